@@ -0,0 +1,128 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_BYTE_BUDGET_LOCAL_STORAGE_CACHE_EXPIRY_CHECKER_H
+#define LIB_QUENTIER_LOCAL_STORAGE_BYTE_BUDGET_LOCAL_STORAGE_CACHE_EXPIRY_CHECKER_H
+
+#include <quentier/local_storage/ILocalStorageCacheExpiryChecker.h>
+
+#include <cstddef>
+
+namespace quentier {
+
+/**
+ * @brief The ByteBudgetLocalStorageCacheExpiryChecker class is the
+ * implementation of ILocalStorageCacheExpiryChecker interface limiting
+ * the approximate memory footprint of each kind of objects cached by
+ * LocalStorageCacheManager rather than the number of cached objects. It is
+ * more suitable than DefaultLocalStorageCacheExpiryChecker when the sizes
+ * of cached objects vary a lot, like notes with and without large resources.
+ *
+ * LocalStorageCacheManager consults the checker before caching a new object so
+ * the budget might be exceeded by the most recently cached object.
+ */
+class QUENTIER_EXPORT ByteBudgetLocalStorageCacheExpiryChecker :
+    public ILocalStorageCacheExpiryChecker
+{
+public:
+    /**
+     * @brief The Budget struct specifies the maximal approximate number of
+     * bytes occupied by cached objects of each kind
+     */
+    struct Budget
+    {
+        size_t m_notesBytes = 32 * 1024 * 1024;
+        size_t m_resourcesBytes = 64 * 1024 * 1024;
+        size_t m_notebooksBytes = 1024 * 1024;
+        size_t m_tagsBytes = 1024 * 1024;
+        size_t m_linkedNotebooksBytes = 1024 * 1024;
+        size_t m_savedSearchesBytes = 1024 * 1024;
+    };
+
+    ByteBudgetLocalStorageCacheExpiryChecker(
+        const LocalStorageCacheManager & cacheManager);
+
+    ByteBudgetLocalStorageCacheExpiryChecker(
+        const LocalStorageCacheManager & cacheManager, const Budget & budget);
+
+    virtual ~ByteBudgetLocalStorageCacheExpiryChecker();
+
+    /**
+     * @return              The budget used by the checker
+     */
+    const Budget & budget() const;
+
+    /**
+     * @return              A pointer to the newly allocated copy of the current
+     *                      ByteBudgetLocalStorageCacheExpiryChecker
+     */
+    virtual ByteBudgetLocalStorageCacheExpiryChecker * clone() const override;
+
+    /**
+     * @return              False if cached notes occupy more memory than
+     *                      the budget allows, true otherwise
+     */
+    virtual bool checkNotes() const override;
+
+    /**
+     * @return              False if cached resources occupy more memory than
+     *                      the budget allows, true otherwise
+     */
+    virtual bool checkResources() const override;
+
+    /**
+     * @return              False if cached notebooks occupy more memory than
+     *                      the budget allows, true otherwise
+     */
+    virtual bool checkNotebooks() const override;
+
+    /**
+     * @return              False if cached tags occupy more memory than
+     *                      the budget allows, true otherwise
+     */
+    virtual bool checkTags() const override;
+
+    /**
+     * @return              False if cached linked notebooks occupy more memory
+     *                      than the budget allows, true otherwise
+     */
+    virtual bool checkLinkedNotebooks() const override;
+
+    /**
+     * @return              False if cached saved searches occupy more memory
+     *                      than the budget allows, true otherwise
+     */
+    virtual bool checkSavedSearches() const override;
+
+    /**
+     * @brief               Print the internal information about the current
+     *                      ByteBudgetLocalStorageCacheExpiryChecker instance
+     *                      to the text stream
+     */
+    virtual QTextStream & print(QTextStream & strm) const override;
+
+private:
+    Q_DISABLE_COPY(ByteBudgetLocalStorageCacheExpiryChecker)
+
+private:
+    Budget m_budget;
+};
+
+} // namespace quentier
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_BYTE_BUDGET_LOCAL_STORAGE_CACHE_EXPIRY_CHECKER_H
@@ -52,6 +52,8 @@ public:
 
     // Notes cache
     size_t numCachedNotes() const;
+    size_t cachedNotesBytes() const;
+    size_t numEvictedNotes() const;
     void cacheNote(const Note & note);
     void expungeNote(const Note & note);
 
@@ -61,6 +63,8 @@ public:
 
     // Resources cache
     size_t numCachedResources() const;
+    size_t cachedResourcesBytes() const;
+    size_t numEvictedResources() const;
     void cacheResource(const Resource & resource);
     void expungeResource(const Resource & resource);
 
@@ -71,6 +75,8 @@ public:
 
     // Notebooks cache
     size_t numCachedNotebooks() const;
+    size_t cachedNotebooksBytes() const;
+    size_t numEvictedNotebooks() const;
     void cacheNotebook(const Notebook & notebook);
     void expungeNotebook(const Notebook & notebook);
 
@@ -82,6 +88,8 @@ public:
 
     // Tags cache
     size_t numCachedTags() const;
+    size_t cachedTagsBytes() const;
+    size_t numEvictedTags() const;
     void cacheTag(const Tag & tag);
     void expungeTag(const Tag & tag);
     const Tag * findTag(const QString & uid, const WhichUid whichUid) const;
@@ -90,6 +98,8 @@ public:
 
     // Linked notebooks cache
     size_t numCachedLinkedNotebooks() const;
+    size_t cachedLinkedNotebooksBytes() const;
+    size_t numEvictedLinkedNotebooks() const;
     void cacheLinkedNotebook(const LinkedNotebook & linkedNotebook);
     void expungeLinkedNotebook(const LinkedNotebook & linkedNotebook);
     const LinkedNotebook * findLinkedNotebook(const QString & guid) const;
@@ -97,6 +107,8 @@ public:
 
     // Saved searches cache
     size_t numCachedSavedSearches() const;
+    size_t cachedSavedSearchesBytes() const;
+    size_t numEvictedSavedSearches() const;
     void cacheSavedSearch(const SavedSearch & savedSearch);
     void expungeSavedSearch(const SavedSearch & savedSearch);
 
@@ -24,8 +24,10 @@
 #include <quentier/types/Account.h>
 #include <quentier/types/ErrorString.h>
 #include <quentier/utility/Linkage.h>
+#include <quentier/utility/Printable.h>
 
 #include <QHash>
+#include <QIODevice>
 #include <QString>
 #include <QVector>
 
@@ -78,7 +80,17 @@ public:
          * method) with the advisory lock on the database file put by
          * someone else would cause the throwing of DatabaseLockedException
          */
-        OverrideLock = 2
+        OverrideLock = 2,
+        /**
+         * If ReadOnly flag is active, LocalStorageManager would open
+         * the existing database through a separate read-only connection:
+         * it would neither lock the database file nor create, patch or clear
+         * anything within the database. Such LocalStorageManager is meant
+         * to serve reads in parallel with another LocalStorageManager
+         * performing writes to the same database; if the database doesn't
+         * exist yet, DatabaseOpeningException would be thrown
+         */
+        ReadOnly = 4
     };
     Q_DECLARE_FLAGS(StartupOptions, StartupOption)
 
@@ -94,6 +106,83 @@ public:
     friend QUENTIER_EXPORT QDebug & operator<<(
         QDebug & dbg, const StartupOptions options);
 
+    /**
+     * @brief The PerformanceProfile struct holds the values of SQLite pragmas
+     * which trade the durability of the local storage database for the speed
+     * of working with it. The profile is applied to the database connection
+     * on startup and on call to switchUser method; it can also be changed
+     * at runtime via setPerformanceProfile method.
+     *
+     * Presets cover typical use cases; individual fields of a preset can be
+     * overridden before the profile is applied.
+     */
+    struct QUENTIER_EXPORT PerformanceProfile : public Printable
+    {
+        enum class Synchronous
+        {
+            Off = 0,
+            Normal = 1,
+            Full = 2,
+            Extra = 3
+        };
+
+        enum class TempStore
+        {
+            Default = 0,
+            File = 1,
+            Memory = 2
+        };
+
+        /**
+         * @return      Profile with which every committed transaction
+         *              survives power loss; equal to SQLite's defaults and
+         *              used unless another profile is specified
+         */
+        static PerformanceProfile durable();
+
+        /**
+         * @return      Profile with which committed transactions survive
+         *              application crashes but the last few of them might be
+         *              lost on power loss; uses larger page cache and memory
+         *              mapped I/O
+         */
+        static PerformanceProfile balanced();
+
+        /**
+         * @return      Profile for massive writes such as the initial full
+         *              sync: the database survives application crashes but
+         *              might get corrupted on power loss or operating system
+         *              crash; should be switched back to durable or balanced
+         *              one once the writes are done
+         */
+        static PerformanceProfile bulkImport();
+
+        virtual QTextStream & print(QTextStream & strm) const override;
+
+        bool operator==(const PerformanceProfile & other) const;
+        bool operator!=(const PerformanceProfile & other) const;
+
+        Synchronous m_synchronous = Synchronous::Full;
+
+        // Positive values are the number of pages, negative ones are
+        // the amount of memory in kibibytes
+        qint64 m_cacheSize = -2000;
+
+        // The max number of bytes of the database file mapped into memory,
+        // zero disables memory mapped I/O
+        qint64 m_mmapSize = 0;
+
+        TempStore m_tempStore = TempStore::Default;
+
+        // The number of pages in the write-ahead log after which it is
+        // checkpointed automatically, zero disables automatic checkpoints
+        int m_walAutocheckpoint = 1000;
+
+        // How long to wait for the lock held by another connection before
+        // failing with "database is locked" error
+        int m_busyTimeoutMsec = 5000;
+    };
+
     /**
      * @brief LocalStorageManager - constructor. Takes in the account for which
      * the LocalStorageManager instance is created plus some other parameters
@@ -114,6 +203,21 @@ public:
 #endif
         QObject * parent = nullptr);
 
+    /**
+     * @brief LocalStorageManager - constructor applying the given performance
+     * profile to the database instead of the durable one
+     *
+     * @param account               The account for which the local storage is
+     *                              being created and initialized
+     * @param options               Startup options for the local storage
+     * @param performanceProfile    Performance profile for the local storage
+     * @param parent                Parent QObject
+     */
+    LocalStorageManager(
+        const Account & account, const StartupOptions options,
+        const PerformanceProfile & performanceProfile,
+        QObject * parent = nullptr);
+
     virtual ~LocalStorageManager() override;
 
 Q_SIGNALS:
@@ -129,6 +233,16 @@ Q_SIGNALS:
      */
     void upgradeProgress(double progress);
 
+    /**
+     * @brief Taking the snapshot of the local storage can be a lengthy
+     * operation so this signal is meant to provide some feedback on its
+     * progress
+     *
+     * @param progress      The value from 0 to 1 denoting the progress of
+     *                      taking the snapshot
+     */
+    void snapshotProgress(double progress);
+
 public:
     /**
      * @brief The ListObjectsOption enum is a QFlags enum which allows to
@@ -600,6 +714,48 @@ public:
         const OrderDirection orderDirection = OrderDirection::Ascending,
         const QString & linkedNotebookGuid = QString()) const;
 
+    /**
+     * @brief listNotebooksPage attempts to list a single page of notebooks
+     * within the account according to the specified input flag.
+     *
+     * Unlike the offset based listing, the page is located by the position of
+     * the last notebook of the previous page within the chosen ordering so
+     * the cost of obtaining each page doesn't grow with the page's number
+     * and notebooks added or removed between the calls don't shift the pages.
+     *
+     * @param flag                  Input parameter used to set the filter for
+     *                              the desired notebooks to be listed
+     * @param errorDescription      Error description if notebooks within
+     *                              the account could not be listed; if no error
+     *                              happens, this parameter is untouched
+     * @param pageSize              The max number of notebooks in the page,
+     *                              zero means no limit
+     * @param continuationToken     Input and output parameter: on input it
+     *                              should be empty for the first page or equal
+     *                              to the token returned along with
+     *                              the previous page; on output it contains
+     *                              the token for the next page or is empty if
+     *                              the returned page is the last one
+     * @param order                 Allows to specify particular ordering of
+     *                              notebooks in the result, NoOrder by default;
+     *                              must be the same for all pages
+     * @param orderDirection        Specifies the direction of ordering, by
+     *                              default ascending direction is used; must be
+     *                              the same for all pages
+     * @param linkedNotebookGuid    Has the same meaning as for listNotebooks
+     * @return                      Either the page of notebooks within
+     *                              the account conforming to the filter or
+     *                              empty list in cases of error or no more
+     *                              notebooks conforming to the filter exist
+     *                              within the account
+     */
+    QList<Notebook> listNotebooksPage(
+        const ListObjectsOptions flag, ErrorString & errorDescription,
+        const size_t pageSize, QString & continuationToken,
+        const ListNotebooksOrder order = ListNotebooksOrder::NoOrder,
+        const OrderDirection orderDirection = OrderDirection::Ascending,
+        const QString & linkedNotebookGuid = QString()) const;
+
     /**
      * @brief listAllSharedNotebooks attempts to list all shared notebooks
      * within the account.
@@ -950,6 +1106,33 @@ public:
         const NoteCountOptions options =
             NoteCountOption::IncludeNonDeletedNotes) const;
 
+    /**
+     * @brief noteCountersAreConsistent checks whether the numbers of notes per
+     * notebook and per tag maintained by the local storage match the actual
+     * numbers of notes. Note counts are served from these counters rather than
+     * computed from scratch on each request.
+     *
+     * @param errorDescription      Error description if the check could not
+     *                              be performed
+     * @return                      True if note counters are consistent with
+     *                              the notes, false if they are not or if
+     *                              the check could not be performed; in
+     *                              the latter case errorDescription is
+     *                              not empty
+     */
+    bool noteCountersAreConsistent(ErrorString & errorDescription) const;
+
+    /**
+     * @brief rebuildNoteCounters recomputes the numbers of notes per notebook
+     * and per tag from scratch.
+     *
+     * @param errorDescription      Error description if note counters could
+     *                              not be rebuilt
+     * @return                      True if note counters were rebuilt
+     *                              successfully, false otherwise
+     */
+    bool rebuildNoteCounters(ErrorString & errorDescription);
+
     /**
      * @brief addNote adds passed in Note to the local storage database.
      *
@@ -1057,6 +1240,60 @@ public:
         Note & note, const UpdateNoteOptions options,
         ErrorString & errorDescription);
 
+    /**
+     * @brief addNotes adds passed in notes to the local storage database
+     * within a single transaction. Each note is handled in the same way as
+     * by addNote method; the failure to add one note doesn't prevent the other
+     * notes from being added.
+     *
+     * @param notes                 Notes to be added to the local storage
+     *                              database; may be changed as a result of
+     *                              the call in the same way as by addNote
+     *                              method
+     * @param noteErrorDescriptions Error descriptions per note, in the same
+     *                              order as notes; empty error description
+     *                              corresponds to the note which was added
+     *                              successfully
+     * @param errorDescription      Error description if the transaction
+     *                              could not be committed
+     * @return                      True if the transaction was committed
+     *                              (even if some of notes could not be added),
+     *                              false otherwise; in the latter case none of
+     *                              notes is added
+     */
+    bool addNotes(
+        QList<Note> & notes, QList<ErrorString> & noteErrorDescriptions,
+        ErrorString & errorDescription);
+
+    /**
+     * @brief updateNotes updates passed in notes in the local storage database
+     * within a single transaction. Each note is handled in the same way as
+     * by updateNote method; the failure to update one note doesn't prevent
+     * the other notes from being updated.
+     *
+     * @param notes                 Notes to be updated in the local storage
+     *                              database; may be changed as a result of
+     *                              the call in the same way as by updateNote
+     *                              method
+     * @param options               Options specifying which optionally
+     *                              updatable fields of notes should actually
+     *                              be updated
+     * @param noteErrorDescriptions Error descriptions per note, in the same
+     *                              order as notes; empty error description
+     *                              corresponds to the note which was updated
+     *                              successfully
+     * @param errorDescription      Error description if the transaction
+     *                              could not be committed
+     * @return                      True if the transaction was committed
+     *                              (even if some of notes could not be
+     *                              updated), false otherwise; in the latter
+     *                              case none of notes is updated
+     */
+    bool updateNotes(
+        QList<Note> & notes, const UpdateNoteOptions options,
+        QList<ErrorString> & noteErrorDescriptions,
+        ErrorString & errorDescription);
+
     /**
      * @brief The GetNoteOption enum is a QFlags enum which allows to specify
      * which note fields should be included when findNote or one of listNote*
@@ -1082,7 +1319,26 @@ public:
          * into each of note's resources; this value only has effect if flags
          * also have WithResourceMetadata value enabled!
          */
-        WithResourceBinaryData = 2
+        WithResourceBinaryData = 2,
+        /**
+         * MapResourceBinaryData value specifies that large enough dataBody
+         * and alternateDataBody of note's resources should not be copied into
+         * memory but mapped from the files they are stored in; the mapping
+         * is kept alive as long as any copy of the resource exists. This value
+         * only has effect if flags also have WithResourceBinaryData value
+         * enabled; it is ignored on Windows which doesn't allow removing or
+         * replacing the files while they are mapped
+         */
+        MapResourceBinaryData = 4,
+        /**
+         * LazyResourceBinaryData value specifies that dataBody and
+         * alternateDataBody of note's resources should not be read at once
+         * but on the first access to them; see Resource::setLazyDataBody.
+         * This value only has effect if flags also have
+         * WithResourceBinaryData value enabled and takes precedence over
+         * MapResourceBinaryData
+         */
+        LazyResourceBinaryData = 8
     };
     Q_DECLARE_FLAGS(GetNoteOptions, GetNoteOption)
 
@@ -1330,6 +1586,167 @@ public:
         const OrderDirection orderDirection = OrderDirection::Ascending,
         const QString & linkedNotebookGuid = QString()) const;
 
+    /**
+     * @brief listNotesPage attempts to list a single page of notes within
+     * the account according to the specified input flag.
+     *
+     * Unlike the offset based listing, the page is located by the position of
+     * the last note of the previous page within the chosen ordering so
+     * the cost of obtaining each page doesn't grow with the page's number
+     * and notes added or removed between the calls don't shift the pages.
+     *
+     * @param flag                  Input parameter used to set the filter for
+     *                              the desired notes to be listed
+     * @param options               Options specifying which optionally
+     *                              includable fields of the note should
+     *                              actually be included
+     * @param errorDescription      Error description if notes within
+     *                              the account could not be listed; if no error
+     *                              happens, this parameter is untouched
+     * @param pageSize              The max number of notes in the page, zero
+     *                              means no limit
+     * @param continuationToken     Input and output parameter: on input it
+     *                              should be empty for the first page or equal
+     *                              to the token returned along with
+     *                              the previous page; on output it contains
+     *                              the token for the next page or is empty if
+     *                              the returned page is the last one
+     * @param order                 Allows to specify particular ordering of
+     *                              notes in the result, NoOrder by default;
+     *                              must be the same for all pages
+     * @param orderDirection        Specifies the direction of ordering, by
+     *                              default ascending direction is used; must be
+     *                              the same for all pages
+     * @param linkedNotebookGuid    Has the same meaning as for listNotes
+     * @return                      Either the page of notes within
+     *                              the account conforming to the filter or
+     *                              empty list in cases of error or no more
+     *                              notes conforming to the filter exist within
+     *                              the account
+     */
+    QList<Note> listNotesPage(
+        const ListObjectsOptions flag, const GetNoteOptions options,
+        ErrorString & errorDescription, const size_t pageSize,
+        QString & continuationToken,
+        const ListNotesOrder order = ListNotesOrder::NoOrder,
+        const OrderDirection orderDirection = OrderDirection::Ascending,
+        const QString & linkedNotebookGuid = QString()) const;
+
+    /**
+     * @brief The NoteSummaryField enum is a QFlags enum which allows to
+     * specify which fields of NoteSummary should be filled when
+     * listNoteSummaries method is called; local uid and guid of the note
+     * are always filled
+     */
+    enum class NoteSummaryField
+    {
+        Title = 1,
+        /**
+         * Notebook value specifies that local uid and guid of note's notebook
+         * should be filled
+         */
+        Notebook = 2,
+        /**
+         * Timestamps value specifies that note's creation, modification and
+         * deletion timestamps should be filled
+         */
+        Timestamps = 4,
+        /**
+         * TagLocalUids value specifies that local uids of note's tags should
+         * be filled in the order in which tags are assigned to the note
+         */
+        TagLocalUids = 8,
+        /**
+         * Preview value specifies that the beginning of note's plain text
+         * should be filled
+         */
+        Preview = 16,
+        /**
+         * Flags value specifies that note's dirty, local and favorited flags
+         * should be filled
+         */
+        Flags = 32
+    };
+    Q_DECLARE_FLAGS(NoteSummaryFields, NoteSummaryField)
+
+    /**
+     * @brief The NoteSummary struct contains a subset of note's fields
+     * sufficient for displaying the note within the list of notes
+     */
+    struct QUENTIER_EXPORT NoteSummary : public Printable
+    {
+        virtual QTextStream & print(QTextStream & strm) const override;
+
+        // Fields which were requested when the summary was listed
+        NoteSummaryFields m_fields;
+
+        QString m_localUid;
+        QString m_guid;
+
+        QString m_title;
+
+        QString m_notebookLocalUid;
+        QString m_notebookGuid;
+
+        // Timestamps are in milliseconds since epoch, zero if not set
+        qint64 m_creationTimestamp = 0;
+        qint64 m_modificationTimestamp = 0;
+        qint64 m_deletionTimestamp = 0;
+
+        QStringList m_tagLocalUids;
+
+        QString m_preview;
+
+        bool m_isDirty = false;
+        bool m_isLocal = false;
+        bool m_isFavorited = false;
+    };
+
+    /**
+     * @brief listNoteSummaries attempts to list summaries of notes within
+     * the account according to the specified input flag.
+     *
+     * Only the columns of notes table corresponding to the requested fields
+     * are read; neither note's content nor its resources, shared notes,
+     * restrictions and limits are loaded. So listing summaries is much
+     * cheaper than listing notes in terms of both time and memory.
+     *
+     * @param flag                  Input parameter used to set the filter for
+     *                              the desired notes to be listed
+     * @param fields                Fields of note summaries which should be
+     *                              filled
+     * @param errorDescription      Error description if note summaries could
+     *                              not be listed; if no error happens, this
+     *                              parameter is untouched
+     * @param limit                 Limit for the max number of summaries in
+     *                              the result, zero by default which means no
+     *                              limit is set
+     * @param offset                Number of summaries to skip in
+     *                              the beginning of the result, zero by default
+     * @param order                 Allows to specify particular ordering of
+     *                              summaries in the result, NoOrder by default
+     * @param orderDirection        Specifies the direction of ordering, by
+     *                              default ascending direction is used; this
+     *                              parameter has no meaning if order is equal
+     *                              to NoOrder
+     * @param linkedNotebookGuid    Has the same meaning as for listNotes
+     * @param previewLength         The max number of characters of note's
+     *                              plain text within the preview; only has
+     *                              effect if fields contain Preview value
+     * @return                      Either list of note summaries conforming
+     *                              to the filter or empty list in cases of
+     *                              error or no notes conforming to the filter
+     *                              exist within the account
+     */
+    QList<NoteSummary> listNoteSummaries(
+        const ListObjectsOptions flag, const NoteSummaryFields fields,
+        ErrorString & errorDescription, const size_t limit = 0,
+        const size_t offset = 0,
+        const ListNotesOrder order = ListNotesOrder::NoOrder,
+        const OrderDirection orderDirection = OrderDirection::Ascending,
+        const QString & linkedNotebookGuid = QString(),
+        const int previewLength = 200) const;
+
     /**
      * @brief findNoteLocalUidsWithSearchQuery attempts to find note local uids
      * of notes corresponding to the passed in NoteSearchQuery object.
@@ -1364,6 +1781,81 @@ public:
         const NoteSearchQuery & noteSearchQuery, const GetNoteOptions options,
         ErrorString & errorDescription) const;
 
+    /**
+     * @brief The NoteSearchHit struct represents a single note found by
+     * the note search query along with its relevance score and the snippet
+     * of the note's text surrounding the matched search terms.
+     */
+    struct QUENTIER_EXPORT NoteSearchHit : public Printable
+    {
+        virtual QTextStream & print(QTextStream & strm) const override;
+
+        QString m_noteLocalUid;
+
+        // Okapi BM25 relevance score summed over note's title, text and
+        // the recognition data of note's resources; higher is better, zero
+        // for notes matching the search query only by modifiers, tag names
+        // or phrased search terms
+        double m_score = 0.0;
+
+        // Fragment of note's title, text or recognition data containing
+        // the matched search terms; empty if m_score is zero
+        QString m_snippet;
+
+        // Positions and lengths of matched search terms within m_snippet
+        QList<QPair<int, int>> m_matchOffsets;
+    };
+
+    /**
+     * @brief findNoteSearchHits attempts to find notes corresponding to
+     * the passed in NoteSearchQuery object and returns them ranked by
+     * relevance without loading the notes themselves.
+     *
+     * @param noteSearchQuery       Filled NoteSearchQuery object used to filter
+     *                              the notes
+     * @param errorDescription      Error description in case search hits could
+     *                              not be found
+     * @param limit                 The max number of search hits to return,
+     *                              only the most relevant ones are returned;
+     *                              zero means no limit
+     * @return                      The list of search hits sorted by
+     *                              the relevance score in descending order or
+     *                              empty list in case of error or no notes
+     *                              presence for the given NoteSearchQuery
+     */
+    QList<NoteSearchHit> findNoteSearchHits(
+        const NoteSearchQuery & noteSearchQuery, ErrorString & errorDescription,
+        const size_t limit = 0) const;
+
+    /**
+     * @brief findNoteLocalUidsWithinBoundingBox attempts to find local uids
+     * of notes having latitude and longitude within the specified bounding
+     * box, i.e. the notes to be shown on the given part of the map.
+     *
+     * The lookup goes through the spatial index of note locations so it
+     * doesn't depend on the total number of notes in the local storage.
+     *
+     * @param minLatitude           The southern border of the bounding box
+     * @param maxLatitude           The northern border of the bounding box
+     * @param minLongitude          The western border of the bounding box;
+     *                              if it is greater than maxLongitude,
+     *                              the bounding box is considered to cross
+     *                              the 180th meridian
+     * @param maxLongitude          The eastern border of the bounding box
+     * @param options               Options clarifying which notes to look for,
+     *                              non-deleted ones by default
+     * @param errorDescription      Error description in case note local uids
+     *                              could not be found
+     * @return                      The list of found notes' local uids or empty
+     *                              list in case of error
+     */
+    QStringList findNoteLocalUidsWithinBoundingBox(
+        const double minLatitude, const double maxLatitude,
+        const double minLongitude, const double maxLongitude,
+        ErrorString & errorDescription,
+        const NoteCountOptions options = NoteCountOptions(
+            NoteCountOption::IncludeNonDeletedNotes)) const;
+
     /**
      * @brief expungeNote permanently deletes note from local storage.
      *
@@ -1409,6 +1901,30 @@ public:
      */
     bool addTag(Tag & tag, ErrorString & errorDescription);
 
+    /**
+     * @brief addTags adds passed in tags to the local storage database within
+     * a single transaction. Each tag is handled in the same way as by addTag
+     * method; the failure to add one tag doesn't prevent the other tags from
+     * being added. Parent tags should precede their child tags within the list.
+     *
+     * @param tags                  Tags to be added to the local storage; may
+     *                              be changed as a result of the call in
+     *                              the same way as by addTag method
+     * @param tagErrorDescriptions  Error descriptions per tag, in the same
+     *                              order as tags; empty error description
+     *                              corresponds to the tag which was added
+     *                              successfully
+     * @param errorDescription      Error description if the transaction
+     *                              could not be committed
+     * @return                      True if the transaction was committed
+     *                              (even if some of tags could not be added),
+     *                              false otherwise; in the latter case none of
+     *                              tags is added
+     */
+    bool addTags(
+        QList<Tag> & tags, QList<ErrorString> & tagErrorDescriptions,
+        ErrorString & errorDescription);
+
     /**
      * @brief updateTag updates passed in Tag in the local storage database.
      *
@@ -1583,6 +2099,48 @@ public:
         const OrderDirection orderDirection = OrderDirection::Ascending,
         const QString & linkedNotebookGuid = QString()) const;
 
+    /**
+     * @brief listTagsPage attempts to list a single page of tags within
+     * the account according to the specified input flag.
+     *
+     * Unlike the offset based listing, the page is located by the position of
+     * the last tag of the previous page within the chosen ordering so
+     * the cost of obtaining each page doesn't grow with the page's number
+     * and tags added or removed between the calls don't shift the pages.
+     *
+     * @param flag                  Input parameter used to set the filter for
+     *                              the desired tags to be listed
+     * @param errorDescription      Error description if tags within
+     *                              the account could not be listed; if no error
+     *                              happens, this parameter is untouched
+     * @param pageSize              The max number of tags in the page, zero
+     *                              means no limit
+     * @param continuationToken     Input and output parameter: on input it
+     *                              should be empty for the first page or equal
+     *                              to the token returned along with
+     *                              the previous page; on output it contains
+     *                              the token for the next page or is empty if
+     *                              the returned page is the last one
+     * @param order                 Allows to specify particular ordering of
+     *                              tags in the result, NoOrder by default;
+     *                              must be the same for all pages
+     * @param orderDirection        Specifies the direction of ordering, by
+     *                              default ascending direction is used; must be
+     *                              the same for all pages
+     * @param linkedNotebookGuid    Has the same meaning as for listTags
+     * @return                      Either the page of tags within
+     *                              the account conforming to the filter or
+     *                              empty list in cases of error or no more
+     *                              tags conforming to the filter exist within
+     *                              the account
+     */
+    QList<Tag> listTagsPage(
+        const ListObjectsOptions flag, ErrorString & errorDescription,
+        const size_t pageSize, QString & continuationToken,
+        const ListTagsOrder & order = ListTagsOrder::NoOrder,
+        const OrderDirection orderDirection = OrderDirection::Ascending,
+        const QString & linkedNotebookGuid = QString()) const;
+
     /**
      * @brief listTagsWithNoteLocalUids attempts to list tags and their
      * corresponding local uids within the account according to the specified
@@ -1721,6 +2279,60 @@ public:
      */
     bool updateEnResource(Resource & resource, ErrorString & errorDescription);
 
+    /**
+     * @brief addEnResource adds passed in resource to the local storage
+     * database reading its data body from the passed in device.
+     *
+     * The data body is streamed from the device to the local storage in
+     * chunks of bounded size so that large resources can be added without
+     * loading their whole data into memory. The data hash and data size of
+     * the resource are computed along the way.
+     *
+     * @param resource                  Resource to be added to the database,
+     *                                  must not have the data body set, all
+     *                                  other requirements are the same as for
+     *                                  the other overload of this method;
+     *                                  on success the data hash and the data
+     *                                  size of the resource are set to those
+     *                                  of the data read from the device
+     * @param dataBodySource            Device opened for reading from which
+     *                                  the data body of the resource is read
+     *                                  until the end
+     * @param errorDescription          Error description if resource could
+     *                                  not be added
+     * @return                          True if resource was added successfully,
+     *                                  false otherwise
+     */
+    bool addEnResource(
+        Resource & resource, QIODevice & dataBodySource,
+        ErrorString & errorDescription);
+
+    /**
+     * @brief updateEnResource updates passed in resource in the local storage
+     * database replacing its data body with the data read from the passed in
+     * device.
+     *
+     * The data body is streamed from the device to the local storage in
+     * chunks of bounded size, see the corresponding overload of addEnResource
+     * method.
+     *
+     * @param resource                  Resource to be updated, must not have
+     *                                  the data body set; on success the data
+     *                                  hash and the data size of the resource
+     *                                  are set to those of the data read from
+     *                                  the device
+     * @param dataBodySource            Device opened for reading from which
+     *                                  the data body of the resource is read
+     *                                  until the end
+     * @param errorDescription          Error description if resource could not
+     *                                  be updated
+     * @return                          True if resource was updated
+     *                                  successfully, false otherwise
+     */
+    bool updateEnResource(
+        Resource & resource, QIODevice & dataBodySource,
+        ErrorString & errorDescription);
+
     /**
      * @brief The GetResourceOption enum is a QFlags enum which allows to
      * specify which resource fields should be included when findEnResource
@@ -1737,7 +2349,25 @@ public:
          * WithBinaryData value specifies than dataBody and alternateDataBody
          * should be included into the returned resource
          */
-        WithBinaryData = 1
+        WithBinaryData = 1,
+        /**
+         * MapBinaryData value specifies that large enough dataBody and
+         * alternateDataBody should not be copied into memory but mapped from
+         * the files they are stored in; the mapping is kept alive as long as
+         * any copy of the resource exists. This value only has effect if
+         * flags also have WithBinaryData value enabled; it is ignored on
+         * Windows which doesn't allow removing or replacing the files while
+         * they are mapped
+         */
+        MapBinaryData = 2,
+        /**
+         * LazyBinaryData value specifies that dataBody and alternateDataBody
+         * should not be read at once but on the first access to them; see
+         * Resource::setLazyDataBody. This value only has effect if flags also
+         * have WithBinaryData value enabled and takes precedence over
+         * MapBinaryData
+         */
+        LazyBinaryData = 4
     };
     Q_DECLARE_FLAGS(GetResourceOptions, GetResourceOption)
 
@@ -1961,7 +2591,10 @@ public:
     /**
      * @brief accountHighUsn returns the highest update sequence number within
      * the data elements stored in the local storage database, either for user's
-     * own account or for some linked notebook.
+     * own account or for some linked notebook. The value is computed from
+     * the data elements only on the first call and after the data element
+     * defining it is expunged; otherwise the value kept up to date on writes
+     * is returned.
      *
      * @param linkedNotebookGuid        The guid of the linked notebook for
      *                                  which the highest update sequence number
@@ -1978,14 +2611,288 @@ public:
     qint32 accountHighUsn(
         const QString & linkedNotebookGuid, ErrorString & errorDescription);
 
+    /**
+     * @brief The QueryStatistics struct contains the statistics collected
+     * for a single SQL query executed by LocalStorageManager. Literal values
+     * within dynamically built queries are replaced with "?" so that
+     * the executions of queries differing only in values are accounted
+     * together.
+     */
+    struct QUENTIER_EXPORT QueryStatistics : public Printable
+    {
+        virtual QTextStream & print(QTextStream & strm) const override;
+
+        QString m_query;
+        qint64 m_executionCount = 0;
+        qint64 m_failureCount = 0;
+
+        // The number of rows returned by select queries or affected by other
+        // ones; rows returned by select queries are accounted only for queries
+        // listing and searching for data items
+        qint64 m_rowCount = 0;
+
+        qint64 m_totalDurationUsec = 0;
+        qint64 m_maxDurationUsec = 0;
+
+        // Percentiles are approximate: they are computed over the histogram
+        // of durations with power of two buckets
+        qint64 m_medianDurationUsec = 0;
+        qint64 m_p90DurationUsec = 0;
+        qint64 m_p99DurationUsec = 0;
+
+        // The output of EXPLAIN QUERY PLAN captured for the first execution
+        // slower than the slow query threshold; empty if there was no such
+        // execution
+        QString m_queryPlan;
+    };
+
+    /**
+     * @brief queryStatistics returns the statistics of SQL queries executed
+     * by LocalStorageManager since its creation or since the last call
+     * to resetQueryStatistics. Statements beginning and ending transactions
+     * are accounted too. Queries made by read-only connections from the pool
+     * of LocalStorageManagerAsync are accounted within the statistics of its
+     * LocalStorageManager.
+     *
+     * Unlike other methods, this one along with resetQueryStatistics,
+     * logQueryStatistics and the methods dealing with the slow query
+     * threshold can be called from any thread, for example, on
+     * LocalStorageManager owned by LocalStorageManagerAsync working in
+     * another thread.
+     *
+     * @return                          The list of query statistics sorted by
+     *                                  the total duration of queries'
+     *                                  executions in descending order
+     */
+    QList<QueryStatistics> queryStatistics() const;
+
+    /**
+     * @brief resetQueryStatistics clears the statistics of SQL queries
+     * collected so far
+     */
+    void resetQueryStatistics();
+
+    /**
+     * @brief logQueryStatistics dumps the statistics of SQL queries collected
+     * so far to the log
+     */
+    void logQueryStatistics() const;
+
+    /**
+     * @brief setSlowQueryThreshold sets the duration of a query's execution
+     * starting from which the query is considered slow: its plan is captured
+     * via EXPLAIN QUERY PLAN and logged. Prepared queries are explained with
+     * the values bound to them.
+     *
+     * @param thresholdUsec             The threshold in microseconds; zero or
+     *                                  negative value disables capturing query
+     *                                  plans which is the default
+     */
+    void setSlowQueryThreshold(const qint64 thresholdUsec);
+
+    /**
+     * @return                          The duration of a query's execution
+     *                                  in microseconds starting from which
+     *                                  the query is considered slow
+     */
+    qint64 slowQueryThreshold() const;
+
+    /**
+     * @brief setAccountHighUsnVerificationEnabled enables or disables
+     * the verification of account high USN values: LocalStorageManager keeps
+     * them up to date on every write so that accountHighUsn doesn't need to
+     * go through all the tables with USNs. In verification mode accountHighUsn
+     * computes the value from the tables anyway and compares it with the kept
+     * one; the mismatch is reported as error. Verification is disabled by
+     * default.
+     *
+     * @param enabled                   True to enable the verification, false
+     *                                  to disable it
+     */
+    void setAccountHighUsnVerificationEnabled(const bool enabled);
+
+    /**
+     * @return                          True if the verification of account
+     *                                  high USN values is enabled, false
+     *                                  otherwise
+     */
+    bool accountHighUsnVerificationEnabled() const;
+
+    /**
+     * @brief The GuidIndexStatistics struct describes the in-memory index
+     * which LocalStorageManager uses to translate guids of notebooks, notes,
+     * tags, resources and saved searches into their local uids and vice versa
+     * without querying the database.
+     */
+    struct QUENTIER_EXPORT GuidIndexStatistics : public Printable
+    {
+        virtual QTextStream & print(QTextStream & strm) const override;
+
+        bool m_enabled = false;
+
+        // The number of guid - local uid pairs kept in the index
+        qint64 m_entryCount = 0;
+
+        // Approximate number of bytes occupied by the index
+        qint64 m_memoryUsage = 0;
+
+        // The numbers of translations served by the index and of the ones
+        // which had to query the database
+        qint64 m_hitCount = 0;
+        qint64 m_missCount = 0;
+    };
+
+    /**
+     * @brief setGuidIndexEnabled enables or disables the in-memory index
+     * of guids and local uids. The index is enabled by default; it can be
+     * disabled on devices with little memory, see guidIndexStatistics for
+     * its memory footprint. Disabling the index frees the memory it occupies.
+     *
+     * @param enabled                   True to enable the index, false to
+     *                                  disable it
+     */
+    void setGuidIndexEnabled(const bool enabled);
+
+    /**
+     * @return                          True if the in-memory index of guids
+     *                                  and local uids is enabled, false
+     *                                  otherwise
+     */
+    bool guidIndexEnabled() const;
+
+    /**
+     * @return                          The statistics of the in-memory index
+     *                                  of guids and local uids
+     */
+    GuidIndexStatistics guidIndexStatistics() const;
+
+    /**
+     * @brief The FreePageStatistics struct describes how much space within
+     * the local storage database file is occupied by free pages i.e. pages
+     * which were once used by deleted data and which could be reclaimed by
+     * compaction.
+     */
+    struct QUENTIER_EXPORT FreePageStatistics : public Printable
+    {
+        virtual QTextStream & print(QTextStream & strm) const override;
+
+        /**
+         * @return                      The fraction of database pages which
+         *                              are free, from 0 to 1
+         */
+        double fragmentation() const;
+
+        qint64 m_pageSize = 0;
+        qint64 m_pageCount = 0;
+        qint64 m_freePageCount = 0;
+
+        // Free pages can be reclaimed incrementally only if the database uses
+        // auto_vacuum = INCREMENTAL mode; otherwise only full compaction can
+        // reclaim them
+        bool m_incrementalVacuumEnabled = false;
+    };
+
+    /**
+     * @brief freePageStatistics collects the statistics of free pages within
+     * the local storage database
+     *
+     * @param statistics                The collected statistics
+     * @param errorDescription          Error description if the statistics
+     *                                  could not be collected
+     * @return                          True if the statistics were collected
+     *                                  successfully, false otherwise
+     */
+    bool freePageStatistics(
+        FreePageStatistics & statistics, ErrorString & errorDescription) const;
+
+    /**
+     * @brief reclaimFreePages incrementally returns free pages of the local
+     * storage database to the file system until either all of them are
+     * reclaimed or the time budget is exhausted. Unlike full compaction it
+     * doesn't rewrite the whole database so it can be called in small slices
+     * between other requests.
+     *
+     * @param timeBudgetMsec            The approximate maximal duration of
+     *                                  the call in milliseconds
+     * @param errorDescription          Error description if free pages could
+     *                                  not be reclaimed
+     * @return                          The number of free pages remaining
+     *                                  after the call - a non-negative value -
+     *                                  or a negative number in case of error
+     */
+    qint64 reclaimFreePages(
+        const qint64 timeBudgetMsec, ErrorString & errorDescription);
+
+    /**
+     * @brief createSnapshot writes a consistent copy of the local storage
+     * database along with the data files of resources into the specified
+     * folder while the local storage remains usable.
+     *
+     * The database is copied via SQLite's VACUUM INTO statement which reads
+     * the database within a single read transaction; as the database is in
+     * write-ahead logging mode, it doesn't block writers from other
+     * connections. Resource data files referenced from the copy are then hard
+     * linked into the folder or copied if hard links are not supported;
+     * resource data files referenced from the copy are not removed until
+     * the snapshot is complete. The folder has the same layout as the account's
+     * persistent storage folder so the account can be restored or cloned by
+     * putting the folder's contents in place of it. VACUUM INTO requires
+     * SQLite 3.27.0 or newer: with older SQLite versions the method fails
+     * without creating anything.
+     *
+     * Progress is reported via snapshotProgress signal. The method must not
+     * be called from within a transaction; for the snapshot to not delay
+     * the processing of other requests, it should be called on a separate
+     * LocalStorageManager, for example, one opened in read-only mode within
+     * a background thread.
+     *
+     * @param snapshotDirPath           The path to the folder for the snapshot;
+     *                                  it is created if it doesn't exist and
+     *                                  must not already contain the database
+     *                                  file
+     * @param errorDescription          Error description if the snapshot could
+     *                                  not be created
+     * @return                          True if the snapshot was created
+     *                                  successfully, false otherwise
+     */
+    bool createSnapshot(
+        const QString & snapshotDirPath, ErrorString & errorDescription);
+
+    /**
+     * @return                          The performance profile currently
+     *                                  applied to the local storage database
+     */
+    PerformanceProfile performanceProfile() const;
+
+    /**
+     * @brief setPerformanceProfile applies the given performance profile
+     * to the connection to the local storage database, for example to speed
+     * up the initial full sync and to switch back to durable profile after it;
+     * the profile remains in effect after the call to switchUser method.
+     * Can't be called while a transaction is open.
+     *
+     * @param performanceProfile        The profile to apply
+     * @param errorDescription          Error description if the profile could
+     *                                  not be applied
+     * @return                          True if the profile was applied
+     *                                  successfully, false otherwise
+     */
+    bool setPerformanceProfile(
+        const PerformanceProfile & performanceProfile,
+        ErrorString & errorDescription);
+
 private:
     Q_DISABLE_COPY(LocalStorageManager)
 
+    friend class LocalStorageReadOnlyConnection;
+    friend class LocalStorageManagerAsyncPrivate;
+
     LocalStorageManagerPrivate * const d_ptr;
     Q_DECLARE_PRIVATE(LocalStorageManager)
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(LocalStorageManager::GetNoteOptions)
+Q_DECLARE_OPERATORS_FOR_FLAGS(LocalStorageManager::NoteSummaryFields)
 Q_DECLARE_OPERATORS_FOR_FLAGS(LocalStorageManager::ListObjectsOptions)
 Q_DECLARE_OPERATORS_FOR_FLAGS(LocalStorageManager::StartupOptions)
 Q_DECLARE_OPERATORS_FOR_FLAGS(LocalStorageManager::UpdateNoteOptions)
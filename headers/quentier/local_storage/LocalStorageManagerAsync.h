@@ -31,6 +31,7 @@
 #include <quentier/types/SharedNotebook.h>
 #include <quentier/types/Tag.h>
 #include <quentier/types/User.h>
+#include <quentier/utility/Printable.h>
 
 #include <QObject>
 
@@ -57,6 +58,34 @@ public:
 
     void setUseCache(const bool useCache);
 
+    // Opt-in: if set to a positive value before init, list, count and search
+    // requests are served by the given number of read-only database
+    // connections in parallel with each other and with write requests.
+    // Zero (the default) means all requests use the single primary connection
+    void setReadOnlyConnectionPoolSize(const int size);
+
+    // Opt-in: if enabled before init, free pages of the database are returned
+    // to the file system in small time-bounded slices while no requests come
+    // to LocalStorageManagerAsync. Requires the database to use incremental
+    // vacuum which is the case for databases of version 6 and later
+    void setIncrementalCompactionEnabled(const bool enabled);
+
+    // Performance profile applied to the database by all connections opened
+    // on init; durable profile is used by default. The profile of the primary
+    // connection can be changed later via onSetPerformanceProfileRequest
+    void setPerformanceProfile(
+        const LocalStorageManager::PerformanceProfile & performanceProfile);
+
+    // Opt-in: if enabled before init, consecutive write requests waiting
+    // in the queue of background or bulk priority are run within a single
+    // transaction of at most maxRequestCount requests which stops taking
+    // new ones after maxDurationMsec. Each request still gets its own
+    // complete or failed signal, emitted after the transaction is committed;
+    // a failed request doesn't affect the rest of the group
+    void setGroupCommitEnabled(
+        const bool enabled, const int maxRequestCount = 100,
+        const int maxDurationMsec = 100);
+
     const LocalStorageCacheManager * localStorageCacheManager() const;
 
     bool installCacheExpiryFunction(
@@ -65,6 +94,75 @@ public:
     const LocalStorageManager * localStorageManager() const;
     LocalStorageManager * localStorageManager();
 
+    /**
+     * @brief The RequestPriority enum defines the classes of requests which
+     * LocalStorageManagerAsync serves in different order. Requests of
+     * interactive priority are run as soon as they arrive. Requests of
+     * background and bulk priorities are queued and run one per event loop
+     * iteration so that interactive requests arriving in the meantime don't
+     * wait for the queues to drain. Background requests are run before bulk
+     * ones unless bulk requests have been waiting for too long. Interactive
+     * write requests don't get ahead of queued writes of the same objects:
+     * such queued writes along with the requests queued before them are run
+     * first while the queued requests unrelated to the interactive write keep
+     * waiting.
+     */
+    enum class RequestPriority
+    {
+        Interactive = 0,
+        Background,
+        Bulk
+    };
+
+    friend QUENTIER_EXPORT QTextStream & operator<<(
+        QTextStream & strm, const RequestPriority priority);
+
+    friend QUENTIER_EXPORT QDebug & operator<<(
+        QDebug & dbg, const RequestPriority priority);
+
+    /**
+     * @brief The RequestQueueStatistics struct contains the statistics
+     * collected for requests of a single priority. Wait duration is the time
+     * between the arrival of the request to the thread of
+     * LocalStorageManagerAsync and the start of its processing so it is zero
+     * for interactive requests.
+     */
+    struct QUENTIER_EXPORT RequestQueueStatistics : public Printable
+    {
+        virtual QTextStream & print(QTextStream & strm) const override;
+
+        RequestPriority m_priority = RequestPriority::Interactive;
+
+        // The number of requests waiting in the queue at the moment and
+        // the largest number of requests ever waiting in it
+        qint64 m_queueDepth = 0;
+        qint64 m_maxQueueDepth = 0;
+
+        qint64 m_processedRequestCount = 0;
+        qint64 m_totalWaitDurationUsec = 0;
+        qint64 m_maxWaitDurationUsec = 0;
+    };
+
+    // Requests sent by signals of the given object are served with the given
+    // priority; requests from other objects and ones made via direct calls
+    // to slots are interactive. Requests from the same sender are run in
+    // the order they were sent unless the sender's priority is changed while
+    // some of its requests are still queued. Can be called from any thread
+    void setRequestSenderPriority(
+        QObject * pSender, const RequestPriority priority);
+
+    // Statistics for each priority since the creation of
+    // LocalStorageManagerAsync or since the last call to
+    // resetRequestQueueStatistics. Can be called from any thread
+    QList<RequestQueueStatistics> requestQueueStatistics() const;
+    void resetRequestQueueStatistics();
+
+    // The number of count and list requests which were not run against
+    // the database because an identical request was already running against
+    // one of read-only connections; such requests get the result of that one.
+    // Reset by resetRequestQueueStatistics. Can be called from any thread
+    qint64 coalescedReadRequestCount() const;
+
 Q_SIGNALS:
     // Sent when the initialization is complete
     void initialized();
@@ -164,6 +262,22 @@ Q_SIGNALS:
         QString linkedNotebookGuid, ErrorString errorDescription,
         QUuid requestId);
 
+    void listNotebooksPageComplete(
+        LocalStorageManager::ListObjectsOptions flag, size_t pageSize,
+        QString continuationToken,
+        LocalStorageManager::ListNotebooksOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, QList<Notebook> foundNotebooks,
+        QString nextContinuationToken, QUuid requestId);
+
+    void listNotebooksPageFailed(
+        LocalStorageManager::ListObjectsOptions flag, size_t pageSize,
+        QString continuationToken,
+        LocalStorageManager::ListNotebooksOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, ErrorString errorDescription,
+        QUuid requestId);
+
     void listAllSharedNotebooksComplete(
         QList<SharedNotebook> foundSharedNotebooks, QUuid requestId);
 
@@ -296,6 +410,24 @@ Q_SIGNALS:
         Note note, LocalStorageManager::UpdateNoteOptions options,
         ErrorString errorDescription, QUuid requestId);
 
+    // Batch note signals; the per-note signals above are emitted for each
+    // note within the batch as well, with the same request id. Notes and
+    // per-note error descriptions follow the order of notes in the request
+    void addNotesComplete(
+        QList<Note> notes, QList<ErrorString> errorDescriptions,
+        QUuid requestId);
+
+    void addNotesFailed(
+        QList<Note> notes, ErrorString errorDescription, QUuid requestId);
+
+    void updateNotesComplete(
+        QList<Note> notes, LocalStorageManager::UpdateNoteOptions options,
+        QList<ErrorString> errorDescriptions, QUuid requestId);
+
+    void updateNotesFailed(
+        QList<Note> notes, LocalStorageManager::UpdateNoteOptions options,
+        ErrorString errorDescription, QUuid requestId);
+
     void findNoteComplete(
         Note foundNote, LocalStorageManager::GetNoteOptions options,
         QUuid requestId);
@@ -377,6 +509,39 @@ Q_SIGNALS:
         QString linkedNotebookGuid, ErrorString errorDescription,
         QUuid requestId);
 
+    void listNotesPageComplete(
+        LocalStorageManager::ListObjectsOptions flag,
+        LocalStorageManager::GetNoteOptions options, size_t pageSize,
+        QString continuationToken, LocalStorageManager::ListNotesOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, QList<Note> foundNotes,
+        QString nextContinuationToken, QUuid requestId);
+
+    void listNotesPageFailed(
+        LocalStorageManager::ListObjectsOptions flag,
+        LocalStorageManager::GetNoteOptions options, size_t pageSize,
+        QString continuationToken, LocalStorageManager::ListNotesOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, ErrorString errorDescription,
+        QUuid requestId);
+
+    void listNoteSummariesComplete(
+        LocalStorageManager::ListObjectsOptions flag,
+        LocalStorageManager::NoteSummaryFields fields, size_t limit,
+        size_t offset, LocalStorageManager::ListNotesOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, int previewLength,
+        QList<LocalStorageManager::NoteSummary> foundNoteSummaries,
+        QUuid requestId);
+
+    void listNoteSummariesFailed(
+        LocalStorageManager::ListObjectsOptions flag,
+        LocalStorageManager::NoteSummaryFields fields, size_t limit,
+        size_t offset, LocalStorageManager::ListNotesOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, int previewLength,
+        ErrorString errorDescription, QUuid requestId);
+
     void findNoteLocalUidsWithSearchQueryComplete(
         QStringList noteLocalUids, NoteSearchQuery noteSearchQuery,
         QUuid requestId);
@@ -385,6 +550,24 @@ Q_SIGNALS:
         NoteSearchQuery noteSearchQuery, ErrorString errorDescription,
         QUuid requestId);
 
+    void findNoteSearchHitsComplete(
+        QList<LocalStorageManager::NoteSearchHit> hits,
+        NoteSearchQuery noteSearchQuery, size_t limit, QUuid requestId);
+
+    void findNoteSearchHitsFailed(
+        NoteSearchQuery noteSearchQuery, size_t limit,
+        ErrorString errorDescription, QUuid requestId);
+
+    void findNoteLocalUidsWithinBoundingBoxComplete(
+        QStringList noteLocalUids, double minLatitude, double maxLatitude,
+        double minLongitude, double maxLongitude,
+        LocalStorageManager::NoteCountOptions options, QUuid requestId);
+
+    void findNoteLocalUidsWithinBoundingBoxFailed(
+        double minLatitude, double maxLatitude, double minLongitude,
+        double maxLongitude, LocalStorageManager::NoteCountOptions options,
+        ErrorString errorDescription, QUuid requestId);
+
     void expungeNoteComplete(Note note, QUuid requestId);
 
     void expungeNoteFailed(
@@ -407,6 +590,16 @@ Q_SIGNALS:
     void getTagCountFailed(ErrorString errorDescription, QUuid requestId);
     void addTagComplete(Tag tag, QUuid requestId);
     void addTagFailed(Tag tag, ErrorString errorDescription, QUuid requestId);
+
+    // Batch tag signals; the per-tag signals above are emitted for each tag
+    // within the batch as well, with the same request id
+    void addTagsComplete(
+        QList<Tag> tags, QList<ErrorString> errorDescriptions,
+        QUuid requestId);
+
+    void addTagsFailed(
+        QList<Tag> tags, ErrorString errorDescription, QUuid requestId);
+
     void updateTagComplete(Tag tag, QUuid requestId);
 
     void updateTagFailed(
@@ -457,6 +650,20 @@ Q_SIGNALS:
         QString linkedNotebookGuid, ErrorString errorDescription,
         QUuid requestId);
 
+    void listTagsPageComplete(
+        LocalStorageManager::ListObjectsOptions flag, size_t pageSize,
+        QString continuationToken, LocalStorageManager::ListTagsOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, QList<Tag> foundTags,
+        QString nextContinuationToken, QUuid requestId);
+
+    void listTagsPageFailed(
+        LocalStorageManager::ListObjectsOptions flag, size_t pageSize,
+        QString continuationToken, LocalStorageManager::ListTagsOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, ErrorString errorDescription,
+        QUuid requestId);
+
     void listTagsWithNoteLocalUidsComplete(
         LocalStorageManager::ListObjectsOptions flag, size_t limit,
         size_t offset, LocalStorageManager::ListTagsOrder order,
@@ -565,6 +772,26 @@ Q_SIGNALS:
         QString linkedNotebookGuid, ErrorString errorDescription,
         QUuid requestId);
 
+    void freePageStatisticsComplete(
+        LocalStorageManager::FreePageStatistics statistics, QUuid requestId);
+
+    void freePageStatisticsFailed(
+        ErrorString errorDescription, QUuid requestId);
+
+    void createSnapshotProgress(double progress, QUuid requestId);
+    void createSnapshotComplete(QString snapshotDirPath, QUuid requestId);
+
+    void createSnapshotFailed(
+        QString snapshotDirPath, ErrorString errorDescription, QUuid requestId);
+
+    void setPerformanceProfileComplete(
+        LocalStorageManager::PerformanceProfile performanceProfile,
+        QUuid requestId);
+
+    void setPerformanceProfileFailed(
+        LocalStorageManager::PerformanceProfile performanceProfile,
+        ErrorString errorDescription, QUuid requestId);
+
 public Q_SLOTS:
     void init();
 
@@ -606,6 +833,13 @@ public Q_SLOTS:
         LocalStorageManager::OrderDirection orderDirection,
         QString linkedNotebookGuid, QUuid requestId);
 
+    void onListNotebooksPageRequest(
+        LocalStorageManager::ListObjectsOptions flag, size_t pageSize,
+        QString continuationToken,
+        LocalStorageManager::ListNotebooksOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, QUuid requestId);
+
     void onListSharedNotebooksPerNotebookGuidRequest(
         QString notebookGuid, QUuid requestId);
 
@@ -661,6 +895,12 @@ public Q_SLOTS:
         Note note, LocalStorageManager::UpdateNoteOptions options,
         QUuid requestId);
 
+    void onAddNotesRequest(QList<Note> notes, QUuid requestId);
+
+    void onUpdateNotesRequest(
+        QList<Note> notes, LocalStorageManager::UpdateNoteOptions options,
+        QUuid requestId);
+
     void onFindNoteRequest(
         Note note, LocalStorageManager::GetNoteOptions options,
         QUuid requestId);
@@ -697,14 +937,37 @@ public Q_SLOTS:
         LocalStorageManager::OrderDirection orderDirection,
         QString linkedNotebookGuid, QUuid requestId);
 
+    void onListNotesPageRequest(
+        LocalStorageManager::ListObjectsOptions flag,
+        LocalStorageManager::GetNoteOptions options, size_t pageSize,
+        QString continuationToken, LocalStorageManager::ListNotesOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, QUuid requestId);
+
+    void onListNoteSummariesRequest(
+        LocalStorageManager::ListObjectsOptions flag,
+        LocalStorageManager::NoteSummaryFields fields, size_t limit,
+        size_t offset, LocalStorageManager::ListNotesOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, int previewLength, QUuid requestId);
+
     void onFindNoteLocalUidsWithSearchQuery(
         NoteSearchQuery noteSearchQuery, QUuid requestId);
 
+    void onFindNoteSearchHitsRequest(
+        NoteSearchQuery noteSearchQuery, size_t limit, QUuid requestId);
+
+    void onFindNoteLocalUidsWithinBoundingBoxRequest(
+        double minLatitude, double maxLatitude, double minLongitude,
+        double maxLongitude, LocalStorageManager::NoteCountOptions options,
+        QUuid requestId);
+
     void onExpungeNoteRequest(Note note, QUuid requestId);
 
     // Tag-related slots:
     void onGetTagCountRequest(QUuid requestId);
     void onAddTagRequest(Tag tag, QUuid requestId);
+    void onAddTagsRequest(QList<Tag> tags, QUuid requestId);
     void onUpdateTagRequest(Tag tag, QUuid requestId);
     void onFindTagRequest(Tag tag, QUuid requestId);
 
@@ -724,6 +987,12 @@ public Q_SLOTS:
         LocalStorageManager::OrderDirection orderDirection,
         QString linkedNotebookGuid, QUuid requestId);
 
+    void onListTagsPageRequest(
+        LocalStorageManager::ListObjectsOptions flag, size_t pageSize,
+        QString continuationToken, LocalStorageManager::ListTagsOrder order,
+        LocalStorageManager::OrderDirection orderDirection,
+        QString linkedNotebookGuid, QUuid requestId);
+
     void onListTagsWithNoteLocalUidsRequest(
         LocalStorageManager::ListObjectsOptions flag, size_t limit,
         size_t offset, LocalStorageManager::ListTagsOrder order,
@@ -764,10 +1033,47 @@ public Q_SLOTS:
 
     void onAccountHighUsnRequest(QString linkedNotebookGuid, QUuid requestId);
 
+    void onFreePageStatisticsRequest(QUuid requestId);
+
+    /**
+     * Creates the snapshot of the local storage within a dedicated thread
+     * using a separate read-only connection to the database so that other
+     * requests continue to be served while the snapshot is being created;
+     * see LocalStorageManager::createSnapshot for details
+     */
+    void onCreateSnapshotRequest(QString snapshotDirPath, QUuid requestId);
+
+    /**
+     * Applies the performance profile to the primary connection to the local
+     * storage database and to read-only connections opened after that; see
+     * LocalStorageManager::setPerformanceProfile for details
+     */
+    void onSetPerformanceProfileRequest(
+        LocalStorageManager::PerformanceProfile performanceProfile,
+        QUuid requestId);
+
 private:
     LocalStorageManagerAsync() = delete;
     Q_DISABLE_COPY(LocalStorageManagerAsync)
 
+    void checkNoteChangesToTrack(
+        const LocalStorageManager::UpdateNoteOptions options,
+        bool & shouldCheckForNotebookChange,
+        bool & shouldCheckForTagListUpdate) const;
+
+    bool findPreviousNoteVersion(
+        const Note & note, Note & previousNoteVersion,
+        ErrorString & errorDescription);
+
+    void cacheUpdatedNote(
+        const Note & note,
+        const LocalStorageManager::UpdateNoteOptions options);
+
+    void notifyNoteChanges(
+        const Note & note, const Note & previousNoteVersion,
+        const bool shouldCheckForNotebookChange,
+        const bool shouldCheckForTagListUpdate);
+
     LocalStorageManagerAsyncPrivate * const d_ptr;
     Q_DECLARE_PRIVATE(LocalStorageManagerAsync)
 };
@@ -22,6 +22,8 @@
 #include "INoteStoreDataElement.h"
 #include "Note.h"
 
+#include <memory>
+
 namespace quentier {
 
 QT_FORWARD_DECLARE_CLASS(ResourceData)
@@ -92,6 +94,44 @@ public:
     const QByteArray & dataBody() const;
     void setDataBody(const QByteArray & body);
 
+    /**
+     * This overload of setDataBody doesn't take ownership of the bytes of
+     * the body: it is meant for bodies created via QByteArray::fromRawData
+     * over the memory owned by bodyOwner, for example, memory mapped file.
+     * The resource and all its copies keep bodyOwner alive so the body stays
+     * valid as long as any of them exists. Note that a bare QByteArray copy of
+     * such body doesn't keep the owner alive.
+     */
+    void setDataBody(
+        const QByteArray & body, std::shared_ptr<const void> bodyOwner);
+
+    /**
+     * @return  True if the data body of the resource was set along with
+     *          the owner of its bytes, false otherwise
+     */
+    bool hasDataBodyOwner() const;
+
+    /**
+     * @return  True if the data body of the resource is not held in memory
+     *          but read from the file it is stored in on the first call to
+     *          dataBody, false otherwise
+     */
+    bool hasLazyDataBody() const;
+
+    /**
+     * setLazyDataBody makes the resource refer to the file containing its
+     * data body instead of holding the body: the body is read from the file
+     * on the first call to dataBody and is shared by all copies of
+     * the resource. hasDataBody returns true for such resource unless
+     * the file doesn't exist or could not be read; dataBody returns empty
+     * byte array in the latter case. Setting the data body via setDataBody
+     * drops the reference to the file.
+     *
+     * @param filePath      The absolute path to the file containing the data
+     *                      body of the resource
+     */
+    void setLazyDataBody(const QString & filePath);
+
     bool hasMime() const;
     const QString & mime() const;
     void setMime(const QString & mime);
@@ -132,6 +172,47 @@ public:
     const QByteArray & alternateDataBody() const;
     void setAlternateDataBody(const QByteArray & body);
 
+    /**
+     * See the description of setDataBody overload taking bodyOwner
+     */
+    void setAlternateDataBody(
+        const QByteArray & body, std::shared_ptr<const void> bodyOwner);
+
+    /**
+     * See the description of hasDataBodyOwner
+     */
+    bool hasAlternateDataBodyOwner() const;
+
+    /**
+     * See the description of hasLazyDataBody
+     */
+    bool hasLazyAlternateDataBody() const;
+
+    /**
+     * See the description of setLazyDataBody
+     */
+    void setLazyAlternateDataBody(const QString & filePath);
+
+    /**
+     * prefetchDataBodies reads lazy data body and alternate data body (if any)
+     * from their files right away instead of waiting for the first access.
+     * After the call the bodies are also included into qevercloudResource.
+     *
+     * @return  True if all lazy bodies were read successfully, false otherwise
+     */
+    bool prefetchDataBodies();
+
+    /**
+     * releaseDataBodies frees the memory occupied by the read lazy data body
+     * and alternate data body (if any) keeping the references to their files
+     * so that they would be read again on the next access. Only this copy
+     * of the resource drops the bodies: other copies sharing them keep
+     * the already read ones. References to the bodies obtained from this
+     * copy before the call become invalid. Does nothing for bodies which
+     * are not lazy.
+     */
+    void releaseDataBodies();
+
     bool hasResourceAttributes() const;
     const qevercloud::ResourceAttributes & resourceAttributes() const;
     qevercloud::ResourceAttributes & resourceAttributes();
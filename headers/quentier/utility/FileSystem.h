@@ -96,6 +96,25 @@ readFileContents(const QString & filePath, ErrorString & errorDescription);
 bool QUENTIER_EXPORT renameFile(
     const QString & from, const QString & to, ErrorString & errorDescription);
 
+/**
+ * linkOrCopyFile creates file with absolute path "to" having the same contents
+ * as file with absolute path "from". If possible, the new file is created as
+ * a hard link to the existing one so that no data is actually copied; if hard
+ * links are not supported, for example, if the files are on different file
+ * systems, the file is copied. On Linux and Mac the hard link is created via
+ * "link" from the standard C library while on Windows CreateHardLinkW is used
+ *
+ * @param from              The absolute file path of the existing file
+ * @param to                The absolute file path of the file to be created;
+ *                          the file must not exist
+ * @param errorDescription  The textual description of the error in case of
+ *                          inability to either link or copy the file
+ * @return                  True if file was successfully linked or copied,
+ *                          false otherwise
+ */
+bool QUENTIER_EXPORT linkOrCopyFile(
+    const QString & from, const QString & to, ErrorString & errorDescription);
+
 } // namespace quentier
 
 #endif // LIB_QUENTIER_UTILITY_FILE_SYSTEM_H
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <quentier/local_storage/ByteBudgetLocalStorageCacheExpiryChecker.h>
+#include <quentier/local_storage/LocalStorageCacheManager.h>
+
+namespace quentier {
+
+ByteBudgetLocalStorageCacheExpiryChecker::
+    ByteBudgetLocalStorageCacheExpiryChecker(
+        const LocalStorageCacheManager & cacheManager) :
+    ILocalStorageCacheExpiryChecker(cacheManager)
+{}
+
+ByteBudgetLocalStorageCacheExpiryChecker::
+    ByteBudgetLocalStorageCacheExpiryChecker(
+        const LocalStorageCacheManager & cacheManager, const Budget & budget) :
+    ILocalStorageCacheExpiryChecker(cacheManager),
+    m_budget(budget)
+{}
+
+ByteBudgetLocalStorageCacheExpiryChecker::
+    ~ByteBudgetLocalStorageCacheExpiryChecker()
+{}
+
+const ByteBudgetLocalStorageCacheExpiryChecker::Budget &
+ByteBudgetLocalStorageCacheExpiryChecker::budget() const
+{
+    return m_budget;
+}
+
+ByteBudgetLocalStorageCacheExpiryChecker *
+ByteBudgetLocalStorageCacheExpiryChecker::clone() const
+{
+    return new ByteBudgetLocalStorageCacheExpiryChecker(
+        m_localStorageCacheManager, m_budget);
+}
+
+bool ByteBudgetLocalStorageCacheExpiryChecker::checkNotes() const
+{
+    size_t bytes = m_localStorageCacheManager.cachedNotesBytes();
+    return (bytes < m_budget.m_notesBytes);
+}
+
+bool ByteBudgetLocalStorageCacheExpiryChecker::checkResources() const
+{
+    size_t bytes = m_localStorageCacheManager.cachedResourcesBytes();
+    return (bytes < m_budget.m_resourcesBytes);
+}
+
+bool ByteBudgetLocalStorageCacheExpiryChecker::checkNotebooks() const
+{
+    size_t bytes = m_localStorageCacheManager.cachedNotebooksBytes();
+    return (bytes < m_budget.m_notebooksBytes);
+}
+
+bool ByteBudgetLocalStorageCacheExpiryChecker::checkTags() const
+{
+    size_t bytes = m_localStorageCacheManager.cachedTagsBytes();
+    return (bytes < m_budget.m_tagsBytes);
+}
+
+bool ByteBudgetLocalStorageCacheExpiryChecker::checkLinkedNotebooks() const
+{
+    size_t bytes = m_localStorageCacheManager.cachedLinkedNotebooksBytes();
+    return (bytes < m_budget.m_linkedNotebooksBytes);
+}
+
+bool ByteBudgetLocalStorageCacheExpiryChecker::checkSavedSearches() const
+{
+    size_t bytes = m_localStorageCacheManager.cachedSavedSearchesBytes();
+    return (bytes < m_budget.m_savedSearchesBytes);
+}
+
+QTextStream & ByteBudgetLocalStorageCacheExpiryChecker::print(
+    QTextStream & strm) const
+{
+    const char * indent = "  ";
+
+    strm << "ByteBudgetLocalStorageCacheExpiryChecker: {\n"
+         << indent << "notes bytes: " << m_budget.m_notesBytes << ";\n"
+         << indent << "resources bytes: " << m_budget.m_resourcesBytes
+         << ";\n"
+         << indent << "notebooks bytes: " << m_budget.m_notebooksBytes
+         << ";\n"
+         << indent << "tags bytes: " << m_budget.m_tagsBytes << ";\n"
+         << indent
+         << "linked notebooks bytes: " << m_budget.m_linkedNotebooksBytes
+         << ";\n"
+         << indent
+         << "saved searches bytes: " << m_budget.m_savedSearchesBytes << "\n"
+         << "};\n";
+
+    return strm;
+}
+
+} // namespace quentier
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GuidLocalUidIndex.h"
+
+#include <quentier/utility/UidGenerator.h>
+
+#include <initializer_list>
+
+namespace quentier {
+
+bool GuidLocalUidIndex::isEnabled() const
+{
+    return m_enabled;
+}
+
+void GuidLocalUidIndex::setEnabled(const bool enabled)
+{
+    m_enabled = enabled;
+    if (!m_enabled) {
+        clear();
+    }
+}
+
+bool GuidLocalUidIndex::localUidForGuid(
+    const ObjectType type, const QString & guid, QString & localUid) const
+{
+    if (!m_enabled) {
+        return false;
+    }
+
+    QUuid guidUuid;
+    if (!toUuid(guid, guidUuid)) {
+        return false;
+    }
+
+    const auto & localUidsByGuid = entries(type).m_localUidsByGuid;
+    auto it = localUidsByGuid.constFind(guidUuid);
+    if (it == localUidsByGuid.constEnd()) {
+        ++m_missCount;
+        return false;
+    }
+
+    ++m_hitCount;
+    localUid = UidGenerator::UidToString(it.value());
+    return true;
+}
+
+bool GuidLocalUidIndex::guidForLocalUid(
+    const ObjectType type, const QString & localUid, QString & guid) const
+{
+    if (!m_enabled) {
+        return false;
+    }
+
+    QUuid localUidUuid;
+    if (!toUuid(localUid, localUidUuid)) {
+        return false;
+    }
+
+    const auto & guidsByLocalUid = entries(type).m_guidsByLocalUid;
+    auto it = guidsByLocalUid.constFind(localUidUuid);
+    if (it == guidsByLocalUid.constEnd()) {
+        ++m_missCount;
+        return false;
+    }
+
+    ++m_hitCount;
+    guid = UidGenerator::UidToString(it.value());
+    return true;
+}
+
+void GuidLocalUidIndex::insert(
+    const ObjectType type, const QString & guid, const QString & localUid)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    QUuid localUidUuid;
+    if (!toUuid(localUid, localUidUuid)) {
+        // Can't tell which entry might refer to this item
+        clear(type);
+        return;
+    }
+
+    removeByLocalUid(type, localUid);
+    removeByGuid(type, guid);
+
+    QUuid guidUuid;
+    if (guid.isEmpty() || !toUuid(guid, guidUuid)) {
+        return;
+    }
+
+    auto & typeEntries = entries(type);
+    typeEntries.m_localUidsByGuid[guidUuid] = localUidUuid;
+    typeEntries.m_guidsByLocalUid[localUidUuid] = guidUuid;
+}
+
+void GuidLocalUidIndex::removeByLocalUid(
+    const ObjectType type, const QString & localUid)
+{
+    QUuid localUidUuid;
+    if (!toUuid(localUid, localUidUuid)) {
+        return;
+    }
+
+    auto & typeEntries = entries(type);
+    auto it = typeEntries.m_guidsByLocalUid.find(localUidUuid);
+    if (it == typeEntries.m_guidsByLocalUid.end()) {
+        return;
+    }
+
+    typeEntries.m_localUidsByGuid.remove(it.value());
+    typeEntries.m_guidsByLocalUid.erase(it);
+}
+
+void GuidLocalUidIndex::removeByGuid(
+    const ObjectType type, const QString & guid)
+{
+    QUuid guidUuid;
+    if (!toUuid(guid, guidUuid)) {
+        return;
+    }
+
+    auto & typeEntries = entries(type);
+    auto it = typeEntries.m_localUidsByGuid.find(guidUuid);
+    if (it == typeEntries.m_localUidsByGuid.end()) {
+        return;
+    }
+
+    typeEntries.m_guidsByLocalUid.remove(it.value());
+    typeEntries.m_localUidsByGuid.erase(it);
+}
+
+void GuidLocalUidIndex::clear(const ObjectType type)
+{
+    auto & typeEntries = entries(type);
+    typeEntries.m_localUidsByGuid.clear();
+    typeEntries.m_guidsByLocalUid.clear();
+}
+
+void GuidLocalUidIndex::clear()
+{
+    for (auto & typeEntries: m_entries) {
+        typeEntries.m_localUidsByGuid.clear();
+        typeEntries.m_guidsByLocalUid.clear();
+    }
+}
+
+GuidLocalUidIndex::Statistics GuidLocalUidIndex::statistics() const
+{
+    // Approximation of QHash memory layout: each node holds the pointer to
+    // the next node, the hash value (padded) and the key and the value; each
+    // bucket is a pointer to node
+    constexpr qint64 nodeSize = 2 * sizeof(void *) + 2 * sizeof(QUuid);
+    constexpr qint64 bucketSize = sizeof(void *);
+
+    Statistics statistics;
+    statistics.m_enabled = m_enabled;
+    statistics.m_hitCount = m_hitCount;
+    statistics.m_missCount = m_missCount;
+
+    for (const auto & typeEntries: m_entries) {
+        statistics.m_entryCount += typeEntries.m_localUidsByGuid.size();
+
+        for (const auto * pHash:
+             {&typeEntries.m_localUidsByGuid, &typeEntries.m_guidsByLocalUid})
+        {
+            statistics.m_memoryUsage +=
+                pHash->size() * nodeSize + pHash->capacity() * bucketSize;
+        }
+    }
+
+    return statistics;
+}
+
+bool GuidLocalUidIndex::toUuid(const QString & str, QUuid & uuid)
+{
+    // Only the strings which would be restored exactly from QUuid by
+    // UidGenerator::UidToString are indexed: lowercase uuids without braces
+    if (str.size() != 36) {
+        return false;
+    }
+
+    for (const auto & c: str) {
+        if (c.isUpper()) {
+            return false;
+        }
+    }
+
+    uuid = QUuid(str);
+    return !uuid.isNull();
+}
+
+GuidLocalUidIndex::Entries & GuidLocalUidIndex::entries(const ObjectType type)
+{
+    return m_entries[static_cast<size_t>(type)];
+}
+
+const GuidLocalUidIndex::Entries & GuidLocalUidIndex::entries(
+    const ObjectType type) const
+{
+    return m_entries[static_cast<size_t>(type)];
+}
+
+} // namespace quentier
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_GUID_LOCAL_UID_INDEX_H
+#define LIB_QUENTIER_LOCAL_STORAGE_GUID_LOCAL_UID_INDEX_H
+
+#include <quentier/local_storage/LocalStorageManager.h>
+
+#include <QHash>
+#include <QString>
+#include <QUuid>
+
+#include <array>
+
+namespace quentier {
+
+/**
+ * @brief The GuidLocalUidIndex class keeps in memory the correspondence
+ * between guids and local uids of data items found by or written into
+ * the local storage so that translating one into another doesn't require
+ * a query to the database. Both guids and local uids are stored as QUuid
+ * rather than strings; the values which are not uuids in canonical form are
+ * not indexed.
+ *
+ * The index is filled lazily and holds only the items known to exist: whoever
+ * removes items from the database is responsible for removing them from
+ * the index or, if it is not known which items were removed, for clearing
+ * the index of the respective object type.
+ */
+class Q_DECL_HIDDEN GuidLocalUidIndex
+{
+public:
+    enum class ObjectType
+    {
+        Notebook = 0,
+        Note,
+        Tag,
+        Resource,
+        SavedSearch
+    };
+
+    using Statistics = LocalStorageManager::GuidIndexStatistics;
+
+    bool isEnabled() const;
+
+    // Disabling the index also clears it
+    void setEnabled(const bool enabled);
+
+    bool localUidForGuid(
+        const ObjectType type, const QString & guid, QString & localUid) const;
+
+    bool guidForLocalUid(
+        const ObjectType type, const QString & localUid, QString & guid) const;
+
+    // Replaces the existing entries for either the guid or the local uid;
+    // empty guid means the item with the local uid has no guid
+    void insert(
+        const ObjectType type, const QString & guid, const QString & localUid);
+
+    void removeByLocalUid(const ObjectType type, const QString & localUid);
+    void removeByGuid(const ObjectType type, const QString & guid);
+
+    void clear(const ObjectType type);
+    void clear();
+
+    Statistics statistics() const;
+
+private:
+    static bool toUuid(const QString & str, QUuid & uuid);
+
+    struct Entries
+    {
+        QHash<QUuid, QUuid> m_localUidsByGuid;
+        QHash<QUuid, QUuid> m_guidsByLocalUid;
+    };
+
+    Entries & entries(const ObjectType type);
+    const Entries & entries(const ObjectType type) const;
+
+private:
+    std::array<Entries, 5> m_entries;
+    bool m_enabled = true;
+
+    mutable qint64 m_hitCount = 0;
+    mutable qint64 m_missCount = 0;
+};
+
+} // namespace quentier
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_GUID_LOCAL_UID_INDEX_H
@@ -52,6 +52,18 @@ size_t LocalStorageCacheManager::numCachedNotes() const
     return d->numCachedNotes();
 }
 
+size_t LocalStorageCacheManager::cachedNotesBytes() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->cachedNotesBytes();
+}
+
+size_t LocalStorageCacheManager::numEvictedNotes() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->numEvictedNotes();
+}
+
 void LocalStorageCacheManager::cacheNote(const Note & note)
 {
     Q_D(LocalStorageCacheManager);
@@ -124,6 +136,18 @@ size_t LocalStorageCacheManager::numCachedResources() const
     return d->numCachedResources();
 }
 
+size_t LocalStorageCacheManager::cachedResourcesBytes() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->cachedResourcesBytes();
+}
+
+size_t LocalStorageCacheManager::numEvictedResources() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->numEvictedResources();
+}
+
 void LocalStorageCacheManager::cacheResource(const Resource & resource)
 {
     Q_D(LocalStorageCacheManager);
@@ -148,6 +172,18 @@ size_t LocalStorageCacheManager::numCachedNotebooks() const
     return d->numCachedNotebooks();
 }
 
+size_t LocalStorageCacheManager::cachedNotebooksBytes() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->cachedNotebooksBytes();
+}
+
+size_t LocalStorageCacheManager::numEvictedNotebooks() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->numEvictedNotebooks();
+}
+
 void LocalStorageCacheManager::cacheNotebook(const Notebook & notebook)
 {
     Q_D(LocalStorageCacheManager);
@@ -172,6 +208,18 @@ size_t LocalStorageCacheManager::numCachedTags() const
     return d->numCachedTags();
 }
 
+size_t LocalStorageCacheManager::cachedTagsBytes() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->cachedTagsBytes();
+}
+
+size_t LocalStorageCacheManager::numEvictedTags() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->numEvictedTags();
+}
+
 void LocalStorageCacheManager::cacheTag(const Tag & tag)
 {
     Q_D(LocalStorageCacheManager);
@@ -196,6 +244,18 @@ size_t LocalStorageCacheManager::numCachedLinkedNotebooks() const
     return d->numCachedLinkedNotebooks();
 }
 
+size_t LocalStorageCacheManager::cachedLinkedNotebooksBytes() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->cachedLinkedNotebooksBytes();
+}
+
+size_t LocalStorageCacheManager::numEvictedLinkedNotebooks() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->numEvictedLinkedNotebooks();
+}
+
 void LocalStorageCacheManager::cacheLinkedNotebook(
     const LinkedNotebook & linkedNotebook)
 {
@@ -229,6 +289,18 @@ size_t LocalStorageCacheManager::numCachedSavedSearches() const
     return d->numCachedSavedSearches();
 }
 
+size_t LocalStorageCacheManager::cachedSavedSearchesBytes() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->cachedSavedSearchesBytes();
+}
+
+size_t LocalStorageCacheManager::numEvictedSavedSearches() const
+{
+    Q_D(const LocalStorageCacheManager);
+    return d->numEvictedSavedSearches();
+}
+
 void LocalStorageCacheManager::cacheSavedSearch(const SavedSearch & savedSearch)
 {
     Q_D(LocalStorageCacheManager);
@@ -40,12 +40,12 @@ LocalStorageCacheManagerPrivate::~LocalStorageCacheManagerPrivate() {}
 
 void LocalStorageCacheManagerPrivate::clear()
 {
-    m_notesCache.clear();
-    m_resourcesCache.clear();
-    m_notebooksCache.clear();
-    m_tagsCache.clear();
-    m_linkedNotebooksCache.clear();
-    m_savedSearchesCache.clear();
+    clearAllNotes();
+    clearAllResources();
+    clearAllNotebooks();
+    clearAllTags();
+    clearAllLinkedNotebooks();
+    clearAllSavedSearches();
 }
 
 bool LocalStorageCacheManagerPrivate::empty() const
@@ -90,6 +90,68 @@ size_t LocalStorageCacheManagerPrivate::numCachedSavedSearches() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+size_t LocalStorageCacheManagerPrivate::cachedNotesBytes() const
+{
+    return m_notesCacheStats.m_bytes;
+}
+
+size_t LocalStorageCacheManagerPrivate::numEvictedNotes() const
+{
+    return m_notesCacheStats.m_evictions;
+}
+
+size_t LocalStorageCacheManagerPrivate::cachedResourcesBytes() const
+{
+    return m_resourcesCacheStats.m_bytes;
+}
+
+size_t LocalStorageCacheManagerPrivate::numEvictedResources() const
+{
+    return m_resourcesCacheStats.m_evictions;
+}
+
+size_t LocalStorageCacheManagerPrivate::cachedNotebooksBytes() const
+{
+    return m_notebooksCacheStats.m_bytes;
+}
+
+size_t LocalStorageCacheManagerPrivate::numEvictedNotebooks() const
+{
+    return m_notebooksCacheStats.m_evictions;
+}
+
+size_t LocalStorageCacheManagerPrivate::cachedTagsBytes() const
+{
+    return m_tagsCacheStats.m_bytes;
+}
+
+size_t LocalStorageCacheManagerPrivate::numEvictedTags() const
+{
+    return m_tagsCacheStats.m_evictions;
+}
+
+size_t LocalStorageCacheManagerPrivate::cachedLinkedNotebooksBytes() const
+{
+    return m_linkedNotebooksCacheStats.m_bytes;
+}
+
+size_t LocalStorageCacheManagerPrivate::numEvictedLinkedNotebooks() const
+{
+    return m_linkedNotebooksCacheStats.m_evictions;
+}
+
+size_t LocalStorageCacheManagerPrivate::cachedSavedSearchesBytes() const
+{
+    return m_savedSearchesCacheStats.m_bytes;
+}
+
+size_t LocalStorageCacheManagerPrivate::numEvictedSavedSearches() const
+{
+    return m_savedSearchesCacheStats.m_evictions;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 namespace {
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -108,6 +170,154 @@ QString itemId(const LinkedNotebook & linkedNotebook)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// The estimates of memory footprints of cached objects only account for
+// the data which might be large: strings, binary data and lists of nested
+// objects; the overhead of containers and small fields is covered by
+// sizeof of the object itself
+
+size_t approximateBytes(const QString & str)
+{
+    return static_cast<size_t>(str.size()) * sizeof(QChar);
+}
+
+size_t approximateBytes(const QByteArray & bytes)
+{
+    return static_cast<size_t>(bytes.size());
+}
+
+template <typename T>
+size_t approximateBytes(const qevercloud::Optional<T> & optional);
+
+template <typename TItem>
+size_t approximateBytes(const QList<TItem> & items);
+
+size_t approximateBytes(const qevercloud::Data & data)
+{
+    return approximateBytes(data.body) + approximateBytes(data.bodyHash);
+}
+
+size_t approximateBytes(const qevercloud::SharedNote & sharedNote)
+{
+    Q_UNUSED(sharedNote)
+    return sizeof(qevercloud::SharedNote);
+}
+
+size_t approximateBytes(const qevercloud::SharedNotebook & sharedNotebook)
+{
+    return sizeof(qevercloud::SharedNotebook) +
+        approximateBytes(sharedNotebook.email) +
+        approximateBytes(sharedNotebook.username);
+}
+
+template <typename T>
+size_t approximateBytes(const qevercloud::Optional<T> & optional)
+{
+    return (optional.isSet() ? approximateBytes(optional.ref()) : 0);
+}
+
+template <typename TItem>
+size_t approximateBytes(const QList<TItem> & items)
+{
+    size_t bytes = 0;
+    for (const auto & item: items) {
+        bytes += approximateBytes(item);
+    }
+
+    return bytes;
+}
+
+size_t approximateBytes(
+    const qevercloud::Optional<qevercloud::Data> & data, const bool withBody)
+{
+    if (!data.isSet()) {
+        return 0;
+    }
+
+    return (withBody ? approximateBytes(data->body) : 0) +
+        approximateBytes(data->bodyHash);
+}
+
+size_t approximateItemBytes(const Resource & resource)
+{
+    const auto & qecResource = resource.qevercloudResource();
+
+    // Bodies referring to memory owned by someone else (i.e. memory mapped
+    // file) and lazily loaded bodies shared by all copies of the resource are
+    // not freed when the cached resource is evicted so they are not
+    // accounted here
+    const bool withDataBody =
+        !resource.hasDataBodyOwner() && !resource.hasLazyDataBody();
+
+    const bool withAlternateDataBody = !resource.hasAlternateDataBodyOwner() &&
+        !resource.hasLazyAlternateDataBody();
+
+    return sizeof(Resource) + sizeof(qevercloud::Resource) +
+        approximateBytes(qecResource.data, withDataBody) +
+        approximateBytes(qecResource.recognition) +
+        approximateBytes(qecResource.alternateData, withAlternateDataBody);
+}
+
+size_t approximateItemBytes(const Note & note)
+{
+    const auto & qecNote = note.qevercloudNote();
+
+    size_t bytes = sizeof(Note) + sizeof(qevercloud::Note) +
+        approximateBytes(qecNote.title) + approximateBytes(qecNote.content) +
+        approximateBytes(qecNote.tagGuids) +
+        approximateBytes(qecNote.sharedNotes) +
+        approximateBytes(note.tagLocalUids()) +
+        approximateBytes(note.thumbnailData());
+
+    if (note.hasResources()) {
+        const auto resources = note.resources();
+        for (const auto & resource: resources) {
+            bytes += approximateItemBytes(resource);
+        }
+    }
+
+    return bytes;
+}
+
+size_t approximateItemBytes(const Notebook & notebook)
+{
+    const auto & qecNotebook = notebook.qevercloudNotebook();
+
+    return sizeof(Notebook) + sizeof(qevercloud::Notebook) +
+        approximateBytes(qecNotebook.name) +
+        approximateBytes(qecNotebook.stack) +
+        approximateBytes(qecNotebook.sharedNotebooks);
+}
+
+size_t approximateItemBytes(const Tag & tag)
+{
+    return sizeof(Tag) + sizeof(qevercloud::Tag) +
+        approximateBytes(tag.qevercloudTag().name);
+}
+
+size_t approximateItemBytes(const LinkedNotebook & linkedNotebook)
+{
+    const auto & qecLinkedNotebook = linkedNotebook.qevercloudLinkedNotebook();
+
+    return sizeof(LinkedNotebook) + sizeof(qevercloud::LinkedNotebook) +
+        approximateBytes(qecLinkedNotebook.shareName) +
+        approximateBytes(qecLinkedNotebook.username) +
+        approximateBytes(qecLinkedNotebook.uri) +
+        approximateBytes(qecLinkedNotebook.noteStoreUrl) +
+        approximateBytes(qecLinkedNotebook.webApiUrlPrefix) +
+        approximateBytes(qecLinkedNotebook.stack);
+}
+
+size_t approximateItemBytes(const SavedSearch & savedSearch)
+{
+    const auto & qecSavedSearch = savedSearch.qevercloudSavedSearch();
+
+    return sizeof(SavedSearch) + sizeof(qevercloud::SavedSearch) +
+        approximateBytes(qecSavedSearch.name) +
+        approximateBytes(qecSavedSearch.query);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 template <typename T>
 bool checkExpiry(ILocalStorageCacheExpiryChecker & checker);
 
@@ -151,10 +361,10 @@ bool checkExpiry<SavedSearch>(ILocalStorageCacheExpiryChecker & checker)
 
 template <
     typename TItem, typename TCache, typename THolder, typename TIndex,
-    typename TChecker>
+    typename TChecker, typename TStats>
 void cacheItem(
     const TItem & item, const QString & itemTypeName, TCache & cache,
-    TChecker * pChecker)
+    TStats & stats, TChecker * pChecker)
 {
     auto & latIndex =
         cache.template get<typename THolder::ByLastAccessTimestamp>();
@@ -169,6 +379,8 @@ void cacheItem(
                     "local_storage",
                     "Going to remove the object from "
                         << "the local storage cache: " << *latIndexBegin);
+                stats.m_bytes -= latIndexBegin->m_approximateBytes;
+                ++stats.m_evictions;
                 Q_UNUSED(latIndex.erase(latIndexBegin));
                 continue;
             }
@@ -178,11 +390,14 @@ void cacheItem(
     THolder holder;
     holder.m_value = item;
     holder.m_lastAccessTimestamp = QDateTime::currentMSecsSinceEpoch();
+    holder.m_approximateBytes = approximateItemBytes(item);
 
     // See whether the item is already in the cache
     auto & uniqueIndex = cache.template get<TIndex>();
     auto it = uniqueIndex.find(itemId(item));
     if (it != uniqueIndex.end()) {
+        stats.m_bytes -= it->m_approximateBytes;
+        stats.m_bytes += holder.m_approximateBytes;
         uniqueIndex.replace(it, holder);
         QNTRACE(
             "local_storage",
@@ -209,6 +424,8 @@ void cacheItem(
         throw LocalStorageCacheManagerException(error);
     }
 
+    stats.m_bytes += holder.m_approximateBytes;
+
     QNTRACE(
         "local_storage",
         "Added " << itemTypeName << " to the local storage cache: " << item);
@@ -222,34 +439,36 @@ void LocalStorageCacheManagerPrivate::cacheNote(const Note & note)
 {
     cacheItem<
         Note, NotesCache, NoteHolder, NoteHolder::ByLocalUid,
-        ILocalStorageCacheExpiryChecker>(
-        note, QStringLiteral("note"), m_notesCache, m_cacheExpiryChecker.get());
+        ILocalStorageCacheExpiryChecker, CacheStats>(
+        note, QStringLiteral("note"), m_notesCache, m_notesCacheStats,
+        m_cacheExpiryChecker.get());
 }
 
 void LocalStorageCacheManagerPrivate::cacheNotebook(const Notebook & notebook)
 {
     cacheItem<
         Notebook, NotebooksCache, NotebookHolder, NotebookHolder::ByLocalUid,
-        ILocalStorageCacheExpiryChecker>(
+        ILocalStorageCacheExpiryChecker, CacheStats>(
         notebook, QStringLiteral("notebook"), m_notebooksCache,
-        m_cacheExpiryChecker.get());
+        m_notebooksCacheStats, m_cacheExpiryChecker.get());
 }
 
 void LocalStorageCacheManagerPrivate::cacheTag(const Tag & tag)
 {
     cacheItem<
         Tag, TagsCache, TagHolder, TagHolder::ByLocalUid,
-        ILocalStorageCacheExpiryChecker>(
-        tag, QStringLiteral("tag"), m_tagsCache, m_cacheExpiryChecker.get());
+        ILocalStorageCacheExpiryChecker, CacheStats>(
+        tag, QStringLiteral("tag"), m_tagsCache, m_tagsCacheStats,
+        m_cacheExpiryChecker.get());
 }
 
 void LocalStorageCacheManagerPrivate::cacheResource(const Resource & resource)
 {
     cacheItem<
         Resource, ResourcesCache, ResourceHolder, ResourceHolder::ByLocalUid,
-        ILocalStorageCacheExpiryChecker>(
+        ILocalStorageCacheExpiryChecker, CacheStats>(
         resource, QStringLiteral("resource"), m_resourcesCache,
-        m_cacheExpiryChecker.get());
+        m_resourcesCacheStats, m_cacheExpiryChecker.get());
 }
 
 void LocalStorageCacheManagerPrivate::cacheLinkedNotebook(
@@ -257,9 +476,11 @@ void LocalStorageCacheManagerPrivate::cacheLinkedNotebook(
 {
     cacheItem<
         LinkedNotebook, LinkedNotebooksCache, LinkedNotebookHolder,
-        LinkedNotebookHolder::ByGuid, ILocalStorageCacheExpiryChecker>(
+        LinkedNotebookHolder::ByGuid, ILocalStorageCacheExpiryChecker,
+        CacheStats>(
         linkedNotebook, QStringLiteral("linked notebook"),
-        m_linkedNotebooksCache, m_cacheExpiryChecker.get());
+        m_linkedNotebooksCache, m_linkedNotebooksCacheStats,
+        m_cacheExpiryChecker.get());
 }
 
 void LocalStorageCacheManagerPrivate::cacheSavedSearch(
@@ -267,18 +488,20 @@ void LocalStorageCacheManagerPrivate::cacheSavedSearch(
 {
     cacheItem<
         SavedSearch, SavedSearchesCache, SavedSearchHolder,
-        SavedSearchHolder::ByLocalUid, ILocalStorageCacheExpiryChecker>(
+        SavedSearchHolder::ByLocalUid, ILocalStorageCacheExpiryChecker,
+        CacheStats>(
         savedSearch, QStringLiteral("saved search"), m_savedSearchesCache,
-        m_cacheExpiryChecker.get());
+        m_savedSearchesCacheStats, m_cacheExpiryChecker.get());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace {
 
-template <typename TItem, typename TCache, typename THolder>
+template <typename TItem, typename TCache, typename THolder, typename TStats>
 void expungeItem(
-    const TItem & item, const QString & itemTypeName, TCache & cache)
+    const TItem & item, const QString & itemTypeName, TCache & cache,
+    TStats & stats)
 {
     bool itemHasGuid = item.hasGuid();
     const QString uid = (itemHasGuid ? item.guid() : item.localUid());
@@ -286,6 +509,7 @@ void expungeItem(
         auto & index = cache.template get<typename THolder::ByGuid>();
         auto it = index.find(uid);
         if (it != index.end()) {
+            stats.m_bytes -= it->m_approximateBytes;
             index.erase(it);
             QNDEBUG(
                 "local_storage",
@@ -297,6 +521,7 @@ void expungeItem(
         auto & index = cache.template get<typename THolder::ByLocalUid>();
         auto it = index.find(uid);
         if (it != index.end()) {
+            stats.m_bytes -= it->m_approximateBytes;
             index.erase(it);
             QNDEBUG(
                 "local_storage",
@@ -313,32 +538,35 @@ void expungeItem(
 void LocalStorageCacheManagerPrivate::expungeNote(const Note & note)
 {
     expungeItem<Note, NotesCache, NoteHolder>(
-        note, QStringLiteral("note"), m_notesCache);
+        note, QStringLiteral("note"), m_notesCache, m_notesCacheStats);
 }
 
 void LocalStorageCacheManagerPrivate::expungeResource(const Resource & resource)
 {
     expungeItem<Resource, ResourcesCache, ResourceHolder>(
-        resource, QStringLiteral("resource"), m_resourcesCache);
+        resource, QStringLiteral("resource"), m_resourcesCache,
+        m_resourcesCacheStats);
 }
 
 void LocalStorageCacheManagerPrivate::expungeNotebook(const Notebook & notebook)
 {
     expungeItem<Notebook, NotebooksCache, NotebookHolder>(
-        notebook, QStringLiteral("notebook"), m_notebooksCache);
+        notebook, QStringLiteral("notebook"), m_notebooksCache,
+        m_notebooksCacheStats);
 }
 
 void LocalStorageCacheManagerPrivate::expungeTag(const Tag & tag)
 {
     expungeItem<Tag, TagsCache, TagHolder>(
-        tag, QStringLiteral("tag"), m_tagsCache);
+        tag, QStringLiteral("tag"), m_tagsCache, m_tagsCacheStats);
 }
 
 void LocalStorageCacheManagerPrivate::expungeSavedSearch(
     const SavedSearch & search)
 {
     expungeItem<SavedSearch, SavedSearchesCache, SavedSearchHolder>(
-        search, QStringLiteral("saved search"), m_savedSearchesCache);
+        search, QStringLiteral("saved search"), m_savedSearchesCache,
+        m_savedSearchesCacheStats);
 }
 
 void LocalStorageCacheManagerPrivate::expungeLinkedNotebook(
@@ -348,6 +576,7 @@ void LocalStorageCacheManagerPrivate::expungeLinkedNotebook(
     auto & index = m_linkedNotebooksCache.get<LinkedNotebookHolder::ByGuid>();
     auto it = index.find(guid);
     if (it != index.end()) {
+        m_linkedNotebooksCacheStats.m_bytes -= it->m_approximateBytes;
         index.erase(it);
         QNDEBUG(
             "local_storage",
@@ -476,31 +705,37 @@ const SavedSearch * LocalStorageCacheManagerPrivate::findSavedSearchByName(
 void LocalStorageCacheManagerPrivate::clearAllNotes()
 {
     m_notesCache.clear();
+    m_notesCacheStats.m_bytes = 0;
 }
 
 void LocalStorageCacheManagerPrivate::clearAllResources()
 {
     m_resourcesCache.clear();
+    m_resourcesCacheStats.m_bytes = 0;
 }
 
 void LocalStorageCacheManagerPrivate::clearAllNotebooks()
 {
     m_notebooksCache.clear();
+    m_notebooksCacheStats.m_bytes = 0;
 }
 
 void LocalStorageCacheManagerPrivate::clearAllTags()
 {
     m_tagsCache.clear();
+    m_tagsCacheStats.m_bytes = 0;
 }
 
 void LocalStorageCacheManagerPrivate::clearAllLinkedNotebooks()
 {
     m_linkedNotebooksCache.clear();
+    m_linkedNotebooksCacheStats.m_bytes = 0;
 }
 
 void LocalStorageCacheManagerPrivate::clearAllSavedSearches()
 {
     m_savedSearchesCache.clear();
+    m_savedSearchesCacheStats.m_bytes = 0;
 }
 
 void LocalStorageCacheManagerPrivate::installCacheExpiryFunction(
@@ -60,6 +60,8 @@ public:
 
     // Notes cache
     size_t numCachedNotes() const;
+    size_t cachedNotesBytes() const;
+    size_t numEvictedNotes() const;
     void cacheNote(const Note & note);
     void expungeNote(const Note & note);
 
@@ -70,6 +72,8 @@ public:
 
     // Resources cache
     size_t numCachedResources() const;
+    size_t cachedResourcesBytes() const;
+    size_t numEvictedResources() const;
     void cacheResource(const Resource & resource);
     void expungeResource(const Resource & resource);
 
@@ -80,6 +84,8 @@ public:
 
     // Notebooks cache
     size_t numCachedNotebooks() const;
+    size_t cachedNotebooksBytes() const;
+    size_t numEvictedNotebooks() const;
     void cacheNotebook(const Notebook & notebook);
     void expungeNotebook(const Notebook & notebook);
 
@@ -91,6 +97,8 @@ public:
 
     // Tags cache
     size_t numCachedTags() const;
+    size_t cachedTagsBytes() const;
+    size_t numEvictedTags() const;
     void cacheTag(const Tag & tag);
     void expungeTag(const Tag & tag);
 
@@ -102,6 +110,8 @@ public:
 
     // Linked notebooks cache
     size_t numCachedLinkedNotebooks() const;
+    size_t cachedLinkedNotebooksBytes() const;
+    size_t numEvictedLinkedNotebooks() const;
     void cacheLinkedNotebook(const LinkedNotebook & linkedNotebook);
     void expungeLinkedNotebook(const LinkedNotebook & linkedNotebook);
 
@@ -111,6 +121,8 @@ public:
 
     // Saved searches cache
     size_t numCachedSavedSearches() const;
+    size_t cachedSavedSearchesBytes() const;
+    size_t numEvictedSavedSearches() const;
     void cacheSavedSearch(const SavedSearch & savedSearch);
     void expungeSavedSearch(const SavedSearch & savedSearch);
 
@@ -143,6 +155,7 @@ private:
 
         Note m_value;
         qint64 m_lastAccessTimestamp = 0;
+        size_t m_approximateBytes = 0;
 
         const QString localUid() const
         {
@@ -193,6 +206,7 @@ private:
 
         Resource m_value;
         qint64 m_lastAccessTimestamp = 0;
+        size_t m_approximateBytes = 0;
 
         const QString localUid() const
         {
@@ -244,6 +258,7 @@ private:
 
         Notebook m_value;
         qint64 m_lastAccessTimestamp = 0;
+        size_t m_approximateBytes = 0;
 
         const QString localUid() const
         {
@@ -310,6 +325,7 @@ private:
 
         Tag m_value;
         qint64 m_lastAccessTimestamp = 0;
+        size_t m_approximateBytes = 0;
 
         const QString localUid() const
         {
@@ -377,6 +393,7 @@ private:
 
         LinkedNotebook m_value;
         qint64 m_lastAccessTimestamp = 0;
+        size_t m_approximateBytes = 0;
 
         const QString guid() const;
 
@@ -419,6 +436,7 @@ private:
 
         SavedSearch m_value;
         qint64 m_lastAccessTimestamp = 0;
+        size_t m_approximateBytes = 0;
 
         const QString localUid() const
         {
@@ -474,6 +492,15 @@ private:
                     SavedSearchHolder, const QString,
                     &SavedSearchHolder::nameUpper>>>>;
 
+    struct CacheStats
+    {
+        // Sum of approximate memory footprints of cached objects
+        size_t m_bytes = 0;
+
+        // Number of objects removed from the cache by the expiry checker
+        size_t m_evictions = 0;
+    };
+
 private:
     Q_DISABLE_COPY(LocalStorageCacheManagerPrivate)
 
@@ -486,6 +513,13 @@ private:
     TagsCache m_tagsCache;
     LinkedNotebooksCache m_linkedNotebooksCache;
     SavedSearchesCache m_savedSearchesCache;
+
+    CacheStats m_notesCacheStats;
+    CacheStats m_resourcesCacheStats;
+    CacheStats m_notebooksCacheStats;
+    CacheStats m_tagsCacheStats;
+    CacheStats m_linkedNotebooksCacheStats;
+    CacheStats m_savedSearchesCacheStats;
 };
 
 } // namespace quentier
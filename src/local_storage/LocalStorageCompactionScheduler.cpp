@@ -0,0 +1,131 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStorageCompactionScheduler.h"
+#include "LocalStorageRequestScheduler.h"
+
+#include <quentier/local_storage/LocalStorageManager.h>
+#include <quentier/logging/QuentierLogger.h>
+#include <quentier/types/ErrorString.h>
+
+#include <QTimerEvent>
+
+// How often the scheduler checks whether the local storage is idle
+#define COMPACTION_CHECK_INTERVAL_MSEC (250)
+
+// How long there should be no requests for the local storage to be
+// considered idle
+#define COMPACTION_IDLE_THRESHOLD_MSEC (2000)
+
+// Time budget of a single compaction slice; requests arriving during the slice
+// wait for no longer than this
+#define COMPACTION_SLICE_DURATION_MSEC (50)
+
+namespace quentier {
+
+LocalStorageCompactionScheduler::LocalStorageCompactionScheduler(
+    LocalStorageManager & localStorageManager,
+    const LocalStorageRequestScheduler & requestScheduler, QObject * parent) :
+    QObject(parent),
+    m_localStorageManager(localStorageManager),
+    m_requestScheduler(requestScheduler)
+{}
+
+LocalStorageCompactionScheduler::~LocalStorageCompactionScheduler() {}
+
+void LocalStorageCompactionScheduler::start()
+{
+    QNDEBUG("local_storage", "LocalStorageCompactionScheduler::start");
+
+    m_noFreePagesTimer.invalidate();
+
+    if (m_timerId == 0) {
+        m_timerId = startTimer(COMPACTION_CHECK_INTERVAL_MSEC);
+    }
+}
+
+void LocalStorageCompactionScheduler::stop()
+{
+    QNDEBUG("local_storage", "LocalStorageCompactionScheduler::stop");
+
+    if (m_timerId != 0) {
+        killTimer(m_timerId);
+        m_timerId = 0;
+    }
+}
+
+bool LocalStorageCompactionScheduler::isActive() const
+{
+    return m_timerId != 0;
+}
+
+bool LocalStorageCompactionScheduler::isIdle() const
+{
+    if (m_requestScheduler.hasDeferredRequests()) {
+        return false;
+    }
+
+    return m_requestScheduler.msecsSinceLastRequest() >=
+        COMPACTION_IDLE_THRESHOLD_MSEC;
+}
+
+void LocalStorageCompactionScheduler::timerEvent(QTimerEvent * pEvent)
+{
+    if (!pEvent || (pEvent->timerId() != m_timerId)) {
+        QObject::timerEvent(pEvent);
+        return;
+    }
+
+    if (m_noFreePagesTimer.isValid()) {
+        if (m_requestScheduler.msecsSinceLastRequest() >=
+            m_noFreePagesTimer.elapsed())
+        {
+            return;
+        }
+
+        // Requests which came since then might have produced new free pages
+        m_noFreePagesTimer.invalidate();
+    }
+
+    if (!isIdle()) {
+        return;
+    }
+
+    ErrorString errorDescription;
+    qint64 remainingFreePageCount = m_localStorageManager.reclaimFreePages(
+        COMPACTION_SLICE_DURATION_MSEC, errorDescription);
+
+    if (remainingFreePageCount < 0) {
+        QNWARNING(
+            "local_storage",
+            "Failed to reclaim free pages of the local storage database, "
+                << "stopping the incremental compaction: "
+                << errorDescription);
+        stop();
+        return;
+    }
+
+    if (remainingFreePageCount == 0) {
+        QNDEBUG(
+            "local_storage",
+            "No free pages left to reclaim, waiting for new requests");
+        m_noFreePagesTimer.start();
+    }
+}
+
+} // namespace quentier
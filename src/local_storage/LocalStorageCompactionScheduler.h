@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_COMPACTION_SCHEDULER_H
+#define LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_COMPACTION_SCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+
+namespace quentier {
+
+QT_FORWARD_DECLARE_CLASS(LocalStorageManager)
+QT_FORWARD_DECLARE_CLASS(LocalStorageRequestScheduler)
+
+/**
+ * @brief The LocalStorageCompactionScheduler class reclaims free pages of
+ * the local storage database in small time-bounded slices while the local
+ * storage is idle: the request scheduler living in the same thread has no
+ * deferred requests and has not got or run any request for a while. Requests
+ * coming during the slice wait for no longer than the slice itself.
+ */
+class Q_DECL_HIDDEN LocalStorageCompactionScheduler final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalStorageCompactionScheduler(
+        LocalStorageManager & localStorageManager,
+        const LocalStorageRequestScheduler & requestScheduler,
+        QObject * parent = nullptr);
+
+    virtual ~LocalStorageCompactionScheduler() override;
+
+    void start();
+    void stop();
+
+    bool isActive() const;
+
+protected:
+    virtual void timerEvent(QTimerEvent * pEvent) override;
+
+private:
+    Q_DISABLE_COPY(LocalStorageCompactionScheduler)
+
+    bool isIdle() const;
+
+private:
+    LocalStorageManager & m_localStorageManager;
+    const LocalStorageRequestScheduler & m_requestScheduler;
+
+    int m_timerId = 0;
+
+    // Valid while there were no free pages left to reclaim after the last
+    // slice; only requests coming after that might produce new ones
+    QElapsedTimer m_noFreePagesTimer;
+};
+
+} // namespace quentier
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_COMPACTION_SCHEDULER_H
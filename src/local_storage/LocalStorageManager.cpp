@@ -27,12 +27,24 @@ namespace quentier {
 
 LocalStorageManager::LocalStorageManager(
     const Account & account, const StartupOptions options, QObject * parent) :
+    LocalStorageManager(
+        account, options, PerformanceProfile::durable(), parent)
+{}
+
+LocalStorageManager::LocalStorageManager(
+    const Account & account, const StartupOptions options,
+    const PerformanceProfile & performanceProfile, QObject * parent) :
     QObject(parent),
-    d_ptr(new LocalStorageManagerPrivate(account, options, this))
+    d_ptr(new LocalStorageManagerPrivate(
+        account, options, performanceProfile, this))
 {
     QObject::connect(
         d_ptr, &LocalStorageManagerPrivate::upgradeProgress, this,
         &LocalStorageManager::upgradeProgress);
+
+    QObject::connect(
+        d_ptr, &LocalStorageManagerPrivate::snapshotProgress, this,
+        &LocalStorageManager::snapshotProgress);
 }
 
 LocalStorageManager::~LocalStorageManager()
@@ -192,6 +204,18 @@ QList<Notebook> LocalStorageManager::listNotebooks(
         linkedNotebookGuid);
 }
 
+QList<Notebook> LocalStorageManager::listNotebooksPage(
+    const ListObjectsOptions flag, ErrorString & errorDescription,
+    const size_t pageSize, QString & continuationToken,
+    const ListNotebooksOrder order, const OrderDirection orderDirection,
+    const QString & linkedNotebookGuid) const
+{
+    Q_D(const LocalStorageManager);
+    return d->listNotebooksPage(
+        flag, errorDescription, pageSize, continuationToken, order,
+        orderDirection, linkedNotebookGuid);
+}
+
 QList<SharedNotebook> LocalStorageManager::listAllSharedNotebooks(
     ErrorString & errorDescription) const
 {
@@ -313,6 +337,19 @@ int LocalStorageManager::noteCountPerNotebooksAndTags(
         notebookLocalUids, tagLocalUids, errorDescription, options);
 }
 
+bool LocalStorageManager::noteCountersAreConsistent(
+    ErrorString & errorDescription) const
+{
+    Q_D(const LocalStorageManager);
+    return d->noteCountersAreConsistent(errorDescription);
+}
+
+bool LocalStorageManager::rebuildNoteCounters(ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManager);
+    return d->rebuildNoteCounters(errorDescription);
+}
+
 bool LocalStorageManager::addNote(Note & note, ErrorString & errorDescription)
 {
     Q_D(LocalStorageManager);
@@ -327,6 +364,23 @@ bool LocalStorageManager::updateNote(
     return d->updateNote(note, options, errorDescription);
 }
 
+bool LocalStorageManager::addNotes(
+    QList<Note> & notes, QList<ErrorString> & noteErrorDescriptions,
+    ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManager);
+    return d->addNotes(notes, noteErrorDescriptions, errorDescription);
+}
+
+bool LocalStorageManager::updateNotes(
+    QList<Note> & notes, const UpdateNoteOptions options,
+    QList<ErrorString> & noteErrorDescriptions, ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManager);
+    return d->updateNotes(
+        notes, options, noteErrorDescriptions, errorDescription);
+}
+
 bool LocalStorageManager::findNote(
     Note & note, const GetNoteOptions options,
     ErrorString & errorDescription) const
@@ -399,6 +453,31 @@ QList<Note> LocalStorageManager::listNotes(
         linkedNotebookGuid);
 }
 
+QList<Note> LocalStorageManager::listNotesPage(
+    const ListObjectsOptions flag, const GetNoteOptions options,
+    ErrorString & errorDescription, const size_t pageSize,
+    QString & continuationToken, const ListNotesOrder order,
+    const OrderDirection orderDirection,
+    const QString & linkedNotebookGuid) const
+{
+    Q_D(const LocalStorageManager);
+    return d->listNotesPage(
+        flag, options, errorDescription, pageSize, continuationToken, order,
+        orderDirection, linkedNotebookGuid);
+}
+
+QList<LocalStorageManager::NoteSummary> LocalStorageManager::listNoteSummaries(
+    const ListObjectsOptions flag, const NoteSummaryFields fields,
+    ErrorString & errorDescription, const size_t limit, const size_t offset,
+    const ListNotesOrder order, const OrderDirection orderDirection,
+    const QString & linkedNotebookGuid, const int previewLength) const
+{
+    Q_D(const LocalStorageManager);
+    return d->listNoteSummaries(
+        flag, fields, errorDescription, limit, offset, order, orderDirection,
+        linkedNotebookGuid, previewLength);
+}
+
 QStringList LocalStorageManager::findNoteLocalUidsWithSearchQuery(
     const NoteSearchQuery & noteSearchQuery,
     ErrorString & errorDescription) const
@@ -417,6 +496,26 @@ NoteList LocalStorageManager::findNotesWithSearchQuery(
         noteSearchQuery, options, errorDescription);
 }
 
+QList<LocalStorageManager::NoteSearchHit>
+LocalStorageManager::findNoteSearchHits(
+    const NoteSearchQuery & noteSearchQuery, ErrorString & errorDescription,
+    const size_t limit) const
+{
+    Q_D(const LocalStorageManager);
+    return d->findNoteSearchHits(noteSearchQuery, errorDescription, limit);
+}
+
+QStringList LocalStorageManager::findNoteLocalUidsWithinBoundingBox(
+    const double minLatitude, const double maxLatitude,
+    const double minLongitude, const double maxLongitude,
+    ErrorString & errorDescription, const NoteCountOptions options) const
+{
+    Q_D(const LocalStorageManager);
+    return d->findNoteLocalUidsWithinBoundingBox(
+        minLatitude, maxLatitude, minLongitude, maxLongitude, options,
+        errorDescription);
+}
+
 bool LocalStorageManager::expungeNote(
     Note & note, ErrorString & errorDescription)
 {
@@ -436,6 +535,14 @@ bool LocalStorageManager::addTag(Tag & tag, ErrorString & errorDescription)
     return d->addTag(tag, errorDescription);
 }
 
+bool LocalStorageManager::addTags(
+    QList<Tag> & tags, QList<ErrorString> & tagErrorDescriptions,
+    ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManager);
+    return d->addTags(tags, tagErrorDescriptions, errorDescription);
+}
+
 bool LocalStorageManager::updateTag(Tag & tag, ErrorString & errorDescription)
 {
     Q_D(LocalStorageManager);
@@ -482,6 +589,18 @@ QList<Tag> LocalStorageManager::listTags(
         linkedNotebookGuid);
 }
 
+QList<Tag> LocalStorageManager::listTagsPage(
+    const ListObjectsOptions flag, ErrorString & errorDescription,
+    const size_t pageSize, QString & continuationToken,
+    const ListTagsOrder & order, const OrderDirection orderDirection,
+    const QString & linkedNotebookGuid) const
+{
+    Q_D(const LocalStorageManager);
+    return d->listTagsPage(
+        flag, errorDescription, pageSize, continuationToken, order,
+        orderDirection, linkedNotebookGuid);
+}
+
 QList<std::pair<Tag, QStringList>>
 LocalStorageManager::listTagsWithNoteLocalUids(
     const ListObjectsOptions flag, ErrorString & errorDescription,
@@ -530,6 +649,22 @@ bool LocalStorageManager::updateEnResource(
     return d->updateEnResource(resource, errorDescription);
 }
 
+bool LocalStorageManager::addEnResource(
+    Resource & resource, QIODevice & dataBodySource,
+    ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManager);
+    return d->addEnResource(resource, dataBodySource, errorDescription);
+}
+
+bool LocalStorageManager::updateEnResource(
+    Resource & resource, QIODevice & dataBodySource,
+    ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManager);
+    return d->updateEnResource(resource, dataBodySource, errorDescription);
+}
+
 bool LocalStorageManager::findEnResource(
     Resource & resource, const GetResourceOptions options,
     ErrorString & errorDescription) const
@@ -606,6 +741,323 @@ qint32 LocalStorageManager::accountHighUsn(
     return d->accountHighUsn(linkedNotebookGuid, errorDescription);
 }
 
+QList<LocalStorageManager::QueryStatistics>
+LocalStorageManager::queryStatistics() const
+{
+    Q_D(const LocalStorageManager);
+    return d->queryStatistics();
+}
+
+void LocalStorageManager::resetQueryStatistics()
+{
+    Q_D(LocalStorageManager);
+    d->resetQueryStatistics();
+}
+
+void LocalStorageManager::logQueryStatistics() const
+{
+    Q_D(const LocalStorageManager);
+    d->logQueryStatistics();
+}
+
+void LocalStorageManager::setSlowQueryThreshold(const qint64 thresholdUsec)
+{
+    Q_D(LocalStorageManager);
+    d->setSlowQueryThreshold(thresholdUsec);
+}
+
+qint64 LocalStorageManager::slowQueryThreshold() const
+{
+    Q_D(const LocalStorageManager);
+    return d->slowQueryThreshold();
+}
+
+void LocalStorageManager::setAccountHighUsnVerificationEnabled(
+    const bool enabled)
+{
+    Q_D(LocalStorageManager);
+    d->setAccountHighUsnVerificationEnabled(enabled);
+}
+
+bool LocalStorageManager::accountHighUsnVerificationEnabled() const
+{
+    Q_D(const LocalStorageManager);
+    return d->accountHighUsnVerificationEnabled();
+}
+
+void LocalStorageManager::setGuidIndexEnabled(const bool enabled)
+{
+    Q_D(LocalStorageManager);
+    d->setGuidIndexEnabled(enabled);
+}
+
+bool LocalStorageManager::guidIndexEnabled() const
+{
+    Q_D(const LocalStorageManager);
+    return d->guidIndexEnabled();
+}
+
+LocalStorageManager::GuidIndexStatistics
+LocalStorageManager::guidIndexStatistics() const
+{
+    Q_D(const LocalStorageManager);
+    return d->guidIndexStatistics();
+}
+
+bool LocalStorageManager::freePageStatistics(
+    FreePageStatistics & statistics, ErrorString & errorDescription) const
+{
+    Q_D(const LocalStorageManager);
+    return d->freePageStatistics(statistics, errorDescription);
+}
+
+qint64 LocalStorageManager::reclaimFreePages(
+    const qint64 timeBudgetMsec, ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManager);
+    return d->reclaimFreePages(timeBudgetMsec, errorDescription);
+}
+
+bool LocalStorageManager::createSnapshot(
+    const QString & snapshotDirPath, ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManager);
+    return d->createSnapshot(snapshotDirPath, errorDescription);
+}
+
+LocalStorageManager::PerformanceProfile
+LocalStorageManager::performanceProfile() const
+{
+    Q_D(const LocalStorageManager);
+    return d->performanceProfile();
+}
+
+bool LocalStorageManager::setPerformanceProfile(
+    const PerformanceProfile & performanceProfile,
+    ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManager);
+    return d->setPerformanceProfile(performanceProfile, errorDescription);
+}
+
+LocalStorageManager::PerformanceProfile
+LocalStorageManager::PerformanceProfile::durable()
+{
+    return PerformanceProfile();
+}
+
+LocalStorageManager::PerformanceProfile
+LocalStorageManager::PerformanceProfile::balanced()
+{
+    PerformanceProfile profile;
+
+    // With write-ahead logging the database stays consistent on power loss
+    // with normal synchronization
+    profile.m_synchronous = Synchronous::Normal;
+    profile.m_cacheSize = -16000;
+    profile.m_mmapSize = 64 * 1024 * 1024;
+    profile.m_tempStore = TempStore::Memory;
+    return profile;
+}
+
+LocalStorageManager::PerformanceProfile
+LocalStorageManager::PerformanceProfile::bulkImport()
+{
+    PerformanceProfile profile;
+    profile.m_synchronous = Synchronous::Off;
+    profile.m_cacheSize = -64000;
+    profile.m_mmapSize = 256 * 1024 * 1024;
+    profile.m_tempStore = TempStore::Memory;
+
+    // Less frequent checkpoints at the cost of larger write-ahead log
+    profile.m_walAutocheckpoint = 10000;
+    return profile;
+}
+
+bool LocalStorageManager::PerformanceProfile::operator==(
+    const PerformanceProfile & other) const
+{
+    return (m_synchronous == other.m_synchronous) &&
+        (m_cacheSize == other.m_cacheSize) &&
+        (m_mmapSize == other.m_mmapSize) &&
+        (m_tempStore == other.m_tempStore) &&
+        (m_walAutocheckpoint == other.m_walAutocheckpoint) &&
+        (m_busyTimeoutMsec == other.m_busyTimeoutMsec);
+}
+
+bool LocalStorageManager::PerformanceProfile::operator!=(
+    const PerformanceProfile & other) const
+{
+    return !(*this == other);
+}
+
+QTextStream & LocalStorageManager::PerformanceProfile::print(
+    QTextStream & strm) const
+{
+    strm << "PerformanceProfile: {\n"
+         << "  synchronous: ";
+
+    switch (m_synchronous) {
+    case Synchronous::Off:
+        strm << "OFF";
+        break;
+    case Synchronous::Normal:
+        strm << "NORMAL";
+        break;
+    case Synchronous::Full:
+        strm << "FULL";
+        break;
+    case Synchronous::Extra:
+        strm << "EXTRA";
+        break;
+    default:
+        strm << "Unknown (" << static_cast<qint64>(m_synchronous) << ")";
+        break;
+    }
+
+    strm << ";\n"
+         << "  cache size: " << m_cacheSize << ";\n"
+         << "  mmap size: " << m_mmapSize << ";\n"
+         << "  temp store: ";
+
+    switch (m_tempStore) {
+    case TempStore::Default:
+        strm << "DEFAULT";
+        break;
+    case TempStore::File:
+        strm << "FILE";
+        break;
+    case TempStore::Memory:
+        strm << "MEMORY";
+        break;
+    default:
+        strm << "Unknown (" << static_cast<qint64>(m_tempStore) << ")";
+        break;
+    }
+
+    strm << ";\n"
+         << "  wal autocheckpoint: " << m_walAutocheckpoint << ";\n"
+         << "  busy timeout (msec): " << m_busyTimeoutMsec << "\n};\n";
+    return strm;
+}
+
+QTextStream & LocalStorageManager::QueryStatistics::print(
+    QTextStream & strm) const
+{
+    strm << "QueryStatistics: {\n"
+         << "  query: " << m_query << ";\n"
+         << "  execution count: " << m_executionCount << ";\n"
+         << "  failure count: " << m_failureCount << ";\n"
+         << "  row count: " << m_rowCount << ";\n"
+         << "  total duration (usec): " << m_totalDurationUsec << ";\n"
+         << "  max duration (usec): " << m_maxDurationUsec << ";\n"
+         << "  median duration (usec): " << m_medianDurationUsec << ";\n"
+         << "  p90 duration (usec): " << m_p90DurationUsec << ";\n"
+         << "  p99 duration (usec): " << m_p99DurationUsec;
+
+    if (!m_queryPlan.isEmpty()) {
+        strm << ";\n  query plan: " << m_queryPlan;
+    }
+
+    strm << "\n};\n";
+    return strm;
+}
+
+double LocalStorageManager::FreePageStatistics::fragmentation() const
+{
+    if (m_pageCount <= 0) {
+        return 0.0;
+    }
+
+    return static_cast<double>(m_freePageCount) /
+        static_cast<double>(m_pageCount);
+}
+
+QTextStream & LocalStorageManager::FreePageStatistics::print(
+    QTextStream & strm) const
+{
+    strm << "FreePageStatistics: {\n"
+         << "  page size: " << m_pageSize << ";\n"
+         << "  page count: " << m_pageCount << ";\n"
+         << "  free page count: " << m_freePageCount << ";\n"
+         << "  fragmentation: " << fragmentation() << ";\n"
+         << "  incremental vacuum enabled: "
+         << (m_incrementalVacuumEnabled ? "true" : "false") << "\n};\n";
+    return strm;
+}
+
+QTextStream & LocalStorageManager::GuidIndexStatistics::print(
+    QTextStream & strm) const
+{
+    strm << "GuidIndexStatistics: {\n"
+         << "  enabled: " << (m_enabled ? "true" : "false") << ";\n"
+         << "  entry count: " << m_entryCount << ";\n"
+         << "  memory usage (bytes): " << m_memoryUsage << ";\n"
+         << "  hit count: " << m_hitCount << ";\n"
+         << "  miss count: " << m_missCount << "\n};\n";
+    return strm;
+}
+
+QTextStream & LocalStorageManager::NoteSearchHit::print(
+    QTextStream & strm) const
+{
+    strm << "NoteSearchHit: {\n"
+         << "  note local uid: " << m_noteLocalUid << ";\n"
+         << "  score: " << m_score << ";\n"
+         << "  snippet: " << m_snippet << ";\n"
+         << "  match offsets: ";
+
+    for (const auto & offset: qAsConst(m_matchOffsets)) {
+        strm << "[" << offset.first << ", " << offset.second << "] ";
+    }
+
+    strm << "\n};\n";
+    return strm;
+}
+
+QTextStream & LocalStorageManager::NoteSummary::print(QTextStream & strm) const
+{
+    strm << "NoteSummary: {\n"
+         << "  fields: " << static_cast<int>(m_fields) << ";\n"
+         << "  local uid: " << m_localUid << ";\n"
+         << "  guid: " << m_guid << ";\n";
+
+    if (m_fields & NoteSummaryField::Title) {
+        strm << "  title: " << m_title << ";\n";
+    }
+
+    if (m_fields & NoteSummaryField::Notebook) {
+        strm << "  notebook local uid: " << m_notebookLocalUid << ";\n"
+             << "  notebook guid: " << m_notebookGuid << ";\n";
+    }
+
+    if (m_fields & NoteSummaryField::Timestamps) {
+        strm << "  creation timestamp: " << m_creationTimestamp << ";\n"
+             << "  modification timestamp: " << m_modificationTimestamp
+             << ";\n"
+             << "  deletion timestamp: " << m_deletionTimestamp << ";\n";
+    }
+
+    if (m_fields & NoteSummaryField::TagLocalUids) {
+        strm << "  tag local uids: "
+             << m_tagLocalUids.join(QStringLiteral(", ")) << ";\n";
+    }
+
+    if (m_fields & NoteSummaryField::Preview) {
+        strm << "  preview: " << m_preview << ";\n";
+    }
+
+    if (m_fields & NoteSummaryField::Flags) {
+        strm << "  is dirty: " << (m_isDirty ? "true" : "false") << ";\n"
+             << "  is local: " << (m_isLocal ? "true" : "false") << ";\n"
+             << "  is favorited: " << (m_isFavorited ? "true" : "false")
+             << ";\n";
+    }
+
+    strm << "};\n";
+    return strm;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace {
@@ -622,6 +1074,9 @@ T & printStartupOption(T & t, const LocalStorageManager::StartupOption option)
     case StartupOption::OverrideLock:
         t << "Override lock";
         break;
+    case StartupOption::ReadOnly:
+        t << "Read only";
+        break;
     default:
         t << "Unknown (" << static_cast<qint64>(option) << ")";
         break;
@@ -644,6 +1099,10 @@ T & printStartupOptions(
         t << "Override lock; ";
     }
 
+    if (options & StartupOption::ReadOnly) {
+        t << "Read only; ";
+    }
+
     return t;
 }
 
@@ -1016,6 +1475,12 @@ T & printGetNoteOption(T & t, const LocalStorageManager::GetNoteOption option)
     case GetNoteOption::WithResourceBinaryData:
         t << "With resource binary data";
         break;
+    case GetNoteOption::MapResourceBinaryData:
+        t << "Map resource binary data";
+        break;
+    case GetNoteOption::LazyResourceBinaryData:
+        t << "Lazy resource binary data";
+        break;
     default:
         t << "Unknown (" << static_cast<qint64>(option) << ")";
         break;
@@ -1038,6 +1503,14 @@ T & printGetNoteOptions(
         t << "With resource binary data; ";
     }
 
+    if (options & GetNoteOption::MapResourceBinaryData) {
+        t << "Map resource binary data; ";
+    }
+
+    if (options & GetNoteOption::LazyResourceBinaryData) {
+        t << "Lazy resource binary data; ";
+    }
+
     return t;
 }
 
@@ -1146,6 +1619,12 @@ T & printGetResourceOption(
     case GetResourceOption::WithBinaryData:
         t << "With binary metadata";
         break;
+    case GetResourceOption::MapBinaryData:
+        t << "Map binary data";
+        break;
+    case GetResourceOption::LazyBinaryData:
+        t << "Lazy binary data";
+        break;
     default:
         t << "Unknown (" << static_cast<qint64>(option) << ")";
         break;
@@ -1164,6 +1643,14 @@ T & printGetResourceOptions(
         t << "With binary data; ";
     }
 
+    if (options & GetResourceOption::MapBinaryData) {
+        t << "Map binary data; ";
+    }
+
+    if (options & GetResourceOption::LazyBinaryData) {
+        t << "Lazy binary data; ";
+    }
+
     return t;
 }
 
@@ -16,6 +16,12 @@
  * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "LocalStorageCompactionScheduler.h"
+#include "LocalStorageManager_p.h"
+#include "LocalStorageReadOnlyConnectionPool.h"
+#include "LocalStorageRequestScheduler.h"
+#include "LocalStorageSnapshotMaker.h"
+
 #include <quentier/local_storage/LocalStorageManagerAsync.h>
 #include <quentier/local_storage/NoteSearchQuery.h>
 #include <quentier/logging/QuentierLogger.h>
@@ -23,7 +29,13 @@
 #include <quentier/utility/SuppressWarnings.h>
 #include <quentier/utility/SysInfo.h>
 
+#include <QAtomicInteger>
+#include <QHash>
 #include <QMetaMethod>
+#include <QThread>
+
+#include <functional>
+#include <memory>
 
 namespace quentier {
 
@@ -32,6 +44,8 @@ class LocalStorageManagerAsyncPrivate
 public:
     ~LocalStorageManagerAsyncPrivate()
     {
+        delete m_pCompactionScheduler;
+        delete m_pReadOnlyConnectionPool;
         delete m_pLocalStorageCacheManager;
         delete m_pLocalStorageManager;
     }
@@ -47,11 +61,22 @@ public:
         m_useCache = useCache;
     }
 
+    /**
+     * Tells whether the results of the read request being completed can be
+     * put into the cache: the results of reads which ran against the pool
+     * while some write was run by the primary connection might be older than
+     * what the cache got from that write
+     */
+    bool shouldCacheReadResults() const
+    {
+        return m_useCache && !m_completingStaleRead;
+    }
+
     void cacheNotes(
         const QList<Note> & notes,
         const LocalStorageManager::GetNoteOptions options)
     {
-        if (!m_useCache) {
+        if (!shouldCacheReadResults()) {
             return;
         }
 
@@ -74,8 +99,268 @@ public:
         }
     }
 
+    // Runs the completions of the reads still running against the pool so
+    // that their results are not lost
+    void finishPendingReadRequests()
+    {
+        if (m_pReadOnlyConnectionPool) {
+            m_pReadOnlyConnectionPool->finishPendingReadRequests();
+        }
+    }
+
+    void resetReadOnlyConnectionPool()
+    {
+        finishPendingReadRequests();
+        delete m_pReadOnlyConnectionPool;
+        m_pReadOnlyConnectionPool = nullptr;
+
+        if (m_readOnlyConnectionPoolSize <= 0) {
+            return;
+        }
+
+        m_pReadOnlyConnectionPool = new LocalStorageReadOnlyConnectionPool(
+            m_account, m_readOnlyConnectionPoolSize, m_performanceProfile,
+            m_pLocalStorageManager->d_func()->queryStatisticsCollector());
+
+        if (m_pReadOnlyConnectionPool->size() == 0) {
+            QNWARNING(
+                "local_storage",
+                "Failed to open any read-only connection to the local "
+                    << "storage, all requests would be served by the primary "
+                    << "connection");
+
+            delete m_pReadOnlyConnectionPool;
+            m_pReadOnlyConnectionPool = nullptr;
+        }
+    }
+
+    /**
+     * Runs readFunc against one of read-only connections from the pool if
+     * there is one or against the primary LocalStorageManager otherwise;
+     * completionFunc is always run within the thread of
+     * LocalStorageManagerAsync so it can safely work with the cache and emit
+     * signals. If coalescingKey is not empty and a read with the same key is
+     * already running against the pool or was run within the same group of
+     * deferred reads, readFunc is not run at all and completionFunc gets
+     * the result of that read
+     */
+    template <class T>
+    void runReadRequest(
+        const std::function<T(LocalStorageManager &, ErrorString &)> &
+            readFunc,
+        const std::function<void(const T &, const ErrorString &)> &
+            completionFunc,
+        const ErrorString & exceptionErrorDescription,
+        const QString & coalescingKey = QString())
+    {
+        const bool coalesce =
+            (m_pReadOnlyConnectionPool || m_readGroupOpen) &&
+            !coalescingKey.isEmpty();
+
+        if (coalesce) {
+            auto it = m_inFlightReads.constFind(coalescingKey);
+            if (it != m_inFlightReads.constEnd()) {
+                const auto & pInFlightRead = it.value();
+
+                // Reads with the same key produce results of the same type
+                auto pResult =
+                    std::static_pointer_cast<T>(pInFlightRead->m_pResult);
+
+                auto pErrorDescription = pInFlightRead->m_pErrorDescription;
+
+                pInFlightRead->m_completions << [=] {
+                    completionFunc(*pResult, *pErrorDescription);
+                };
+
+                m_coalescedReadRequestCount.ref();
+                return;
+            }
+        }
+
+        auto pResult = std::make_shared<T>();
+        auto pErrorDescription = std::make_shared<ErrorString>();
+
+        auto read = [=](LocalStorageManager & localStorageManager) {
+            try {
+                *pResult = readFunc(localStorageManager, *pErrorDescription);
+            }
+            catch (const std::exception & e) {
+                *pErrorDescription = exceptionErrorDescription;
+                pErrorDescription->details() = QString::fromUtf8(e.what());
+                SysInfo sysInfo;
+                QNERROR(
+                    "local_storage",
+                    *pErrorDescription << "; backtrace: "
+                                       << sysInfo.stackTrace());
+            }
+        };
+
+        auto complete = [=] { completionFunc(*pResult, *pErrorDescription); };
+
+        // The read might finish after a write posted later, its results must
+        // not replace in the cache the ones put there by that write
+        const quint64 writeGeneration = m_writeGeneration;
+        auto completeRead = [=](const std::function<void()> & completion) {
+            m_completingStaleRead = (writeGeneration != m_writeGeneration);
+            completion();
+            m_completingStaleRead = false;
+        };
+
+        if (coalesce) {
+            auto pInFlightRead = std::make_shared<InFlightRead>();
+            pInFlightRead->m_pResult = pResult;
+            pInFlightRead->m_pErrorDescription = pErrorDescription;
+            pInFlightRead->m_completions << complete;
+            m_inFlightReads[coalescingKey] = pInFlightRead;
+
+            if (!m_pReadOnlyConnectionPool) {
+                // The read is run right away but its completion waits for
+                // the rest of the group to let the reads joining it finish
+                // along with it
+                read(*m_pLocalStorageManager);
+                m_readGroupKeys << coalescingKey;
+                return;
+            }
+
+            m_pReadOnlyConnectionPool->postReadRequest(read, [=] {
+                // The entry might have been replaced after a write
+                auto it = m_inFlightReads.find(coalescingKey);
+                if ((it != m_inFlightReads.end()) &&
+                    (it.value() == pInFlightRead))
+                {
+                    m_inFlightReads.erase(it);
+                }
+
+                for (const auto & completion:
+                     qAsConst(pInFlightRead->m_completions))
+                {
+                    completeRead(completion);
+                }
+            });
+
+            return;
+        }
+
+        if (m_pReadOnlyConnectionPool) {
+            m_pReadOnlyConnectionPool->postReadRequest(
+                read, [=] { completeRead(complete); });
+            return;
+        }
+
+        read(*m_pLocalStorageManager);
+        complete();
+    }
+
+    /**
+     * Runs the write requests within a single transaction; complete and failed
+     * signals emitted by the requests are held back until the transaction is
+     * committed and are dropped if it fails to commit
+     */
+    bool runWriteGroup(const std::function<void()> & runRequests)
+    {
+        auto * pLocalStorageManagerPrivate = m_pLocalStorageManager->d_func();
+
+        ErrorString errorDescription;
+        if (!pLocalStorageManagerPrivate->beginWriteGroup(errorDescription)) {
+            return false;
+        }
+
+        m_writeGroupOpen = true;
+        runRequests();
+        m_writeGroupOpen = false;
+
+        if (!pLocalStorageManagerPrivate->commitWriteGroup(errorDescription)) {
+            m_pendingNotifications.clear();
+
+            // The cache might contain items whose writes were rolled back
+            if (m_useCache) {
+                m_pLocalStorageCacheManager->clear();
+            }
+
+            return false;
+        }
+
+        const auto notifications = std::move(m_pendingNotifications);
+        m_pendingNotifications.clear();
+
+        for (const auto & notify: notifications) {
+            notify();
+        }
+
+        return true;
+    }
+
+    /**
+     * Runs the group of deferred read requests which the request scheduler
+     * found to be the same; reads with the same coalescing key run by
+     * the primary connection within the group are only run once
+     */
+    void runReadGroup(const std::function<void()> & runRequests)
+    {
+        m_readGroupOpen = true;
+        runRequests();
+        m_readGroupOpen = false;
+
+        const auto keys = std::move(m_readGroupKeys);
+        m_readGroupKeys.clear();
+
+        for (const auto & key: keys) {
+            auto pInFlightRead = m_inFlightReads.take(key);
+            if (Q_UNLIKELY(!pInFlightRead)) {
+                continue;
+            }
+
+            for (const auto & completion:
+                 qAsConst(pInFlightRead->m_completions))
+            {
+                completion();
+            }
+        }
+    }
+
+    void emitAfterCommit(std::function<void()> notify)
+    {
+        if (m_writeGroupOpen) {
+            m_pendingNotifications << std::move(notify);
+            return;
+        }
+
+        notify();
+    }
+
     Account m_account;
     bool m_useCache = true;
+    int m_readOnlyConnectionPoolSize = 0;
+    bool m_incrementalCompactionEnabled = false;
+
+    bool m_groupCommitEnabled = false;
+    int m_groupCommitMaxRequestCount = 0;
+    int m_groupCommitMaxDurationMsec = 0;
+
+    bool m_writeGroupOpen = false;
+    QList<std::function<void()>> m_pendingNotifications;
+
+    struct InFlightRead
+    {
+        std::shared_ptr<void> m_pResult;
+        std::shared_ptr<ErrorString> m_pErrorDescription;
+        QList<std::function<void()>> m_completions;
+    };
+
+    // Reads running against the pool keyed by the request kind and arguments;
+    // cleared on each write so that requests coming after the write don't get
+    // the results which might have been read before it
+    QHash<QString, std::shared_ptr<InFlightRead>> m_inFlightReads;
+    QAtomicInteger<qint64> m_coalescedReadRequestCount;
+
+    // Keys of the reads run by the primary connection within the group of
+    // deferred reads, their completions are run once the group is over
+    bool m_readGroupOpen = false;
+    QStringList m_readGroupKeys;
+
+    // Incremented on each write request run by the primary connection
+    quint64 m_writeGeneration = 0;
+    bool m_completingStaleRead = false;
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
     LocalStorageManager::StartupOptions m_startupOptions;
@@ -83,8 +368,16 @@ public:
     LocalStorageManager::StartupOptions m_startupOptions = 0;
 #endif
 
+    LocalStorageManager::PerformanceProfile m_performanceProfile;
+
     LocalStorageManager * m_pLocalStorageManager = nullptr;
     LocalStorageCacheManager * m_pLocalStorageCacheManager = nullptr;
+    LocalStorageReadOnlyConnectionPool * m_pReadOnlyConnectionPool = nullptr;
+    LocalStorageCompactionScheduler * m_pCompactionScheduler = nullptr;
+
+    // Owned by LocalStorageManagerAsync as a child so that it moves to
+    // the same thread
+    LocalStorageRequestScheduler * m_pRequestScheduler = nullptr;
 };
 
 namespace {
@@ -105,8 +398,175 @@ void splitNoteAndResourcesForCaching(Note & note, QList<Resource> & resources)
     note.setResources(noteResources);
 }
 
+QString readRequestKeyPart(const QString & value)
+{
+    // Null and empty strings mean different things for some requests
+    if (value.isNull()) {
+        return QStringLiteral("<null>");
+    }
+
+    return QStringLiteral("\"") + value + QStringLiteral("\"");
+}
+
+template <class T>
+QString readRequestKeyPart(const T & value)
+{
+    return QString::number(static_cast<qint64>(value));
+}
+
+void appendReadRequestKeyParts(QString & key)
+{
+    Q_UNUSED(key)
+}
+
+template <class T, class... Args>
+void appendReadRequestKeyParts(
+    QString & key, const T & value, const Args &... args)
+{
+    key += QStringLiteral("/");
+    key += readRequestKeyPart(value);
+    appendReadRequestKeyParts(key, args...);
+}
+
+/**
+ * Composes the key identifying read requests of the same kind with the same
+ * arguments, used to coalesce such requests running at the same time
+ */
+template <class... Args>
+QString readRequestKey(const char * requestName, const Args &... args)
+{
+    QString key = QString::fromUtf8(requestName);
+    appendReadRequestKeyParts(key, args...);
+    return key;
+}
+
+/**
+ * Appends the keys of the objects modified by the write request: the local
+ * uid and guid of the object itself and of the object it belongs to
+ */
+void appendWriteRequestKeys(
+    QStringList & keys, const QString & localUid, const bool hasGuid,
+    const QString & guid)
+{
+    if (!localUid.isEmpty()) {
+        keys << localUid;
+    }
+
+    if (hasGuid) {
+        keys << guid;
+    }
+}
+
+void appendWriteRequestKeys(QStringList & keys, const User & user)
+{
+    if (user.hasId()) {
+        keys << (QStringLiteral("user/") + QString::number(user.id()));
+    }
+}
+
+void appendWriteRequestKeys(QStringList & keys, const Notebook & notebook)
+{
+    appendWriteRequestKeys(
+        keys, notebook.localUid(), notebook.hasGuid(), notebook.guid());
+}
+
+void appendWriteRequestKeys(
+    QStringList & keys, const LinkedNotebook & linkedNotebook)
+{
+    appendWriteRequestKeys(
+        keys, QString(), linkedNotebook.hasGuid(), linkedNotebook.guid());
+}
+
+void appendWriteRequestKeys(QStringList & keys, const Note & note)
+{
+    appendWriteRequestKeys(keys, note.localUid(), note.hasGuid(), note.guid());
+
+    appendWriteRequestKeys(
+        keys, note.notebookLocalUid(), note.hasNotebookGuid(),
+        note.notebookGuid());
+}
+
+void appendWriteRequestKeys(QStringList & keys, const Tag & tag)
+{
+    appendWriteRequestKeys(keys, tag.localUid(), tag.hasGuid(), tag.guid());
+}
+
+void appendWriteRequestKeys(QStringList & keys, const Resource & resource)
+{
+    appendWriteRequestKeys(
+        keys, resource.localUid(), resource.hasGuid(), resource.guid());
+
+    appendWriteRequestKeys(
+        keys, resource.noteLocalUid(), resource.hasNoteGuid(),
+        resource.noteGuid());
+}
+
+void appendWriteRequestKeys(QStringList & keys, const SavedSearch & search)
+{
+    appendWriteRequestKeys(
+        keys, search.localUid(), search.hasGuid(), search.guid());
+}
+
+template <class T>
+void appendWriteRequestKeys(QStringList & keys, const QList<T> & items)
+{
+    for (const auto & item: items) {
+        appendWriteRequestKeys(keys, item);
+    }
+}
+
+/**
+ * Composes the keys of the objects modified by the write request, used to
+ * let interactive writes get ahead of the deferred writes of other objects
+ */
+template <class T>
+QStringList writeRequestKeys(const T & item)
+{
+    QStringList keys;
+    appendWriteRequestKeys(keys, item);
+    return keys;
+}
+
 } // namespace
 
+// Hands the request over to the request scheduler which either defers it,
+// in which case the slot returns right away and is invoked once again with
+// the same arguments later, or lets it run right away
+#define SCHEDULE_REQUEST(call)                                                 \
+    if (d->m_pRequestScheduler->deferRequest(sender(), [=] { call; })) {       \
+        return;                                                                \
+    }
+
+// Same as SCHEDULE_REQUEST but for read requests which can be coalesced: if
+// the read with the same key is already deferred and no write has come after
+// it, the request joins it and both are run together
+#define SCHEDULE_READ_REQUEST(key, call)                                       \
+    if (d->m_pRequestScheduler->deferRequest(                                  \
+            sender(), [=] { call; }, /* is write = */ false, key))             \
+    {                                                                          \
+        return;                                                                \
+    }
+
+// Same as SCHEDULE_REQUEST but for requests modifying the local storage which
+// can be run as a group within a single transaction; once the write request
+// is run, reads coming after it can't join the ones which started before it
+// and the ones which started before it don't put their results into the cache;
+// keys identify the objects modified by the request, empty list of keys means
+// the request might modify any object
+#define SCHEDULE_WRITE_REQUEST(keys, call)                                     \
+    if (d->m_pRequestScheduler->deferRequest(                                  \
+            sender(), [=] { call; }, /* is write = */ true, QString(), keys))  \
+    {                                                                          \
+        return;                                                                \
+    }                                                                          \
+    d->m_inFlightReads.clear();                                                \
+    ++d->m_writeGeneration
+
+// Emits the signal right away unless the group of write requests is being
+// run, in which case the signal is emitted after the group is committed
+#define EMIT_AFTER_COMMIT(signal)                                              \
+    d->emitAfterCommit([=] { Q_EMIT signal; })
+
 LocalStorageManagerAsync::LocalStorageManagerAsync(
     const Account & account, const LocalStorageManager::StartupOptions options,
     QObject * parent) :
@@ -116,6 +576,7 @@ LocalStorageManagerAsync::LocalStorageManagerAsync(
     Q_D(LocalStorageManagerAsync);
     d->m_account = account;
     d->m_startupOptions = options;
+    d->m_pRequestScheduler = new LocalStorageRequestScheduler(this);
 }
 
 LocalStorageManagerAsync::~LocalStorageManagerAsync()
@@ -129,6 +590,35 @@ void LocalStorageManagerAsync::setUseCache(const bool useCache)
     d->setUseCache(useCache);
 }
 
+void LocalStorageManagerAsync::setReadOnlyConnectionPoolSize(const int size)
+{
+    Q_D(LocalStorageManagerAsync);
+    d->m_readOnlyConnectionPoolSize = size;
+}
+
+void LocalStorageManagerAsync::setIncrementalCompactionEnabled(
+    const bool enabled)
+{
+    Q_D(LocalStorageManagerAsync);
+    d->m_incrementalCompactionEnabled = enabled;
+}
+
+void LocalStorageManagerAsync::setPerformanceProfile(
+    const LocalStorageManager::PerformanceProfile & performanceProfile)
+{
+    Q_D(LocalStorageManagerAsync);
+    d->m_performanceProfile = performanceProfile;
+}
+
+void LocalStorageManagerAsync::setGroupCommitEnabled(
+    const bool enabled, const int maxRequestCount, const int maxDurationMsec)
+{
+    Q_D(LocalStorageManagerAsync);
+    d->m_groupCommitEnabled = enabled;
+    d->m_groupCommitMaxRequestCount = maxRequestCount;
+    d->m_groupCommitMaxDurationMsec = maxDurationMsec;
+}
+
 const LocalStorageCacheManager *
 LocalStorageManagerAsync::localStorageCacheManager() const
 {
@@ -167,16 +657,54 @@ LocalStorageManager * LocalStorageManagerAsync::localStorageManager()
     return d->m_pLocalStorageManager;
 }
 
+void LocalStorageManagerAsync::setRequestSenderPriority(
+    QObject * pSender, const RequestPriority priority)
+{
+    Q_D(LocalStorageManagerAsync);
+    d->m_pRequestScheduler->setSenderPriority(pSender, priority);
+}
+
+QList<LocalStorageManagerAsync::RequestQueueStatistics>
+LocalStorageManagerAsync::requestQueueStatistics() const
+{
+    Q_D(const LocalStorageManagerAsync);
+    return d->m_pRequestScheduler->statistics();
+}
+
+void LocalStorageManagerAsync::resetRequestQueueStatistics()
+{
+    Q_D(LocalStorageManagerAsync);
+    d->m_pRequestScheduler->resetStatistics();
+    d->m_coalescedReadRequestCount.storeRelease(0);
+}
+
+qint64 LocalStorageManagerAsync::coalescedReadRequestCount() const
+{
+    Q_D(const LocalStorageManagerAsync);
+    return d->m_coalescedReadRequestCount.loadAcquire();
+}
+
 void LocalStorageManagerAsync::init()
 {
     Q_D(LocalStorageManagerAsync);
 
+    // Requests deferred before must be served by the local storage manager
+    // which was there when they were sent
+    d->m_pRequestScheduler->runDeferredRequests();
+
+    // The scheduler refers to the local storage manager being replaced
+    delete d->m_pCompactionScheduler;
+    d->m_pCompactionScheduler = nullptr;
+
     if (d->m_pLocalStorageManager) {
         delete d->m_pLocalStorageManager;
     }
 
-    d->m_pLocalStorageManager =
-        new LocalStorageManager(d->m_account, d->m_startupOptions);
+    d->m_pLocalStorageManager = new LocalStorageManager(
+        d->m_account, d->m_startupOptions, d->m_performanceProfile);
+
+    d->resetReadOnlyConnectionPool();
+    d->m_inFlightReads.clear();
 
     if (d->m_pLocalStorageCacheManager) {
         delete d->m_pLocalStorageCacheManager;
@@ -184,36 +712,54 @@ void LocalStorageManagerAsync::init()
 
     d->m_pLocalStorageCacheManager = new LocalStorageCacheManager();
 
+    if (d->m_incrementalCompactionEnabled) {
+        d->m_pCompactionScheduler = new LocalStorageCompactionScheduler(
+            *d->m_pLocalStorageManager, *d->m_pRequestScheduler);
+        d->m_pCompactionScheduler->start();
+    }
+
+    if (d->m_groupCommitEnabled) {
+        d->m_pRequestScheduler->setWriteGroupFunc(
+            [d](const std::function<void()> & runRequests) {
+                return d->runWriteGroup(runRequests);
+            },
+            d->m_groupCommitMaxRequestCount, d->m_groupCommitMaxDurationMsec);
+    }
+    else {
+        d->m_pRequestScheduler->setWriteGroupFunc({}, 0, 0);
+    }
+
+    d->m_pRequestScheduler->setReadGroupFunc(
+        [d](const std::function<void()> & runRequests) {
+            d->runReadGroup(runRequests);
+        });
+
     Q_EMIT initialized();
 }
 
 void LocalStorageManagerAsync::onGetUserCountRequest(QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        int count = d->m_pLocalStorageManager->userCount(errorDescription);
-        if (count < 0) {
-            Q_EMIT getUserCountFailed(errorDescription, requestId);
-        }
-        else {
-            Q_EMIT getUserCountComplete(count, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+    const QString coalescingKey = readRequestKey("userCount");
+    SCHEDULE_READ_REQUEST(coalescingKey, onGetUserCountRequest(requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.userCount(errorDescription);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getUserCountFailed(errorDescription, requestId);
+            }
+            else {
+                Q_EMIT getUserCountComplete(count, requestId);
+            }
+        },
+        ErrorString(
             QT_TR_NOOP("Can't get user count from the local "
-                       "storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getUserCountFailed(error, requestId);
-    }
+                       "storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onSwitchUserRequest(
@@ -222,6 +768,12 @@ void LocalStorageManagerAsync::onSwitchUserRequest(
 {
     Q_D(LocalStorageManagerAsync);
 
+    // Switching the user is never deferred and requests deferred before
+    // it must be served for the account which was there when they were sent;
+    // the same goes for the reads running against the read-only connections
+    d->m_pRequestScheduler->runDeferredRequests();
+    d->finishPendingReadRequests();
+
     try {
         d->m_pLocalStorageManager->switchUser(account, startupOptions);
     }
@@ -244,23 +796,28 @@ void LocalStorageManagerAsync::onSwitchUserRequest(
         d->m_pLocalStorageCacheManager->clear();
     }
 
+    d->m_account = account;
+    d->resetReadOnlyConnectionPool();
+
     Q_EMIT switchUserComplete(account, requestId);
 }
 
 void LocalStorageManagerAsync::onAddUserRequest(User user, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(user), onAddUserRequest(user, requestId));
 
     try {
         ErrorString errorDescription;
 
         bool res = d->m_pLocalStorageManager->addUser(user, errorDescription);
         if (!res) {
-            Q_EMIT addUserFailed(user, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(addUserFailed(user, errorDescription, requestId));
             return;
         }
 
-        Q_EMIT addUserComplete(user, requestId);
+        EMIT_AFTER_COMMIT(addUserComplete(user, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -273,13 +830,15 @@ void LocalStorageManagerAsync::onAddUserRequest(User user, QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT addUserFailed(user, error, requestId);
+        EMIT_AFTER_COMMIT(addUserFailed(user, error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onUpdateUserRequest(User user, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(user), onUpdateUserRequest(user, requestId));
 
     try {
         ErrorString errorDescription;
@@ -288,11 +847,12 @@ void LocalStorageManagerAsync::onUpdateUserRequest(User user, QUuid requestId)
             d->m_pLocalStorageManager->updateUser(user, errorDescription);
 
         if (!res) {
-            Q_EMIT updateUserFailed(user, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                updateUserFailed(user, errorDescription, requestId));
             return;
         }
 
-        Q_EMIT updateUserComplete(user, requestId);
+        EMIT_AFTER_COMMIT(updateUserComplete(user, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -305,13 +865,14 @@ void LocalStorageManagerAsync::onUpdateUserRequest(User user, QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT updateUserFailed(user, error, requestId);
+        EMIT_AFTER_COMMIT(updateUserFailed(user, error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onFindUserRequest(User user, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindUserRequest(user, requestId));
 
     try {
         ErrorString errorDescription;
@@ -342,6 +903,8 @@ void LocalStorageManagerAsync::onFindUserRequest(User user, QUuid requestId)
 void LocalStorageManagerAsync::onDeleteUserRequest(User user, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(user), onDeleteUserRequest(user, requestId));
 
     try {
         ErrorString errorDescription;
@@ -349,11 +912,12 @@ void LocalStorageManagerAsync::onDeleteUserRequest(User user, QUuid requestId)
         bool res =
             d->m_pLocalStorageManager->deleteUser(user, errorDescription);
         if (!res) {
-            Q_EMIT deleteUserFailed(user, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                deleteUserFailed(user, errorDescription, requestId));
             return;
         }
 
-        Q_EMIT deleteUserComplete(user, requestId);
+        EMIT_AFTER_COMMIT(deleteUserComplete(user, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -366,13 +930,15 @@ void LocalStorageManagerAsync::onDeleteUserRequest(User user, QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT deleteUserFailed(user, error, requestId);
+        EMIT_AFTER_COMMIT(deleteUserFailed(user, error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onExpungeUserRequest(User user, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(user), onExpungeUserRequest(user, requestId));
 
     try {
         ErrorString errorDescription;
@@ -381,11 +947,12 @@ void LocalStorageManagerAsync::onExpungeUserRequest(User user, QUuid requestId)
             d->m_pLocalStorageManager->expungeUser(user, errorDescription);
 
         if (!res) {
-            Q_EMIT expungeUserFailed(user, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                expungeUserFailed(user, errorDescription, requestId));
             return;
         }
 
-        Q_EMIT expungeUserComplete(user, requestId);
+        EMIT_AFTER_COMMIT(expungeUserComplete(user, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -398,43 +965,41 @@ void LocalStorageManagerAsync::onExpungeUserRequest(User user, QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT expungeUserFailed(user, error, requestId);
+        EMIT_AFTER_COMMIT(expungeUserFailed(user, error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onGetNotebookCountRequest(QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        int count = d->m_pLocalStorageManager->notebookCount(errorDescription);
-        if (count < 0) {
-            Q_EMIT getNotebookCountFailed(errorDescription, requestId);
-        }
-        else {
-            Q_EMIT getNotebookCountComplete(count, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+    const QString coalescingKey = readRequestKey("notebookCount");
+    SCHEDULE_READ_REQUEST(coalescingKey, onGetNotebookCountRequest(requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.notebookCount(errorDescription);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getNotebookCountFailed(errorDescription, requestId);
+            }
+            else {
+                Q_EMIT getNotebookCountComplete(count, requestId);
+            }
+        },
+        ErrorString(
             QT_TR_NOOP("Can't get notebook count from the local "
-                       "storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getNotebookCountFailed(error, requestId);
-    }
+                       "storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onAddNotebookRequest(
     Notebook notebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(notebook), onAddNotebookRequest(notebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -443,7 +1008,8 @@ void LocalStorageManagerAsync::onAddNotebookRequest(
             d->m_pLocalStorageManager->addNotebook(notebook, errorDescription);
 
         if (!res) {
-            Q_EMIT addNotebookFailed(notebook, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                addNotebookFailed(notebook, errorDescription, requestId));
             return;
         }
 
@@ -451,7 +1017,7 @@ void LocalStorageManagerAsync::onAddNotebookRequest(
             d->m_pLocalStorageCacheManager->cacheNotebook(notebook);
         }
 
-        Q_EMIT addNotebookComplete(notebook, requestId);
+        EMIT_AFTER_COMMIT(addNotebookComplete(notebook, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -464,7 +1030,7 @@ void LocalStorageManagerAsync::onAddNotebookRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT addNotebookFailed(notebook, error, requestId);
+        EMIT_AFTER_COMMIT(addNotebookFailed(notebook, error, requestId));
     }
 }
 
@@ -472,6 +1038,9 @@ void LocalStorageManagerAsync::onUpdateNotebookRequest(
     Notebook notebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(notebook),
+        onUpdateNotebookRequest(notebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -480,7 +1049,8 @@ void LocalStorageManagerAsync::onUpdateNotebookRequest(
             notebook, errorDescription);
 
         if (!res) {
-            Q_EMIT updateNotebookFailed(notebook, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                updateNotebookFailed(notebook, errorDescription, requestId));
             return;
         }
 
@@ -488,7 +1058,7 @@ void LocalStorageManagerAsync::onUpdateNotebookRequest(
             d->m_pLocalStorageCacheManager->cacheNotebook(notebook);
         }
 
-        Q_EMIT updateNotebookComplete(notebook, requestId);
+        EMIT_AFTER_COMMIT(updateNotebookComplete(notebook, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -501,7 +1071,7 @@ void LocalStorageManagerAsync::onUpdateNotebookRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT updateNotebookFailed(notebook, error, requestId);
+        EMIT_AFTER_COMMIT(updateNotebookFailed(notebook, error, requestId));
     }
 }
 
@@ -510,74 +1080,69 @@ void LocalStorageManagerAsync::onFindNotebookRequest(
 {
     Q_D(LocalStorageManagerAsync);
 
-    try {
-        ErrorString errorDescription;
-
-        bool foundNotebookInCache = false;
-        if (d->m_useCache) {
-            bool notebookHasGuid = notebook.hasGuid();
-            if (notebookHasGuid || !notebook.localUid().isEmpty()) {
-                const QString uid =
-                    (notebookHasGuid ? notebook.guid() : notebook.localUid());
+    const QString coalescingKey = readRequestKey(
+        "findNotebook", (notebook.hasGuid() ? notebook.guid() : QString()),
+        notebook.localUid(), (notebook.hasName() ? notebook.name() : QString()),
+        (notebook.hasLinkedNotebookGuid() ? notebook.linkedNotebookGuid()
+                                          : QString()));
 
-                LocalStorageCacheManager::WhichUid wg =
-                    (notebookHasGuid ? LocalStorageCacheManager::Guid
-                                     : LocalStorageCacheManager::LocalUid);
+    SCHEDULE_READ_REQUEST(
+        coalescingKey, onFindNotebookRequest(notebook, requestId));
 
-                const Notebook * pNotebook =
-                    d->m_pLocalStorageCacheManager->findNotebook(uid, wg);
+    if (d->m_useCache) {
+        const Notebook * pNotebook = nullptr;
 
-                if (pNotebook) {
-                    notebook = *pNotebook;
-                    foundNotebookInCache = true;
-                }
-            }
-            else if (notebook.hasName() && !notebook.name().isEmpty()) {
-                const QString notebookName = notebook.name();
+        bool notebookHasGuid = notebook.hasGuid();
+        if (notebookHasGuid || !notebook.localUid().isEmpty()) {
+            const QString uid =
+                (notebookHasGuid ? notebook.guid() : notebook.localUid());
 
-                const Notebook * pNotebook =
-                    d->m_pLocalStorageCacheManager->findNotebookByName(
-                        notebookName);
+            LocalStorageCacheManager::WhichUid wg =
+                (notebookHasGuid ? LocalStorageCacheManager::Guid
+                                 : LocalStorageCacheManager::LocalUid);
 
-                if (pNotebook) {
-                    notebook = *pNotebook;
-                    foundNotebookInCache = true;
-                }
-            }
+            pNotebook = d->m_pLocalStorageCacheManager->findNotebook(uid, wg);
+        }
+        else if (notebook.hasName() && !notebook.name().isEmpty()) {
+            pNotebook = d->m_pLocalStorageCacheManager->findNotebookByName(
+                notebook.name());
         }
 
-        if (!foundNotebookInCache) {
-            bool res = d->m_pLocalStorageManager->findNotebook(
-                notebook, errorDescription);
+        if (pNotebook) {
+            Q_EMIT findNotebookComplete(*pNotebook, requestId);
+            return;
+        }
+    }
 
-            if (!res) {
+    d->runReadRequest<std::pair<bool, Notebook>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            Notebook foundNotebook = notebook;
+            bool res = localStorageManager.findNotebook(
+                foundNotebook, errorDescription);
+            return std::make_pair(res, foundNotebook);
+        },
+        [=](const std::pair<bool, Notebook> & result,
+            const ErrorString & errorDescription) {
+            if (!result.first) {
                 Q_EMIT findNotebookFailed(
                     notebook, errorDescription, requestId);
                 return;
             }
-        }
 
-        Q_EMIT findNotebookComplete(notebook, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT findNotebookComplete(result.second, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't find notebook within the local storage: "
-                       "caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT findNotebookFailed(notebook, error, requestId);
-    }
+                       "caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onFindDefaultNotebookRequest(
     Notebook notebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindDefaultNotebookRequest(notebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -612,6 +1177,7 @@ void LocalStorageManagerAsync::onFindLastUsedNotebookRequest(
     Notebook notebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindLastUsedNotebookRequest(notebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -646,6 +1212,8 @@ void LocalStorageManagerAsync::onFindDefaultOrLastUsedNotebookRequest(
     Notebook notebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindDefaultOrLastUsedNotebookRequest(
+        notebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -682,75 +1250,73 @@ void LocalStorageManagerAsync::onListAllNotebooksRequest(
     QString linkedNotebookGuid, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    const QString coalescingKey = readRequestKey(
+        "listAllNotebooks", limit, offset, order, orderDirection,
+        linkedNotebookGuid);
+    SCHEDULE_READ_REQUEST(
+        coalescingKey,
+        onListAllNotebooksRequest(
+            limit, offset, order, orderDirection, linkedNotebookGuid,
+            requestId));
+
+    d->runReadRequest<QList<Notebook>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listAllNotebooks(
+                errorDescription, limit, offset, order, orderDirection,
+                linkedNotebookGuid);
+        },
+        [=](const QList<Notebook> & notebooks,
+            const ErrorString & errorDescription) {
+            if (notebooks.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listAllNotebooksFailed(
+                    limit, offset, order, orderDirection, linkedNotebookGuid,
+                    errorDescription, requestId);
+                return;
+            }
 
-    try {
-        ErrorString errorDescription;
-        QList<Notebook> notebooks = d->m_pLocalStorageManager->listAllNotebooks(
-            errorDescription, limit, offset, order, orderDirection,
-            linkedNotebookGuid);
-
-        if (notebooks.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listAllNotebooksFailed(
-                limit, offset, order, orderDirection, linkedNotebookGuid,
-                errorDescription, requestId);
-            return;
-        }
-
-        if (d->m_useCache) {
-            for (const auto & notebook: qAsConst(notebooks)) {
-                d->m_pLocalStorageCacheManager->cacheNotebook(notebook);
+            if (d->shouldCacheReadResults()) {
+                for (const auto & notebook: qAsConst(notebooks)) {
+                    d->m_pLocalStorageCacheManager->cacheNotebook(notebook);
+                }
             }
-        }
 
-        Q_EMIT listAllNotebooksComplete(
-            limit, offset, order, orderDirection, linkedNotebookGuid, notebooks,
-            requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT listAllNotebooksComplete(
+                limit, offset, order, orderDirection, linkedNotebookGuid,
+                notebooks, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list all notebooks from the local "
-                       "storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listAllNotebooksFailed(
-            limit, offset, order, orderDirection, linkedNotebookGuid, error,
-            requestId);
-    }
+                       "storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onListAllSharedNotebooksRequest(QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    const QString coalescingKey = readRequestKey("listAllSharedNotebooks");
+    SCHEDULE_READ_REQUEST(
+        coalescingKey, onListAllSharedNotebooksRequest(requestId));
+
+    d->runReadRequest<QList<SharedNotebook>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listAllSharedNotebooks(errorDescription);
+        },
+        [=](const QList<SharedNotebook> & sharedNotebooks,
+            const ErrorString & errorDescription) {
+            if (sharedNotebooks.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listAllSharedNotebooksFailed(
+                    errorDescription, requestId);
+                return;
+            }
 
-    try {
-        ErrorString errorDescription;
-        QList<SharedNotebook> sharedNotebooks =
-            d->m_pLocalStorageManager->listAllSharedNotebooks(errorDescription);
-        if (sharedNotebooks.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listAllSharedNotebooksFailed(errorDescription, requestId);
-            return;
-        }
-
-        Q_EMIT listAllSharedNotebooksComplete(sharedNotebooks, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT listAllSharedNotebooksComplete(sharedNotebooks, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list all shared notebooks from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listAllSharedNotebooksFailed(error, requestId);
-    }
+                       "the local storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onListNotebooksRequest(
@@ -760,87 +1326,122 @@ void LocalStorageManagerAsync::onListNotebooksRequest(
     QString linkedNotebookGuid, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListNotebooksRequest(
+        flag, limit, offset, order, orderDirection, linkedNotebookGuid,
+        requestId));
+
+    d->runReadRequest<QList<Notebook>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listNotebooks(
+                flag, errorDescription, limit, offset, order, orderDirection,
+                linkedNotebookGuid);
+        },
+        [=](const QList<Notebook> & notebooks,
+            const ErrorString & errorDescription) {
+            if (notebooks.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listNotebooksFailed(
+                    flag, limit, offset, order, orderDirection,
+                    linkedNotebookGuid, errorDescription, requestId);
+                return;
+            }
 
-    try {
-        ErrorString errorDescription;
-        QList<Notebook> notebooks = d->m_pLocalStorageManager->listNotebooks(
-            flag, errorDescription, limit, offset, order, orderDirection,
-            linkedNotebookGuid);
-
-        if (notebooks.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listNotebooksFailed(
-                flag, limit, offset, order, orderDirection, linkedNotebookGuid,
-                errorDescription, requestId);
-            return;
-        }
-
-        if (d->m_useCache) {
-            for (const auto & notebook: qAsConst(notebooks)) {
-                d->m_pLocalStorageCacheManager->cacheNotebook(notebook);
+            if (d->shouldCacheReadResults()) {
+                for (const auto & notebook: qAsConst(notebooks)) {
+                    d->m_pLocalStorageCacheManager->cacheNotebook(notebook);
+                }
             }
-        }
 
-        Q_EMIT listNotebooksComplete(
-            flag, limit, offset, order, orderDirection, linkedNotebookGuid,
-            notebooks, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT listNotebooksComplete(
+                flag, limit, offset, order, orderDirection, linkedNotebookGuid,
+                notebooks, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list notebooks from the local storage: "
-                       "caught exception"));
+                       "caught exception")));
+}
 
-        error.details() = QString::fromUtf8(e.what());
+void LocalStorageManagerAsync::onListNotebooksPageRequest(
+    LocalStorageManager::ListObjectsOptions flag, size_t pageSize,
+    QString continuationToken, LocalStorageManager::ListNotebooksOrder order,
+    LocalStorageManager::OrderDirection orderDirection,
+    QString linkedNotebookGuid, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListNotebooksPageRequest(
+        flag, pageSize, continuationToken, order, orderDirection,
+        linkedNotebookGuid, requestId));
+
+    auto nextContinuationToken = std::make_shared<QString>(continuationToken);
+
+    d->runReadRequest<QList<Notebook>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listNotebooksPage(
+                flag, errorDescription, pageSize, *nextContinuationToken,
+                order, orderDirection, linkedNotebookGuid);
+        },
+        [=](const QList<Notebook> & notebooks,
+            const ErrorString & errorDescription) {
+            if (notebooks.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listNotebooksPageFailed(
+                    flag, pageSize, continuationToken, order, orderDirection,
+                    linkedNotebookGuid, errorDescription, requestId);
+                return;
+            }
 
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
+            if (d->shouldCacheReadResults()) {
+                for (const auto & notebook: qAsConst(notebooks)) {
+                    d->m_pLocalStorageCacheManager->cacheNotebook(notebook);
+                }
+            }
 
-        Q_EMIT listNotebooksFailed(
-            flag, limit, offset, order, orderDirection, linkedNotebookGuid,
-            error, requestId);
-    }
+            Q_EMIT listNotebooksPageComplete(
+                flag, pageSize, continuationToken, order, orderDirection,
+                linkedNotebookGuid, notebooks, *nextContinuationToken,
+                requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't list the page of notebooks from the local "
+                       "storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onListSharedNotebooksPerNotebookGuidRequest(
     QString notebookGuid, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListSharedNotebooksPerNotebookGuidRequest(
+        notebookGuid, requestId));
 
-    try {
-        ErrorString errorDescription;
-        QList<SharedNotebook> sharedNotebooks =
-            d->m_pLocalStorageManager->listSharedNotebooksPerNotebookGuid(
+    d->runReadRequest<QList<SharedNotebook>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listSharedNotebooksPerNotebookGuid(
                 notebookGuid, errorDescription);
+        },
+        [=](const QList<SharedNotebook> & sharedNotebooks,
+            const ErrorString & errorDescription) {
+            if (sharedNotebooks.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listSharedNotebooksPerNotebookGuidFailed(
+                    notebookGuid, errorDescription, requestId);
+                return;
+            }
 
-        if (sharedNotebooks.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listSharedNotebooksPerNotebookGuidFailed(
-                notebookGuid, errorDescription, requestId);
-            return;
-        }
-
-        Q_EMIT listSharedNotebooksPerNotebookGuidComplete(
-            notebookGuid, sharedNotebooks, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT listSharedNotebooksPerNotebookGuidComplete(
+                notebookGuid, sharedNotebooks, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list shared notebooks by notebook guid "
-                       "from the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listSharedNotebooksPerNotebookGuidFailed(
-            notebookGuid, error, requestId);
-    }
+                       "from the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onExpungeNotebookRequest(
     Notebook notebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(notebook),
+        onExpungeNotebookRequest(notebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -849,7 +1450,8 @@ void LocalStorageManagerAsync::onExpungeNotebookRequest(
             notebook, errorDescription);
 
         if (!res) {
-            Q_EMIT expungeNotebookFailed(notebook, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                expungeNotebookFailed(notebook, errorDescription, requestId));
             return;
         }
 
@@ -857,7 +1459,7 @@ void LocalStorageManagerAsync::onExpungeNotebookRequest(
             d->m_pLocalStorageCacheManager->expungeNotebook(notebook);
         }
 
-        Q_EMIT expungeNotebookComplete(notebook, requestId);
+        EMIT_AFTER_COMMIT(expungeNotebookComplete(notebook, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -870,44 +1472,44 @@ void LocalStorageManagerAsync::onExpungeNotebookRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT expungeNotebookFailed(notebook, error, requestId);
+        EMIT_AFTER_COMMIT(expungeNotebookFailed(notebook, error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onGetLinkedNotebookCountRequest(QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        int count =
-            d->m_pLocalStorageManager->linkedNotebookCount(errorDescription);
-        if (count < 0) {
-            Q_EMIT getLinkedNotebookCountFailed(errorDescription, requestId);
-        }
-        else {
-            Q_EMIT getLinkedNotebookCountComplete(count, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+    const QString coalescingKey = readRequestKey("linkedNotebookCount");
+    SCHEDULE_READ_REQUEST(
+        coalescingKey, onGetLinkedNotebookCountRequest(requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.linkedNotebookCount(errorDescription);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getLinkedNotebookCountFailed(
+                    errorDescription, requestId);
+            }
+            else {
+                Q_EMIT getLinkedNotebookCountComplete(count, requestId);
+            }
+        },
+        ErrorString(
             QT_TR_NOOP("Can't get linked notebook count from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getLinkedNotebookCountFailed(error, requestId);
-    }
+                       "the local storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onAddLinkedNotebookRequest(
     LinkedNotebook linkedNotebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(linkedNotebook),
+        onAddLinkedNotebookRequest(linkedNotebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -916,8 +1518,8 @@ void LocalStorageManagerAsync::onAddLinkedNotebookRequest(
             linkedNotebook, errorDescription);
 
         if (!res) {
-            Q_EMIT addLinkedNotebookFailed(
-                linkedNotebook, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(addLinkedNotebookFailed(
+                linkedNotebook, errorDescription, requestId));
             return;
         }
 
@@ -925,7 +1527,7 @@ void LocalStorageManagerAsync::onAddLinkedNotebookRequest(
             d->m_pLocalStorageCacheManager->cacheLinkedNotebook(linkedNotebook);
         }
 
-        Q_EMIT addLinkedNotebookComplete(linkedNotebook, requestId);
+        EMIT_AFTER_COMMIT(addLinkedNotebookComplete(linkedNotebook, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -938,7 +1540,8 @@ void LocalStorageManagerAsync::onAddLinkedNotebookRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT addLinkedNotebookFailed(linkedNotebook, error, requestId);
+        EMIT_AFTER_COMMIT(
+            addLinkedNotebookFailed(linkedNotebook, error, requestId));
     }
 }
 
@@ -946,6 +1549,9 @@ void LocalStorageManagerAsync::onUpdateLinkedNotebookRequest(
     LinkedNotebook linkedNotebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(linkedNotebook),
+        onUpdateLinkedNotebookRequest(linkedNotebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -954,8 +1560,8 @@ void LocalStorageManagerAsync::onUpdateLinkedNotebookRequest(
             linkedNotebook, errorDescription);
 
         if (!res) {
-            Q_EMIT updateLinkedNotebookFailed(
-                linkedNotebook, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(updateLinkedNotebookFailed(
+                linkedNotebook, errorDescription, requestId));
             return;
         }
 
@@ -963,7 +1569,8 @@ void LocalStorageManagerAsync::onUpdateLinkedNotebookRequest(
             d->m_pLocalStorageCacheManager->cacheLinkedNotebook(linkedNotebook);
         }
 
-        Q_EMIT updateLinkedNotebookComplete(linkedNotebook, requestId);
+        EMIT_AFTER_COMMIT(
+            updateLinkedNotebookComplete(linkedNotebook, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -976,7 +1583,8 @@ void LocalStorageManagerAsync::onUpdateLinkedNotebookRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT updateLinkedNotebookFailed(linkedNotebook, error, requestId);
+        EMIT_AFTER_COMMIT(
+            updateLinkedNotebookFailed(linkedNotebook, error, requestId));
     }
 }
 
@@ -984,6 +1592,7 @@ void LocalStorageManagerAsync::onFindLinkedNotebookRequest(
     LinkedNotebook linkedNotebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindLinkedNotebookRequest(linkedNotebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -1033,44 +1642,43 @@ void LocalStorageManagerAsync::onListAllLinkedNotebooksRequest(
     LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        QList<LinkedNotebook> linkedNotebooks =
-            d->m_pLocalStorageManager->listAllLinkedNotebooks(
+    const QString coalescingKey = readRequestKey(
+        "listAllLinkedNotebooks", limit, offset, order, orderDirection);
+    SCHEDULE_READ_REQUEST(
+        coalescingKey,
+        onListAllLinkedNotebooksRequest(
+            limit, offset, order, orderDirection, requestId));
+
+    d->runReadRequest<QList<LinkedNotebook>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listAllLinkedNotebooks(
                 errorDescription, limit, offset, order, orderDirection);
+        },
+        [=](const QList<LinkedNotebook> & linkedNotebooks,
+            const ErrorString & errorDescription) {
+            if (linkedNotebooks.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listAllLinkedNotebooksFailed(
+                    limit, offset, order, orderDirection, errorDescription,
+                    requestId);
+                return;
+            }
 
-        if (linkedNotebooks.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listAllLinkedNotebooksFailed(
-                limit, offset, order, orderDirection, errorDescription,
-                requestId);
-            return;
-        }
-
-        if (d->m_useCache) {
-            for (const auto & linkedNotebook: qAsConst(linkedNotebooks)) {
-                d->m_pLocalStorageCacheManager->cacheLinkedNotebook(
-                    linkedNotebook);
+            if (d->shouldCacheReadResults()) {
+                for (const auto & linkedNotebook: qAsConst(linkedNotebooks)) {
+                    d->m_pLocalStorageCacheManager->cacheLinkedNotebook(
+                        linkedNotebook);
+                }
             }
-        }
 
-        Q_EMIT listAllLinkedNotebooksComplete(
-            limit, offset, order, orderDirection, linkedNotebooks, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT listAllLinkedNotebooksComplete(
+                limit, offset, order, orderDirection, linkedNotebooks,
+                requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list all linked notebooks from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listAllLinkedNotebooksFailed(
-            limit, offset, order, orderDirection, error, requestId);
-    }
+                       "the local storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onListLinkedNotebooksRequest(
@@ -1079,51 +1687,47 @@ void LocalStorageManagerAsync::onListLinkedNotebooksRequest(
     LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListLinkedNotebooksRequest(
+        flag, limit, offset, order, orderDirection, requestId));
 
-    try {
-        ErrorString errorDescription;
-        QList<LinkedNotebook> linkedNotebooks =
-            d->m_pLocalStorageManager->listLinkedNotebooks(
+    d->runReadRequest<QList<LinkedNotebook>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listLinkedNotebooks(
                 flag, errorDescription, limit, offset, order, orderDirection);
+        },
+        [=](const QList<LinkedNotebook> & linkedNotebooks,
+            const ErrorString & errorDescription) {
+            if (linkedNotebooks.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listLinkedNotebooksFailed(
+                    flag, limit, offset, order, orderDirection,
+                    errorDescription, requestId);
+                return;
+            }
 
-        if (linkedNotebooks.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listLinkedNotebooksFailed(
-                flag, limit, offset, order, orderDirection, errorDescription,
-                requestId);
-            return;
-        }
-
-        if (d->m_useCache) {
-            for (const auto & linkedNotebook: qAsConst(linkedNotebooks)) {
-                d->m_pLocalStorageCacheManager->cacheLinkedNotebook(
-                    linkedNotebook);
+            if (d->shouldCacheReadResults()) {
+                for (const auto & linkedNotebook: qAsConst(linkedNotebooks)) {
+                    d->m_pLocalStorageCacheManager->cacheLinkedNotebook(
+                        linkedNotebook);
+                }
             }
-        }
 
-        Q_EMIT listLinkedNotebooksComplete(
-            flag, limit, offset, order, orderDirection, linkedNotebooks,
-            requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT listLinkedNotebooksComplete(
+                flag, limit, offset, order, orderDirection, linkedNotebooks,
+                requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list linked notebooks from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listLinkedNotebooksFailed(
-            flag, limit, offset, order, orderDirection, error, requestId);
-    }
+                       "the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onExpungeLinkedNotebookRequest(
     LinkedNotebook linkedNotebook, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(linkedNotebook),
+        onExpungeLinkedNotebookRequest(linkedNotebook, requestId));
 
     try {
         ErrorString errorDescription;
@@ -1132,8 +1736,8 @@ void LocalStorageManagerAsync::onExpungeLinkedNotebookRequest(
             linkedNotebook, errorDescription);
 
         if (!res) {
-            Q_EMIT expungeLinkedNotebookFailed(
-                linkedNotebook, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(expungeLinkedNotebookFailed(
+                linkedNotebook, errorDescription, requestId));
             return;
         }
 
@@ -1142,7 +1746,8 @@ void LocalStorageManagerAsync::onExpungeLinkedNotebookRequest(
                 linkedNotebook);
         }
 
-        Q_EMIT expungeLinkedNotebookComplete(linkedNotebook, requestId);
+        EMIT_AFTER_COMMIT(
+            expungeLinkedNotebookComplete(linkedNotebook, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -1155,7 +1760,8 @@ void LocalStorageManagerAsync::onExpungeLinkedNotebookRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT expungeLinkedNotebookFailed(linkedNotebook, error, requestId);
+        EMIT_AFTER_COMMIT(
+            expungeLinkedNotebookFailed(linkedNotebook, error, requestId));
     }
 }
 
@@ -1163,32 +1769,27 @@ void LocalStorageManagerAsync::onGetNoteCountRequest(
     LocalStorageManager::NoteCountOptions options, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        int count =
-            d->m_pLocalStorageManager->noteCount(errorDescription, options);
-
-        if (count < 0) {
-            Q_EMIT getNoteCountFailed(errorDescription, options, requestId);
-        }
-        else {
-            Q_EMIT getNoteCountComplete(count, options, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+    const QString coalescingKey = readRequestKey("noteCount", options);
+    SCHEDULE_READ_REQUEST(
+        coalescingKey, onGetNoteCountRequest(options, requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.noteCount(errorDescription, options);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getNoteCountFailed(errorDescription, options, requestId);
+            }
+            else {
+                Q_EMIT getNoteCountComplete(count, options, requestId);
+            }
+        },
+        ErrorString(
             QT_TR_NOOP("Can't get note count from the local "
-                       "storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getNoteCountFailed(error, options, requestId);
-    }
+                       "storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onGetNoteCountPerNotebookRequest(
@@ -1196,152 +1797,139 @@ void LocalStorageManagerAsync::onGetNoteCountPerNotebookRequest(
     QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        int count = d->m_pLocalStorageManager->noteCountPerNotebook(
-            notebook, errorDescription, options);
-
-        if (count < 0) {
-            Q_EMIT getNoteCountPerNotebookFailed(
-                errorDescription, notebook, options, requestId);
-        }
-        else {
-            Q_EMIT getNoteCountPerNotebookComplete(
-                count, notebook, options, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+    SCHEDULE_REQUEST(onGetNoteCountPerNotebookRequest(
+        notebook, options, requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.noteCountPerNotebook(
+                notebook, errorDescription, options);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getNoteCountPerNotebookFailed(
+                    errorDescription, notebook, options, requestId);
+            }
+            else {
+                Q_EMIT getNoteCountPerNotebookComplete(
+                    count, notebook, options, requestId);
+            }
+        },
+        ErrorString(
             QT_TR_NOOP("Can't get note count per notebook from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getNoteCountPerNotebookFailed(
-            error, notebook, options, requestId);
-    }
+                       "the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onGetNoteCountPerTagRequest(
     Tag tag, LocalStorageManager::NoteCountOptions options, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        int count = d->m_pLocalStorageManager->noteCountPerTag(
-            tag, errorDescription, options);
-
-        if (count < 0) {
-            Q_EMIT getNoteCountPerTagFailed(
-                errorDescription, tag, options, requestId);
-        }
-        else {
-            Q_EMIT getNoteCountPerTagComplete(count, tag, options, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+    SCHEDULE_REQUEST(onGetNoteCountPerTagRequest(tag, options, requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.noteCountPerTag(
+                tag, errorDescription, options);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getNoteCountPerTagFailed(
+                    errorDescription, tag, options, requestId);
+            }
+            else {
+                Q_EMIT getNoteCountPerTagComplete(
+                    count, tag, options, requestId);
+            }
+        },
+        ErrorString(
             QT_TR_NOOP("Can't get note count per tag from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getNoteCountPerTagFailed(error, tag, options, requestId);
-    }
+                       "the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onGetNoteCountsPerAllTagsRequest(
     LocalStorageManager::NoteCountOptions options, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    const QString coalescingKey = readRequestKey(
+        "noteCountsPerAllTags", options);
+    SCHEDULE_READ_REQUEST(
+        coalescingKey, onGetNoteCountsPerAllTagsRequest(options, requestId));
+
+    d->runReadRequest<QHash<QString, int>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            QHash<QString, int> noteCountsPerTagLocalUid;
+            bool res = localStorageManager.noteCountsPerAllTags(
+                noteCountsPerTagLocalUid, errorDescription, options);
+            if (!res && errorDescription.isEmpty()) {
+                errorDescription.setBase(
+                    QT_TR_NOOP("Can't get note counts per all tags from "
+                               "the local storage"));
+            }
 
-    try {
-        ErrorString errorDescription;
-        QHash<QString, int> noteCountsPerTagLocalUid;
-        bool res = d->m_pLocalStorageManager->noteCountsPerAllTags(
-            noteCountsPerTagLocalUid, errorDescription, options);
-
-        if (!res) {
-            Q_EMIT getNoteCountsPerAllTagsFailed(
-                errorDescription, options, requestId);
-        }
-        else {
-            Q_EMIT getNoteCountsPerAllTagsComplete(
-                noteCountsPerTagLocalUid, options, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
-            QT_TR_NOOP("Can't get note counts per all tags from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getNoteCountsPerAllTagsFailed(error, options, requestId);
-    }
-}
+            return noteCountsPerTagLocalUid;
+        },
+        [=](const QHash<QString, int> & noteCountsPerTagLocalUid,
+            const ErrorString & errorDescription) {
+            if (!errorDescription.isEmpty()) {
+                Q_EMIT getNoteCountsPerAllTagsFailed(
+                    errorDescription, options, requestId);
+            }
+            else {
+                Q_EMIT getNoteCountsPerAllTagsComplete(
+                    noteCountsPerTagLocalUid, options, requestId);
+            }
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't get note counts per all tags from "
+                       "the local storage: caught exception")),
+        coalescingKey);
+}
 
 void LocalStorageManagerAsync::onGetNoteCountPerNotebooksAndTagsRequest(
     QStringList notebookLocalUids, QStringList tagLocalUids,
     LocalStorageManager::NoteCountOptions options, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        int count = d->m_pLocalStorageManager->noteCountPerNotebooksAndTags(
-            notebookLocalUids, tagLocalUids, errorDescription, options);
-
-        if (count < 0) {
-            Q_EMIT getNoteCountPerNotebooksAndTagsFailed(
-                errorDescription, notebookLocalUids, tagLocalUids, options,
-                requestId);
-        }
-        else {
-            Q_EMIT getNoteCountPerNotebooksAndTagsComplete(
-                count, notebookLocalUids, tagLocalUids, options, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+    SCHEDULE_REQUEST(onGetNoteCountPerNotebooksAndTagsRequest(
+        notebookLocalUids, tagLocalUids, options, requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.noteCountPerNotebooksAndTags(
+                notebookLocalUids, tagLocalUids, errorDescription, options);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getNoteCountPerNotebooksAndTagsFailed(
+                    errorDescription, notebookLocalUids, tagLocalUids, options,
+                    requestId);
+            }
+            else {
+                Q_EMIT getNoteCountPerNotebooksAndTagsComplete(
+                    count, notebookLocalUids, tagLocalUids, options, requestId);
+            }
+        },
+        ErrorString(
             QT_TR_NOOP("Can't get note count per notebooks and "
-                       "tags from the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getNoteCountPerNotebooksAndTagsFailed(
-            error, notebookLocalUids, tagLocalUids, options, requestId);
-    }
+                       "tags from the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onAddNoteRequest(Note note, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(note), onAddNoteRequest(note, requestId));
 
     try {
         ErrorString errorDescription;
 
         bool res = d->m_pLocalStorageManager->addNote(note, errorDescription);
         if (!res) {
-            Q_EMIT addNoteFailed(note, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(addNoteFailed(note, errorDescription, requestId));
             return;
         }
 
@@ -1358,7 +1946,7 @@ void LocalStorageManagerAsync::onAddNoteRequest(Note note, QUuid requestId)
             }
         }
 
-        Q_EMIT addNoteComplete(note, requestId);
+        EMIT_AFTER_COMMIT(addNoteComplete(note, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -1371,7 +1959,7 @@ void LocalStorageManagerAsync::onAddNoteRequest(Note note, QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT addNoteFailed(note, error, requestId);
+        EMIT_AFTER_COMMIT(addNoteFailed(note, error, requestId));
     }
 }
 
@@ -1380,96 +1968,101 @@ void LocalStorageManagerAsync::onUpdateNoteRequest(
     QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(note), onUpdateNoteRequest(note, options, requestId));
 
     try {
         bool shouldCheckForNotebookChange = false;
         bool shouldCheckForTagListUpdate = false;
+        checkNoteChangesToTrack(
+            options, shouldCheckForNotebookChange, shouldCheckForTagListUpdate);
 
-        static const QMetaMethod noteMovedToAnotherNotebookSignal =
-            QMetaMethod::fromSignal(
-                &LocalStorageManagerAsync::noteMovedToAnotherNotebook);
-        if (isSignalConnected(noteMovedToAnotherNotebookSignal)) {
-            shouldCheckForNotebookChange = true;
+        Note previousNoteVersion;
+        if (shouldCheckForNotebookChange || shouldCheckForTagListUpdate) {
+            ErrorString errorDescription;
+            if (!findPreviousNoteVersion(
+                    note, previousNoteVersion, errorDescription)) {
+                EMIT_AFTER_COMMIT(updateNoteFailed(
+                    note, options, errorDescription, requestId));
+                return;
+            }
         }
 
-        if (options & LocalStorageManager::UpdateNoteOption::UpdateTags) {
-            static const QMetaMethod noteTagListChangedSignal =
-                QMetaMethod::fromSignal(
-                    &LocalStorageManagerAsync::noteTagListChanged);
-            if (isSignalConnected(noteTagListChangedSignal)) {
-                shouldCheckForTagListUpdate = true;
-            }
+        ErrorString errorDescription;
+        bool res = d->m_pLocalStorageManager->updateNote(
+            note, options, errorDescription);
+
+        if (!res) {
+            EMIT_AFTER_COMMIT(
+                updateNoteFailed(note, options, errorDescription, requestId));
+            return;
         }
 
-        Note previousNoteVersion;
-        if (shouldCheckForNotebookChange || shouldCheckForTagListUpdate) {
-            bool foundNoteInCache = false;
-            if (d->m_useCache) {
-                const Note * pNote = nullptr;
+        cacheUpdatedNote(note, options);
 
-                if (note.hasGuid()) {
-                    pNote = d->m_pLocalStorageCacheManager->findNote(
-                        note.guid(), LocalStorageCacheManager::WhichUid::Guid);
-                }
+        EMIT_AFTER_COMMIT(updateNoteComplete(note, options, requestId));
 
-                if (!pNote) {
-                    pNote = d->m_pLocalStorageCacheManager->findNote(
-                        note.localUid(),
-                        LocalStorageCacheManager::WhichUid::LocalUid);
-                }
+        notifyNoteChanges(
+            note, previousNoteVersion, shouldCheckForNotebookChange,
+            shouldCheckForTagListUpdate);
+    }
+    catch (const std::exception & e) {
+        ErrorString error(
+            QT_TR_NOOP("Can't update note in the local storage: "
+                       "caught exception"));
 
-                if (pNote) {
-                    previousNoteVersion = *pNote;
-                    foundNoteInCache = true;
-                }
-            }
+        error.details() = QString::fromUtf8(e.what());
 
-            if (!foundNoteInCache) {
-                ErrorString errorDescription;
-#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
-                LocalStorageManager::GetNoteOptions getNoteOptions;
-#else
-                LocalStorageManager::GetNoteOptions getNoteOptions(0);
-#endif
-                bool res = false;
+        SysInfo sysInfo;
+        QNERROR(
+            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-                if (note.hasGuid()) {
-                    // Try to find note by guid first
-                    previousNoteVersion.setGuid(note.guid());
-                    res = d->m_pLocalStorageManager->findNote(
-                        previousNoteVersion, getNoteOptions, errorDescription);
-                }
+        EMIT_AFTER_COMMIT(updateNoteFailed(note, options, error, requestId));
+    }
+}
 
-                if (!res) {
-                    previousNoteVersion.setLocalUid(note.localUid());
-                    previousNoteVersion.setGuid(QString());
-                    res = d->m_pLocalStorageManager->findNote(
-                        previousNoteVersion, getNoteOptions, errorDescription);
-                }
+void LocalStorageManagerAsync::onAddNotesRequest(
+    QList<Note> notes, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(notes), onAddNotesRequest(notes, requestId));
 
-                if (!res) {
-                    Q_EMIT updateNoteFailed(
-                        note, options, errorDescription, requestId);
-                    return;
-                }
-            }
-        }
+    // The number of notes for which per-note signals were emitted; if
+    // an exception is thrown, the rest of notes are reported as failed ones
+    int reportedNoteCount = 0;
 
+    try {
+        QList<ErrorString> noteErrorDescriptions;
         ErrorString errorDescription;
-        bool res = d->m_pLocalStorageManager->updateNote(
-            note, options, errorDescription);
+
+        bool res = d->m_pLocalStorageManager->addNotes(
+            notes, noteErrorDescriptions, errorDescription);
 
         if (!res) {
-            Q_EMIT updateNoteFailed(note, options, errorDescription, requestId);
+            for (const auto & note: qAsConst(notes)) {
+                EMIT_AFTER_COMMIT(
+                    addNoteFailed(note, errorDescription, requestId));
+            }
+
+            EMIT_AFTER_COMMIT(
+                addNotesFailed(notes, errorDescription, requestId));
             return;
         }
 
-        if (d->m_useCache) {
-            if ((options &
-                 LocalStorageManager::UpdateNoteOption::
-                     UpdateResourceMetadata) &&
-                (options & LocalStorageManager::UpdateNoteOption::UpdateTags))
-            {
+        for (int i = 0, size = notes.size(); i < size; ++i) {
+            const Note & note = notes.at(i);
+            const ErrorString & noteErrorDescription =
+                noteErrorDescriptions.at(i);
+
+            if (!noteErrorDescription.isEmpty()) {
+                EMIT_AFTER_COMMIT(
+                    addNoteFailed(note, noteErrorDescription, requestId));
+                ++reportedNoteCount;
+                continue;
+            }
+
+            if (d->m_useCache) {
                 Note noteForCaching = note;
                 QList<Resource> resourcesForCaching;
                 splitNoteAndResourcesForCaching(
@@ -1477,103 +2070,150 @@ void LocalStorageManagerAsync::onUpdateNoteRequest(
 
                 d->m_pLocalStorageCacheManager->cacheNote(noteForCaching);
 
-                if (options &
-                    LocalStorageManager::UpdateNoteOption::
-                        UpdateResourceBinaryData) {
-                    for (const auto & resource: qAsConst(resourcesForCaching)) {
-                        d->m_pLocalStorageCacheManager->cacheResource(resource);
-                    }
-                }
-                else {
-                    // Since resources metadata might have changed, it would
-                    // become stale within the cache so need to remove it from
-                    // there
-                    for (const auto & resource: qAsConst(resourcesForCaching)) {
-                        d->m_pLocalStorageCacheManager->expungeResource(
-                            resource);
-                    }
-                }
-            }
-            else {
-                // The note was somehow changed but the resources or tags
-                // information was not updated => the note in the cache is
-                // stale/incomplete in either case, need to remove it from there
-                d->m_pLocalStorageCacheManager->expungeNote(note);
-
-                // Same goes for its resources
-                QList<Resource> resources = note.resources();
-                for (const auto & resource: qAsConst(resources)) {
-                    d->m_pLocalStorageCacheManager->expungeResource(resource);
+                for (const auto & resource: qAsConst(resourcesForCaching)) {
+                    d->m_pLocalStorageCacheManager->cacheResource(resource);
                 }
             }
+
+            EMIT_AFTER_COMMIT(addNoteComplete(note, requestId));
+            ++reportedNoteCount;
+        }
+
+        EMIT_AFTER_COMMIT(
+            addNotesComplete(notes, noteErrorDescriptions, requestId));
+    }
+    catch (const std::exception & e) {
+        ErrorString error(
+            QT_TR_NOOP("Can't add notes to the local storage: "
+                       "caught exception"));
+
+        error.details() = QString::fromUtf8(e.what());
+
+        SysInfo sysInfo;
+        QNERROR(
+            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
+
+        for (int i = reportedNoteCount, size = notes.size(); i < size; ++i) {
+            EMIT_AFTER_COMMIT(addNoteFailed(notes.at(i), error, requestId));
         }
 
-        Q_EMIT updateNoteComplete(note, options, requestId);
+        EMIT_AFTER_COMMIT(addNotesFailed(notes, error, requestId));
+    }
+}
+
+void LocalStorageManagerAsync::onUpdateNotesRequest(
+    QList<Note> notes, LocalStorageManager::UpdateNoteOptions options,
+    QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(notes),
+        onUpdateNotesRequest(notes, options, requestId));
+
+    // The number of notes for which per-note signals were emitted; if
+    // an exception is thrown, the rest of notes are reported as failed ones
+    int reportedNoteCount = 0;
+
+    try {
+        bool shouldCheckForNotebookChange = false;
+        bool shouldCheckForTagListUpdate = false;
+        checkNoteChangesToTrack(
+            options, shouldCheckForNotebookChange, shouldCheckForTagListUpdate);
+
+        const int numNotes = notes.size();
+
+        // Per-note error descriptions and previous note versions in the order
+        // of notes within the batch
+        QList<ErrorString> noteErrorDescriptions;
+        noteErrorDescriptions.reserve(numNotes);
+
+        QList<Note> previousNoteVersions;
+        previousNoteVersions.reserve(numNotes);
+
+        // Notes which previous versions could not be found are reported
+        // as per-note failures without attempting to update these notes
+        QList<Note> notesToUpdate;
+        notesToUpdate.reserve(numNotes);
+
+        QList<int> notesToUpdateIndices;
+        notesToUpdateIndices.reserve(numNotes);
 
-        if (shouldCheckForNotebookChange) {
-            bool notebookChanged = false;
-            if (note.hasNotebookGuid() && previousNoteVersion.hasNotebookGuid())
+        for (int i = 0; i < numNotes; ++i) {
+            const Note & note = notes.at(i);
+
+            Note previousNoteVersion;
+            ErrorString errorDescription;
+            if ((shouldCheckForNotebookChange || shouldCheckForTagListUpdate) &&
+                !findPreviousNoteVersion(
+                    note, previousNoteVersion, errorDescription))
             {
-                notebookChanged =
-                    (note.notebookGuid() != previousNoteVersion.notebookGuid());
-            }
-            else {
-                notebookChanged =
-                    (note.notebookLocalUid() !=
-                     previousNoteVersion.notebookLocalUid());
+                noteErrorDescriptions << errorDescription;
+                previousNoteVersions << Note();
+                continue;
             }
 
-            if (notebookChanged) {
-                QNDEBUG(
-                    "local_storage",
-                    "Notebook change detected for note "
-                        << note.localUid() << ": moved from notebook "
-                        << previousNoteVersion.notebookLocalUid()
-                        << " to notebook " << note.notebookLocalUid());
+            noteErrorDescriptions << ErrorString();
+            previousNoteVersions << previousNoteVersion;
 
-                Q_EMIT noteMovedToAnotherNotebook(
-                    note.localUid(), previousNoteVersion.notebookLocalUid(),
-                    note.notebookLocalUid());
-            }
+            notesToUpdate << note;
+            notesToUpdateIndices << i;
         }
 
-        if (shouldCheckForTagListUpdate) {
-            const QStringList & previousTagLocalUids =
-                previousNoteVersion.tagLocalUids();
-
-            const QStringList & updatedTagLocalUids = note.tagLocalUids();
+        QList<ErrorString> updatedNoteErrorDescriptions;
+        ErrorString errorDescription;
 
-            bool tagListUpdated =
-                (previousTagLocalUids.size() != updatedTagLocalUids.size());
+        bool res = d->m_pLocalStorageManager->updateNotes(
+            notesToUpdate, options, updatedNoteErrorDescriptions,
+            errorDescription);
 
-            if (!tagListUpdated) {
-                for (const auto & prevTagLocalUid:
-                     qAsConst(previousTagLocalUids)) {
-                    int index = updatedTagLocalUids.indexOf(prevTagLocalUid);
-                    if (index < 0) {
-                        tagListUpdated = true;
-                        break;
-                    }
-                }
+        if (!res) {
+            for (const auto & note: qAsConst(notes)) {
+                EMIT_AFTER_COMMIT(updateNoteFailed(
+                    note, options, errorDescription, requestId));
             }
 
-            if (tagListUpdated) {
-                QNDEBUG(
-                    "local_storage",
-                    "Tags list update detected for note "
-                        << note.localUid() << ": previous tag local uids: "
-                        << previousTagLocalUids.join(QStringLiteral(", "))
-                        << "; updated tag local uids: "
-                        << updatedTagLocalUids.join(QStringLiteral(",")));
+            EMIT_AFTER_COMMIT(
+                updateNotesFailed(notes, options, errorDescription, requestId));
+            return;
+        }
 
-                Q_EMIT noteTagListChanged(
-                    note.localUid(), previousTagLocalUids, updatedTagLocalUids);
+        // Updated notes might have been complemented by the local storage
+        // manager, e.g. with tag guids
+        QList<Note> updatedNotes = notes;
+        for (int i = 0, size = notesToUpdate.size(); i < size; ++i) {
+            int index = notesToUpdateIndices.at(i);
+            updatedNotes[index] = notesToUpdate.at(i);
+            noteErrorDescriptions[index] = updatedNoteErrorDescriptions.at(i);
+        }
+
+        for (int i = 0; i < numNotes; ++i) {
+            const Note & note = updatedNotes.at(i);
+            const ErrorString & noteErrorDescription =
+                noteErrorDescriptions.at(i);
+
+            if (!noteErrorDescription.isEmpty()) {
+                EMIT_AFTER_COMMIT(updateNoteFailed(
+                    note, options, noteErrorDescription, requestId));
+                ++reportedNoteCount;
+                continue;
             }
+
+            cacheUpdatedNote(note, options);
+
+            EMIT_AFTER_COMMIT(updateNoteComplete(note, options, requestId));
+            ++reportedNoteCount;
+
+            notifyNoteChanges(
+                note, previousNoteVersions.at(i), shouldCheckForNotebookChange,
+                shouldCheckForTagListUpdate);
         }
+
+        EMIT_AFTER_COMMIT(updateNotesComplete(
+            updatedNotes, options, noteErrorDescriptions, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
-            QT_TR_NOOP("Can't update note in the local storage: "
+            QT_TR_NOOP("Can't update notes in the local storage: "
                        "caught exception"));
 
         error.details() = QString::fromUtf8(e.what());
@@ -1582,7 +2222,12 @@ void LocalStorageManagerAsync::onUpdateNoteRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT updateNoteFailed(note, options, error, requestId);
+        for (int i = reportedNoteCount, size = notes.size(); i < size; ++i) {
+            EMIT_AFTER_COMMIT(
+                updateNoteFailed(notes.at(i), options, error, requestId));
+        }
+
+        EMIT_AFTER_COMMIT(updateNotesFailed(notes, options, error, requestId));
     }
 }
 
@@ -1591,6 +2236,13 @@ void LocalStorageManagerAsync::onFindNoteRequest(
 {
     Q_D(LocalStorageManagerAsync);
 
+    const QString coalescingKey = readRequestKey(
+        "findNote", (note.hasGuid() ? note.guid() : QString()), note.localUid(),
+        options);
+
+    SCHEDULE_READ_REQUEST(
+        coalescingKey, onFindNoteRequest(note, options, requestId));
+
     try {
         ErrorString errorDescription;
 
@@ -1637,6 +2289,22 @@ void LocalStorageManagerAsync::onFindNoteRequest(
                                 resourceOptions = LocalStorageManager::
                                     GetResourceOption::WithBinaryData;
 
+                            if (options &
+                                LocalStorageManager::GetNoteOption::
+                                    MapResourceBinaryData)
+                            {
+                                resourceOptions |= LocalStorageManager::
+                                    GetResourceOption::MapBinaryData;
+                            }
+
+                            if (options &
+                                LocalStorageManager::GetNoteOption::
+                                    LazyResourceBinaryData)
+                            {
+                                resourceOptions |= LocalStorageManager::
+                                    GetResourceOption::LazyBinaryData;
+                            }
+
                             bool res =
                                 d->m_pLocalStorageManager->findEnResource(
                                     resource, resourceOptions,
@@ -1655,38 +2323,16 @@ void LocalStorageManagerAsync::onFindNoteRequest(
             }
         }
 
-        if (!foundNoteInCache) {
-            bool res = d->m_pLocalStorageManager->findNote(
-                note, options, errorDescription);
-
-            if (!res) {
-                Q_EMIT findNoteFailed(
-                    note, options, errorDescription, requestId);
-                return;
-            }
-        }
-
-        if (!foundNoteInCache && d->m_useCache) {
-            QList<Resource> resources = note.resources();
-            for (auto & resource: resources) {
-                resource.setDataBody(QByteArray());
-                resource.setAlternateDataBody(QByteArray());
+        if (foundNoteInCache) {
+            if (!(options &
+                  LocalStorageManager::GetNoteOption::WithResourceMetadata))
+            {
+                note.setResources(QList<Resource>());
             }
 
-            Note noteWithoutResourceBinaryData = note;
-            noteWithoutResourceBinaryData.setResources(resources);
-            d->m_pLocalStorageCacheManager->cacheNote(
-                noteWithoutResourceBinaryData);
-        }
-
-        if (foundNoteInCache &&
-            !(options &
-              LocalStorageManager::GetNoteOption::WithResourceMetadata))
-        {
-            note.setResources(QList<Resource>());
+            Q_EMIT findNoteComplete(note, options, requestId);
+            return;
         }
-
-        Q_EMIT findNoteComplete(note, options, requestId);
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -1700,7 +2346,46 @@ void LocalStorageManagerAsync::onFindNoteRequest(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
         Q_EMIT findNoteFailed(note, options, error, requestId);
+        return;
     }
+
+    d->runReadRequest<std::pair<bool, Note>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            Note foundNote = note;
+            bool res = localStorageManager.findNote(
+                foundNote, options, errorDescription);
+            return std::make_pair(res, foundNote);
+        },
+        [=](const std::pair<bool, Note> & result,
+            const ErrorString & errorDescription) {
+            if (!result.first) {
+                Q_EMIT findNoteFailed(
+                    note, options, errorDescription, requestId);
+                return;
+            }
+
+            const Note & foundNote = result.second;
+
+            if (d->shouldCacheReadResults()) {
+                QList<Resource> resources = foundNote.resources();
+                for (auto & resource: resources) {
+                    resource.setDataBody(QByteArray());
+                    resource.setAlternateDataBody(QByteArray());
+                }
+
+                Note noteWithoutResourceBinaryData = foundNote;
+                noteWithoutResourceBinaryData.setResources(resources);
+                d->m_pLocalStorageCacheManager->cacheNote(
+                    noteWithoutResourceBinaryData);
+            }
+
+            Q_EMIT findNoteComplete(foundNote, options, requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't find note within the local "
+                       "storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onListNotesPerNotebookRequest(
@@ -1710,42 +2395,34 @@ void LocalStorageManagerAsync::onListNotesPerNotebookRequest(
     LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListNotesPerNotebookRequest(
+        notebook, options, flag, limit, offset, order, orderDirection,
+        requestId));
+
+    d->runReadRequest<QList<Note>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listNotesPerNotebook(
+                notebook, options, errorDescription, flag, limit, offset, order,
+                orderDirection);
+        },
+        [=](const QList<Note> & notes, const ErrorString & errorDescription) {
+            if (notes.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listNotesPerNotebookFailed(
+                    notebook, options, flag, limit, offset, order,
+                    orderDirection, errorDescription, requestId);
+                return;
+            }
 
-    try {
-        ErrorString errorDescription;
-
-        QList<Note> notes = d->m_pLocalStorageManager->listNotesPerNotebook(
-            notebook, options, errorDescription, flag, limit, offset, order,
-            orderDirection);
+            d->cacheNotes(notes, options);
 
-        if (notes.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listNotesPerNotebookFailed(
+            Q_EMIT listNotesPerNotebookComplete(
                 notebook, options, flag, limit, offset, order, orderDirection,
-                errorDescription, requestId);
-            return;
-        }
-
-        d->cacheNotes(notes, options);
-
-        Q_EMIT listNotesPerNotebookComplete(
-            notebook, options, flag, limit, offset, order, orderDirection,
-            notes, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+                notes, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list notes per notebook from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listNotesPerNotebookFailed(
-            notebook, options, flag, limit, offset, order, orderDirection,
-            error, requestId);
-    }
+                       "the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onListNotesPerTagRequest(
@@ -1755,41 +2432,32 @@ void LocalStorageManagerAsync::onListNotesPerTagRequest(
     LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListNotesPerTagRequest(
+        tag, options, flag, limit, offset, order, orderDirection, requestId));
+
+    d->runReadRequest<QList<Note>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listNotesPerTag(
+                tag, options, errorDescription, flag, limit, offset, order,
+                orderDirection);
+        },
+        [=](const QList<Note> & notes, const ErrorString & errorDescription) {
+            if (notes.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listNotesPerTagFailed(
+                    tag, options, flag, limit, offset, order, orderDirection,
+                    errorDescription, requestId);
+                return;
+            }
 
-    try {
-        ErrorString errorDescription;
-
-        QList<Note> notes = d->m_pLocalStorageManager->listNotesPerTag(
-            tag, options, errorDescription, flag, limit, offset, order,
-            orderDirection);
-
-        if (notes.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listNotesPerTagFailed(
-                tag, options, flag, limit, offset, order, orderDirection,
-                errorDescription, requestId);
-            return;
-        }
-
-        d->cacheNotes(notes, options);
-        Q_EMIT listNotesPerTagComplete(
-            tag, options, flag, limit, offset, order, orderDirection, notes,
-            requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            d->cacheNotes(notes, options);
+            Q_EMIT listNotesPerTagComplete(
+                tag, options, flag, limit, offset, order, orderDirection, notes,
+                requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list notes per tag from the local "
-                       "storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listNotesPerTagFailed(
-            tag, options, flag, limit, offset, order, orderDirection, error,
-            requestId);
-    }
+                       "storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onListNotesPerNotebooksAndTagsRequest(
@@ -1800,41 +2468,33 @@ void LocalStorageManagerAsync::onListNotesPerNotebooksAndTagsRequest(
     LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        QList<Note> notes =
-            d->m_pLocalStorageManager->listNotesPerNotebooksAndTags(
+    SCHEDULE_REQUEST(onListNotesPerNotebooksAndTagsRequest(
+        notebookLocalUids, tagLocalUids, options, flag, limit, offset, order,
+        orderDirection, requestId));
+
+    d->runReadRequest<QList<Note>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listNotesPerNotebooksAndTags(
                 notebookLocalUids, tagLocalUids, options, errorDescription,
                 flag, limit, offset, order, orderDirection);
+        },
+        [=](const QList<Note> & notes, const ErrorString & errorDescription) {
+            if (notes.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listNotesPerNotebooksAndTagsFailed(
+                    notebookLocalUids, tagLocalUids, options, flag, limit,
+                    offset, order, orderDirection, errorDescription, requestId);
+                return;
+            }
 
-        if (notes.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listNotesPerNotebooksAndTagsFailed(
+            d->cacheNotes(notes, options);
+            Q_EMIT listNotesPerNotebooksAndTagsComplete(
                 notebookLocalUids, tagLocalUids, options, flag, limit, offset,
-                order, orderDirection, errorDescription, requestId);
-            return;
-        }
-
-        d->cacheNotes(notes, options);
-        Q_EMIT listNotesPerNotebooksAndTagsComplete(
-            notebookLocalUids, tagLocalUids, options, flag, limit, offset,
-            order, orderDirection, notes, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+                order, orderDirection, notes, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list notes per notebooks and tags "
-                       "from the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listNotesPerNotebooksAndTagsFailed(
-            notebookLocalUids, tagLocalUids, options, flag, limit, offset,
-            order, orderDirection, error, requestId);
-    }
+                       "from the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onListNotesByLocalUidsRequest(
@@ -1844,40 +2504,33 @@ void LocalStorageManagerAsync::onListNotesByLocalUidsRequest(
     LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListNotesByLocalUidsRequest(
+        noteLocalUids, options, flag, limit, offset, order, orderDirection,
+        requestId));
+
+    d->runReadRequest<QList<Note>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listNotesByLocalUids(
+                noteLocalUids, options, errorDescription, flag, limit, offset,
+                order, orderDirection);
+        },
+        [=](const QList<Note> & notes, const ErrorString & errorDescription) {
+            if (notes.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listNotesByLocalUidsFailed(
+                    noteLocalUids, options, flag, limit, offset, order,
+                    orderDirection, errorDescription, requestId);
+                return;
+            }
 
-    try {
-        ErrorString errorDescription;
-        QList<Note> notes = d->m_pLocalStorageManager->listNotesByLocalUids(
-            noteLocalUids, options, errorDescription, flag, limit, offset,
-            order, orderDirection);
-
-        if (notes.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listNotesByLocalUidsFailed(
+            d->cacheNotes(notes, options);
+            Q_EMIT listNotesByLocalUidsComplete(
                 noteLocalUids, options, flag, limit, offset, order,
-                orderDirection, errorDescription, requestId);
-            return;
-        }
-
-        d->cacheNotes(notes, options);
-        Q_EMIT listNotesByLocalUidsComplete(
-            noteLocalUids, options, flag, limit, offset, order, orderDirection,
-            notes, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+                orderDirection, notes, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list notes by local uids from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listNotesByLocalUidsFailed(
-            noteLocalUids, options, flag, limit, offset, order, orderDirection,
-            error, requestId);
-    }
+                       "the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onListNotesRequest(
@@ -1888,82 +2541,219 @@ void LocalStorageManagerAsync::onListNotesRequest(
     QString linkedNotebookGuid, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListNotesRequest(
+        flag, options, limit, offset, order, orderDirection, linkedNotebookGuid,
+        requestId));
+
+    d->runReadRequest<QList<Note>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listNotes(
+                flag, options, errorDescription, limit, offset, order,
+                orderDirection, linkedNotebookGuid);
+        },
+        [=](const QList<Note> & notes, const ErrorString & errorDescription) {
+            if (notes.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listNotesFailed(
+                    flag, options, limit, offset, order, orderDirection,
+                    linkedNotebookGuid, errorDescription, requestId);
+                return;
+            }
 
-    try {
-        ErrorString errorDescription;
-        QList<Note> notes = d->m_pLocalStorageManager->listNotes(
-            flag, options, errorDescription, limit, offset, order,
-            orderDirection, linkedNotebookGuid);
+            d->cacheNotes(notes, options);
 
-        if (notes.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listNotesFailed(
+            Q_EMIT listNotesComplete(
                 flag, options, limit, offset, order, orderDirection,
-                linkedNotebookGuid, errorDescription, requestId);
-            return;
-        }
+                linkedNotebookGuid, notes, requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't list notes from the local storage: "
+                       "caught exception")));
+}
 
-        d->cacheNotes(notes, options);
+void LocalStorageManagerAsync::onListNotesPageRequest(
+    LocalStorageManager::ListObjectsOptions flag,
+    LocalStorageManager::GetNoteOptions options, size_t pageSize,
+    QString continuationToken, LocalStorageManager::ListNotesOrder order,
+    LocalStorageManager::OrderDirection orderDirection,
+    QString linkedNotebookGuid, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListNotesPageRequest(
+        flag, options, pageSize, continuationToken, order, orderDirection,
+        linkedNotebookGuid, requestId));
+
+    auto nextContinuationToken = std::make_shared<QString>(continuationToken);
+
+    d->runReadRequest<QList<Note>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listNotesPage(
+                flag, options, errorDescription, pageSize,
+                *nextContinuationToken, order, orderDirection,
+                linkedNotebookGuid);
+        },
+        [=](const QList<Note> & notes, const ErrorString & errorDescription) {
+            if (notes.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listNotesPageFailed(
+                    flag, options, pageSize, continuationToken, order,
+                    orderDirection, linkedNotebookGuid, errorDescription,
+                    requestId);
+                return;
+            }
 
-        Q_EMIT listNotesComplete(
-            flag, options, limit, offset, order, orderDirection,
-            linkedNotebookGuid, notes, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
-            QT_TR_NOOP("Can't list notes from the local storage: "
-                       "caught exception"));
+            d->cacheNotes(notes, options);
 
-        error.details() = QString::fromUtf8(e.what());
+            Q_EMIT listNotesPageComplete(
+                flag, options, pageSize, continuationToken, order,
+                orderDirection, linkedNotebookGuid, notes,
+                *nextContinuationToken, requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't list the page of notes from the local storage: "
+                       "caught exception")));
+}
 
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
+void LocalStorageManagerAsync::onListNoteSummariesRequest(
+    LocalStorageManager::ListObjectsOptions flag,
+    LocalStorageManager::NoteSummaryFields fields, size_t limit, size_t offset,
+    LocalStorageManager::ListNotesOrder order,
+    LocalStorageManager::OrderDirection orderDirection,
+    QString linkedNotebookGuid, int previewLength, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListNoteSummariesRequest(
+        flag, fields, limit, offset, order, orderDirection, linkedNotebookGuid,
+        previewLength, requestId));
+
+    using NoteSummary = LocalStorageManager::NoteSummary;
+
+    d->runReadRequest<QList<NoteSummary>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listNoteSummaries(
+                flag, fields, errorDescription, limit, offset, order,
+                orderDirection, linkedNotebookGuid, previewLength);
+        },
+        [=](const QList<NoteSummary> & noteSummaries,
+            const ErrorString & errorDescription) {
+            if (noteSummaries.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listNoteSummariesFailed(
+                    flag, fields, limit, offset, order, orderDirection,
+                    linkedNotebookGuid, previewLength, errorDescription,
+                    requestId);
+                return;
+            }
 
-        Q_EMIT listNotesFailed(
-            flag, options, limit, offset, order, orderDirection,
-            linkedNotebookGuid, error, requestId);
-    }
+            Q_EMIT listNoteSummariesComplete(
+                flag, fields, limit, offset, order, orderDirection,
+                linkedNotebookGuid, previewLength, noteSummaries, requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't list note summaries from the local storage: "
+                       "caught exception")));
 }
 
 void LocalStorageManagerAsync::onFindNoteLocalUidsWithSearchQuery(
     NoteSearchQuery noteSearchQuery, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindNoteLocalUidsWithSearchQuery(
+        noteSearchQuery, requestId));
 
-    try {
-        ErrorString errorDescription;
-        QStringList noteLocalUids =
-            d->m_pLocalStorageManager->findNoteLocalUidsWithSearchQuery(
+    d->runReadRequest<QStringList>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.findNoteLocalUidsWithSearchQuery(
                 noteSearchQuery, errorDescription);
+        },
+        [=](const QStringList & noteLocalUids,
+            const ErrorString & errorDescription) {
+            if (noteLocalUids.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT findNoteLocalUidsWithSearchQueryFailed(
+                    noteSearchQuery, errorDescription, requestId);
+                return;
+            }
 
-        if (noteLocalUids.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT findNoteLocalUidsWithSearchQueryFailed(
-                noteSearchQuery, errorDescription, requestId);
-            return;
-        }
-
-        Q_EMIT findNoteLocalUidsWithSearchQueryComplete(
-            noteLocalUids, noteSearchQuery, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT findNoteLocalUidsWithSearchQueryComplete(
+                noteLocalUids, noteSearchQuery, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't find note local uids with search query "
-                       "within the local storage: caught exception"));
+                       "within the local storage: caught exception")));
+}
 
-        error.details() = QString::fromUtf8(e.what());
+void LocalStorageManagerAsync::onFindNoteSearchHitsRequest(
+    NoteSearchQuery noteSearchQuery, size_t limit, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindNoteSearchHitsRequest(
+        noteSearchQuery, limit, requestId));
+
+    using NoteSearchHit = LocalStorageManager::NoteSearchHit;
+
+    d->runReadRequest<QList<NoteSearchHit>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.findNoteSearchHits(
+                noteSearchQuery, errorDescription, limit);
+        },
+        [=](const QList<NoteSearchHit> & hits,
+            const ErrorString & errorDescription) {
+            if (hits.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT findNoteSearchHitsFailed(
+                    noteSearchQuery, limit, errorDescription, requestId);
+                return;
+            }
 
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
+            Q_EMIT findNoteSearchHitsComplete(
+                hits, noteSearchQuery, limit, requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't find note search hits within the local "
+                       "storage: caught exception")));
+}
 
-        Q_EMIT findNoteLocalUidsWithSearchQueryFailed(
-            noteSearchQuery, error, requestId);
-    }
+void LocalStorageManagerAsync::onFindNoteLocalUidsWithinBoundingBoxRequest(
+    double minLatitude, double maxLatitude, double minLongitude,
+    double maxLongitude, LocalStorageManager::NoteCountOptions options,
+    QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindNoteLocalUidsWithinBoundingBoxRequest(
+        minLatitude, maxLatitude, minLongitude, maxLongitude, options,
+        requestId));
+
+    d->runReadRequest<QStringList>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.findNoteLocalUidsWithinBoundingBox(
+                minLatitude, maxLatitude, minLongitude, maxLongitude,
+                errorDescription, options);
+        },
+        [=](const QStringList & noteLocalUids,
+            const ErrorString & errorDescription) {
+            if (noteLocalUids.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT findNoteLocalUidsWithinBoundingBoxFailed(
+                    minLatitude, maxLatitude, minLongitude, maxLongitude,
+                    options, errorDescription, requestId);
+                return;
+            }
+
+            Q_EMIT findNoteLocalUidsWithinBoundingBoxComplete(
+                noteLocalUids, minLatitude, maxLatitude, minLongitude,
+                maxLongitude, options, requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't find note local uids within the bounding box "
+                       "in the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onExpungeNoteRequest(Note note, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(note), onExpungeNoteRequest(note, requestId));
 
     try {
         ErrorString errorDescription;
@@ -1973,7 +2763,8 @@ void LocalStorageManagerAsync::onExpungeNoteRequest(Note note, QUuid requestId)
             d->m_pLocalStorageManager->expungeNote(note, errorDescription);
 
         if (!res) {
-            Q_EMIT expungeNoteFailed(note, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                expungeNoteFailed(note, errorDescription, requestId));
             return;
         }
 
@@ -1985,7 +2776,7 @@ void LocalStorageManagerAsync::onExpungeNoteRequest(Note note, QUuid requestId)
             }
         }
 
-        Q_EMIT expungeNoteComplete(note, requestId);
+        EMIT_AFTER_COMMIT(expungeNoteComplete(note, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -1998,28 +2789,60 @@ void LocalStorageManagerAsync::onExpungeNoteRequest(Note note, QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT expungeNoteFailed(note, error, requestId);
+        EMIT_AFTER_COMMIT(expungeNoteFailed(note, error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onGetTagCountRequest(QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    const QString coalescingKey = readRequestKey("tagCount");
+    SCHEDULE_READ_REQUEST(coalescingKey, onGetTagCountRequest(requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.tagCount(errorDescription);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getTagCountFailed(errorDescription, requestId);
+            }
+            else {
+                Q_EMIT getTagCountComplete(count, requestId);
+            }
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't get tag count from the local "
+                       "storage: caught exception")),
+        coalescingKey);
+}
+
+void LocalStorageManagerAsync::onAddTagRequest(Tag tag, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(tag), onAddTagRequest(tag, requestId));
 
     try {
         ErrorString errorDescription;
-        int count = d->m_pLocalStorageManager->tagCount(errorDescription);
-        if (count < 0) {
-            Q_EMIT getTagCountFailed(errorDescription, requestId);
+
+        bool res = d->m_pLocalStorageManager->addTag(tag, errorDescription);
+        if (!res) {
+            EMIT_AFTER_COMMIT(addTagFailed(tag, errorDescription, requestId));
+            return;
         }
-        else {
-            Q_EMIT getTagCountComplete(count, requestId);
+
+        if (d->m_useCache) {
+            d->m_pLocalStorageCacheManager->cacheTag(tag);
         }
+
+        EMIT_AFTER_COMMIT(addTagComplete(tag, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
-            QT_TR_NOOP("Can't get tag count from the local "
-                       "storage: caught exception"));
+            QT_TR_NOOP("Can't add tag to the local storage: "
+                       "caught exception"));
 
         error.details() = QString::fromUtf8(e.what());
 
@@ -2027,32 +2850,58 @@ void LocalStorageManagerAsync::onGetTagCountRequest(QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT getTagCountFailed(error, requestId);
+        EMIT_AFTER_COMMIT(addTagFailed(tag, error, requestId));
     }
 }
 
-void LocalStorageManagerAsync::onAddTagRequest(Tag tag, QUuid requestId)
+void LocalStorageManagerAsync::onAddTagsRequest(
+    QList<Tag> tags, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(tags), onAddTagsRequest(tags, requestId));
 
     try {
+        QList<ErrorString> tagErrorDescriptions;
         ErrorString errorDescription;
 
-        bool res = d->m_pLocalStorageManager->addTag(tag, errorDescription);
+        bool res = d->m_pLocalStorageManager->addTags(
+            tags, tagErrorDescriptions, errorDescription);
+
         if (!res) {
-            Q_EMIT addTagFailed(tag, errorDescription, requestId);
+            for (const auto & tag: qAsConst(tags)) {
+                EMIT_AFTER_COMMIT(
+                    addTagFailed(tag, errorDescription, requestId));
+            }
+
+            EMIT_AFTER_COMMIT(addTagsFailed(tags, errorDescription, requestId));
             return;
         }
 
-        if (d->m_useCache) {
-            d->m_pLocalStorageCacheManager->cacheTag(tag);
+        for (int i = 0, size = tags.size(); i < size; ++i) {
+            const Tag & tag = tags.at(i);
+            const ErrorString & tagErrorDescription =
+                tagErrorDescriptions.at(i);
+
+            if (!tagErrorDescription.isEmpty()) {
+                EMIT_AFTER_COMMIT(
+                    addTagFailed(tag, tagErrorDescription, requestId));
+                continue;
+            }
+
+            if (d->m_useCache) {
+                d->m_pLocalStorageCacheManager->cacheTag(tag);
+            }
+
+            EMIT_AFTER_COMMIT(addTagComplete(tag, requestId));
         }
 
-        Q_EMIT addTagComplete(tag, requestId);
+        EMIT_AFTER_COMMIT(
+            addTagsComplete(tags, tagErrorDescriptions, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
-            QT_TR_NOOP("Can't add tag to the local storage: "
+            QT_TR_NOOP("Can't add tags to the local storage: "
                        "caught exception"));
 
         error.details() = QString::fromUtf8(e.what());
@@ -2061,20 +2910,23 @@ void LocalStorageManagerAsync::onAddTagRequest(Tag tag, QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT addTagFailed(tag, error, requestId);
+        EMIT_AFTER_COMMIT(addTagsFailed(tags, error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onUpdateTagRequest(Tag tag, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(tag), onUpdateTagRequest(tag, requestId));
 
     try {
         ErrorString errorDescription;
 
         bool res = d->m_pLocalStorageManager->updateTag(tag, errorDescription);
         if (!res) {
-            Q_EMIT updateTagFailed(tag, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                updateTagFailed(tag, errorDescription, requestId));
             return;
         }
 
@@ -2082,7 +2934,7 @@ void LocalStorageManagerAsync::onUpdateTagRequest(Tag tag, QUuid requestId)
             d->m_pLocalStorageCacheManager->cacheTag(tag);
         }
 
-        Q_EMIT updateTagComplete(tag, requestId);
+        EMIT_AFTER_COMMIT(updateTagComplete(tag, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -2095,13 +2947,14 @@ void LocalStorageManagerAsync::onUpdateTagRequest(Tag tag, QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT updateTagFailed(tag, error, requestId);
+        EMIT_AFTER_COMMIT(updateTagFailed(tag, error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onFindTagRequest(Tag tag, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindTagRequest(tag, requestId));
 
     try {
         ErrorString errorDescription;
@@ -2167,43 +3020,37 @@ void LocalStorageManagerAsync::onListAllTagsPerNoteRequest(
     LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListAllTagsPerNoteRequest(
+        note, flag, limit, offset, order, orderDirection, requestId));
+
+    d->runReadRequest<QList<Tag>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listAllTagsPerNote(
+                note, errorDescription, flag, limit, offset, order,
+                orderDirection);
+        },
+        [=](const QList<Tag> & tags, const ErrorString & errorDescription) {
+            if (tags.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listAllTagsPerNoteFailed(
+                    note, flag, limit, offset, order, orderDirection,
+                    errorDescription, requestId);
+                return;
+            }
 
-    try {
-        ErrorString errorDescription;
-
-        QList<Tag> tags = d->m_pLocalStorageManager->listAllTagsPerNote(
-            note, errorDescription, flag, limit, offset, order, orderDirection);
-
-        if (tags.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listAllTagsPerNoteFailed(
-                note, flag, limit, offset, order, orderDirection,
-                errorDescription, requestId);
-            return;
-        }
-
-        if (d->m_useCache) {
-            for (const auto & tag: qAsConst(tags)) {
-                d->m_pLocalStorageCacheManager->cacheTag(tag);
+            if (d->shouldCacheReadResults()) {
+                for (const auto & tag: qAsConst(tags)) {
+                    d->m_pLocalStorageCacheManager->cacheTag(tag);
+                }
             }
-        }
 
-        Q_EMIT listAllTagsPerNoteComplete(
-            tags, note, flag, limit, offset, order, orderDirection, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT listAllTagsPerNoteComplete(
+                tags, note, flag, limit, offset, order, orderDirection,
+                requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list all tags per note from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listAllTagsPerNoteFailed(
-            note, flag, limit, offset, order, orderDirection, error, requestId);
-    }
+                       "the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onListAllTagsRequest(
@@ -2212,46 +3059,44 @@ void LocalStorageManagerAsync::onListAllTagsRequest(
     QString linkedNotebookGuid, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    const QString coalescingKey = readRequestKey(
+        "listAllTags", limit, offset, order, orderDirection,
+        linkedNotebookGuid);
+    SCHEDULE_READ_REQUEST(
+        coalescingKey,
+        onListAllTagsRequest(
+            limit, offset, order, orderDirection, linkedNotebookGuid,
+            requestId));
+
+    d->runReadRequest<QList<Tag>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listAllTags(
+                errorDescription, limit, offset, order, orderDirection,
+                linkedNotebookGuid);
+        },
+        [=](const QList<Tag> & tags, const ErrorString & errorDescription) {
+            if (tags.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listAllTagsFailed(
+                    limit, offset, order, orderDirection, linkedNotebookGuid,
+                    errorDescription, requestId);
+                return;
+            }
 
-    try {
-        ErrorString errorDescription;
-
-        QList<Tag> tags = d->m_pLocalStorageManager->listAllTags(
-            errorDescription, limit, offset, order, orderDirection,
-            linkedNotebookGuid);
-
-        if (tags.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listAllTagsFailed(
-                limit, offset, order, orderDirection, linkedNotebookGuid,
-                errorDescription, requestId);
-            return;
-        }
-
-        if (d->m_useCache) {
-            for (const auto & tag: qAsConst(tags)) {
-                d->m_pLocalStorageCacheManager->cacheTag(tag);
+            if (d->shouldCacheReadResults()) {
+                for (const auto & tag: qAsConst(tags)) {
+                    d->m_pLocalStorageCacheManager->cacheTag(tag);
+                }
             }
-        }
 
-        Q_EMIT listAllTagsComplete(
-            limit, offset, order, orderDirection, linkedNotebookGuid, tags,
-            requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT listAllTagsComplete(
+                limit, offset, order, orderDirection, linkedNotebookGuid, tags,
+                requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list all tags from the local "
-                       "storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT listAllTagsFailed(
-            limit, offset, order, orderDirection, linkedNotebookGuid, error,
-            requestId);
-    }
+                       "storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onListTagsRequest(
@@ -2261,44 +3106,80 @@ void LocalStorageManagerAsync::onListTagsRequest(
     QString linkedNotebookGuid, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListTagsRequest(
+        flag, limit, offset, order, orderDirection, linkedNotebookGuid,
+        requestId));
+
+    d->runReadRequest<QList<Tag>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listTags(
+                flag, errorDescription, limit, offset, order, orderDirection,
+                linkedNotebookGuid);
+        },
+        [=](const QList<Tag> & tags, const ErrorString & errorDescription) {
+            if (tags.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listTagsFailed(
+                    flag, limit, offset, order, orderDirection,
+                    linkedNotebookGuid, errorDescription, requestId);
+            }
 
-    try {
-        ErrorString errorDescription;
-        QList<Tag> tags = d->m_pLocalStorageManager->listTags(
-            flag, errorDescription, limit, offset, order, orderDirection,
-            linkedNotebookGuid);
-
-        if (tags.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listTagsFailed(
-                flag, limit, offset, order, orderDirection, linkedNotebookGuid,
-                errorDescription, requestId);
-        }
-
-        if (d->m_useCache) {
-            for (const auto & tag: qAsConst(tags)) {
-                d->m_pLocalStorageCacheManager->cacheTag(tag);
+            if (d->shouldCacheReadResults()) {
+                for (const auto & tag: qAsConst(tags)) {
+                    d->m_pLocalStorageCacheManager->cacheTag(tag);
+                }
             }
-        }
 
-        Q_EMIT listTagsComplete(
-            flag, limit, offset, order, orderDirection, linkedNotebookGuid,
-            tags, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+            Q_EMIT listTagsComplete(
+                flag, limit, offset, order, orderDirection, linkedNotebookGuid,
+                tags, requestId);
+        },
+        ErrorString(
             QT_TR_NOOP("Can't list tags from the local storage: "
-                       "caught exception"));
+                       "caught exception")));
+}
 
-        error.details() = QString::fromUtf8(e.what());
+void LocalStorageManagerAsync::onListTagsPageRequest(
+    LocalStorageManager::ListObjectsOptions flag, size_t pageSize,
+    QString continuationToken, LocalStorageManager::ListTagsOrder order,
+    LocalStorageManager::OrderDirection orderDirection,
+    QString linkedNotebookGuid, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListTagsPageRequest(
+        flag, pageSize, continuationToken, order, orderDirection,
+        linkedNotebookGuid, requestId));
+
+    auto nextContinuationToken = std::make_shared<QString>(continuationToken);
+
+    d->runReadRequest<QList<Tag>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listTagsPage(
+                flag, errorDescription, pageSize, *nextContinuationToken,
+                order, orderDirection, linkedNotebookGuid);
+        },
+        [=](const QList<Tag> & tags, const ErrorString & errorDescription) {
+            if (tags.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listTagsPageFailed(
+                    flag, pageSize, continuationToken, order, orderDirection,
+                    linkedNotebookGuid, errorDescription, requestId);
+                return;
+            }
 
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
+            if (d->shouldCacheReadResults()) {
+                for (const auto & tag: qAsConst(tags)) {
+                    d->m_pLocalStorageCacheManager->cacheTag(tag);
+                }
+            }
 
-        Q_EMIT listTagsFailed(
-            flag, limit, offset, order, orderDirection, linkedNotebookGuid,
-            error, requestId);
-    }
+            Q_EMIT listTagsPageComplete(
+                flag, pageSize, continuationToken, order, orderDirection,
+                linkedNotebookGuid, tags, *nextContinuationToken, requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't list the page of tags from the local storage: "
+                       "caught exception")));
 }
 
 void LocalStorageManagerAsync::onListTagsWithNoteLocalUidsRequest(
@@ -2308,56 +3189,53 @@ void LocalStorageManagerAsync::onListTagsWithNoteLocalUidsRequest(
     QString linkedNotebookGuid, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        QList<std::pair<Tag, QStringList>> tagsWithNoteLocalUids =
-            d->m_pLocalStorageManager->listTagsWithNoteLocalUids(
+    SCHEDULE_REQUEST(onListTagsWithNoteLocalUidsRequest(
+        flag, limit, offset, order, orderDirection, linkedNotebookGuid,
+        requestId));
+
+    d->runReadRequest<QList<std::pair<Tag, QStringList>>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listTagsWithNoteLocalUids(
                 flag, errorDescription, limit, offset, order, orderDirection,
                 linkedNotebookGuid);
-
-        if (tagsWithNoteLocalUids.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listTagsWithNoteLocalUidsFailed(
-                flag, limit, offset, order, orderDirection, linkedNotebookGuid,
-                errorDescription, requestId);
-        }
-
-        if (d->m_useCache) {
-            // clang-format off
-            SAVE_WARNINGS
-            CLANG_SUPPRESS_WARNING(-Wrange-loop-analysis)
-            // clang-format off
-            for (const auto it: // clazy:exclude=range-loop
-                 qevercloud::toRange(qAsConst(tagsWithNoteLocalUids))) {
-                d->m_pLocalStorageCacheManager->cacheTag(it->first);
+        },
+        [=](const QList<std::pair<Tag, QStringList>> & tagsWithNoteLocalUids,
+            const ErrorString & errorDescription) {
+            if (tagsWithNoteLocalUids.isEmpty() &&
+                !errorDescription.isEmpty())
+            {
+                Q_EMIT listTagsWithNoteLocalUidsFailed(
+                    flag, limit, offset, order, orderDirection,
+                    linkedNotebookGuid, errorDescription, requestId);
             }
-            RESTORE_WARNINGS
-        }
-
-        Q_EMIT listTagsWithNoteLocalUidsComplete(
-            flag, limit, offset, order, orderDirection, linkedNotebookGuid,
-            tagsWithNoteLocalUids, requestId);
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
-            QT_TR_NOOP("Can't list tags with note local uids from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT listTagsWithNoteLocalUidsFailed(
-            flag, limit, offset, order, orderDirection, linkedNotebookGuid,
-            error, requestId);
-    }
+            if (d->shouldCacheReadResults()) {
+                // clang-format off
+                SAVE_WARNINGS
+                CLANG_SUPPRESS_WARNING(-Wrange-loop-analysis)
+                // clang-format off
+                for (const auto it: // clazy:exclude=range-loop
+                     qevercloud::toRange(qAsConst(tagsWithNoteLocalUids))) {
+                    d->m_pLocalStorageCacheManager->cacheTag(it->first);
+                }
+                RESTORE_WARNINGS
+            }
+
+            Q_EMIT listTagsWithNoteLocalUidsComplete(
+                flag, limit, offset, order, orderDirection, linkedNotebookGuid,
+                tagsWithNoteLocalUids, requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't list tags with note local uids from "
+                       "the local storage: caught exception")));
 }
 
 void LocalStorageManagerAsync::onExpungeTagRequest(Tag tag, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(tag), onExpungeTagRequest(tag, requestId));
 
     try {
         ErrorString errorDescription;
@@ -2367,7 +3245,8 @@ void LocalStorageManagerAsync::onExpungeTagRequest(Tag tag, QUuid requestId)
             tag, expungedChildTagLocalUids, errorDescription);
 
         if (!res) {
-            Q_EMIT expungeTagFailed(tag, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                expungeTagFailed(tag, errorDescription, requestId));
             return;
         }
 
@@ -2381,7 +3260,8 @@ void LocalStorageManagerAsync::onExpungeTagRequest(Tag tag, QUuid requestId)
             }
         }
 
-        Q_EMIT expungeTagComplete(tag, expungedChildTagLocalUids, requestId);
+        EMIT_AFTER_COMMIT(
+            expungeTagComplete(tag, expungedChildTagLocalUids, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -2394,7 +3274,7 @@ void LocalStorageManagerAsync::onExpungeTagRequest(Tag tag, QUuid requestId)
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT expungeTagFailed(tag, error, requestId);
+        EMIT_AFTER_COMMIT(expungeTagFailed(tag, error, requestId));
     }
 }
 
@@ -2402,6 +3282,9 @@ void LocalStorageManagerAsync::onExpungeNotelessTagsFromLinkedNotebooksRequest(
     QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        QStringList(),
+        onExpungeNotelessTagsFromLinkedNotebooksRequest(requestId));
 
     try {
         ErrorString errorDescription;
@@ -2410,8 +3293,8 @@ void LocalStorageManagerAsync::onExpungeNotelessTagsFromLinkedNotebooksRequest(
                 errorDescription);
 
         if (!res) {
-            Q_EMIT expungeNotelessTagsFromLinkedNotebooksFailed(
-                errorDescription, requestId);
+            EMIT_AFTER_COMMIT(expungeNotelessTagsFromLinkedNotebooksFailed(
+                errorDescription, requestId));
             return;
         }
 
@@ -2420,7 +3303,8 @@ void LocalStorageManagerAsync::onExpungeNotelessTagsFromLinkedNotebooksRequest(
             d->m_pLocalStorageCacheManager->clearAllResources();
         }
 
-        Q_EMIT expungeNotelessTagsFromLinkedNotebooksComplete(requestId);
+        EMIT_AFTER_COMMIT(
+            expungeNotelessTagsFromLinkedNotebooksComplete(requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -2433,44 +3317,42 @@ void LocalStorageManagerAsync::onExpungeNotelessTagsFromLinkedNotebooksRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT expungeNotelessTagsFromLinkedNotebooksFailed(error, requestId);
+        EMIT_AFTER_COMMIT(
+            expungeNotelessTagsFromLinkedNotebooksFailed(error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onGetResourceCountRequest(QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        int count =
-            d->m_pLocalStorageManager->enResourceCount(errorDescription);
-        if (count < 0) {
-            Q_EMIT getResourceCountFailed(errorDescription, requestId);
-        }
-        else {
-            Q_EMIT getResourceCountComplete(count, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+    const QString coalescingKey = readRequestKey("resourceCount");
+    SCHEDULE_READ_REQUEST(coalescingKey, onGetResourceCountRequest(requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.enResourceCount(errorDescription);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getResourceCountFailed(errorDescription, requestId);
+            }
+            else {
+                Q_EMIT getResourceCountComplete(count, requestId);
+            }
+        },
+        ErrorString(
             QT_TR_NOOP("Can't get resource count from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getResourceCountFailed(error, requestId);
-    }
+                       "the local storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onAddResourceRequest(
     Resource resource, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(resource), onAddResourceRequest(resource, requestId));
 
     try {
         ErrorString errorDescription;
@@ -2479,7 +3361,8 @@ void LocalStorageManagerAsync::onAddResourceRequest(
             resource, errorDescription);
 
         if (!res) {
-            Q_EMIT addResourceFailed(resource, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                addResourceFailed(resource, errorDescription, requestId));
             return;
         }
 
@@ -2487,7 +3370,7 @@ void LocalStorageManagerAsync::onAddResourceRequest(
             d->m_pLocalStorageCacheManager->cacheResource(resource);
         }
 
-        Q_EMIT addResourceComplete(resource, requestId);
+        EMIT_AFTER_COMMIT(addResourceComplete(resource, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -2500,7 +3383,7 @@ void LocalStorageManagerAsync::onAddResourceRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT addResourceFailed(resource, error, requestId);
+        EMIT_AFTER_COMMIT(addResourceFailed(resource, error, requestId));
     }
 }
 
@@ -2508,6 +3391,9 @@ void LocalStorageManagerAsync::onUpdateResourceRequest(
     Resource resource, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(resource),
+        onUpdateResourceRequest(resource, requestId));
 
     try {
         ErrorString errorDescription;
@@ -2516,7 +3402,8 @@ void LocalStorageManagerAsync::onUpdateResourceRequest(
             resource, errorDescription);
 
         if (!res) {
-            Q_EMIT updateResourceFailed(resource, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                updateResourceFailed(resource, errorDescription, requestId));
             return;
         }
 
@@ -2524,7 +3411,7 @@ void LocalStorageManagerAsync::onUpdateResourceRequest(
             d->m_pLocalStorageCacheManager->cacheResource(resource);
         }
 
-        Q_EMIT updateResourceComplete(resource, requestId);
+        EMIT_AFTER_COMMIT(updateResourceComplete(resource, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -2537,7 +3424,7 @@ void LocalStorageManagerAsync::onUpdateResourceRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT updateResourceFailed(resource, error, requestId);
+        EMIT_AFTER_COMMIT(updateResourceFailed(resource, error, requestId));
     }
 }
 
@@ -2546,6 +3433,7 @@ void LocalStorageManagerAsync::onFindResourceRequest(
     QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindResourceRequest(resource, options, requestId));
 
     try {
         ErrorString errorDescription;
@@ -2611,6 +3499,9 @@ void LocalStorageManagerAsync::onExpungeResourceRequest(
     Resource resource, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(resource),
+        onExpungeResourceRequest(resource, requestId));
 
     try {
         ErrorString errorDescription;
@@ -2619,7 +3510,8 @@ void LocalStorageManagerAsync::onExpungeResourceRequest(
             resource, errorDescription);
 
         if (!res) {
-            Q_EMIT expungeResourceFailed(resource, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                expungeResourceFailed(resource, errorDescription, requestId));
             return;
         }
 
@@ -2627,7 +3519,7 @@ void LocalStorageManagerAsync::onExpungeResourceRequest(
             d->m_pLocalStorageCacheManager->expungeResource(resource);
         }
 
-        Q_EMIT expungeResourceComplete(resource, requestId);
+        EMIT_AFTER_COMMIT(expungeResourceComplete(resource, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -2640,44 +3532,42 @@ void LocalStorageManagerAsync::onExpungeResourceRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT expungeResourceFailed(resource, error, requestId);
+        EMIT_AFTER_COMMIT(expungeResourceFailed(resource, error, requestId));
     }
 }
 
 void LocalStorageManagerAsync::onGetSavedSearchCountRequest(QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
-
-    try {
-        ErrorString errorDescription;
-        int count =
-            d->m_pLocalStorageManager->savedSearchCount(errorDescription);
-        if (count < 0) {
-            Q_EMIT getSavedSearchCountFailed(errorDescription, requestId);
-        }
-        else {
-            Q_EMIT getSavedSearchCountComplete(count, requestId);
-        }
-    }
-    catch (const std::exception & e) {
-        ErrorString error(
+    const QString coalescingKey = readRequestKey("savedSearchCount");
+    SCHEDULE_READ_REQUEST(
+        coalescingKey, onGetSavedSearchCountRequest(requestId));
+
+    d->runReadRequest<int>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.savedSearchCount(errorDescription);
+        },
+        [=](const int count, const ErrorString & errorDescription) {
+            if ((count < 0) || !errorDescription.isEmpty()) {
+                Q_EMIT getSavedSearchCountFailed(errorDescription, requestId);
+            }
+            else {
+                Q_EMIT getSavedSearchCountComplete(count, requestId);
+            }
+        },
+        ErrorString(
             QT_TR_NOOP("Can't get saved searches count from "
-                       "the local storage: caught exception"));
-
-        error.details() = QString::fromUtf8(e.what());
-
-        SysInfo sysInfo;
-        QNERROR(
-            "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
-
-        Q_EMIT getSavedSearchCountFailed(error, requestId);
-    }
+                       "the local storage: caught exception")),
+        coalescingKey);
 }
 
 void LocalStorageManagerAsync::onAddSavedSearchRequest(
     SavedSearch search, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(search), onAddSavedSearchRequest(search, requestId));
 
     try {
         ErrorString errorDescription;
@@ -2686,7 +3576,8 @@ void LocalStorageManagerAsync::onAddSavedSearchRequest(
             d->m_pLocalStorageManager->addSavedSearch(search, errorDescription);
 
         if (!res) {
-            Q_EMIT addSavedSearchFailed(search, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                addSavedSearchFailed(search, errorDescription, requestId));
             return;
         }
 
@@ -2694,7 +3585,7 @@ void LocalStorageManagerAsync::onAddSavedSearchRequest(
             d->m_pLocalStorageCacheManager->cacheSavedSearch(search);
         }
 
-        Q_EMIT addSavedSearchComplete(search, requestId);
+        EMIT_AFTER_COMMIT(addSavedSearchComplete(search, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -2707,7 +3598,7 @@ void LocalStorageManagerAsync::onAddSavedSearchRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT addSavedSearchFailed(search, error, requestId);
+        EMIT_AFTER_COMMIT(addSavedSearchFailed(search, error, requestId));
     }
 }
 
@@ -2715,6 +3606,9 @@ void LocalStorageManagerAsync::onUpdateSavedSearchRequest(
     SavedSearch search, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(search),
+        onUpdateSavedSearchRequest(search, requestId));
 
     try {
         ErrorString errorDescription;
@@ -2723,7 +3617,8 @@ void LocalStorageManagerAsync::onUpdateSavedSearchRequest(
             search, errorDescription);
 
         if (!res) {
-            Q_EMIT updateSavedSearchFailed(search, errorDescription, requestId);
+            EMIT_AFTER_COMMIT(
+                updateSavedSearchFailed(search, errorDescription, requestId));
             return;
         }
 
@@ -2731,7 +3626,7 @@ void LocalStorageManagerAsync::onUpdateSavedSearchRequest(
             d->m_pLocalStorageCacheManager->cacheSavedSearch(search);
         }
 
-        Q_EMIT updateSavedSearchComplete(search, requestId);
+        EMIT_AFTER_COMMIT(updateSavedSearchComplete(search, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
@@ -2744,7 +3639,7 @@ void LocalStorageManagerAsync::onUpdateSavedSearchRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT updateSavedSearchFailed(search, error, requestId);
+        EMIT_AFTER_COMMIT(updateSavedSearchFailed(search, error, requestId));
     }
 }
 
@@ -2752,6 +3647,7 @@ void LocalStorageManagerAsync::onFindSavedSearchRequest(
     SavedSearch search, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFindSavedSearchRequest(search, requestId));
 
     try {
         ErrorString errorDescription;
@@ -2819,32 +3715,114 @@ void LocalStorageManagerAsync::onListAllSavedSearchesRequest(
     LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    const QString coalescingKey = readRequestKey(
+        "listAllSavedSearches", limit, offset, order, orderDirection);
+    SCHEDULE_READ_REQUEST(
+        coalescingKey,
+        onListAllSavedSearchesRequest(
+            limit, offset, order, orderDirection, requestId));
+
+    d->runReadRequest<QList<SavedSearch>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listAllSavedSearches(
+                errorDescription, limit, offset, order, orderDirection);
+        },
+        [=](const QList<SavedSearch> & savedSearches,
+            const ErrorString & errorDescription) {
+            if (savedSearches.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listAllSavedSearchesFailed(
+                    limit, offset, order, orderDirection, errorDescription,
+                    requestId);
+                return;
+            }
+
+            if (d->shouldCacheReadResults()) {
+                for (const auto & savedSearch: qAsConst(savedSearches)) {
+                    d->m_pLocalStorageCacheManager->cacheSavedSearch(
+                        savedSearch);
+                }
+            }
+
+            Q_EMIT listAllSavedSearchesComplete(
+                limit, offset, order, orderDirection, savedSearches, requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't list all saved searches from "
+                       "the local storage: caught exception")),
+        coalescingKey);
+}
+
+void LocalStorageManagerAsync::onListSavedSearchesRequest(
+    LocalStorageManager::ListObjectsOptions flag, size_t limit, size_t offset,
+    LocalStorageManager::ListSavedSearchesOrder order,
+    LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onListSavedSearchesRequest(
+        flag, limit, offset, order, orderDirection, requestId));
+
+    d->runReadRequest<QList<SavedSearch>>(
+        [=](LocalStorageManager & localStorageManager,
+            ErrorString & errorDescription) {
+            return localStorageManager.listSavedSearches(
+                flag, errorDescription, limit, offset, order, orderDirection);
+        },
+        [=](const QList<SavedSearch> & savedSearches,
+            const ErrorString & errorDescription) {
+            if (savedSearches.isEmpty() && !errorDescription.isEmpty()) {
+                Q_EMIT listSavedSearchesFailed(
+                    flag, limit, offset, order, orderDirection,
+                    errorDescription, requestId);
+
+                return;
+            }
+
+            if (d->shouldCacheReadResults()) {
+                for (const auto & savedSearch: qAsConst(savedSearches)) {
+                    d->m_pLocalStorageCacheManager->cacheSavedSearch(
+                        savedSearch);
+                }
+            }
+
+            Q_EMIT listSavedSearchesComplete(
+                flag, limit, offset, order, orderDirection, savedSearches,
+                requestId);
+        },
+        ErrorString(
+            QT_TR_NOOP("Can't list all saved searches from "
+                       "the local storage: caught exception")));
+}
+
+void LocalStorageManagerAsync::onExpungeSavedSearchRequest(
+    SavedSearch search, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_WRITE_REQUEST(
+        writeRequestKeys(search),
+        onExpungeSavedSearchRequest(search, requestId));
 
     try {
         ErrorString errorDescription;
-        QList<SavedSearch> savedSearches =
-            d->m_pLocalStorageManager->listAllSavedSearches(
-                errorDescription, limit, offset, order, orderDirection);
 
-        if (savedSearches.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listAllSavedSearchesFailed(
-                limit, offset, order, orderDirection, errorDescription,
-                requestId);
+        bool res = d->m_pLocalStorageManager->expungeSavedSearch(
+            search, errorDescription);
+
+        if (!res) {
+            EMIT_AFTER_COMMIT(
+                expungeSavedSearchFailed(search, errorDescription, requestId));
             return;
         }
 
         if (d->m_useCache) {
-            for (const auto & savedSearch: qAsConst(savedSearches)) {
-                d->m_pLocalStorageCacheManager->cacheSavedSearch(savedSearch);
-            }
+            d->m_pLocalStorageCacheManager->expungeSavedSearch(search);
         }
 
-        Q_EMIT listAllSavedSearchesComplete(
-            limit, offset, order, orderDirection, savedSearches, requestId);
+        EMIT_AFTER_COMMIT(expungeSavedSearchComplete(search, requestId));
     }
     catch (const std::exception & e) {
         ErrorString error(
-            QT_TR_NOOP("Can't list all saved searches from "
+            QT_TR_NOOP("Can't expunge saved search from "
                        "the local storage: caught exception"));
 
         error.details() = QString::fromUtf8(e.what());
@@ -2853,45 +3831,34 @@ void LocalStorageManagerAsync::onListAllSavedSearchesRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT listAllSavedSearchesFailed(
-            limit, offset, order, orderDirection, error, requestId);
+        EMIT_AFTER_COMMIT(expungeSavedSearchFailed(search, error, requestId));
     }
 }
 
-void LocalStorageManagerAsync::onListSavedSearchesRequest(
-    LocalStorageManager::ListObjectsOptions flag, size_t limit, size_t offset,
-    LocalStorageManager::ListSavedSearchesOrder order,
-    LocalStorageManager::OrderDirection orderDirection, QUuid requestId)
+void LocalStorageManagerAsync::onAccountHighUsnRequest(
+    QString linkedNotebookGuid, QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onAccountHighUsnRequest(linkedNotebookGuid, requestId));
 
     try {
         ErrorString errorDescription;
-        QList<SavedSearch> savedSearches =
-            d->m_pLocalStorageManager->listSavedSearches(
-                flag, errorDescription, limit, offset, order, orderDirection);
 
-        if (savedSearches.isEmpty() && !errorDescription.isEmpty()) {
-            Q_EMIT listSavedSearchesFailed(
-                flag, limit, offset, order, orderDirection, errorDescription,
-                requestId);
+        qint32 updateSequenceNumber = d->m_pLocalStorageManager->accountHighUsn(
+            linkedNotebookGuid, errorDescription);
 
+        if (updateSequenceNumber < 0) {
+            Q_EMIT accountHighUsnFailed(
+                linkedNotebookGuid, errorDescription, requestId);
             return;
         }
 
-        if (d->m_useCache) {
-            for (const auto & savedSearch: qAsConst(savedSearches)) {
-                d->m_pLocalStorageCacheManager->cacheSavedSearch(savedSearch);
-            }
-        }
-
-        Q_EMIT listSavedSearchesComplete(
-            flag, limit, offset, order, orderDirection, savedSearches,
-            requestId);
+        Q_EMIT accountHighUsnComplete(
+            updateSequenceNumber, linkedNotebookGuid, requestId);
     }
     catch (const std::exception & e) {
         ErrorString error(
-            QT_TR_NOOP("Can't list all saved searches from "
+            QT_TR_NOOP("Can't get account high USN from "
                        "the local storage: caught exception"));
 
         error.details() = QString::fromUtf8(e.what());
@@ -2900,38 +3867,33 @@ void LocalStorageManagerAsync::onListSavedSearchesRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT listSavedSearchesFailed(
-            flag, limit, offset, order, orderDirection, error, requestId);
+        Q_EMIT accountHighUsnFailed(linkedNotebookGuid, error, requestId);
     }
 }
 
-void LocalStorageManagerAsync::onExpungeSavedSearchRequest(
-    SavedSearch search, QUuid requestId)
+void LocalStorageManagerAsync::onFreePageStatisticsRequest(QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onFreePageStatisticsRequest(requestId));
 
     try {
         ErrorString errorDescription;
+        LocalStorageManager::FreePageStatistics statistics;
 
-        bool res = d->m_pLocalStorageManager->expungeSavedSearch(
-            search, errorDescription);
+        bool res = d->m_pLocalStorageManager->freePageStatistics(
+            statistics, errorDescription);
 
         if (!res) {
-            Q_EMIT expungeSavedSearchFailed(
-                search, errorDescription, requestId);
+            Q_EMIT freePageStatisticsFailed(errorDescription, requestId);
             return;
         }
 
-        if (d->m_useCache) {
-            d->m_pLocalStorageCacheManager->expungeSavedSearch(search);
-        }
-
-        Q_EMIT expungeSavedSearchComplete(search, requestId);
+        Q_EMIT freePageStatisticsComplete(statistics, requestId);
     }
     catch (const std::exception & e) {
         ErrorString error(
-            QT_TR_NOOP("Can't expunge saved search from "
-                       "the local storage: caught exception"));
+            QT_TR_NOOP("Can't get free page statistics from the local "
+                       "storage: caught exception"));
 
         error.details() = QString::fromUtf8(e.what());
 
@@ -2939,34 +3901,39 @@ void LocalStorageManagerAsync::onExpungeSavedSearchRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT expungeSavedSearchFailed(search, error, requestId);
+        Q_EMIT freePageStatisticsFailed(error, requestId);
     }
 }
 
-void LocalStorageManagerAsync::onAccountHighUsnRequest(
-    QString linkedNotebookGuid, QUuid requestId)
+void LocalStorageManagerAsync::onSetPerformanceProfileRequest(
+    LocalStorageManager::PerformanceProfile performanceProfile,
+    QUuid requestId)
 {
     Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(
+        onSetPerformanceProfileRequest(performanceProfile, requestId));
 
     try {
         ErrorString errorDescription;
 
-        qint32 updateSequenceNumber = d->m_pLocalStorageManager->accountHighUsn(
-            linkedNotebookGuid, errorDescription);
+        bool res = d->m_pLocalStorageManager->setPerformanceProfile(
+            performanceProfile, errorDescription);
 
-        if (updateSequenceNumber < 0) {
-            Q_EMIT accountHighUsnFailed(
-                linkedNotebookGuid, errorDescription, requestId);
+        if (!res) {
+            Q_EMIT setPerformanceProfileFailed(
+                performanceProfile, errorDescription, requestId);
             return;
         }
 
-        Q_EMIT accountHighUsnComplete(
-            updateSequenceNumber, linkedNotebookGuid, requestId);
+        // Read-only connections opened from now on would use the new profile
+        d->m_performanceProfile = performanceProfile;
+
+        Q_EMIT setPerformanceProfileComplete(performanceProfile, requestId);
     }
     catch (const std::exception & e) {
         ErrorString error(
-            QT_TR_NOOP("Can't get account high USN from "
-                       "the local storage: caught exception"));
+            QT_TR_NOOP("Can't apply the performance profile to the local "
+                       "storage: caught exception"));
 
         error.details() = QString::fromUtf8(e.what());
 
@@ -2974,8 +3941,309 @@ void LocalStorageManagerAsync::onAccountHighUsnRequest(
         QNERROR(
             "local_storage", error << "; backtrace: " << sysInfo.stackTrace());
 
-        Q_EMIT accountHighUsnFailed(linkedNotebookGuid, error, requestId);
+        Q_EMIT setPerformanceProfileFailed(
+            performanceProfile, error, requestId);
+    }
+}
+
+void LocalStorageManagerAsync::onCreateSnapshotRequest(
+    QString snapshotDirPath, QUuid requestId)
+{
+    Q_D(LocalStorageManagerAsync);
+    SCHEDULE_REQUEST(onCreateSnapshotRequest(snapshotDirPath, requestId));
+
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerAsync::onCreateSnapshotRequest: snapshot dir "
+            << "path = " << snapshotDirPath << ", request id = " << requestId);
+
+    auto * pThread = new QThread;
+
+    auto * pSnapshotMaker =
+        new LocalStorageSnapshotMaker(d->m_account, snapshotDirPath, requestId);
+
+    pSnapshotMaker->moveToThread(pThread);
+
+    QObject::connect(
+        pThread, &QThread::started, pSnapshotMaker,
+        &LocalStorageSnapshotMaker::start);
+
+    QObject::connect(
+        pSnapshotMaker, &LocalStorageSnapshotMaker::progress, this,
+        &LocalStorageManagerAsync::createSnapshotProgress);
+
+    QObject::connect(
+        pSnapshotMaker, &LocalStorageSnapshotMaker::finished, this,
+        [this](
+            const QString & dirPath, const ErrorString & errorDescription,
+            const QUuid & id) {
+            if (errorDescription.isEmpty()) {
+                Q_EMIT createSnapshotComplete(dirPath, id);
+            }
+            else {
+                Q_EMIT createSnapshotFailed(dirPath, errorDescription, id);
+            }
+        });
+
+    QObject::connect(
+        pSnapshotMaker, &LocalStorageSnapshotMaker::finished, pThread,
+        &QThread::quit);
+
+    QObject::connect(
+        pThread, &QThread::finished, pSnapshotMaker,
+        &LocalStorageSnapshotMaker::deleteLater);
+
+    QObject::connect(
+        pThread, &QThread::finished, pThread, &QThread::deleteLater);
+
+    pThread->start();
+}
+
+void LocalStorageManagerAsync::checkNoteChangesToTrack(
+    const LocalStorageManager::UpdateNoteOptions options,
+    bool & shouldCheckForNotebookChange,
+    bool & shouldCheckForTagListUpdate) const
+{
+    shouldCheckForNotebookChange = false;
+    shouldCheckForTagListUpdate = false;
+
+    static const QMetaMethod noteMovedToAnotherNotebookSignal =
+        QMetaMethod::fromSignal(
+            &LocalStorageManagerAsync::noteMovedToAnotherNotebook);
+    if (isSignalConnected(noteMovedToAnotherNotebookSignal)) {
+        shouldCheckForNotebookChange = true;
+    }
+
+    if (options & LocalStorageManager::UpdateNoteOption::UpdateTags) {
+        static const QMetaMethod noteTagListChangedSignal =
+            QMetaMethod::fromSignal(
+                &LocalStorageManagerAsync::noteTagListChanged);
+        if (isSignalConnected(noteTagListChangedSignal)) {
+            shouldCheckForTagListUpdate = true;
+        }
+    }
+}
+
+bool LocalStorageManagerAsync::findPreviousNoteVersion(
+    const Note & note, Note & previousNoteVersion,
+    ErrorString & errorDescription)
+{
+    Q_D(LocalStorageManagerAsync);
+
+    if (d->m_useCache) {
+        const Note * pNote = nullptr;
+
+        if (note.hasGuid()) {
+            pNote = d->m_pLocalStorageCacheManager->findNote(
+                note.guid(), LocalStorageCacheManager::WhichUid::Guid);
+        }
+
+        if (!pNote) {
+            pNote = d->m_pLocalStorageCacheManager->findNote(
+                note.localUid(), LocalStorageCacheManager::WhichUid::LocalUid);
+        }
+
+        if (pNote) {
+            previousNoteVersion = *pNote;
+            return true;
+        }
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    LocalStorageManager::GetNoteOptions getNoteOptions;
+#else
+    LocalStorageManager::GetNoteOptions getNoteOptions(0);
+#endif
+    bool res = false;
+
+    if (note.hasGuid()) {
+        // Try to find note by guid first
+        previousNoteVersion.setGuid(note.guid());
+        res = d->m_pLocalStorageManager->findNote(
+            previousNoteVersion, getNoteOptions, errorDescription);
+    }
+
+    if (!res) {
+        previousNoteVersion.setLocalUid(note.localUid());
+        previousNoteVersion.setGuid(QString());
+        res = d->m_pLocalStorageManager->findNote(
+            previousNoteVersion, getNoteOptions, errorDescription);
+    }
+
+    return res;
+}
+
+void LocalStorageManagerAsync::cacheUpdatedNote(
+    const Note & note, const LocalStorageManager::UpdateNoteOptions options)
+{
+    Q_D(LocalStorageManagerAsync);
+
+    if (!d->m_useCache) {
+        return;
+    }
+
+    if ((options &
+         LocalStorageManager::UpdateNoteOption::UpdateResourceMetadata) &&
+        (options & LocalStorageManager::UpdateNoteOption::UpdateTags))
+    {
+        Note noteForCaching = note;
+        QList<Resource> resourcesForCaching;
+        splitNoteAndResourcesForCaching(noteForCaching, resourcesForCaching);
+
+        d->m_pLocalStorageCacheManager->cacheNote(noteForCaching);
+
+        if (options &
+            LocalStorageManager::UpdateNoteOption::UpdateResourceBinaryData) {
+            for (const auto & resource: qAsConst(resourcesForCaching)) {
+                d->m_pLocalStorageCacheManager->cacheResource(resource);
+            }
+        }
+        else {
+            // Since resources metadata might have changed, it would become
+            // stale within the cache so need to remove it from there
+            for (const auto & resource: qAsConst(resourcesForCaching)) {
+                d->m_pLocalStorageCacheManager->expungeResource(resource);
+            }
+        }
+    }
+    else {
+        // The note was somehow changed but the resources or tags information
+        // was not updated => the note in the cache is stale/incomplete in
+        // either case, need to remove it from there
+        d->m_pLocalStorageCacheManager->expungeNote(note);
+
+        // Same goes for its resources
+        QList<Resource> resources = note.resources();
+        for (const auto & resource: qAsConst(resources)) {
+            d->m_pLocalStorageCacheManager->expungeResource(resource);
+        }
+    }
+}
+
+void LocalStorageManagerAsync::notifyNoteChanges(
+    const Note & note, const Note & previousNoteVersion,
+    const bool shouldCheckForNotebookChange,
+    const bool shouldCheckForTagListUpdate)
+{
+    Q_D(LocalStorageManagerAsync);
+
+    if (shouldCheckForNotebookChange) {
+        bool notebookChanged = false;
+        if (note.hasNotebookGuid() && previousNoteVersion.hasNotebookGuid()) {
+            notebookChanged =
+                (note.notebookGuid() != previousNoteVersion.notebookGuid());
+        }
+        else {
+            notebookChanged =
+                (note.notebookLocalUid() !=
+                 previousNoteVersion.notebookLocalUid());
+        }
+
+        if (notebookChanged) {
+            QNDEBUG(
+                "local_storage",
+                "Notebook change detected for note "
+                    << note.localUid() << ": moved from notebook "
+                    << previousNoteVersion.notebookLocalUid()
+                    << " to notebook " << note.notebookLocalUid());
+
+            EMIT_AFTER_COMMIT(noteMovedToAnotherNotebook(
+                note.localUid(), previousNoteVersion.notebookLocalUid(),
+                note.notebookLocalUid()));
+        }
+    }
+
+    if (shouldCheckForTagListUpdate) {
+        const QStringList & previousTagLocalUids =
+            previousNoteVersion.tagLocalUids();
+
+        const QStringList & updatedTagLocalUids = note.tagLocalUids();
+
+        bool tagListUpdated =
+            (previousTagLocalUids.size() != updatedTagLocalUids.size());
+
+        if (!tagListUpdated) {
+            for (const auto & prevTagLocalUid: qAsConst(previousTagLocalUids)) {
+                int index = updatedTagLocalUids.indexOf(prevTagLocalUid);
+                if (index < 0) {
+                    tagListUpdated = true;
+                    break;
+                }
+            }
+        }
+
+        if (tagListUpdated) {
+            QNDEBUG(
+                "local_storage",
+                "Tags list update detected for note "
+                    << note.localUid() << ": previous tag local uids: "
+                    << previousTagLocalUids.join(QStringLiteral(", "))
+                    << "; updated tag local uids: "
+                    << updatedTagLocalUids.join(QStringLiteral(",")));
+
+            EMIT_AFTER_COMMIT(noteTagListChanged(
+                note.localUid(), previousTagLocalUids, updatedTagLocalUids));
+        }
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+template <typename T>
+T & printRequestPriority(
+    T & t, const LocalStorageManagerAsync::RequestPriority priority)
+{
+    using RequestPriority = LocalStorageManagerAsync::RequestPriority;
+
+    switch (priority) {
+    case RequestPriority::Interactive:
+        t << "Interactive";
+        break;
+    case RequestPriority::Background:
+        t << "Background";
+        break;
+    case RequestPriority::Bulk:
+        t << "Bulk";
+        break;
+    default:
+        t << "Unknown (" << static_cast<qint64>(priority) << ")";
+        break;
+    }
+
+    return t;
+}
+
+} // namespace
+
+QTextStream & operator<<(
+    QTextStream & strm,
+    const LocalStorageManagerAsync::RequestPriority priority)
+{
+    return printRequestPriority(strm, priority);
+}
+
+QDebug & operator<<(
+    QDebug & dbg, const LocalStorageManagerAsync::RequestPriority priority)
+{
+    return printRequestPriority(dbg, priority);
+}
+
+QTextStream & LocalStorageManagerAsync::RequestQueueStatistics::print(
+    QTextStream & strm) const
+{
+    strm << "RequestQueueStatistics: {\n"
+         << "  priority: " << m_priority << ";\n"
+         << "  queue depth: " << m_queueDepth << ";\n"
+         << "  max queue depth: " << m_maxQueueDepth << ";\n"
+         << "  processed request count: " << m_processedRequestCount << ";\n"
+         << "  total wait duration (usec): " << m_totalWaitDurationUsec
+         << ";\n"
+         << "  max wait duration (usec): " << m_maxWaitDurationUsec << "\n"
+         << "};\n";
+
+    return strm;
+}
+
 } // namespace quentier
@@ -38,13 +38,22 @@
 #include <quentier/utility/UidGenerator.h>
 
 #include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QSqlRecord>
 
 #include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <limits>
 #include <memory>
 
 namespace quentier {
@@ -53,6 +62,30 @@ namespace quentier {
 
 #define QUENTIER_DATABASE_NAME "qn.storage.sqlite"
 
+// Max number of values bound to a single SQL query; SQLite's default limit
+// on the number of host parameters is 999
+#define MAX_SQL_QUERY_BOUND_VALUES (500)
+
+// Resource data files smaller than this are read into memory even when mapping
+// is requested: mapping small files doesn't save much memory but keeps a file
+// descriptor open per mapped file
+#define MIN_MAPPED_RESOURCE_FILE_SIZE (64 * 1024)
+
+// Max number of compiled note search queries kept for reuse
+#define MAX_COMPILED_NOTE_SEARCH_QUERIES (32)
+
+// Max number of snapshots of notes' persisted state kept for partial updates
+// of the notes
+#define MAX_NOTE_LOCAL_STORAGE_SNAPSHOTS (32)
+
+// Size of chunks in which resource data is streamed from QIODevice to
+// the blob store
+#define RESOURCE_BLOB_STREAMING_CHUNK_SIZE (1024 * 1024)
+
+// Number of free pages reclaimed per step of incremental vacuum; the time
+// budget of reclaimFreePages is checked between the steps
+#define INCREMENTAL_VACUUM_PAGES_PER_STEP (64)
+
 ////////////////////////////////////////////////////////////////////////////////
 
 using GetNoteOption = LocalStorageManager::GetNoteOption;
@@ -73,6 +106,10 @@ using ListObjectsOptions = LocalStorageManager::ListObjectsOptions;
 using NoteCountOption = LocalStorageManager::NoteCountOption;
 using NoteCountOptions = LocalStorageManager::NoteCountOptions;
 
+using NoteSummary = LocalStorageManager::NoteSummary;
+using NoteSummaryField = LocalStorageManager::NoteSummaryField;
+using NoteSummaryFields = LocalStorageManager::NoteSummaryFields;
+
 using OrderDirection = LocalStorageManager::OrderDirection;
 
 using StartupOption = LocalStorageManager::StartupOption;
@@ -83,10 +120,84 @@ using UpdateNoteOptions = LocalStorageManager::UpdateNoteOptions;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Numbers of snapshots being taken per database file path within this process;
+// resource data blob files are not removed while a snapshot of the database
+// referencing them is being taken
+struct SnapshotsInProgress
+{
+    QMutex m_mutex;
+    QHash<QString, int> m_counts;
+};
+
+SnapshotsInProgress & snapshotsInProgress()
+{
+    static SnapshotsInProgress snapshots;
+    return snapshots;
+}
+
+bool snapshotInProgress(const QString & databaseFilePath)
+{
+    auto & snapshots = snapshotsInProgress();
+    QMutexLocker lock(&snapshots.m_mutex);
+    return snapshots.m_counts.value(databaseFilePath, 0) > 0;
+}
+
+class SnapshotInProgressGuard
+{
+public:
+    explicit SnapshotInProgressGuard(QString databaseFilePath) :
+        m_databaseFilePath(std::move(databaseFilePath))
+    {
+        auto & snapshots = snapshotsInProgress();
+        QMutexLocker lock(&snapshots.m_mutex);
+        ++snapshots.m_counts[m_databaseFilePath];
+    }
+
+    ~SnapshotInProgressGuard()
+    {
+        auto & snapshots = snapshotsInProgress();
+        QMutexLocker lock(&snapshots.m_mutex);
+        auto it = snapshots.m_counts.find(m_databaseFilePath);
+        if ((it != snapshots.m_counts.end()) && (--it.value() <= 0)) {
+            snapshots.m_counts.erase(it);
+        }
+    }
+
+private:
+    QString m_databaseFilePath;
+};
+
+// Statements beginning and ending transactions and savepoints have no query
+// plans to capture
+bool isTransactionControlQuery(const QString & normalizedQuery)
+{
+    static const QStringList keywords = QStringList()
+        << QStringLiteral("BEGIN") << QStringLiteral("COMMIT")
+        << QStringLiteral("END") << QStringLiteral("ROLLBACK")
+        << QStringLiteral("SAVEPOINT") << QStringLiteral("RELEASE");
+
+    for (const auto & keyword: qAsConst(keywords)) {
+        if (normalizedQuery.startsWith(keyword, Qt::CaseInsensitive)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
 LocalStorageManagerPrivate::LocalStorageManagerPrivate(
-    const Account & account, const StartupOptions options, QObject * parent) :
+    const Account & account, const StartupOptions options,
+    const LocalStorageManager::PerformanceProfile & performanceProfile,
+    QObject * parent) :
     QObject(parent),
-    m_currentAccount(account)
+    m_currentAccount(account), m_performanceProfile(performanceProfile),
+    m_noteLocalStorageSnapshots(MAX_NOTE_LOCAL_STORAGE_SNAPSHOTS)
 {
     m_preservedAsterisk.reserve(1);
     m_preservedAsterisk.push_back(QChar::fromLatin1('*'));
@@ -96,10 +207,22 @@ LocalStorageManagerPrivate::LocalStorageManagerPrivate(
 
 LocalStorageManagerPrivate::~LocalStorageManagerPrivate()
 {
+    // Uncommitted write group is rolled back
+    m_pWriteGroupTransaction.reset();
+
     if (m_sqlDatabase.isOpen()) {
         m_sqlDatabase.close();
     }
 
+    if (m_readOnly) {
+        // Read-only connections are created per instance so need to be
+        // removed along with it
+        clearCachedQueries();
+        QString sqlDatabaseConnectionName = m_sqlDatabase.connectionName();
+        m_sqlDatabase = QSqlDatabase();
+        QSqlDatabase::removeDatabase(sqlDatabaseConnectionName);
+    }
+
     unlockDatabaseFile();
 }
 
@@ -236,7 +359,7 @@ bool LocalStorageManagerPrivate::findUser(
 
     query.bindValue(QStringLiteral(":id"), userId);
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     size_t counter = 0;
@@ -289,7 +412,7 @@ bool LocalStorageManagerPrivate::deleteUser(
     query.bindValue(QStringLiteral(":userIsLocal"), (user.isLocal() ? 1 : 0));
     query.bindValue(QStringLiteral(":id"), user.id());
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -317,7 +440,7 @@ bool LocalStorageManagerPrivate::expungeUser(
     QString userId = QString::number(id);
     query.bindValue(QStringLiteral(":id"), userId);
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -357,7 +480,7 @@ int LocalStorageManagerPrivate::notebookCount(
         return -1;
     }
 
-    res = query.exec();
+    res = execQuery(query);
     if (!res) {
         SET_ERROR();
         return -1;
@@ -413,6 +536,15 @@ void LocalStorageManagerPrivate::switchUser(
     }
 
     m_currentAccount = account;
+    m_readOnly = (options & StartupOption::ReadOnly);
+
+    // Read-only connections can't observe the writes made by other ones so
+    // the guid index would go stale there
+    m_guidLocalUidIndex.clear();
+    m_noteLocalStorageSnapshots.clear();
+    if (m_readOnly) {
+        m_guidLocalUidIndex.setEnabled(false);
+    }
 
     QString sqlDriverName = QStringLiteral("QSQLITE");
     bool isSqlDriverAvailable = QSqlDatabase::isDriverAvailable(sqlDriverName);
@@ -434,6 +566,19 @@ void LocalStorageManagerPrivate::switchUser(
     QString sqlDatabaseConnectionName =
         QStringLiteral("quentier_sqlite_connection");
 
+    if (m_readOnly) {
+        // QSqlDatabase connection can only be used from the thread which has
+        // created it so each read-only local storage manager needs its own one
+        sqlDatabaseConnectionName = m_sqlDatabase.connectionName();
+        if (sqlDatabaseConnectionName.isEmpty()) {
+            static QAtomicInt readOnlyConnectionCounter;
+            sqlDatabaseConnectionName =
+                QStringLiteral("quentier_sqlite_read_only_connection_") +
+                QString::number(
+                    readOnlyConnectionCounter.fetchAndAddOrdered(1));
+        }
+    }
+
     if (!QSqlDatabase::contains(sqlDatabaseConnectionName)) {
         m_sqlDatabase =
             QSqlDatabase::addDatabase(sqlDriverName, sqlDatabaseConnectionName);
@@ -493,67 +638,25 @@ void LocalStorageManagerPrivate::switchUser(
             throw DatabaseOpeningException(error);
         }
     }
+    else if (m_readOnly) {
+        ErrorString error(
+            QT_TR_NOOP("Can't open the local storage database in read-only "
+                       "mode: database file doesn't exist"));
+        error.details() = m_databaseFilePath;
+        throw DatabaseOpeningException(error);
+    }
     else {
         // The file needs to exist in order to lock it
         clearDatabaseFile();
     }
 
-    /**
-     * NOTE: it appears boost::interprocess::file_lock applied to the database
-     * file on Windows causes the inability to properly open the database.
-     * The reason for this is not clear so for now just disable the use of
-     * boost::interprocess::file_lock on Windows. It's not a major problem
-     * because Windows won't let another process to open the file being worked
-     * with by another process
-     */
-#ifndef Q_OS_WIN
-    /**
-     * WARNING: something strange is going on here: if no call is made to the
-     * below method, boost::interprocess::file_lock occasionally and
-     * sporadically thinks "there is no such file or directory"; that's what
-     * its exception message says
-     */
-    bool databaseFileExists = databaseFileInfo.exists();
-    QNDEBUG(
-        "local_storage",
-        "Database file exists before locking: "
-            << (databaseFileExists ? "true" : "false"));
-
-    bool lockResult = false;
-
-    try {
-        boost::interprocess::file_lock databaseLock(
-            databaseFileInfo.canonicalFilePath().toUtf8().constData());
-
-        m_databaseFileLock.swap(databaseLock);
-        lockResult = m_databaseFileLock.try_lock();
-    }
-    catch (boost::interprocess::interprocess_exception & exc) {
-        ErrorString error(QT_TR_NOOP("Can't lock the database file"));
-        error.details() = QStringLiteral("error code ");
-        error.details() += QString::number(exc.get_error_code());
-        error.details() += QStringLiteral("; ");
-        error.details() += QString::fromUtf8(exc.what());
-        throw DatabaseLockFailedException(error);
-    }
-
-    if (!lockResult) {
-        if (!(options & StartupOption::OverrideLock)) {
-            ErrorString error(
-                QT_TR_NOOP("Local storage database file is locked"));
-            error.details() = m_databaseFilePath;
-            throw DatabaseLockedException(error);
-        }
-        else {
-            QNINFO(
-                "local_storage",
-                "Local storage database file "
-                    << m_databaseFilePath << " is locked but nobody cares");
-        }
+    // Read-only local storage managers work alongside the one which has
+    // the database file locked
+    if (!m_readOnly) {
+        lockDatabaseFile(databaseFileInfo, options);
     }
-#endif // Q_OS_WIN
 
-    if (options & StartupOption::ClearDatabase) {
+    if ((options & StartupOption::ClearDatabase) && !m_readOnly) {
         QNDEBUG(
             "local_storage",
             "Cleaning up the whole database for account: " << m_currentAccount);
@@ -565,6 +668,9 @@ void LocalStorageManagerPrivate::switchUser(
     m_sqlDatabase.setPassword(accountName);
     m_sqlDatabase.setDatabaseName(m_databaseFilePath);
 
+    m_sqlDatabase.setConnectOptions(
+        m_readOnly ? QStringLiteral("QSQLITE_OPEN_READONLY") : QString());
+
     if (!m_sqlDatabase.open()) {
         QString lastErrorText = m_sqlDatabase.lastError().text();
         ErrorString error(
@@ -583,6 +689,35 @@ void LocalStorageManagerPrivate::switchUser(
         throw DatabaseRequestException(error);
     }
 
+    ErrorString performanceProfileError;
+    if (!applyPerformanceProfile(
+            m_performanceProfile, performanceProfileError))
+    {
+        throw DatabaseRequestException(performanceProfileError);
+    }
+
+    ErrorString noteLocationIndexError;
+    if (!checkNoteLocationIndexAvailability(noteLocationIndexError)) {
+        throw DatabaseRequestException(noteLocationIndexError);
+    }
+
+    if (m_readOnly) {
+        // The rest of the setup is done through the primary connection
+        clearCachedQueries();
+        return;
+    }
+
+    // Has effect only for the newly created database: the existing one is
+    // switched to incremental vacuum by LocalStoragePatch5To6
+    if (!query.exec(QStringLiteral("PRAGMA auto_vacuum = INCREMENTAL"))) {
+        QString lastErrorText = m_sqlDatabase.lastError().text();
+        ErrorString error(
+            QT_TR_NOOP("Can't set auto_vacuum pragma to INCREMENTAL for "
+                       "the local storage database"));
+        error.details() = lastErrorText;
+        throw DatabaseRequestException(error);
+    }
+
     SysInfo sysInfo;
     qint64 pageSize = sysInfo.pageSize();
 
@@ -619,6 +754,92 @@ void LocalStorageManagerPrivate::switchUser(
     }
 
     clearCachedQueries();
+
+    errorDescription.clear();
+    if (!collectResourceBlobsGarbage(errorDescription)) {
+        QNWARNING(
+            "local_storage",
+            "Failed to collect the garbage within resource data blob store: "
+                << errorDescription);
+    }
+}
+
+LocalStorageManager::PerformanceProfile
+LocalStorageManagerPrivate::performanceProfile() const
+{
+    return m_performanceProfile;
+}
+
+bool LocalStorageManagerPrivate::setPerformanceProfile(
+    const LocalStorageManager::PerformanceProfile & performanceProfile,
+    ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::setPerformanceProfile: "
+            << performanceProfile);
+
+    // SQLite doesn't allow changing synchronous pragma within a transaction
+    if (Q_UNLIKELY(m_transactionNestingLevel > 0)) {
+        errorDescription.setBase(
+            QT_TR_NOOP("Can't apply the performance profile to the local "
+                       "storage: a transaction is open"));
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    if (!applyPerformanceProfile(performanceProfile, errorDescription)) {
+        // Pragmas applied before the failed one should be reverted
+        ErrorString error;
+        if (!applyPerformanceProfile(m_performanceProfile, error)) {
+            QNWARNING(
+                "local_storage",
+                "Failed to restore the previous performance profile: "
+                    << error);
+        }
+
+        return false;
+    }
+
+    m_performanceProfile = performanceProfile;
+    return true;
+}
+
+bool LocalStorageManagerPrivate::applyPerformanceProfile(
+    const LocalStorageManager::PerformanceProfile & performanceProfile,
+    ErrorString & errorDescription)
+{
+    const QStringList queries = QStringList()
+        << QString::fromUtf8("PRAGMA synchronous = %1")
+               .arg(static_cast<int>(performanceProfile.m_synchronous))
+        << QString::fromUtf8("PRAGMA cache_size = %1")
+               .arg(performanceProfile.m_cacheSize)
+        << QString::fromUtf8("PRAGMA mmap_size = %1")
+               .arg(performanceProfile.m_mmapSize)
+        << QString::fromUtf8("PRAGMA temp_store = %1")
+               .arg(static_cast<int>(performanceProfile.m_tempStore))
+        << QString::fromUtf8("PRAGMA wal_autocheckpoint = %1")
+               .arg(performanceProfile.m_walAutocheckpoint)
+        << QString::fromUtf8("PRAGMA busy_timeout = %1")
+               .arg(performanceProfile.m_busyTimeoutMsec);
+
+    QSqlQuery query(m_sqlDatabase);
+    for (const auto & queryString: qAsConst(queries)) {
+        if (!execQuery(query, queryString)) {
+            errorDescription.setBase(
+                QT_TR_NOOP("Can't apply the performance profile to the local "
+                           "storage database"));
+            errorDescription.details() = queryString;
+            errorDescription.details() += QStringLiteral(": ");
+            errorDescription.details() += query.lastError().text();
+            QNWARNING("local_storage", errorDescription);
+            return false;
+        }
+
+        query.finish();
+    }
+
+    return true;
 }
 
 bool LocalStorageManagerPrivate::isLocalStorageVersionTooHigh(
@@ -665,7 +886,7 @@ qint32 LocalStorageManagerPrivate::localStorageVersion(
         QStringLiteral("SELECT version FROM Auxiliary LIMIT 1");
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     if (Q_UNLIKELY(!res)) {
         errorDescription.setBase(
             QT_TR_NOOP("failed to execute SQL query checking whether "
@@ -700,7 +921,7 @@ qint32 LocalStorageManagerPrivate::localStorageVersion(
 
 qint32 LocalStorageManagerPrivate::highestSupportedLocalStorageVersion() const
 {
-    return 2;
+    return 8;
 }
 
 int LocalStorageManagerPrivate::userCount(ErrorString & errorDescription) const
@@ -716,7 +937,7 @@ int LocalStorageManagerPrivate::userCount(ErrorString & errorDescription) const
         return -1;
     }
 
-    res = query.exec();
+    res = execQuery(query);
     if (!res) {
         SET_ERROR();
         return -1;
@@ -1022,7 +1243,7 @@ bool LocalStorageManagerPrivate::findNotebook(
     Notebook result;
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     size_t counter = 0;
@@ -1057,8 +1278,7 @@ bool LocalStorageManagerPrivate::findDefaultNotebook(
     ErrorString errorPrefix(QT_TR_NOOP(
         "Can't find default notebook in the local storage database"));
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(QStringLiteral(
+    QString queryString = QStringLiteral(
         "SELECT * FROM Notebooks "
         "LEFT OUTER JOIN NotebookRestrictions ON "
         "Notebooks.localUid = NotebookRestrictions.localUid "
@@ -1078,7 +1298,10 @@ bool LocalStorageManagerPrivate::findDefaultNotebook(
         "Notebooks.contactId = AccountLimits.id "
         "LEFT OUTER JOIN BusinessUserInfo ON "
         "Notebooks.contactId = BusinessUserInfo.id "
-        "WHERE isDefault = 1 LIMIT 1"));
+        "WHERE isDefault = 1 LIMIT 1");
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     if (!query.next()) {
@@ -1114,8 +1337,7 @@ bool LocalStorageManagerPrivate::findLastUsedNotebook(
         QT_TR_NOOP("Can't find last used notebook in the local storage "
                    "database"));
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(QStringLiteral(
+    QString queryString = QStringLiteral(
         "SELECT * FROM Notebooks "
         "LEFT OUTER JOIN NotebookRestrictions ON "
         "Notebooks.localUid = NotebookRestrictions.localUid "
@@ -1135,7 +1357,10 @@ bool LocalStorageManagerPrivate::findLastUsedNotebook(
         "Notebooks.contactId = AccountLimits.id "
         "LEFT OUTER JOIN BusinessUserInfo ON "
         "Notebooks.contactId = BusinessUserInfo.id "
-        "WHERE isLastUsed = 1 LIMIT 1"));
+        "WHERE isLastUsed = 1 LIMIT 1");
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     if (!query.next()) {
@@ -1197,22 +1422,26 @@ QList<Notebook> LocalStorageManagerPrivate::listNotebooks(
         "local_storage",
         "LocalStorageManagerPrivate::listNotebooks: flag = " << flag);
 
-    QString linkedNotebookGuidSqlQueryCondition;
-    if (!linkedNotebookGuid.isNull()) {
-        if (linkedNotebookGuid.isEmpty()) {
-            linkedNotebookGuidSqlQueryCondition =
-                QStringLiteral("linkedNotebookGuid IS NULL");
-        }
-        else {
-            linkedNotebookGuidSqlQueryCondition =
-                QString::fromUtf8("linkedNotebookGuid = '%1'")
-                    .arg(sqlEscapeString(linkedNotebookGuid));
-        }
-    }
-
     return listObjects<Notebook, ListNotebooksOrder>(
         flag, errorDescription, limit, offset, order, orderDirection,
-        linkedNotebookGuidSqlQueryCondition);
+        linkedNotebookGuidSqlQueryCondition(linkedNotebookGuid));
+}
+
+QList<Notebook> LocalStorageManagerPrivate::listNotebooksPage(
+    const ListObjectsOptions flag, ErrorString & errorDescription,
+    const size_t pageSize, QString & continuationToken,
+    const ListNotebooksOrder & order, const OrderDirection & orderDirection,
+    const QString & linkedNotebookGuid) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::listNotebooksPage: flag = "
+            << flag << ", page size = " << pageSize);
+
+    return listObjectsPage<Notebook, ListNotebooksOrder>(
+        flag, errorDescription, pageSize, continuationToken, order,
+        orderDirection,
+        linkedNotebookGuidSqlQueryCondition(linkedNotebookGuid));
 }
 
 QList<SharedNotebook> LocalStorageManagerPrivate::listAllSharedNotebooks(
@@ -1225,7 +1454,8 @@ QList<SharedNotebook> LocalStorageManagerPrivate::listAllSharedNotebooks(
     ErrorString errorPrefix(QT_TR_NOOP("Can't list all shared notebooks"));
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(QStringLiteral("SELECT * FROM SharedNotebooks"));
+    bool res =
+        execQuery(query, QStringLiteral("SELECT * FROM SharedNotebooks"));
     if (!res) {
         errorDescription.base() = errorPrefix.base();
         QNERROR(
@@ -1323,7 +1553,7 @@ LocalStorageManagerPrivate::listEnSharedNotebooksPerNotebookGuid(
 
     query.addBindValue(notebookGuid);
 
-    bool res = query.exec();
+    bool res = execQuery(query);
     if (!res) {
         SET_ERROR();
         return qecSharedNotebooks;
@@ -1436,15 +1666,6 @@ bool LocalStorageManagerPrivate::expungeNotebook(
         return false;
     }
 
-    ErrorString error;
-    if (!removeResourceDataFilesForNotebook(notebook, error)) {
-        errorDescription = errorPrefix;
-        errorDescription.appendBase(error.base());
-        errorDescription.appendBase(error.additionalBases());
-        errorDescription.details() = error.details();
-        return false;
-    }
-
     uid = sqlEscapeString(uid);
 
     QString queryString =
@@ -1452,9 +1673,33 @@ bool LocalStorageManagerPrivate::expungeNotebook(
             .arg(column, uid);
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
+    invalidateCompiledNoteSearchQueries();
+
+    if (notebook.hasGuid()) {
+        m_guidLocalUidIndex.removeByGuid(
+            GuidLocalUidIndex::ObjectType::Notebook, notebook.guid());
+    }
+
+    m_guidLocalUidIndex.removeByLocalUid(
+        GuidLocalUidIndex::ObjectType::Notebook, notebook.localUid());
+
+    // Notebook's notes and their resources are removed by triggers
+    m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Note);
+    m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Resource);
+    m_noteLocalStorageSnapshots.clear();
+
+    ErrorString error;
+    if (!removeOrphanResourceBlobs(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        return false;
+    }
+
     return true;
 }
 
@@ -1472,7 +1717,7 @@ int LocalStorageManagerPrivate::linkedNotebookCount(
         return -1;
     }
 
-    res = query.exec();
+    res = execQuery(query);
     if (!res) {
         SET_ERROR();
         return -1;
@@ -1631,7 +1876,7 @@ bool LocalStorageManagerPrivate::findLinkedNotebook(
 
     query.addBindValue(notebookGuid);
 
-    bool res = query.exec();
+    bool res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     if (!query.next()) {
@@ -1728,8 +1973,26 @@ bool LocalStorageManagerPrivate::expungeLinkedNotebook(
         return false;
     }
 
+    QString queryString =
+        QString::fromUtf8("DELETE FROM LinkedNotebooks WHERE guid='%1'")
+            .arg(linkedNotebookGuid);
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    invalidateCompiledNoteSearchQueries();
+
+    // Linked notebook's notebooks, tags, notes and resources are removed
+    // by triggers
+    m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Notebook);
+    m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Tag);
+    m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Note);
+    m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Resource);
+    m_noteLocalStorageSnapshots.clear();
+
     ErrorString error;
-    if (!removeResourceDataFilesForLinkedNotebook(linkedNotebook, error)) {
+    if (!removeOrphanResourceBlobs(error)) {
         errorDescription = errorPrefix;
         errorDescription.appendBase(error.base());
         errorDescription.appendBase(error.additionalBases());
@@ -1737,14 +2000,6 @@ bool LocalStorageManagerPrivate::expungeLinkedNotebook(
         return false;
     }
 
-    QString queryString =
-        QString::fromUtf8("DELETE FROM LinkedNotebooks WHERE guid='%1'")
-            .arg(linkedNotebookGuid);
-
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
-
     return true;
 }
 
@@ -1755,15 +2010,13 @@ int LocalStorageManagerPrivate::noteCount(
         QT_TR_NOOP("Can't get the number of notes in the local storage "
                    "database"));
 
-    QString queryString = QStringLiteral("SELECT COUNT(*) FROM Notes");
-    QString condition = noteCountOptionsToSqlQueryPart(options);
-    if (!condition.isEmpty()) {
-        queryString += QStringLiteral(" WHERE ");
-        queryString += condition;
-    }
+    QString queryString =
+        QString::fromUtf8(
+            "SELECT COALESCE(SUM(%1), 0) FROM NotebookNoteCounters")
+            .arg(noteCountOptionsToCounterColumns(options));
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     if (!res) {
         SET_ERROR();
         return -1;
@@ -1806,29 +2059,25 @@ int LocalStorageManagerPrivate::noteCountPerNotebook(
         return -1;
     }
 
-    QString column, value;
+    QString notebookLocalUid;
     if (notebook.hasGuid()) {
-        column = QStringLiteral("notebookGuid");
-        value = notebook.guid();
+        notebookLocalUid = QString::fromUtf8(
+                               "(SELECT localUid FROM Notebooks "
+                               "WHERE guid = '%1')")
+                               .arg(sqlEscapeString(notebook.guid()));
     }
     else {
-        column = QStringLiteral("notebookLocalUid");
-        value = notebook.localUid();
+        notebookLocalUid = QStringLiteral("'") +
+            sqlEscapeString(notebook.localUid()) + QStringLiteral("'");
     }
 
-    value = sqlEscapeString(value);
-
     QString queryString =
-        QString::fromUtf8("SELECT COUNT(*) FROM Notes WHERE %1 = '%2'")
-            .arg(column, value);
-    QString condition = noteCountOptionsToSqlQueryPart(options);
-    if (!condition.isEmpty()) {
-        queryString += QStringLiteral(" AND ");
-        queryString += condition;
-    }
+        QString::fromUtf8(
+            "SELECT %1 FROM NotebookNoteCounters WHERE notebookLocalUid = %2")
+            .arg(noteCountOptionsToCounterColumns(options), notebookLocalUid);
 
     QSqlQuery query(m_sqlDatabase);
-    res = query.exec(queryString);
+    res = execQuery(query, queryString);
 
     if (!res) {
         SET_ERROR();
@@ -1874,32 +2123,24 @@ int LocalStorageManagerPrivate::noteCountPerTag(
         return -1;
     }
 
-    QString column, value;
+    QString tagLocalUid;
     if (tag.hasGuid()) {
-        column = QStringLiteral("tag");
-        value = tag.guid();
+        tagLocalUid =
+            QString::fromUtf8("(SELECT localUid FROM Tags WHERE guid = '%1')")
+                .arg(sqlEscapeString(tag.guid()));
     }
     else {
-        column = QStringLiteral("localTag");
-        value = tag.localUid();
+        tagLocalUid = QStringLiteral("'") + sqlEscapeString(tag.localUid()) +
+            QStringLiteral("'");
     }
 
-    value = sqlEscapeString(value);
-
     QString queryString =
         QString::fromUtf8(
-            "SELECT COUNT(*) FROM Notes WHERE (localUid IN (SELECT DISTINCT "
-            "localNote FROM NoteTags WHERE %1 = '%2'))")
-            .arg(column, value);
-
-    QString condition = noteCountOptionsToSqlQueryPart(options);
-    if (!condition.isEmpty()) {
-        queryString += QStringLiteral(" AND ");
-        queryString += condition;
-    }
+            "SELECT %1 FROM TagNoteCounters WHERE tagLocalUid = %2")
+            .arg(noteCountOptionsToCounterColumns(options), tagLocalUid);
 
     QSqlQuery query(m_sqlDatabase);
-    res = query.exec(queryString);
+    res = execQuery(query, queryString);
     if (!res) {
         SET_ERROR();
         return -1;
@@ -1933,21 +2174,14 @@ bool LocalStorageManagerPrivate::noteCountsPerAllTags(
 
     noteCountsPerTagLocalUid.clear();
 
-    QString queryString = QStringLiteral(
-        "SELECT localTag, COUNT(localTag) AS noteCount FROM "
-        "NoteTags LEFT OUTER JOIN Notes "
-        "ON NoteTags.localNote = Notes.localUid ");
-
-    QString condition = noteCountOptionsToSqlQueryPart(options);
-    if (!condition.isEmpty()) {
-        queryString += QStringLiteral("WHERE ");
-        queryString += condition;
-        queryString += QStringLiteral(" ");
-    }
-    queryString += QStringLiteral("GROUP BY localTag");
+    QString queryString =
+        QString::fromUtf8(
+            "SELECT tagLocalUid AS localTag, %1 AS noteCount "
+            "FROM TagNoteCounters WHERE %1 > 0")
+            .arg(noteCountOptionsToCounterColumns(options));
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     if (!res) {
         SET_ERROR();
         return false;
@@ -2020,9 +2254,42 @@ int LocalStorageManagerPrivate::noteCountPerNotebooksAndTags(
         QT_TR_NOOP("Can't get the number of notes per notebooks and tags from "
                    "the local storage database"));
 
-    QString queryString = QStringLiteral("SELECT COUNT(*) FROM Notes");
-    if (!notebookLocalUids.isEmpty() || !tagLocalUids.isEmpty()) {
-        queryString += QStringLiteral(" WHERE ");
+    QString queryString;
+
+    // Notes belong to a single notebook so the counters of notebooks can be
+    // summed up; a note can have many tags so notes matching several tags
+    // or both notebooks and tags still have to be counted from scratch
+    if (tagLocalUids.isEmpty() ||
+        (notebookLocalUids.isEmpty() && (tagLocalUids.size() == 1)))
+    {
+        const bool countPerNotebooks = tagLocalUids.isEmpty();
+
+        const QStringList & localUids =
+            (countPerNotebooks ? notebookLocalUids : tagLocalUids);
+
+        queryString =
+            QString::fromUtf8("SELECT COALESCE(SUM(%1), 0) FROM %2")
+                .arg(
+                    noteCountOptionsToCounterColumns(options),
+                    (countPerNotebooks ? QStringLiteral("NotebookNoteCounters")
+                                       : QStringLiteral("TagNoteCounters")));
+
+        if (!localUids.isEmpty()) {
+            queryString += (countPerNotebooks
+                                ? QStringLiteral(" WHERE notebookLocalUid IN (")
+                                : QStringLiteral(" WHERE tagLocalUid IN ("));
+
+            for (const auto & localUid: localUids) {
+                queryString += QStringLiteral("'") + sqlEscapeString(localUid) +
+                    QStringLiteral("', ");
+            }
+
+            queryString.chop(2);
+            queryString += QStringLiteral(")");
+        }
+    }
+    else {
+        queryString = QStringLiteral("SELECT COUNT(*) FROM Notes WHERE ");
 
         if (!notebookLocalUids.isEmpty()) {
             queryString += QStringLiteral("(notebookLocalUid IN (");
@@ -2033,42 +2300,30 @@ int LocalStorageManagerPrivate::noteCountPerNotebooksAndTags(
             }
 
             queryString.chop(2);
-            queryString += QStringLiteral(")) ");
+            queryString += QStringLiteral(")) AND ");
         }
 
-        if (!tagLocalUids.isEmpty()) {
-            if (!notebookLocalUids.isEmpty()) {
-                queryString += QStringLiteral(" AND ");
-            }
-
-            queryString += QStringLiteral(
-                "(localUid IN (SELECT DISTINCT localNote "
-                "FROM NoteTags WHERE localTag IN (");
-
-            for (const auto & tagLocalUid: tagLocalUids) {
-                queryString += QStringLiteral("'") +
-                    sqlEscapeString(tagLocalUid) + QStringLiteral("', ");
-            }
+        queryString += QStringLiteral(
+            "(localUid IN (SELECT DISTINCT localNote "
+            "FROM NoteTags WHERE localTag IN (");
 
-            queryString.chop(2);
-            queryString += QStringLiteral(")))");
+        for (const auto & tagLocalUid: tagLocalUids) {
+            queryString += QStringLiteral("'") + sqlEscapeString(tagLocalUid) +
+                QStringLiteral("', ");
         }
-    }
 
-    QString condition = noteCountOptionsToSqlQueryPart(options);
-    if (!condition.isEmpty()) {
-        if (!notebookLocalUids.isEmpty() || !tagLocalUids.isEmpty()) {
+        queryString.chop(2);
+        queryString += QStringLiteral(")))");
+
+        QString condition = noteCountOptionsToSqlQueryPart(options);
+        if (!condition.isEmpty()) {
             queryString += QStringLiteral(" AND ");
+            queryString += condition;
         }
-        else {
-            queryString += QStringLiteral(" WHERE ");
-        }
-
-        queryString += condition;
     }
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     if (!res) {
         SET_ERROR();
         return -1;
@@ -2224,6 +2479,9 @@ bool LocalStorageManagerPrivate::addNote(
         UpdateNoteOption::UpdateResourceBinaryData |
         UpdateNoteOption::UpdateTags);
 
+    // The snapshot of another note with the same local uid, if any, is stale
+    Q_UNUSED(m_noteLocalStorageSnapshots.remove(note.localUid()))
+
     res = insertOrReplaceNote(note, options, errorDescription);
     if (!res) {
         QNWARNING("local_storage", "Note which produced the error: " << note);
@@ -2365,6 +2623,40 @@ bool LocalStorageManagerPrivate::updateNote(
     return res;
 }
 
+bool LocalStorageManagerPrivate::addNotes(
+    QList<Note> & notes, QList<ErrorString> & noteErrorDescriptions,
+    ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::addNotes: " << notes.size()
+                                                 << " notes");
+
+    return processBatchInTransaction(
+        notes.size(),
+        [&](const int index, ErrorString & error) {
+            return addNote(notes[index], error);
+        },
+        noteErrorDescriptions, errorDescription);
+}
+
+bool LocalStorageManagerPrivate::updateNotes(
+    QList<Note> & notes, const UpdateNoteOptions options,
+    QList<ErrorString> & noteErrorDescriptions, ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::updateNotes: " << notes.size()
+                                                    << " notes");
+
+    return processBatchInTransaction(
+        notes.size(),
+        [&](const int index, ErrorString & error) {
+            return updateNote(notes[index], options, error);
+        },
+        noteErrorDescriptions, errorDescription);
+}
+
 bool LocalStorageManagerPrivate::findNote(
     Note & note, const GetNoteOptions options,
     ErrorString & errorDescription) const
@@ -2411,6 +2703,17 @@ bool LocalStorageManagerPrivate::findNote(
     bool withResourceBinaryData =
         (options & GetNoteOption::WithResourceBinaryData);
 
+    GetResourceOptions resourceBinaryDataOptions =
+        GetResourceOption::WithBinaryData;
+
+    if (options & GetNoteOption::MapResourceBinaryData) {
+        resourceBinaryDataOptions |= GetResourceOption::MapBinaryData;
+    }
+
+    if (options & GetNoteOption::LazyResourceBinaryData) {
+        resourceBinaryDataOptions |= GetResourceOption::LazyBinaryData;
+    }
+
     QString resourceIndexColumn =
         (column == QStringLiteral("localUid") ? QStringLiteral("noteLocalUid")
                                               : QStringLiteral("noteGuid"));
@@ -2494,7 +2797,7 @@ bool LocalStorageManagerPrivate::findNote(
 
     queryString += QString::fromUtf8("WHERE %1 = '%2'").arg(column, uid);
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     Note result;
@@ -2552,7 +2855,9 @@ bool LocalStorageManagerPrivate::findNote(
                     resource.setNoteLocalUid(note.localUid());
 
                     if (withResourceBinaryData &&
-                        !readResourceDataFromFiles(resource, errorDescription))
+                        !readResourceDataFromFiles(
+                            resource, resourceBinaryDataOptions,
+                            errorDescription))
                     {
                         return false;
                     }
@@ -2653,6 +2958,9 @@ bool LocalStorageManagerPrivate::findNote(
         return false;
     }
 
+    // Subsequent update of the note would write only its modified parts
+    putNoteLocalStorageSnapshot(result, withResourceMetadata);
+
     note = result;
     return true;
 }
@@ -2904,27 +3212,253 @@ QList<Note> LocalStorageManagerPrivate::listNotes(
     ErrorString errorPrefix(
         QT_TR_NOOP("Can't list notes from the local storage database"));
 
-    QString linkedNotebookGuidSqlQueryCondition;
-    if (!linkedNotebookGuid.isNull()) {
-        linkedNotebookGuidSqlQueryCondition = QStringLiteral(
-            "localUid IN (SELECT DISTINCT Notes.localUid FROM "
-            "(Notes LEFT OUTER JOIN Notebooks ON "
-            "Notes.notebookLocalUid = Notebooks.localUid) "
-            "WHERE Notebooks.linkedNotebookGuid");
+    return listNotesImpl(
+        errorPrefix,
+        noteLinkedNotebookGuidSqlQueryCondition(linkedNotebookGuid), flag,
+        options, errorDescription, limit, offset, order, orderDirection);
+}
+
+QList<Note> LocalStorageManagerPrivate::listNotesPage(
+    const ListObjectsOptions flag, const GetNoteOptions options,
+    ErrorString & errorDescription, const size_t pageSize,
+    QString & continuationToken, const ListNotesOrder & order,
+    const OrderDirection & orderDirection,
+    const QString & linkedNotebookGuid) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::listNotesPage: flag = "
+            << flag << ", page size = " << pageSize
+            << ", linked notebook guid = " << linkedNotebookGuid);
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't list notes from the local storage database"));
+
+    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Selection);
+    Q_UNUSED(transaction)
+
+    ErrorString error;
 
-        if (linkedNotebookGuid.isEmpty()) {
-            linkedNotebookGuidSqlQueryCondition += QStringLiteral(" IS NULL)");
+    auto notes = listObjectsPage<Note, ListNotesOrder>(
+        flag, error, pageSize, continuationToken, order, orderDirection,
+        noteLinkedNotebookGuidSqlQueryCondition(linkedNotebookGuid));
+
+    if (notes.isEmpty() && !error.isEmpty()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return notes;
+    }
+
+    if (!complementNotesWithTagsAndResources(
+            notes, options, errorPrefix, errorDescription))
+    {
+        notes.clear();
+        continuationToken.clear();
+    }
+
+    return notes;
+}
+
+QList<NoteSummary> LocalStorageManagerPrivate::listNoteSummaries(
+    const ListObjectsOptions flag, const NoteSummaryFields fields,
+    ErrorString & errorDescription, const size_t limit, const size_t offset,
+    const ListNotesOrder & order, const OrderDirection & orderDirection,
+    const QString & linkedNotebookGuid, const int previewLength) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::listNoteSummaries: flag = "
+            << flag << ", fields = " << static_cast<int>(fields)
+            << ", limit = " << limit << ", offset = " << offset
+            << ", order = " << order << ", direction = " << orderDirection
+            << ", linked notebook guid = " << linkedNotebookGuid
+            << ", preview length = " << previewLength);
+
+    ErrorString errorPrefix(QT_TR_NOOP(
+        "Can't list note summaries from the local storage database"));
+
+    QList<NoteSummary> noteSummaries;
+
+    ErrorString error;
+    QString sqlQueryConditions;
+    if (!listObjectsSqlQueryConditions<Note>(
+            flag, noteLinkedNotebookGuidSqlQueryCondition(linkedNotebookGuid),
+            sqlQueryConditions, error))
+    {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return noteSummaries;
+    }
+
+    // Only the columns backing the requested fields are selected and only
+    // from Notes table: neither note's content nor the tables with note's
+    // shared notes, restrictions and limits are touched
+    QStringList columns;
+    auto addColumn = [&columns](const QString & column) {
+        columns << column;
+        return columns.size() - 1;
+    };
+
+    const int localUidIndex = addColumn(QStringLiteral("localUid"));
+    const int guidIndex = addColumn(QStringLiteral("guid"));
+
+    int titleIndex = -1;
+    if (fields & NoteSummaryField::Title) {
+        titleIndex = addColumn(QStringLiteral("title"));
+    }
+
+    int notebookLocalUidIndex = -1;
+    int notebookGuidIndex = -1;
+    if (fields & NoteSummaryField::Notebook) {
+        notebookLocalUidIndex = addColumn(QStringLiteral("notebookLocalUid"));
+        notebookGuidIndex = addColumn(QStringLiteral("notebookGuid"));
+    }
+
+    int creationTimestampIndex = -1;
+    int modificationTimestampIndex = -1;
+    int deletionTimestampIndex = -1;
+    if (fields & NoteSummaryField::Timestamps) {
+        creationTimestampIndex = addColumn(QStringLiteral("creationTimestamp"));
+
+        modificationTimestampIndex =
+            addColumn(QStringLiteral("modificationTimestamp"));
+
+        deletionTimestampIndex = addColumn(QStringLiteral("deletionTimestamp"));
+    }
+
+    int previewIndex = -1;
+    if ((fields & NoteSummaryField::Preview) && (previewLength > 0)) {
+        previewIndex =
+            addColumn(QString::fromUtf8("substr(contentPlainText, 1, %1)")
+                          .arg(previewLength));
+    }
+
+    int isDirtyIndex = -1;
+    int isLocalIndex = -1;
+    int isFavoritedIndex = -1;
+    if (fields & NoteSummaryField::Flags) {
+        isDirtyIndex = addColumn(QStringLiteral("isDirty"));
+        isLocalIndex = addColumn(QStringLiteral("isLocal"));
+        isFavoritedIndex = addColumn(QStringLiteral("isFavorited"));
+    }
+
+    QString queryString = QStringLiteral("SELECT ") +
+        columns.join(QStringLiteral(", ")) + QStringLiteral(" FROM Notes");
+
+    if (!sqlQueryConditions.isEmpty()) {
+        queryString += QStringLiteral(" WHERE ") + sqlQueryConditions;
+    }
+
+    QString orderByColumn = orderByToSqlTableColumn<ListNotesOrder>(order);
+    if (!orderByColumn.isEmpty()) {
+        queryString += QStringLiteral(" ORDER BY ") + orderByColumn;
+
+        if (orderDirection == OrderDirection::Descending) {
+            queryString += QStringLiteral(" DESC");
         }
         else {
-            linkedNotebookGuidSqlQueryCondition +=
-                QString::fromUtf8(" = '%1')")
-                    .arg(sqlEscapeString(linkedNotebookGuid));
+            queryString += QStringLiteral(" ASC");
         }
     }
 
-    return listNotesImpl(
-        errorPrefix, linkedNotebookGuidSqlQueryCondition, flag, options,
-        errorDescription, limit, offset, order, orderDirection);
+    if (limit != 0) {
+        queryString += QStringLiteral(" LIMIT ") + QString::number(limit);
+    }
+    else if (offset != 0) {
+        // SQLite doesn't accept OFFSET without LIMIT
+        queryString += QStringLiteral(" LIMIT -1");
+    }
+
+    if (offset != 0) {
+        queryString += QStringLiteral(" OFFSET ") + QString::number(offset);
+    }
+
+    QNDEBUG("local_storage", "SQL query string: " << queryString);
+
+    // Tags are listed within the same transaction as notes so that they
+    // correspond to each other
+    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Selection);
+    Q_UNUSED(transaction)
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.details() = query.lastError().text();
+        QNERROR(
+            "local_storage",
+            errorDescription << ", last executed query: "
+                             << lastExecutedQuery(query));
+        return noteSummaries;
+    }
+
+    while (query.next()) {
+        NoteSummary noteSummary;
+        noteSummary.m_fields = fields;
+        noteSummary.m_localUid = query.value(localUidIndex).toString();
+        noteSummary.m_guid = query.value(guidIndex).toString();
+
+        if (titleIndex >= 0) {
+            noteSummary.m_title = query.value(titleIndex).toString();
+        }
+
+        if (notebookLocalUidIndex >= 0) {
+            noteSummary.m_notebookLocalUid =
+                query.value(notebookLocalUidIndex).toString();
+
+            noteSummary.m_notebookGuid =
+                query.value(notebookGuidIndex).toString();
+        }
+
+        if (creationTimestampIndex >= 0) {
+            noteSummary.m_creationTimestamp =
+                query.value(creationTimestampIndex).toLongLong();
+
+            noteSummary.m_modificationTimestamp =
+                query.value(modificationTimestampIndex).toLongLong();
+
+            noteSummary.m_deletionTimestamp =
+                query.value(deletionTimestampIndex).toLongLong();
+        }
+
+        if (previewIndex >= 0) {
+            noteSummary.m_preview = query.value(previewIndex).toString();
+        }
+
+        if (isDirtyIndex >= 0) {
+            noteSummary.m_isDirty = (query.value(isDirtyIndex).toInt() != 0);
+            noteSummary.m_isLocal = (query.value(isLocalIndex).toInt() != 0);
+
+            noteSummary.m_isFavorited =
+                (query.value(isFavoritedIndex).toInt() != 0);
+        }
+
+        noteSummaries << noteSummary;
+    }
+
+    if ((fields & NoteSummaryField::TagLocalUids) && !noteSummaries.isEmpty()) {
+        error.clear();
+        if (!findAndSetTagLocalUidsPerNoteSummaries(noteSummaries, error)) {
+            errorDescription.base() = errorPrefix.base();
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            QNWARNING("local_storage", errorDescription);
+            noteSummaries.clear();
+            return noteSummaries;
+        }
+    }
+
+    QNDEBUG(
+        "local_storage", "found " << noteSummaries.size() << " note summaries");
+
+    return noteSummaries;
 }
 
 QList<Note> LocalStorageManagerPrivate::listNotesImpl(
@@ -2933,17 +3467,6 @@ QList<Note> LocalStorageManagerPrivate::listNotesImpl(
     ErrorString & errorDescription, const size_t limit, const size_t offset,
     const ListNotesOrder & order, const OrderDirection & orderDirection) const
 {
-    bool withResourceMetadata = (options & GetNoteOption::WithResourceMetadata);
-
-    GetResourceOptions resourceOptions =
-        ((options & GetNoteOption::WithResourceBinaryData)
-             ? GetResourceOption::WithBinaryData
-#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
-             : GetResourceOptions());
-#else
-             : GetResourceOptions(0));
-#endif
-
     // Will run all the queries from this method and its sub-methods within
     // a single transaction to prevent multiple drops and re-obtainings of
     // shared lock
@@ -2964,36 +3487,70 @@ QList<Note> LocalStorageManagerPrivate::listNotesImpl(
         return notes;
     }
 
-    const int numNotes = notes.size();
-    for (int i = 0; i < numNotes; ++i) {
-        auto & note = notes[i];
+    if (!complementNotesWithTagsAndResources(
+            notes, options, errorPrefix, errorDescription))
+    {
+        notes.clear();
+    }
+
+    return notes;
+}
+
+bool LocalStorageManagerPrivate::complementNotesWithTagsAndResources(
+    NoteList & notes, const GetNoteOptions options,
+    const ErrorString & errorPrefix, ErrorString & errorDescription) const
+{
+    bool withResourceMetadata = (options & GetNoteOption::WithResourceMetadata);
+
+    GetResourceOptions resourceOptions =
+        ((options & GetNoteOption::WithResourceBinaryData)
+             ? GetResourceOption::WithBinaryData
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+             : GetResourceOptions());
+#else
+             : GetResourceOptions(0));
+#endif
+
+    if ((options & GetNoteOption::WithResourceBinaryData) &&
+        (options & GetNoteOption::MapResourceBinaryData))
+    {
+        resourceOptions |= GetResourceOption::MapBinaryData;
+    }
+
+    if ((options & GetNoteOption::WithResourceBinaryData) &&
+        (options & GetNoteOption::LazyResourceBinaryData))
+    {
+        resourceOptions |= GetResourceOption::LazyBinaryData;
+    }
+
+    // Tags and resources are fetched for all notes within the page at once
+    // instead of running separate queries for each note
+    ErrorString error;
+    bool res = findAndSetTagIdsPerNotes(notes, error);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
 
+    if (withResourceMetadata) {
         error.clear();
-        bool res = findAndSetTagIdsPerNote(note, error);
+        res = findAndSetResourcesPerNotes(notes, resourceOptions, error);
         if (!res) {
             errorDescription.base() = errorPrefix.base();
             errorDescription.appendBase(error.base());
             errorDescription.appendBase(error.additionalBases());
             errorDescription.details() = error.details();
             QNWARNING("local_storage", errorDescription);
-            notes.clear();
-            return notes;
-        }
-
-        if (withResourceMetadata) {
-            error.clear();
-            res = findAndSetResourcesPerNote(note, resourceOptions, error);
-            if (!res) {
-                errorDescription.base() = errorPrefix.base();
-                errorDescription.appendBase(error.base());
-                errorDescription.appendBase(error.additionalBases());
-                errorDescription.details() = error.details();
-                QNWARNING("local_storage", errorDescription);
-                notes.clear();
-                return notes;
-            }
+            return false;
         }
+    }
 
+    for (const auto & note: qAsConst(notes)) {
+        error.clear();
         res = note.checkParameters(error);
         if (!res) {
             errorDescription.base() = errorPrefix.base();
@@ -3001,12 +3558,11 @@ QList<Note> LocalStorageManagerPrivate::listNotesImpl(
             errorDescription.appendBase(error.additionalBases());
             errorDescription.details() = error.details();
             QNWARNING("local_storage", errorDescription);
-            notes.clear();
-            return notes;
+            return false;
         }
     }
 
-    return notes;
+    return true;
 }
 
 bool LocalStorageManagerPrivate::expungeNote(
@@ -3114,11 +3670,26 @@ bool LocalStorageManagerPrivate::expungeNote(
         QString::fromUtf8("DELETE FROM Notes WHERE %1 = '%2'").arg(column, uid);
 
     QSqlQuery query(m_sqlDatabase);
-    res = query.exec(queryString);
+    res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
+    invalidateCompiledNoteSearchQueries();
+
+    if (note.hasGuid()) {
+        m_guidLocalUidIndex.removeByGuid(
+            GuidLocalUidIndex::ObjectType::Note, note.guid());
+    }
+
+    m_guidLocalUidIndex.removeByLocalUid(
+        GuidLocalUidIndex::ObjectType::Note, note.localUid());
+
+    Q_UNUSED(m_noteLocalStorageSnapshots.remove(note.localUid()))
+
+    // Note's resources are removed by triggers
+    m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Resource);
+
     error.clear();
-    if (!removeResourceDataFilesForNote(localUid, error)) {
+    if (!removeOrphanResourceBlobs(error)) {
         errorDescription = errorPrefix;
         errorDescription.appendBase(error.base());
         errorDescription.appendBase(error.additionalBases());
@@ -3142,8 +3713,6 @@ QStringList LocalStorageManagerPrivate::findNoteLocalUidsWithSearchQuery(
         return QStringList();
     }
 
-    QString queryString;
-
     /**
      * Will run all the queries from this method and its sub-methods within
      * a single transaction to prevent multiple drops and re-obtainings of
@@ -3155,8 +3724,9 @@ QStringList LocalStorageManagerPrivate::findNoteLocalUidsWithSearchQuery(
     ErrorString errorPrefix(
         QT_TR_NOOP("Can't find notes with the note search query"));
 
+    QSqlQuery query;
     ErrorString error;
-    bool res = noteSearchQueryToSQL(noteSearchQuery, queryString, error);
+    bool res = compiledNoteSearchQuery(noteSearchQuery, query, error);
     if (!res) {
         errorDescription.base() = errorPrefix.base();
         errorDescription.appendBase(error.base());
@@ -3166,16 +3736,19 @@ QStringList LocalStorageManagerPrivate::findNoteLocalUidsWithSearchQuery(
         return QStringList();
     }
 
-    QSqlQuery query(m_sqlDatabase);
-    res = query.exec(queryString);
+    res = execQuery(query);
     if (!res) {
         SET_ERROR();
-        QNWARNING("local_storage", "Full executed SQL query: " << queryString);
+        QNWARNING(
+            "local_storage", "Full executed SQL query: " << query.lastQuery());
         return QStringList();
     }
 
     QSet<QString> foundLocalUids;
+    int rowCount = 0;
     while (query.next()) {
+        ++rowCount;
+
         QSqlRecord rec = query.record();
         int index = rec.indexOf(QStringLiteral("localUid"));
         if (index < 0) {
@@ -3190,6 +3763,12 @@ QStringList LocalStorageManagerPrivate::findNoteLocalUidsWithSearchQuery(
         foundLocalUids.insert(value);
     }
 
+    recordQueryRows(query, rowCount);
+
+    // Reset the cached prepared statement so that it doesn't hold the read
+    // lock
+    query.finish();
+
     QStringList result;
     result.reserve(foundLocalUids.size());
     for (const auto & localUid: foundLocalUids) {
@@ -3239,7 +3818,7 @@ NoteList LocalStorageManagerPrivate::findNotesWithSearchQuery(
             .arg(joinedLocalUids);
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     if (Q_UNLIKELY(!res)) {
         SET_ERROR();
         return NoteList();
@@ -3256,9 +3835,21 @@ NoteList LocalStorageManagerPrivate::findNotesWithSearchQuery(
              : GetResourceOptions(0));
 #endif
 
-    NoteList notes;
-    notes.reserve(qMax(query.size(), 0));
-    ErrorString error;
+    if ((options & GetNoteOption::WithResourceBinaryData) &&
+        (options & GetNoteOption::MapResourceBinaryData))
+    {
+        resourceOptions |= GetResourceOption::MapBinaryData;
+    }
+
+    if ((options & GetNoteOption::WithResourceBinaryData) &&
+        (options & GetNoteOption::LazyResourceBinaryData))
+    {
+        resourceOptions |= GetResourceOption::LazyBinaryData;
+    }
+
+    NoteList notes;
+    notes.reserve(qMax(query.size(), 0));
+    ErrorString error;
 
     while (query.next()) {
         notes.push_back(Note());
@@ -3279,35 +3870,36 @@ NoteList LocalStorageManagerPrivate::findNotesWithSearchQuery(
             QNWARNING("local_storage", errorDescription);
             return NoteList();
         }
+    }
+
+    error.clear();
+    res = findAndSetTagIdsPerNotes(notes, error);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(QT_TR_NOOP("can't fetch note's tag ids"));
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return NoteList();
+    }
 
+    if (withResourceMetadata) {
         error.clear();
-        res = findAndSetTagIdsPerNote(note, error);
+        res = findAndSetResourcesPerNotes(notes, resourceOptions, error);
         if (!res) {
             errorDescription.base() = errorPrefix.base();
             errorDescription.appendBase(
-                QT_TR_NOOP("can't fetch note's tag ids"));
+                QT_TR_NOOP("can't fetch note's resources"));
             errorDescription.appendBase(error.base());
             errorDescription.appendBase(error.additionalBases());
             errorDescription.details() = error.details();
             QNWARNING("local_storage", errorDescription);
             return NoteList();
         }
+    }
 
-        if (withResourceMetadata) {
-            error.clear();
-            res = findAndSetResourcesPerNote(note, resourceOptions, error);
-            if (!res) {
-                errorDescription.base() = errorPrefix.base();
-                errorDescription.appendBase(
-                    QT_TR_NOOP("can't fetch note's resources"));
-                errorDescription.appendBase(error.base());
-                errorDescription.appendBase(error.additionalBases());
-                errorDescription.details() = error.details();
-                QNWARNING("local_storage", errorDescription);
-                return NoteList();
-            }
-        }
-
+    for (const auto & note: qAsConst(notes)) {
         error.clear();
         res = note.checkParameters(error);
         if (!res) {
@@ -3326,6 +3918,279 @@ NoteList LocalStorageManagerPrivate::findNotesWithSearchQuery(
     return notes;
 }
 
+QList<LocalStorageManager::NoteSearchHit>
+LocalStorageManagerPrivate::findNoteSearchHits(
+    const NoteSearchQuery & noteSearchQuery, ErrorString & errorDescription,
+    const size_t limit) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::findNoteSearchHits: "
+            << noteSearchQuery << "\nLimit = " << limit);
+
+    using NoteSearchHit = LocalStorageManager::NoteSearchHit;
+
+    if (!noteSearchQuery.isMatcheable()) {
+        return QList<NoteSearchHit>();
+    }
+
+    /**
+     * Running all the queries within a single transaction so that scores
+     * and snippets are computed over the same snapshot of the database
+     */
+    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Selection);
+    Q_UNUSED(transaction)
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't find note search hits with the note search query"));
+
+    ErrorString error;
+    const QStringList noteLocalUids =
+        findNoteLocalUidsWithSearchQuery(noteSearchQuery, error);
+
+    if (noteLocalUids.isEmpty()) {
+        if (!error.isEmpty()) {
+            errorDescription.base() = errorPrefix.base();
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            QNWARNING("local_storage", errorDescription);
+        }
+
+        return QList<NoteSearchHit>();
+    }
+
+    QSet<QString> noteLocalUidsSet;
+    noteLocalUidsSet.reserve(noteLocalUids.size());
+    for (const auto & noteLocalUid: noteLocalUids) {
+        noteLocalUidsSet.insert(noteLocalUid);
+    }
+
+    QString noteMatchExpression;
+    QString resourceMatchExpression;
+
+    const QStringList ftsTerms =
+        noteSearchQueryContentSearchTermsToFTSTerms(noteSearchQuery);
+
+    for (const auto & ftsTerm: ftsTerms) {
+        if (!noteMatchExpression.isEmpty()) {
+            noteMatchExpression += QStringLiteral(" OR ");
+            resourceMatchExpression += QStringLiteral(" OR ");
+        }
+
+        noteMatchExpression += QStringLiteral("titleNormalized:") + ftsTerm +
+            QStringLiteral(" OR contentListOfWords:") + ftsTerm;
+
+        resourceMatchExpression += QStringLiteral("recognitionData:") + ftsTerm;
+    }
+
+    QHash<QString, double> scores;
+    QHash<QString, QPair<qint64, double>> bestNoteDocIds;
+    QHash<QString, QPair<qint64, double>> bestResourceDocIds;
+
+    if (!ftsTerms.isEmpty()) {
+        // Matches within note's title weigh more than matches within its text;
+        // other columns of NoteFTS are not searched for content search terms
+        QVector<double> noteColumnWeights;
+        noteColumnWeights << 0.0  // localUid
+                          << 2.0  // titleNormalized
+                          << 1.0; // contentListOfWords
+
+        bool res = scoreFTSMatches(
+            QStringLiteral("NoteFTS"), QStringLiteral("localUid"),
+            noteMatchExpression, noteColumnWeights, noteLocalUidsSet, scores,
+            bestNoteDocIds, error);
+
+        if (res) {
+            QVector<double> resourceColumnWeights;
+            resourceColumnWeights << 0.0  // resourceLocalUid
+                                  << 0.0  // noteLocalUid
+                                  << 1.0; // recognitionData
+
+            res = scoreFTSMatches(
+                QStringLiteral("ResourceRecognitionDataFTS"),
+                QStringLiteral("noteLocalUid"), resourceMatchExpression,
+                resourceColumnWeights, noteLocalUidsSet, scores,
+                bestResourceDocIds, error);
+        }
+
+        if (!res) {
+            errorDescription.base() = errorPrefix.base();
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            QNWARNING("local_storage", errorDescription);
+            return QList<NoteSearchHit>();
+        }
+    }
+
+    QList<NoteSearchHit> hits;
+    hits.reserve(noteLocalUids.size());
+    for (const auto & noteLocalUid: noteLocalUids) {
+        NoteSearchHit hit;
+        hit.m_noteLocalUid = noteLocalUid;
+        hit.m_score = scores.value(noteLocalUid, 0.0);
+        hits << hit;
+    }
+
+    auto compareHits = [](const NoteSearchHit & lhs,
+                          const NoteSearchHit & rhs) {
+        if (lhs.m_score != rhs.m_score) {
+            return lhs.m_score > rhs.m_score;
+        }
+
+        return lhs.m_noteLocalUid < rhs.m_noteLocalUid;
+    };
+
+    if ((limit > 0) && (limit < static_cast<size_t>(hits.size()))) {
+        const int numHits = static_cast<int>(limit);
+
+        std::partial_sort(
+            hits.begin(), hits.begin() + numHits, hits.end(), compareHits);
+
+        hits.erase(hits.begin() + numHits, hits.end());
+    }
+    else {
+        std::sort(hits.begin(), hits.end(), compareHits);
+    }
+
+    // Snippets are computed only for the returned hits; the snippet is taken
+    // from note's title or text if they match the search terms, otherwise
+    // from the best matching recognition data of note's resources
+    QHash<qint64, int> noteHitIndicesByDocId;
+    QHash<qint64, int> resourceHitIndicesByDocId;
+
+    for (int i = 0, numHits = hits.size(); i < numHits; ++i) {
+        const QString & noteLocalUid = qAsConst(hits)[i].m_noteLocalUid;
+
+        auto noteIt = bestNoteDocIds.find(noteLocalUid);
+        if (noteIt != bestNoteDocIds.end()) {
+            noteHitIndicesByDocId[noteIt.value().first] = i;
+            continue;
+        }
+
+        auto resourceIt = bestResourceDocIds.find(noteLocalUid);
+        if (resourceIt != bestResourceDocIds.end()) {
+            resourceHitIndicesByDocId[resourceIt.value().first] = i;
+        }
+    }
+
+    bool res = fillNoteSearchHitSnippets(
+        QStringLiteral("NoteFTS"), noteMatchExpression, noteHitIndicesByDocId,
+        hits, error);
+
+    if (res) {
+        res = fillNoteSearchHitSnippets(
+            QStringLiteral("ResourceRecognitionDataFTS"),
+            resourceMatchExpression, resourceHitIndicesByDocId, hits, error);
+    }
+
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return QList<NoteSearchHit>();
+    }
+
+    return hits;
+}
+
+QStringList LocalStorageManagerPrivate::findNoteLocalUidsWithinBoundingBox(
+    const double minLatitude, const double maxLatitude,
+    const double minLongitude, const double maxLongitude,
+    const NoteCountOptions options, ErrorString & errorDescription) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::findNoteLocalUidsWithinBoundingBox: "
+            << "latitude: [" << minLatitude << ", " << maxLatitude
+            << "], longitude: [" << minLongitude << ", " << maxLongitude
+            << "], options: " << options);
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't find notes within the bounding box"));
+
+    if (minLatitude > maxLatitude) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("min latitude is greater than max latitude"));
+        QNWARNING("local_storage", errorDescription);
+        return QStringList();
+    }
+
+    // The box crossing the antimeridian is split into two
+    QList<QPair<double, double>> longitudeRanges;
+    if (minLongitude > maxLongitude) {
+        longitudeRanges << qMakePair(minLongitude, 180.0);
+        longitudeRanges << qMakePair(-180.0, maxLongitude);
+    }
+    else {
+        longitudeRanges << qMakePair(minLongitude, maxLongitude);
+    }
+
+    const auto number = [](const double value) {
+        return QString::number(value, 'g', 17);
+    };
+
+    const QString deletionCondition = noteCountOptionsToSqlQueryPart(options);
+
+    QStringList selects;
+    for (const auto & longitudeRange: qAsConst(longitudeRanges)) {
+        QString select;
+
+        // Same as with note search queries, the index only narrows down
+        // the candidates while the exact condition is checked against Notes
+        if (m_noteLocationIndexAvailable) {
+            select = QString::fromUtf8(
+                         "SELECT Notes.localUid FROM NoteLocationIndex "
+                         "INNER JOIN Notes ON "
+                         "Notes.rowid = NoteLocationIndex.id WHERE "
+                         "NoteLocationIndex.maxLatitude >= %1 AND "
+                         "NoteLocationIndex.minLatitude <= %2 AND "
+                         "NoteLocationIndex.maxLongitude >= %3 AND "
+                         "NoteLocationIndex.minLongitude <= %4 AND ")
+                         .arg(
+                             number(minLatitude), number(maxLatitude),
+                             number(longitudeRange.first),
+                             number(longitudeRange.second));
+        }
+        else {
+            select = QStringLiteral("SELECT Notes.localUid FROM Notes WHERE ");
+        }
+
+        select += QString::fromUtf8(
+                      "Notes.latitude BETWEEN %1 AND %2 AND "
+                      "Notes.longitude BETWEEN %3 AND %4")
+                      .arg(
+                          number(minLatitude), number(maxLatitude),
+                          number(longitudeRange.first),
+                          number(longitudeRange.second));
+
+        if (!deletionCondition.isEmpty()) {
+            select += QStringLiteral(" AND Notes.") + deletionCondition;
+        }
+
+        selects << select;
+    }
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, selects.join(QStringLiteral(" UNION ")));
+    if (!res) {
+        SET_ERROR();
+        return QStringList();
+    }
+
+    QStringList result;
+    while (query.next()) {
+        result << query.value(0).toString();
+    }
+
+    recordQueryRows(query, result.size());
+    return result;
+}
+
 int LocalStorageManagerPrivate::tagCount(ErrorString & errorDescription) const
 {
     ErrorString errorPrefix(
@@ -3339,7 +4204,7 @@ int LocalStorageManagerPrivate::tagCount(ErrorString & errorDescription) const
         return -1;
     }
 
-    res = query.exec();
+    res = execQuery(query);
     if (!res) {
         SET_ERROR();
         return -1;
@@ -3450,6 +4315,22 @@ bool LocalStorageManagerPrivate::addTag(
     return true;
 }
 
+bool LocalStorageManagerPrivate::addTags(
+    QList<Tag> & tags, QList<ErrorString> & tagErrorDescriptions,
+    ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::addTags: " << tags.size() << " tags");
+
+    return processBatchInTransaction(
+        tags.size(),
+        [&](const int index, ErrorString & error) {
+            return addTag(tags[index], error);
+        },
+        tagErrorDescriptions, errorDescription);
+}
+
 bool LocalStorageManagerPrivate::updateTag(
     Tag & tag, ErrorString & errorDescription)
 {
@@ -3621,7 +4502,7 @@ bool LocalStorageManagerPrivate::findTag(
     }
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     bool foundTag = false;
@@ -3701,7 +4582,7 @@ QList<Tag> LocalStorageManagerPrivate::listAllTagsPerNote(
             .arg(column, uid);
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     if (!res) {
         SET_ERROR();
         return tags;
@@ -3779,18 +4660,26 @@ QList<Tag> LocalStorageManagerPrivate::listTags(
         "local_storage",
         "LocalStorageManagerPrivate::listTags: flag = " << flag);
 
-    QString linkedNotebookGuidSqlQueryCondition;
-    if (!linkedNotebookGuid.isNull()) {
-        linkedNotebookGuidSqlQueryCondition =
-            (linkedNotebookGuid.isEmpty()
-                 ? QStringLiteral("linkedNotebookGuid IS NULL")
-                 : QString::fromUtf8("linkedNotebookGuid = '%1'")
-                       .arg(sqlEscapeString(linkedNotebookGuid)));
-    }
-
     return listObjects<Tag, ListTagsOrder>(
         flag, errorDescription, limit, offset, order, orderDirection,
-        linkedNotebookGuidSqlQueryCondition);
+        linkedNotebookGuidSqlQueryCondition(linkedNotebookGuid));
+}
+
+QList<Tag> LocalStorageManagerPrivate::listTagsPage(
+    const ListObjectsOptions flag, ErrorString & errorDescription,
+    const size_t pageSize, QString & continuationToken,
+    const ListTagsOrder & order, const OrderDirection & orderDirection,
+    const QString & linkedNotebookGuid) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::listTagsPage: flag = "
+            << flag << ", page size = " << pageSize);
+
+    return listObjectsPage<Tag, ListTagsOrder>(
+        flag, errorDescription, pageSize, continuationToken, order,
+        orderDirection,
+        linkedNotebookGuidSqlQueryCondition(linkedNotebookGuid));
 }
 
 QList<std::pair<Tag, QStringList>>
@@ -3896,7 +4785,7 @@ bool LocalStorageManagerPrivate::expungeTag(
         QString::fromUtf8("SELECT localUid FROM Tags WHERE %1='%2'")
             .arg(parentColumn, uid);
 
-    bool res = query.exec(findChildTagsQueryString);
+    bool res = execQuery(query, findChildTagsQueryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     while (query.next()) {
@@ -3933,15 +4822,23 @@ bool LocalStorageManagerPrivate::expungeTag(
     QString queryString = QString::fromUtf8("DELETE FROM Tags WHERE %1='%2'")
                               .arg(parentColumn, uid);
 
-    res = query.exec(queryString);
+    res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     queryString =
         QString::fromUtf8("DELETE FROM Tags WHERE %1='%2'").arg(column, uid);
 
-    res = query.exec(queryString);
+    res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
+    invalidateCompiledNoteSearchQueries();
+
+    // Child tags are removed along with the tag
+    m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Tag);
+
+    // Snapshots of notes which were labeled with the removed tags are stale
+    m_noteLocalStorageSnapshots.clear();
+
     return true;
 }
 
@@ -3957,9 +4854,13 @@ bool LocalStorageManagerPrivate::expungeNotelessTagsFromLinkedNotebooks(
         "AND (localUid NOT IN (SELECT localTag FROM NoteTags)))");
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
+    invalidateCompiledNoteSearchQueries();
+
+    m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Tag);
+
     return true;
 }
 
@@ -3977,7 +4878,7 @@ int LocalStorageManagerPrivate::enResourceCount(
         return -1;
     }
 
-    res = query.exec();
+    res = execQuery(query);
     if (!res) {
         SET_ERROR();
         return -1;
@@ -4033,36 +4934,11 @@ bool LocalStorageManagerPrivate::findEnResource(
 
     uid = sqlEscapeString(uid);
 
-    QString queryString = QStringLiteral(
-        "SELECT Resources.resourceLocalUid, resourceGuid, "
-        "noteGuid, resourceUpdateSequenceNumber, resourceIsDirty, "
-        "dataSize, dataHash, mime, width, height, recognitionDataSize, "
-        "recognitionDataHash, alternateDataSize, alternateDataHash, "
-        "resourceIndexInNote, resourceSourceURL, timestamp, "
-        "resourceLatitude, resourceLongitude, resourceAltitude, "
-        "cameraMake, cameraModel, clientWillIndex, fileName, "
-        "attachment, resourceKey, resourceMapKey, resourceValue, "
-        "localNote, recognitionDataBody");
-
-    queryString +=
-        QString::fromUtf8(
-            " FROM Resources "
-            "LEFT OUTER JOIN ResourceAttributes ON "
-            "Resources.resourceLocalUid = "
-            "ResourceAttributes.resourceLocalUid "
-            "LEFT OUTER JOIN ResourceAttributesApplicationDataKeysOnly ON "
-            "Resources.resourceLocalUid = "
-            "ResourceAttributesApplicationDataKeysOnly.resourceLocalUid "
-            "LEFT OUTER JOIN ResourceAttributesApplicationDataFullMap ON "
-            "Resources.resourceLocalUid = "
-            "ResourceAttributesApplicationDataFullMap.resourceLocalUid "
-            "LEFT OUTER JOIN NoteResources ON "
-            "Resources.resourceLocalUid = NoteResources.localResource "
-            "WHERE Resources.%1 = '%2'")
-            .arg(column, uid);
+    QString queryString = resourceSelectionQueryPart() +
+        QString::fromUtf8(" WHERE Resources.%1 = '%2'").arg(column, uid);
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     Resource foundResource(resource);
@@ -4081,7 +4957,7 @@ bool LocalStorageManagerPrivate::findEnResource(
     }
 
     if ((options & GetResourceOption::WithBinaryData) &&
-        !readResourceDataFromFiles(foundResource, errorDescription))
+        !readResourceDataFromFiles(foundResource, options, errorDescription))
     {
         return false;
     }
@@ -4194,11 +5070,23 @@ bool LocalStorageManagerPrivate::expungeEnResource(
             .arg(column, uid);
 
     QSqlQuery query(m_sqlDatabase);
-    res = query.exec(queryString);
+    res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
+    invalidateCompiledNoteSearchQueries();
+
+    if (resource.hasGuid()) {
+        m_guidLocalUidIndex.removeByGuid(
+            GuidLocalUidIndex::ObjectType::Resource, resource.guid());
+    }
+
+    m_guidLocalUidIndex.removeByLocalUid(
+        GuidLocalUidIndex::ObjectType::Resource, resource.localUid());
+
+    removeNoteLocalStorageSnapshot(resource);
+
     error.clear();
-    res = removeResourceDataFiles(resource, error);
+    res = removeOrphanResourceBlobs(error);
     if (!res) {
         errorDescription = errorPrefix;
         errorDescription.appendBase(error.base());
@@ -4224,7 +5112,7 @@ int LocalStorageManagerPrivate::savedSearchCount(
         return -1;
     }
 
-    res = query.exec();
+    res = execQuery(query);
     if (!res) {
         SET_ERROR();
         return -1;
@@ -4477,7 +5365,7 @@ bool LocalStorageManagerPrivate::findSavedSearch(
             .arg(column, value);
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     if (!query.next()) {
@@ -4610,9 +5498,17 @@ bool LocalStorageManagerPrivate::expungeSavedSearch(
             .arg(column, uid);
 
     QSqlQuery query(m_sqlDatabase);
-    res = query.exec(queryString);
+    res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
+    if (search.hasGuid()) {
+        m_guidLocalUidIndex.removeByGuid(
+            GuidLocalUidIndex::ObjectType::SavedSearch, search.guid());
+    }
+
+    m_guidLocalUidIndex.removeByLocalUid(
+        GuidLocalUidIndex::ObjectType::SavedSearch, search.localUid());
+
     return true;
 }
 
@@ -4624,41 +5520,137 @@ qint32 LocalStorageManagerPrivate::accountHighUsn(
         "LocalStorageManagerPrivate::accountHighUsn: linked notebook guid = "
             << linkedNotebookGuid);
 
-    qint32 updateSequenceNumber = 0;
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to get the account high update sequence number"));
 
-    QVector<HighUsnRequestData> tablesAndUsnColumns;
-    if (linkedNotebookGuid.isEmpty()) {
-        tablesAndUsnColumns.reserve(6);
-    }
-    else {
-        tablesAndUsnColumns.reserve(4);
+    // User's own account is denoted by empty linked notebook guid
+    // in AccountHighUsns table
+    const QString scope =
+        linkedNotebookGuid.isEmpty() ? QStringLiteral("") : linkedNotebookGuid;
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.prepare(
+        QStringLiteral("SELECT highUsn FROM AccountHighUsns "
+                       "WHERE linkedNotebookGuid = :linkedNotebookGuid"));
+
+    if (res) {
+        query.bindValue(QStringLiteral(":linkedNotebookGuid"), scope);
+        res = execQuery(query);
     }
 
-    QString queryCondition = QStringLiteral("WHERE linkedNotebookGuid");
-    if (linkedNotebookGuid.isEmpty()) {
-        queryCondition += QStringLiteral(" IS NULL");
+    if (!res) {
+        SET_ERROR();
+        return -1;
     }
-    else {
-        queryCondition +=
-            QString::fromUtf8("='%1'").arg(sqlEscapeString(linkedNotebookGuid));
+
+    bool hasCachedUsn = false;
+    qint32 cachedUsn = 0;
+    if (query.next()) {
+        cachedUsn = query.value(0).toInt(&hasCachedUsn);
+        if (!hasCachedUsn) {
+            SET_INT_CONVERSION_ERROR();
+            return -1;
+        }
+
+        if (!m_verifyAccountHighUsn) {
+            QNDEBUG("local_storage", "Cached max USN = " << cachedUsn);
+            return cachedUsn;
+        }
     }
 
-#define ADD_TABLE_AND_USN_COLUMN(tableName, usnColumnName)                     \
-    tablesAndUsnColumns << HighUsnRequestData(                                 \
-        tableName, usnColumnName, queryCondition)
+    query.finish();
 
-    ADD_TABLE_AND_USN_COLUMN(
-        QStringLiteral("Notebooks"), QStringLiteral("updateSequenceNumber"));
+    qint32 updateSequenceNumber =
+        accountHighUsnFromTables(linkedNotebookGuid, errorDescription);
 
-    ADD_TABLE_AND_USN_COLUMN(
-        QStringLiteral("Tags"), QStringLiteral("updateSequenceNumber"));
+    if (updateSequenceNumber < 0) {
+        return -1;
+    }
 
-    // Separate query condition is required for notes table
-    queryCondition = QStringLiteral(
-        "WHERE notebookLocalUid IN (SELECT DISTINCT localUid "
-        "FROM Notebooks WHERE linkedNotebookGuid");
-    if (linkedNotebookGuid.isEmpty()) {
-        queryCondition += QStringLiteral(" IS NULL)");
+    const bool cachedUsnMismatch =
+        hasCachedUsn && (cachedUsn != updateSequenceNumber);
+
+    if (cachedUsnMismatch) {
+        errorDescription.setBase(
+            QT_TR_NOOP("cached account high update sequence number doesn't "
+                       "match the one computed from the local storage "
+                       "tables"));
+        errorDescription.details() = QStringLiteral("cached ") +
+            QString::number(cachedUsn) + QStringLiteral(", actual ") +
+            QString::number(updateSequenceNumber);
+        QNWARNING("local_storage", errorDescription);
+    }
+
+    // Read-only connections cannot update the cache; the primary connection
+    // would do it on the next call
+    if (m_readOnly || (hasCachedUsn && !cachedUsnMismatch)) {
+        return cachedUsnMismatch ? -1 : updateSequenceNumber;
+    }
+
+    res = query.prepare(
+        QStringLiteral("INSERT OR REPLACE INTO AccountHighUsns"
+                       "(linkedNotebookGuid, highUsn) "
+                       "VALUES(:linkedNotebookGuid, :highUsn)"));
+
+    if (res) {
+        query.bindValue(QStringLiteral(":linkedNotebookGuid"), scope);
+        query.bindValue(QStringLiteral(":highUsn"), updateSequenceNumber);
+        res = execQuery(query);
+    }
+
+    if (!res) {
+        SET_ERROR();
+        return -1;
+    }
+
+    // In verification mode the mismatch is reported as error after
+    // the cached value is fixed
+    return cachedUsnMismatch ? -1 : updateSequenceNumber;
+}
+
+qint32 LocalStorageManagerPrivate::accountHighUsnFromTables(
+    const QString & linkedNotebookGuid, ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::accountHighUsnFromTables: linked "
+            << "notebook guid = " << linkedNotebookGuid);
+
+    qint32 updateSequenceNumber = 0;
+
+    QVector<HighUsnRequestData> tablesAndUsnColumns;
+    if (linkedNotebookGuid.isEmpty()) {
+        tablesAndUsnColumns.reserve(6);
+    }
+    else {
+        tablesAndUsnColumns.reserve(4);
+    }
+
+    QString queryCondition = QStringLiteral("WHERE linkedNotebookGuid");
+    if (linkedNotebookGuid.isEmpty()) {
+        queryCondition += QStringLiteral(" IS NULL");
+    }
+    else {
+        queryCondition +=
+            QString::fromUtf8("='%1'").arg(sqlEscapeString(linkedNotebookGuid));
+    }
+
+#define ADD_TABLE_AND_USN_COLUMN(tableName, usnColumnName)                     \
+    tablesAndUsnColumns << HighUsnRequestData(                                 \
+        tableName, usnColumnName, queryCondition)
+
+    ADD_TABLE_AND_USN_COLUMN(
+        QStringLiteral("Notebooks"), QStringLiteral("updateSequenceNumber"));
+
+    ADD_TABLE_AND_USN_COLUMN(
+        QStringLiteral("Tags"), QStringLiteral("updateSequenceNumber"));
+
+    // Separate query condition is required for notes table
+    queryCondition = QStringLiteral(
+        "WHERE notebookLocalUid IN (SELECT DISTINCT localUid "
+        "FROM Notebooks WHERE linkedNotebookGuid");
+    if (linkedNotebookGuid.isEmpty()) {
+        queryCondition += QStringLiteral(" IS NULL)");
     }
     else {
         queryCondition += QString::fromUtf8("='%1')").arg(
@@ -4753,7 +5745,7 @@ bool LocalStorageManagerPrivate::updateSequenceNumberFromTable(
     }
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     if (!query.next()) {
@@ -4789,266 +5781,253 @@ bool LocalStorageManagerPrivate::compactLocalStorage(
     ErrorString errorPrefix(QT_TR_NOOP("Can't compact local storage database"));
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(QStringLiteral("VACUUM"));
+    bool res = execQuery(query, QStringLiteral("VACUUM"));
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
 }
 
-void LocalStorageManagerPrivate::processPostTransactionException(
-    ErrorString message, QSqlError error)
+bool LocalStorageManagerPrivate::enableIncrementalVacuum(
+    ErrorString & errorDescription)
 {
-    QNERROR("local_storage", message << ": " << error);
-    message.details() += error.text();
-    throw DatabaseRequestException(message);
-}
+    QNDEBUG(
+        "local_storage", "LocalStorageManagerPrivate::enableIncrementalVacuum");
 
-bool LocalStorageManagerPrivate::addEnResource(
-    Resource & resource, ErrorString & errorDescription)
-{
     ErrorString errorPrefix(
-        QT_TR_NOOP("Can't add resource to the local storage database"));
-
-    ErrorString error;
-    if (!resource.checkParameters(error)) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(error.base());
-        errorDescription.appendBase(error.additionalBases());
-        errorDescription.details() = error.details();
-        QNWARNING("local_storage", "Found invalid resource: " << resource);
-        return false;
-    }
-
-    if (!resource.hasNoteGuid() && !resource.hasNoteLocalUid()) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(
-            QT_TR_NOOP("both resource's note local uid and note guid are "
-                       "empty"));
-        QNWARNING(
-            "local_storage", errorDescription << ", resource: " << resource);
-        return false;
-    }
+        QT_TR_NOOP("Can't enable incremental vacuum for local storage "
+                   "database"));
 
-    /**
-     * NOTE: since adding the resource is essentially the update of a note
-     * containing the resource, we might need to check if the notebook in which
-     * this note resides allows one to update its notes; however, there is no
-     * such check here because the request to update the note might come from
-     * the synchronization i.e. the note might have been updated via
-     * the official Evernote client which doesn't account for such minor issues
-     * as the notebooks' restriction to update the note
-     */
+    QSqlQuery query(m_sqlDatabase);
+    bool res =
+        execQuery(query, QStringLiteral("PRAGMA auto_vacuum = INCREMENTAL"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    // Now can continue with adding the resource
-    error.clear();
-    bool res = complementResourceNoteIds(resource, error);
-    if (!res) {
-        return false;
-    }
+    // The change of auto_vacuum mode takes effect for the existing database
+    // only after it is rebuilt by VACUUM
+    return compactLocalStorage(errorDescription);
+}
 
-    int resourceIndexInNote = -1;
+bool LocalStorageManagerPrivate::freePageStatistics(
+    LocalStorageManager::FreePageStatistics & statistics,
+    ErrorString & errorDescription) const
+{
+    QNDEBUG("local_storage", "LocalStorageManagerPrivate::freePageStatistics");
 
-    QString noteLocalUid = resource.noteLocalUid();
-    noteLocalUid = sqlEscapeString(noteLocalUid);
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't collect free page statistics of local storage "
+                   "database"));
 
-    QString queryString =
-        QString::fromUtf8(
-            "SELECT COUNT(*) FROM NoteResources WHERE localNote = '%1'")
-            .arg(noteLocalUid);
+    const std::pair<const char *, qint64 *> pragmas[] = {
+        {"page_size", &statistics.m_pageSize},
+        {"page_count", &statistics.m_pageCount},
+        {"freelist_count", &statistics.m_freePageCount}};
 
     QSqlQuery query(m_sqlDatabase);
-    res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+    for (const auto & pragma: pragmas) {
+        bool res = execQuery(
+            query, QStringLiteral("PRAGMA ") + QString::fromUtf8(pragma.first));
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        if (!query.next()) {
+            SET_ERROR();
+            return false;
+        }
 
-    if (query.next()) {
         bool conversionResult = false;
-        resourceIndexInNote = query.record().value(0).toInt(&conversionResult);
+        *pragma.second = query.value(0).toLongLong(&conversionResult);
         if (!conversionResult) {
             SET_INT_CONVERSION_ERROR();
             return false;
         }
     }
-    else {
-        resourceIndexInNote = 0;
-    }
 
-    resource.setIndexInNote(resourceIndexInNote);
+    bool res = execQuery(query, QStringLiteral("PRAGMA auto_vacuum"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    QString resourceLocalUid = resource.localUid();
+    // 2 stands for INCREMENTAL auto_vacuum mode
+    statistics.m_incrementalVacuumEnabled =
+        query.next() && (query.value(0).toInt() == 2);
 
-    QString column, uid;
-    bool shouldCheckResourceExistence = true;
+    return true;
+}
 
-    bool resourceHasGuid = resource.hasGuid();
-    if (resourceHasGuid) {
-        column = QStringLiteral("resourceGuid");
-        uid = resource.guid();
+qint64 LocalStorageManagerPrivate::reclaimFreePages(
+    const qint64 timeBudgetMsec, ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::reclaimFreePages: time budget = "
+            << timeBudgetMsec << " msec");
 
-        if (resourceLocalUid.isEmpty()) {
-            error.clear();
-            bool res = getResourceLocalUidForGuid(uid, resourceLocalUid, error);
-            if (res || !resourceLocalUid.isEmpty()) {
-                errorDescription.base() = errorPrefix.base();
-                errorDescription.appendBase(
-                    QT_TR_NOOP("resource already exists"));
-                errorDescription.details() = column;
-                errorDescription.details() += QStringLiteral(" = ");
-                errorDescription.details() += uid;
-                QNWARNING("local_storage", errorDescription);
-                return false;
-            }
+    QElapsedTimer timer;
+    timer.start();
 
-            resourceLocalUid = UidGenerator::Generate();
-            resource.setLocalUid(resourceLocalUid);
-            shouldCheckResourceExistence = false;
-        }
-    }
-    else {
-        column = QStringLiteral("resourceLocalUid");
-        uid = resource.localUid();
+    LocalStorageManager::FreePageStatistics statistics;
+    if (!freePageStatistics(statistics, errorDescription)) {
+        return -1;
     }
 
-    if (shouldCheckResourceExistence &&
-        rowExists(QStringLiteral("Resources"), column, uid))
-    {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(QT_TR_NOOP("resource already exists"));
-        errorDescription.details() = column;
-        errorDescription.details() += QStringLiteral(" = ");
-        errorDescription.details() += uid;
+    if (!statistics.m_incrementalVacuumEnabled) {
+        errorDescription.setBase(
+            QT_TR_NOOP("Can't reclaim free pages of local storage database: "
+                       "incremental vacuum is not enabled"));
         QNWARNING("local_storage", errorDescription);
-        return false;
+        return -1;
     }
 
-    error.clear();
-    res = insertOrReplaceResource(resource, error);
-    if (!res) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(error.base());
-        errorDescription.appendBase(error.additionalBases());
-        errorDescription.details() = error.details();
-        QNWARNING("local_storage", errorDescription);
-        return false;
+    qint64 freePageCount = statistics.m_freePageCount;
+    QSqlQuery query(m_sqlDatabase);
+
+    while ((freePageCount > 0) && (timer.elapsed() < timeBudgetMsec)) {
+        const qint64 pageCount =
+            std::min<qint64>(freePageCount, INCREMENTAL_VACUUM_PAGES_PER_STEP);
+
+        bool res = execQuery(
+            query,
+            QString::fromUtf8("PRAGMA incremental_vacuum(%1)")
+                .arg(QString::number(pageCount)));
+
+        if (!res) {
+            errorDescription.setBase(
+                QT_TR_NOOP("Can't reclaim free pages of local storage "
+                           "database"));
+            errorDescription.details() = query.lastError().text();
+            QNWARNING("local_storage", errorDescription);
+            return -1;
+        }
+
+        // The pragma frees one page per each result row so all of them need
+        // to be fetched for the whole step to be done
+        while (query.next()) {
+        }
+
+        query.finish();
+        freePageCount -= pageCount;
     }
 
-    return true;
+    if (!freePageStatistics(statistics, errorDescription)) {
+        return -1;
+    }
+
+    QNDEBUG(
+        "local_storage",
+        "Remaining free pages after reclaiming: "
+            << statistics.m_freePageCount << ", spent " << timer.elapsed()
+            << " msec");
+
+    return statistics.m_freePageCount;
 }
 
-bool LocalStorageManagerPrivate::updateEnResource(
-    Resource & resource, ErrorString & errorDescription)
+bool LocalStorageManagerPrivate::createSnapshot(
+    const QString & snapshotDirPath, ErrorString & errorDescription)
 {
+    QNINFO(
+        "local_storage",
+        "LocalStorageManagerPrivate::createSnapshot: " << snapshotDirPath);
+
     ErrorString errorPrefix(
-        QT_TR_NOOP("Can't update resource in the local storage database"));
+        QT_TR_NOOP("Can't create snapshot of the local storage"));
 
-    ErrorString error;
-    if (!resource.checkParameters(error)) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(error.base());
-        errorDescription.appendBase(error.additionalBases());
-        errorDescription.details() = error.details();
-        QNWARNING("local_storage", "Found invalid resource: " << resource);
+    // VACUUM INTO can't be run within a transaction
+    if (Q_UNLIKELY(m_transactionNestingLevel > 0)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("a transaction is open on the local storage"));
+        QNWARNING("local_storage", errorDescription);
         return false;
     }
 
-    if (!resource.hasNoteGuid() && !resource.hasNoteLocalUid()) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(QT_TR_NOOP(
-            "both resource's note local uid and note guid are empty"));
-        QNWARNING(
-            "local_storage", errorDescription << ", resource: " << resource);
-        return false;
+    // VACUUM INTO is only supported since SQLite 3.27.0
+    QString sqliteVersion;
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(QStringLiteral("SELECT sqlite_version()"));
+    if (res && query.next()) {
+        sqliteVersion = query.value(0).toString();
     }
-
-    /**
-     * NOTE: since updating the resource is essentially the update of a note
-     * containing the resource, we might need to check if the notebook in which
-     * this note resides allows one to update its notes; however, there is no
-     * such check here because the request to update the note might come from
-     * the synchronization i.e. the note might have been updated via
-     * the official Evernote client which doesn't account for such minor issues
-     * as the notebooks' restriction to update the note
-     */
-
-    // Now can continue with updating the resource
-    error.clear();
-    bool res = complementResourceNoteIds(resource, error);
-    if (!res) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(error.base());
-        errorDescription.appendBase(error.additionalBases());
-        errorDescription.details() = error.details();
+    else {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("failed to find out the version of SQLite"));
+        errorDescription.details() = query.lastError().text();
         QNWARNING("local_storage", errorDescription);
         return false;
     }
 
-    QString resourceLocalUid = resource.localUid();
+    query.finish();
 
-    QString column, uid;
-    bool shouldCheckResourceExistence = true;
+    const QStringList sqliteVersionParts =
+        sqliteVersion.split(QChar::fromLatin1('.'));
 
-    bool resourceHasGuid = resource.hasGuid();
-    if (resourceHasGuid) {
-        column = QStringLiteral("resourceGuid");
-        uid = resource.guid();
+    const int sqliteMajorVersion =
+        (sqliteVersionParts.size() > 0 ? sqliteVersionParts[0].toInt() : 0);
 
-        if (resourceLocalUid.isEmpty()) {
-            error.clear();
-            bool res = getResourceLocalUidForGuid(uid, resourceLocalUid, error);
-            if (!res || resourceLocalUid.isEmpty()) {
-                errorDescription.base() = errorPrefix.base();
-                errorDescription.appendBase(
-                    QT_TR_NOOP("resource to be updated was not found in "
-                               "the local storage database"));
-                errorDescription.details() = column;
-                errorDescription.details() += QStringLiteral(" = ");
-                errorDescription.details() += uid;
-                QNWARNING("local_storage", errorDescription);
-                return false;
-            }
+    const int sqliteMinorVersion =
+        (sqliteVersionParts.size() > 1 ? sqliteVersionParts[1].toInt() : 0);
 
-            resource.setLocalUid(resourceLocalUid);
-            shouldCheckResourceExistence = false;
-        }
+    if ((sqliteMajorVersion < 3) ||
+        ((sqliteMajorVersion == 3) && (sqliteMinorVersion < 27)))
+    {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("snapshots are not supported by the version of SQLite "
+                       "in use, SQLite 3.27.0 or newer is required"));
+        errorDescription.details() = sqliteVersion;
+        QNWARNING("local_storage", errorDescription);
+        return false;
     }
-    else {
-        column = QStringLiteral("resourceLocalUid");
-        uid = resource.localUid();
+
+    QDir snapshotDir(snapshotDirPath);
+    if (!snapshotDir.exists() && !snapshotDir.mkpath(snapshotDirPath)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("failed to create folder for the snapshot"));
+        errorDescription.details() = QDir::toNativeSeparators(snapshotDirPath);
+        QNWARNING("local_storage", errorDescription);
+        return false;
     }
 
-    if (shouldCheckResourceExistence &&
-        !rowExists(QStringLiteral("Resources"), column, uid))
-    {
-        bool foundByOtherColumn = false;
+    const QString snapshotDatabaseFilePath = snapshotDir.absoluteFilePath(
+        QStringLiteral(QUENTIER_DATABASE_NAME));
 
-        if (resourceHasGuid) {
-            QNDEBUG(
-                "local_storage",
-                "Failed to find the resource by guid "
-                    << "within the local storage, trying to find it by local "
-                       "uid");
-            column = QStringLiteral("resourceLocalUid");
-            uid = resource.localUid();
-            foundByOtherColumn =
-                rowExists(QStringLiteral("Resources"), column, uid);
-        }
+    if (QFileInfo::exists(snapshotDatabaseFilePath)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("the snapshot folder already contains database file"));
+        errorDescription.details() =
+            QDir::toNativeSeparators(snapshotDatabaseFilePath);
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
 
-        if (!foundByOtherColumn) {
-            errorDescription.base() = errorPrefix.base();
-            errorDescription.appendBase(
-                QT_TR_NOOP("resource to be updated was not found in the local "
-                           "storage database"));
-            errorDescription.details() = column;
-            errorDescription.details() += QStringLiteral(" = ");
-            errorDescription.details() += uid;
-            QNWARNING("local_storage", errorDescription);
-            return false;
-        }
+    // Must be registered before the database is read so that blob files
+    // referenced from the snapshot are not removed until they are linked
+    SnapshotInProgressGuard snapshotInProgressGuard(m_databaseFilePath);
+
+    Q_EMIT snapshotProgress(0.0);
+
+    res = query.prepare(QStringLiteral("VACUUM INTO ?"));
+    if (res) {
+        query.addBindValue(snapshotDatabaseFilePath);
+        res = execQuery(query);
     }
 
-    error.clear();
-    res = insertOrReplaceResource(resource, error);
     if (!res) {
-        errorDescription.base() = errorPrefix.base();
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(QT_TR_NOOP("failed to copy the database"));
+        errorDescription.details() = query.lastError().text();
+        QNWARNING("local_storage", errorDescription);
+        Q_UNUSED(removeFile(snapshotDatabaseFilePath))
+        return false;
+    }
+
+    query.finish();
+
+    QStringList blobHashes;
+    ErrorString error;
+    if (!listSnapshotResourceBlobHashes(
+            snapshotDatabaseFilePath, blobHashes, error))
+    {
+        errorDescription = errorPrefix;
         errorDescription.appendBase(error.base());
         errorDescription.appendBase(error.additionalBases());
         errorDescription.details() = error.details();
@@ -5056,301 +6035,2087 @@ bool LocalStorageManagerPrivate::updateEnResource(
         return false;
     }
 
+    // Progress is measured in bytes: the database copy is already done,
+    // blob files are counted as they are linked or copied
+    const QString storagePath = accountPersistentStoragePath(m_currentAccount);
+
+    QStringList blobFilePaths;
+    blobFilePaths.reserve(blobHashes.size());
+
+    QVector<qint64> blobFileSizes;
+    blobFileSizes.reserve(blobHashes.size());
+
+    qint64 totalSize = QFileInfo(snapshotDatabaseFilePath).size();
+    qint64 doneSize = totalSize;
+
+    for (const auto & blobHash: qAsConst(blobHashes)) {
+        QString blobFilePath = resourceBlobFilePath(blobHash);
+        QFileInfo blobFileInfo(blobFilePath);
+        if (Q_UNLIKELY(!blobFileInfo.exists())) {
+            QNWARNING(
+                "local_storage",
+                "Resource data blob file referenced from the database doesn't "
+                    << "exist, it won't be in the snapshot: "
+                    << blobFilePath);
+            continue;
+        }
+
+        blobFilePaths << blobFilePath;
+        blobFileSizes << blobFileInfo.size();
+        totalSize += blobFileInfo.size();
+    }
+
+    if (totalSize > 0) {
+        Q_EMIT snapshotProgress(
+            static_cast<double>(doneSize) / static_cast<double>(totalSize));
+    }
+
+    for (int i = 0, size = blobFilePaths.size(); i < size; ++i) {
+        const QString & blobFilePath = blobFilePaths[i];
+
+        QString snapshotBlobFilePath =
+            snapshotDir.absolutePath() + blobFilePath.mid(storagePath.size());
+
+        QFileInfo snapshotBlobFileInfo(snapshotBlobFilePath);
+        QDir snapshotBlobDir = snapshotBlobFileInfo.absoluteDir();
+        if (!snapshotBlobDir.exists() &&
+            !snapshotBlobDir.mkpath(snapshotBlobDir.absolutePath()))
+        {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(QT_TR_NOOP(
+                "failed to create folder for resource data blob files"));
+            errorDescription.details() =
+                QDir::toNativeSeparators(snapshotBlobDir.absolutePath());
+            QNWARNING("local_storage", errorDescription);
+            return false;
+        }
+
+        error.clear();
+        if (!snapshotBlobFileInfo.exists() &&
+            !linkOrCopyFile(blobFilePath, snapshotBlobFilePath, error))
+        {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            QNWARNING("local_storage", errorDescription);
+            return false;
+        }
+
+        doneSize += blobFileSizes[i];
+        Q_EMIT snapshotProgress(
+            static_cast<double>(doneSize) / static_cast<double>(totalSize));
+    }
+
+    Q_EMIT snapshotProgress(1.0);
+
+    QNINFO(
+        "local_storage",
+        "Created snapshot of the local storage with "
+            << blobFilePaths.size() << " resource data blob files, "
+            << totalSize << " bytes in total");
+
     return true;
 }
 
-void LocalStorageManagerPrivate::unlockDatabaseFile()
+bool LocalStorageManagerPrivate::listSnapshotResourceBlobHashes(
+    const QString & snapshotDatabaseFilePath, QStringList & blobHashes,
+    ErrorString & errorDescription) const
+{
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to list resource data blobs of the snapshot"));
+
+    static QAtomicInt snapshotConnectionCounter;
+    const QString connectionName =
+        QStringLiteral("quentier_sqlite_snapshot_connection_") +
+        QString::number(snapshotConnectionCounter.fetchAndAddOrdered(1));
+
+    bool res = false;
+
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(
+            m_sqlDatabase.driverName(), connectionName);
+
+        database.setDatabaseName(snapshotDatabaseFilePath);
+        database.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+
+        res = database.open();
+        if (!res) {
+            errorDescription = errorPrefix;
+            errorDescription.details() = database.lastError().text();
+        }
+        else {
+            // Rows of orphan blobs might still be present, their files might
+            // be already removed
+            QSqlQuery query(database);
+            res = query.exec(QStringLiteral(
+                "SELECT blobHash FROM ResourceBlobs WHERE refCount > 0"));
+            if (!res) {
+                errorDescription = errorPrefix;
+                errorDescription.details() = query.lastError().text();
+            }
+            else {
+                while (query.next()) {
+                    blobHashes << query.value(0).toString();
+                }
+            }
+        }
+
+        database.close();
+    }
+
+    QSqlDatabase::removeDatabase(connectionName);
+    return res;
+}
+
+bool LocalStorageManagerPrivate::createFullTextSearchIndexTriggers(
+    ErrorString & errorDescription)
 {
     QNDEBUG(
         "local_storage",
-        "LocalStorageManagerPrivate::unlockDatabaseFile: "
-            << m_databaseFilePath);
+        "LocalStorageManagerPrivate::createFullTextSearchIndexTriggers");
 
-#ifndef Q_OS_WIN
-    if (m_databaseFilePath.isEmpty()) {
-        QNDEBUG("local_storage", "No database file, nothing to do");
-        return;
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't create trigger maintaining full text search index"));
+
+    // All FTS tables are external content ones so the triggers need to keep
+    // them in sync with content tables. Only the index entries of the affected
+    // row are touched so the cost of a write doesn't depend on the table size.
+    // Deletion from FTS4 external content table needs the original row to be
+    // still present in the content table so deletions are done in BEFORE
+    // triggers. INSERT OR REPLACE doesn't fire delete triggers for replaced
+    // rows (unless recursive triggers are enabled) so the index entries of rows
+    // which are about to be replaced are removed by BEFORE INSERT trigger.
+    const auto createTriggers = [&](const QString & ftsTableName,
+                                    const QString & contentTableName,
+                                    const QStringList & columns,
+                                    const QString & replacedRowsCondition) {
+        QString columnNames = columns.join(QStringLiteral(", "));
+
+        QStringList newValuesList;
+        newValuesList.reserve(columns.size());
+        for (const auto & column: qAsConst(columns)) {
+            newValuesList << (QStringLiteral("new.") + column);
+        }
+
+        QString newValues = newValuesList.join(QStringLiteral(", "));
+
+        QSqlQuery query(m_sqlDatabase);
+        bool res = true;
+
+        if (!replacedRowsCondition.isEmpty()) {
+            res = query.exec(
+                QString::fromUtf8("CREATE TRIGGER IF NOT EXISTS "
+                                  "%1_BeforeInsertTrigger "
+                                  "BEFORE INSERT ON %2 "
+                                  "BEGIN "
+                                  "DELETE FROM %1 WHERE docid IN "
+                                  "(SELECT rowid FROM %2 WHERE %3); "
+                                  "END")
+                    .arg(ftsTableName, contentTableName,
+                         replacedRowsCondition));
+            DATABASE_CHECK_AND_SET_ERROR()
+        }
+
+        res = query.exec(QString::fromUtf8("CREATE TRIGGER IF NOT EXISTS "
+                                           "%1_AfterInsertTrigger "
+                                           "AFTER INSERT ON %2 "
+                                           "BEGIN "
+                                           "INSERT INTO %1(docid, %3) "
+                                           "VALUES(new.rowid, %4); "
+                                           "END")
+                             .arg(
+                                 ftsTableName, contentTableName, columnNames,
+                                 newValues));
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        res = query.exec(QString::fromUtf8("CREATE TRIGGER IF NOT EXISTS "
+                                           "%1_BeforeUpdateTrigger "
+                                           "BEFORE UPDATE OF %3 ON %2 "
+                                           "BEGIN "
+                                           "DELETE FROM %1 "
+                                           "WHERE docid=old.rowid; "
+                                           "END")
+                             .arg(ftsTableName, contentTableName, columnNames));
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        res = query.exec(QString::fromUtf8("CREATE TRIGGER IF NOT EXISTS "
+                                           "%1_AfterUpdateTrigger "
+                                           "AFTER UPDATE OF %3 ON %2 "
+                                           "BEGIN "
+                                           "INSERT INTO %1(docid, %3) "
+                                           "VALUES(new.rowid, %4); "
+                                           "END")
+                             .arg(
+                                 ftsTableName, contentTableName, columnNames,
+                                 newValues));
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        res = query.exec(QString::fromUtf8("CREATE TRIGGER IF NOT EXISTS "
+                                           "%1_BeforeDeleteTrigger "
+                                           "BEFORE DELETE ON %2 "
+                                           "BEGIN "
+                                           "DELETE FROM %1 "
+                                           "WHERE docid=old.rowid; "
+                                           "END")
+                             .arg(ftsTableName, contentTableName));
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        return true;
+    };
+
+    bool res = createTriggers(
+        QStringLiteral("NotebookFTS"), QStringLiteral("Notebooks"),
+        QStringList() << QStringLiteral("localUid") << QStringLiteral("guid")
+                      << QStringLiteral("notebookName"),
+        QStringLiteral("localUid=new.localUid OR guid=new.guid OR "
+                       "isDefault=new.isDefault OR "
+                       "isLastUsed=new.isLastUsed OR "
+                       "(notebookNameUpper=new.notebookNameUpper AND "
+                       "linkedNotebookGuid=new.linkedNotebookGuid)"));
+    if (!res) {
+        return false;
     }
 
-    try {
-        m_databaseFileLock.unlock();
+    res = createTriggers(
+        QStringLiteral("NoteFTS"), QStringLiteral("Notes"),
+        QStringList() << QStringLiteral("localUid")
+                      << QStringLiteral("titleNormalized")
+                      << QStringLiteral("contentListOfWords")
+                      << QStringLiteral("contentContainsFinishedToDo")
+                      << QStringLiteral("contentContainsUnfinishedToDo")
+                      << QStringLiteral("contentContainsEncryption")
+                      << QStringLiteral("creationTimestamp")
+                      << QStringLiteral("modificationTimestamp")
+                      << QStringLiteral("isActive")
+                      << QStringLiteral("notebookLocalUid")
+                      << QStringLiteral("notebookGuid")
+                      << QStringLiteral("subjectDate")
+                      << QStringLiteral("latitude")
+                      << QStringLiteral("longitude")
+                      << QStringLiteral("altitude") << QStringLiteral("author")
+                      << QStringLiteral("source")
+                      << QStringLiteral("sourceApplication")
+                      << QStringLiteral("reminderOrder")
+                      << QStringLiteral("reminderDoneTime")
+                      << QStringLiteral("reminderTime")
+                      << QStringLiteral("placeName")
+                      << QStringLiteral("contentClass")
+                      << QStringLiteral("applicationDataKeysOnly")
+                      << QStringLiteral("applicationDataKeysMap")
+                      << QStringLiteral("applicationDataValues"),
+        QStringLiteral("localUid=new.localUid OR guid=new.guid"));
+    if (!res) {
+        return false;
     }
-    catch (boost::interprocess::interprocess_exception & exc) {
-        QNWARNING(
-            "local_storage",
-            "Caught exception trying to unlock "
-                << "the database file: error = " << exc.get_error_code()
-                << ", error message = " << exc.what()
-                << "; native error = " << exc.get_native_error());
+
+    res = createTriggers(
+        QStringLiteral("ResourceRecognitionDataFTS"),
+        QStringLiteral("ResourceRecognitionData"),
+        QStringList() << QStringLiteral("resourceLocalUid")
+                      << QStringLiteral("noteLocalUid")
+                      << QStringLiteral("recognitionData"),
+        QString());
+    if (!res) {
+        return false;
     }
-#endif
+
+    res = createTriggers(
+        QStringLiteral("ResourceMimeFTS"), QStringLiteral("Resources"),
+        QStringList() << QStringLiteral("resourceLocalUid")
+                      << QStringLiteral("mime"),
+        QStringLiteral("resourceLocalUid=new.resourceLocalUid OR "
+                       "resourceGuid=new.resourceGuid"));
+    if (!res) {
+        return false;
+    }
+
+    return createTriggers(
+        QStringLiteral("TagFTS"), QStringLiteral("Tags"),
+        QStringList() << QStringLiteral("localUid") << QStringLiteral("guid")
+                      << QStringLiteral("nameLower"),
+        QStringLiteral("localUid=new.localUid OR guid=new.guid OR "
+                       "(nameLower=new.nameLower AND "
+                       "linkedNotebookGuid=new.linkedNotebookGuid)"));
 }
 
-bool LocalStorageManagerPrivate::createTables(ErrorString & errorDescription)
+bool LocalStorageManagerPrivate::createResourceBlobStoreTables(
+    ErrorString & errorDescription)
 {
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::createResourceBlobStoreTables");
+
+    // Resource binary data is stored in files named after MD5 hashes of their
+    // contents so that identical data bodies of different resources are only
+    // stored once. Each blob keeps the number of references to it from
+    // resources, the blobs which are no longer referenced are removed after
+    // the transaction which removed the last reference is committed
+    ErrorString errorPrefix(QT_TR_NOOP("Can't create ResourceBlobs table"));
+
     QSqlQuery query(m_sqlDatabase);
-    bool res;
+    bool res = query.exec(
+        QStringLiteral("CREATE TABLE IF NOT EXISTS ResourceBlobs("
+                       "  blobHash                TEXT PRIMARY KEY NOT NULL "
+                       "UNIQUE, "
+                       "  refCount                INTEGER NOT NULL DEFAULT 0"
+                       ")"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(
+        QStringLiteral("CREATE INDEX IF NOT EXISTS ResourceBlobsRefCountIndex "
+                       "ON ResourceBlobs(refCount)"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create ResourceBlobsRefCountIndex index"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    // Checking whether auxiliary table exists
     res = query.exec(QStringLiteral(
-        "SELECT name FROM sqlite_master WHERE name='Auxiliary'"));
+        "CREATE TABLE IF NOT EXISTS ResourceBlobReferences("
+        "  resourceLocalUid REFERENCES Resources(resourceLocalUid) "
+        "ON UPDATE CASCADE, "
+        "  isAlternateData         INTEGER NOT NULL, "
+        "  blobHash REFERENCES ResourceBlobs(blobHash), "
+        "  UNIQUE(resourceLocalUid, isAlternateData)"
+        ")"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create ResourceBlobReferences table"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    ErrorString errorPrefix(
-        QT_TR_NOOP("Can't check whether Auxiliary table exists"));
+    res = query.exec(QStringLiteral(
+        "CREATE TRIGGER IF NOT EXISTS "
+        "ResourceBlobReferences_AfterInsertTrigger "
+        "AFTER INSERT ON ResourceBlobReferences "
+        "BEGIN "
+        "UPDATE ResourceBlobs SET refCount = refCount + 1 "
+        "WHERE blobHash = new.blobHash; "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger to fire on resource blob reference "
+                   "insertion"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
+    res = query.exec(QStringLiteral(
+        "CREATE TRIGGER IF NOT EXISTS "
+        "ResourceBlobReferences_AfterDeleteTrigger "
+        "AFTER DELETE ON ResourceBlobReferences "
+        "BEGIN "
+        "UPDATE ResourceBlobs SET refCount = refCount - 1 "
+        "WHERE blobHash = old.blobHash; "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger to fire on resource blob reference "
+                   "deletion"));
     DATABASE_CHECK_AND_SET_ERROR()
-    bool auxiliaryTableExists = query.next();
 
+    // NOTE: resources are deleted along with notes, notebooks and linked
+    // notebooks via triggers so this one covers all of these cases
+    res = query.exec(QStringLiteral(
+        "CREATE TRIGGER IF NOT EXISTS "
+        "on_resource_delete_blob_references_trigger "
+        "BEFORE DELETE ON Resources "
+        "BEGIN "
+        "DELETE FROM ResourceBlobReferences "
+        "WHERE ResourceBlobReferences.resourceLocalUid="
+        "OLD.resourceLocalUid; "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger removing resource blob references on "
+                   "resource deletion"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::createNoteCounterTables(
+    ErrorString & errorDescription)
+{
     QNDEBUG(
         "local_storage",
-        "Auxiliary table "
-            << (auxiliaryTableExists ? "already exists" : "doesn't exist yet"));
+        "LocalStorageManagerPrivate::createNoteCounterTables");
+
+    // The numbers of deleted and non-deleted notes per notebook and per tag
+    // are maintained by triggers so that counting notes doesn't require
+    // the aggregation over all notes. INSERT OR REPLACE doesn't fire delete
+    // triggers for replaced rows (unless recursive triggers are enabled) so
+    // the replaced rows are subtracted from counters by BEFORE INSERT
+    // triggers. The conflict resolution of the statement which fired
+    // the trigger overrides the one of statements within the trigger so
+    // the rows of counters are inserted only if they don't exist yet rather
+    // than via INSERT OR IGNORE.
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't create NotebookNoteCounters table"));
 
-    if (!auxiliaryTableExists) {
-        res = query.exec(
-            QStringLiteral("CREATE TABLE Auxiliary("
-                           "  lock    CHAR(1) PRIMARY KEY  NOT NULL DEFAULT "
-                           "'X' CHECK (lock='X'), "
-                           "  version INTEGER              NOT NULL DEFAULT 2"
-                           ")"));
-        errorPrefix.setBase(QT_TR_NOOP("Can't create Auxiliary table"));
-        DATABASE_CHECK_AND_SET_ERROR()
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS NotebookNoteCounters("
+        "  notebookLocalUid        TEXT PRIMARY KEY NOT NULL UNIQUE, "
+        "  nonDeletedNoteCount     INTEGER NOT NULL DEFAULT 0, "
+        "  deletedNoteCount        INTEGER NOT NULL DEFAULT 0"
+        ")"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-        res = query.exec(
-            QStringLiteral("INSERT INTO Auxiliary (version) VALUES(2)"));
-        errorPrefix.setBase(QT_TR_NOOP("Can't set version to Auxiliary table"));
-        DATABASE_CHECK_AND_SET_ERROR()
-    }
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS TagNoteCounters("
+        "  tagLocalUid             TEXT PRIMARY KEY NOT NULL UNIQUE, "
+        "  nonDeletedNoteCount     INTEGER NOT NULL DEFAULT 0, "
+        "  deletedNoteCount        INTEGER NOT NULL DEFAULT 0"
+        ")"));
+    errorPrefix.setBase(QT_TR_NOOP("Can't create TagNoteCounters table"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS Users("
-        "  id                           INTEGER PRIMARY KEY NOT NULL UNIQUE, "
-        "  username                     TEXT                DEFAULT NULL, "
-        "  email                        TEXT                DEFAULT NULL, "
-        "  name                         TEXT                DEFAULT NULL, "
-        "  timezone                     TEXT                DEFAULT NULL, "
-        "  privilege                    INTEGER             DEFAULT NULL, "
-        "  serviceLevel                 INTEGER             DEFAULT NULL, "
-        "  userCreationTimestamp        INTEGER             DEFAULT NULL, "
-        "  userModificationTimestamp    INTEGER             DEFAULT NULL, "
-        "  userIsDirty                  INTEGER             NOT NULL, "
-        "  userIsLocal                  INTEGER             NOT NULL, "
-        "  userDeletionTimestamp        INTEGER             DEFAULT NULL, "
-        "  userIsActive                 INTEGER             DEFAULT NULL, "
-        "  userShardId                  TEXT                DEFAULT NULL, "
-        "  userPhotoUrl                 TEXT                DEFAULT NULL, "
-        "  userPhotoLastUpdateTimestamp INTEGER             DEFAULT NULL"
-        ")"));
-    errorPrefix.setBase(QT_TR_NOOP("Can't create Users table"));
+        "CREATE TRIGGER IF NOT EXISTS "
+        "NoteCounters_NotesBeforeInsertTrigger "
+        "BEFORE INSERT ON Notes "
+        "BEGIN "
+        "UPDATE NotebookNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount - "
+        "(SELECT COUNT(*) FROM Notes "
+        "WHERE (localUid=new.localUid OR guid=new.guid) AND "
+        "Notes.notebookLocalUid=NotebookNoteCounters.notebookLocalUid AND "
+        "deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount - "
+        "(SELECT COUNT(*) FROM Notes "
+        "WHERE (localUid=new.localUid OR guid=new.guid) AND "
+        "Notes.notebookLocalUid=NotebookNoteCounters.notebookLocalUid AND "
+        "deletionTimestamp IS NOT NULL) "
+        "WHERE notebookLocalUid IN (SELECT notebookLocalUid FROM Notes "
+        "WHERE localUid=new.localUid OR guid=new.guid); "
+        "UPDATE TagNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount - "
+        "(SELECT COUNT(*) FROM NoteTags INNER JOIN Notes "
+        "ON NoteTags.localNote=Notes.localUid "
+        "WHERE (Notes.localUid=new.localUid OR Notes.guid=new.guid) AND "
+        "NoteTags.localTag=TagNoteCounters.tagLocalUid AND "
+        "Notes.deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount - "
+        "(SELECT COUNT(*) FROM NoteTags INNER JOIN Notes "
+        "ON NoteTags.localNote=Notes.localUid "
+        "WHERE (Notes.localUid=new.localUid OR Notes.guid=new.guid) AND "
+        "NoteTags.localTag=TagNoteCounters.tagLocalUid AND "
+        "Notes.deletionTimestamp IS NOT NULL) "
+        "WHERE tagLocalUid IN (SELECT localTag FROM NoteTags "
+        "WHERE localNote IN (SELECT localUid FROM Notes "
+        "WHERE localUid=new.localUid OR guid=new.guid)); "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger updating note counters before note "
+                   "insertion"));
     DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS UserAttributes("
-        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
-        "  defaultLocationName        TEXT                  DEFAULT NULL, "
-        "  defaultLatitude            REAL                  DEFAULT NULL, "
-        "  defaultLongitude           REAL                  DEFAULT NULL, "
-        "  preactivation              INTEGER               DEFAULT NULL, "
-        "  incomingEmailAddress       TEXT                  DEFAULT NULL, "
-        "  comments                   TEXT                  DEFAULT NULL, "
-        "  dateAgreedToTermsOfService INTEGER               DEFAULT NULL, "
-        "  maxReferrals               INTEGER               DEFAULT NULL, "
-        "  referralCount              INTEGER               DEFAULT NULL, "
-        "  refererCode                TEXT                  DEFAULT NULL, "
-        "  sentEmailDate              INTEGER               DEFAULT NULL, "
-        "  sentEmailCount             INTEGER               DEFAULT NULL, "
-        "  dailyEmailLimit            INTEGER               DEFAULT NULL, "
-        "  emailOptOutDate            INTEGER               DEFAULT NULL, "
-        "  partnerEmailOptInDate      INTEGER               DEFAULT NULL, "
-        "  preferredLanguage          TEXT                  DEFAULT NULL, "
-        "  preferredCountry           TEXT                  DEFAULT NULL, "
-        "  clipFullPage               INTEGER               DEFAULT NULL, "
-        "  twitterUserName            TEXT                  DEFAULT NULL, "
-        "  twitterId                  TEXT                  DEFAULT NULL, "
-        "  groupName                  TEXT                  DEFAULT NULL, "
-        "  recognitionLanguage        TEXT                  DEFAULT NULL, "
-        "  referralProof              TEXT                  DEFAULT NULL, "
-        "  educationalDiscount        INTEGER               DEFAULT NULL, "
-        "  businessAddress            TEXT                  DEFAULT NULL, "
-        "  hideSponsorBilling         INTEGER               DEFAULT NULL, "
-        "  useEmailAutoFiling         INTEGER               DEFAULT NULL, "
-        "  reminderEmailConfig        INTEGER               DEFAULT NULL, "
-        "  emailAddressLastConfirmed  INTEGER               DEFAULT NULL, "
-        "  passwordUpdated            INTEGER               DEFAULT NULL, "
-        "  salesforcePushEnabled      INTEGER               DEFAULT NULL, "
-        "  shouldLogClientEvent       INTEGER               DEFAULT NULL)"));
-    errorPrefix.setBase(QT_TR_NOOP("Can't create UserAttributes table"));
+        "CREATE TRIGGER IF NOT EXISTS "
+        "NoteCounters_NotesAfterInsertTrigger "
+        "AFTER INSERT ON Notes "
+        "BEGIN "
+        "INSERT INTO NotebookNoteCounters(notebookLocalUid) "
+        "SELECT new.notebookLocalUid WHERE new.notebookLocalUid IS NOT NULL "
+        "AND NOT EXISTS (SELECT 1 FROM NotebookNoteCounters "
+        "WHERE notebookLocalUid=new.notebookLocalUid); "
+        "UPDATE NotebookNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount + "
+        "(new.deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount + "
+        "(new.deletionTimestamp IS NOT NULL) "
+        "WHERE notebookLocalUid=new.notebookLocalUid; "
+        "UPDATE TagNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount + "
+        "(new.deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount + "
+        "(new.deletionTimestamp IS NOT NULL) "
+        "WHERE tagLocalUid IN (SELECT localTag FROM NoteTags "
+        "WHERE localNote=new.localUid); "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger updating note counters after note "
+                   "insertion"));
     DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS UserAttributesViewedPromotions("
-        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
-        "  promotion               TEXT                    DEFAULT NULL)"));
+        "CREATE TRIGGER IF NOT EXISTS "
+        "NoteCounters_NotesAfterUpdateTrigger "
+        "AFTER UPDATE OF notebookLocalUid, deletionTimestamp ON Notes "
+        "BEGIN "
+        "UPDATE NotebookNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount - "
+        "(old.deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount - "
+        "(old.deletionTimestamp IS NOT NULL) "
+        "WHERE notebookLocalUid=old.notebookLocalUid; "
+        "INSERT INTO NotebookNoteCounters(notebookLocalUid) "
+        "SELECT new.notebookLocalUid WHERE new.notebookLocalUid IS NOT NULL "
+        "AND NOT EXISTS (SELECT 1 FROM NotebookNoteCounters "
+        "WHERE notebookLocalUid=new.notebookLocalUid); "
+        "UPDATE NotebookNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount + "
+        "(new.deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount + "
+        "(new.deletionTimestamp IS NOT NULL) "
+        "WHERE notebookLocalUid=new.notebookLocalUid; "
+        "UPDATE TagNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount - "
+        "(old.deletionTimestamp IS NULL) + (new.deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount - "
+        "(old.deletionTimestamp IS NOT NULL) + "
+        "(new.deletionTimestamp IS NOT NULL) "
+        "WHERE tagLocalUid IN (SELECT localTag FROM NoteTags "
+        "WHERE localNote=new.localUid); "
+        "END"));
     errorPrefix.setBase(
-        QT_TR_NOOP("Can't create UserAttributesViewedPromotions table"));
+        QT_TR_NOOP("Can't create trigger updating note counters after note "
+                   "update"));
     DATABASE_CHECK_AND_SET_ERROR()
 
+    // NOTE: note's tags are removed by on_note_delete_trigger while the note
+    // still exists so tag counters are updated by the trigger on NoteTags
     res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS UserAttributesRecentMailedAddresses("
-        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
-        "  address                 TEXT                    DEFAULT NULL)"));
+        "CREATE TRIGGER IF NOT EXISTS "
+        "NoteCounters_NotesAfterDeleteTrigger "
+        "AFTER DELETE ON Notes "
+        "BEGIN "
+        "UPDATE NotebookNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount - "
+        "(old.deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount - "
+        "(old.deletionTimestamp IS NOT NULL) "
+        "WHERE notebookLocalUid=old.notebookLocalUid; "
+        "END"));
     errorPrefix.setBase(
-        QT_TR_NOOP("Can't create UserAttributesRecentMailedAddresses table"));
+        QT_TR_NOOP("Can't create trigger updating note counters after note "
+                   "deletion"));
     DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS Accounting("
-        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
-        "  uploadLimitEnd              INTEGER             DEFAULT NULL, "
-        "  uploadLimitNextMonth        INTEGER             DEFAULT NULL, "
-        "  premiumServiceStatus        INTEGER             DEFAULT NULL, "
-        "  premiumOrderNumber          TEXT                DEFAULT NULL, "
-        "  premiumCommerceService      TEXT                DEFAULT NULL, "
-        "  premiumServiceStart         INTEGER             DEFAULT NULL, "
-        "  premiumServiceSKU           TEXT                DEFAULT NULL, "
-        "  lastSuccessfulCharge        INTEGER             DEFAULT NULL, "
-        "  lastFailedCharge            INTEGER             DEFAULT NULL, "
-        "  lastFailedChargeReason      TEXT                DEFAULT NULL, "
-        "  nextPaymentDue              INTEGER             DEFAULT NULL, "
-        "  premiumLockUntil            INTEGER             DEFAULT NULL, "
-        "  updated                     INTEGER             DEFAULT NULL, "
-        "  premiumSubscriptionNumber   TEXT                DEFAULT NULL, "
-        "  lastRequestedCharge         INTEGER             DEFAULT NULL, "
-        "  currency                    TEXT                DEFAULT NULL, "
-        "  unitPrice                   INTEGER             DEFAULT NULL, "
-        "  unitDiscount                INTEGER             DEFAULT NULL, "
-        "  nextChargeDate              INTEGER             DEFAULT NULL, "
-        "  availablePoints             INTEGER             DEFAULT NULL)"));
-    errorPrefix.setBase(QT_TR_NOOP("Can't create Accounting table"));
+        "CREATE TRIGGER IF NOT EXISTS "
+        "NoteCounters_NoteTagsBeforeInsertTrigger "
+        "BEFORE INSERT ON NoteTags "
+        "BEGIN "
+        "UPDATE TagNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount - "
+        "(SELECT COUNT(*) FROM NoteTags INNER JOIN Notes "
+        "ON NoteTags.localNote=Notes.localUid "
+        "WHERE NoteTags.localNote=new.localNote AND "
+        "NoteTags.localTag=new.localTag AND "
+        "Notes.deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount - "
+        "(SELECT COUNT(*) FROM NoteTags INNER JOIN Notes "
+        "ON NoteTags.localNote=Notes.localUid "
+        "WHERE NoteTags.localNote=new.localNote AND "
+        "NoteTags.localTag=new.localTag AND "
+        "Notes.deletionTimestamp IS NOT NULL) "
+        "WHERE tagLocalUid=new.localTag; "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger updating note counters before "
+                   "note tag insertion"));
     DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS AccountLimits("
-        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
-        "  userMailLimitDaily          INTEGER             DEFAULT NULL, "
-        "  noteSizeMax                 INTEGER             DEFAULT NULL, "
-        "  resourceSizeMax             INTEGER             DEFAULT NULL, "
-        "  userLinkedNotebookMax       INTEGER             DEFAULT NULL, "
-        "  uploadLimit                 INTEGER             DEFAULT NULL, "
-        "  userNoteCountMax            INTEGER             DEFAULT NULL, "
-        "  userNotebookCountMax        INTEGER             DEFAULT NULL, "
-        "  userTagCountMax             INTEGER             DEFAULT NULL, "
-        "  noteTagCountMax             INTEGER             DEFAULT NULL, "
-        "  userSavedSearchesMax        INTEGER             DEFAULT NULL, "
-        "  noteResourceCountMax        INTEGER             DEFAULT NULL)"));
-    errorPrefix.setBase(QT_TR_NOOP("Can't create AccountLimits table"));
+        "CREATE TRIGGER IF NOT EXISTS "
+        "NoteCounters_NoteTagsAfterInsertTrigger "
+        "AFTER INSERT ON NoteTags "
+        "BEGIN "
+        "INSERT INTO TagNoteCounters(tagLocalUid) "
+        "SELECT new.localTag WHERE new.localTag IS NOT NULL "
+        "AND NOT EXISTS (SELECT 1 FROM TagNoteCounters "
+        "WHERE tagLocalUid=new.localTag); "
+        "UPDATE TagNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount + "
+        "(SELECT COUNT(*) FROM Notes WHERE localUid=new.localNote AND "
+        "deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount + "
+        "(SELECT COUNT(*) FROM Notes WHERE localUid=new.localNote AND "
+        "deletionTimestamp IS NOT NULL) "
+        "WHERE tagLocalUid=new.localTag; "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger updating note counters after "
+                   "note tag insertion"));
     DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS BusinessUserInfo("
-        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
-        "  businessId              INTEGER                 DEFAULT NULL, "
-        "  businessName            TEXT                    DEFAULT NULL, "
-        "  role                    INTEGER                 DEFAULT NULL, "
-        "  businessInfoEmail       TEXT                    DEFAULT NULL)"));
-    errorPrefix.setBase(QT_TR_NOOP("Can't create BusinessUserInfo table"));
+        "CREATE TRIGGER IF NOT EXISTS "
+        "NoteCounters_NoteTagsAfterDeleteTrigger "
+        "AFTER DELETE ON NoteTags "
+        "BEGIN "
+        "UPDATE TagNoteCounters SET "
+        "nonDeletedNoteCount = nonDeletedNoteCount - "
+        "(SELECT COUNT(*) FROM Notes WHERE localUid=old.localNote AND "
+        "deletionTimestamp IS NULL), "
+        "deletedNoteCount = deletedNoteCount - "
+        "(SELECT COUNT(*) FROM Notes WHERE localUid=old.localNote AND "
+        "deletionTimestamp IS NOT NULL) "
+        "WHERE tagLocalUid=old.localTag; "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger updating note counters after "
+                   "note tag deletion"));
     DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.exec(QStringLiteral(
-        "CREATE TRIGGER IF NOT EXISTS on_user_delete_trigger "
-        "BEFORE DELETE ON Users "
+        "CREATE TRIGGER IF NOT EXISTS "
+        "NoteCounters_NotebooksAfterDeleteTrigger "
+        "AFTER DELETE ON Notebooks "
         "BEGIN "
-        "DELETE FROM UserAttributes WHERE id=OLD.id; "
-        "DELETE FROM UserAttributesViewedPromotions WHERE id=OLD.id; "
-        "DELETE FROM UserAttributesRecentMailedAddresses WHERE id=OLD.id; "
-        "DELETE FROM Accounting WHERE id=OLD.id; "
-        "DELETE FROM AccountLimits WHERE id=OLD.id; "
-        "DELETE FROM BusinessUserInfo WHERE id=OLD.id; "
+        "DELETE FROM NotebookNoteCounters "
+        "WHERE notebookLocalUid=old.localUid; "
         "END"));
-    errorPrefix.setBase(QT_TR_NOOP(
-        "Can't create trigger to fire on deletion from users table"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger removing note counters on notebook "
+                   "deletion"));
     DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS LinkedNotebooks("
-        "  guid                            TEXT PRIMARY KEY  NOT NULL UNIQUE, "
-        "  updateSequenceNumber            INTEGER           DEFAULT NULL, "
-        "  isDirty                         INTEGER           DEFAULT NULL, "
-        "  shareName                       TEXT              DEFAULT NULL, "
-        "  username                        TEXT              DEFAULT NULL, "
-        "  shardId                         TEXT              DEFAULT NULL, "
-        "  sharedNotebookGlobalId          TEXT              DEFAULT NULL, "
-        "  uri                             TEXT              DEFAULT NULL, "
-        "  noteStoreUrl                    TEXT              DEFAULT NULL, "
-        "  webApiUrlPrefix                 TEXT              DEFAULT NULL, "
-        "  stack                           TEXT              DEFAULT NULL, "
-        "  businessId                      INTEGER           DEFAULT NULL"
-        ")"));
-    errorPrefix.setBase(QT_TR_NOOP("Can't create LinkedNotebooks table"));
+        "CREATE TRIGGER IF NOT EXISTS "
+        "NoteCounters_TagsAfterDeleteTrigger "
+        "AFTER DELETE ON Tags "
+        "BEGIN "
+        "DELETE FROM TagNoteCounters WHERE tagLocalUid=old.localUid; "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger removing note counters on tag "
+                   "deletion"));
     DATABASE_CHECK_AND_SET_ERROR()
 
-    res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS Notebooks("
-        "  localUid                        TEXT PRIMARY KEY  NOT NULL UNIQUE, "
-        "  guid                            TEXT              DEFAULT NULL "
-        "UNIQUE, "
-        "  linkedNotebookGuid REFERENCES LinkedNotebooks(guid) ON UPDATE "
-        "CASCADE, "
-        "  updateSequenceNumber            INTEGER           DEFAULT NULL, "
-        "  notebookName                    TEXT              DEFAULT NULL, "
-        "  notebookNameUpper               TEXT              DEFAULT NULL, "
-        "  creationTimestamp               INTEGER           DEFAULT NULL, "
-        "  modificationTimestamp           INTEGER           DEFAULT NULL, "
-        "  isDirty                         INTEGER           NOT NULL, "
-        "  isLocal                         INTEGER           NOT NULL, "
-        "  isDefault                       INTEGER           DEFAULT NULL "
-        "UNIQUE, "
-        "  isLastUsed                      INTEGER           DEFAULT NULL "
-        "UNIQUE, "
-        "  isFavorited                     INTEGER           DEFAULT NULL, "
-        "  publishingUri                   TEXT              DEFAULT NULL, "
-        "  publishingNoteSortOrder         INTEGER           DEFAULT NULL, "
-        "  publishingAscendingSort         INTEGER           DEFAULT NULL, "
-        "  publicDescription               TEXT              DEFAULT NULL, "
-        "  isPublished                     INTEGER           DEFAULT NULL, "
-        "  stack                           TEXT              DEFAULT NULL, "
-        "  businessNotebookDescription     TEXT              DEFAULT NULL, "
-        "  businessNotebookPrivilegeLevel  INTEGER           DEFAULT NULL, "
-        "  businessNotebookIsRecommended   INTEGER           DEFAULT NULL, "
-        "  contactId                       INTEGER           DEFAULT NULL, "
-        "  recipientReminderNotifyEmail    INTEGER           DEFAULT NULL, "
-        "  recipientReminderNotifyInApp    INTEGER           DEFAULT NULL, "
-        "  recipientInMyList               INTEGER           DEFAULT NULL, "
-        "  recipientStack                  TEXT              DEFAULT NULL, "
-        "  UNIQUE(localUid, guid), "
-        "  UNIQUE(notebookNameUpper, linkedNotebookGuid) "
+    return true;
+}
+
+bool LocalStorageManagerPrivate::createAccountHighUsnTables(
+    ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::createAccountHighUsnTables");
+
+    // AccountHighUsns table keeps the highest USN per user's own account
+    // (denoted by empty linked notebook guid) and per linked notebook.
+    // The rows are put there by accountHighUsn after computing the value
+    // from all the tables with USNs; triggers raise the values on writes and
+    // remove the rows which might have become stale: on deletion of the item
+    // with the highest USN, on decrease of the highest USN and on items
+    // moving between linked notebooks. The removed values are recomputed by
+    // the next call to accountHighUsn. As with note counters, BEFORE INSERT
+    // triggers handle rows replaced by INSERT OR REPLACE.
+    ErrorString errorPrefix(QT_TR_NOOP("Can't create AccountHighUsns table"));
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS AccountHighUsns("
+        "  linkedNotebookGuid      TEXT PRIMARY KEY NOT NULL UNIQUE, "
+        "  highUsn                 INTEGER NOT NULL"
         ")"));
-    errorPrefix.setBase(QT_TR_NOOP("Can't create Notebooks table"));
     DATABASE_CHECK_AND_SET_ERROR()
 
-    res = query.exec(
-        QStringLiteral("CREATE VIRTUAL TABLE IF NOT EXISTS NotebookFTS "
-                       "USING FTS4(content=\"Notebooks\", "
-                       "localUid, guid, notebookName)"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create virtual FTS4 NotebookFTS table"));
+    struct TableData
+    {
+        const char * m_tableName;
+        const char * m_usnColumnName;
+
+        // Condition matching the row "r" replaced by the inserted one
+        const char * m_replacedRowCondition;
+
+        // Expression computing the linked notebook guid of the row denoted
+        // by %1 or empty string for user's own account
+        const char * m_scope;
+
+        // Columns which update might change the USN or the scope
+        const char * m_updateColumns;
+    };
+
+    const TableData tables[] = {
+        {"Notebooks", "updateSequenceNumber",
+         "r.localUid=new.localUid OR r.guid=new.guid",
+         "COALESCE(%1.linkedNotebookGuid, '')",
+         "updateSequenceNumber, linkedNotebookGuid"},
+        {"Tags", "updateSequenceNumber",
+         "r.localUid=new.localUid OR r.guid=new.guid",
+         "COALESCE(%1.linkedNotebookGuid, '')",
+         "updateSequenceNumber, linkedNotebookGuid"},
+        {"Notes", "updateSequenceNumber",
+         "r.localUid=new.localUid OR r.guid=new.guid",
+         "(SELECT COALESCE(linkedNotebookGuid, '') FROM Notebooks "
+         "WHERE localUid=%1.notebookLocalUid)",
+         "updateSequenceNumber, notebookLocalUid"},
+        {"Resources", "resourceUpdateSequenceNumber",
+         "r.resourceLocalUid=new.resourceLocalUid OR "
+         "r.resourceGuid=new.resourceGuid",
+         "(SELECT COALESCE(Notebooks.linkedNotebookGuid, '') FROM Notes "
+         "INNER JOIN Notebooks ON Notes.notebookLocalUid=Notebooks.localUid "
+         "WHERE Notes.localUid=%1.noteLocalUid)",
+         "resourceUpdateSequenceNumber, noteLocalUid"},
+        {"LinkedNotebooks", "updateSequenceNumber", "r.guid=new.guid", "''",
+         "updateSequenceNumber"},
+        {"SavedSearches", "updateSequenceNumber",
+         "r.localUid=new.localUid OR r.guid=new.guid", "''",
+         "updateSequenceNumber"}};
+
+    for (const auto & table: tables) {
+        const QString tableName = QString::fromUtf8(table.m_tableName);
+        const QString usn = QString::fromUtf8(table.m_usnColumnName);
+
+        auto scope = [&](const QString & row) {
+            return QString::fromUtf8(table.m_scope)
+                .replace(QStringLiteral("%1"), row);
+        };
+
+        // Matches the values for both linked notebooks if the row moves from
+        // one to another; unknown linked notebook means any of them
+        auto scopeChangeCondition = [&](const QString & oldRow) {
+            return QString::fromUtf8(
+                       "%1 IS NOT %2 AND "
+                       "(AccountHighUsns.linkedNotebookGuid IN (%1, %2) OR "
+                       "%1 IS NULL OR %2 IS NULL)")
+                .arg(scope(oldRow), scope(QStringLiteral("new")));
+        };
+
+        // Matches the value which the old row might have been defining
+        // unless the row's USN doesn't decrease
+        auto usnDecreaseCondition = [&](const QString & oldRow) {
+            return QString::fromUtf8(
+                       "AccountHighUsns.highUsn <= %1.%2 AND "
+                       "(%3 IS NULL OR AccountHighUsns.linkedNotebookGuid = "
+                       "%3) AND NOT (new.%2 IS NOT NULL AND new.%2 >= %1.%2)")
+                .arg(oldRow, usn, scope(oldRow));
+        };
+
+        const QString raiseStatement =
+            QString::fromUtf8(
+                "UPDATE AccountHighUsns SET highUsn = new.%1 "
+                "WHERE highUsn < new.%1 AND linkedNotebookGuid = %2; ")
+                .arg(usn, scope(QStringLiteral("new")));
+
+        const QString replacedRow = QStringLiteral("r");
+        const QString oldRow = QStringLiteral("old");
+
+        const QString triggers[] = {
+            QString::fromUtf8(
+                "CREATE TRIGGER IF NOT EXISTS "
+                "AccountHighUsns_%1BeforeInsertTrigger "
+                "BEFORE INSERT ON %1 "
+                "BEGIN "
+                "DELETE FROM AccountHighUsns WHERE EXISTS "
+                "(SELECT 1 FROM %1 AS r WHERE (%2) AND ((%3) OR (%4))); "
+                "END")
+                .arg(
+                    tableName,
+                    QString::fromUtf8(table.m_replacedRowCondition),
+                    scopeChangeCondition(replacedRow),
+                    usnDecreaseCondition(replacedRow)),
+            QString::fromUtf8(
+                "CREATE TRIGGER IF NOT EXISTS "
+                "AccountHighUsns_%1AfterInsertTrigger "
+                "AFTER INSERT ON %1 "
+                "BEGIN %2END")
+                .arg(tableName, raiseStatement),
+            QString::fromUtf8(
+                "CREATE TRIGGER IF NOT EXISTS "
+                "AccountHighUsns_%1AfterUpdateTrigger "
+                "AFTER UPDATE OF %2 ON %1 "
+                "BEGIN "
+                "DELETE FROM AccountHighUsns WHERE (%3) OR (%4); "
+                "%5"
+                "END")
+                .arg(
+                    tableName, QString::fromUtf8(table.m_updateColumns),
+                    scopeChangeCondition(oldRow),
+                    usnDecreaseCondition(oldRow), raiseStatement),
+            QString::fromUtf8(
+                "CREATE TRIGGER IF NOT EXISTS "
+                "AccountHighUsns_%1AfterDeleteTrigger "
+                "AFTER DELETE ON %1 "
+                "BEGIN "
+                "DELETE FROM AccountHighUsns WHERE highUsn <= old.%2 AND "
+                "(%3 IS NULL OR linkedNotebookGuid = %3); "
+                "END")
+                .arg(tableName, usn, scope(oldRow))};
+
+        errorPrefix.setBase(
+            QT_TR_NOOP("Can't create trigger maintaining account high update "
+                       "sequence numbers"));
+
+        for (const auto & trigger: triggers) {
+            res = query.exec(trigger);
+            DATABASE_CHECK_AND_SET_ERROR()
+        }
+    }
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::createNoteLocationIndexTables(
+    ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::createNoteLocationIndexTables");
+
+    // NoteLocationIndex is an R*Tree over coordinates of notes keyed by rowids
+    // of Notes, the same way as NoteFTS docids. Only notes having at least
+    // one of the coordinates are indexed; missing coordinates are stored as
+    // zeroes which is harmless as conditions on coordinates are always
+    // rechecked against Notes table. As with FTS, BEFORE INSERT trigger
+    // handles rows replaced by INSERT OR REPLACE.
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't create NoteLocationIndex table"));
+
+    if (!checkNoteLocationIndexAvailability(errorDescription)) {
+        return false;
+    }
+
+    const bool indexExisted = m_noteLocationIndexAvailable;
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(
+        QStringLiteral("CREATE VIRTUAL TABLE IF NOT EXISTS NoteLocationIndex "
+                       "USING rtree(id, minLatitude, maxLatitude, "
+                       "minLongitude, maxLongitude, minAltitude, "
+                       "maxAltitude)"));
+    if (!res &&
+        query.lastError().text().contains(QStringLiteral("no such module")))
+    {
+        QNWARNING(
+            "local_storage",
+            "SQLite is built without R*Tree module, searches by note "
+                << "location would scan Notes table: "
+                << query.lastError().text());
+        return true;
+    }
     DATABASE_CHECK_AND_SET_ERROR()
 
-    res = query.exec(
+    const auto locationValues = [](const QString & row) {
+        return QString::fromUtf8(
+                   "%1.rowid, IFNULL(%1.latitude, 0), IFNULL(%1.latitude, 0), "
+                   "IFNULL(%1.longitude, 0), IFNULL(%1.longitude, 0), "
+                   "IFNULL(%1.altitude, 0), IFNULL(%1.altitude, 0)")
+            .arg(row);
+    };
+
+    const auto hasLocation = [](const QString & row) {
+        return QString::fromUtf8(
+                   "%1.latitude IS NOT NULL OR %1.longitude IS NOT NULL OR "
+                   "%1.altitude IS NOT NULL")
+            .arg(row);
+    };
+
+    const QString newRow = QStringLiteral("new");
+
+    const QString triggers[] = {
         QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
-                       "NotebookFTS_BeforeDeleteTrigger "
-                       "BEFORE DELETE ON Notebooks "
+                       "NoteLocationIndex_BeforeInsertTrigger "
+                       "BEFORE INSERT ON Notes "
                        "BEGIN "
-                       "DELETE FROM NotebookFTS WHERE localUid=old.localUid; "
-                       "END"));
+                       "DELETE FROM NoteLocationIndex WHERE id IN "
+                       "(SELECT rowid FROM Notes WHERE "
+                       "localUid=new.localUid OR guid=new.guid); "
+                       "END"),
+        QString::fromUtf8("CREATE TRIGGER IF NOT EXISTS "
+                          "NoteLocationIndex_AfterInsertTrigger "
+                          "AFTER INSERT ON Notes WHEN %1 "
+                          "BEGIN "
+                          "INSERT OR REPLACE INTO NoteLocationIndex "
+                          "VALUES(%2); "
+                          "END")
+            .arg(hasLocation(newRow), locationValues(newRow)),
+        QString::fromUtf8("CREATE TRIGGER IF NOT EXISTS "
+                          "NoteLocationIndex_AfterUpdateTrigger "
+                          "AFTER UPDATE OF latitude, longitude, altitude "
+                          "ON Notes "
+                          "BEGIN "
+                          "DELETE FROM NoteLocationIndex WHERE id=old.rowid; "
+                          "INSERT INTO NoteLocationIndex SELECT %1 WHERE %2; "
+                          "END")
+            .arg(locationValues(newRow), hasLocation(newRow)),
+        QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
+                       "NoteLocationIndex_BeforeDeleteTrigger "
+                       "BEFORE DELETE ON Notes "
+                       "BEGIN "
+                       "DELETE FROM NoteLocationIndex WHERE id=old.rowid; "
+                       "END")};
+
     errorPrefix.setBase(
-        QT_TR_NOOP("Can't create NotebookFTS_BeforeDeleteTrigger"));
-    DATABASE_CHECK_AND_SET_ERROR()
+        QT_TR_NOOP("Can't create trigger maintaining note location index"));
 
-    res = query.exec(QStringLiteral(
-        "CREATE TRIGGER IF NOT EXISTS "
-        "NotebookFTS_AfterInsertTrigger "
-        "AFTER INSERT ON Notebooks "
+    for (const auto & trigger: triggers) {
+        res = query.exec(trigger);
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
+
+    // The index might be created for the database already containing notes:
+    // either by LocalStoragePatch7To8 or on the first start with SQLite
+    // having R*Tree module after the ones without it
+    if (!indexExisted) {
+        const QString notesRow = QStringLiteral("Notes");
+        res = query.exec(
+            QString::fromUtf8("INSERT OR REPLACE INTO NoteLocationIndex "
+                              "SELECT %1 FROM Notes WHERE %2")
+                .arg(locationValues(notesRow), hasLocation(notesRow)));
+        errorPrefix.setBase(QT_TR_NOOP("Can't fill NoteLocationIndex table"));
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
+
+    m_noteLocationIndexAvailable = true;
+    return true;
+}
+
+bool LocalStorageManagerPrivate::checkNoteLocationIndexAvailability(
+    ErrorString & errorDescription)
+{
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't check whether note location index exists"));
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(
+        QStringLiteral("SELECT COUNT(*) FROM sqlite_master "
+                       "WHERE type='table' AND name='NoteLocationIndex'"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    m_noteLocationIndexAvailable =
+        (query.next() && (query.value(0).toInt() > 0));
+
+    QNDEBUG(
+        "local_storage",
+        "Note location index is "
+            << (m_noteLocationIndexAvailable ? "available" : "not available"));
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::noteCountersAreConsistent(
+    ErrorString & errorDescription) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::noteCountersAreConsistent");
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't check the consistency of note counters"));
+
+    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Selection);
+    Q_UNUSED(transaction)
+
+    // Counters which went down to zero are not removed so only non-zero ones
+    // are compared with the actual numbers of notes
+    const QString notebookCounters = QStringLiteral(
+        "SELECT notebookLocalUid, nonDeletedNoteCount, deletedNoteCount "
+        "FROM NotebookNoteCounters "
+        "WHERE nonDeletedNoteCount != 0 OR deletedNoteCount != 0");
+
+    const QString actualNotebookCounts = QStringLiteral(
+        "SELECT notebookLocalUid, SUM(deletionTimestamp IS NULL), "
+        "SUM(deletionTimestamp IS NOT NULL) FROM Notes "
+        "WHERE notebookLocalUid IS NOT NULL GROUP BY notebookLocalUid");
+
+    const QString tagCounters = QStringLiteral(
+        "SELECT tagLocalUid, nonDeletedNoteCount, deletedNoteCount "
+        "FROM TagNoteCounters "
+        "WHERE nonDeletedNoteCount != 0 OR deletedNoteCount != 0");
+
+    const QString actualTagCounts = QStringLiteral(
+        "SELECT localTag, SUM(Notes.deletionTimestamp IS NULL), "
+        "SUM(Notes.deletionTimestamp IS NOT NULL) FROM NoteTags "
+        "INNER JOIN Notes ON NoteTags.localNote=Notes.localUid "
+        "WHERE localTag IS NOT NULL GROUP BY localTag");
+
+    const auto countMismatches = [](const QString & lhs, const QString & rhs) {
+        return QString::fromUtf8(
+                   "SELECT COUNT(*) FROM "
+                   "(SELECT * FROM (%1 EXCEPT %2) UNION ALL "
+                   "SELECT * FROM (%2 EXCEPT %1))")
+            .arg(lhs, rhs);
+    };
+
+    const QStringList queryStrings = QStringList()
+        << countMismatches(notebookCounters, actualNotebookCounts)
+        << countMismatches(tagCounters, actualTagCounts);
+
+    for (const auto & queryString: queryStrings) {
+        QSqlQuery query(m_sqlDatabase);
+        bool res = execQuery(query, queryString);
+        if (!res) {
+            SET_ERROR();
+            return false;
+        }
+
+        if (!query.next()) {
+            continue;
+        }
+
+        bool conversionResult = false;
+        int numMismatches = query.value(0).toInt(&conversionResult);
+        if (!conversionResult) {
+            SET_INT_CONVERSION_ERROR();
+            return false;
+        }
+
+        if (numMismatches != 0) {
+            QNINFO(
+                "local_storage",
+                "Found " << numMismatches << " note counters not matching "
+                         << "the actual numbers of notes");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::rebuildNoteCounters(
+    ErrorString & errorDescription)
+{
+    QNDEBUG("local_storage", "LocalStorageManagerPrivate::rebuildNoteCounters");
+
+    ErrorString errorPrefix(QT_TR_NOOP("Can't rebuild note counters"));
+
+    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Exclusive);
+
+    const QStringList queryStrings = QStringList()
+        << QStringLiteral("DELETE FROM NotebookNoteCounters")
+        << QStringLiteral(
+               "INSERT INTO NotebookNoteCounters"
+               "(notebookLocalUid, nonDeletedNoteCount, deletedNoteCount) "
+               "SELECT notebookLocalUid, SUM(deletionTimestamp IS NULL), "
+               "SUM(deletionTimestamp IS NOT NULL) FROM Notes "
+               "WHERE notebookLocalUid IS NOT NULL GROUP BY notebookLocalUid")
+        << QStringLiteral("DELETE FROM TagNoteCounters")
+        << QStringLiteral(
+               "INSERT INTO TagNoteCounters"
+               "(tagLocalUid, nonDeletedNoteCount, deletedNoteCount) "
+               "SELECT localTag, SUM(Notes.deletionTimestamp IS NULL), "
+               "SUM(Notes.deletionTimestamp IS NOT NULL) FROM NoteTags "
+               "INNER JOIN Notes ON NoteTags.localNote=Notes.localUid "
+               "WHERE localTag IS NOT NULL GROUP BY localTag");
+
+    for (const auto & queryString: queryStrings) {
+        QSqlQuery query(m_sqlDatabase);
+        bool res = execQuery(query, queryString);
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
+
+    return transaction.commit(errorDescription);
+}
+
+QString LocalStorageManagerPrivate::noteCountOptionsToCounterColumns(
+    const NoteCountOptions options) const
+{
+    // Mirrors noteCountOptionsToSqlQueryPart
+    if ((options & NoteCountOption::IncludeNonDeletedNotes) &&
+        (options & NoteCountOption::IncludeDeletedNotes))
+    {
+        return QStringLiteral("(nonDeletedNoteCount + deletedNoteCount)");
+    }
+
+    if (options & NoteCountOption::IncludeNonDeletedNotes) {
+        return QStringLiteral("nonDeletedNoteCount");
+    }
+
+    return QStringLiteral("deletedNoteCount");
+}
+
+void LocalStorageManagerPrivate::processPostTransactionException(
+    ErrorString message, QSqlError error)
+{
+    QNERROR("local_storage", message << ": " << error);
+    message.details() += error.text();
+    throw DatabaseRequestException(message);
+}
+
+void LocalStorageManagerPrivate::runWithinSelectionTransaction(
+    const std::function<void()> & func)
+{
+    // Only the failure to begin the transaction is handled here, exceptions
+    // thrown by the function itself go to the caller
+    std::unique_ptr<Transaction> pTransaction;
+    try {
+        pTransaction = std::make_unique<Transaction>(
+            m_sqlDatabase, *this, Transaction::Type::Selection);
+    }
+    catch (const std::exception & e) {
+        QNWARNING(
+            "local_storage",
+            "Failed to begin the read transaction: "
+                << e.what() << "; running the queries without it");
+    }
+
+    func();
+}
+
+bool LocalStorageManagerPrivate::beginWriteGroup(ErrorString & errorDescription)
+{
+    QNDEBUG("local_storage", "LocalStorageManagerPrivate::beginWriteGroup");
+
+    if (Q_UNLIKELY(m_pWriteGroupTransaction)) {
+        errorDescription.setBase(
+            QT_TR_NOOP("Can't begin the group of writes to the local storage: "
+                       "another group is already open"));
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    try {
+        m_pWriteGroupTransaction = std::make_unique<Transaction>(
+            m_sqlDatabase, *this, Transaction::Type::Exclusive);
+    }
+    catch (const std::exception & e) {
+        errorDescription.setBase(
+            QT_TR_NOOP("Can't begin the group of writes to the local "
+                       "storage"));
+        errorDescription.details() = QString::fromUtf8(e.what());
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::commitWriteGroup(
+    ErrorString & errorDescription)
+{
+    QNDEBUG("local_storage", "LocalStorageManagerPrivate::commitWriteGroup");
+
+    if (Q_UNLIKELY(!m_pWriteGroupTransaction)) {
+        errorDescription.setBase(
+            QT_TR_NOOP("Can't commit the group of writes to the local "
+                       "storage: no group is open"));
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    // The transaction is rolled back on destruction if it fails to commit
+    std::unique_ptr<Transaction> pTransaction =
+        std::move(m_pWriteGroupTransaction);
+
+    ErrorString error;
+    if (Q_UNLIKELY(!pTransaction->commit(error))) {
+        errorDescription.setBase(
+            QT_TR_NOOP("Can't commit the group of writes to the local "
+                       "storage"));
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    return true;
+}
+
+QList<LocalStorageManager::QueryStatistics>
+LocalStorageManagerPrivate::queryStatistics() const
+{
+    return m_pQueryStatistics->statistics();
+}
+
+void LocalStorageManagerPrivate::resetQueryStatistics()
+{
+    m_pQueryStatistics->clear();
+}
+
+void LocalStorageManagerPrivate::logQueryStatistics() const
+{
+    const auto statistics = m_pQueryStatistics->statistics();
+
+    QString str;
+    QTextStream strm(&str);
+    for (const auto & stats: qAsConst(statistics)) {
+        strm << stats;
+    }
+
+    strm.flush();
+
+    QNINFO(
+        "local_storage",
+        "Statistics of " << statistics.size()
+                         << " SQL queries executed by local storage manager:\n"
+                         << str);
+}
+
+std::shared_ptr<QueryStatisticsCollector>
+LocalStorageManagerPrivate::queryStatisticsCollector() const
+{
+    return m_pQueryStatistics;
+}
+
+void LocalStorageManagerPrivate::setQueryStatisticsCollector(
+    std::shared_ptr<QueryStatisticsCollector> pQueryStatistics)
+{
+    if (Q_UNLIKELY(!pQueryStatistics)) {
+        return;
+    }
+
+    m_pQueryStatistics = std::move(pQueryStatistics);
+}
+
+void LocalStorageManagerPrivate::setSlowQueryThreshold(
+    const qint64 thresholdUsec)
+{
+    m_pQueryStatistics->setSlowQueryThreshold(thresholdUsec);
+}
+
+qint64 LocalStorageManagerPrivate::slowQueryThreshold() const
+{
+    return m_pQueryStatistics->slowQueryThreshold();
+}
+
+void LocalStorageManagerPrivate::setAccountHighUsnVerificationEnabled(
+    const bool enabled)
+{
+    m_verifyAccountHighUsn = enabled;
+}
+
+bool LocalStorageManagerPrivate::accountHighUsnVerificationEnabled() const
+{
+    return m_verifyAccountHighUsn;
+}
+
+void LocalStorageManagerPrivate::setGuidIndexEnabled(const bool enabled)
+{
+    if (enabled && m_readOnly) {
+        QNDEBUG(
+            "local_storage",
+            "Not enabling the guid index for read-only local storage");
+        return;
+    }
+
+    m_guidLocalUidIndex.setEnabled(enabled);
+}
+
+bool LocalStorageManagerPrivate::guidIndexEnabled() const
+{
+    return m_guidLocalUidIndex.isEnabled();
+}
+
+LocalStorageManager::GuidIndexStatistics
+LocalStorageManagerPrivate::guidIndexStatistics() const
+{
+    return m_guidLocalUidIndex.statistics();
+}
+
+bool LocalStorageManagerPrivate::execQuery(
+    QSqlQuery & query, const QString & queryString) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool res = (queryString.isNull() ? query.exec() : query.exec(queryString));
+
+    const qint64 durationUsec = timer.nsecsElapsed() / 1000;
+
+    const QString normalizedQuery =
+        m_pQueryStatistics->normalizedQuery(query.lastQuery());
+
+    // Rows returned by select queries are not known until they are fetched
+    const int rowCount =
+        ((res && !query.isSelect()) ? query.numRowsAffected() : 0);
+
+    m_pQueryStatistics->recordExecution(
+        normalizedQuery, durationUsec, res, rowCount);
+
+    const qint64 slowQueryThresholdUsec =
+        m_pQueryStatistics->slowQueryThreshold();
+
+    if (res && (slowQueryThresholdUsec > 0) &&
+        (durationUsec >= slowQueryThresholdUsec) &&
+        !isTransactionControlQuery(normalizedQuery) &&
+        !m_pQueryStatistics->hasQueryPlan(normalizedQuery))
+    {
+        captureQueryPlan(normalizedQuery, query, durationUsec);
+    }
+
+    return res;
+}
+
+void LocalStorageManagerPrivate::recordQueryRows(
+    const QSqlQuery & query, const int rowCount) const
+{
+    m_pQueryStatistics->recordRows(
+        m_pQueryStatistics->normalizedQuery(query.lastQuery()), rowCount);
+}
+
+void LocalStorageManagerPrivate::captureQueryPlan(
+    const QString & normalizedQuery, const QSqlQuery & query,
+    const qint64 durationUsec) const
+{
+    const QString queryString = query.lastQuery();
+    const int boundValueCount = query.boundValues().size();
+
+    QSqlQuery planQuery(m_sqlDatabase);
+    bool res = false;
+    if (boundValueCount == 0) {
+        res =
+            planQuery.exec(QStringLiteral("EXPLAIN QUERY PLAN ") + queryString);
+    }
+    else {
+        res = planQuery.prepare(
+            QStringLiteral("EXPLAIN QUERY PLAN ") + queryString);
+
+        if (res) {
+            for (int i = 0; i < boundValueCount; ++i) {
+                planQuery.bindValue(i, query.boundValue(i));
+            }
+
+            res = planQuery.exec();
+        }
+    }
+
+    if (!res) {
+        QNDEBUG(
+            "local_storage",
+            "Failed to capture the plan of slow SQL query: "
+                << planQuery.lastError().text() << "; query: " << queryString);
+        return;
+    }
+
+    QStringList details;
+    while (planQuery.next()) {
+        details << planQuery.value(QStringLiteral("detail")).toString();
+    }
+
+    const QString queryPlan = details.join(QStringLiteral("; "));
+    m_pQueryStatistics->setQueryPlan(normalizedQuery, queryPlan);
+
+    QNINFO(
+        "local_storage",
+        "Slow SQL query took " << durationUsec << " usec: " << queryString
+                               << "; query plan: " << queryPlan);
+}
+
+void LocalStorageManagerPrivate::onTransactionCommitted()
+{
+    if (!m_hasPendingOrphanResourceBlobs) {
+        return;
+    }
+
+    ErrorString errorDescription;
+    if (!removeOrphanResourceBlobs(errorDescription)) {
+        QNWARNING(
+            "local_storage",
+            "Failed to remove orphan resource data blobs after "
+                << "the transaction commit: " << errorDescription);
+    }
+}
+
+void LocalStorageManagerPrivate::onTransactionRolledBack()
+{
+    // The index might have been updated with items which are now gone
+    m_guidLocalUidIndex.clear();
+
+    // Same goes for the snapshots of notes
+    m_noteLocalStorageSnapshots.clear();
+}
+
+bool LocalStorageManagerPrivate::addEnResource(
+    Resource & resource, ErrorString & errorDescription,
+    const bool keepMissingDataBody)
+{
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't add resource to the local storage database"));
+
+    ErrorString error;
+    if (!resource.checkParameters(error)) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", "Found invalid resource: " << resource);
+        return false;
+    }
+
+    if (!resource.hasNoteGuid() && !resource.hasNoteLocalUid()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("both resource's note local uid and note guid are "
+                       "empty"));
+        QNWARNING(
+            "local_storage", errorDescription << ", resource: " << resource);
+        return false;
+    }
+
+    /**
+     * NOTE: since adding the resource is essentially the update of a note
+     * containing the resource, we might need to check if the notebook in which
+     * this note resides allows one to update its notes; however, there is no
+     * such check here because the request to update the note might come from
+     * the synchronization i.e. the note might have been updated via
+     * the official Evernote client which doesn't account for such minor issues
+     * as the notebooks' restriction to update the note
+     */
+
+    // Now can continue with adding the resource
+    error.clear();
+    bool res = complementResourceNoteIds(resource, error);
+    if (!res) {
+        return false;
+    }
+
+    int resourceIndexInNote = -1;
+
+    QString noteLocalUid = resource.noteLocalUid();
+    noteLocalUid = sqlEscapeString(noteLocalUid);
+
+    QString queryString =
+        QString::fromUtf8(
+            "SELECT COUNT(*) FROM NoteResources WHERE localNote = '%1'")
+            .arg(noteLocalUid);
+
+    QSqlQuery query(m_sqlDatabase);
+    res = execQuery(query, queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    if (query.next()) {
+        bool conversionResult = false;
+        resourceIndexInNote = query.record().value(0).toInt(&conversionResult);
+        if (!conversionResult) {
+            SET_INT_CONVERSION_ERROR();
+            return false;
+        }
+    }
+    else {
+        resourceIndexInNote = 0;
+    }
+
+    resource.setIndexInNote(resourceIndexInNote);
+
+    QString resourceLocalUid = resource.localUid();
+
+    QString column, uid;
+    bool shouldCheckResourceExistence = true;
+
+    bool resourceHasGuid = resource.hasGuid();
+    if (resourceHasGuid) {
+        column = QStringLiteral("resourceGuid");
+        uid = resource.guid();
+
+        if (resourceLocalUid.isEmpty()) {
+            error.clear();
+            bool res = getResourceLocalUidForGuid(uid, resourceLocalUid, error);
+            if (res || !resourceLocalUid.isEmpty()) {
+                errorDescription.base() = errorPrefix.base();
+                errorDescription.appendBase(
+                    QT_TR_NOOP("resource already exists"));
+                errorDescription.details() = column;
+                errorDescription.details() += QStringLiteral(" = ");
+                errorDescription.details() += uid;
+                QNWARNING("local_storage", errorDescription);
+                return false;
+            }
+
+            resourceLocalUid = UidGenerator::Generate();
+            resource.setLocalUid(resourceLocalUid);
+            shouldCheckResourceExistence = false;
+        }
+    }
+    else {
+        column = QStringLiteral("resourceLocalUid");
+        uid = resource.localUid();
+    }
+
+    if (shouldCheckResourceExistence &&
+        rowExists(QStringLiteral("Resources"), column, uid))
+    {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(QT_TR_NOOP("resource already exists"));
+        errorDescription.details() = column;
+        errorDescription.details() += QStringLiteral(" = ");
+        errorDescription.details() += uid;
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    error.clear();
+    res = insertOrReplaceResource(
+        resource, error, /* set resource binary data = */ true,
+        /* use separate transaction = */ true, keepMissingDataBody);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::updateEnResource(
+    Resource & resource, ErrorString & errorDescription,
+    const bool keepMissingDataBody)
+{
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't update resource in the local storage database"));
+
+    ErrorString error;
+    if (!resource.checkParameters(error)) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", "Found invalid resource: " << resource);
+        return false;
+    }
+
+    if (!resource.hasNoteGuid() && !resource.hasNoteLocalUid()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(QT_TR_NOOP(
+            "both resource's note local uid and note guid are empty"));
+        QNWARNING(
+            "local_storage", errorDescription << ", resource: " << resource);
+        return false;
+    }
+
+    /**
+     * NOTE: since updating the resource is essentially the update of a note
+     * containing the resource, we might need to check if the notebook in which
+     * this note resides allows one to update its notes; however, there is no
+     * such check here because the request to update the note might come from
+     * the synchronization i.e. the note might have been updated via
+     * the official Evernote client which doesn't account for such minor issues
+     * as the notebooks' restriction to update the note
+     */
+
+    // Now can continue with updating the resource
+    error.clear();
+    bool res = complementResourceNoteIds(resource, error);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    QString resourceLocalUid = resource.localUid();
+
+    QString column, uid;
+    bool shouldCheckResourceExistence = true;
+
+    bool resourceHasGuid = resource.hasGuid();
+    if (resourceHasGuid) {
+        column = QStringLiteral("resourceGuid");
+        uid = resource.guid();
+
+        if (resourceLocalUid.isEmpty()) {
+            error.clear();
+            bool res = getResourceLocalUidForGuid(uid, resourceLocalUid, error);
+            if (!res || resourceLocalUid.isEmpty()) {
+                errorDescription.base() = errorPrefix.base();
+                errorDescription.appendBase(
+                    QT_TR_NOOP("resource to be updated was not found in "
+                               "the local storage database"));
+                errorDescription.details() = column;
+                errorDescription.details() += QStringLiteral(" = ");
+                errorDescription.details() += uid;
+                QNWARNING("local_storage", errorDescription);
+                return false;
+            }
+
+            resource.setLocalUid(resourceLocalUid);
+            shouldCheckResourceExistence = false;
+        }
+    }
+    else {
+        column = QStringLiteral("resourceLocalUid");
+        uid = resource.localUid();
+    }
+
+    if (shouldCheckResourceExistence &&
+        !rowExists(QStringLiteral("Resources"), column, uid))
+    {
+        bool foundByOtherColumn = false;
+
+        if (resourceHasGuid) {
+            QNDEBUG(
+                "local_storage",
+                "Failed to find the resource by guid "
+                    << "within the local storage, trying to find it by local "
+                       "uid");
+            column = QStringLiteral("resourceLocalUid");
+            uid = resource.localUid();
+            foundByOtherColumn =
+                rowExists(QStringLiteral("Resources"), column, uid);
+        }
+
+        if (!foundByOtherColumn) {
+            errorDescription.base() = errorPrefix.base();
+            errorDescription.appendBase(
+                QT_TR_NOOP("resource to be updated was not found in the local "
+                           "storage database"));
+            errorDescription.details() = column;
+            errorDescription.details() += QStringLiteral(" = ");
+            errorDescription.details() += uid;
+            QNWARNING("local_storage", errorDescription);
+            return false;
+        }
+    }
+
+    error.clear();
+    res = insertOrReplaceResource(
+        resource, error, /* set resource binary data = */ true,
+        /* use separate transaction = */ true, keepMissingDataBody);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::addEnResource(
+    Resource & resource, QIODevice & dataBodySource,
+    ErrorString & errorDescription)
+{
+    return addOrUpdateEnResourceWithDataFromDevice(
+        resource, dataBodySource, /* is update = */ false, errorDescription);
+}
+
+bool LocalStorageManagerPrivate::updateEnResource(
+    Resource & resource, QIODevice & dataBodySource,
+    ErrorString & errorDescription)
+{
+    return addOrUpdateEnResourceWithDataFromDevice(
+        resource, dataBodySource, /* is update = */ true, errorDescription);
+}
+
+bool LocalStorageManagerPrivate::addOrUpdateEnResourceWithDataFromDevice(
+    Resource & resource, QIODevice & dataBodySource, const bool isUpdate,
+    ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::addOrUpdateEnResourceWithDataFromDevice: "
+            << "resource local uid = " << resource.localUid()
+            << ", is update = " << (isUpdate ? "true" : "false"));
+
+    ErrorString errorPrefix(
+        isUpdate
+            ? QT_TR_NOOP("Can't update resource in the local storage database")
+            : QT_TR_NOOP("Can't add resource to the local storage database"));
+
+    if (Q_UNLIKELY(resource.hasDataBody())) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("the resource already has data body set"));
+        QNWARNING(
+            "local_storage", errorDescription << ", resource: " << resource);
+        return false;
+    }
+
+    if (Q_UNLIKELY(!dataBodySource.isReadable())) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("the device with resource data is not readable"));
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    Transaction transaction(
+        m_sqlDatabase, *this, Transaction::Type::Exclusive);
+
+    QString blobHash;
+    qint64 size = 0;
+
+    ErrorString error;
+    if (!writeResourceBlob(dataBodySource, blobHash, size, error)) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    if (Q_UNLIKELY(size > std::numeric_limits<qint32>::max())) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(QT_TR_NOOP("resource data is too large"));
+        errorDescription.details() = QString::number(size);
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    resource.setDataHash(QByteArray::fromHex(blobHash.toLatin1()));
+    resource.setDataSize(static_cast<qint32>(size));
+
+    // The resource without data body keeps its existing binary data so
+    // the reference to the freshly written blob is set afterwards
+    error.clear();
+    bool res =
+        (isUpdate ? updateEnResource(
+                        resource, error, /* keep missing data body = */ true)
+                  : addEnResource(
+                        resource, error, /* keep missing data body = */ true));
+    if (!res) {
+        errorDescription = error;
+        return false;
+    }
+
+    error.clear();
+    res = setResourceBlobReference(
+        resource.localUid(), /* is alternate data body = */ false, blobHash,
+        error);
+
+    if (res) {
+        res = removeOrphanResourceBlobs(error);
+    }
+
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    return transaction.commit(errorDescription);
+}
+
+void LocalStorageManagerPrivate::lockDatabaseFile(
+    const QFileInfo & databaseFileInfo, const StartupOptions options)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::lockDatabaseFile: "
+            << m_databaseFilePath);
+
+    /**
+     * NOTE: it appears boost::interprocess::file_lock applied to the database
+     * file on Windows causes the inability to properly open the database.
+     * The reason for this is not clear so for now just disable the use of
+     * boost::interprocess::file_lock on Windows. It's not a major problem
+     * because Windows won't let another process to open the file being worked
+     * with by another process
+     */
+#ifndef Q_OS_WIN
+    /**
+     * WARNING: something strange is going on here: if no call is made to the
+     * below method, boost::interprocess::file_lock occasionally and
+     * sporadically thinks "there is no such file or directory"; that's what
+     * its exception message says
+     */
+    bool databaseFileExists = databaseFileInfo.exists();
+    QNDEBUG(
+        "local_storage",
+        "Database file exists before locking: "
+            << (databaseFileExists ? "true" : "false"));
+
+    bool lockResult = false;
+
+    try {
+        boost::interprocess::file_lock databaseLock(
+            databaseFileInfo.canonicalFilePath().toUtf8().constData());
+
+        m_databaseFileLock.swap(databaseLock);
+        lockResult = m_databaseFileLock.try_lock();
+    }
+    catch (boost::interprocess::interprocess_exception & exc) {
+        ErrorString error(QT_TR_NOOP("Can't lock the database file"));
+        error.details() = QStringLiteral("error code ");
+        error.details() += QString::number(exc.get_error_code());
+        error.details() += QStringLiteral("; ");
+        error.details() += QString::fromUtf8(exc.what());
+        throw DatabaseLockFailedException(error);
+    }
+
+    if (!lockResult) {
+        if (!(options & StartupOption::OverrideLock)) {
+            ErrorString error(
+                QT_TR_NOOP("Local storage database file is locked"));
+            error.details() = m_databaseFilePath;
+            throw DatabaseLockedException(error);
+        }
+        else {
+            QNINFO(
+                "local_storage",
+                "Local storage database file "
+                    << m_databaseFilePath << " is locked but nobody cares");
+        }
+    }
+#else
+    Q_UNUSED(databaseFileInfo)
+    Q_UNUSED(options)
+#endif // Q_OS_WIN
+}
+
+void LocalStorageManagerPrivate::unlockDatabaseFile()
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::unlockDatabaseFile: "
+            << m_databaseFilePath);
+
+    if (m_readOnly) {
+        QNDEBUG("local_storage", "Read-only connection, nothing to do");
+        return;
+    }
+
+#ifndef Q_OS_WIN
+    if (m_databaseFilePath.isEmpty()) {
+        QNDEBUG("local_storage", "No database file, nothing to do");
+        return;
+    }
+
+    try {
+        m_databaseFileLock.unlock();
+    }
+    catch (boost::interprocess::interprocess_exception & exc) {
+        QNWARNING(
+            "local_storage",
+            "Caught exception trying to unlock "
+                << "the database file: error = " << exc.get_error_code()
+                << ", error message = " << exc.what()
+                << "; native error = " << exc.get_native_error());
+    }
+#endif
+}
+
+bool LocalStorageManagerPrivate::createTables(ErrorString & errorDescription)
+{
+    QSqlQuery query(m_sqlDatabase);
+    bool res;
+
+    // Checking whether auxiliary table exists
+    res = query.exec(QStringLiteral(
+        "SELECT name FROM sqlite_master WHERE name='Auxiliary'"));
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't check whether Auxiliary table exists"));
+
+    DATABASE_CHECK_AND_SET_ERROR()
+    bool auxiliaryTableExists = query.next();
+
+    QNDEBUG(
+        "local_storage",
+        "Auxiliary table "
+            << (auxiliaryTableExists ? "already exists" : "doesn't exist yet"));
+
+    if (!auxiliaryTableExists) {
+        res = query.exec(
+            QStringLiteral("CREATE TABLE Auxiliary("
+                           "  lock    CHAR(1) PRIMARY KEY  NOT NULL DEFAULT "
+                           "'X' CHECK (lock='X'), "
+                           "  version INTEGER              NOT NULL"
+                           ")"));
+        errorPrefix.setBase(QT_TR_NOOP("Can't create Auxiliary table"));
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        res = query.exec(
+            QStringLiteral("INSERT INTO Auxiliary (version) VALUES(8)"));
+        errorPrefix.setBase(QT_TR_NOOP("Can't set version to Auxiliary table"));
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS Users("
+        "  id                           INTEGER PRIMARY KEY NOT NULL UNIQUE, "
+        "  username                     TEXT                DEFAULT NULL, "
+        "  email                        TEXT                DEFAULT NULL, "
+        "  name                         TEXT                DEFAULT NULL, "
+        "  timezone                     TEXT                DEFAULT NULL, "
+        "  privilege                    INTEGER             DEFAULT NULL, "
+        "  serviceLevel                 INTEGER             DEFAULT NULL, "
+        "  userCreationTimestamp        INTEGER             DEFAULT NULL, "
+        "  userModificationTimestamp    INTEGER             DEFAULT NULL, "
+        "  userIsDirty                  INTEGER             NOT NULL, "
+        "  userIsLocal                  INTEGER             NOT NULL, "
+        "  userDeletionTimestamp        INTEGER             DEFAULT NULL, "
+        "  userIsActive                 INTEGER             DEFAULT NULL, "
+        "  userShardId                  TEXT                DEFAULT NULL, "
+        "  userPhotoUrl                 TEXT                DEFAULT NULL, "
+        "  userPhotoLastUpdateTimestamp INTEGER             DEFAULT NULL"
+        ")"));
+    errorPrefix.setBase(QT_TR_NOOP("Can't create Users table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS UserAttributes("
+        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
+        "  defaultLocationName        TEXT                  DEFAULT NULL, "
+        "  defaultLatitude            REAL                  DEFAULT NULL, "
+        "  defaultLongitude           REAL                  DEFAULT NULL, "
+        "  preactivation              INTEGER               DEFAULT NULL, "
+        "  incomingEmailAddress       TEXT                  DEFAULT NULL, "
+        "  comments                   TEXT                  DEFAULT NULL, "
+        "  dateAgreedToTermsOfService INTEGER               DEFAULT NULL, "
+        "  maxReferrals               INTEGER               DEFAULT NULL, "
+        "  referralCount              INTEGER               DEFAULT NULL, "
+        "  refererCode                TEXT                  DEFAULT NULL, "
+        "  sentEmailDate              INTEGER               DEFAULT NULL, "
+        "  sentEmailCount             INTEGER               DEFAULT NULL, "
+        "  dailyEmailLimit            INTEGER               DEFAULT NULL, "
+        "  emailOptOutDate            INTEGER               DEFAULT NULL, "
+        "  partnerEmailOptInDate      INTEGER               DEFAULT NULL, "
+        "  preferredLanguage          TEXT                  DEFAULT NULL, "
+        "  preferredCountry           TEXT                  DEFAULT NULL, "
+        "  clipFullPage               INTEGER               DEFAULT NULL, "
+        "  twitterUserName            TEXT                  DEFAULT NULL, "
+        "  twitterId                  TEXT                  DEFAULT NULL, "
+        "  groupName                  TEXT                  DEFAULT NULL, "
+        "  recognitionLanguage        TEXT                  DEFAULT NULL, "
+        "  referralProof              TEXT                  DEFAULT NULL, "
+        "  educationalDiscount        INTEGER               DEFAULT NULL, "
+        "  businessAddress            TEXT                  DEFAULT NULL, "
+        "  hideSponsorBilling         INTEGER               DEFAULT NULL, "
+        "  useEmailAutoFiling         INTEGER               DEFAULT NULL, "
+        "  reminderEmailConfig        INTEGER               DEFAULT NULL, "
+        "  emailAddressLastConfirmed  INTEGER               DEFAULT NULL, "
+        "  passwordUpdated            INTEGER               DEFAULT NULL, "
+        "  salesforcePushEnabled      INTEGER               DEFAULT NULL, "
+        "  shouldLogClientEvent       INTEGER               DEFAULT NULL)"));
+    errorPrefix.setBase(QT_TR_NOOP("Can't create UserAttributes table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS UserAttributesViewedPromotions("
+        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
+        "  promotion               TEXT                    DEFAULT NULL)"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create UserAttributesViewedPromotions table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS UserAttributesRecentMailedAddresses("
+        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
+        "  address                 TEXT                    DEFAULT NULL)"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create UserAttributesRecentMailedAddresses table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS Accounting("
+        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
+        "  uploadLimitEnd              INTEGER             DEFAULT NULL, "
+        "  uploadLimitNextMonth        INTEGER             DEFAULT NULL, "
+        "  premiumServiceStatus        INTEGER             DEFAULT NULL, "
+        "  premiumOrderNumber          TEXT                DEFAULT NULL, "
+        "  premiumCommerceService      TEXT                DEFAULT NULL, "
+        "  premiumServiceStart         INTEGER             DEFAULT NULL, "
+        "  premiumServiceSKU           TEXT                DEFAULT NULL, "
+        "  lastSuccessfulCharge        INTEGER             DEFAULT NULL, "
+        "  lastFailedCharge            INTEGER             DEFAULT NULL, "
+        "  lastFailedChargeReason      TEXT                DEFAULT NULL, "
+        "  nextPaymentDue              INTEGER             DEFAULT NULL, "
+        "  premiumLockUntil            INTEGER             DEFAULT NULL, "
+        "  updated                     INTEGER             DEFAULT NULL, "
+        "  premiumSubscriptionNumber   TEXT                DEFAULT NULL, "
+        "  lastRequestedCharge         INTEGER             DEFAULT NULL, "
+        "  currency                    TEXT                DEFAULT NULL, "
+        "  unitPrice                   INTEGER             DEFAULT NULL, "
+        "  unitDiscount                INTEGER             DEFAULT NULL, "
+        "  nextChargeDate              INTEGER             DEFAULT NULL, "
+        "  availablePoints             INTEGER             DEFAULT NULL)"));
+    errorPrefix.setBase(QT_TR_NOOP("Can't create Accounting table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS AccountLimits("
+        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
+        "  userMailLimitDaily          INTEGER             DEFAULT NULL, "
+        "  noteSizeMax                 INTEGER             DEFAULT NULL, "
+        "  resourceSizeMax             INTEGER             DEFAULT NULL, "
+        "  userLinkedNotebookMax       INTEGER             DEFAULT NULL, "
+        "  uploadLimit                 INTEGER             DEFAULT NULL, "
+        "  userNoteCountMax            INTEGER             DEFAULT NULL, "
+        "  userNotebookCountMax        INTEGER             DEFAULT NULL, "
+        "  userTagCountMax             INTEGER             DEFAULT NULL, "
+        "  noteTagCountMax             INTEGER             DEFAULT NULL, "
+        "  userSavedSearchesMax        INTEGER             DEFAULT NULL, "
+        "  noteResourceCountMax        INTEGER             DEFAULT NULL)"));
+    errorPrefix.setBase(QT_TR_NOOP("Can't create AccountLimits table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS BusinessUserInfo("
+        "  id REFERENCES Users(id) ON UPDATE CASCADE, "
+        "  businessId              INTEGER                 DEFAULT NULL, "
+        "  businessName            TEXT                    DEFAULT NULL, "
+        "  role                    INTEGER                 DEFAULT NULL, "
+        "  businessInfoEmail       TEXT                    DEFAULT NULL)"));
+    errorPrefix.setBase(QT_TR_NOOP("Can't create BusinessUserInfo table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TRIGGER IF NOT EXISTS on_user_delete_trigger "
+        "BEFORE DELETE ON Users "
         "BEGIN "
-        "INSERT INTO NotebookFTS(NotebookFTS) VALUES('rebuild'); "
+        "DELETE FROM UserAttributes WHERE id=OLD.id; "
+        "DELETE FROM UserAttributesViewedPromotions WHERE id=OLD.id; "
+        "DELETE FROM UserAttributesRecentMailedAddresses WHERE id=OLD.id; "
+        "DELETE FROM Accounting WHERE id=OLD.id; "
+        "DELETE FROM AccountLimits WHERE id=OLD.id; "
+        "DELETE FROM BusinessUserInfo WHERE id=OLD.id; "
         "END"));
+    errorPrefix.setBase(QT_TR_NOOP(
+        "Can't create trigger to fire on deletion from users table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS LinkedNotebooks("
+        "  guid                            TEXT PRIMARY KEY  NOT NULL UNIQUE, "
+        "  updateSequenceNumber            INTEGER           DEFAULT NULL, "
+        "  isDirty                         INTEGER           DEFAULT NULL, "
+        "  shareName                       TEXT              DEFAULT NULL, "
+        "  username                        TEXT              DEFAULT NULL, "
+        "  shardId                         TEXT              DEFAULT NULL, "
+        "  sharedNotebookGlobalId          TEXT              DEFAULT NULL, "
+        "  uri                             TEXT              DEFAULT NULL, "
+        "  noteStoreUrl                    TEXT              DEFAULT NULL, "
+        "  webApiUrlPrefix                 TEXT              DEFAULT NULL, "
+        "  stack                           TEXT              DEFAULT NULL, "
+        "  businessId                      INTEGER           DEFAULT NULL"
+        ")"));
+    errorPrefix.setBase(QT_TR_NOOP("Can't create LinkedNotebooks table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS Notebooks("
+        "  localUid                        TEXT PRIMARY KEY  NOT NULL UNIQUE, "
+        "  guid                            TEXT              DEFAULT NULL "
+        "UNIQUE, "
+        "  linkedNotebookGuid REFERENCES LinkedNotebooks(guid) ON UPDATE "
+        "CASCADE, "
+        "  updateSequenceNumber            INTEGER           DEFAULT NULL, "
+        "  notebookName                    TEXT              DEFAULT NULL, "
+        "  notebookNameUpper               TEXT              DEFAULT NULL, "
+        "  creationTimestamp               INTEGER           DEFAULT NULL, "
+        "  modificationTimestamp           INTEGER           DEFAULT NULL, "
+        "  isDirty                         INTEGER           NOT NULL, "
+        "  isLocal                         INTEGER           NOT NULL, "
+        "  isDefault                       INTEGER           DEFAULT NULL "
+        "UNIQUE, "
+        "  isLastUsed                      INTEGER           DEFAULT NULL "
+        "UNIQUE, "
+        "  isFavorited                     INTEGER           DEFAULT NULL, "
+        "  publishingUri                   TEXT              DEFAULT NULL, "
+        "  publishingNoteSortOrder         INTEGER           DEFAULT NULL, "
+        "  publishingAscendingSort         INTEGER           DEFAULT NULL, "
+        "  publicDescription               TEXT              DEFAULT NULL, "
+        "  isPublished                     INTEGER           DEFAULT NULL, "
+        "  stack                           TEXT              DEFAULT NULL, "
+        "  businessNotebookDescription     TEXT              DEFAULT NULL, "
+        "  businessNotebookPrivilegeLevel  INTEGER           DEFAULT NULL, "
+        "  businessNotebookIsRecommended   INTEGER           DEFAULT NULL, "
+        "  contactId                       INTEGER           DEFAULT NULL, "
+        "  recipientReminderNotifyEmail    INTEGER           DEFAULT NULL, "
+        "  recipientReminderNotifyInApp    INTEGER           DEFAULT NULL, "
+        "  recipientInMyList               INTEGER           DEFAULT NULL, "
+        "  recipientStack                  TEXT              DEFAULT NULL, "
+        "  UNIQUE(localUid, guid), "
+        "  UNIQUE(notebookNameUpper, linkedNotebookGuid) "
+        ")"));
+    errorPrefix.setBase(QT_TR_NOOP("Can't create Notebooks table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(
+        QStringLiteral("CREATE VIRTUAL TABLE IF NOT EXISTS NotebookFTS "
+                       "USING FTS4(content=\"Notebooks\", "
+                       "localUid, guid, notebookName)"));
     errorPrefix.setBase(
-        QT_TR_NOOP("Can't create NotebookFTS_AfterInsertTrigger"));
+        QT_TR_NOOP("Can't create virtual FTS4 NotebookFTS table"));
     DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.exec(QStringLiteral(
@@ -5570,28 +8335,6 @@ bool LocalStorageManagerPrivate::createTables(ErrorString & errorDescription)
     errorPrefix.setBase(QT_TR_NOOP("Can't create virtual FTS4 table NoteFTS"));
     DATABASE_CHECK_AND_SET_ERROR()
 
-    res = query.exec(
-        QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
-                       "NoteFTS_BeforeDeleteTrigger "
-                       "BEFORE DELETE ON Notes "
-                       "BEGIN "
-                       "DELETE FROM NoteFTS WHERE localUid=old.localUid; "
-                       "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger NoteFTS_BeforeDeleteTrigger"));
-    DATABASE_CHECK_AND_SET_ERROR()
-
-    res = query.exec(
-        QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
-                       "NoteFTS_AfterInsertTrigger "
-                       "AFTER INSERT ON Notes "
-                       "BEGIN "
-                       "INSERT INTO NoteFTS(NoteFTS) VALUES('rebuild'); "
-                       "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger NoteFTS_AfterInsertTrigger"));
-    DATABASE_CHECK_AND_SET_ERROR()
-
     res = query.exec(
         QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
                        "on_notebook_delete_trigger "
@@ -5668,32 +8411,6 @@ bool LocalStorageManagerPrivate::createTables(ErrorString & errorDescription)
         "Can't create virtual FTS4 ResourceRecognitionDataFTS table"));
     DATABASE_CHECK_AND_SET_ERROR()
 
-    res = query.exec(
-        QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
-                       "ResourceRecognitionDataFTS_BeforeDeleteTrigger "
-                       "BEFORE DELETE ON ResourceRecognitionData "
-                       "BEGIN "
-                       "DELETE FROM ResourceRecognitionDataFTS "
-                       "WHERE recognitionData=old.recognitionData; "
-                       "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger "
-                   "ResourceRecognitionDataFTS_BeforeDeleteTrigger"));
-    DATABASE_CHECK_AND_SET_ERROR()
-
-    res = query.exec(
-        QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
-                       "ResourceRecognitionDataFTS_AfterInsertTrigger "
-                       "AFTER INSERT ON ResourceRecognitionData "
-                       "BEGIN "
-                       "INSERT INTO ResourceRecognitionDataFTS("
-                       "ResourceRecognitionDataFTS) VALUES('rebuild'); "
-                       "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger "
-                   "ResourceRecognitionDataFTS_AfterInsertTrigger"));
-    DATABASE_CHECK_AND_SET_ERROR()
-
     res = query.exec(
         QStringLiteral("CREATE VIRTUAL TABLE IF NOT EXISTS "
                        "ResourceMimeFTS USING FTS4(content=\"Resources\", "
@@ -5702,30 +8419,6 @@ bool LocalStorageManagerPrivate::createTables(ErrorString & errorDescription)
         QT_TR_NOOP("Can't create virtual FTS4 ResourceMimeFTS table"));
     DATABASE_CHECK_AND_SET_ERROR()
 
-    res = query.exec(
-        QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
-                       "ResourceMimeFTS_BeforeDeleteTrigger "
-                       "BEFORE DELETE ON Resources "
-                       "BEGIN "
-                       "DELETE FROM ResourceMimeFTS WHERE mime=old.mime; "
-                       "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger "
-                   "ResourceMimeFTS_BeforeDeleteTrigger"));
-    DATABASE_CHECK_AND_SET_ERROR()
-
-    res = query.exec(
-        QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
-                       "ResourceMimeFTS_AfterInsertTrigger "
-                       "AFTER INSERT ON Resources "
-                       "BEGIN "
-                       "INSERT INTO ResourceMimeFTS(ResourceMimeFTS) "
-                       "VALUES('rebuild'); "
-                       "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger ResourceMimeFTS_AfterInsertTrigger"));
-    DATABASE_CHECK_AND_SET_ERROR()
-
     res = query.exec(QStringLiteral(
         "CREATE INDEX IF NOT EXISTS ResourceNote ON Resources(noteLocalUid)"));
     errorPrefix.setBase(QT_TR_NOOP("Can't create ResourceNote index"));
@@ -5806,27 +8499,6 @@ bool LocalStorageManagerPrivate::createTables(ErrorString & errorDescription)
     errorPrefix.setBase(QT_TR_NOOP("Can't create virtual FTS4 table TagFTS"));
     DATABASE_CHECK_AND_SET_ERROR()
 
-    res = query.exec(
-        QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
-                       "TagFTS_BeforeDeleteTrigger "
-                       "BEFORE DELETE ON Tags "
-                       "BEGIN "
-                       "DELETE FROM TagFTS WHERE localUid=old.localUid; "
-                       "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger TagFTS_BeforeDeleteTrigger"));
-    DATABASE_CHECK_AND_SET_ERROR()
-
-    res = query.exec(
-        QStringLiteral("CREATE TRIGGER IF NOT EXISTS "
-                       "TagFTS_AfterInsertTrigger AFTER INSERT ON Tags "
-                       "BEGIN "
-                       "INSERT INTO TagFTS(TagFTS) VALUES('rebuild'); "
-                       "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger TagFTS_AfterInsertTrigger"));
-    DATABASE_CHECK_AND_SET_ERROR()
-
     res =
         query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS TagsSearchName "
                                   "ON Tags(nameLower)"));
@@ -5913,61 +8585,180 @@ bool LocalStorageManagerPrivate::createTables(ErrorString & errorDescription)
         QT_TR_NOOP("Can't create trigger to fire on note deletion"));
     DATABASE_CHECK_AND_SET_ERROR()
 
-    res = query.exec(QStringLiteral(
-        "CREATE TRIGGER IF NOT EXISTS "
-        "on_resource_delete_trigger "
-        "BEFORE DELETE ON Resources "
-        "BEGIN "
-        "DELETE FROM ResourceRecognitionData "
-        "WHERE ResourceRecognitionData.resourceLocalUid="
-        "OLD.resourceLocalUid; "
-        "DELETE FROM ResourceAttributes WHERE "
-        "ResourceAttributes.resourceLocalUid=OLD.resourceLocalUid; "
-        "DELETE FROM ResourceAttributesApplicationDataKeysOnly WHERE "
-        "ResourceAttributesApplicationDataKeysOnly.resourceLocalUid="
-        "OLD.resourceLocalUid; "
-        "DELETE FROM ResourceAttributesApplicationDataFullMap WHERE "
-        "ResourceAttributesApplicationDataFullMap.resourceLocalUid="
-        "OLD.resourceLocalUid; "
-        "DELETE FROM NoteResources WHERE "
-        "NoteResources.localResource=OLD.resourceLocalUid; "
-        "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger to fire on resource deletion"));
-    DATABASE_CHECK_AND_SET_ERROR()
+    res = query.exec(QStringLiteral(
+        "CREATE TRIGGER IF NOT EXISTS "
+        "on_resource_delete_trigger "
+        "BEFORE DELETE ON Resources "
+        "BEGIN "
+        "DELETE FROM ResourceRecognitionData "
+        "WHERE ResourceRecognitionData.resourceLocalUid="
+        "OLD.resourceLocalUid; "
+        "DELETE FROM ResourceAttributes WHERE "
+        "ResourceAttributes.resourceLocalUid=OLD.resourceLocalUid; "
+        "DELETE FROM ResourceAttributesApplicationDataKeysOnly WHERE "
+        "ResourceAttributesApplicationDataKeysOnly.resourceLocalUid="
+        "OLD.resourceLocalUid; "
+        "DELETE FROM ResourceAttributesApplicationDataFullMap WHERE "
+        "ResourceAttributesApplicationDataFullMap.resourceLocalUid="
+        "OLD.resourceLocalUid; "
+        "DELETE FROM NoteResources WHERE "
+        "NoteResources.localResource=OLD.resourceLocalUid; "
+        "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger to fire on resource deletion"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(
+        QStringLiteral("CREATE TRIGGER IF NOT EXISTS on_tag_delete_trigger "
+                       "BEFORE DELETE ON Tags "
+                       "BEGIN "
+                       "DELETE FROM NoteTags WHERE "
+                       "NoteTags.localTag=OLD.localUid; "
+                       "END"));
+    errorPrefix.setBase(
+        QT_TR_NOOP("Can't create trigger to fire on tag deletion"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS SavedSearches("
+        "  localUid                        TEXT PRIMARY KEY    NOT NULL "
+        "UNIQUE, "
+        "  guid                            TEXT                DEFAULT NULL "
+        "UNIQUE, "
+        "  name                            TEXT                DEFAULT NULL, "
+        "  nameLower                       TEXT                DEFAULT NULL "
+        "UNIQUE, "
+        "  query                           TEXT                DEFAULT NULL, "
+        "  format                          INTEGER             DEFAULT NULL, "
+        "  updateSequenceNumber            INTEGER             DEFAULT NULL, "
+        "  isDirty                         INTEGER             NOT NULL, "
+        "  isLocal                         INTEGER             NOT NULL, "
+        "  includeAccount                  INTEGER             DEFAULT NULL, "
+        "  includePersonalLinkedNotebooks  INTEGER             DEFAULT NULL, "
+        "  includeBusinessLinkedNotebooks  INTEGER             DEFAULT NULL, "
+        "  isFavorited                     INTEGER             NOT NULL, "
+        "  UNIQUE(localUid, guid))"));
+    errorPrefix.setBase(QT_TR_NOOP("Can't create SavedSearches table"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    // Local storage of versions prior to 3 maintains full text search indices
+    // via triggers rebuilding the whole index on each insertion; such triggers
+    // are replaced with the incremental ones by LocalStoragePatch2To3
+    int version = localStorageVersion(errorDescription);
+    if (Q_UNLIKELY(version < 0)) {
+        return false;
+    }
+
+    if (version < 3) {
+        return true;
+    }
+
+    if (!createFullTextSearchIndexTriggers(errorDescription)) {
+        return false;
+    }
+
+    // Local storage of versions prior to 4 keeps resource binary data in files
+    // per resource; these are moved to the blob store by LocalStoragePatch3To4
+    if (version < 4) {
+        return true;
+    }
+
+    if (!createResourceBlobStoreTables(errorDescription)) {
+        return false;
+    }
+
+    // Local storage of versions prior to 5 has no note counters; these are
+    // created and filled by LocalStoragePatch4To5
+    if (version < 5) {
+        return true;
+    }
+
+    if (!createNoteCounterTables(errorDescription)) {
+        return false;
+    }
+
+    // Local storage of versions prior to 7 has no cached account high USNs;
+    // these are created by LocalStoragePatch6To7
+    if (version < 7) {
+        return true;
+    }
+
+    if (!createAccountHighUsnTables(errorDescription)) {
+        return false;
+    }
+
+    // Local storage of versions prior to 8 has no note location index; it is
+    // created and filled by LocalStoragePatch7To8
+    if (version < 8) {
+        return true;
+    }
+
+    return createNoteLocationIndexTables(errorDescription);
+}
+
+bool LocalStorageManagerPrivate::processBatchInTransaction(
+    const int numItems,
+    const std::function<bool(const int, ErrorString &)> & processItem,
+    QList<ErrorString> & itemErrorDescriptions, ErrorString & errorDescription)
+{
+    itemErrorDescriptions.clear();
+    itemErrorDescriptions.reserve(numItems);
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("Can't process the batch of items in the local storage "
+                   "database"));
+
+    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Exclusive);
+
+    for (int i = 0; i < numItems; ++i) {
+        Transaction itemTransaction(
+            m_sqlDatabase, *this, Transaction::Type::Exclusive);
+
+        ErrorString itemError;
+        if (!processItem(i, itemError)) {
+            if (itemError.isEmpty()) {
+                itemError.setBase(QT_TR_NOOP("unknown error"));
+            }
+
+            ErrorString error;
+            if (Q_UNLIKELY(!itemTransaction.rollback(error))) {
+                errorDescription.base() = errorPrefix.base();
+                errorDescription.appendBase(error.base());
+                errorDescription.appendBase(error.additionalBases());
+                errorDescription.details() = error.details();
+                QNWARNING("local_storage", errorDescription);
+                itemErrorDescriptions.clear();
+                return false;
+            }
+
+            itemErrorDescriptions << itemError;
+            continue;
+        }
+
+        ErrorString error;
+        if (Q_UNLIKELY(!itemTransaction.commit(error))) {
+            errorDescription.base() = errorPrefix.base();
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            QNWARNING("local_storage", errorDescription);
+            itemErrorDescriptions.clear();
+            return false;
+        }
 
-    res = query.exec(
-        QStringLiteral("CREATE TRIGGER IF NOT EXISTS on_tag_delete_trigger "
-                       "BEFORE DELETE ON Tags "
-                       "BEGIN "
-                       "DELETE FROM NoteTags WHERE "
-                       "NoteTags.localTag=OLD.localUid; "
-                       "END"));
-    errorPrefix.setBase(
-        QT_TR_NOOP("Can't create trigger to fire on tag deletion"));
-    DATABASE_CHECK_AND_SET_ERROR()
+        itemErrorDescriptions << ErrorString();
+    }
 
-    res = query.exec(QStringLiteral(
-        "CREATE TABLE IF NOT EXISTS SavedSearches("
-        "  localUid                        TEXT PRIMARY KEY    NOT NULL "
-        "UNIQUE, "
-        "  guid                            TEXT                DEFAULT NULL "
-        "UNIQUE, "
-        "  name                            TEXT                DEFAULT NULL, "
-        "  nameLower                       TEXT                DEFAULT NULL "
-        "UNIQUE, "
-        "  query                           TEXT                DEFAULT NULL, "
-        "  format                          INTEGER             DEFAULT NULL, "
-        "  updateSequenceNumber            INTEGER             DEFAULT NULL, "
-        "  isDirty                         INTEGER             NOT NULL, "
-        "  isLocal                         INTEGER             NOT NULL, "
-        "  includeAccount                  INTEGER             DEFAULT NULL, "
-        "  includePersonalLinkedNotebooks  INTEGER             DEFAULT NULL, "
-        "  includeBusinessLinkedNotebooks  INTEGER             DEFAULT NULL, "
-        "  isFavorited                     INTEGER             NOT NULL, "
-        "  UNIQUE(localUid, guid))"));
-    errorPrefix.setBase(QT_TR_NOOP("Can't create SavedSearches table"));
-    DATABASE_CHECK_AND_SET_ERROR()
+    ErrorString error;
+    if (Q_UNLIKELY(!transaction.commit(error))) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        itemErrorDescriptions.clear();
+        return false;
+    }
 
     return true;
 }
@@ -6033,7 +8824,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceNotebookRestrictions(
                       .ref())
             : nullValue);
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -6142,7 +8933,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceSharedNotebook(
              ? sharedNotebook.indexInNotebook()
              : nullValue));
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -6159,7 +8950,7 @@ bool LocalStorageManagerPrivate::rowExists(
             .arg(tableName, uniqueKeyName, key);
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     if (!res) {
         QNWARNING(
             "local_storage",
@@ -6272,7 +9063,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUser(
                  ? user.photoLastUpdateTimestamp()
                  : nullValue));
 
-        res = query.exec();
+        res = execQuery(query);
         DATABASE_CHECK_AND_SET_ERROR()
     }
 
@@ -6298,7 +9089,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUser(
                     .arg(userId);
 
             QSqlQuery query(m_sqlDatabase);
-            bool res = query.exec(queryString);
+            bool res = execQuery(query, queryString);
             DATABASE_CHECK_AND_SET_ERROR()
         }
 
@@ -6311,7 +9102,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUser(
                     .arg(userId);
 
             QSqlQuery query(m_sqlDatabase);
-            bool res = query.exec(queryString);
+            bool res = execQuery(query, queryString);
             DATABASE_CHECK_AND_SET_ERROR()
         }
 
@@ -6322,7 +9113,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUser(
                     .arg(userId);
 
             QSqlQuery query(m_sqlDatabase);
-            bool res = query.exec(queryString);
+            bool res = execQuery(query, queryString);
             DATABASE_CHECK_AND_SET_ERROR()
         }
     }
@@ -6344,7 +9135,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUser(
             QString::fromUtf8("DELETE FROM Accounting WHERE id=%1").arg(userId);
 
         QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
+        bool res = execQuery(query, queryString);
         DATABASE_CHECK_AND_SET_ERROR()
     }
 
@@ -6366,7 +9157,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUser(
                 .arg(userId);
 
         QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
+        bool res = execQuery(query, queryString);
         DATABASE_CHECK_AND_SET_ERROR()
     }
 
@@ -6388,7 +9179,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUser(
                 .arg(userId);
 
         QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
+        bool res = execQuery(query, queryString);
         DATABASE_CHECK_AND_SET_ERROR()
     }
 
@@ -6426,7 +9217,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceBusinessUserInfo(
         QStringLiteral(":businessInfoEmail"),
         (info.email.isSet() ? info.email.ref() : nullValue));
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -6475,7 +9266,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceAccounting(
 
 #undef CHECK_AND_BIND_VALUE
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -6516,7 +9307,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceAccountLimits(
 
 #undef CHECK_AND_BIND_VALUE
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -6589,7 +9380,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUserAttributes(
 
 #undef CHECK_AND_BIND_BOOLEAN_VALUE
 
-        res = query.exec();
+        res = execQuery(query);
         DATABASE_CHECK_AND_SET_ERROR()
     }
 
@@ -6601,7 +9392,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUserAttributes(
                 .arg(id);
 
         QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
+        bool res = execQuery(query, queryString);
         DATABASE_CHECK_AND_SET_ERROR()
     }
 
@@ -6617,7 +9408,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUserAttributes(
         const auto & viewedPromotions = attributes.viewedPromotions.ref();
         for (const auto & viewedPromotion: viewedPromotions) {
             query.bindValue(QStringLiteral(":promotion"), viewedPromotion);
-            res = query.exec();
+            res = execQuery(query);
             DATABASE_CHECK_AND_SET_ERROR()
         }
     }
@@ -6630,7 +9421,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUserAttributes(
                 .arg(id);
 
         QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
+        bool res = execQuery(query, queryString);
         DATABASE_CHECK_AND_SET_ERROR()
     }
 
@@ -6650,7 +9441,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceUserAttributes(
 
         for (const auto & recentMailedAddress: recentMailedAddresses) {
             query.bindValue(QStringLiteral(":address"), recentMailedAddress);
-            res = query.exec();
+            res = execQuery(query);
             DATABASE_CHECK_AND_SET_ERROR()
         }
     }
@@ -6701,1378 +9492,1889 @@ bool LocalStorageManagerPrivate::checkAndPrepareInsertOrReplaceUserQuery()
         ":userPhotoUrl, :userPhotoLastUpdateTimestamp)");
     bool res = m_insertOrReplaceUserQuery.prepare(queryString);
     if (res) {
-        m_insertOrReplaceUserQueryPrepared = true;
+        m_insertOrReplaceUserQueryPrepared = true;
+    }
+
+    return res;
+}
+
+bool LocalStorageManagerPrivate::checkAndPrepareInsertOrReplaceAccountingQuery()
+{
+    if (Q_LIKELY(m_insertOrReplaceAccountingQueryPrepared)) {
+        return true;
+    }
+
+    QNDEBUG(
+        "local_storage",
+        "Preparing SQL query to insert or replace "
+            << "accounting");
+
+    m_insertOrReplaceAccountingQuery = QSqlQuery(m_sqlDatabase);
+
+    QString queryString = QStringLiteral(
+        "INSERT OR REPLACE INTO Accounting"
+        "(id, uploadLimitEnd, uploadLimitNextMonth, "
+        "premiumServiceStatus, premiumOrderNumber, "
+        "premiumCommerceService, premiumServiceStart, "
+        "premiumServiceSKU, lastSuccessfulCharge, "
+        "lastFailedCharge, lastFailedChargeReason, nextPaymentDue, "
+        "premiumLockUntil, updated, premiumSubscriptionNumber, "
+        "lastRequestedCharge, currency, unitPrice, unitDiscount, "
+        "nextChargeDate, availablePoints) "
+        "VALUES(:id, :uploadLimitEnd, :uploadLimitNextMonth, "
+        ":premiumServiceStatus, :premiumOrderNumber, "
+        ":premiumCommerceService, :premiumServiceStart, "
+        ":premiumServiceSKU, :lastSuccessfulCharge, "
+        ":lastFailedCharge, :lastFailedChargeReason, "
+        ":nextPaymentDue, :premiumLockUntil, :updated, "
+        ":premiumSubscriptionNumber, :lastRequestedCharge, "
+        ":currency, :unitPrice, :unitDiscount, :nextChargeDate, "
+        ":availablePoints)");
+
+    bool res = m_insertOrReplaceAccountingQuery.prepare(queryString);
+    if (res) {
+        m_insertOrReplaceAccountingQueryPrepared = true;
+    }
+
+    return res;
+}
+
+bool LocalStorageManagerPrivate::
+    checkAndPrepareInsertOrReplaceAccountLimitsQuery()
+{
+    if (Q_LIKELY(m_insertOrReplaceAccountLimitsQueryPrepared)) {
+        return true;
+    }
+
+    QNDEBUG(
+        "local_storage",
+        "Preparing SQL query to insert or replace account "
+            << "limits");
+
+    m_insertOrReplaceAccountLimitsQuery = QSqlQuery(m_sqlDatabase);
+
+    QString queryString = QStringLiteral(
+        "INSERT OR REPLACE INTO AccountLimits"
+        "(id, userMailLimitDaily, noteSizeMax, resourceSizeMax, "
+        "userLinkedNotebookMax, uploadLimit, userNoteCountMax, "
+        "userNotebookCountMax, userTagCountMax, noteTagCountMax, "
+        "userSavedSearchesMax, noteResourceCountMax) "
+        "VALUES(:id, :userMailLimitDaily, :noteSizeMax, "
+        ":resourceSizeMax, :userLinkedNotebookMax, :uploadLimit, "
+        ":userNoteCountMax, :userNotebookCountMax, "
+        ":userTagCountMax, :noteTagCountMax, "
+        ":userSavedSearchesMax, :noteResourceCountMax)");
+
+    bool res = m_insertOrReplaceAccountLimitsQuery.prepare(queryString);
+    if (res) {
+        m_insertOrReplaceAccountLimitsQueryPrepared = true;
+    }
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::
+    checkAndPrepareInsertOrReplaceBusinessUserInfoQuery()
+{
+    if (Q_LIKELY(m_insertOrReplaceBusinessUserInfoQueryPrepared)) {
+        return true;
+    }
+
+    QNDEBUG(
+        "local_storage",
+        "Preparing SQl query to insert or replace "
+            << "business user info");
+
+    m_insertOrReplaceBusinessUserInfoQuery = QSqlQuery(m_sqlDatabase);
+
+    QString queryString = QStringLiteral(
+        "INSERT OR REPLACE INTO BusinessUserInfo"
+        "(id, businessId, businessName, role, businessInfoEmail) "
+        "VALUES(:id, :businessId, :businessName, :role, :businessInfoEmail)");
+
+    bool res = m_insertOrReplaceBusinessUserInfoQuery.prepare(queryString);
+    if (res) {
+        m_insertOrReplaceBusinessUserInfoQueryPrepared = true;
+    }
+
+    return res;
+}
+
+bool LocalStorageManagerPrivate::
+    checkAndPrepareInsertOrReplaceUserAttributesQuery()
+{
+    if (Q_LIKELY(m_insertOrReplaceUserAttributesQueryPrepared)) {
+        return true;
+    }
+
+    QNDEBUG(
+        "local_storage",
+        "Preparing SQL query to insert or replace user "
+            << "attributes");
+
+    m_insertOrReplaceUserAttributesQuery = QSqlQuery(m_sqlDatabase);
+
+    QString queryString = QStringLiteral(
+        "INSERT OR REPLACE INTO UserAttributes"
+        "(id, defaultLocationName, defaultLatitude, "
+        "defaultLongitude, preactivation, "
+        "incomingEmailAddress, comments, "
+        "dateAgreedToTermsOfService, maxReferrals, "
+        "referralCount, refererCode, sentEmailDate, "
+        "sentEmailCount, dailyEmailLimit, "
+        "emailOptOutDate, partnerEmailOptInDate, "
+        "preferredLanguage, preferredCountry, "
+        "clipFullPage, twitterUserName, twitterId, "
+        "groupName, recognitionLanguage, "
+        "referralProof, educationalDiscount, "
+        "businessAddress, hideSponsorBilling, "
+        "useEmailAutoFiling, reminderEmailConfig, "
+        "emailAddressLastConfirmed, passwordUpdated, "
+        "salesforcePushEnabled, shouldLogClientEvent) "
+        "VALUES(:id, :defaultLocationName, :defaultLatitude, "
+        ":defaultLongitude, :preactivation, "
+        ":incomingEmailAddress, :comments, "
+        ":dateAgreedToTermsOfService, :maxReferrals, "
+        ":referralCount, :refererCode, :sentEmailDate, "
+        ":sentEmailCount, :dailyEmailLimit, "
+        ":emailOptOutDate, :partnerEmailOptInDate, "
+        ":preferredLanguage, :preferredCountry, "
+        ":clipFullPage, :twitterUserName, :twitterId, "
+        ":groupName, :recognitionLanguage, "
+        ":referralProof, :educationalDiscount, "
+        ":businessAddress, :hideSponsorBilling, "
+        ":useEmailAutoFiling, :reminderEmailConfig, "
+        ":emailAddressLastConfirmed, :passwordUpdated, "
+        ":salesforcePushEnabled, :shouldLogClientEvent)");
+
+    bool res = m_insertOrReplaceUserAttributesQuery.prepare(queryString);
+    if (res) {
+        m_insertOrReplaceUserAttributesQueryPrepared = true;
+    }
+
+    return res;
+}
+
+bool LocalStorageManagerPrivate::
+    checkAndPrepareInsertOrReplaceUserAttributesViewedPromotionsQuery()
+{
+    if (Q_LIKELY(m_insertOrReplaceUserAttributesViewedPromotionsQueryPrepared))
+    {
+        return true;
+    }
+
+    QNDEBUG(
+        "local_storage",
+        "Preparing SQL query to insert or replace user "
+            << "attributes viewed promotions");
+
+    m_insertOrReplaceUserAttributesViewedPromotionsQuery =
+        QSqlQuery(m_sqlDatabase);
+
+    QString queryString = QStringLiteral(
+        "INSERT OR REPLACE INTO UserAttributesViewedPromotions"
+        "(id, promotion) VALUES(:id, :promotion)");
+
+    bool res = m_insertOrReplaceUserAttributesViewedPromotionsQuery.prepare(
+        queryString);
+
+    if (res) {
+        m_insertOrReplaceUserAttributesViewedPromotionsQueryPrepared = true;
     }
 
     return res;
 }
 
-bool LocalStorageManagerPrivate::checkAndPrepareInsertOrReplaceAccountingQuery()
+bool LocalStorageManagerPrivate::
+    checkAndPrepareInsertOrReplaceUserAttributesRecentMailedAddressesQuery()
 {
-    if (Q_LIKELY(m_insertOrReplaceAccountingQueryPrepared)) {
+    if (Q_LIKELY(
+            m_insertOrReplaceUserAttributesRecentMailedAddressesQueryPrepared))
+    {
         return true;
     }
 
     QNDEBUG(
         "local_storage",
-        "Preparing SQL query to insert or replace "
-            << "accounting");
+        "Preparing SQL query to insert or replace user "
+            << "attributes recent mailed addresses");
 
-    m_insertOrReplaceAccountingQuery = QSqlQuery(m_sqlDatabase);
+    m_insertOrReplaceUserAttributesRecentMailedAddressesQuery =
+        QSqlQuery(m_sqlDatabase);
 
     QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO Accounting"
-        "(id, uploadLimitEnd, uploadLimitNextMonth, "
-        "premiumServiceStatus, premiumOrderNumber, "
-        "premiumCommerceService, premiumServiceStart, "
-        "premiumServiceSKU, lastSuccessfulCharge, "
-        "lastFailedCharge, lastFailedChargeReason, nextPaymentDue, "
-        "premiumLockUntil, updated, premiumSubscriptionNumber, "
-        "lastRequestedCharge, currency, unitPrice, unitDiscount, "
-        "nextChargeDate, availablePoints) "
-        "VALUES(:id, :uploadLimitEnd, :uploadLimitNextMonth, "
-        ":premiumServiceStatus, :premiumOrderNumber, "
-        ":premiumCommerceService, :premiumServiceStart, "
-        ":premiumServiceSKU, :lastSuccessfulCharge, "
-        ":lastFailedCharge, :lastFailedChargeReason, "
-        ":nextPaymentDue, :premiumLockUntil, :updated, "
-        ":premiumSubscriptionNumber, :lastRequestedCharge, "
-        ":currency, :unitPrice, :unitDiscount, :nextChargeDate, "
-        ":availablePoints)");
+        "INSERT OR REPLACE INTO UserAttributesRecentMailedAddresses"
+        "(id, address) VALUES(:id, :address)");
+
+    bool res =
+        m_insertOrReplaceUserAttributesRecentMailedAddressesQuery.prepare(
+            queryString);
 
-    bool res = m_insertOrReplaceAccountingQuery.prepare(queryString);
     if (res) {
-        m_insertOrReplaceAccountingQueryPrepared = true;
+        m_insertOrReplaceUserAttributesRecentMailedAddressesQueryPrepared =
+            true;
     }
 
     return res;
 }
 
-bool LocalStorageManagerPrivate::
-    checkAndPrepareInsertOrReplaceAccountLimitsQuery()
+bool LocalStorageManagerPrivate::checkAndPrepareDeleteUserQuery()
 {
-    if (Q_LIKELY(m_insertOrReplaceAccountLimitsQueryPrepared)) {
+    if (Q_LIKELY(m_deleteUserQueryPrepared)) {
         return true;
     }
 
-    QNDEBUG(
-        "local_storage",
-        "Preparing SQL query to insert or replace account "
-            << "limits");
+    QNDEBUG("local_storage", "Preparing SQL query to mark user deleted");
 
-    m_insertOrReplaceAccountLimitsQuery = QSqlQuery(m_sqlDatabase);
+    m_deleteUserQuery = QSqlQuery(m_sqlDatabase);
 
     QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO AccountLimits"
-        "(id, userMailLimitDaily, noteSizeMax, resourceSizeMax, "
-        "userLinkedNotebookMax, uploadLimit, userNoteCountMax, "
-        "userNotebookCountMax, userTagCountMax, noteTagCountMax, "
-        "userSavedSearchesMax, noteResourceCountMax) "
-        "VALUES(:id, :userMailLimitDaily, :noteSizeMax, "
-        ":resourceSizeMax, :userLinkedNotebookMax, :uploadLimit, "
-        ":userNoteCountMax, :userNotebookCountMax, "
-        ":userTagCountMax, :noteTagCountMax, "
-        ":userSavedSearchesMax, :noteResourceCountMax)");
+        "UPDATE Users SET userDeletionTimestamp = :userDeletionTimestamp, "
+        "userIsLocal = :userIsLocal WHERE id = :id");
 
-    bool res = m_insertOrReplaceAccountLimitsQuery.prepare(queryString);
+    bool res = m_deleteUserQuery.prepare(queryString);
     if (res) {
-        m_insertOrReplaceAccountLimitsQueryPrepared = true;
+        m_deleteUserQueryPrepared = true;
     }
 
-    return true;
+    return res;
 }
 
-bool LocalStorageManagerPrivate::
-    checkAndPrepareInsertOrReplaceBusinessUserInfoQuery()
+bool LocalStorageManagerPrivate::insertOrReplaceNotebook(
+    const Notebook & notebook, ErrorString & errorDescription)
 {
-    if (Q_LIKELY(m_insertOrReplaceBusinessUserInfoQueryPrepared)) {
-        return true;
-    }
+    // NOTE: this method expects to be called after notebook is already checked
+    // for sanity of its parameters!
 
-    QNDEBUG(
-        "local_storage",
-        "Preparing SQl query to insert or replace "
-            << "business user info");
+    ErrorString errorPrefix(QT_TR_NOOP("can't insert or replace notebook"));
 
-    m_insertOrReplaceBusinessUserInfoQuery = QSqlQuery(m_sqlDatabase);
+    invalidateCompiledNoteSearchQueries();
 
-    QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO BusinessUserInfo"
-        "(id, businessId, businessName, role, businessInfoEmail) "
-        "VALUES(:id, :businessId, :businessName, :role, :businessInfoEmail)");
+    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Exclusive);
 
-    bool res = m_insertOrReplaceBusinessUserInfoQuery.prepare(queryString);
-    if (res) {
-        m_insertOrReplaceBusinessUserInfoQueryPrepared = true;
+    QString localUid = sqlEscapeString(notebook.localUid());
+    QVariant nullValue;
+
+    // Insert or replace common Notebook data
+    {
+        bool res = checkAndPrepareInsertOrReplaceNotebookQuery();
+        QSqlQuery & query = m_insertOrReplaceNotebookQuery;
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        query.bindValue(
+            QStringLiteral(":localUid"),
+            (localUid.isEmpty() ? nullValue : localUid));
+
+        query.bindValue(
+            QStringLiteral(":guid"),
+            (notebook.hasGuid() ? notebook.guid() : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":linkedNotebookGuid"),
+            (notebook.hasLinkedNotebookGuid() ? notebook.linkedNotebookGuid()
+                                              : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":updateSequenceNumber"),
+            (notebook.hasUpdateSequenceNumber()
+                 ? notebook.updateSequenceNumber()
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":notebookName"),
+            (notebook.hasName() ? notebook.name() : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":notebookNameUpper"),
+            (notebook.hasName() ? notebook.name().toUpper() : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":creationTimestamp"),
+            (notebook.hasCreationTimestamp() ? notebook.creationTimestamp()
+                                             : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":modificationTimestamp"),
+            (notebook.hasModificationTimestamp()
+                 ? notebook.modificationTimestamp()
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":isDirty"), (notebook.isDirty() ? 1 : 0));
+
+        query.bindValue(
+            QStringLiteral(":isLocal"), (notebook.isLocal() ? 1 : 0));
+
+        query.bindValue(
+            QStringLiteral(":isDefault"),
+            (notebook.isDefaultNotebook() ? 1 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":isLastUsed"),
+            (notebook.isLastUsed() ? 1 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":isFavorited"), (notebook.isFavorited() ? 1 : 0));
+
+        query.bindValue(
+            QStringLiteral(":publishingUri"),
+            (notebook.hasPublishingUri() ? notebook.publishingUri()
+                                         : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":publishingNoteSortOrder"),
+            (notebook.hasPublishingOrder() ? notebook.publishingOrder()
+                                           : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":publishingAscendingSort"),
+            (notebook.hasPublishingAscending()
+                 ? (notebook.isPublishingAscending() ? 1 : 0)
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":publicDescription"),
+            (notebook.hasPublishingPublicDescription()
+                 ? notebook.publishingPublicDescription()
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":isPublished"),
+            (notebook.hasPublished() ? (notebook.isPublished() ? 1 : 0)
+                                     : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":stack"),
+            (notebook.hasStack() ? notebook.stack() : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":businessNotebookDescription"),
+            (notebook.hasBusinessNotebookDescription()
+                 ? notebook.businessNotebookDescription()
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":businessNotebookPrivilegeLevel"),
+            (notebook.hasBusinessNotebookPrivilegeLevel()
+                 ? notebook.businessNotebookPrivilegeLevel()
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":businessNotebookIsRecommended"),
+            (notebook.hasBusinessNotebookRecommended()
+                 ? (notebook.isBusinessNotebookRecommended() ? 1 : 0)
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":contactId"),
+            ((notebook.hasContact() && notebook.contact().hasId())
+                 ? notebook.contact().id()
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":recipientReminderNotifyEmail"),
+            (notebook.hasRecipientReminderNotifyEmail()
+                 ? (notebook.recipientReminderNotifyEmail() ? 1 : 0)
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":recipientReminderNotifyInApp"),
+            (notebook.hasRecipientReminderNotifyInApp()
+                 ? (notebook.recipientReminderNotifyInApp() ? 1 : 0)
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":recipientInMyList"),
+            (notebook.hasRecipientInMyList()
+                 ? (notebook.recipientInMyList() ? 1 : 0)
+                 : nullValue));
+
+        query.bindValue(
+            QStringLiteral(":recipientStack"),
+            (notebook.hasRecipientStack() ? notebook.recipientStack()
+                                          : nullValue));
+
+        res = execQuery(query);
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
+
+    if (notebook.hasRestrictions()) {
+        ErrorString error;
+        bool res = insertOrReplaceNotebookRestrictions(
+            localUid, notebook.restrictions(), error);
+
+        if (!res) {
+            errorDescription.base() = errorPrefix.base();
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            return res;
+        }
     }
+    else {
+        QString queryString =
+            QString::fromUtf8(
+                "DELETE FROM NotebookRestrictions WHERE localUid='%1'")
+                .arg(localUid);
 
-    return res;
-}
-
-bool LocalStorageManagerPrivate::
-    checkAndPrepareInsertOrReplaceUserAttributesQuery()
-{
-    if (Q_LIKELY(m_insertOrReplaceUserAttributesQueryPrepared)) {
-        return true;
+        QSqlQuery query(m_sqlDatabase);
+        bool res = execQuery(query, queryString);
+        DATABASE_CHECK_AND_SET_ERROR()
     }
 
-    QNDEBUG(
-        "local_storage",
-        "Preparing SQL query to insert or replace user "
-            << "attributes");
+    if (notebook.hasGuid()) {
+        QString guid = sqlEscapeString(notebook.guid());
+        QString queryString = QString::fromUtf8(
+                                  "DELETE FROM SharedNotebooks WHERE "
+                                  "sharedNotebookNotebookGuid='%1'")
+                                  .arg(guid);
 
-    m_insertOrReplaceUserAttributesQuery = QSqlQuery(m_sqlDatabase);
+        QSqlQuery query(m_sqlDatabase);
+        bool res = execQuery(query, queryString);
+        DATABASE_CHECK_AND_SET_ERROR()
 
-    QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO UserAttributes"
-        "(id, defaultLocationName, defaultLatitude, "
-        "defaultLongitude, preactivation, "
-        "incomingEmailAddress, comments, "
-        "dateAgreedToTermsOfService, maxReferrals, "
-        "referralCount, refererCode, sentEmailDate, "
-        "sentEmailCount, dailyEmailLimit, "
-        "emailOptOutDate, partnerEmailOptInDate, "
-        "preferredLanguage, preferredCountry, "
-        "clipFullPage, twitterUserName, twitterId, "
-        "groupName, recognitionLanguage, "
-        "referralProof, educationalDiscount, "
-        "businessAddress, hideSponsorBilling, "
-        "useEmailAutoFiling, reminderEmailConfig, "
-        "emailAddressLastConfirmed, passwordUpdated, "
-        "salesforcePushEnabled, shouldLogClientEvent) "
-        "VALUES(:id, :defaultLocationName, :defaultLatitude, "
-        ":defaultLongitude, :preactivation, "
-        ":incomingEmailAddress, :comments, "
-        ":dateAgreedToTermsOfService, :maxReferrals, "
-        ":referralCount, :refererCode, :sentEmailDate, "
-        ":sentEmailCount, :dailyEmailLimit, "
-        ":emailOptOutDate, :partnerEmailOptInDate, "
-        ":preferredLanguage, :preferredCountry, "
-        ":clipFullPage, :twitterUserName, :twitterId, "
-        ":groupName, :recognitionLanguage, "
-        ":referralProof, :educationalDiscount, "
-        ":businessAddress, :hideSponsorBilling, "
-        ":useEmailAutoFiling, :reminderEmailConfig, "
-        ":emailAddressLastConfirmed, :passwordUpdated, "
-        ":salesforcePushEnabled, :shouldLogClientEvent)");
+        auto sharedNotebooks = notebook.sharedNotebooks();
+        for (int i = 0, size = sharedNotebooks.size(); i < size; ++i) {
+            const SharedNotebook & sharedNotebook = sharedNotebooks[i];
+            if (!sharedNotebook.hasId()) {
+                QNWARNING(
+                    "local_storage",
+                    "Found shared notebook without "
+                        << "primary identifier of the share set, skipping it: "
+                        << sharedNotebook);
+                continue;
+            }
 
-    bool res = m_insertOrReplaceUserAttributesQuery.prepare(queryString);
-    if (res) {
-        m_insertOrReplaceUserAttributesQueryPrepared = true;
+            ErrorString error;
+            res = insertOrReplaceSharedNotebook(sharedNotebook, error);
+            if (!res) {
+                errorDescription.base() = errorPrefix.base();
+                errorDescription.appendBase(error.base());
+                errorDescription.appendBase(error.additionalBases());
+                errorDescription.details() = error.details();
+                return res;
+            }
+        }
     }
 
-    return res;
+    if (!transaction.commit(errorDescription)) {
+        return false;
+    }
+
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::Notebook,
+        (notebook.hasGuid() ? notebook.guid() : QString()),
+        notebook.localUid());
+
+    return true;
 }
 
-bool LocalStorageManagerPrivate::
-    checkAndPrepareInsertOrReplaceUserAttributesViewedPromotionsQuery()
+bool LocalStorageManagerPrivate::checkAndPrepareNotebookCountQuery() const
 {
-    if (Q_LIKELY(m_insertOrReplaceUserAttributesViewedPromotionsQueryPrepared))
-    {
+    if (Q_LIKELY(m_getNotebookCountQueryPrepared)) {
         return true;
     }
 
     QNDEBUG(
         "local_storage",
-        "Preparing SQL query to insert or replace user "
-            << "attributes viewed promotions");
-
-    m_insertOrReplaceUserAttributesViewedPromotionsQuery =
-        QSqlQuery(m_sqlDatabase);
-
-    QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO UserAttributesViewedPromotions"
-        "(id, promotion) VALUES(:id, :promotion)");
-
-    bool res = m_insertOrReplaceUserAttributesViewedPromotionsQuery.prepare(
-        queryString);
+        "Preparing SQL query to get the count of "
+            << "notebooks");
 
+    m_getNotebookCountQuery = QSqlQuery(m_sqlDatabase);
+    QString queryString = QStringLiteral("SELECT COUNT(*) FROM Notebooks");
+    bool res = m_getNotebookCountQuery.prepare(queryString);
     if (res) {
-        m_insertOrReplaceUserAttributesViewedPromotionsQueryPrepared = true;
+        m_getNotebookCountQueryPrepared = true;
     }
 
     return res;
 }
 
-bool LocalStorageManagerPrivate::
-    checkAndPrepareInsertOrReplaceUserAttributesRecentMailedAddressesQuery()
+bool LocalStorageManagerPrivate::checkAndPrepareInsertOrReplaceNotebookQuery()
 {
-    if (Q_LIKELY(
-            m_insertOrReplaceUserAttributesRecentMailedAddressesQueryPrepared))
-    {
+    if (Q_LIKELY(m_insertOrReplaceNotebookQueryPrepared)) {
         return true;
     }
 
     QNDEBUG(
         "local_storage",
-        "Preparing SQL query to insert or replace user "
-            << "attributes recent mailed addresses");
+        "Preparing SQL query to insert or replace "
+            << "notebook");
 
-    m_insertOrReplaceUserAttributesRecentMailedAddressesQuery =
-        QSqlQuery(m_sqlDatabase);
+    m_insertOrReplaceNotebookQuery = QSqlQuery(m_sqlDatabase);
 
     QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO UserAttributesRecentMailedAddresses"
-        "(id, address) VALUES(:id, :address)");
-
-    bool res =
-        m_insertOrReplaceUserAttributesRecentMailedAddressesQuery.prepare(
-            queryString);
+        "INSERT OR REPLACE INTO Notebooks"
+        "(localUid, guid, linkedNotebookGuid, "
+        "updateSequenceNumber, notebookName, notebookNameUpper, "
+        "creationTimestamp, modificationTimestamp, isDirty, "
+        "isLocal, isDefault, isLastUsed, isFavorited, "
+        "publishingUri, publishingNoteSortOrder, "
+        "publishingAscendingSort, publicDescription, isPublished, "
+        "stack, businessNotebookDescription, "
+        "businessNotebookPrivilegeLevel, "
+        "businessNotebookIsRecommended, contactId, "
+        "recipientReminderNotifyEmail, recipientReminderNotifyInApp, "
+        "recipientInMyList, recipientStack) "
+        "VALUES(:localUid, :guid, :linkedNotebookGuid, "
+        ":updateSequenceNumber, :notebookName, :notebookNameUpper, "
+        ":creationTimestamp, :modificationTimestamp, :isDirty, "
+        ":isLocal, :isDefault, :isLastUsed, :isFavorited, "
+        ":publishingUri, :publishingNoteSortOrder, "
+        ":publishingAscendingSort, :publicDescription, "
+        ":isPublished, :stack, :businessNotebookDescription, "
+        ":businessNotebookPrivilegeLevel, "
+        ":businessNotebookIsRecommended, :contactId, "
+        ":recipientReminderNotifyEmail, "
+        ":recipientReminderNotifyInApp, :recipientInMyList, "
+        ":recipientStack)");
 
+    bool res = m_insertOrReplaceNotebookQuery.prepare(queryString);
     if (res) {
-        m_insertOrReplaceUserAttributesRecentMailedAddressesQueryPrepared =
-            true;
+        m_insertOrReplaceNotebookQueryPrepared = true;
     }
 
     return res;
 }
 
-bool LocalStorageManagerPrivate::checkAndPrepareDeleteUserQuery()
+bool LocalStorageManagerPrivate::
+    checkAndPrepareInsertOrReplaceNotebookRestrictionsQuery()
 {
-    if (Q_LIKELY(m_deleteUserQueryPrepared)) {
+    if (Q_LIKELY(m_insertOrReplaceNotebookRestrictionsQueryPrepared)) {
         return true;
     }
 
-    QNDEBUG("local_storage", "Preparing SQL query to mark user deleted");
+    QNDEBUG(
+        "local_storage",
+        "Preparing SQL query to insert or replace "
+            << "notebook restrictions");
 
-    m_deleteUserQuery = QSqlQuery(m_sqlDatabase);
+    m_insertOrReplaceNotebookRestrictionsQuery = QSqlQuery(m_sqlDatabase);
 
     QString queryString = QStringLiteral(
-        "UPDATE Users SET userDeletionTimestamp = :userDeletionTimestamp, "
-        "userIsLocal = :userIsLocal WHERE id = :id");
-
-    bool res = m_deleteUserQuery.prepare(queryString);
-    if (res) {
-        m_deleteUserQueryPrepared = true;
-    }
-
-    return res;
-}
-
-bool LocalStorageManagerPrivate::insertOrReplaceNotebook(
-    const Notebook & notebook, ErrorString & errorDescription)
-{
-    // NOTE: this method expects to be called after notebook is already checked
-    // for sanity of its parameters!
-
-    ErrorString errorPrefix(QT_TR_NOOP("can't insert or replace notebook"));
-
-    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Exclusive);
-
-    QString localUid = sqlEscapeString(notebook.localUid());
-    QVariant nullValue;
-
-    // Insert or replace common Notebook data
-    {
-        bool res = checkAndPrepareInsertOrReplaceNotebookQuery();
-        QSqlQuery & query = m_insertOrReplaceNotebookQuery;
-        DATABASE_CHECK_AND_SET_ERROR()
-
-        query.bindValue(
-            QStringLiteral(":localUid"),
-            (localUid.isEmpty() ? nullValue : localUid));
-
-        query.bindValue(
-            QStringLiteral(":guid"),
-            (notebook.hasGuid() ? notebook.guid() : nullValue));
-
-        query.bindValue(
-            QStringLiteral(":linkedNotebookGuid"),
-            (notebook.hasLinkedNotebookGuid() ? notebook.linkedNotebookGuid()
-                                              : nullValue));
-
-        query.bindValue(
-            QStringLiteral(":updateSequenceNumber"),
-            (notebook.hasUpdateSequenceNumber()
-                 ? notebook.updateSequenceNumber()
-                 : nullValue));
-
-        query.bindValue(
-            QStringLiteral(":notebookName"),
-            (notebook.hasName() ? notebook.name() : nullValue));
-
-        query.bindValue(
-            QStringLiteral(":notebookNameUpper"),
-            (notebook.hasName() ? notebook.name().toUpper() : nullValue));
-
-        query.bindValue(
-            QStringLiteral(":creationTimestamp"),
-            (notebook.hasCreationTimestamp() ? notebook.creationTimestamp()
-                                             : nullValue));
+        "INSERT OR REPLACE INTO NotebookRestrictions"
+        "(localUid, noReadNotes, noCreateNotes, noUpdateNotes, "
+        "noExpungeNotes, noShareNotes, noEmailNotes, "
+        "noSendMessageToRecipients, noUpdateNotebook, "
+        "noExpungeNotebook, noSetDefaultNotebook, "
+        "noSetNotebookStack, noPublishToPublic, "
+        "noPublishToBusinessLibrary, noCreateTags, noUpdateTags, "
+        "noExpungeTags, noSetParentTag, noCreateSharedNotebooks, "
+        "updateWhichSharedNotebookRestrictions, "
+        "expungeWhichSharedNotebookRestrictions) "
+        "VALUES(:localUid, :noReadNotes, :noCreateNotes, "
+        ":noUpdateNotes, :noExpungeNotes, :noShareNotes, "
+        ":noEmailNotes, :noSendMessageToRecipients, "
+        ":noUpdateNotebook, :noExpungeNotebook, "
+        ":noSetDefaultNotebook, :noSetNotebookStack, "
+        ":noPublishToPublic, :noPublishToBusinessLibrary, "
+        ":noCreateTags, :noUpdateTags, :noExpungeTags, "
+        ":noSetParentTag, :noCreateSharedNotebooks, "
+        ":updateWhichSharedNotebookRestrictions, "
+        ":expungeWhichSharedNotebookRestrictions)");
 
-        query.bindValue(
-            QStringLiteral(":modificationTimestamp"),
-            (notebook.hasModificationTimestamp()
-                 ? notebook.modificationTimestamp()
-                 : nullValue));
+    bool res = m_insertOrReplaceNotebookRestrictionsQuery.prepare(queryString);
+    if (res) {
+        m_insertOrReplaceNotebookRestrictionsQueryPrepared = true;
+    }
 
-        query.bindValue(
-            QStringLiteral(":isDirty"), (notebook.isDirty() ? 1 : 0));
+    return res;
+}
 
-        query.bindValue(
-            QStringLiteral(":isLocal"), (notebook.isLocal() ? 1 : 0));
+bool LocalStorageManagerPrivate::
+    checkAndPrepareInsertOrReplaceSharedNotebookQuery()
+{
+    if (Q_LIKELY(m_insertOrReplaceSharedNotebookQueryPrepared)) {
+        return true;
+    }
 
-        query.bindValue(
-            QStringLiteral(":isDefault"),
-            (notebook.isDefaultNotebook() ? 1 : nullValue));
+    QNDEBUG(
+        "local_storage",
+        "Preparing SQL query to insert or replace shared "
+            << "notebook");
 
-        query.bindValue(
-            QStringLiteral(":isLastUsed"),
-            (notebook.isLastUsed() ? 1 : nullValue));
+    m_insertOrReplaceSharedNotebookQuery = QSqlQuery(m_sqlDatabase);
 
-        query.bindValue(
-            QStringLiteral(":isFavorited"), (notebook.isFavorited() ? 1 : 0));
+    QString queryString = QStringLiteral(
+        "INSERT OR REPLACE INTO SharedNotebooks"
+        "(sharedNotebookShareId, sharedNotebookUserId, "
+        "sharedNotebookNotebookGuid, sharedNotebookEmail, "
+        "sharedNotebookCreationTimestamp, "
+        "sharedNotebookModificationTimestamp, "
+        "sharedNotebookGlobalId, sharedNotebookUsername, "
+        "sharedNotebookPrivilegeLevel, "
+        "sharedNotebookRecipientReminderNotifyEmail, "
+        "sharedNotebookRecipientReminderNotifyInApp, "
+        "sharedNotebookSharerUserId, "
+        "sharedNotebookRecipientUsername, "
+        "sharedNotebookRecipientUserId, "
+        "sharedNotebookRecipientIdentityId, "
+        "sharedNotebookAssignmentTimestamp, indexInNotebook) "
+        "VALUES(:sharedNotebookShareId, :sharedNotebookUserId, "
+        ":sharedNotebookNotebookGuid, :sharedNotebookEmail, "
+        ":sharedNotebookCreationTimestamp, "
+        ":sharedNotebookModificationTimestamp, "
+        ":sharedNotebookGlobalId, :sharedNotebookUsername, "
+        ":sharedNotebookPrivilegeLevel, "
+        ":sharedNotebookRecipientReminderNotifyEmail, "
+        ":sharedNotebookRecipientReminderNotifyInApp, "
+        ":sharedNotebookSharerUserId, "
+        ":sharedNotebookRecipientUsername, "
+        ":sharedNotebookRecipientUserId, "
+        ":sharedNotebookRecipientIdentityId, "
+        ":sharedNotebookAssignmentTimestamp, :indexInNotebook) ");
 
-        query.bindValue(
-            QStringLiteral(":publishingUri"),
-            (notebook.hasPublishingUri() ? notebook.publishingUri()
-                                         : nullValue));
+    bool res = m_insertOrReplaceSharedNotebookQuery.prepare(queryString);
+    if (res) {
+        m_insertOrReplaceSharedNotebookQueryPrepared = true;
+    }
 
-        query.bindValue(
-            QStringLiteral(":publishingNoteSortOrder"),
-            (notebook.hasPublishingOrder() ? notebook.publishingOrder()
-                                           : nullValue));
+    return res;
+}
 
-        query.bindValue(
-            QStringLiteral(":publishingAscendingSort"),
-            (notebook.hasPublishingAscending()
-                 ? (notebook.isPublishingAscending() ? 1 : 0)
-                 : nullValue));
+bool LocalStorageManagerPrivate::insertOrReplaceLinkedNotebook(
+    const LinkedNotebook & linkedNotebook, ErrorString & errorDescription)
+{
+    // NOTE: this method expects to be called after the linked notebook
+    // is already checked for sanity ot its parameters
 
-        query.bindValue(
-            QStringLiteral(":publicDescription"),
-            (notebook.hasPublishingPublicDescription()
-                 ? notebook.publishingPublicDescription()
-                 : nullValue));
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't insert or replace linked notebook"));
 
-        query.bindValue(
-            QStringLiteral(":isPublished"),
-            (notebook.hasPublished() ? (notebook.isPublished() ? 1 : 0)
-                                     : nullValue));
+    bool res = checkAndPrepareInsertOrReplaceLinkedNotebookQuery();
+    QSqlQuery & query = m_insertOrReplaceLinkedNotebookQuery;
+    DATABASE_CHECK_AND_SET_ERROR()
 
-        query.bindValue(
-            QStringLiteral(":stack"),
-            (notebook.hasStack() ? notebook.stack() : nullValue));
+    QVariant nullValue;
 
-        query.bindValue(
-            QStringLiteral(":businessNotebookDescription"),
-            (notebook.hasBusinessNotebookDescription()
-                 ? notebook.businessNotebookDescription()
-                 : nullValue));
+    query.bindValue(
+        QStringLiteral(":guid"),
+        (linkedNotebook.hasGuid() ? linkedNotebook.guid() : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":businessNotebookPrivilegeLevel"),
-            (notebook.hasBusinessNotebookPrivilegeLevel()
-                 ? notebook.businessNotebookPrivilegeLevel()
-                 : nullValue));
+    query.bindValue(
+        QStringLiteral(":updateSequenceNumber"),
+        (linkedNotebook.hasUpdateSequenceNumber()
+             ? linkedNotebook.updateSequenceNumber()
+             : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":businessNotebookIsRecommended"),
-            (notebook.hasBusinessNotebookRecommended()
-                 ? (notebook.isBusinessNotebookRecommended() ? 1 : 0)
-                 : nullValue));
+    query.bindValue(
+        QStringLiteral(":shareName"),
+        (linkedNotebook.hasShareName() ? linkedNotebook.shareName()
+                                       : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":contactId"),
-            ((notebook.hasContact() && notebook.contact().hasId())
-                 ? notebook.contact().id()
-                 : nullValue));
+    query.bindValue(
+        QStringLiteral(":username"),
+        (linkedNotebook.hasUsername() ? linkedNotebook.username() : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":recipientReminderNotifyEmail"),
-            (notebook.hasRecipientReminderNotifyEmail()
-                 ? (notebook.recipientReminderNotifyEmail() ? 1 : 0)
-                 : nullValue));
+    query.bindValue(
+        QStringLiteral(":shardId"),
+        (linkedNotebook.hasShardId() ? linkedNotebook.shardId() : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":recipientReminderNotifyInApp"),
-            (notebook.hasRecipientReminderNotifyInApp()
-                 ? (notebook.recipientReminderNotifyInApp() ? 1 : 0)
-                 : nullValue));
+    query.bindValue(
+        QStringLiteral(":sharedNotebookGlobalId"),
+        (linkedNotebook.hasSharedNotebookGlobalId()
+             ? linkedNotebook.sharedNotebookGlobalId()
+             : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":recipientInMyList"),
-            (notebook.hasRecipientInMyList()
-                 ? (notebook.recipientInMyList() ? 1 : 0)
-                 : nullValue));
+    query.bindValue(
+        QStringLiteral(":uri"),
+        (linkedNotebook.hasUri() ? linkedNotebook.uri() : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":recipientStack"),
-            (notebook.hasRecipientStack() ? notebook.recipientStack()
+    query.bindValue(
+        QStringLiteral(":noteStoreUrl"),
+        (linkedNotebook.hasNoteStoreUrl() ? linkedNotebook.noteStoreUrl()
                                           : nullValue));
 
-        res = query.exec();
-        DATABASE_CHECK_AND_SET_ERROR()
-    }
+    query.bindValue(
+        QStringLiteral(":webApiUrlPrefix"),
+        (linkedNotebook.hasWebApiUrlPrefix() ? linkedNotebook.webApiUrlPrefix()
+                                             : nullValue));
 
-    if (notebook.hasRestrictions()) {
-        ErrorString error;
-        bool res = insertOrReplaceNotebookRestrictions(
-            localUid, notebook.restrictions(), error);
+    query.bindValue(
+        QStringLiteral(":stack"),
+        (linkedNotebook.hasStack() ? linkedNotebook.stack() : nullValue));
 
-        if (!res) {
-            errorDescription.base() = errorPrefix.base();
-            errorDescription.appendBase(error.base());
-            errorDescription.appendBase(error.additionalBases());
-            errorDescription.details() = error.details();
-            return res;
-        }
-    }
-    else {
-        QString queryString =
-            QString::fromUtf8(
-                "DELETE FROM NotebookRestrictions WHERE localUid='%1'")
-                .arg(localUid);
+    query.bindValue(
+        QStringLiteral(":businessId"),
+        (linkedNotebook.hasBusinessId() ? linkedNotebook.businessId()
+                                        : nullValue));
 
-        QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
-        DATABASE_CHECK_AND_SET_ERROR()
-    }
+    query.bindValue(
+        QStringLiteral(":isDirty"), (linkedNotebook.isDirty() ? 1 : 0));
 
-    if (notebook.hasGuid()) {
-        QString guid = sqlEscapeString(notebook.guid());
-        QString queryString = QString::fromUtf8(
-                                  "DELETE FROM SharedNotebooks WHERE "
-                                  "sharedNotebookNotebookGuid='%1'")
-                                  .arg(guid);
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
 
-        QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
-        DATABASE_CHECK_AND_SET_ERROR()
+    return true;
+}
 
-        auto sharedNotebooks = notebook.sharedNotebooks();
-        for (int i = 0, size = sharedNotebooks.size(); i < size; ++i) {
-            const SharedNotebook & sharedNotebook = sharedNotebooks[i];
-            if (!sharedNotebook.hasId()) {
-                QNWARNING(
-                    "local_storage",
-                    "Found shared notebook without "
-                        << "primary identifier of the share set, skipping it: "
-                        << sharedNotebook);
-                continue;
-            }
+bool LocalStorageManagerPrivate::checkAndPrepareGetLinkedNotebookCountQuery()
+    const
+{
+    if (Q_LIKELY(m_getLinkedNotebookCountQueryPrepared)) {
+        return true;
+    }
 
-            ErrorString error;
-            res = insertOrReplaceSharedNotebook(sharedNotebook, error);
-            if (!res) {
-                errorDescription.base() = errorPrefix.base();
-                errorDescription.appendBase(error.base());
-                errorDescription.appendBase(error.additionalBases());
-                errorDescription.details() = error.details();
-                return res;
-            }
-        }
+    QNDEBUG(
+        "local_storage",
+        "Preparing SQL query to get the count of linked "
+            << "notebooks");
+
+    m_getLinkedNotebookCountQuery = QSqlQuery(m_sqlDatabase);
+    QString queryString =
+        QStringLiteral("SELECT COUNT(*) FROM LinkedNotebooks");
+    bool res = m_getLinkedNotebookCountQuery.prepare(queryString);
+    if (res) {
+        m_getLinkedNotebookCountQueryPrepared = true;
     }
 
-    return transaction.commit(errorDescription);
+    return res;
 }
 
-bool LocalStorageManagerPrivate::checkAndPrepareNotebookCountQuery() const
+bool LocalStorageManagerPrivate::
+    checkAndPrepareInsertOrReplaceLinkedNotebookQuery()
 {
-    if (Q_LIKELY(m_getNotebookCountQueryPrepared)) {
+    if (Q_LIKELY(m_insertOrReplaceLinkedNotebookQueryPrepared)) {
         return true;
     }
 
     QNDEBUG(
         "local_storage",
-        "Preparing SQL query to get the count of "
-            << "notebooks");
+        "Preparing SQL query to insert or replace linked "
+            << "notebook");
 
-    m_getNotebookCountQuery = QSqlQuery(m_sqlDatabase);
-    QString queryString = QStringLiteral("SELECT COUNT(*) FROM Notebooks");
-    bool res = m_getNotebookCountQuery.prepare(queryString);
+    m_insertOrReplaceLinkedNotebookQuery = QSqlQuery(m_sqlDatabase);
+
+    QString queryString = QStringLiteral(
+        "INSERT OR REPLACE INTO LinkedNotebooks "
+        "(guid, updateSequenceNumber, shareName, "
+        "username, shardId, sharedNotebookGlobalId, "
+        "uri, noteStoreUrl, webApiUrlPrefix, stack, "
+        "businessId, isDirty) VALUES(:guid, "
+        ":updateSequenceNumber, :shareName, :username, "
+        ":shardId, :sharedNotebookGlobalId, :uri, "
+        ":noteStoreUrl, :webApiUrlPrefix, :stack, "
+        ":businessId, :isDirty)");
+
+    bool res = m_insertOrReplaceLinkedNotebookQuery.prepare(queryString);
     if (res) {
-        m_getNotebookCountQueryPrepared = true;
+        m_insertOrReplaceLinkedNotebookQueryPrepared = true;
     }
 
     return res;
 }
 
-bool LocalStorageManagerPrivate::checkAndPrepareInsertOrReplaceNotebookQuery()
+bool LocalStorageManagerPrivate::getNoteLocalUidFromResource(
+    const Resource & resource, QString & noteLocalUid,
+    ErrorString & errorDescription) const
 {
-    if (Q_LIKELY(m_insertOrReplaceNotebookQueryPrepared)) {
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::getNoteLocalUidFromResource: resource = "
+            << resource);
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't get note local uid for resource"));
+
+    noteLocalUid.resize(0);
+
+    if (resource.hasNoteLocalUid()) {
+        noteLocalUid = resource.noteLocalUid();
         return true;
     }
 
-    QNDEBUG(
+    QNTRACE(
         "local_storage",
-        "Preparing SQL query to insert or replace "
-            << "notebook");
+        "Resource doesn't have the note local uid, "
+            << "trying to deduce it from note-resource linkage");
 
-    m_insertOrReplaceNotebookQuery = QSqlQuery(m_sqlDatabase);
+    QString column, uid;
+    bool resourceHasGuid = resource.hasGuid();
+    if (resourceHasGuid) {
+        column = QStringLiteral("resource");
+        uid = resource.guid();
 
-    QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO Notebooks"
-        "(localUid, guid, linkedNotebookGuid, "
-        "updateSequenceNumber, notebookName, notebookNameUpper, "
-        "creationTimestamp, modificationTimestamp, isDirty, "
-        "isLocal, isDefault, isLastUsed, isFavorited, "
-        "publishingUri, publishingNoteSortOrder, "
-        "publishingAscendingSort, publicDescription, isPublished, "
-        "stack, businessNotebookDescription, "
-        "businessNotebookPrivilegeLevel, "
-        "businessNotebookIsRecommended, contactId, "
-        "recipientReminderNotifyEmail, recipientReminderNotifyInApp, "
-        "recipientInMyList, recipientStack) "
-        "VALUES(:localUid, :guid, :linkedNotebookGuid, "
-        ":updateSequenceNumber, :notebookName, :notebookNameUpper, "
-        ":creationTimestamp, :modificationTimestamp, :isDirty, "
-        ":isLocal, :isDefault, :isLastUsed, :isFavorited, "
-        ":publishingUri, :publishingNoteSortOrder, "
-        ":publishingAscendingSort, :publicDescription, "
-        ":isPublished, :stack, :businessNotebookDescription, "
-        ":businessNotebookPrivilegeLevel, "
-        ":businessNotebookIsRecommended, :contactId, "
-        ":recipientReminderNotifyEmail, "
-        ":recipientReminderNotifyInApp, :recipientInMyList, "
-        ":recipientStack)");
+        if (!checkGuid(uid)) {
+            errorDescription.base() = errorPrefix.base();
+            errorDescription.appendBase(
+                QT_TR_NOOP("resource's guid is invalid"));
+            errorDescription.details() = uid;
+            QNWARNING("local_storage", errorDescription);
+            return false;
+        }
+    }
+    else {
+        column = QStringLiteral("localResource");
+        uid = resource.localUid();
 
-    bool res = m_insertOrReplaceNotebookQuery.prepare(queryString);
-    if (res) {
-        m_insertOrReplaceNotebookQueryPrepared = true;
+        if (uid.isEmpty()) {
+            errorDescription.base() = errorPrefix.base();
+            errorDescription.appendBase(
+                QT_TR_NOOP("both resource's local uid and guid are empty"));
+            QNWARNING("local_storage", errorDescription);
+            return false;
+        }
     }
 
-    return res;
+    uid = sqlEscapeString(uid);
+
+    QString queryString =
+        QString::fromUtf8("SELECT localNote FROM NoteResources WHERE %1='%2'")
+            .arg(column, uid);
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.next();
+    if (!res) {
+        SET_NO_DATA_FOUND();
+        return false;
+    }
+
+    noteLocalUid = query.record().value(QStringLiteral("localNote")).toString();
+    return true;
 }
 
-bool LocalStorageManagerPrivate::
-    checkAndPrepareInsertOrReplaceNotebookRestrictionsQuery()
+bool LocalStorageManagerPrivate::getNotebookLocalUidFromNote(
+    const Note & note, QString & notebookLocalUid,
+    ErrorString & errorDescription) const
 {
-    if (Q_LIKELY(m_insertOrReplaceNotebookRestrictionsQueryPrepared)) {
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::getNotebookLocalUidFromNote: "
+            << "note local uid = " << note.localUid() << ", note guid = "
+            << (note.hasGuid() ? note.guid() : QStringLiteral("<null>")));
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't get notebook local uid for note"));
+
+    notebookLocalUid.resize(0);
+
+    if (note.hasNotebookLocalUid()) {
+        notebookLocalUid = note.notebookLocalUid();
+        QNTRACE(
+            "local_storage",
+            "Notebook local uid taken from note: " << notebookLocalUid);
         return true;
     }
 
-    QNDEBUG(
+    QNTRACE(
         "local_storage",
-        "Preparing SQL query to insert or replace "
-            << "notebook restrictions");
+        "Note doesn't have the notebook local uid, "
+            << "trying to deduce it from guid");
 
-    m_insertOrReplaceNotebookRestrictionsQuery = QSqlQuery(m_sqlDatabase);
+    if (note.hasNotebookGuid()) {
+        QString notebookGuid = sqlEscapeString(note.notebookGuid());
+        QString queryString =
+            QString::fromUtf8(
+                "SELECT localUid FROM Notebooks WHERE guid = '%1'")
+                .arg(notebookGuid);
 
-    QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO NotebookRestrictions"
-        "(localUid, noReadNotes, noCreateNotes, noUpdateNotes, "
-        "noExpungeNotes, noShareNotes, noEmailNotes, "
-        "noSendMessageToRecipients, noUpdateNotebook, "
-        "noExpungeNotebook, noSetDefaultNotebook, "
-        "noSetNotebookStack, noPublishToPublic, "
-        "noPublishToBusinessLibrary, noCreateTags, noUpdateTags, "
-        "noExpungeTags, noSetParentTag, noCreateSharedNotebooks, "
-        "updateWhichSharedNotebookRestrictions, "
-        "expungeWhichSharedNotebookRestrictions) "
-        "VALUES(:localUid, :noReadNotes, :noCreateNotes, "
-        ":noUpdateNotes, :noExpungeNotes, :noShareNotes, "
-        ":noEmailNotes, :noSendMessageToRecipients, "
-        ":noUpdateNotebook, :noExpungeNotebook, "
-        ":noSetDefaultNotebook, :noSetNotebookStack, "
-        ":noPublishToPublic, :noPublishToBusinessLibrary, "
-        ":noCreateTags, :noUpdateTags, :noExpungeTags, "
-        ":noSetParentTag, :noCreateSharedNotebooks, "
-        ":updateWhichSharedNotebookRestrictions, "
-        ":expungeWhichSharedNotebookRestrictions)");
+        QSqlQuery query(m_sqlDatabase);
+        bool res = execQuery(query, queryString);
+        DATABASE_CHECK_AND_SET_ERROR()
 
-    bool res = m_insertOrReplaceNotebookRestrictionsQuery.prepare(queryString);
-    if (res) {
-        m_insertOrReplaceNotebookRestrictionsQueryPrepared = true;
+        res = query.next();
+        if (!res) {
+            SET_NO_DATA_FOUND();
+            return false;
+        }
+
+        notebookLocalUid =
+            query.record().value(QStringLiteral("localUid")).toString();
+
+        QNTRACE(
+            "local_storage",
+            "Notebook local uid deduced from notebook's "
+                << "guid " << notebookGuid << ": " << notebookLocalUid);
+    }
+    else {
+        QString column, uid;
+        if (note.hasGuid()) {
+            column = QStringLiteral("guid");
+            uid = note.guid();
+        }
+        else {
+            column = QStringLiteral("localUid");
+            uid = note.localUid();
+        }
+
+        uid = sqlEscapeString(uid);
+
+        QString queryString =
+            QString::fromUtf8(
+                "SELECT notebookLocalUid FROM Notes WHERE %1='%2'")
+                .arg(column, uid);
+
+        QSqlQuery query(m_sqlDatabase);
+        bool res = execQuery(query, queryString);
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        res = query.next();
+        if (!res) {
+            SET_NO_DATA_FOUND();
+            return false;
+        }
+
+        notebookLocalUid =
+            query.record().value(QStringLiteral("notebookLocalUid")).toString();
+
+        QNTRACE(
+            "local_storage",
+            "Notebook local uid deduced from note's "
+                << column << " " << uid << ": " << notebookLocalUid);
+    }
+
+    if (notebookLocalUid.isEmpty()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("found notebook local uid is empty"));
+        QNDEBUG("local_storage", errorDescription << ", note: " << note);
+        return false;
     }
 
-    return res;
-}
+    return true;
+}
+
+bool LocalStorageManagerPrivate::getNotebookGuidForNote(
+    const Note & note, QString & notebookGuid,
+    ErrorString & errorDescription) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::getNotebookGuidForNote: "
+            << "note local uid = " << note.localUid() << ", note guid = "
+            << (note.hasGuid() ? note.guid() : QStringLiteral("<null>")));
+
+    ErrorString errorPrefix(QT_TR_NOOP("can't get notebook guid for note"));
+
+    notebookGuid.resize(0);
 
-bool LocalStorageManagerPrivate::
-    checkAndPrepareInsertOrReplaceSharedNotebookQuery()
-{
-    if (Q_LIKELY(m_insertOrReplaceSharedNotebookQueryPrepared)) {
+    if (note.hasNotebookGuid()) {
+        notebookGuid = note.notebookGuid();
         return true;
     }
 
-    QNDEBUG(
+    QNTRACE(
         "local_storage",
-        "Preparing SQL query to insert or replace shared "
-            << "notebook");
+        "Note doesn't have the notebook guid, trying to "
+            << "deduce it from notebook local uid");
 
-    m_insertOrReplaceSharedNotebookQuery = QSqlQuery(m_sqlDatabase);
+    if (!note.hasNotebookLocalUid()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(QT_TR_NOOP(
+            "note has neither notebook local uid nor notebook guid"));
+        QNDEBUG("local_storage", errorDescription << ", note: " << note);
+        return false;
+    }
 
-    QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO SharedNotebooks"
-        "(sharedNotebookShareId, sharedNotebookUserId, "
-        "sharedNotebookNotebookGuid, sharedNotebookEmail, "
-        "sharedNotebookCreationTimestamp, "
-        "sharedNotebookModificationTimestamp, "
-        "sharedNotebookGlobalId, sharedNotebookUsername, "
-        "sharedNotebookPrivilegeLevel, "
-        "sharedNotebookRecipientReminderNotifyEmail, "
-        "sharedNotebookRecipientReminderNotifyInApp, "
-        "sharedNotebookSharerUserId, "
-        "sharedNotebookRecipientUsername, "
-        "sharedNotebookRecipientUserId, "
-        "sharedNotebookRecipientIdentityId, "
-        "sharedNotebookAssignmentTimestamp, indexInNotebook) "
-        "VALUES(:sharedNotebookShareId, :sharedNotebookUserId, "
-        ":sharedNotebookNotebookGuid, :sharedNotebookEmail, "
-        ":sharedNotebookCreationTimestamp, "
-        ":sharedNotebookModificationTimestamp, "
-        ":sharedNotebookGlobalId, :sharedNotebookUsername, "
-        ":sharedNotebookPrivilegeLevel, "
-        ":sharedNotebookRecipientReminderNotifyEmail, "
-        ":sharedNotebookRecipientReminderNotifyInApp, "
-        ":sharedNotebookSharerUserId, "
-        ":sharedNotebookRecipientUsername, "
-        ":sharedNotebookRecipientUserId, "
-        ":sharedNotebookRecipientIdentityId, "
-        ":sharedNotebookAssignmentTimestamp, :indexInNotebook) ");
+    QString notebookLocalUid = note.notebookLocalUid();
+    notebookLocalUid = sqlEscapeString(notebookLocalUid);
 
-    bool res = m_insertOrReplaceSharedNotebookQuery.prepare(queryString);
-    if (res) {
-        m_insertOrReplaceSharedNotebookQueryPrepared = true;
+    QString queryString =
+        QString::fromUtf8("SELECT guid FROM Notebooks where localUid = '%1'")
+            .arg(notebookLocalUid);
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.next();
+    if (!res) {
+        SET_NO_DATA_FOUND();
+        return false;
     }
 
-    return res;
+    notebookGuid = query.record().value(QStringLiteral("guid")).toString();
+
+    QNTRACE(
+        "local_storage",
+        "Found notebook guid corresponding to local uid "
+            << notebookLocalUid << ": " << notebookGuid);
+    return true;
 }
 
-bool LocalStorageManagerPrivate::insertOrReplaceLinkedNotebook(
-    const LinkedNotebook & linkedNotebook, ErrorString & errorDescription)
+bool LocalStorageManagerPrivate::getNotebookLocalUidForGuid(
+    const QString & notebookGuid, QString & notebookLocalUid,
+    ErrorString & errorDescription) const
 {
-    // NOTE: this method expects to be called after the linked notebook
-    // is already checked for sanity ot its parameters
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::getNotebookLocalUidForGuid: "
+            << "notebook guid = " << notebookGuid);
+
+    if (m_guidLocalUidIndex.localUidForGuid(
+            GuidLocalUidIndex::ObjectType::Notebook, notebookGuid,
+            notebookLocalUid))
+    {
+        return true;
+    }
 
     ErrorString errorPrefix(
-        QT_TR_NOOP("can't insert or replace linked notebook"));
+        QT_TR_NOOP("can't get notebook local uid for guid"));
 
-    bool res = checkAndPrepareInsertOrReplaceLinkedNotebookQuery();
-    QSqlQuery & query = m_insertOrReplaceLinkedNotebookQuery;
+    QString queryString =
+        QString::fromUtf8("SELECT localUid FROM Notebooks WHERE guid = '%1'")
+            .arg(sqlEscapeString(notebookGuid));
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
-    QVariant nullValue;
+    if (query.next()) {
+        notebookLocalUid =
+            query.record().value(QStringLiteral("localUid")).toString();
+    }
 
-    query.bindValue(
-        QStringLiteral(":guid"),
-        (linkedNotebook.hasGuid() ? linkedNotebook.guid() : nullValue));
+    if (notebookLocalUid.isEmpty()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("no existing local uid corresponding to notebook's guid "
+                       "was found"));
+        errorDescription.details() = notebookGuid;
+        QNDEBUG("local_storage", errorDescription);
+        return false;
+    }
 
-    query.bindValue(
-        QStringLiteral(":updateSequenceNumber"),
-        (linkedNotebook.hasUpdateSequenceNumber()
-             ? linkedNotebook.updateSequenceNumber()
-             : nullValue));
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::Notebook, notebookGuid,
+        notebookLocalUid);
 
-    query.bindValue(
-        QStringLiteral(":shareName"),
-        (linkedNotebook.hasShareName() ? linkedNotebook.shareName()
-                                       : nullValue));
+    return true;
+}
 
-    query.bindValue(
-        QStringLiteral(":username"),
-        (linkedNotebook.hasUsername() ? linkedNotebook.username() : nullValue));
+bool LocalStorageManagerPrivate::getNoteLocalUidForGuid(
+    const QString & noteGuid, QString & noteLocalUid,
+    ErrorString & errorDescription) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::getNoteLocalUidForGuid: note guid = "
+            << noteGuid);
 
-    query.bindValue(
-        QStringLiteral(":shardId"),
-        (linkedNotebook.hasShardId() ? linkedNotebook.shardId() : nullValue));
+    if (m_guidLocalUidIndex.localUidForGuid(
+            GuidLocalUidIndex::ObjectType::Note, noteGuid, noteLocalUid))
+    {
+        return true;
+    }
 
-    query.bindValue(
-        QStringLiteral(":sharedNotebookGlobalId"),
-        (linkedNotebook.hasSharedNotebookGlobalId()
-             ? linkedNotebook.sharedNotebookGlobalId()
-             : nullValue));
+    ErrorString errorPrefix(QT_TR_NOOP("can't get note local uid for guid"));
 
-    query.bindValue(
-        QStringLiteral(":uri"),
-        (linkedNotebook.hasUri() ? linkedNotebook.uri() : nullValue));
+    QString queryString =
+        QString::fromUtf8("SELECT localUid FROM Notes WHERE guid='%1'")
+            .arg(sqlEscapeString(noteGuid));
 
-    query.bindValue(
-        QStringLiteral(":noteStoreUrl"),
-        (linkedNotebook.hasNoteStoreUrl() ? linkedNotebook.noteStoreUrl()
-                                          : nullValue));
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    query.bindValue(
-        QStringLiteral(":webApiUrlPrefix"),
-        (linkedNotebook.hasWebApiUrlPrefix() ? linkedNotebook.webApiUrlPrefix()
-                                             : nullValue));
+    if (query.next()) {
+        noteLocalUid =
+            query.record().value(QStringLiteral("localUid")).toString();
+    }
 
-    query.bindValue(
-        QStringLiteral(":stack"),
-        (linkedNotebook.hasStack() ? linkedNotebook.stack() : nullValue));
+    if (noteLocalUid.isEmpty()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("no existing local uid corresponding to note's guid was "
+                       "found"));
+        errorDescription.details() = noteGuid;
+        QNDEBUG("local_storage", errorDescription);
+        return false;
+    }
 
-    query.bindValue(
-        QStringLiteral(":businessId"),
-        (linkedNotebook.hasBusinessId() ? linkedNotebook.businessId()
-                                        : nullValue));
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::Note, noteGuid, noteLocalUid);
 
-    query.bindValue(
-        QStringLiteral(":isDirty"), (linkedNotebook.isDirty() ? 1 : 0));
+    return true;
+}
+
+bool LocalStorageManagerPrivate::getNoteGuidForLocalUid(
+    const QString & noteLocalUid, QString & noteGuid,
+    ErrorString & errorDescription) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::getNoteGuidForLocalUid: note local "
+            << "uid = " << noteLocalUid);
+
+    if (m_guidLocalUidIndex.guidForLocalUid(
+            GuidLocalUidIndex::ObjectType::Note, noteLocalUid, noteGuid))
+    {
+        return true;
+    }
+
+    ErrorString errorPrefix(QT_TR_NOOP("can't get note guid for local uid"));
+
+    QString queryString =
+        QString::fromUtf8("SELECT guid FROM Notes WHERE localUid='%1'")
+            .arg(sqlEscapeString(noteLocalUid));
 
-    res = query.exec();
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
+    if (query.next()) {
+        noteGuid = query.record().value(QStringLiteral("guid")).toString();
+        if (!noteGuid.isEmpty()) {
+            m_guidLocalUidIndex.insert(
+                GuidLocalUidIndex::ObjectType::Note, noteGuid, noteLocalUid);
+        }
+    }
+
     return true;
 }
 
-bool LocalStorageManagerPrivate::checkAndPrepareGetLinkedNotebookCountQuery()
-    const
+bool LocalStorageManagerPrivate::getTagLocalUidForGuid(
+    const QString & tagGuid, QString & tagLocalUid,
+    ErrorString & errorDescription) const
 {
-    if (Q_LIKELY(m_getLinkedNotebookCountQueryPrepared)) {
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::getTagLocalUidForGuid: tag guid = "
+            << tagGuid);
+
+    if (m_guidLocalUidIndex.localUidForGuid(
+            GuidLocalUidIndex::ObjectType::Tag, tagGuid, tagLocalUid))
+    {
         return true;
     }
 
-    QNDEBUG(
-        "local_storage",
-        "Preparing SQL query to get the count of linked "
-            << "notebooks");
+    ErrorString errorPrefix(QT_TR_NOOP("can't get tag local uid for guid"));
 
-    m_getLinkedNotebookCountQuery = QSqlQuery(m_sqlDatabase);
     QString queryString =
-        QStringLiteral("SELECT COUNT(*) FROM LinkedNotebooks");
-    bool res = m_getLinkedNotebookCountQuery.prepare(queryString);
-    if (res) {
-        m_getLinkedNotebookCountQueryPrepared = true;
+        QString::fromUtf8("SELECT localUid FROM Tags WHERE guid = '%1'")
+            .arg(sqlEscapeString(tagGuid));
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    if (query.next()) {
+        tagLocalUid =
+            query.record().value(QStringLiteral("localUid")).toString();
+    }
+
+    if (tagLocalUid.isEmpty()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("no existing local uid corresponding to tag's guid was "
+                       "found"));
+        errorDescription.details() = tagGuid;
+        QNDEBUG("local_storage", errorDescription);
+        return false;
     }
 
-    return res;
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::Tag, tagGuid, tagLocalUid);
+
+    return true;
 }
 
-bool LocalStorageManagerPrivate::
-    checkAndPrepareInsertOrReplaceLinkedNotebookQuery()
+bool LocalStorageManagerPrivate::getResourceLocalUidForGuid(
+    const QString & resourceGuid, QString & resourceLocalUid,
+    ErrorString & errorDescription) const
 {
-    if (Q_LIKELY(m_insertOrReplaceLinkedNotebookQueryPrepared)) {
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::getResourceLocalUidForGuid: "
+            << "resource guid = " << resourceGuid);
+
+    if (m_guidLocalUidIndex.localUidForGuid(
+            GuidLocalUidIndex::ObjectType::Resource, resourceGuid,
+            resourceLocalUid))
+    {
         return true;
     }
 
-    QNDEBUG(
-        "local_storage",
-        "Preparing SQL query to insert or replace linked "
-            << "notebook");
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't get resource local uid for guid"));
 
-    m_insertOrReplaceLinkedNotebookQuery = QSqlQuery(m_sqlDatabase);
+    QString queryString =
+        QString::fromUtf8(
+            "SELECT resourceLocalUid FROM Resources WHERE resourceGuid = '%1'")
+            .arg(sqlEscapeString(resourceGuid));
 
-    QString queryString = QStringLiteral(
-        "INSERT OR REPLACE INTO LinkedNotebooks "
-        "(guid, updateSequenceNumber, shareName, "
-        "username, shardId, sharedNotebookGlobalId, "
-        "uri, noteStoreUrl, webApiUrlPrefix, stack, "
-        "businessId, isDirty) VALUES(:guid, "
-        ":updateSequenceNumber, :shareName, :username, "
-        ":shardId, :sharedNotebookGlobalId, :uri, "
-        ":noteStoreUrl, :webApiUrlPrefix, :stack, "
-        ":businessId, :isDirty)");
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    bool res = m_insertOrReplaceLinkedNotebookQuery.prepare(queryString);
-    if (res) {
-        m_insertOrReplaceLinkedNotebookQueryPrepared = true;
+    if (query.next()) {
+        resourceLocalUid =
+            query.record().value(QStringLiteral("resourceLocalUid")).toString();
     }
 
-    return res;
+    if (resourceLocalUid.isEmpty()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("no existing local uid corresponding to resource's "
+                       "guid was found"));
+        errorDescription.details() = resourceGuid;
+        QNDEBUG("local_storage", errorDescription);
+        return false;
+    }
+
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::Resource, resourceGuid,
+        resourceLocalUid);
+
+    return true;
 }
 
-bool LocalStorageManagerPrivate::getNoteLocalUidFromResource(
-    const Resource & resource, QString & noteLocalUid,
+bool LocalStorageManagerPrivate::getSavedSearchLocalUidForGuid(
+    const QString & savedSearchGuid, QString & savedSearchLocalUid,
     ErrorString & errorDescription) const
 {
     QNDEBUG(
         "local_storage",
-        "LocalStorageManagerPrivate::getNoteLocalUidFromResource: resource = "
-            << resource);
-
-    ErrorString errorPrefix(
-        QT_TR_NOOP("can't get note local uid for resource"));
-
-    noteLocalUid.resize(0);
+        "LocalStorageManagerPrivate::getSavedSearchLocalUidForGuid: "
+            << "saved search guid = " << savedSearchGuid);
 
-    if (resource.hasNoteLocalUid()) {
-        noteLocalUid = resource.noteLocalUid();
+    if (m_guidLocalUidIndex.localUidForGuid(
+            GuidLocalUidIndex::ObjectType::SavedSearch, savedSearchGuid,
+            savedSearchLocalUid))
+    {
         return true;
     }
 
-    QNTRACE(
-        "local_storage",
-        "Resource doesn't have the note local uid, "
-            << "trying to deduce it from note-resource linkage");
-
-    QString column, uid;
-    bool resourceHasGuid = resource.hasGuid();
-    if (resourceHasGuid) {
-        column = QStringLiteral("resource");
-        uid = resource.guid();
-
-        if (!checkGuid(uid)) {
-            errorDescription.base() = errorPrefix.base();
-            errorDescription.appendBase(
-                QT_TR_NOOP("resource's guid is invalid"));
-            errorDescription.details() = uid;
-            QNWARNING("local_storage", errorDescription);
-            return false;
-        }
-    }
-    else {
-        column = QStringLiteral("localResource");
-        uid = resource.localUid();
-
-        if (uid.isEmpty()) {
-            errorDescription.base() = errorPrefix.base();
-            errorDescription.appendBase(
-                QT_TR_NOOP("both resource's local uid and guid are empty"));
-            QNWARNING("local_storage", errorDescription);
-            return false;
-        }
-    }
-
-    uid = sqlEscapeString(uid);
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't get saved search local uid for guid"));
 
     QString queryString =
-        QString::fromUtf8("SELECT localNote FROM NoteResources WHERE %1='%2'")
-            .arg(column, uid);
+        QString::fromUtf8(
+            "SELECT localUid FROM SavedSearches WHERE guid = '%1'")
+            .arg(sqlEscapeString(savedSearchGuid));
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
-    res = query.next();
-    if (!res) {
-        SET_NO_DATA_FOUND();
+    if (query.next()) {
+        savedSearchLocalUid =
+            query.record().value(QStringLiteral("localUid")).toString();
+    }
+
+    if (savedSearchLocalUid.isEmpty()) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(
+            QT_TR_NOOP("no existing local uid corresponding "
+                       "to saved search's guid was found"));
+        errorDescription.details() = savedSearchGuid;
+        QNDEBUG("local_storage", errorDescription);
         return false;
     }
 
-    noteLocalUid = query.record().value(QStringLiteral("localNote")).toString();
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::SavedSearch, savedSearchGuid,
+        savedSearchLocalUid);
+
     return true;
 }
 
-bool LocalStorageManagerPrivate::getNotebookLocalUidFromNote(
-    const Note & note, QString & notebookLocalUid,
-    ErrorString & errorDescription) const
+bool LocalStorageManagerPrivate::insertOrReplaceNote(
+    Note & note, const UpdateNoteOptions options,
+    ErrorString & errorDescription)
 {
     QNDEBUG(
         "local_storage",
-        "LocalStorageManagerPrivate::getNotebookLocalUidFromNote: "
-            << "note local uid = " << note.localUid() << ", note guid = "
-            << (note.hasGuid() ? note.guid() : QStringLiteral("<null>")));
-
-    ErrorString errorPrefix(
-        QT_TR_NOOP("can't get notebook local uid for note"));
-
-    notebookLocalUid.resize(0);
+        "LocalStorageManagerPrivate::insertOrReplaceNote: update tags = "
+            << ((options & UpdateNoteOption::UpdateTags) ? "true" : "false")
+            << ", update resource metadata = "
+            << ((options & UpdateNoteOption::UpdateResourceMetadata) ? "true"
+                                                                     : "false")
+            << ", update resource binary data = "
+            << ((options & UpdateNoteOption::UpdateResourceBinaryData)
+                    ? "true"
+                    : "false")
+            << ", note local uid = " << note.localUid());
 
-    if (note.hasNotebookLocalUid()) {
-        notebookLocalUid = note.notebookLocalUid();
-        QNTRACE(
-            "local_storage",
-            "Notebook local uid taken from note: " << notebookLocalUid);
-        return true;
-    }
+    QNTRACE("local_storage", note);
 
-    QNTRACE(
-        "local_storage",
-        "Note doesn't have the notebook local uid, "
-            << "trying to deduce it from guid");
+    // NOTE: this method expects to be called after the note is already checked
+    // for sanity of its parameters!
 
-    if (note.hasNotebookGuid()) {
-        QString notebookGuid = sqlEscapeString(note.notebookGuid());
-        QString queryString =
-            QString::fromUtf8(
-                "SELECT localUid FROM Notebooks WHERE guid = '%1'")
-                .arg(notebookGuid);
+    ErrorString errorPrefix(QT_TR_NOOP("can't insert or replace note"));
 
-        QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
-        DATABASE_CHECK_AND_SET_ERROR()
+    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Exclusive);
 
-        res = query.next();
-        if (!res) {
-            SET_NO_DATA_FOUND();
-            return false;
-        }
+    QVariant nullValue;
+    QString localUid = sqlEscapeString(note.localUid());
 
-        notebookLocalUid =
-            query.record().value(QStringLiteral("localUid")).toString();
+    QString notebookLocalUid =
+        (note.hasNotebookLocalUid() ? sqlEscapeString(note.notebookLocalUid())
+                                    : QString());
 
-        QNTRACE(
-            "local_storage",
-            "Notebook local uid deduced from notebook's "
-                << "guid " << notebookGuid << ": " << notebookLocalUid);
+    // If the state of the note as it was last read from or written to
+    // the local storage is known, only the parts of the note modified since
+    // then need to be written
+    NoteLocalStorageSnapshot snapshot;
+    const Note * pSnapshot = nullptr;
+    const auto * pCachedSnapshot =
+        m_noteLocalStorageSnapshots.get(note.localUid());
+    if (pCachedSnapshot &&
+        pCachedSnapshot->m_note.qevercloudNote().guid.isEqual(
+            note.qevercloudNote().guid))
+    {
+        // The cached snapshot might be removed from the cache while the note
+        // is being written
+        snapshot = *pCachedSnapshot;
+        pSnapshot = &snapshot.m_note;
     }
-    else {
-        QString column, uid;
-        if (note.hasGuid()) {
-            column = QStringLiteral("guid");
-            uid = note.guid();
-        }
-        else {
-            column = QStringLiteral("localUid");
-            uid = note.localUid();
-        }
-
-        uid = sqlEscapeString(uid);
 
-        QString queryString =
-            QString::fromUtf8(
-                "SELECT notebookLocalUid FROM Notes WHERE %1='%2'")
-                .arg(column, uid);
+    if (pSnapshot) {
+        // Only the modified columns are updated so the triggers depending on
+        // the other columns, including those maintaining the full text search
+        // index, don't fire
+        bool snapshotMatches = false;
+        bool res = updateModifiedNoteColumns(
+            note, *pSnapshot, localUid, notebookLocalUid, snapshotMatches,
+            errorDescription);
 
-        QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
-        DATABASE_CHECK_AND_SET_ERROR()
-
-        res = query.next();
         if (!res) {
-            SET_NO_DATA_FOUND();
             return false;
         }
 
-        notebookLocalUid =
-            query.record().value(QStringLiteral("notebookLocalUid")).toString();
-
-        QNTRACE(
-            "local_storage",
-            "Notebook local uid deduced from note's "
-                << column << " " << uid << ": " << notebookLocalUid);
-    }
-
-    if (notebookLocalUid.isEmpty()) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(
-            QT_TR_NOOP("found notebook local uid is empty"));
-        QNDEBUG("local_storage", errorDescription << ", note: " << note);
-        return false;
+        if (!snapshotMatches) {
+            QNDEBUG(
+                "local_storage",
+                "Note in the local storage doesn't match its snapshot, "
+                    << "writing the whole note");
+            pSnapshot = nullptr;
+            Q_UNUSED(m_noteLocalStorageSnapshots.remove(note.localUid()))
+        }
     }
 
-    return true;
-}
-
-bool LocalStorageManagerPrivate::getNotebookGuidForNote(
-    const Note & note, QString & notebookGuid,
-    ErrorString & errorDescription) const
-{
     QNDEBUG(
         "local_storage",
-        "LocalStorageManagerPrivate::getNotebookGuidForNote: "
-            << "note local uid = " << note.localUid() << ", note guid = "
-            << (note.hasGuid() ? note.guid() : QStringLiteral("<null>")));
+        "Writing only modified parts of the note = "
+            << (pSnapshot ? "true" : "false"));
 
-    ErrorString errorPrefix(QT_TR_NOOP("can't get notebook guid for note"));
+    // Special logic needs to be applied if guid is being cleared from the
+    // note; here the evaluation occurs whether guid clearance is meant to take
+    // place
+    bool noteGuidIsBeingCleared = false;
+    if (!pSnapshot && !note.hasGuid()) {
+        QString noteGuid;
 
-    notebookGuid.resize(0);
+        bool res =
+            getNoteGuidForLocalUid(note.localUid(), noteGuid, errorDescription);
+
+        if (!res) {
+            return false;
+        }
 
-    if (note.hasNotebookGuid()) {
-        notebookGuid = note.notebookGuid();
-        return true;
+        noteGuidIsBeingCleared = !noteGuid.isEmpty();
     }
 
-    QNTRACE(
+    QNDEBUG(
         "local_storage",
-        "Note doesn't have the notebook guid, trying to "
-            << "deduce it from notebook local uid");
+        "Note guid is being cleared = "
+            << (noteGuidIsBeingCleared ? "true" : "false"));
 
-    if (!note.hasNotebookLocalUid()) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(QT_TR_NOOP(
-            "note has neither notebook local uid nor notebook guid"));
-        QNDEBUG("local_storage", errorDescription << ", note: " << note);
-        return false;
-    }
+    if (noteGuidIsBeingCleared) {
+        if (note.hasResources() &&
+            (options & UpdateNoteOption::UpdateResourceMetadata)) {
+            QList<Resource> resources = note.resources();
+            for (const auto & resource: qAsConst(resources)) {
+                if (Q_UNLIKELY(resource.hasNoteGuid())) {
+                    errorDescription = errorPrefix;
+                    errorDescription.appendBase(
+                        QT_TR_NOOP("note's guid is being cleared but one of "
+                                   "note's resources has non-empty note guid"));
+                    if (resource.hasResourceAttributes() &&
+                        resource.resourceAttributes().fileName.isSet())
+                    {
+                        errorDescription.details() =
+                            resource.resourceAttributes().fileName.ref();
+                    }
 
-    QString notebookLocalUid = note.notebookLocalUid();
-    notebookLocalUid = sqlEscapeString(notebookLocalUid);
+                    QNWARNING("local_storage", errorDescription);
+                    return false;
+                }
 
-    QString queryString =
-        QString::fromUtf8("SELECT guid FROM Notebooks where localUid = '%1'")
-            .arg(notebookLocalUid);
+                if (Q_UNLIKELY(resource.hasGuid())) {
+                    errorDescription = errorPrefix;
+                    errorDescription.appendBase(
+                        QT_TR_NOOP("note's guid is being cleared but one of "
+                                   "note's resources has non-empty guid"));
+                    if (resource.hasResourceAttributes() &&
+                        resource.resourceAttributes().fileName.isSet())
+                    {
+                        errorDescription.details() =
+                            resource.resourceAttributes().fileName.ref();
+                    }
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+                    QNWARNING("local_storage", errorDescription);
+                    return false;
+                }
+            }
+        }
 
-    res = query.next();
-    if (!res) {
-        SET_NO_DATA_FOUND();
-        return false;
+        QString queryString =
+            QString::fromUtf8(
+                "UPDATE Notes SET guid = NULL WHERE localUid='%1'")
+                .arg(localUid);
+
+        QSqlQuery query(m_sqlDatabase);
+        bool res = execQuery(query, queryString);
+        DATABASE_CHECK_AND_SET_ERROR()
     }
 
-    notebookGuid = query.record().value(QStringLiteral("guid")).toString();
+    // Update common table with Note properties
+    if (!pSnapshot) {
+        bool res = checkAndPrepareInsertOrReplaceNoteQuery();
+        QSqlQuery & query = m_insertOrReplaceNoteQuery;
+        DATABASE_CHECK_AND_SET_ERROR()
 
-    QNTRACE(
-        "local_storage",
-        "Found notebook guid corresponding to local uid "
-            << notebookLocalUid << ": " << notebookGuid);
-    return true;
-}
+        QList<std::pair<QString, QVariant>> columnValues;
+        res = noteColumnValues(
+            note, nullptr, localUid, notebookLocalUid, columnValues,
+            errorDescription);
 
-bool LocalStorageManagerPrivate::getNotebookLocalUidForGuid(
-    const QString & notebookGuid, QString & notebookLocalUid,
-    ErrorString & errorDescription) const
-{
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::getNotebookLocalUidForGuid: "
-            << "notebook guid = " << notebookGuid);
+        if (!res) {
+            return false;
+        }
 
-    ErrorString errorPrefix(
-        QT_TR_NOOP("can't get notebook local uid for guid"));
+        for (const auto & columnValue: qAsConst(columnValues)) {
+            query.bindValue(
+                QStringLiteral(":") + columnValue.first, columnValue.second);
+        }
 
-    QString queryString =
-        QString::fromUtf8("SELECT localUid FROM Notebooks WHERE guid = '%1'")
-            .arg(sqlEscapeString(notebookGuid));
+        res = execQuery(query);
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+    if (!pSnapshot ||
+        !note.qevercloudNote().restrictions.isEqual(
+            pSnapshot->qevercloudNote().restrictions))
+    {
+        if (note.hasNoteRestrictions()) {
+            const auto & restrictions = note.noteRestrictions();
+            bool res = insertOrReplaceNoteRestrictions(
+                localUid, restrictions, errorDescription);
+            if (!res) {
+                QNWARNING("local_storage", "Note: " << note);
+                return false;
+            }
+        }
+        else {
+            QString queryString =
+                QString::fromUtf8(
+                    "DELETE FROM NoteRestrictions WHERE noteLocalUid='%1'")
+                    .arg(localUid);
 
-    if (query.next()) {
-        notebookLocalUid =
-            query.record().value(QStringLiteral("localUid")).toString();
+            QSqlQuery query(m_sqlDatabase);
+            bool res = execQuery(query, queryString);
+            DATABASE_CHECK_AND_SET_ERROR()
+        }
     }
 
-    if (notebookLocalUid.isEmpty()) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(
-            QT_TR_NOOP("no existing local uid corresponding to notebook's guid "
-                       "was found"));
-        errorDescription.details() = notebookGuid;
-        QNDEBUG("local_storage", errorDescription);
-        return false;
-    }
+    if (!pSnapshot ||
+        !note.qevercloudNote().limits.isEqual(
+            pSnapshot->qevercloudNote().limits))
+    {
+        if (note.hasNoteLimits()) {
+            const qevercloud::NoteLimits & limits = note.noteLimits();
+            bool res =
+                insertOrReplaceNoteLimits(localUid, limits, errorDescription);
+            if (!res) {
+                QNWARNING("local_storage", "Note: " << note);
+                return false;
+            }
+        }
+        else {
+            QString queryString =
+                QString::fromUtf8(
+                    "DELETE FROM NoteLimits WHERE noteLocalUid='%1'")
+                    .arg(localUid);
 
-    return true;
-}
+            QSqlQuery query(m_sqlDatabase);
+            bool res = execQuery(query, queryString);
+            DATABASE_CHECK_AND_SET_ERROR()
+        }
+    }
 
-bool LocalStorageManagerPrivate::getNoteLocalUidForGuid(
-    const QString & noteGuid, QString & noteLocalUid,
-    ErrorString & errorDescription) const
-{
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::getNoteLocalUidForGuid: note guid = "
-            << noteGuid);
+    if (note.hasGuid() &&
+        (!pSnapshot ||
+         !note.qevercloudNote().sharedNotes.isEqual(
+             pSnapshot->qevercloudNote().sharedNotes)))
+    {
+        // Clear shared notes for a given note first, update them (if any)
+        // second
+        {
+            QString noteGuid = sqlEscapeString(note.guid());
+            QString queryString =
+                QString::fromUtf8(
+                    "DELETE FROM SharedNotes WHERE sharedNoteNoteGuid='%1'")
+                    .arg(noteGuid);
 
-    ErrorString errorPrefix(QT_TR_NOOP("can't get note local uid for guid"));
+            QSqlQuery query(m_sqlDatabase);
+            bool res = execQuery(query, queryString);
+            DATABASE_CHECK_AND_SET_ERROR()
+        }
 
-    QString queryString =
-        QString::fromUtf8("SELECT localUid FROM Notes WHERE guid='%1'")
-            .arg(sqlEscapeString(noteGuid));
+        if (note.hasSharedNotes()) {
+            QList<SharedNote> sharedNotes = note.sharedNotes();
+            for (const auto & sharedNote: qAsConst(sharedNotes)) {
+                bool res =
+                    insertOrReplaceSharedNote(sharedNote, errorDescription);
+                if (!res) {
+                    QNWARNING("local_storage", "Note: " << note);
+                    return false;
+                }
+            }
+        }
+    }
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+    bool tagsModified =
+        (!pSnapshot || (note.tagLocalUids() != pSnapshot->tagLocalUids()) ||
+         (note.tagGuids() != pSnapshot->tagGuids()));
 
-    if (query.next()) {
-        noteLocalUid =
-            query.record().value(QStringLiteral("localUid")).toString();
-    }
+    if ((options & UpdateNoteOption::UpdateTags) && tagsModified) {
+        // Clear note-to-tag binding first, update them second
+        {
+            QString queryString =
+                QString::fromUtf8("DELETE From NoteTags WHERE localNote='%1'")
+                    .arg(localUid);
 
-    if (noteLocalUid.isEmpty()) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(
-            QT_TR_NOOP("no existing local uid corresponding to note's guid was "
-                       "found"));
-        errorDescription.details() = noteGuid;
-        QNDEBUG("local_storage", errorDescription);
-        return false;
-    }
+            QSqlQuery query(m_sqlDatabase);
+            bool res = execQuery(query, queryString);
+            DATABASE_CHECK_AND_SET_ERROR()
+        }
 
-    return true;
-}
+        bool hasTagLocalUids = note.hasTagLocalUids();
+        bool hasTagGuids = note.hasTagGuids();
 
-bool LocalStorageManagerPrivate::getNoteGuidForLocalUid(
-    const QString & noteLocalUid, QString & noteGuid,
-    ErrorString & errorDescription) const
-{
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::getNoteGuidForLocalUid: note local "
-            << "uid = " << noteLocalUid);
+        if (hasTagLocalUids || hasTagGuids) {
+            QStringList tagIds;
+            if (hasTagLocalUids) {
+                tagIds = note.tagLocalUids();
+            }
+            else {
+                tagIds = note.tagGuids();
+            }
 
-    ErrorString errorPrefix(QT_TR_NOOP("can't get note guid for local uid"));
+            int numTagIds = tagIds.size();
 
-    QString queryString =
-        QString::fromUtf8("SELECT guid FROM Notes WHERE localUid='%1'")
-            .arg(sqlEscapeString(noteLocalUid));
+            QStringList tagComplementedIds;
+            tagComplementedIds.reserve(numTagIds);
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+            bool res = checkAndPrepareInsertOrReplaceNoteIntoNoteTagsQuery();
+            QSqlQuery & query = m_insertOrReplaceNoteIntoNoteTagsQuery;
+            DATABASE_CHECK_AND_SET_ERROR()
 
-    if (query.next()) {
-        noteGuid = query.record().value(QStringLiteral("guid")).toString();
-    }
+            ErrorString error;
 
-    return true;
-}
+            int tagIndexInNote = 0;
+            for (const auto & tagId: qAsConst(tagIds)) {
+                // NOTE: the behavior expressed here is valid since tags are
+                // synchronized before notes so they must exist within local
+                // storage database; if they don't then something went really
+                // wrong
 
-bool LocalStorageManagerPrivate::getTagLocalUidForGuid(
-    const QString & tagGuid, QString & tagLocalUid,
-    ErrorString & errorDescription) const
-{
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::getTagLocalUidForGuid: tag guid = "
-            << tagGuid);
+                Tag tag;
+                if (hasTagLocalUids) {
+                    tag.setLocalUid(tagId);
+                }
+                else {
+                    tag.setGuid(tagId);
+                }
 
-    ErrorString errorPrefix(QT_TR_NOOP("can't get tag local uid for guid"));
+                error.clear();
+                bool res = findTag(tag, error);
+                if (!res) {
+                    errorDescription.base() = errorPrefix.base();
+                    errorDescription.appendBase(QString::fromUtf8(
+                        QT_TR_NOOP("failed to find one of note's tags")));
+                    errorDescription.appendBase(error.base());
+                    errorDescription.appendBase(error.additionalBases());
+                    errorDescription.details() = error.details();
+                    QNWARNING(
+                        "local_storage",
+                        errorDescription << ", note: " << note);
+                    return false;
+                }
 
-    QString queryString =
-        QString::fromUtf8("SELECT localUid FROM Tags WHERE guid = '%1'")
-            .arg(sqlEscapeString(tagGuid));
+                if (hasTagLocalUids) {
+                    if (tag.hasGuid()) {
+                        tagComplementedIds << tag.guid();
+                    }
+                }
+                else {
+                    tagComplementedIds << tag.localUid();
+                }
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+                query.bindValue(QStringLiteral(":localNote"), localUid);
 
-    if (query.next()) {
-        tagLocalUid =
-            query.record().value(QStringLiteral("localUid")).toString();
-    }
+                query.bindValue(
+                    QStringLiteral(":note"),
+                    (note.hasGuid() ? note.guid() : nullValue));
 
-    if (tagLocalUid.isEmpty()) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(
-            QT_TR_NOOP("no existing local uid corresponding to tag's guid was "
-                       "found"));
-        errorDescription.details() = tagGuid;
-        QNDEBUG("local_storage", errorDescription);
-        return false;
-    }
+                query.bindValue(QStringLiteral(":localTag"), tag.localUid());
 
-    return true;
-}
+                query.bindValue(
+                    QStringLiteral(":tag"),
+                    (tag.hasGuid() ? tag.guid() : nullValue));
 
-bool LocalStorageManagerPrivate::getResourceLocalUidForGuid(
-    const QString & resourceGuid, QString & resourceLocalUid,
-    ErrorString & errorDescription) const
-{
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::getResourceLocalUidForGuid: "
-            << "resource guid = " << resourceGuid);
+                query.bindValue(
+                    QStringLiteral(":tagIndexInNote"), tagIndexInNote);
 
-    ErrorString errorPrefix(
-        QT_TR_NOOP("can't get resource local uid for guid"));
+                res = execQuery(query);
+                DATABASE_CHECK_AND_SET_ERROR()
 
-    QString queryString =
-        QString::fromUtf8(
-            "SELECT resourceLocalUid FROM Resources WHERE resourceGuid = '%1'")
-            .arg(sqlEscapeString(resourceGuid));
+                ++tagIndexInNote;
+            }
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+            if (hasTagLocalUids) {
+                note.setTagGuids(tagComplementedIds);
+            }
+            else {
+                note.setTagLocalUids(tagComplementedIds);
+            }
+        }
 
-    if (query.next()) {
-        resourceLocalUid =
-            query.record().value(QStringLiteral("resourceLocalUid")).toString();
+        // NOTE: don't even attempt fo find tags by their names because
+        // qevercloud::Note.tagNames has the only purpose to provide tag names
+        // alternatively to guids to NoteStore::createNote method
     }
 
-    if (resourceLocalUid.isEmpty()) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(
-            QT_TR_NOOP("no existing local uid corresponding to resource's "
-                       "guid was found"));
-        errorDescription.details() = resourceGuid;
-        QNDEBUG("local_storage", errorDescription);
-        return false;
-    }
+    bool resourcesModified =
+        (!pSnapshot || !snapshot.m_hasResources ||
+         (note.resources() != pSnapshot->resources()));
 
-    return true;
-}
+    if ((options & UpdateNoteOption::UpdateResourceMetadata) &&
+        resourcesModified)
+    {
+        if (!note.hasResources()) {
+            QNDEBUG(
+                "local_storage",
+                "Deleting all resources the note might "
+                    << "have had");
 
-bool LocalStorageManagerPrivate::getSavedSearchLocalUidForGuid(
-    const QString & savedSearchGuid, QString & savedSearchLocalUid,
-    ErrorString & errorDescription) const
-{
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::getSavedSearchLocalUidForGuid: "
-            << "saved search guid = " << savedSearchGuid);
+            QString queryString =
+                QString::fromUtf8(
+                    "DELETE FROM Resources WHERE noteLocalUid='%1'")
+                    .arg(localUid);
 
-    ErrorString errorPrefix(
-        QT_TR_NOOP("can't get saved search local uid for guid"));
+            QSqlQuery query(m_sqlDatabase);
+            bool res = execQuery(query, queryString);
+            DATABASE_CHECK_AND_SET_ERROR()
 
-    QString queryString =
-        QString::fromUtf8(
-            "SELECT localUid FROM SavedSearches WHERE guid = '%1'")
-            .arg(sqlEscapeString(savedSearchGuid));
+            invalidateCompiledNoteSearchQueries();
+            m_guidLocalUidIndex.clear(GuidLocalUidIndex::ObjectType::Resource);
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+            ErrorString error;
+            res = removeOrphanResourceBlobs(error);
+            if (!res) {
+                errorDescription = errorPrefix;
+                errorDescription.appendBase(error.base());
+                errorDescription.appendBase(error.additionalBases());
+                errorDescription.details() = error.details();
+                return false;
+            }
+        }
+        else {
+            bool updateResourceBinaryData =
+                (options & UpdateNoteOption::UpdateResourceBinaryData);
 
-    if (query.next()) {
-        savedSearchLocalUid =
-            query.record().value(QStringLiteral("localUid")).toString();
+            bool res = partialUpdateNoteResources(
+                localUid, note.resources(), updateResourceBinaryData,
+                errorDescription);
+
+            if (!res) {
+                return false;
+            }
+        }
     }
 
-    if (savedSearchLocalUid.isEmpty()) {
-        errorDescription.base() = errorPrefix.base();
-        errorDescription.appendBase(
-            QT_TR_NOOP("no existing local uid corresponding "
-                       "to saved search's guid was found"));
-        errorDescription.details() = savedSearchGuid;
-        QNDEBUG("local_storage", errorDescription);
+    if (!transaction.commit(errorDescription)) {
         return false;
     }
 
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::Note,
+        (note.hasGuid() ? note.guid() : QString()), note.localUid());
+
+    updateNoteLocalStorageSnapshot(
+        note, (pSnapshot ? &snapshot : nullptr), options);
+
     return true;
 }
 
-bool LocalStorageManagerPrivate::insertOrReplaceNote(
-    Note & note, const UpdateNoteOptions options,
+bool LocalStorageManagerPrivate::updateModifiedNoteColumns(
+    const Note & note, const Note & snapshot, const QString & localUid,
+    const QString & notebookLocalUid, bool & snapshotMatches,
     ErrorString & errorDescription)
 {
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::insertOrReplaceNote: update tags = "
-            << ((options & UpdateNoteOption::UpdateTags) ? "true" : "false")
-            << ", update resource metadata = "
-            << ((options & UpdateNoteOption::UpdateResourceMetadata) ? "true"
-                                                                     : "false")
-            << ", update resource binary data = "
-            << ((options & UpdateNoteOption::UpdateResourceBinaryData)
-                    ? "true"
-                    : "false")
-            << ", note local uid = " << note.localUid());
-
-    QNTRACE("local_storage", note);
-
-    // NOTE: this method expects to be called after the note is already checked
-    // for sanity of its parameters!
-
     ErrorString errorPrefix(QT_TR_NOOP("can't insert or replace note"));
 
-    Transaction transaction(m_sqlDatabase, *this, Transaction::Type::Exclusive);
-
-    QVariant nullValue;
-    QString localUid = sqlEscapeString(note.localUid());
+    snapshotMatches = false;
 
-    QString notebookLocalUid =
-        (note.hasNotebookLocalUid() ? sqlEscapeString(note.notebookLocalUid())
-                                    : QString());
+    QList<std::pair<QString, QVariant>> columnValues;
+    bool res = noteColumnValues(
+        note, &snapshot, localUid, notebookLocalUid, columnValues,
+        errorDescription);
 
-    // Special logic needs to be applied if guid is being cleared from the
-    // note; here the evaluation occurs whether guid clearance is meant to take
-    // place
-    bool noteGuidIsBeingCleared = false;
-    if (!note.hasGuid()) {
-        QString noteGuid;
+    if (!res) {
+        return false;
+    }
 
-        bool res =
-            getNoteGuidForLocalUid(note.localUid(), noteGuid, errorDescription);
+    // The row is only updated if its update sequence number and modification
+    // timestamp are still those of the snapshot; otherwise the note must have
+    // been written bypassing the snapshot so it can't tell which parts of
+    // the note are modified
+    QString snapshotCondition = QStringLiteral(
+        "localUid = :localUid AND "
+        "updateSequenceNumber IS :snapshotUpdateSequenceNumber AND "
+        "modificationTimestamp IS :snapshotModificationTimestamp");
 
-        if (!res) {
-            return false;
+    QSqlQuery query(m_sqlDatabase);
+    if (columnValues.isEmpty()) {
+        res = query.prepare(
+            QStringLiteral("SELECT localUid FROM Notes WHERE ") +
+            snapshotCondition);
+    }
+    else {
+        QStringList assignments;
+        assignments.reserve(columnValues.size());
+        for (const auto & columnValue: qAsConst(columnValues)) {
+            assignments
+                << (columnValue.first + QStringLiteral(" = :") +
+                    columnValue.first);
         }
 
-        noteGuidIsBeingCleared = !noteGuid.isEmpty();
+        QNDEBUG(
+            "local_storage",
+            "Updating modified note columns: "
+                << assignments.join(QStringLiteral(", ")));
+
+        res = query.prepare(
+            QString::fromUtf8("UPDATE Notes SET %1 WHERE %2")
+                .arg(
+                    assignments.join(QStringLiteral(", ")),
+                    snapshotCondition));
     }
 
-    QNDEBUG(
-        "local_storage",
-        "Note guid is being cleared = "
-            << (noteGuidIsBeingCleared ? "true" : "false"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    if (noteGuidIsBeingCleared) {
-        if (note.hasResources() &&
-            (options & UpdateNoteOption::UpdateResourceMetadata)) {
-            QList<Resource> resources = note.resources();
-            for (const auto & resource: qAsConst(resources)) {
-                if (Q_UNLIKELY(resource.hasNoteGuid())) {
-                    errorDescription = errorPrefix;
-                    errorDescription.appendBase(
-                        QT_TR_NOOP("note's guid is being cleared but one of "
-                                   "note's resources has non-empty note guid"));
-                    if (resource.hasResourceAttributes() &&
-                        resource.resourceAttributes().fileName.isSet())
-                    {
-                        errorDescription.details() =
-                            resource.resourceAttributes().fileName.ref();
-                    }
+    for (const auto & columnValue: qAsConst(columnValues)) {
+        query.bindValue(
+            QStringLiteral(":") + columnValue.first, columnValue.second);
+    }
 
-                    QNWARNING("local_storage", errorDescription);
-                    return false;
-                }
+    QVariant nullValue;
 
-                if (Q_UNLIKELY(resource.hasGuid())) {
-                    errorDescription = errorPrefix;
-                    errorDescription.appendBase(
-                        QT_TR_NOOP("note's guid is being cleared but one of "
-                                   "note's resources has non-empty guid"));
-                    if (resource.hasResourceAttributes() &&
-                        resource.resourceAttributes().fileName.isSet())
-                    {
-                        errorDescription.details() =
-                            resource.resourceAttributes().fileName.ref();
-                    }
+    query.bindValue(QStringLiteral(":localUid"), localUid);
 
-                    QNWARNING("local_storage", errorDescription);
-                    return false;
-                }
-            }
-        }
+    query.bindValue(
+        QStringLiteral(":snapshotUpdateSequenceNumber"),
+        (snapshot.hasUpdateSequenceNumber() ? snapshot.updateSequenceNumber()
+                                            : nullValue));
+
+    query.bindValue(
+        QStringLiteral(":snapshotModificationTimestamp"),
+        (snapshot.hasModificationTimestamp()
+             ? snapshot.modificationTimestamp()
+             : nullValue));
 
-        QString queryString =
-            QString::fromUtf8(
-                "UPDATE Notes SET guid = NULL WHERE localUid='%1'")
-                .arg(localUid);
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
 
-        QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
-        DATABASE_CHECK_AND_SET_ERROR()
+    if (columnValues.isEmpty()) {
+        snapshotMatches = query.next();
+    }
+    else {
+        snapshotMatches = (query.numRowsAffected() > 0);
     }
 
-    // Update common table with Note properties
-    {
-        bool res = checkAndPrepareInsertOrReplaceNoteQuery();
-        QSqlQuery & query = m_insertOrReplaceNoteQuery;
-        DATABASE_CHECK_AND_SET_ERROR()
+    return true;
+}
 
-        QString titleNormalized;
-        if (note.hasTitle()) {
-            titleNormalized = note.title().toLower();
-            m_stringUtils.removeDiacritics(titleNormalized);
-        }
+bool LocalStorageManagerPrivate::noteColumnValues(
+    const Note & note, const Note * pSnapshot, const QString & localUid,
+    const QString & notebookLocalUid,
+    QList<std::pair<QString, QVariant>> & columnValues,
+    ErrorString & errorDescription)
+{
+    ErrorString errorPrefix(QT_TR_NOOP("can't insert or replace note"));
 
-        query.bindValue(QStringLiteral(":localUid"), localUid);
+    QVariant nullValue;
 
-        query.bindValue(
-            QStringLiteral(":guid"),
-            (note.hasGuid() ? note.guid() : nullValue));
+    const auto addColumnValue = [&](const QString & column,
+                                    const QVariant & value) {
+        columnValues << std::make_pair(column, value);
+    };
 
-        query.bindValue(
-            QStringLiteral(":updateSequenceNumber"),
+    const auto & qecNote = note.qevercloudNote();
+
+    const qevercloud::Note * pSnapshotQecNote =
+        (pSnapshot ? &pSnapshot->qevercloudNote() : nullptr);
+
+    // Without the snapshot all columns are considered modified
+#define NOTE_FIELD_MODIFIED(field)                                             \
+    (!pSnapshotQecNote || !qecNote.field.isEqual(pSnapshotQecNote->field))
+
+    if (!pSnapshot) {
+        addColumnValue(QStringLiteral("localUid"), localUid);
+    }
+
+    if (NOTE_FIELD_MODIFIED(guid)) {
+        addColumnValue(
+            QStringLiteral("guid"), (note.hasGuid() ? note.guid() : nullValue));
+    }
+
+    if (NOTE_FIELD_MODIFIED(updateSequenceNumber)) {
+        addColumnValue(
+            QStringLiteral("updateSequenceNumber"),
             (note.hasUpdateSequenceNumber() ? note.updateSequenceNumber()
                                             : nullValue));
+    }
 
-        query.bindValue(QStringLiteral(":isDirty"), (note.isDirty() ? 1 : 0));
+    if (!pSnapshot || (note.isDirty() != pSnapshot->isDirty())) {
+        addColumnValue(QStringLiteral("isDirty"), (note.isDirty() ? 1 : 0));
+    }
 
-        query.bindValue(QStringLiteral(":isLocal"), (note.isLocal() ? 1 : 0));
+    if (!pSnapshot || (note.isLocal() != pSnapshot->isLocal())) {
+        addColumnValue(QStringLiteral("isLocal"), (note.isLocal() ? 1 : 0));
+    }
 
-        query.bindValue(
-            QStringLiteral(":isFavorited"), (note.isFavorited() ? 1 : 0));
+    if (!pSnapshot || (note.isFavorited() != pSnapshot->isFavorited())) {
+        addColumnValue(
+            QStringLiteral("isFavorited"), (note.isFavorited() ? 1 : 0));
+    }
 
-        query.bindValue(
-            QStringLiteral(":title"),
+    if (NOTE_FIELD_MODIFIED(title)) {
+        QString titleNormalized;
+        if (note.hasTitle()) {
+            titleNormalized = note.title().toLower();
+            m_stringUtils.removeDiacritics(titleNormalized);
+        }
+
+        addColumnValue(
+            QStringLiteral("title"),
             (note.hasTitle() ? note.title() : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":titleNormalized"),
+        addColumnValue(
+            QStringLiteral("titleNormalized"),
             (titleNormalized.isEmpty() ? nullValue : titleNormalized));
+    }
 
-        query.bindValue(
-            QStringLiteral(":content"),
+    if (NOTE_FIELD_MODIFIED(content)) {
+        addColumnValue(
+            QStringLiteral("content"),
             (note.hasContent() ? note.content() : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":contentLength"),
-            (note.hasContentLength() ? note.contentLength() : nullValue));
-
-        query.bindValue(
-            QStringLiteral(":contentHash"),
-            (note.hasContentHash() ? note.contentHash() : nullValue));
-
-        query.bindValue(
-            QStringLiteral(":contentContainsFinishedToDo"),
+        addColumnValue(
+            QStringLiteral("contentContainsFinishedToDo"),
             (note.containsCheckedTodo() ? 1 : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":contentContainsUnfinishedToDo"),
+        addColumnValue(
+            QStringLiteral("contentContainsUnfinishedToDo"),
             (note.containsUncheckedTodo() ? 1 : nullValue));
 
-        query.bindValue(
-            QStringLiteral(":contentContainsEncryption"),
+        addColumnValue(
+            QStringLiteral("contentContainsEncryption"),
             (note.containsEncryption() ? 1 : nullValue));
 
         if (note.hasContent()) {
@@ -8098,87 +11400,119 @@ bool LocalStorageManagerPrivate::insertOrReplaceNote(
             listOfWords = listOfWords.toLower();
             m_stringUtils.removeDiacritics(listOfWords);
 
-            query.bindValue(
-                QStringLiteral(":contentPlainText"),
+            addColumnValue(
+                QStringLiteral("contentPlainText"),
                 (plainTextAndListOfWords.first.isEmpty()
                      ? nullValue
                      : plainTextAndListOfWords.first));
 
-            query.bindValue(
-                QStringLiteral(":contentListOfWords"),
+            addColumnValue(
+                QStringLiteral("contentListOfWords"),
                 (listOfWords.isEmpty() ? nullValue : listOfWords));
         }
         else {
-            query.bindValue(QStringLiteral(":contentPlainText"), nullValue);
-            query.bindValue(QStringLiteral(":contentListOfWords"), nullValue);
+            addColumnValue(QStringLiteral("contentPlainText"), nullValue);
+            addColumnValue(QStringLiteral("contentListOfWords"), nullValue);
         }
+    }
 
-        query.bindValue(
-            QStringLiteral(":creationTimestamp"),
+    if (NOTE_FIELD_MODIFIED(contentLength)) {
+        addColumnValue(
+            QStringLiteral("contentLength"),
+            (note.hasContentLength() ? note.contentLength() : nullValue));
+    }
+
+    if (NOTE_FIELD_MODIFIED(contentHash)) {
+        addColumnValue(
+            QStringLiteral("contentHash"),
+            (note.hasContentHash() ? note.contentHash() : nullValue));
+    }
+
+    if (NOTE_FIELD_MODIFIED(created)) {
+        addColumnValue(
+            QStringLiteral("creationTimestamp"),
             (note.hasCreationTimestamp() ? note.creationTimestamp()
                                          : nullValue));
+    }
 
-        query.bindValue(
-            QStringLiteral(":modificationTimestamp"),
+    if (NOTE_FIELD_MODIFIED(updated)) {
+        addColumnValue(
+            QStringLiteral("modificationTimestamp"),
             (note.hasModificationTimestamp() ? note.modificationTimestamp()
                                              : nullValue));
+    }
 
-        query.bindValue(
-            QStringLiteral(":deletionTimestamp"),
+    if (NOTE_FIELD_MODIFIED(deleted)) {
+        addColumnValue(
+            QStringLiteral("deletionTimestamp"),
             (note.hasDeletionTimestamp() ? note.deletionTimestamp()
                                          : nullValue));
+    }
 
-        query.bindValue(
-            QStringLiteral(":isActive"),
+    if (NOTE_FIELD_MODIFIED(active)) {
+        addColumnValue(
+            QStringLiteral("isActive"),
             (note.hasActive() ? (note.active() ? 1 : 0) : nullValue));
+    }
 
-        query.bindValue(
-            QStringLiteral(":hasAttributes"),
-            (note.hasNoteAttributes() ? 1 : 0));
-
-        QByteArray thumbnailData = note.thumbnailData();
-        query.bindValue(
-            QStringLiteral(":thumbnail"),
+    QByteArray thumbnailData = note.thumbnailData();
+    if (!pSnapshot || (thumbnailData != pSnapshot->thumbnailData())) {
+        addColumnValue(
+            QStringLiteral("thumbnail"),
             (thumbnailData.isEmpty() ? nullValue : thumbnailData));
+    }
 
-        query.bindValue(
-            QStringLiteral(":notebookLocalUid"),
+    if (!pSnapshot ||
+        (note.hasNotebookLocalUid() != pSnapshot->hasNotebookLocalUid()) ||
+        (note.hasNotebookLocalUid() &&
+         (note.notebookLocalUid() != pSnapshot->notebookLocalUid())))
+    {
+        addColumnValue(
+            QStringLiteral("notebookLocalUid"),
             (notebookLocalUid.isEmpty() ? nullValue : notebookLocalUid));
+    }
 
-        query.bindValue(
-            QStringLiteral(":notebookGuid"),
+    if (NOTE_FIELD_MODIFIED(notebookGuid)) {
+        addColumnValue(
+            QStringLiteral("notebookGuid"),
             (note.hasNotebookGuid() ? note.notebookGuid() : nullValue));
+    }
+
+    if (NOTE_FIELD_MODIFIED(attributes)) {
+        addColumnValue(
+            QStringLiteral("hasAttributes"),
+            (note.hasNoteAttributes() ? 1 : 0));
 
         if (note.hasNoteAttributes()) {
             const auto & attributes = note.noteAttributes();
 
-#define BIND_ATTRIBUTE(name)                                                   \
-    query.bindValue(                                                           \
-        QStringLiteral(":" #name),                                             \
+#define ADD_ATTRIBUTE_VALUE(name)                                              \
+    addColumnValue(                                                            \
+        QStringLiteral(#name),                                                 \
         (attributes.name.isSet() ? attributes.name.ref() : nullValue))
 
-            BIND_ATTRIBUTE(subjectDate);
-            BIND_ATTRIBUTE(latitude);
-            BIND_ATTRIBUTE(longitude);
-            BIND_ATTRIBUTE(altitude);
-            BIND_ATTRIBUTE(author);
-            BIND_ATTRIBUTE(source);
-            BIND_ATTRIBUTE(sourceURL);
-            BIND_ATTRIBUTE(sourceApplication);
-            BIND_ATTRIBUTE(shareDate);
-            BIND_ATTRIBUTE(reminderOrder);
-            BIND_ATTRIBUTE(reminderDoneTime);
-            BIND_ATTRIBUTE(reminderTime);
-            BIND_ATTRIBUTE(placeName);
-            BIND_ATTRIBUTE(contentClass);
-            BIND_ATTRIBUTE(lastEditedBy);
-            BIND_ATTRIBUTE(creatorId);
-            BIND_ATTRIBUTE(lastEditorId);
-            BIND_ATTRIBUTE(sharedWithBusiness);
-            BIND_ATTRIBUTE(conflictSourceNoteGuid);
-            BIND_ATTRIBUTE(noteTitleQuality);
-
-#undef BIND_ATTRIBUTE
+            ADD_ATTRIBUTE_VALUE(subjectDate);
+            ADD_ATTRIBUTE_VALUE(latitude);
+            ADD_ATTRIBUTE_VALUE(longitude);
+            ADD_ATTRIBUTE_VALUE(altitude);
+            ADD_ATTRIBUTE_VALUE(author);
+            ADD_ATTRIBUTE_VALUE(source);
+            ADD_ATTRIBUTE_VALUE(sourceURL);
+            ADD_ATTRIBUTE_VALUE(sourceApplication);
+            ADD_ATTRIBUTE_VALUE(shareDate);
+            ADD_ATTRIBUTE_VALUE(reminderOrder);
+            ADD_ATTRIBUTE_VALUE(reminderDoneTime);
+            ADD_ATTRIBUTE_VALUE(reminderTime);
+            ADD_ATTRIBUTE_VALUE(placeName);
+            ADD_ATTRIBUTE_VALUE(contentClass);
+            ADD_ATTRIBUTE_VALUE(lastEditedBy);
+            ADD_ATTRIBUTE_VALUE(creatorId);
+            ADD_ATTRIBUTE_VALUE(lastEditorId);
+            ADD_ATTRIBUTE_VALUE(sharedWithBusiness);
+            ADD_ATTRIBUTE_VALUE(conflictSourceNoteGuid);
+            ADD_ATTRIBUTE_VALUE(noteTitleQuality);
+
+#undef ADD_ATTRIBUTE_VALUE
 
             if (attributes.applicationData.isSet()) {
                 const auto & lazyMap = attributes.applicationData.ref();
@@ -8198,13 +11532,13 @@ bool LocalStorageManagerPrivate::insertOrReplaceNote(
                         "Application data keys only "
                             << "string: " << keysOnlyString);
 
-                    query.bindValue(
-                        QStringLiteral(":applicationDataKeysOnly"),
+                    addColumnValue(
+                        QStringLiteral("applicationDataKeysOnly"),
                         keysOnlyString);
                 }
                 else {
-                    query.bindValue(
-                        QStringLiteral(":applicationDataKeysOnly"), nullValue);
+                    addColumnValue(
+                        QStringLiteral("applicationDataKeysOnly"), nullValue);
                 }
 
                 if (lazyMap.fullMap.isSet()) {
@@ -8230,31 +11564,31 @@ bool LocalStorageManagerPrivate::insertOrReplaceNote(
                             << ", application data map values: "
                             << fullMapValuesString);
 
-                    query.bindValue(
-                        QStringLiteral(":applicationDataKeysMap"),
+                    addColumnValue(
+                        QStringLiteral("applicationDataKeysMap"),
                         fullMapKeysString);
 
-                    query.bindValue(
-                        QStringLiteral(":applicationDataValues"),
+                    addColumnValue(
+                        QStringLiteral("applicationDataValues"),
                         fullMapValuesString);
                 }
                 else {
-                    query.bindValue(
-                        QStringLiteral(":applicationDataKeysMap"), nullValue);
+                    addColumnValue(
+                        QStringLiteral("applicationDataKeysMap"), nullValue);
 
-                    query.bindValue(
-                        QStringLiteral(":applicationDataValues"), nullValue);
+                    addColumnValue(
+                        QStringLiteral("applicationDataValues"), nullValue);
                 }
             }
             else {
-                query.bindValue(
-                    QStringLiteral(":applicationDataKeysOnly"), nullValue);
+                addColumnValue(
+                    QStringLiteral("applicationDataKeysOnly"), nullValue);
 
-                query.bindValue(
-                    QStringLiteral(":applicationDataKeysMap"), nullValue);
+                addColumnValue(
+                    QStringLiteral("applicationDataKeysMap"), nullValue);
 
-                query.bindValue(
-                    QStringLiteral(":applicationDataValues"), nullValue);
+                addColumnValue(
+                    QStringLiteral("applicationDataValues"), nullValue);
             }
 
             if (attributes.classifications.isSet()) {
@@ -8274,276 +11608,128 @@ bool LocalStorageManagerPrivate::insertOrReplaceNote(
                     "local_storage",
                     "Classification keys: " << classificationKeys
                                             << ", classification values"
-                                            << classificationValues);
-
-                query.bindValue(
-                    QStringLiteral(":classificationKeys"), classificationKeys);
-
-                query.bindValue(
-                    QStringLiteral(":classificationValues"),
-                    classificationValues);
-            }
-            else {
-                query.bindValue(
-                    QStringLiteral(":classificationKeys"), nullValue);
-
-                query.bindValue(
-                    QStringLiteral(":classificationValues"), nullValue);
-            }
-        }
-        else {
-#define BIND_NULL_ATTRIBUTE(name)                                              \
-    query.bindValue(QStringLiteral(":" #name), nullValue)
-
-            BIND_NULL_ATTRIBUTE(subjectDate);
-            BIND_NULL_ATTRIBUTE(latitude);
-            BIND_NULL_ATTRIBUTE(longitude);
-            BIND_NULL_ATTRIBUTE(altitude);
-            BIND_NULL_ATTRIBUTE(author);
-            BIND_NULL_ATTRIBUTE(source);
-            BIND_NULL_ATTRIBUTE(sourceURL);
-            BIND_NULL_ATTRIBUTE(sourceApplication);
-            BIND_NULL_ATTRIBUTE(shareDate);
-            BIND_NULL_ATTRIBUTE(reminderOrder);
-            BIND_NULL_ATTRIBUTE(reminderDoneTime);
-            BIND_NULL_ATTRIBUTE(reminderTime);
-            BIND_NULL_ATTRIBUTE(placeName);
-            BIND_NULL_ATTRIBUTE(contentClass);
-            BIND_NULL_ATTRIBUTE(lastEditedBy);
-            BIND_NULL_ATTRIBUTE(creatorId);
-            BIND_NULL_ATTRIBUTE(lastEditorId);
-            BIND_NULL_ATTRIBUTE(sharedWithBusiness);
-            BIND_NULL_ATTRIBUTE(conflictSourceNoteGuid);
-            BIND_NULL_ATTRIBUTE(noteTitleQuality);
-            BIND_NULL_ATTRIBUTE(applicationDataKeysOnly);
-            BIND_NULL_ATTRIBUTE(applicationDataKeysMap);
-            BIND_NULL_ATTRIBUTE(applicationDataValues);
-            BIND_NULL_ATTRIBUTE(classificationKeys);
-            BIND_NULL_ATTRIBUTE(classificationValues);
-
-#undef BIND_NULL_ATTRIBUTE
-        }
-
-        res = query.exec();
-        DATABASE_CHECK_AND_SET_ERROR()
-    }
-
-    if (note.hasNoteRestrictions()) {
-        const auto & restrictions = note.noteRestrictions();
-        bool res = insertOrReplaceNoteRestrictions(
-            localUid, restrictions, errorDescription);
-        if (!res) {
-            QNWARNING("local_storage", "Note: " << note);
-            return false;
-        }
-    }
-    else {
-        QString queryString =
-            QString::fromUtf8(
-                "DELETE FROM NoteRestrictions WHERE noteLocalUid='%1'")
-                .arg(localUid);
-
-        QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
-        DATABASE_CHECK_AND_SET_ERROR()
-    }
-
-    if (note.hasNoteLimits()) {
-        const qevercloud::NoteLimits & limits = note.noteLimits();
-        bool res =
-            insertOrReplaceNoteLimits(localUid, limits, errorDescription);
-        if (!res) {
-            QNWARNING("local_storage", "Note: " << note);
-            return false;
-        }
-    }
-    else {
-        QString queryString =
-            QString::fromUtf8("DELETE FROM NoteLimits WHERE noteLocalUid='%1'")
-                .arg(localUid);
-
-        QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
-        DATABASE_CHECK_AND_SET_ERROR()
-    }
-
-    if (note.hasGuid()) {
-        // Clear shared notes for a given note first, update them (if any)
-        // second
-        {
-            QString noteGuid = sqlEscapeString(note.guid());
-            QString queryString =
-                QString::fromUtf8(
-                    "DELETE FROM SharedNotes WHERE sharedNoteNoteGuid='%1'")
-                    .arg(noteGuid);
-
-            QSqlQuery query(m_sqlDatabase);
-            bool res = query.exec(queryString);
-            DATABASE_CHECK_AND_SET_ERROR()
-        }
-
-        if (note.hasSharedNotes()) {
-            QList<SharedNote> sharedNotes = note.sharedNotes();
-            for (const auto & sharedNote: qAsConst(sharedNotes)) {
-                bool res =
-                    insertOrReplaceSharedNote(sharedNote, errorDescription);
-                if (!res) {
-                    QNWARNING("local_storage", "Note: " << note);
-                    return false;
-                }
-            }
-        }
-    }
-
-    if (options & UpdateNoteOption::UpdateTags) {
-        // Clear note-to-tag binding first, update them second
-        {
-            QString queryString =
-                QString::fromUtf8("DELETE From NoteTags WHERE localNote='%1'")
-                    .arg(localUid);
-
-            QSqlQuery query(m_sqlDatabase);
-            bool res = query.exec(queryString);
-            DATABASE_CHECK_AND_SET_ERROR()
-        }
-
-        bool hasTagLocalUids = note.hasTagLocalUids();
-        bool hasTagGuids = note.hasTagGuids();
-
-        if (hasTagLocalUids || hasTagGuids) {
-            QStringList tagIds;
-            if (hasTagLocalUids) {
-                tagIds = note.tagLocalUids();
-            }
-            else {
-                tagIds = note.tagGuids();
-            }
-
-            int numTagIds = tagIds.size();
-
-            QStringList tagComplementedIds;
-            tagComplementedIds.reserve(numTagIds);
-
-            bool res = checkAndPrepareInsertOrReplaceNoteIntoNoteTagsQuery();
-            QSqlQuery & query = m_insertOrReplaceNoteIntoNoteTagsQuery;
-            DATABASE_CHECK_AND_SET_ERROR()
-
-            ErrorString error;
-
-            int tagIndexInNote = 0;
-            for (const auto & tagId: qAsConst(tagIds)) {
-                // NOTE: the behavior expressed here is valid since tags are
-                // synchronized before notes so they must exist within local
-                // storage database; if they don't then something went really
-                // wrong
-
-                Tag tag;
-                if (hasTagLocalUids) {
-                    tag.setLocalUid(tagId);
-                }
-                else {
-                    tag.setGuid(tagId);
-                }
-
-                error.clear();
-                bool res = findTag(tag, error);
-                if (!res) {
-                    errorDescription.base() = errorPrefix.base();
-                    errorDescription.appendBase(QString::fromUtf8(
-                        QT_TR_NOOP("failed to find one of note's tags")));
-                    errorDescription.appendBase(error.base());
-                    errorDescription.appendBase(error.additionalBases());
-                    errorDescription.details() = error.details();
-                    QNWARNING(
-                        "local_storage",
-                        errorDescription << ", note: " << note);
-                    return false;
-                }
-
-                if (hasTagLocalUids) {
-                    if (tag.hasGuid()) {
-                        tagComplementedIds << tag.guid();
-                    }
-                }
-                else {
-                    tagComplementedIds << tag.localUid();
-                }
-
-                query.bindValue(QStringLiteral(":localNote"), localUid);
-
-                query.bindValue(
-                    QStringLiteral(":note"),
-                    (note.hasGuid() ? note.guid() : nullValue));
-
-                query.bindValue(QStringLiteral(":localTag"), tag.localUid());
-
-                query.bindValue(
-                    QStringLiteral(":tag"),
-                    (tag.hasGuid() ? tag.guid() : nullValue));
-
-                query.bindValue(
-                    QStringLiteral(":tagIndexInNote"), tagIndexInNote);
-
-                res = query.exec();
-                DATABASE_CHECK_AND_SET_ERROR()
+                                            << classificationValues);
 
-                ++tagIndexInNote;
-            }
+                addColumnValue(
+                    QStringLiteral("classificationKeys"), classificationKeys);
 
-            if (hasTagLocalUids) {
-                note.setTagGuids(tagComplementedIds);
+                addColumnValue(
+                    QStringLiteral("classificationValues"),
+                    classificationValues);
             }
             else {
-                note.setTagLocalUids(tagComplementedIds);
+                addColumnValue(QStringLiteral("classificationKeys"), nullValue);
+
+                addColumnValue(
+                    QStringLiteral("classificationValues"), nullValue);
             }
         }
+        else {
+#define ADD_NULL_ATTRIBUTE_VALUE(name)                                         \
+    addColumnValue(QStringLiteral(#name), nullValue)
+
+            ADD_NULL_ATTRIBUTE_VALUE(subjectDate);
+            ADD_NULL_ATTRIBUTE_VALUE(latitude);
+            ADD_NULL_ATTRIBUTE_VALUE(longitude);
+            ADD_NULL_ATTRIBUTE_VALUE(altitude);
+            ADD_NULL_ATTRIBUTE_VALUE(author);
+            ADD_NULL_ATTRIBUTE_VALUE(source);
+            ADD_NULL_ATTRIBUTE_VALUE(sourceURL);
+            ADD_NULL_ATTRIBUTE_VALUE(sourceApplication);
+            ADD_NULL_ATTRIBUTE_VALUE(shareDate);
+            ADD_NULL_ATTRIBUTE_VALUE(reminderOrder);
+            ADD_NULL_ATTRIBUTE_VALUE(reminderDoneTime);
+            ADD_NULL_ATTRIBUTE_VALUE(reminderTime);
+            ADD_NULL_ATTRIBUTE_VALUE(placeName);
+            ADD_NULL_ATTRIBUTE_VALUE(contentClass);
+            ADD_NULL_ATTRIBUTE_VALUE(lastEditedBy);
+            ADD_NULL_ATTRIBUTE_VALUE(creatorId);
+            ADD_NULL_ATTRIBUTE_VALUE(lastEditorId);
+            ADD_NULL_ATTRIBUTE_VALUE(sharedWithBusiness);
+            ADD_NULL_ATTRIBUTE_VALUE(conflictSourceNoteGuid);
+            ADD_NULL_ATTRIBUTE_VALUE(noteTitleQuality);
+            ADD_NULL_ATTRIBUTE_VALUE(applicationDataKeysOnly);
+            ADD_NULL_ATTRIBUTE_VALUE(applicationDataKeysMap);
+            ADD_NULL_ATTRIBUTE_VALUE(applicationDataValues);
+            ADD_NULL_ATTRIBUTE_VALUE(classificationKeys);
+            ADD_NULL_ATTRIBUTE_VALUE(classificationValues);
+
+#undef ADD_NULL_ATTRIBUTE_VALUE
+        }
+
+    }
+
+#undef NOTE_FIELD_MODIFIED
 
-        // NOTE: don't even attempt fo find tags by their names because
-        // qevercloud::Note.tagNames has the only purpose to provide tag names
-        // alternatively to guids to NoteStore::createNote method
+    return true;
+}
+
+void LocalStorageManagerPrivate::updateNoteLocalStorageSnapshot(
+    const Note & note, const NoteLocalStorageSnapshot * pPreviousSnapshot,
+    const UpdateNoteOptions options)
+{
+    // Tags and resources are written only if the options say so; if they were
+    // not written, their persisted state is known only if the note still has
+    // them the same as in the previous snapshot
+    bool tagsKnown = (options & UpdateNoteOption::UpdateTags) ||
+        (pPreviousSnapshot &&
+         (note.tagLocalUids() == pPreviousSnapshot->m_note.tagLocalUids()) &&
+         (note.tagGuids() == pPreviousSnapshot->m_note.tagGuids()));
+
+    if (!tagsKnown) {
+        Q_UNUSED(m_noteLocalStorageSnapshots.remove(note.localUid()))
+        return;
     }
 
+    bool resourcesKnown = false;
     if (options & UpdateNoteOption::UpdateResourceMetadata) {
-        if (!note.hasResources()) {
-            QNDEBUG(
-                "local_storage",
-                "Deleting all resources the note might "
-                    << "have had");
-
-            QString queryString =
-                QString::fromUtf8(
-                    "DELETE FROM Resources WHERE noteLocalUid='%1'")
-                    .arg(localUid);
-
-            QSqlQuery query(m_sqlDatabase);
-            bool res = query.exec(queryString);
-            DATABASE_CHECK_AND_SET_ERROR()
-
-            ErrorString error;
-            res = removeResourceDataFilesForNote(localUid, error);
-            if (!res) {
-                errorDescription = errorPrefix;
-                errorDescription.appendBase(error.base());
-                errorDescription.appendBase(error.additionalBases());
-                errorDescription.details() = error.details();
-                return false;
-            }
+        resourcesKnown = (options & UpdateNoteOption::UpdateResourceBinaryData);
+        if (!resourcesKnown) {
+            // Binary data which was not written might differ from the one
+            // in the local storage
+            const auto resources = note.resources();
+            resourcesKnown = std::none_of(
+                resources.constBegin(), resources.constEnd(),
+                [](const Resource & resource) {
+                    return resource.hasDataBody() ||
+                        resource.hasAlternateDataBody();
+                });
         }
-        else {
-            bool updateResourceBinaryData =
-                (options & UpdateNoteOption::UpdateResourceBinaryData);
+    }
+    else if (pPreviousSnapshot && pPreviousSnapshot->m_hasResources) {
+        resourcesKnown =
+            (note.resources() == pPreviousSnapshot->m_note.resources());
+    }
 
-            bool res = partialUpdateNoteResources(
-                localUid, note.resources(), updateResourceBinaryData,
-                errorDescription);
+    putNoteLocalStorageSnapshot(note, resourcesKnown);
+}
 
-            if (!res) {
-                return false;
-            }
-        }
+void LocalStorageManagerPrivate::putNoteLocalStorageSnapshot(
+    const Note & note, const bool withResources) const
+{
+    // Read-only connections don't write notes
+    if (m_readOnly) {
+        return;
     }
 
-    return transaction.commit(errorDescription);
+    // The snapshot shares the implicitly shared data with the note so it is
+    // cheap until either of them is modified
+    NoteLocalStorageSnapshot snapshot;
+    snapshot.m_note = note;
+    snapshot.m_hasResources = withResources;
+    m_noteLocalStorageSnapshots.put(note.localUid(), snapshot);
+}
+
+void LocalStorageManagerPrivate::removeNoteLocalStorageSnapshot(
+    const Resource & resource)
+{
+    // The snapshot of resource's note no longer reflects the note's resources
+    if (resource.hasNoteLocalUid()) {
+        Q_UNUSED(m_noteLocalStorageSnapshots.remove(resource.noteLocalUid()))
+    }
+    else {
+        m_noteLocalStorageSnapshots.clear();
+    }
 }
 
 bool LocalStorageManagerPrivate::insertOrReplaceSharedNote(
@@ -8682,7 +11868,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceSharedNote(
         ((sharedNote.indexInNote() >= 0) ? sharedNote.indexInNote()
                                          : nullValue));
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -8718,7 +11904,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceNoteRestrictions(
 
 #undef BIND_RESTRICTION
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -8751,7 +11937,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceNoteLimits(
 
 #undef BIND_LIMIT
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
     return true;
@@ -9057,6 +12243,8 @@ bool LocalStorageManagerPrivate::insertOrReplaceTag(
         QT_TR_NOOP("can't insert or replace tag into the local storage "
                    "database"));
 
+    invalidateCompiledNoteSearchQueries();
+
     QString localUid = tag.localUid();
 
     bool res = checkAndPrepareInsertOrReplaceTagQuery();
@@ -9109,9 +12297,13 @@ bool LocalStorageManagerPrivate::insertOrReplaceTag(
     query.bindValue(
         QStringLiteral(":isFavorited"), (tag.isFavorited() ? 1 : 0));
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
 
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::Tag,
+        (tag.hasGuid() ? tag.guid() : QString()), localUid);
+
     return true;
 }
 
@@ -9199,7 +12391,7 @@ bool LocalStorageManagerPrivate::complementTagParentInfo(
     QNDEBUG("local_storage", "Query string = " << queryString);
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     res = query.next();
@@ -9225,7 +12417,8 @@ bool LocalStorageManagerPrivate::complementTagParentInfo(
 
 bool LocalStorageManagerPrivate::insertOrReplaceResource(
     const Resource & resource, ErrorString & errorDescription,
-    const bool setResourceBinaryData, const bool useSeparateTransaction)
+    const bool setResourceBinaryData, const bool useSeparateTransaction,
+    const bool keepMissingDataBody)
 {
     // NOTE: this method expects to be called after resource is already checked
     // for sanity of its parameters!
@@ -9242,6 +12435,9 @@ bool LocalStorageManagerPrivate::insertOrReplaceResource(
         QT_TR_NOOP("can't insert or replace resource into the local storage "
                    "database"));
 
+    invalidateCompiledNoteSearchQueries();
+    removeNoteLocalStorageSnapshot(resource);
+
     std::unique_ptr<Transaction> pTransaction;
     if (useSeparateTransaction) {
         pTransaction.reset(new Transaction(
@@ -9271,7 +12467,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceResource(
 
         query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
 
-        res = query.exec();
+        res = execQuery(query);
         DATABASE_CHECK_AND_SET_ERROR()
     }
 
@@ -9308,380 +12504,755 @@ bool LocalStorageManagerPrivate::insertOrReplaceResource(
                 query.bindValue(
                     QStringLiteral(":resourceLocalUid"), resourceLocalUid);
 
-                query.bindValue(QStringLiteral(":noteLocalUid"), noteLocalUid);
+                query.bindValue(QStringLiteral(":noteLocalUid"), noteLocalUid);
+
+                query.bindValue(
+                    QStringLiteral(":recognitionData"), recognitionData);
+
+                res = execQuery(query);
+                DATABASE_CHECK_AND_SET_ERROR()
+            }
+        }
+    }
+
+    // Removing resource from ResourceAttributes table
+    {
+        bool res = checkAndPrepareDeleteResourceFromResourceAttributesQuery();
+        QSqlQuery & query = m_deleteResourceFromResourceAttributesQuery;
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+
+        res = execQuery(query);
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
+
+    // Removing resource from ResourceAttributesApplicationDataKeysOnly table
+    {
+        bool res =
+            checkAndPrepareDeleteResourceFromResourceAttributesApplicationDataKeysOnlyQuery();
+
+        QSqlQuery & query =
+            m_deleteResourceFromResourceAttributesApplicationDataKeysOnlyQuery;
+
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+
+        res = execQuery(query);
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
+
+    // Removing resource from ResourceAttributesApplicationDataFullMap table
+    {
+        bool res =
+            checkAndPrepareDeleteResourceFromResourceAttributesApplicationDataFullMapQuery();
+
+        QSqlQuery & query =
+            m_deleteResourceFromResourceAttributesApplicationDataFullMapQuery;
+
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+
+        res = execQuery(query);
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
+
+    if (resource.hasResourceAttributes()) {
+        const auto & attributes = resource.resourceAttributes();
+
+        bool res = insertOrReplaceResourceAttributes(
+            resourceLocalUid, attributes, errorDescription);
+
+        if (!res) {
+            return false;
+        }
+    }
+
+    if (setResourceBinaryData) {
+        if (!writeResourceBinaryDataToFiles(
+                resource, keepMissingDataBody, errorDescription))
+        {
+            return false;
+        }
+    }
+
+    if (pTransaction) {
+        if (!pTransaction->commit(errorDescription)) {
+            return false;
+        }
+    }
+
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::Resource,
+        (resource.hasGuid() ? resource.guid() : QString()), resourceLocalUid);
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::writeResourceBinaryDataToFiles(
+    const Resource & resource, const bool keepMissingDataBody,
+    ErrorString & errorDescription)
+{
+    QString resourceLocalUid = resource.localUid();
+
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::writeResourceBinaryDataToFiles: "
+            << "resource local uid = " << resourceLocalUid);
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't insert or replace resource: failed to write resource "
+                   "binary data to files"));
+
+    if (!resource.hasNoteLocalUid()) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("the resource has no note local uid set"));
+        QString displayName = resource.displayName();
+        if (!displayName.isEmpty()) {
+            errorDescription.details() = displayName + QStringLiteral(", ");
+        }
+        errorDescription.details() += QStringLiteral("resource local uid = ");
+        errorDescription.details() += resourceLocalUid;
+        QNWARNING(
+            "local_storage", errorDescription << ", resource: " << resource);
+        return false;
+    }
+
+    // NOTE: when the data body is streamed to the blob store separately,
+    // data without body means the already stored data body should be kept
+    // as is
+    bool keepDataBody = keepMissingDataBody && resource.hasData() &&
+        !resource.hasDataBody();
+
+    if (Q_UNLIKELY(
+            !resource.hasDataBody() && !resource.hasAlternateDataBody() &&
+            !keepDataBody))
+    {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("the resource has neither data body nor alternate data "
+                       "body set"));
+        QString displayName = resource.displayName();
+        if (!displayName.isEmpty()) {
+            errorDescription.details() = displayName + QStringLiteral(", ");
+        }
+        errorDescription.details() += QStringLiteral("resource local uid = ");
+        errorDescription.details() += resourceLocalUid;
+        QNWARNING(
+            "local_storage", errorDescription << ", resource: " << resource);
+        return false;
+    }
+
+    // Lazy bodies are read from blob files which might have been removed
+    // since the resource was read from the local storage; writing the bodies
+    // which could not be read would replace the actual data with empty one
+    Resource resourceWithBodies(resource);
+    if ((resource.hasLazyDataBody() || resource.hasLazyAlternateDataBody()) &&
+        !resourceWithBodies.prefetchDataBodies())
+    {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("the lazily loaded binary data of the resource could "
+                       "not be read"));
+        QString displayName = resource.displayName();
+        if (!displayName.isEmpty()) {
+            errorDescription.details() = displayName + QStringLiteral(", ");
+        }
+        errorDescription.details() += QStringLiteral("resource local uid = ");
+        errorDescription.details() += resourceLocalUid;
+        QNWARNING(
+            "local_storage", errorDescription << ", resource: " << resource);
+        return false;
+    }
+
+    // Blob files are never modified once written so the switch from the old
+    // binary data to the new one is done by updating the references within
+    // the current transaction; the blobs which are no longer referenced are
+    // removed after the transaction is committed
+    for (const bool isAlternateDataBody: {false, true}) {
+        bool hasBody =
+            (isAlternateDataBody ? resourceWithBodies.hasAlternateDataBody()
+                                 : resourceWithBodies.hasDataBody());
+
+        bool hasData =
+            (isAlternateDataBody ? resourceWithBodies.hasAlternateData()
+                                 : resourceWithBodies.hasData());
+
+        ErrorString error;
+        bool res = true;
+
+        if (hasBody) {
+            QString blobHash;
+            res = writeResourceBlob(
+                (isAlternateDataBody ? resourceWithBodies.alternateDataBody()
+                                     : resourceWithBodies.dataBody()),
+                blobHash, error);
+
+            if (res) {
+                res = setResourceBlobReference(
+                    resourceLocalUid, isAlternateDataBody, blobHash, error);
+            }
+        }
+        else if (!hasData) {
+            res = removeResourceBlobReference(
+                resourceLocalUid, isAlternateDataBody, error);
+        }
+
+        if (!res) {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            return false;
+        }
+    }
+
+    ErrorString error;
+    if (!removeOrphanResourceBlobs(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        return false;
+    }
+
+    return true;
+}
+
+QString LocalStorageManagerPrivate::resourceBlobFilePath(
+    const QString & blobHash) const
+{
+    // Blobs are spread across subfolders named after the first two characters
+    // of their hashes to keep the number of files per folder reasonable
+    return accountPersistentStoragePath(m_currentAccount) +
+        QStringLiteral("/Resources/blobs/") + blobHash.left(2) +
+        QStringLiteral("/") + blobHash + QStringLiteral(".dat");
+}
+
+bool LocalStorageManagerPrivate::writeResourceBlob(
+    const QByteArray & body, QString & blobHash,
+    ErrorString & errorDescription)
+{
+    blobHash = QString::fromLatin1(
+        QCryptographicHash::hash(body, QCryptographicHash::Md5).toHex());
+
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::writeResourceBlob: blob hash = "
+            << blobHash << ", size = " << body.size());
+
+    ErrorString errorPrefix(QT_TR_NOOP("failed to write resource data blob"));
+
+    QString blobFilePath = resourceBlobFilePath(blobHash);
+    QFileInfo blobFileInfo(blobFilePath);
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.prepare(QStringLiteral(
+        "SELECT refCount FROM ResourceBlobs WHERE blobHash = :blobHash"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    query.bindValue(QStringLiteral(":blobHash"), blobHash);
+
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    if (query.next() && blobFileInfo.exists()) {
+        QNDEBUG(
+            "local_storage",
+            "Resource data blob already exists, no need to write it again");
+        return true;
+    }
+
+    QDir blobDir = blobFileInfo.absoluteDir();
+    if (!blobDir.exists() && !blobDir.mkpath(blobDir.absolutePath())) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("failed to create directory for resource data blob"));
+        errorDescription.details() = blobDir.absolutePath();
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
+
+    // NOTE: for crash recovery purposes the blob is first written to a new
+    // file which is then atomically renamed
+    QString newBlobFilePath = blobFilePath + QStringLiteral(".new");
+    QFile blobFile(newBlobFilePath);
 
-                query.bindValue(
-                    QStringLiteral(":recognitionData"), recognitionData);
+    if (!blobFile.open(QIODevice::WriteOnly)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("failed to open resource data blob file for writing"));
+        errorDescription.details() = newBlobFilePath;
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
 
-                res = query.exec();
-                DATABASE_CHECK_AND_SET_ERROR()
-            }
-        }
+    qint64 bytesWritten = blobFile.write(body);
+    if (bytesWritten < static_cast<qint64>(body.size())) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(QT_TR_NOOP(
+            "failed to write the whole resource data to blob file"));
+        errorDescription.details() = newBlobFilePath;
+        QNWARNING("local_storage", errorDescription);
+        return false;
     }
 
-    // Removing resource from ResourceAttributes table
-    {
-        bool res = checkAndPrepareDeleteResourceFromResourceAttributesQuery();
-        QSqlQuery & query = m_deleteResourceFromResourceAttributesQuery;
-        DATABASE_CHECK_AND_SET_ERROR()
+    if (!blobFile.flush()) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(QT_TR_NOOP(
+            "failed to flush file after writing resource data blob to it"));
+        errorDescription.details() = newBlobFilePath;
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
 
-        query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+    // NOTE: this seems to be required for the subsequent call
+    // to rename to work on Windows
+    blobFile.close();
 
-        res = query.exec();
-        DATABASE_CHECK_AND_SET_ERROR()
+    ErrorString error;
+    if (!renameFile(newBlobFilePath, blobFilePath, error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        return false;
     }
 
-    // Removing resource from ResourceAttributesApplicationDataKeysOnly table
-    {
-        bool res =
-            checkAndPrepareDeleteResourceFromResourceAttributesApplicationDataKeysOnlyQuery();
+    res = query.prepare(QStringLiteral(
+        "INSERT OR IGNORE INTO ResourceBlobs (blobHash, refCount) "
+        "VALUES(:blobHash, 0)"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-        QSqlQuery & query =
-            m_deleteResourceFromResourceAttributesApplicationDataKeysOnlyQuery;
+    query.bindValue(QStringLiteral(":blobHash"), blobHash);
 
-        DATABASE_CHECK_AND_SET_ERROR()
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
 
-        query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+    return true;
+}
 
-        res = query.exec();
-        DATABASE_CHECK_AND_SET_ERROR()
-    }
+bool LocalStorageManagerPrivate::writeResourceBlob(
+    QIODevice & source, QString & blobHash, qint64 & size,
+    ErrorString & errorDescription)
+{
+    QNDEBUG("local_storage", "LocalStorageManagerPrivate::writeResourceBlob");
 
-    // Removing resource from ResourceAttributesApplicationDataFullMap table
-    {
-        bool res =
-            checkAndPrepareDeleteResourceFromResourceAttributesApplicationDataFullMapQuery();
+    ErrorString errorPrefix(QT_TR_NOOP("failed to write resource data blob"));
 
-        QSqlQuery & query =
-            m_deleteResourceFromResourceAttributesApplicationDataFullMapQuery;
+    // The hash of the data is only known after all of it is read so the data
+    // is first written to a temporary file within the blob store which is
+    // then renamed after the hash
+    QString blobsPath = accountPersistentStoragePath(m_currentAccount) +
+        QStringLiteral("/Resources/blobs");
 
-        DATABASE_CHECK_AND_SET_ERROR()
+    QDir blobsDir(blobsPath);
+    if (!blobsDir.exists() && !blobsDir.mkpath(blobsPath)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("failed to create directory for resource data blob"));
+        errorDescription.details() = blobsPath;
+        QNWARNING("local_storage", errorDescription);
+        return false;
+    }
 
-        query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+    QString newBlobFilePath =
+        blobsPath + QStringLiteral("/") + UidGenerator::Generate() +
+        QStringLiteral(".new");
 
-        res = query.exec();
-        DATABASE_CHECK_AND_SET_ERROR()
+    QFile newBlobFile(newBlobFilePath);
+    if (!newBlobFile.open(QIODevice::WriteOnly)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("failed to open resource data blob file for writing"));
+        errorDescription.details() = newBlobFilePath;
+        QNWARNING("local_storage", errorDescription);
+        return false;
     }
 
-    if (resource.hasResourceAttributes()) {
-        const auto & attributes = resource.resourceAttributes();
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    QByteArray chunk(RESOURCE_BLOB_STREAMING_CHUNK_SIZE, Qt::Uninitialized);
+    size = 0;
 
-        bool res = insertOrReplaceResourceAttributes(
-            resourceLocalUid, attributes, errorDescription);
+    while (true) {
+        qint64 bytesRead = source.read(chunk.data(), chunk.size());
+        if (bytesRead == 0) {
+            // Sequential devices might need to wait for more data
+            if (source.isSequential() && !source.atEnd() &&
+                source.waitForReadyRead(-1))
+            {
+                continue;
+            }
 
-        if (!res) {
-            return false;
+            break;
         }
-    }
 
-    if (setResourceBinaryData) {
-        if (!writeResourceBinaryDataToFiles(resource, errorDescription)) {
+        if (bytesRead < 0) {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(
+                QT_TR_NOOP("failed to read resource data from device"));
+            errorDescription.details() = source.errorString();
+            QNWARNING("local_storage", errorDescription);
+            newBlobFile.close();
+            Q_UNUSED(removeFile(newBlobFilePath))
             return false;
         }
-    }
 
-    if (pTransaction) {
-        if (!pTransaction->commit(errorDescription)) {
+        hash.addData(chunk.constData(), static_cast<int>(bytesRead));
+
+        if (newBlobFile.write(chunk.constData(), bytesRead) != bytesRead) {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(QT_TR_NOOP(
+                "failed to write the whole resource data to blob file"));
+            errorDescription.details() = newBlobFilePath;
+            QNWARNING("local_storage", errorDescription);
+            newBlobFile.close();
+            Q_UNUSED(removeFile(newBlobFilePath))
             return false;
         }
+
+        size += bytesRead;
     }
 
-    return true;
-}
+    if (!newBlobFile.flush()) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(QT_TR_NOOP(
+            "failed to flush file after writing resource data blob to it"));
+        errorDescription.details() = newBlobFilePath;
+        QNWARNING("local_storage", errorDescription);
+        newBlobFile.close();
+        Q_UNUSED(removeFile(newBlobFilePath))
+        return false;
+    }
 
-bool LocalStorageManagerPrivate::writeResourceBinaryDataToFiles(
-    const Resource & resource, ErrorString & errorDescription)
-{
-    QString resourceLocalUid = resource.localUid();
+    // NOTE: this seems to be required for the subsequent call
+    // to rename to work on Windows
+    newBlobFile.close();
+
+    blobHash = QString::fromLatin1(hash.result().toHex());
 
     QNDEBUG(
         "local_storage",
-        "LocalStorageManagerPrivate::writeResourceBinaryDataToFiles: "
-            << "resource local uid = " << resourceLocalUid);
+        "Streamed resource data blob: hash = " << blobHash
+                                               << ", size = " << size);
 
-    ErrorString errorPrefix(
-        QT_TR_NOOP("can't insert or replace resource: failed to write resource "
-                   "binary data to files"));
+    QString blobFilePath = resourceBlobFilePath(blobHash);
+    QFileInfo blobFileInfo(blobFilePath);
 
-    if (!resource.hasNoteLocalUid()) {
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.prepare(QStringLiteral(
+        "SELECT refCount FROM ResourceBlobs WHERE blobHash = :blobHash"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    query.bindValue(QStringLiteral(":blobHash"), blobHash);
+
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    if (query.next() && blobFileInfo.exists()) {
+        QNDEBUG(
+            "local_storage",
+            "Resource data blob already exists, removing the streamed copy");
+        Q_UNUSED(removeFile(newBlobFilePath))
+        return true;
+    }
+
+    QDir blobDir = blobFileInfo.absoluteDir();
+    if (!blobDir.exists() && !blobDir.mkpath(blobDir.absolutePath())) {
         errorDescription = errorPrefix;
         errorDescription.appendBase(
-            QT_TR_NOOP("the resource has no note local uid set"));
-        QString displayName = resource.displayName();
-        if (!displayName.isEmpty()) {
-            errorDescription.details() = displayName + QStringLiteral(", ");
-        }
-        errorDescription.details() += QStringLiteral("resource local uid = ");
-        errorDescription.details() += resourceLocalUid;
-        QNWARNING(
-            "local_storage", errorDescription << ", resource: " << resource);
+            QT_TR_NOOP("failed to create directory for resource data blob"));
+        errorDescription.details() = blobDir.absolutePath();
+        QNWARNING("local_storage", errorDescription);
+        Q_UNUSED(removeFile(newBlobFilePath))
         return false;
     }
 
-    if (Q_UNLIKELY(!resource.hasDataBody() && !resource.hasAlternateDataBody()))
-    {
+    ErrorString error;
+    if (!renameFile(newBlobFilePath, blobFilePath, error)) {
         errorDescription = errorPrefix;
-        errorDescription.appendBase(
-            QT_TR_NOOP("the resource has neither data body nor alternate data "
-                       "body set"));
-        QString displayName = resource.displayName();
-        if (!displayName.isEmpty()) {
-            errorDescription.details() = displayName + QStringLiteral(", ");
-        }
-        errorDescription.details() += QStringLiteral("resource local uid = ");
-        errorDescription.details() += resourceLocalUid;
-        QNWARNING(
-            "local_storage", errorDescription << ", resource: " << resource);
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        Q_UNUSED(removeFile(newBlobFilePath))
         return false;
     }
 
-    bool shouldReplaceOriginalFile =
-        (!resource.hasDataBody() || !resource.hasAlternateDataBody());
+    res = query.prepare(QStringLiteral(
+        "INSERT OR IGNORE INTO ResourceBlobs (blobHash, refCount) "
+        "VALUES(:blobHash, 0)"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    if (resource.hasDataBody()) {
-        ErrorString error;
-        bool res = writeResourceBinaryDataToFile(
-            resourceLocalUid, resource.noteLocalUid(), resource.dataBody(),
-            /* is alternate data body = */ false, shouldReplaceOriginalFile,
-            error);
+    query.bindValue(QStringLiteral(":blobHash"), blobHash);
 
-        if (!res) {
-            errorDescription = errorPrefix;
-            errorDescription.appendBase(error.base());
-            errorDescription.appendBase(error.additionalBases());
-            errorDescription.details() = error.details();
-            return false;
-        }
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::setResourceBlobReference(
+    const QString & resourceLocalUid, const bool isAlternateDataBody,
+    const QString & blobHash, ErrorString & errorDescription)
+{
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to set the reference to resource data blob"));
+
+    // NOTE: not using INSERT OR REPLACE here because the deletion of
+    // the replaced row doesn't fire the trigger maintaining blob's reference
+    // count
+    ErrorString error;
+    if (!removeResourceBlobReference(
+            resourceLocalUid, isAlternateDataBody, error))
+    {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        return false;
     }
 
-    if (resource.hasAlternateDataBody()) {
-        ErrorString error;
-        bool res = writeResourceBinaryDataToFile(
-            resourceLocalUid, resource.noteLocalUid(),
-            resource.alternateDataBody(),
-            /* is alternate data body = */ true, shouldReplaceOriginalFile,
-            error);
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.prepare(QStringLiteral(
+        "INSERT INTO ResourceBlobReferences "
+        "(resourceLocalUid, isAlternateData, blobHash) "
+        "VALUES(:resourceLocalUid, :isAlternateData, :blobHash)"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-        if (!res) {
-            errorDescription = errorPrefix;
-            errorDescription.appendBase(error.base());
-            errorDescription.appendBase(error.additionalBases());
-            errorDescription.details() = error.details();
-            return false;
-        }
+    query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+
+    query.bindValue(
+        QStringLiteral(":isAlternateData"), (isAlternateDataBody ? 1 : 0));
+
+    query.bindValue(QStringLiteral(":blobHash"), blobHash);
+
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::removeResourceBlobReference(
+    const QString & resourceLocalUid, const bool isAlternateDataBody,
+    ErrorString & errorDescription)
+{
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to remove the reference to resource data blob"));
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.prepare(QStringLiteral(
+        "DELETE FROM ResourceBlobReferences "
+        "WHERE resourceLocalUid = :resourceLocalUid "
+        "AND isAlternateData = :isAlternateData"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+
+    query.bindValue(
+        QStringLiteral(":isAlternateData"), (isAlternateDataBody ? 1 : 0));
+
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    return true;
+}
+
+bool LocalStorageManagerPrivate::findResourceBlobHash(
+    const QString & resourceLocalUid, const bool isAlternateDataBody,
+    QString & blobHash, ErrorString & errorDescription) const
+{
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to find the resource data blob"));
+
+    bool res = checkAndPrepareGetResourceBlobHashQuery();
+    QSqlQuery & query = m_getResourceBlobHashQuery;
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+
+    query.bindValue(
+        QStringLiteral(":isAlternateData"), (isAlternateDataBody ? 1 : 0));
+
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    if (!query.next()) {
+        blobHash.clear();
+        return true;
     }
 
-    if (shouldReplaceOriginalFile) {
+    blobHash = query.value(0).toString();
+    return true;
+}
+
+bool LocalStorageManagerPrivate::checkAndPrepareGetResourceBlobHashQuery() const
+{
+    if (Q_LIKELY(m_getResourceBlobHashQueryPrepared)) {
         return true;
     }
 
-    // New data files were written for both data body and alternate data
-    // body, now need to replace the old ones with the new ones
+    QNDEBUG(
+        "local_storage",
+        "Preparing SQL query to get the hash of resource data blob");
 
-    QString storagePath = accountPersistentStoragePath(m_currentAccount);
+    m_getResourceBlobHashQuery = QSqlQuery(m_sqlDatabase);
 
-    /**
-     * Tricky algorithm tolerant to crashes anywhere during the process:
-     * 1) if alternate data file exists, move it to the file with additional
-     *    ".old" suffix
-     * 2) rename/move the alternate data file with ".new" suffix to the file
-     *    without that suffix
-     * 3) rename/move the data file with ".new" suffix to the file without
-     *    that suffix (i.e. replace the old file with the new one)
-     * 4) remove the alternate data file with additional ".old" suffix if it
-     *    exists
-     *
-     * Each of these actions is atomic. If alternate data file existed and the
-     * process crashed after 1 but before 2, 3 and 4 the logic reading
-     * the alternate data from file would handle the case of nonexisting file
-     * with existing file with additional ".old" suffix. If the process crashed
-     * after 2 but before 3 and 4, it is still possible to recover because
-     * the situation is unambiguous - the alternate data file with ".old"
-     * extension should not exist unless something went wrong. The logic reading
-     * the alternate data from file would handle it. Same goes for the case of
-     * crash after 3 but before 4 - it is only different by the existence of
-     * two data body files - the "usual" one and the one with ".new" suffix.
-     */
+    bool res = m_getResourceBlobHashQuery.prepare(QStringLiteral(
+        "SELECT blobHash FROM ResourceBlobReferences "
+        "WHERE resourceLocalUid = :resourceLocalUid "
+        "AND isAlternateData = :isAlternateData"));
 
-    QString alternateDataStoragePath = storagePath +
-        QStringLiteral("/Resources/alternateData/") + resource.noteLocalUid() +
-        QStringLiteral("/") + resourceLocalUid + QStringLiteral(".dat");
+    if (res) {
+        m_getResourceBlobHashQueryPrepared = true;
+    }
 
-    QString oldFileName = alternateDataStoragePath;
+    return res;
+}
 
-    QFileInfo oldAlternateDataFileInfo(oldFileName);
-    if (oldAlternateDataFileInfo.exists() && oldAlternateDataFileInfo.isFile())
+bool LocalStorageManagerPrivate::removeOrphanResourceBlobs(
+    ErrorString & errorDescription)
+{
+    // The removal of blob files can't be rolled back so it is postponed
+    // until the outermost transaction is committed; it is also postponed
+    // while a snapshot of the database is being taken as the snapshot might
+    // reference the blobs
+    if ((m_transactionNestingLevel > 0) ||
+        snapshotInProgress(m_databaseFilePath))
     {
-        QString oldFileBackupName =
-            alternateDataStoragePath + QStringLiteral(".old");
-
-        ErrorString error;
-        bool res = renameFile(oldFileName, oldFileBackupName, error);
-        if (!res) {
-            errorDescription.setBase(
-                QT_TR_NOOP("failed to atomically backup old resource alternate "
-                           "data file"));
-            errorDescription.appendBase(error.base());
-            errorDescription.appendBase(error.additionalBases());
-            errorDescription.details() = error.details();
-            QNWARNING("local_storage", errorDescription);
-            return false;
-        }
+        m_hasPendingOrphanResourceBlobs = true;
+        return true;
     }
 
-    QString newFileName = oldFileName + QStringLiteral(".new");
+    m_hasPendingOrphanResourceBlobs = false;
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to remove orphan resource data blobs"));
+
+    QString queryString = QStringLiteral(
+        "SELECT blobHash FROM ResourceBlobs WHERE refCount <= 0");
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = execQuery(query, queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    QStringList orphanBlobHashes;
+    while (query.next()) {
+        orphanBlobHashes << query.value(0).toString();
+    }
 
-    ErrorString error;
-    bool res = renameFile(newFileName, oldFileName, error);
-    if (!res) {
-        errorDescription.setBase(
-            QT_TR_NOOP("failed to atomically replace old alternate data "
-                       "resource file with the new one"));
-        errorDescription.appendBase(error.base());
-        errorDescription.appendBase(error.additionalBases());
-        errorDescription.details() = error.details();
-        QNWARNING("local_storage", errorDescription);
-        return false;
+    if (orphanBlobHashes.isEmpty()) {
+        return true;
     }
 
-    QString dataStoragePath = storagePath + QStringLiteral("/Resources/data/") +
-        resource.noteLocalUid() + QStringLiteral("/") + resourceLocalUid +
-        QStringLiteral(".dat");
+    QNDEBUG(
+        "local_storage",
+        "Removing " << orphanBlobHashes.size()
+                    << " orphan resource data blobs");
 
-    oldFileName = dataStoragePath;
-    newFileName = oldFileName + QStringLiteral(".new");
+    res = query.prepare(QStringLiteral(
+        "DELETE FROM ResourceBlobs WHERE blobHash = :blobHash "
+        "AND refCount <= 0"));
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    res = renameFile(newFileName, oldFileName, error);
-    if (!res) {
-        errorDescription.setBase(
-            QT_TR_NOOP("failed to atomically replace old resource file with "
-                       "the new one"));
-        errorDescription.appendBase(error.base());
-        errorDescription.appendBase(error.additionalBases());
-        errorDescription.details() = error.details();
-        QNWARNING("local_storage", errorDescription);
-        return false;
-    }
+    for (const auto & blobHash: qAsConst(orphanBlobHashes)) {
+        // NOTE: the file is removed before the row so that a crash in between
+        // leaves the row which would be collected on the next attempt
+        QString blobFilePath = resourceBlobFilePath(blobHash);
+        QFileInfo blobFileInfo(blobFilePath);
+        if (blobFileInfo.exists() && !removeFile(blobFilePath)) {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(
+                QT_TR_NOOP("failed to remove resource data blob file"));
+            errorDescription.details() = blobFilePath;
+            QNWARNING("local_storage", errorDescription);
+            return false;
+        }
 
-    QFileInfo backupAlternateDataFileInfo(
-        alternateDataStoragePath + QStringLiteral(".old"));
-    if (backupAlternateDataFileInfo.exists() &&
-        backupAlternateDataFileInfo.isFile() &&
-        !removeFile(backupAlternateDataFileInfo.absoluteFilePath()))
-    {
-        errorDescription.setBase(
-            QT_TR_NOOP("failed to remove backup alternate data file"));
-        errorDescription.details() +=
-            backupAlternateDataFileInfo.absoluteFilePath();
-        QNWARNING("local_storage", errorDescription);
-        return false;
+        query.bindValue(QStringLiteral(":blobHash"), blobHash);
+
+        res = execQuery(query);
+        DATABASE_CHECK_AND_SET_ERROR()
     }
 
     return true;
 }
 
-bool LocalStorageManagerPrivate::writeResourceBinaryDataToFile(
-    const QString & resourceLocalUid, const QString & noteLocalUid,
-    const QByteArray & dataBody, const bool isAlternateDataBody,
-    const bool replaceOriginalFile, ErrorString & errorDescription)
+bool LocalStorageManagerPrivate::removeUnreferencedResourceBlobFiles(
+    ErrorString & errorDescription)
 {
     QNDEBUG(
         "local_storage",
-        "LocalStorageManagerPrivate::writeResourceBinaryDataToFile: "
-            << "resource local uid = " << resourceLocalUid
-            << ", note local uid = " << noteLocalUid << ", writing"
-            << (isAlternateDataBody ? " alternate" : "")
-            << " data body; replace original file = "
-            << (replaceOriginalFile ? "true" : "false"));
+        "LocalStorageManagerPrivate::removeUnreferencedResourceBlobFiles");
 
-    QString storagePath = accountPersistentStoragePath(m_currentAccount);
-    if (isAlternateDataBody) {
-        storagePath += QStringLiteral("/Resources/alternateData/");
-    }
-    else {
-        storagePath += QStringLiteral("/Resources/data/");
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to remove unreferenced resource data blob files"));
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res =
+        execQuery(query, QStringLiteral("SELECT blobHash FROM ResourceBlobs"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    QSet<QString> blobHashes;
+    while (query.next()) {
+        blobHashes.insert(query.value(0).toString());
     }
 
-    storagePath += noteLocalUid;
+    // Blob files might be left without rows in the database if the transaction
+    // within which they were written was rolled back or if the process crashed
+    // right after writing them
+    QString blobsPath = accountPersistentStoragePath(m_currentAccount) +
+        QStringLiteral("/Resources/blobs");
 
-    QDir storageDir(storagePath);
-    if (!storageDir.exists()) {
-        bool res = storageDir.mkpath(storagePath);
-        if (!res) {
-            errorDescription.setBase(
-                QT_TR_NOOP("failed to create directory for resource data file "
-                           "storage"));
-            errorDescription.details() = storagePath;
+    QDirIterator it(
+        blobsPath, QDir::Files | QDir::NoDotAndDotDot,
+        QDirIterator::Subdirectories);
+
+    while (it.hasNext()) {
+        QString filePath = it.next();
+        QFileInfo fileInfo = it.fileInfo();
+        if ((fileInfo.suffix() == QStringLiteral("dat")) &&
+            blobHashes.contains(fileInfo.completeBaseName()))
+        {
+            continue;
+        }
+
+        QNDEBUG(
+            "local_storage",
+            "Removing unreferenced resource data blob file: " << filePath);
+
+        if (!removeFile(filePath)) {
+            errorDescription = errorPrefix;
+            errorDescription.details() = filePath;
             QNWARNING("local_storage", errorDescription);
             return false;
         }
     }
 
-    // NOTE: for crash recovery pusposes new data gets written to a new file
-    // which will then replace the old file
-    QFile resourceDataFile(
-        storagePath + QStringLiteral("/") + resourceLocalUid +
-        QStringLiteral(".dat.new"));
-
-    if (!resourceDataFile.open(QIODevice::WriteOnly)) {
-        errorDescription.setBase(
-            QT_TR_NOOP("failed to open resource data file for writing"));
-        errorDescription.details() = resourceDataFile.fileName();
-        QNWARNING("local_storage", errorDescription);
-        return false;
-    }
+    return true;
+}
 
-    qint64 dataSize = dataBody.size();
-    qint64 bytesWritten = resourceDataFile.write(dataBody);
-    if (bytesWritten < 0) {
-        errorDescription.setBase(
-            QT_TR_NOOP("failed to write resource data to file"));
-        errorDescription.details() = resourceDataFile.fileName();
-        QNWARNING("local_storage", errorDescription);
+bool LocalStorageManagerPrivate::collectResourceBlobsGarbage(
+    ErrorString & errorDescription)
+{
+    int version = localStorageVersion(errorDescription);
+    if (Q_UNLIKELY(version < 0)) {
         return false;
     }
 
-    if (bytesWritten < dataSize) {
-        errorDescription.setBase(
-            QT_TR_NOOP("failed to write the whole resource data to file"));
-        errorDescription.details() = resourceDataFile.fileName();
-        QNWARNING("local_storage", errorDescription);
-        return false;
+    if (version < 4) {
+        return true;
     }
 
-    if (!resourceDataFile.flush()) {
-        errorDescription.setBase(QT_TR_NOOP(
-            "failed to flush file after writing resource data to it"));
-        errorDescription.details() = resourceDataFile.fileName();
-        QNWARNING("local_storage", errorDescription);
+    if (!removeOrphanResourceBlobs(errorDescription)) {
         return false;
     }
 
-    // NOTE: this seems to be required for the subsequent call
-    // to rename to work on Windows
-    resourceDataFile.close();
-
-    if (replaceOriginalFile) {
-        QString oldFileName = storagePath + QStringLiteral("/") +
-            resourceLocalUid + QStringLiteral(".dat");
-
-        QString newFileName = oldFileName + QStringLiteral(".new");
-
-        ErrorString error;
-        bool res = renameFile(newFileName, oldFileName, error);
-        if (!res) {
-            errorDescription.setBase(
-                QT_TR_NOOP("failed to atomically replace old resource file "
-                           "with the new one"));
-            errorDescription.appendBase(error.base());
-            errorDescription.appendBase(error.additionalBases());
-            errorDescription.details() = error.details();
-            QNWARNING("local_storage", errorDescription);
-            return false;
-        }
-    }
-
-    return true;
+    return removeUnreferencedResourceBlobFiles(errorDescription);
 }
 
 bool LocalStorageManagerPrivate::insertOrReplaceResourceAttributes(
@@ -9759,7 +13330,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceResourceAttributes(
                  ? (attributes.attachment.ref() ? 1 : 0)
                  : nullValue));
 
-        res = query.exec();
+        res = execQuery(query);
         DATABASE_CHECK_AND_SET_ERROR()
     }
 
@@ -9781,7 +13352,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceResourceAttributes(
             const auto & keysOnly = attributes.applicationData->keysOnly.ref();
             for (const auto & key: keysOnly) {
                 query.bindValue(QStringLiteral(":resourceKey"), key);
-                res = query.exec();
+                res = execQuery(query);
                 DATABASE_CHECK_AND_SET_ERROR()
             }
         }
@@ -9801,7 +13372,7 @@ bool LocalStorageManagerPrivate::insertOrReplaceResourceAttributes(
             for (const auto it: qevercloud::toRange(fullMap)) {
                 query.bindValue(QStringLiteral(":resourceMapKey"), it.key());
                 query.bindValue(QStringLiteral(":resourceValue"), it.value());
-                res = query.exec();
+                res = execQuery(query);
                 DATABASE_CHECK_AND_SET_ERROR()
             }
         }
@@ -9899,304 +13470,63 @@ bool LocalStorageManagerPrivate::insertOrReplaceResourceMetadata(
                                              : nullValue));
 
         query.bindValue(
-            QStringLiteral(":alternateDataHash"),
-            (resource.hasAlternateDataHash() ? resource.alternateDataHash()
-                                             : nullValue));
-    }
-
-    res = query.exec();
-    DATABASE_CHECK_AND_SET_ERROR()
-
-    return true;
-}
-
-bool LocalStorageManagerPrivate::updateNoteResources(
-    const Resource & resource, ErrorString & errorDescription)
-{
-    QNDEBUG("local_storage", "LocalStorageManagerPrivate::updateNoteResources");
-
-    ErrorString errorPrefix(
-        QT_TR_NOOP("can't insert or replace resource: failed to update "
-                   "note-resource interconnections"));
-
-    QVariant nullValue;
-    bool res = checkAndPrepareInsertOrReplaceNoteResourceQuery();
-    QSqlQuery & query = m_insertOrReplaceNoteResourceQuery;
-    DATABASE_CHECK_AND_SET_ERROR()
-
-    query.bindValue(QStringLiteral(":localNote"), resource.noteLocalUid());
-
-    query.bindValue(
-        QStringLiteral(":note"),
-        (resource.hasNoteGuid() ? resource.noteGuid() : nullValue));
-
-    query.bindValue(QStringLiteral(":localResource"), resource.localUid());
-
-    query.bindValue(
-        QStringLiteral(":resource"),
-        (resource.hasGuid() ? resource.guid() : nullValue));
-
-    res = query.exec();
-    DATABASE_CHECK_AND_SET_ERROR()
-
-    return true;
-}
-
-void LocalStorageManagerPrivate::setNoteIdsToNoteResources(Note & note) const
-{
-    if (!note.hasResources()) {
-        return;
-    }
-
-    auto resources = note.resources();
-    for (auto & resource: resources) {
-        resource.setNoteLocalUid(note.localUid());
-        if (note.hasGuid()) {
-            resource.setNoteGuid(note.guid());
-        }
-    }
-    note.setResources(resources);
-}
-
-bool LocalStorageManagerPrivate::removeResourceDataFiles(
-    const Resource & resource, ErrorString & errorDescription)
-{
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::removeResourceDataFiles: "
-            << "resource local uid = " << resource.localUid()
-            << ", note local uid = "
-            << (resource.hasNoteLocalUid() ? resource.noteLocalUid()
-                                           : QStringLiteral("<not set>")));
-
-    if (Q_UNLIKELY(!resource.hasNoteLocalUid())) {
-        errorDescription.setBase(
-            QT_TR_NOOP("the resource has no note local uid set"));
-
-        QString displayName = resource.displayName();
-        if (!displayName.isEmpty()) {
-            errorDescription.details() = displayName + QStringLiteral(", ");
-        }
-
-        errorDescription.details() += QStringLiteral("resource local uid = ");
-        errorDescription.details() += resource.localUid();
-        QNWARNING("local_storage", errorDescription);
-        return false;
-    }
-
-    const QString & noteLocalUid = resource.noteLocalUid();
-    QString storagePath = accountPersistentStoragePath(m_currentAccount);
-
-    QFile resourceDataFile(
-        storagePath + QStringLiteral("/Resources/data/") + noteLocalUid +
-        QStringLiteral("/") + resource.localUid() + QStringLiteral(".dat"));
-
-    if (resourceDataFile.exists()) {
-        bool res = resourceDataFile.remove();
-        if (Q_UNLIKELY(!res)) {
-            // Double-check, QFile::remove is known to not return
-            // proper return code sometimes
-            QFileInfo resourceDataFileInfo(resourceDataFile.fileName());
-            if (resourceDataFileInfo.exists()) {
-                errorDescription.setBase(
-                    QT_TR_NOOP("failed to delete resource data file"));
-
-                QString displayName = resource.displayName();
-                if (!displayName.isEmpty()) {
-                    errorDescription.details() =
-                        displayName + QStringLiteral(", ");
-                }
-
-                errorDescription.details() +=
-                    QStringLiteral("resource local uid = ");
-
-                errorDescription.details() += resource.localUid();
-                QNWARNING("local_storage", errorDescription);
-                return false;
-            }
-        }
-    }
-
-    QFile resourceAlternateDataFile(
-        storagePath + QStringLiteral("/Resources/alternateData/") +
-        noteLocalUid + QStringLiteral("/") + resource.localUid() +
-        QStringLiteral(".dat"));
-
-    if (resourceAlternateDataFile.exists()) {
-        bool res = resourceAlternateDataFile.remove();
-        if (Q_UNLIKELY(!res)) {
-            // Double-check, QFile::remove is known to not return
-            // proper return code sometimes
-            QFileInfo resourceAlternateDataFileInfo(
-                resourceAlternateDataFile.fileName());
-
-            if (resourceAlternateDataFileInfo.exists()) {
-                errorDescription.setBase(QT_TR_NOOP(
-                    "failed to delete resource alternate data file"));
-
-                QString displayName = resource.displayName();
-                if (!displayName.isEmpty()) {
-                    errorDescription.details() =
-                        displayName + QStringLiteral(", ");
-                }
-
-                errorDescription.details() +=
-                    QStringLiteral("resource local uid = ");
-
-                errorDescription.details() += resource.localUid();
-                QNWARNING("local_storage", errorDescription);
-                return false;
-            }
-        }
-    }
-
-    return true;
-}
-
-bool LocalStorageManagerPrivate::removeResourceDataFilesForNote(
-    const QString & noteLocalUid, ErrorString & errorDescription)
-{
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::removeResourceDataFilesForNote: "
-            << "note local uid = " << noteLocalUid);
-
-    QString accountPath = accountPersistentStoragePath(m_currentAccount);
-
-    QString dataPath =
-        accountPath + QStringLiteral("/Resources/data/") + noteLocalUid;
-
-    if (!removeDir(dataPath)) {
-        errorDescription.setBase(
-            QT_TR_NOOP("failed to remove the folder containing "
-                       "note's resource data bodies"));
-        errorDescription.details() = dataPath;
-        QNWARNING("local_storage", errorDescription);
-        return false;
-    }
-
-    QString alternateDataPath = accountPath +
-        QStringLiteral("/Resources/alternateData/") + noteLocalUid;
-
-    if (!removeDir(alternateDataPath)) {
-        errorDescription.setBase(
-            QT_TR_NOOP("failed to remove the folder containing "
-                       "note's resource alternate data bodies"));
-        errorDescription.details() = alternateDataPath;
-        QNWARNING("local_storage", errorDescription);
-        return false;
-    }
-
-    return true;
-}
-
-bool LocalStorageManagerPrivate::removeResourceDataFilesForNotebook(
-    const Notebook & notebook, ErrorString & errorDescription)
-{
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::removeResourceDataFilesForNotebook: "
-            << "notebook = " << notebook);
-
-    ErrorString errorPrefix(
-        QT_TR_NOOP("failed to remove resource data files for notebook: cannot "
-                   "list note local uids per notebook"));
-
-    QString column, uid;
-    if (notebook.hasGuid()) {
-        column = QStringLiteral("notebookGuid");
-        uid = notebook.guid();
-    }
-    else {
-        column = QStringLiteral("notebookLocalUid");
-        uid = notebook.localUid();
-    }
-
-    uid = sqlEscapeString(uid);
-
-    QString queryString =
-        QString::fromUtf8("SELECT localUid FROM Notes WHERE %1 = '%2'")
-            .arg(column, uid);
-
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
-
-    QStringList noteLocalUids;
-    noteLocalUids.reserve(std::max(query.size(), 0));
-
-    ErrorString error;
-    while (query.next()) {
-        QString noteLocalUid = query.value(0).toString();
-
-        error.clear();
-        if (!removeResourceDataFilesForNote(noteLocalUid, error)) {
-            errorDescription.setBase(QT_TR_NOOP(
-                "failed to remove resource data files for notebook"));
-
-            errorDescription.appendBase(error.base());
-            errorDescription.appendBase(error.additionalBases());
-            errorDescription.details() = error.details();
-            return false;
-        }
+            QStringLiteral(":alternateDataHash"),
+            (resource.hasAlternateDataHash() ? resource.alternateDataHash()
+                                             : nullValue));
     }
 
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
+
     return true;
 }
 
-bool LocalStorageManagerPrivate::removeResourceDataFilesForLinkedNotebook(
-    const LinkedNotebook & linkedNotebook, ErrorString & errorDescription)
+bool LocalStorageManagerPrivate::updateNoteResources(
+    const Resource & resource, ErrorString & errorDescription)
 {
-    QNDEBUG(
-        "local_storage",
-        "LocalStorageManagerPrivate::removeResourceDataFilesForLinkedNotebook: "
-            << "linked notebook = " << linkedNotebook);
+    QNDEBUG("local_storage", "LocalStorageManagerPrivate::updateNoteResources");
 
     ErrorString errorPrefix(
-        QT_TR_NOOP("failed to remove resource data files for linked notebook: "
-                   "cannot list note local uids per linked notebook"));
+        QT_TR_NOOP("can't insert or replace resource: failed to update "
+                   "note-resource interconnections"));
 
-    if (Q_UNLIKELY(!linkedNotebook.hasGuid())) {
-        errorDescription.setBase(
-            QT_TR_NOOP("failed to remove resource data files for linked "
-                       "notebook: linked notebook has no guid set"));
-        QNWARNING(
-            "local_storage",
-            errorDescription << ", linked notebook: " << linkedNotebook);
-        return false;
-    }
+    QVariant nullValue;
+    bool res = checkAndPrepareInsertOrReplaceNoteResourceQuery();
+    QSqlQuery & query = m_insertOrReplaceNoteResourceQuery;
+    DATABASE_CHECK_AND_SET_ERROR()
 
-    QString queryString =
-        QString::fromUtf8(
-            "SELECT localUid FROM Notes WHERE notebookLocalUid IN "
-            "(SELECT localUid FROM Notebooks WHERE "
-            "linkedNotebookGuid = '%1')")
-            .arg(sqlEscapeString(linkedNotebook.guid()));
+    query.bindValue(QStringLiteral(":localNote"), resource.noteLocalUid());
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+    query.bindValue(
+        QStringLiteral(":note"),
+        (resource.hasNoteGuid() ? resource.noteGuid() : nullValue));
 
-    QStringList noteLocalUids;
-    noteLocalUids.reserve(std::max(query.size(), 0));
+    query.bindValue(QStringLiteral(":localResource"), resource.localUid());
 
-    ErrorString error;
-    while (query.next()) {
-        QString noteLocalUid = query.value(0).toString();
+    query.bindValue(
+        QStringLiteral(":resource"),
+        (resource.hasGuid() ? resource.guid() : nullValue));
 
-        error.clear();
-        if (!removeResourceDataFilesForNote(noteLocalUid, error)) {
-            errorDescription.setBase(QT_TR_NOOP(
-                "failed to remove resource data files for notebook"));
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
 
-            errorDescription.appendBase(error.base());
-            errorDescription.appendBase(error.additionalBases());
-            errorDescription.details() = error.details();
-            return false;
-        }
+    return true;
+}
+
+void LocalStorageManagerPrivate::setNoteIdsToNoteResources(Note & note) const
+{
+    if (!note.hasResources()) {
+        return;
     }
 
-    return true;
+    auto resources = note.resources();
+    for (auto & resource: resources) {
+        resource.setNoteLocalUid(note.localUid());
+        if (note.hasGuid()) {
+            resource.setNoteGuid(note.guid());
+        }
+    }
+    note.setResources(resources);
 }
 
 bool LocalStorageManagerPrivate::
@@ -10656,8 +13986,13 @@ bool LocalStorageManagerPrivate::insertOrReplaceSavedSearch(
     query.bindValue(
         QStringLiteral(":isFavorited"), (search.isFavorited() ? 1 : 0));
 
-    res = query.exec();
+    res = execQuery(query);
     DATABASE_CHECK_AND_SET_ERROR()
+
+    m_guidLocalUidIndex.insert(
+        GuidLocalUidIndex::ObjectType::SavedSearch,
+        (search.hasGuid() ? search.guid() : QString()), search.localUid());
+
     return true;
 }
 
@@ -10745,7 +14080,7 @@ bool LocalStorageManagerPrivate::complementTagsWithNoteLocalUids(
     queryString += QStringLiteral(")");
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     QMap<QString, QSet<QString>> noteLocalUidsByTagLocalUid;
@@ -10797,15 +14132,21 @@ bool LocalStorageManagerPrivate::complementTagsWithNoteLocalUids(
 }
 
 bool LocalStorageManagerPrivate::readResourceDataFromFiles(
-    Resource & resource, ErrorString & errorDescription) const
+    Resource & resource, const GetResourceOptions options,
+    ErrorString & errorDescription) const
 {
+    const bool mapFiles = (options & GetResourceOption::MapBinaryData);
+    const bool lazyLoad = (options & GetResourceOption::LazyBinaryData);
+
     QNDEBUG(
         "local_storage",
         "LocalStorageManagerPrivate::readResourceDataFromFiles: "
             << "resource local uid = " << resource.localUid()
             << ", note local uid = "
             << (resource.hasNoteLocalUid() ? resource.noteLocalUid()
-                                           : QStringLiteral("<not set>")));
+                                           : QStringLiteral("<not set>"))
+            << ", map files = " << (mapFiles ? "true" : "false")
+            << ", lazy load = " << (lazyLoad ? "true" : "false"));
 
     if (Q_UNLIKELY(!resource.hasNoteLocalUid())) {
         errorDescription.setBase(
@@ -10824,10 +14165,19 @@ bool LocalStorageManagerPrivate::readResourceDataFromFiles(
 
     if (resource.hasData()) {
         QByteArray dataBody;
+        std::shared_ptr<const void> dataBodyOwner;
+        QString filePath;
         ErrorString error;
-        auto status = readResourceBinaryDataFromFile(
-            resource.localUid(), resource.noteLocalUid(),
-            /* is alternate data body = */ false, dataBody, error);
+
+        auto status =
+            (lazyLoad ? findResourceBinaryDataFilePath(
+                            resource.localUid(),
+                            /* is alternate data body = */ false, filePath,
+                            error)
+                      : readResourceBinaryDataFromFile(
+                            resource.localUid(),
+                            /* is alternate data body = */ false, mapFiles,
+                            dataBody, dataBodyOwner, error));
 
         if (status != ReadResourceBinaryDataFromFileStatus::Success) {
             if (status == ReadResourceBinaryDataFromFileStatus::FileNotFound) {
@@ -10851,16 +14201,29 @@ bool LocalStorageManagerPrivate::readResourceDataFromFiles(
             return false;
         }
 
-        resource.setDataBody(dataBody);
+        if (lazyLoad) {
+            resource.setLazyDataBody(filePath);
+        }
+        else {
+            resource.setDataBody(dataBody, std::move(dataBodyOwner));
+        }
     }
 
     if (resource.hasAlternateData()) {
         QByteArray alternateDataBody;
+        std::shared_ptr<const void> alternateDataBodyOwner;
+        QString filePath;
         ErrorString error;
 
-        auto status = readResourceBinaryDataFromFile(
-            resource.localUid(), resource.noteLocalUid(),
-            /* is alternate data body = */ true, alternateDataBody, error);
+        auto status =
+            (lazyLoad ? findResourceBinaryDataFilePath(
+                            resource.localUid(),
+                            /* is alternate data body = */ true, filePath,
+                            error)
+                      : readResourceBinaryDataFromFile(
+                            resource.localUid(),
+                            /* is alternate data body = */ true, mapFiles,
+                            alternateDataBody, alternateDataBodyOwner, error));
 
         if (status != ReadResourceBinaryDataFromFileStatus::Success) {
             if (status == ReadResourceBinaryDataFromFileStatus::FileNotFound) {
@@ -10884,7 +14247,13 @@ bool LocalStorageManagerPrivate::readResourceDataFromFiles(
             return false;
         }
 
-        resource.setAlternateDataBody(alternateDataBody);
+        if (lazyLoad) {
+            resource.setLazyAlternateDataBody(filePath);
+        }
+        else {
+            resource.setAlternateDataBody(
+                alternateDataBody, std::move(alternateDataBodyOwner));
+        }
     }
 
     return true;
@@ -10892,161 +14261,68 @@ bool LocalStorageManagerPrivate::readResourceDataFromFiles(
 
 LocalStorageManagerPrivate::ReadResourceBinaryDataFromFileStatus
 LocalStorageManagerPrivate::readResourceBinaryDataFromFile(
-    const QString & resourceLocalUid, const QString & noteLocalUid,
-    const bool isAlternateDataBody, QByteArray & dataBody,
+    const QString & resourceLocalUid, const bool isAlternateDataBody,
+    const bool mapFile, QByteArray & dataBody,
+    std::shared_ptr<const void> & dataBodyOwner,
     ErrorString & errorDescription) const
 {
     QNDEBUG(
         "local_storage",
         "LocalStorageManagerPrivate::readResourceBinaryDataFromFile: "
-            << "resource local uid = " << resourceLocalUid
-            << ", note local uid = " << noteLocalUid << ", reading "
-            << (isAlternateDataBody ? "alternate" : "") << " data body");
+            << "resource local uid = " << resourceLocalUid << ", reading "
+            << (isAlternateDataBody ? "alternate" : "") << " data body"
+            << (mapFile ? ", mapping the file" : ""));
 
-    QString storagePath = accountPersistentStoragePath(m_currentAccount);
-    if (isAlternateDataBody) {
-        storagePath += QStringLiteral("/Resources/alternateData/");
-    }
-    else {
-        storagePath += QStringLiteral("/Resources/data/");
-    }
+    QString storagePath;
+    auto status = findResourceBinaryDataFilePath(
+        resourceLocalUid, isAlternateDataBody, storagePath, errorDescription);
 
-    storagePath += noteLocalUid + QStringLiteral("/") + resourceLocalUid +
-        QStringLiteral(".dat");
+    if (status != ReadResourceBinaryDataFromFileStatus::Success) {
+        return status;
+    }
 
     QFile resourceDataFile(storagePath);
 
     /**
-     * Below there's a specialized logic of crash recovery from unsuccessful
-     * attempt to update resource data body and alternate data body
-     * simultaneously, see writeResourceBinaryDataToFiles method implementation
-     * for more details
+     * NOTE: Windows doesn't allow removing or renaming a file while it is
+     * mapped; resource data files are removed once no longer referenced and
+     * replaced on resource updates while mapped data bodies might be kept
+     * around indefinitely so the files are always read on Windows
      */
-
-    if (!resourceDataFile.exists()) {
+#ifdef Q_OS_WIN
+    if (mapFile) {
         QNDEBUG(
             "local_storage",
-            "Resource data file doesn't exist: "
-                << QDir::toNativeSeparators(storagePath));
-
-        if (isAlternateDataBody) {
-            QFileInfo prevAlternateDataFileInfo(
-                storagePath + QStringLiteral(".old"));
-
-            if (prevAlternateDataFileInfo.exists() &&
-                prevAlternateDataFileInfo.isFile()) {
-                resourceDataFile.setFileName(
-                    prevAlternateDataFileInfo.absoluteFilePath());
-
-                QString prevAlternateDataFilePath = QDir::toNativeSeparators(
-                    prevAlternateDataFileInfo.absoluteFilePath());
-
-                QString newAlternateDataFilePath =
-                    QDir::toNativeSeparators(storagePath);
-
-                int res = rename(
-                    prevAlternateDataFilePath.toLocal8Bit().constData(),
-                    newAlternateDataFilePath.toLocal8Bit().constData());
-
-                if (res != 0) {
-                    QNWARNING(
-                        "local_storage",
-                        "Failed to recover the previous "
-                            << "alternate data file: "
-                            << prevAlternateDataFilePath << ": "
-                            << strerror(errno));
-                    return ReadResourceBinaryDataFromFileStatus::FileNotFound;
-                }
-
-                QNINFO(
-                    "local_storage",
-                    "Recovered alternate resource data "
-                        << "from file with \".old\" suffix: "
-                        << prevAlternateDataFilePath);
-                resourceDataFile.setFileName(storagePath);
-            }
-        }
-
-        if (!resourceDataFile.exists()) {
-            return ReadResourceBinaryDataFromFileStatus::FileNotFound;
-        }
+            "Resource data files are not mapped on Windows, reading the file "
+                << "instead");
     }
-    else if (isAlternateDataBody) {
-        QFileInfo prevAlternateDataFileInfo(
-            storagePath + QStringLiteral(".old"));
-
-        if (prevAlternateDataFileInfo.exists() &&
-            prevAlternateDataFileInfo.isFile()) {
-            QString resourceDataStoragePath =
-                accountPersistentStoragePath(m_currentAccount);
-
-            resourceDataStoragePath += QStringLiteral("/Resources/data/");
-            resourceDataStoragePath += noteLocalUid;
-            resourceDataStoragePath += QStringLiteral("/");
-            resourceDataStoragePath += resourceLocalUid;
-            resourceDataStoragePath += QStringLiteral(".dat");
-
-            QFileInfo newResourceDataFileInfo(
-                resourceDataStoragePath + QStringLiteral(".new"));
-
-            if (newResourceDataFileInfo.exists() &&
-                newResourceDataFileInfo.isFile()) {
-                QNDEBUG(
-                    "local_storage",
-                    "Old resource alternate data file "
-                        << "exists + resource data file with .new suffix "
-                           "exists "
-                        << "=> need to use old resource alternate data file");
-
-                resourceDataFile.setFileName(
-                    prevAlternateDataFileInfo.absoluteFilePath());
-
-                QString prevAlternateDataFilePath = QDir::toNativeSeparators(
-                    prevAlternateDataFileInfo.absoluteFilePath());
-
-                QString newAlternateDataFilePath =
-                    QDir::toNativeSeparators(storagePath);
-
-                int res = rename(
-                    prevAlternateDataFilePath.toLocal8Bit().constData(),
-                    newAlternateDataFilePath.toLocal8Bit().constData());
-
-                if (res != 0) {
-                    QNWARNING(
-                        "local_storage",
-                        "Failed to recover the previous "
-                            << "alternate data file: "
-                            << prevAlternateDataFilePath << ": "
-                            << strerror(errno));
-                    return ReadResourceBinaryDataFromFileStatus::FileNotFound;
-                }
-
-                Q_UNUSED(removeFile(newResourceDataFileInfo.absoluteFilePath()))
-
-                resourceDataFile.setFileName(storagePath);
-            }
-            else {
-                QNINFO(
-                    "local_storage",
-                    "Removing stale leftover resource "
-                        << "alternate data file: "
-                        << prevAlternateDataFileInfo.absoluteFilePath());
-
-                Q_UNUSED(
-                    removeFile(prevAlternateDataFileInfo.absoluteFilePath()));
+#else
+    if (mapFile && (resourceDataFile.size() >= MIN_MAPPED_RESOURCE_FILE_SIZE)) {
+        // The file has to stay open for the mapping to remain valid so it is
+        // owned by all the resources referring to the mapped data body
+        auto pMappedFile =
+            std::make_shared<QFile>(resourceDataFile.fileName());
+
+        if (pMappedFile->open(QIODevice::ReadOnly)) {
+            qint64 size = pMappedFile->size();
+            const uchar * pData = pMappedFile->map(0, size);
+            if (pData) {
+                dataBody = QByteArray::fromRawData(
+                    reinterpret_cast<const char *>(pData),
+                    static_cast<int>(size));
+
+                dataBodyOwner = std::move(pMappedFile);
+                return ReadResourceBinaryDataFromFileStatus::Success;
             }
         }
+
+        QNDEBUG(
+            "local_storage",
+            "Failed to map resource data file, will read it instead: "
+                << QDir::toNativeSeparators(storagePath) << ": "
+                << pMappedFile->errorString());
     }
-    else {
-        QFileInfo newDataFileInfo(storagePath + QStringLiteral(".new"));
-        if (newDataFileInfo.exists() && newDataFileInfo.isFile()) {
-            QNINFO(
-                "local_storage",
-                "Removing stale leftover resource data "
-                    << "file: " << newDataFileInfo.absoluteFilePath());
-            Q_UNUSED(removeFile(newDataFileInfo.absoluteFilePath()))
-        }
-    }
+#endif // Q_OS_WIN
 
     if (!resourceDataFile.open(QIODevice::ReadOnly)) {
         errorDescription.setBase(
@@ -11057,6 +14333,39 @@ LocalStorageManagerPrivate::readResourceBinaryDataFromFile(
     }
 
     dataBody = resourceDataFile.readAll();
+    dataBodyOwner.reset();
+    return ReadResourceBinaryDataFromFileStatus::Success;
+}
+
+LocalStorageManagerPrivate::ReadResourceBinaryDataFromFileStatus
+LocalStorageManagerPrivate::findResourceBinaryDataFilePath(
+    const QString & resourceLocalUid, const bool isAlternateDataBody,
+    QString & filePath, ErrorString & errorDescription) const
+{
+    QString blobHash;
+    if (!findResourceBlobHash(
+            resourceLocalUid, isAlternateDataBody, blobHash, errorDescription))
+    {
+        return ReadResourceBinaryDataFromFileStatus::Failure;
+    }
+
+    if (blobHash.isEmpty()) {
+        QNDEBUG(
+            "local_storage",
+            "No resource data blob is referenced by the resource");
+        return ReadResourceBinaryDataFromFileStatus::FileNotFound;
+    }
+
+    filePath = resourceBlobFilePath(blobHash);
+
+    if (!QFileInfo::exists(filePath)) {
+        QNDEBUG(
+            "local_storage",
+            "Resource data blob file doesn't exist: "
+                << QDir::toNativeSeparators(filePath));
+        return ReadResourceBinaryDataFromFileStatus::FileNotFound;
+    }
+
     return ReadResourceBinaryDataFromFileStatus::Success;
 }
 
@@ -12737,146 +16046,209 @@ QList<Tag> LocalStorageManagerPrivate::fillTagsFromSqlQuery(
 
 bool LocalStorageManagerPrivate::findAndSetTagIdsPerNote(
     Note & note, ErrorString & errorDescription) const
+{
+    NoteList notes;
+    notes << note;
+
+    if (!findAndSetTagIdsPerNotes(notes, errorDescription)) {
+        return false;
+    }
+
+    note = notes.at(0);
+    return true;
+}
+
+bool LocalStorageManagerPrivate::findAndSetTagIdsPerNotes(
+    NoteList & notes, ErrorString & errorDescription) const
 {
     ErrorString errorPrefix(
         QT_TR_NOOP("can't find tag guids/local uids per note"));
 
-    const QString noteLocalUid = note.localUid();
+    // Tag local uids and guids along with their indices within notes,
+    // per note local uid
+    QHash<QString, QList<std::pair<QString, int>>> tagLocalUidsPerNote;
+    QHash<QString, QList<std::pair<QString, int>>> tagGuidsPerNote;
 
-    QSqlQuery query(m_sqlDatabase);
-    query.prepare(
-        QStringLiteral("SELECT tag, localTag, tagIndexInNote FROM "
-                       "NoteTags WHERE localNote = ?"));
-    query.addBindValue(noteLocalUid);
+    QStringList noteLocalUids;
+    noteLocalUids.reserve(notes.size());
+    for (const auto & note: qAsConst(notes)) {
+        noteLocalUids << note.localUid();
+    }
 
-    bool res = query.exec();
-    DATABASE_CHECK_AND_SET_ERROR()
+    const int numNoteLocalUids = noteLocalUids.size();
+    for (int offset = 0; offset < numNoteLocalUids;
+         offset += MAX_SQL_QUERY_BOUND_VALUES)
+    {
+        const QStringList chunk =
+            noteLocalUids.mid(offset, MAX_SQL_QUERY_BOUND_VALUES);
 
-    QMultiHash<int, QString> tagGuidsAndIndices;
-    QMultiHash<int, QString> tagLocalUidsAndIndices;
+        QSqlQuery query(m_sqlDatabase);
+        query.prepare(
+            QStringLiteral("SELECT localNote, tag, localTag, tagIndexInNote "
+                           "FROM NoteTags WHERE localNote IN (") +
+            sqlQueryPlaceholders(chunk.size()) + QStringLiteral(")"));
 
-    while (query.next()) {
-        QSqlRecord rec = query.record();
+        for (const auto & noteLocalUid: chunk) {
+            query.addBindValue(noteLocalUid);
+        }
 
-        QString tagLocalUid;
-        QString tagGuid;
+        bool res = execQuery(query);
+        DATABASE_CHECK_AND_SET_ERROR()
 
-        bool tagLocalUidFound = false;
-        bool tagGuidFound = false;
+        while (query.next()) {
+            QSqlRecord rec = query.record();
 
-        int tagGuidIndex = rec.indexOf(QStringLiteral("tag"));
-        if (tagGuidIndex >= 0) {
-            QVariant value = rec.value(tagGuidIndex);
-            tagGuid = value.toString();
-            tagGuidFound = true;
-        }
+            QString noteLocalUid =
+                rec.value(QStringLiteral("localNote")).toString();
 
-        int tagLocalUidIndex = rec.indexOf(QStringLiteral("localTag"));
-        if (tagLocalUidIndex >= 0) {
-            QVariant value = rec.value(tagLocalUidIndex);
-            if (!value.isNull()) {
-                tagLocalUid = value.toString();
-                tagLocalUidFound = true;
+            QString tagLocalUid;
+            QString tagGuid;
+
+            bool tagLocalUidFound = false;
+            bool tagGuidFound = false;
+
+            int tagGuidIndex = rec.indexOf(QStringLiteral("tag"));
+            if (tagGuidIndex >= 0) {
+                QVariant value = rec.value(tagGuidIndex);
+                tagGuid = value.toString();
+                tagGuidFound = true;
             }
-        }
 
-        if (!tagLocalUidFound) {
-            errorDescription.base() = errorPrefix.base();
-            errorDescription.appendBase(
-                QT_TR_NOOP("no tag local uid in the result of SQL query"));
-            return false;
-        }
+            int tagLocalUidIndex = rec.indexOf(QStringLiteral("localTag"));
+            if (tagLocalUidIndex >= 0) {
+                QVariant value = rec.value(tagLocalUidIndex);
+                if (!value.isNull()) {
+                    tagLocalUid = value.toString();
+                    tagLocalUidFound = true;
+                }
+            }
 
-        if (!tagGuidFound) {
-            errorDescription.base() = errorPrefix.base();
-            errorDescription.appendBase(
-                QT_TR_NOOP("no tag guid in the result of SQL query"));
-            return false;
-        }
+            if (!tagLocalUidFound) {
+                errorDescription.base() = errorPrefix.base();
+                errorDescription.appendBase(
+                    QT_TR_NOOP("no tag local uid in the result of SQL query"));
+                return false;
+            }
 
-        if (!tagGuid.isEmpty() && !checkGuid(tagGuid)) {
-            errorDescription.base() = errorPrefix.base();
-            errorDescription.appendBase(
-                QT_TR_NOOP("found invalid tag guid for the requested note"));
-            return false;
-        }
+            if (!tagGuidFound) {
+                errorDescription.base() = errorPrefix.base();
+                errorDescription.appendBase(
+                    QT_TR_NOOP("no tag guid in the result of SQL query"));
+                return false;
+            }
 
-        QNTRACE(
-            "local_storage",
-            "Found tag local uid " << tagLocalUid << " and tag guid " << tagGuid
-                                   << " for note with local uid "
-                                   << noteLocalUid);
-
-        int indexInNote = -1;
-        int recordIndex = rec.indexOf(QStringLiteral("tagIndexInNote"));
-        if (recordIndex >= 0) {
-            QVariant value = rec.value(recordIndex);
-            if (!value.isNull()) {
-                bool conversionResult = false;
-                indexInNote = value.toInt(&conversionResult);
-                if (!conversionResult) {
-                    errorDescription.base() = errorPrefix.base();
-                    errorDescription.appendBase(
-                        QT_TR_NOOP("can't convert tag index in note to int"));
-                    return false;
+            if (!tagGuid.isEmpty() && !checkGuid(tagGuid)) {
+                errorDescription.base() = errorPrefix.base();
+                errorDescription.appendBase(QT_TR_NOOP(
+                    "found invalid tag guid for the requested note"));
+                return false;
+            }
+
+            QNTRACE(
+                "local_storage",
+                "Found tag local uid " << tagLocalUid << " and tag guid "
+                                       << tagGuid << " for note with local uid "
+                                       << noteLocalUid);
+
+            int indexInNote = -1;
+            int recordIndex = rec.indexOf(QStringLiteral("tagIndexInNote"));
+            if (recordIndex >= 0) {
+                QVariant value = rec.value(recordIndex);
+                if (!value.isNull()) {
+                    bool conversionResult = false;
+                    indexInNote = value.toInt(&conversionResult);
+                    if (!conversionResult) {
+                        errorDescription.base() = errorPrefix.base();
+                        errorDescription.appendBase(QT_TR_NOOP(
+                            "can't convert tag index in note to int"));
+                        return false;
+                    }
                 }
             }
-        }
 
-        tagLocalUidsAndIndices.insert(indexInNote, tagLocalUid);
+            tagLocalUidsPerNote[noteLocalUid] << std::make_pair(
+                tagLocalUid, indexInNote);
 
-        if (!tagGuid.isEmpty()) {
-            tagGuidsAndIndices.insert(indexInNote, tagGuid);
+            if (!tagGuid.isEmpty()) {
+                tagGuidsPerNote[noteLocalUid] << std::make_pair(
+                    tagGuid, indexInNote);
+            }
         }
     }
 
-    // Setting tag local uids
+    auto sortedUids = [](QList<std::pair<QString, int>> uidIndexPairs) {
+        std::sort(
+            uidIndexPairs.begin(), uidIndexPairs.end(),
+            QStringIntPairCompareByInt());
 
-    int numTagLocalUids = tagLocalUidsAndIndices.size();
-    QList<std::pair<QString, int>> tagLocalUidIndexPairs;
-    tagLocalUidIndexPairs.reserve(std::max(numTagLocalUids, 0));
-    for (const auto it: qevercloud::toRange(tagLocalUidsAndIndices)) {
-        tagLocalUidIndexPairs << std::make_pair(it.value(), it.key());
-    }
+        QStringList uids;
+        uids.reserve(uidIndexPairs.size());
+        for (const auto & pair: qAsConst(uidIndexPairs)) {
+            uids << pair.first;
+        }
 
-    std::sort(
-        tagLocalUidIndexPairs.begin(), tagLocalUidIndexPairs.end(),
-        QStringIntPairCompareByInt());
+        return uids;
+    };
 
-    QStringList tagLocalUids;
-    tagLocalUids.reserve(std::max(numTagLocalUids, 0));
-    for (int i = 0; i < numTagLocalUids; ++i) {
-        tagLocalUids << tagLocalUidIndexPairs[i].first;
+    for (auto & note: notes) {
+        const QString noteLocalUid = note.localUid();
+        note.setTagLocalUids(
+            sortedUids(tagLocalUidsPerNote.value(noteLocalUid)));
+        note.setTagGuids(sortedUids(tagGuidsPerNote.value(noteLocalUid)));
     }
 
-    note.setTagLocalUids(tagLocalUids);
+    return true;
+}
+
+bool LocalStorageManagerPrivate::findAndSetTagLocalUidsPerNoteSummaries(
+    QList<NoteSummary> & noteSummaries, ErrorString & errorDescription) const
+{
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't find tag local uids per note summaries"));
 
-    // Setting tag guids
+    QHash<QString, int> noteSummaryIndices;
+    noteSummaryIndices.reserve(noteSummaries.size());
 
-    int numTagGuids = tagGuidsAndIndices.size();
-    QList<std::pair<QString, int>> tagGuidIndexPairs;
-    tagGuidIndexPairs.reserve(std::max(numTagGuids, 0));
+    QStringList noteLocalUids;
+    noteLocalUids.reserve(noteSummaries.size());
 
-    for (const auto it: qevercloud::toRange(tagGuidsAndIndices)) {
-        tagGuidIndexPairs << std::make_pair(it.value(), it.key());
+    for (int i = 0, size = noteSummaries.size(); i < size; ++i) {
+        const QString & noteLocalUid = noteSummaries[i].m_localUid;
+        noteSummaryIndices[noteLocalUid] = i;
+        noteLocalUids << noteLocalUid;
     }
 
-    std::sort(
-        tagGuidIndexPairs.begin(), tagGuidIndexPairs.end(),
-        QStringIntPairCompareByInt());
-
-    QStringList tagGuids;
-    tagGuids.reserve(std::max(numTagGuids, 0));
-    for (int i = 0; i < numTagGuids; ++i) {
-        const QString & guid = tagGuidIndexPairs[i].first;
-        if (guid.isEmpty()) {
-            continue;
+    const int numNoteLocalUids = noteLocalUids.size();
+    for (int offset = 0; offset < numNoteLocalUids;
+         offset += MAX_SQL_QUERY_BOUND_VALUES)
+    {
+        const QStringList chunk =
+            noteLocalUids.mid(offset, MAX_SQL_QUERY_BOUND_VALUES);
+
+        QSqlQuery query(m_sqlDatabase);
+        query.prepare(
+            QStringLiteral("SELECT localNote, localTag FROM NoteTags "
+                           "WHERE localNote IN (") +
+            sqlQueryPlaceholders(chunk.size()) +
+            QStringLiteral(") ORDER BY tagIndexInNote ASC"));
+
+        for (const auto & noteLocalUid: chunk) {
+            query.addBindValue(noteLocalUid);
         }
 
-        tagGuids << guid;
-    }
+        bool res = execQuery(query);
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        while (query.next()) {
+            auto it = noteSummaryIndices.find(query.value(0).toString());
+            if (Q_UNLIKELY(it == noteSummaryIndices.end())) {
+                continue;
+            }
 
-    note.setTagGuids(tagGuids);
+            noteSummaries[it.value()].m_tagLocalUids
+                << query.value(1).toString();
+        }
+    }
 
     return true;
 }
@@ -12884,77 +16256,166 @@ bool LocalStorageManagerPrivate::findAndSetTagIdsPerNote(
 bool LocalStorageManagerPrivate::findAndSetResourcesPerNote(
     Note & note, const GetResourceOptions options,
     ErrorString & errorDescription) const
+{
+    NoteList notes;
+    notes << note;
+
+    if (!findAndSetResourcesPerNotes(notes, options, errorDescription)) {
+        return false;
+    }
+
+    note = notes.at(0);
+    return true;
+}
+
+bool LocalStorageManagerPrivate::findAndSetResourcesPerNotes(
+    NoteList & notes, const GetResourceOptions options,
+    ErrorString & errorDescription) const
 {
     ErrorString errorPrefix(QT_TR_NOOP("can't find resources for note"));
 
-    const QString noteLocalUid = note.localUid();
+    // Resources are accumulated from multiple rows of the query result
+    // since the query joins the application data tables; resources' local
+    // uids are kept in the order in which they were found
+    QHash<QString, Resource> resourcesByLocalUid;
+    QHash<QString, QStringList> resourceLocalUidsPerNote;
+
+    QStringList noteLocalUids;
+    noteLocalUids.reserve(notes.size());
+    for (const auto & note: qAsConst(notes)) {
+        noteLocalUids << note.localUid();
+    }
+
+    const int numNoteLocalUids = noteLocalUids.size();
+    for (int offset = 0; offset < numNoteLocalUids;
+         offset += MAX_SQL_QUERY_BOUND_VALUES)
+    {
+        const QStringList chunk =
+            noteLocalUids.mid(offset, MAX_SQL_QUERY_BOUND_VALUES);
+
+        QSqlQuery query(m_sqlDatabase);
+        query.prepare(
+            resourceSelectionQueryPart() +
+            QStringLiteral(" WHERE NoteResources.localNote IN (") +
+            sqlQueryPlaceholders(chunk.size()) + QStringLiteral(")"));
+
+        for (const auto & noteLocalUid: chunk) {
+            query.addBindValue(noteLocalUid);
+        }
+
+        bool res = execQuery(query);
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        while (query.next()) {
+            QSqlRecord rec = query.record();
 
-    QString queryString =
-        QString::fromUtf8(
-            "SELECT localResource FROM NoteResources WHERE localNote='%1'")
-            .arg(sqlEscapeString(noteLocalUid));
+            QString resourceLocalUid =
+                rec.value(QStringLiteral("resourceLocalUid")).toString();
 
-    QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
-    DATABASE_CHECK_AND_SET_ERROR()
+            auto it = resourcesByLocalUid.find(resourceLocalUid);
+            if (it == resourcesByLocalUid.end()) {
+                QString noteLocalUid =
+                    rec.value(QStringLiteral("localNote")).toString();
 
-    QStringList resourceLocalUids;
-    resourceLocalUids.reserve(std::max(query.size(), 0));
+                resourceLocalUidsPerNote[noteLocalUid] << resourceLocalUid;
 
-    while (query.next()) {
-        QSqlRecord rec = query.record();
-        int index = rec.indexOf(QStringLiteral("localResource"));
-        if (Q_UNLIKELY(index < 0)) {
-            continue;
-        }
+                QNTRACE(
+                    "local_storage",
+                    "Found resource with local uid "
+                        << resourceLocalUid << " for note with local uid "
+                        << noteLocalUid);
 
-        QVariant value = rec.value(index);
-        if (Q_UNLIKELY(value.isNull())) {
-            continue;
-        }
+                it = resourcesByLocalUid.insert(resourceLocalUid, Resource());
+            }
 
-        QString resourceLocalUid = value.toString();
-        resourceLocalUids << resourceLocalUid;
-        QNTRACE(
-            "local_storage",
-            "Found resource's local uid: " << resourceLocalUid);
+            fillResourceFromSqlRecord(rec, it.value());
+        }
     }
 
-    int numResources = resourceLocalUids.size();
-    QNTRACE("local_storage", "Found " << numResources << " resources");
+    QNTRACE(
+        "local_storage",
+        "Found " << resourcesByLocalUid.size() << " resources for "
+                 << notes.size() << " notes");
 
     ErrorString error;
-    QList<Resource> resources;
-    resources.reserve(std::max(numResources, 0));
-    for (const auto & resourceLocalUid: qAsConst(resourceLocalUids)) {
-        resources << Resource();
-        Resource & resource = resources.back();
-        resource.setLocalUid(resourceLocalUid);
+    for (auto & note: notes) {
+        const QStringList resourceLocalUids =
+            resourceLocalUidsPerNote.value(note.localUid());
 
-        error.clear();
-        bool res = findEnResource(resource, options, error);
-        if (Q_UNLIKELY(!res)) {
-            errorDescription.base() = errorPrefix.base();
-            errorDescription.appendBase(error.base());
-            errorDescription.appendBase(error.additionalBases());
-            errorDescription.details() = error.details();
-            QNWARNING("local_storage", errorDescription);
-            return false;
+        QList<Resource> resources;
+        resources.reserve(resourceLocalUids.size());
+
+        for (const auto & resourceLocalUid: resourceLocalUids) {
+            resources << resourcesByLocalUid.value(resourceLocalUid);
+            Resource & resource = resources.back();
+
+            if (!(options & GetResourceOption::WithBinaryData)) {
+                continue;
+            }
+
+            error.clear();
+            if (Q_UNLIKELY(
+                    !readResourceDataFromFiles(resource, options, error)))
+            {
+                errorDescription.base() = errorPrefix.base();
+                errorDescription.appendBase(error.base());
+                errorDescription.appendBase(error.additionalBases());
+                errorDescription.details() = error.details();
+                QNWARNING("local_storage", errorDescription);
+                return false;
+            }
         }
 
-        QNTRACE(
-            "local_storage",
-            "Found resource with local uid " << resource.localUid()
-                                             << " for note with local uid "
-                                             << noteLocalUid);
+        std::sort(resources.begin(), resources.end(), ResourceCompareByIndex());
+        note.setResources(resources);
     }
 
-    std::sort(resources.begin(), resources.end(), ResourceCompareByIndex());
-    note.setResources(resources);
-
     return true;
 }
 
+QString LocalStorageManagerPrivate::resourceSelectionQueryPart() const
+{
+    return QStringLiteral(
+        "SELECT Resources.resourceLocalUid, resourceGuid, "
+        "noteGuid, resourceUpdateSequenceNumber, resourceIsDirty, "
+        "dataSize, dataHash, mime, width, height, recognitionDataSize, "
+        "recognitionDataHash, alternateDataSize, alternateDataHash, "
+        "resourceIndexInNote, resourceSourceURL, timestamp, "
+        "resourceLatitude, resourceLongitude, resourceAltitude, "
+        "cameraMake, cameraModel, clientWillIndex, fileName, "
+        "attachment, resourceKey, resourceMapKey, resourceValue, "
+        "localNote, recognitionDataBody "
+        "FROM Resources "
+        "LEFT OUTER JOIN ResourceAttributes ON "
+        "Resources.resourceLocalUid = "
+        "ResourceAttributes.resourceLocalUid "
+        "LEFT OUTER JOIN ResourceAttributesApplicationDataKeysOnly ON "
+        "Resources.resourceLocalUid = "
+        "ResourceAttributesApplicationDataKeysOnly.resourceLocalUid "
+        "LEFT OUTER JOIN ResourceAttributesApplicationDataFullMap ON "
+        "Resources.resourceLocalUid = "
+        "ResourceAttributesApplicationDataFullMap.resourceLocalUid "
+        "LEFT OUTER JOIN NoteResources ON "
+        "Resources.resourceLocalUid = NoteResources.localResource");
+}
+
+QString LocalStorageManagerPrivate::sqlQueryPlaceholders(
+    const int numPlaceholders) const
+{
+    QString placeholders;
+    placeholders.reserve(std::max(numPlaceholders * 3, 0));
+
+    for (int i = 0; i < numPlaceholders; ++i) {
+        if (i != 0) {
+            placeholders += QStringLiteral(", ");
+        }
+
+        placeholders += QStringLiteral("?");
+    }
+
+    return placeholders;
+}
+
 void LocalStorageManagerPrivate::sortSharedNotebooks(Notebook & notebook) const
 {
     if (!notebook.hasSharedNotebooks()) {
@@ -13017,7 +16478,7 @@ bool LocalStorageManagerPrivate::noteSearchQueryToSQL(
                 "notebookName MATCH '%1' LIMIT 1")
                 .arg(sqlEscapeString(notebookName));
 
-        bool res = query.exec(notebookQueryString);
+        bool res = execQuery(query, notebookQueryString);
         DATABASE_CHECK_AND_SET_ERROR()
 
         if (Q_UNLIKELY(!query.next())) {
@@ -13390,6 +16851,40 @@ bool LocalStorageManagerPrivate::noteSearchQueryToSQL(
 
     // 6) ==== Processing other better generalizable filters ====
 
+    // Range conditions on note coordinates are served by the R*Tree index
+    // when it is available. The index keeps coordinates as 32 bit floats
+    // rounded outwards so it only narrows down the candidates and the exact
+    // condition is checked against Notes table
+    const auto numericRangeCondition =
+        [this](const QString & column, const bool negated,
+               const QString & value) {
+            const QString op =
+                (negated ? QStringLiteral("<") : QStringLiteral(">="));
+
+            const bool locationColumn =
+                (column == QStringLiteral("latitude")) ||
+                (column == QStringLiteral("longitude")) ||
+                (column == QStringLiteral("altitude"));
+
+            if (!locationColumn || !m_noteLocationIndexAvailable) {
+                return QString::fromUtf8(
+                           "(localUid IN (SELECT localUid FROM Notes "
+                           "WHERE Notes.%1 %2 %3)) ")
+                    .arg(column, op, value);
+            }
+
+            QString indexColumn = (negated ? QStringLiteral("min")
+                                           : QStringLiteral("max")) +
+                column.left(1).toUpper() + column.mid(1);
+
+            return QString::fromUtf8(
+                       "(localUid IN (SELECT Notes.localUid FROM "
+                       "NoteLocationIndex INNER JOIN Notes ON "
+                       "Notes.rowid = NoteLocationIndex.id WHERE "
+                       "NoteLocationIndex.%1 %3 %4 AND Notes.%2 %3 %4)) ")
+                .arg(indexColumn, column, op, value);
+        };
+
 #define CHECK_AND_PROCESS_ANY_ITEM(hasAnyItem, hasNegatedAnyItem, column)      \
     if (noteSearchQuery.hasAnyItem()) {                                        \
         sql += QStringLiteral("(NoteFTS." #column " IS NOT NULL) ");           \
@@ -13455,16 +16950,9 @@ bool LocalStorageManagerPrivate::noteSearchQueryToSQL(
             }                                                                  \
         }                                                                      \
         if (it != noteSearchQuery##list##column.constEnd()) {                  \
-            sql += QStringLiteral("(localUid IN (SELECT localUid FROM ");      \
-            sql += QStringLiteral("Notes WHERE Notes." #column);               \
-            if (negated) {                                                     \
-                sql += QStringLiteral(" < ");                                  \
-            }                                                                  \
-            else {                                                             \
-                sql += QStringLiteral(" >= ");                                 \
-            }                                                                  \
-            sql += sqlEscapeString(__VA_ARGS__(*it));                          \
-            sql += QStringLiteral(")) ");                                      \
+            sql += numericRangeCondition(                                      \
+                QStringLiteral(#column), negated,                              \
+                sqlEscapeString(__VA_ARGS__(*it)));                            \
             sql += uniteOperator;                                              \
             sql += QStringLiteral(" ");                                        \
         }                                                                      \
@@ -13681,6 +17169,96 @@ bool LocalStorageManagerPrivate::noteSearchQueryToSQL(
     return true;
 }
 
+bool LocalStorageManagerPrivate::compiledNoteSearchQuery(
+    const NoteSearchQuery & noteSearchQuery, QSqlQuery & query,
+    ErrorString & errorDescription) const
+{
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't compile note search query into SQL query"));
+
+    /**
+     * Changes made by other connections, if any, are not tracked so all
+     * compiled queries are dropped whenever another connection modifies
+     * the database
+     */
+    QSqlQuery dataVersionQuery(m_sqlDatabase);
+    bool res =
+        execQuery(dataVersionQuery, QStringLiteral("PRAGMA data_version"));
+
+    if (res && dataVersionQuery.next()) {
+        qint64 dataVersion = dataVersionQuery.value(0).toLongLong();
+        if (dataVersion != m_compiledNoteSearchQueriesDataVersion) {
+            invalidateCompiledNoteSearchQueries();
+            m_compiledNoteSearchQueriesDataVersion = dataVersion;
+        }
+    }
+    else {
+        invalidateCompiledNoteSearchQueries();
+    }
+
+    // Timestamps from relative date modifiers are resolved at parsing time so
+    // the printed representation of the parsed query accounts for them
+    const QString key = ToString(noteSearchQuery);
+
+    ++m_compiledNoteSearchQueriesUseCounter;
+
+    auto it = m_compiledNoteSearchQueries.find(key);
+    if (it != m_compiledNoteSearchQueries.end()) {
+        QNTRACE("local_storage", "Using cached compiled note search query");
+        it.value().m_lastUseCounter = m_compiledNoteSearchQueriesUseCounter;
+        query = it.value().m_query;
+        return true;
+    }
+
+    QString sql;
+    ErrorString error;
+    res = noteSearchQueryToSQL(noteSearchQuery, sql, error);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        return false;
+    }
+
+    CompiledNoteSearchQuery compiledQuery;
+    compiledQuery.m_query = QSqlQuery(m_sqlDatabase);
+    compiledQuery.m_lastUseCounter = m_compiledNoteSearchQueriesUseCounter;
+
+    res = compiledQuery.m_query.prepare(sql);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.details() = compiledQuery.m_query.lastError().text();
+        QNWARNING("local_storage", errorDescription << ", SQL query: " << sql);
+        return false;
+    }
+
+    if (m_compiledNoteSearchQueries.size() >=
+        MAX_COMPILED_NOTE_SEARCH_QUERIES)
+    {
+        auto lruIt = m_compiledNoteSearchQueries.begin();
+        for (auto cit = m_compiledNoteSearchQueries.begin(),
+                  end = m_compiledNoteSearchQueries.end();
+             cit != end; ++cit)
+        {
+            if (cit.value().m_lastUseCounter < lruIt.value().m_lastUseCounter) {
+                lruIt = cit;
+            }
+        }
+
+        Q_UNUSED(m_compiledNoteSearchQueries.erase(lruIt))
+    }
+
+    m_compiledNoteSearchQueries[key] = compiledQuery;
+    query = compiledQuery.m_query;
+    return true;
+}
+
+void LocalStorageManagerPrivate::invalidateCompiledNoteSearchQueries() const
+{
+    m_compiledNoteSearchQueries.clear();
+}
+
 bool LocalStorageManagerPrivate::noteSearchQueryContentSearchTermsToSQL(
     const NoteSearchQuery & noteSearchQuery, QString & sql,
     ErrorString & errorDescription) const
@@ -13868,23 +17446,280 @@ void LocalStorageManagerPrivate::contentSearchTermToSQLQueryPart(
             searchTerm.remove(0, 1);
         }
 
-        while (searchTerm.endsWith(asterisk)) {
-            searchTerm.chop(1);
-        }
+        while (searchTerm.endsWith(asterisk)) {
+            searchTerm.chop(1);
+        }
+
+        frontSearchTermModifier = QStringLiteral("%");
+        backSearchTermModifier = QStringLiteral("%");
+
+        int pos = -1;
+        while ((pos = searchTerm.indexOf(asterisk)) >= 0) {
+            searchTerm.replace(pos, 1, QStringLiteral("%"));
+        }
+    }
+    else {
+        matchStatement = QStringLiteral("MATCH");
+        frontSearchTermModifier = QLatin1String("");
+        backSearchTermModifier = QLatin1String("");
+    }
+}
+
+QStringList
+LocalStorageManagerPrivate::noteSearchQueryContentSearchTermsToFTSTerms(
+    const NoteSearchQuery & noteSearchQuery) const
+{
+    const QStringList & contentSearchTerms =
+        noteSearchQuery.contentSearchTerms();
+
+    QStringList result;
+    result.reserve(contentSearchTerms.size());
+
+    QString matchStatement;
+    QString frontSearchTermModifier;
+    QString backSearchTermModifier;
+
+    const QString asterisk = QStringLiteral("*");
+
+    for (auto searchTerm: contentSearchTerms) {
+        m_stringUtils.removePunctuation(searchTerm, m_preservedAsterisk);
+        if (searchTerm.isEmpty()) {
+            continue;
+        }
+
+        m_stringUtils.removeDiacritics(searchTerm);
+
+        contentSearchTermToSQLQueryPart(
+            frontSearchTermModifier, searchTerm, backSearchTermModifier,
+            matchStatement);
+
+        // Terms which need to be looked up via LIKE can't be ranked
+        if (matchStatement != QStringLiteral("MATCH")) {
+            continue;
+        }
+
+        if (QString(searchTerm).remove(asterisk).isEmpty()) {
+            continue;
+        }
+
+        // Lowercasing the term prevents it from being interpreted as one of
+        // FTS operators like OR or NOT; FTS tokenizer lowercases the indexed
+        // text anyway
+        result << searchTerm.toLower();
+    }
+
+    return result;
+}
+
+bool LocalStorageManagerPrivate::scoreFTSMatches(
+    const QString & ftsTableName, const QString & noteLocalUidColumn,
+    const QString & matchExpression, const QVector<double> & columnWeights,
+    const QSet<QString> & noteLocalUids, QHash<QString, double> & scores,
+    QHash<QString, QPair<qint64, double>> & bestDocIds,
+    ErrorString & errorDescription) const
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageManagerPrivate::scoreFTSMatches: table = "
+            << ftsTableName << ", match expression: " << matchExpression);
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't compute the relevance of full text search matches"));
+
+    QString queryString =
+        QString::fromUtf8(
+            "SELECT docid, %1, matchinfo(%2, 'pcnalx') FROM %2 "
+            "WHERE %2 MATCH :matchExpression")
+            .arg(noteLocalUidColumn, ftsTableName);
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.prepare(queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    query.bindValue(QStringLiteral(":matchExpression"), matchExpression);
+
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    int rowCount = 0;
+    while (query.next()) {
+        ++rowCount;
+
+        QString noteLocalUid = query.value(1).toString();
+        if (!noteLocalUids.contains(noteLocalUid)) {
+            continue;
+        }
+
+        double score =
+            bm25FromMatchInfo(query.value(2).toByteArray(), columnWeights);
+
+        scores[noteLocalUid] += score;
+
+        auto it = bestDocIds.find(noteLocalUid);
+        if ((it == bestDocIds.end()) || (it.value().second < score)) {
+            bestDocIds[noteLocalUid] =
+                qMakePair(query.value(0).toLongLong(), score);
+        }
+    }
+
+    recordQueryRows(query, rowCount);
+    return true;
+}
+
+bool LocalStorageManagerPrivate::fillNoteSearchHitSnippets(
+    const QString & ftsTableName, const QString & matchExpression,
+    const QHash<qint64, int> & hitIndicesByDocId,
+    QList<LocalStorageManager::NoteSearchHit> & hits,
+    ErrorString & errorDescription) const
+{
+    if (hitIndicesByDocId.isEmpty()) {
+        return true;
+    }
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("can't get the snippets of full text search matches"));
+
+    QString docIds;
+    for (auto it = hitIndicesByDocId.constBegin(),
+              end = hitIndicesByDocId.constEnd();
+         it != end; ++it)
+    {
+        if (!docIds.isEmpty()) {
+            docIds += QStringLiteral(", ");
+        }
+
+        docIds += QString::number(it.key());
+    }
+
+    // Snippet of up to 16 tokens from the best matching column
+    QString queryString =
+        QString::fromUtf8(
+            "SELECT docid, snippet(%1, :matchStart, :matchEnd, '...', -1, 16) "
+            "FROM %1 WHERE %1 MATCH :matchExpression AND docid IN (%2)")
+            .arg(ftsTableName, docIds);
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.prepare(queryString);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    // Control characters which can't appear within the indexed text are used
+    // to mark the matches so that their offsets can be computed
+    const QChar matchStart(0x02);
+    const QChar matchEnd(0x03);
+
+    query.bindValue(QStringLiteral(":matchStart"), QString(matchStart));
+    query.bindValue(QStringLiteral(":matchEnd"), QString(matchEnd));
+    query.bindValue(QStringLiteral(":matchExpression"), matchExpression);
+
+    res = execQuery(query);
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    while (query.next()) {
+        int hitIndex = hitIndicesByDocId.value(query.value(0).toLongLong(), -1);
+        if (Q_UNLIKELY((hitIndex < 0) || (hitIndex >= hits.size()))) {
+            continue;
+        }
+
+        auto & hit = hits[hitIndex];
+        hit.m_snippet.resize(0);
+        hit.m_matchOffsets.clear();
+
+        const QString snippet = query.value(1).toString();
+        hit.m_snippet.reserve(snippet.size());
+
+        int currentMatchStart = -1;
+        for (const QChar c: snippet) {
+            if (c == matchStart) {
+                currentMatchStart = hit.m_snippet.size();
+                continue;
+            }
+
+            if (c == matchEnd) {
+                if (currentMatchStart >= 0) {
+                    hit.m_matchOffsets << qMakePair(
+                        currentMatchStart,
+                        hit.m_snippet.size() - currentMatchStart);
+                    currentMatchStart = -1;
+                }
+
+                continue;
+            }
+
+            hit.m_snippet += c;
+        }
+    }
+
+    return true;
+}
+
+double LocalStorageManagerPrivate::bm25FromMatchInfo(
+    const QByteArray & matchInfo, const QVector<double> & columnWeights) const
+{
+    // Commonly used values of BM25 free parameters
+    const double k1 = 1.2;
+    const double b = 0.75;
+
+    const int numValues = matchInfo.size() / static_cast<int>(sizeof(quint32));
+    if (Q_UNLIKELY(numValues < 3)) {
+        return 0.0;
+    }
+
+    // matchinfo returns an array of unsigned 32 bit integers in machine byte
+    // order
+    QVector<quint32> values(numValues);
+    std::memcpy(
+        values.data(), matchInfo.constData(),
+        static_cast<size_t>(numValues) * sizeof(quint32));
+
+    const int numPhrases = static_cast<int>(values[0]);
+    const int numColumns = static_cast<int>(values[1]);
+    const double numRows = values[2];
+
+    const int avgLengthsOffset = 3;
+    const int lengthsOffset = avgLengthsOffset + numColumns;
+    const int hitsOffset = lengthsOffset + numColumns;
+
+    if (Q_UNLIKELY(numValues < hitsOffset + 3 * numPhrases * numColumns)) {
+        return 0.0;
+    }
+
+    const int numWeightedColumns = std::min(numColumns, columnWeights.size());
+
+    double score = 0.0;
+    for (int column = 0; column < numWeightedColumns; ++column) {
+        const double weight = columnWeights[column];
+        if (weight <= 0.0) {
+            continue;
+        }
+
+        const double avgLength =
+            std::max(values[avgLengthsOffset + column], quint32(1));
+
+        const double length = values[lengthsOffset + column];
+
+        for (int phrase = 0; phrase < numPhrases; ++phrase) {
+            const int hitsIndex =
+                hitsOffset + 3 * (column + phrase * numColumns);
+
+            const double termFrequency = values[hitsIndex];
+            if (termFrequency <= 0.0) {
+                continue;
+            }
+
+            const double numRowsWithHits = values[hitsIndex + 2];
 
-        frontSearchTermModifier = QStringLiteral("%");
-        backSearchTermModifier = QStringLiteral("%");
+            // This variant of IDF doesn't go negative for terms found within
+            // more than a half of rows
+            const double idf = std::log(
+                1.0 + (numRows - numRowsWithHits + 0.5) /
+                    (numRowsWithHits + 0.5));
 
-        int pos = -1;
-        while ((pos = searchTerm.indexOf(asterisk)) >= 0) {
-            searchTerm.replace(pos, 1, QStringLiteral("%"));
+            score += weight * idf * termFrequency * (k1 + 1.0) /
+                (termFrequency + k1 * (1.0 - b + b * length / avgLength));
         }
     }
-    else {
-        matchStatement = QStringLiteral("MATCH");
-        frontSearchTermModifier = QLatin1String("");
-        backSearchTermModifier = QLatin1String("");
-    }
+
+    return score;
 }
 
 bool LocalStorageManagerPrivate::tagNamesToTagLocalUids(
@@ -13953,10 +17788,10 @@ bool LocalStorageManagerPrivate::tagNamesToTagLocalUids(
 
     bool res = false;
     if (queryString.isEmpty()) {
-        res = query.exec();
+        res = execQuery(query);
     }
     else {
-        res = query.exec(queryString);
+        res = execQuery(query, queryString);
     }
     DATABASE_CHECK_AND_SET_ERROR()
 
@@ -14049,10 +17884,10 @@ bool LocalStorageManagerPrivate::resourceMimeTypesToResourceLocalUids(
 
     bool res = false;
     if (queryString.isEmpty()) {
-        res = query.exec();
+        res = execQuery(query);
     }
     else {
-        res = query.exec(queryString);
+        res = execQuery(query, queryString);
     }
     DATABASE_CHECK_AND_SET_ERROR()
 
@@ -14086,7 +17921,7 @@ bool LocalStorageManagerPrivate::complementResourceNoteIds(
                 .arg(noteLocalUid);
 
         QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
+        bool res = execQuery(query, queryString);
         DATABASE_CHECK_AND_SET_ERROR()
 
         if (query.next()) {
@@ -14101,7 +17936,7 @@ bool LocalStorageManagerPrivate::complementResourceNoteIds(
                 .arg(noteGuid);
 
         QSqlQuery query(m_sqlDatabase);
-        bool res = query.exec(queryString);
+        bool res = execQuery(query, queryString);
         DATABASE_CHECK_AND_SET_ERROR()
 
         if (query.next()) {
@@ -14151,7 +17986,7 @@ bool LocalStorageManagerPrivate::partialUpdateNoteResources(
             .arg(sqlEscapeString(noteLocalUid));
 
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(listNoteResourcesQueryString);
+    bool res = execQuery(query, listNoteResourcesQueryString);
     DATABASE_CHECK_AND_SET_ERROR()
 
     QList<Resource> previousNoteResources;
@@ -14284,23 +18119,25 @@ bool LocalStorageManagerPrivate::partialUpdateNoteResources(
                 "DELETE FROM Resources WHERE resourceLocalUid IN ('%1')")
                 .arg(localUidsForResourcesRemovedFromNote.join(
                     QStringLiteral(",")));
-        res = query.exec(removeResourcesQueryString);
+        res = execQuery(query, removeResourcesQueryString);
         DATABASE_CHECK_AND_SET_ERROR()
 
-        for (const auto & localUid:
-             qAsConst(localUidsForResourcesRemovedFromNote)) {
-            Resource resource;
-            resource.setLocalUid(localUid);
-            resource.setNoteLocalUid(noteLocalUid);
+        invalidateCompiledNoteSearchQueries();
 
-            ErrorString error;
-            if (!removeResourceDataFiles(resource, error)) {
-                errorDescription = errorPrefix;
-                errorDescription.appendBase(error.base());
-                errorDescription.appendBase(error.additionalBases());
-                errorDescription.details() = error.details();
-                return false;
-            }
+        for (const auto & resourceLocalUid:
+             qAsConst(localUidsForResourcesRemovedFromNote))
+        {
+            m_guidLocalUidIndex.removeByLocalUid(
+                GuidLocalUidIndex::ObjectType::Resource, resourceLocalUid);
+        }
+
+        ErrorString error;
+        if (!removeOrphanResourceBlobs(error)) {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            return false;
         }
     }
 
@@ -14440,6 +18277,9 @@ void LocalStorageManagerPrivate::clearCachedQueries()
     m_insertOrReplaceResourceMetadataWithDataPropertiesQuery = QSqlQuery();
     m_insertOrReplaceResourceMetadataWithDataPropertiesQueryPrepared = false;
 
+    m_getResourceBlobHashQuery = QSqlQuery();
+    m_getResourceBlobHashQueryPrepared = false;
+
     m_updateResourceMetadataWithoutDataPropertiesQuery = QSqlQuery();
     m_updateResourceMetadataWithoutDataPropertiesQueryPrepared = false;
 
@@ -14554,6 +18394,9 @@ void LocalStorageManagerPrivate::clearCachedQueries()
 
     m_deleteUserQuery = QSqlQuery();
     m_deleteUserQueryPrepared = false;
+
+    invalidateCompiledNoteSearchQueries();
+    m_compiledNoteSearchQueriesDataVersion = -1;
 }
 
 template <class T>
@@ -14746,6 +18589,24 @@ QString LocalStorageManagerPrivate::listObjectsGenericSqlQuery<Note>() const
     return result;
 }
 
+template <>
+QString LocalStorageManagerPrivate::listObjectsTableName<Tag>() const
+{
+    return QStringLiteral("Tags");
+}
+
+template <>
+QString LocalStorageManagerPrivate::listObjectsTableName<Notebook>() const
+{
+    return QStringLiteral("Notebooks");
+}
+
+template <>
+QString LocalStorageManagerPrivate::listObjectsTableName<Note>() const
+{
+    return QStringLiteral("Notes");
+}
+
 template <>
 QString LocalStorageManagerPrivate::orderByToSqlTableColumn<ListNotesOrder>(
     const ListNotesOrder & order) const
@@ -14890,7 +18751,10 @@ bool LocalStorageManagerPrivate::fillObjectsFromSqlQuery(
 {
     objects.reserve(std::max(query.size(), 0));
 
+    int rowCount = 0;
     while (query.next()) {
+        ++rowCount;
+
         QSqlRecord rec = query.record();
 
         objects << T();
@@ -14902,6 +18766,8 @@ bool LocalStorageManagerPrivate::fillObjectsFromSqlQuery(
         }
     }
 
+    recordQueryRows(query, rowCount);
+
     return true;
 }
 
@@ -14911,7 +18777,10 @@ bool LocalStorageManagerPrivate::fillObjectsFromSqlQuery(
 {
     QMap<QString, int> indexForLocalUid;
 
+    int rowCount = 0;
     while (query.next()) {
+        ++rowCount;
+
         QSqlRecord rec = query.record();
 
         int localUidIndex = rec.indexOf(QStringLiteral("localUid"));
@@ -14948,6 +18817,8 @@ bool LocalStorageManagerPrivate::fillObjectsFromSqlQuery(
         sortSharedNotes(note);
     }
 
+    recordQueryRows(query, rowCount);
+
     return true;
 }
 
@@ -14958,7 +18829,10 @@ bool LocalStorageManagerPrivate::fillObjectsFromSqlQuery<Notebook>(
 {
     QMap<QString, int> indexForLocalUid;
 
+    int rowCount = 0;
     while (query.next()) {
+        ++rowCount;
+
         QSqlRecord rec = query.record();
 
         int localUidIndex = rec.indexOf(QStringLiteral("localUid"));
@@ -14999,6 +18873,8 @@ bool LocalStorageManagerPrivate::fillObjectsFromSqlQuery<Notebook>(
         sortSharedNotebooks(notebook);
     }
 
+    recordQueryRows(query, rowCount);
+
     return true;
 }
 
@@ -15060,7 +18936,10 @@ bool LocalStorageManagerPrivate::fillObjectsFromSqlQuery(
 {
     tagsWithNoteLocalUids.reserve(std::max(query.size(), 0));
 
+    int rowCount = 0;
     while (query.next()) {
+        ++rowCount;
+
         QSqlRecord rec = query.record();
 
         tagsWithNoteLocalUids << std::pair<Tag, QStringList>();
@@ -15073,28 +18952,29 @@ bool LocalStorageManagerPrivate::fillObjectsFromSqlQuery(
         }
     }
 
+    recordQueryRows(query, rowCount);
+
     return complementTagsWithNoteLocalUids(
         tagsWithNoteLocalUids, errorDescription);
 }
 
-template <class T, class TOrderBy>
-QList<T> LocalStorageManagerPrivate::listObjects(
-    const ListObjectsOptions & flag, ErrorString & errorDescription,
-    const size_t limit, const size_t offset, const TOrderBy & orderBy,
-    const OrderDirection & orderDirection,
-    const QString & additionalSqlQueryCondition) const
+template <class T>
+bool LocalStorageManagerPrivate::listObjectsSqlQueryConditions(
+    const ListObjectsOptions & flag,
+    const QString & additionalSqlQueryCondition, QString & sqlQueryConditions,
+    ErrorString & errorDescription) const
 {
     ErrorString flagError;
-    QString sqlQueryConditions =
+    QString flagSqlQueryConditions =
         listObjectsOptionsToSqlQueryConditions<T>(flag, flagError);
-    if (sqlQueryConditions.isEmpty() && !flagError.isEmpty()) {
+    if (flagSqlQueryConditions.isEmpty() && !flagError.isEmpty()) {
         errorDescription = flagError;
-        return QList<T>();
+        return false;
     }
 
     QString sumSqlQueryConditions;
-    if (!sqlQueryConditions.isEmpty()) {
-        sumSqlQueryConditions += sqlQueryConditions;
+    if (!flagSqlQueryConditions.isEmpty()) {
+        sumSqlQueryConditions += flagSqlQueryConditions;
     }
 
     if (!additionalSqlQueryCondition.isEmpty()) {
@@ -15111,10 +18991,32 @@ QList<T> LocalStorageManagerPrivate::listObjects(
         sumSqlQueryConditions.chop(5);
     }
 
-    QString queryString = listObjectsGenericSqlQuery<T>();
     if (!sumSqlQueryConditions.isEmpty()) {
         sumSqlQueryConditions.prepend(QStringLiteral("("));
         sumSqlQueryConditions.append(QStringLiteral(")"));
+    }
+
+    sqlQueryConditions = sumSqlQueryConditions;
+    return true;
+}
+
+template <class T, class TOrderBy>
+QList<T> LocalStorageManagerPrivate::listObjects(
+    const ListObjectsOptions & flag, ErrorString & errorDescription,
+    const size_t limit, const size_t offset, const TOrderBy & orderBy,
+    const OrderDirection & orderDirection,
+    const QString & additionalSqlQueryCondition) const
+{
+    QString sumSqlQueryConditions;
+    if (!listObjectsSqlQueryConditions<T>(
+            flag, additionalSqlQueryCondition, sumSqlQueryConditions,
+            errorDescription))
+    {
+        return QList<T>();
+    }
+
+    QString queryString = listObjectsGenericSqlQuery<T>();
+    if (!sumSqlQueryConditions.isEmpty()) {
         queryString += QStringLiteral(" WHERE ");
         queryString += sumSqlQueryConditions;
     }
@@ -15153,7 +19055,221 @@ QList<T> LocalStorageManagerPrivate::listObjects(
         "can't list objects from the local "
         "storage database by filter"));
     QSqlQuery query(m_sqlDatabase);
-    bool res = query.exec(queryString);
+    bool res = execQuery(query, queryString);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        QNERROR(
+            "local_storage",
+            errorDescription << ", last query = " << query.lastQuery()
+                             << ", last error = " << query.lastError());
+        errorDescription.details() = query.lastError().text();
+        return objects;
+    }
+
+    ErrorString error;
+    res = fillObjectsFromSqlQuery(query, objects, error);
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage", errorDescription);
+        objects.clear();
+        return objects;
+    }
+
+    QNDEBUG("local_storage", "found " << objects.size() << " objects");
+
+    return objects;
+}
+
+template <class T, class TOrderBy>
+QList<T> LocalStorageManagerPrivate::listObjectsPage(
+    const ListObjectsOptions & flag, ErrorString & errorDescription,
+    const size_t pageSize, QString & continuationToken,
+    const TOrderBy & orderBy, const OrderDirection & orderDirection,
+    const QString & additionalSqlQueryCondition) const
+{
+    ErrorString errorPrefix(QT_TRANSLATE_NOOP(
+        "LocalStorageManagerPrivate",
+        "can't list the page of objects from the local storage database"));
+
+    QString sqlQueryConditions;
+    if (!listObjectsSqlQueryConditions<T>(
+            flag, additionalSqlQueryCondition, sqlQueryConditions,
+            errorDescription))
+    {
+        return QList<T>();
+    }
+
+    const QString tableName = listObjectsTableName<T>();
+    const QString localUidColumn = tableName + QStringLiteral(".localUid");
+
+    QString orderByColumn = orderByToSqlTableColumn<TOrderBy>(orderBy);
+    if (!orderByColumn.isEmpty()) {
+        orderByColumn.prepend(tableName + QStringLiteral("."));
+    }
+
+    // Without ordering by some column the rows are ordered by local uid only
+    // and the direction is always ascending
+    const bool descending = !orderByColumn.isEmpty() &&
+        (orderDirection == OrderDirection::Descending);
+
+    const QString comparison =
+        (descending ? QStringLiteral(" < ") : QStringLiteral(" > "));
+
+    QVariant lastOrderByValue;
+    QString lastLocalUid;
+    QString keysetCondition;
+
+    if (!continuationToken.isEmpty()) {
+        ErrorString error;
+        if (!decodeListObjectsContinuationToken(
+                continuationToken, static_cast<int>(orderBy), orderDirection,
+                lastOrderByValue, lastLocalUid, error))
+        {
+            errorDescription.base() = errorPrefix.base();
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            QNWARNING("local_storage", errorDescription);
+            return QList<T>();
+        }
+
+        const QString localUidCondition =
+            localUidColumn + comparison + QStringLiteral("?");
+
+        if (orderByColumn.isEmpty()) {
+            keysetCondition = localUidCondition;
+        }
+        else if (lastOrderByValue.isNull()) {
+            // SQLite puts null values first in ascending order and last
+            // in descending order
+            keysetCondition = QStringLiteral("(") + orderByColumn +
+                QStringLiteral(" IS NULL AND ") + localUidCondition +
+                QStringLiteral(")");
+
+            if (!descending) {
+                keysetCondition += QStringLiteral(" OR ") + orderByColumn +
+                    QStringLiteral(" IS NOT NULL");
+            }
+        }
+        else {
+            keysetCondition = orderByColumn + comparison +
+                QStringLiteral("? OR (") + orderByColumn +
+                QStringLiteral(" = ? AND ") + localUidCondition +
+                QStringLiteral(")");
+
+            if (descending) {
+                keysetCondition +=
+                    QStringLiteral(" OR ") + orderByColumn +
+                    QStringLiteral(" IS NULL");
+            }
+        }
+
+        keysetCondition.prepend(QStringLiteral("("));
+        keysetCondition.append(QStringLiteral(")"));
+    }
+
+    const QString direction =
+        (descending ? QStringLiteral(" DESC") : QStringLiteral(" ASC"));
+
+    QString orderByClause = QStringLiteral(" ORDER BY ");
+    if (!orderByColumn.isEmpty()) {
+        orderByClause += orderByColumn + direction + QStringLiteral(", ");
+    }
+
+    orderByClause += localUidColumn + direction;
+
+    // The page is selected from the objects' table alone so that the limit
+    // counts objects rather than the rows of the joined tables
+    QString pageQueryString = QStringLiteral("SELECT ") + localUidColumn;
+    if (!orderByColumn.isEmpty()) {
+        pageQueryString += QStringLiteral(", ") + orderByColumn;
+    }
+
+    pageQueryString += QStringLiteral(" FROM ") + tableName;
+
+    QStringList conditions;
+    if (!sqlQueryConditions.isEmpty()) {
+        conditions << sqlQueryConditions;
+    }
+
+    if (!keysetCondition.isEmpty()) {
+        conditions << keysetCondition;
+    }
+
+    if (!conditions.isEmpty()) {
+        pageQueryString += QStringLiteral(" WHERE ") +
+            conditions.join(QStringLiteral(" AND "));
+    }
+
+    pageQueryString += orderByClause;
+
+    if (pageSize != 0) {
+        pageQueryString +=
+            QStringLiteral(" LIMIT ") + QString::number(pageSize);
+    }
+
+    QNDEBUG("local_storage", "SQL query string: " << pageQueryString);
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.prepare(pageQueryString);
+    if (res && !keysetCondition.isEmpty()) {
+        if (!orderByColumn.isEmpty() && !lastOrderByValue.isNull()) {
+            query.addBindValue(lastOrderByValue);
+            query.addBindValue(lastOrderByValue);
+        }
+
+        query.addBindValue(lastLocalUid);
+    }
+
+    if (res) {
+        res = execQuery(query);
+    }
+
+    if (!res) {
+        errorDescription.base() = errorPrefix.base();
+        QNERROR(
+            "local_storage",
+            errorDescription << ", last query = " << query.lastQuery()
+                             << ", last error = " << query.lastError());
+        errorDescription.details() = query.lastError().text();
+        return QList<T>();
+    }
+
+    QString joinedLocalUids;
+    int numLocalUids = 0;
+    while (query.next()) {
+        lastLocalUid = query.value(0).toString();
+        if (!orderByColumn.isEmpty()) {
+            lastOrderByValue = query.value(1);
+        }
+
+        if (!joinedLocalUids.isEmpty()) {
+            joinedLocalUids += QStringLiteral(", ");
+        }
+
+        joinedLocalUids += QStringLiteral("'");
+        joinedLocalUids += sqlEscapeString(lastLocalUid);
+        joinedLocalUids += QStringLiteral("'");
+        ++numLocalUids;
+    }
+
+    if (numLocalUids == 0) {
+        continuationToken.clear();
+        return QList<T>();
+    }
+
+    QString queryString = listObjectsGenericSqlQuery<T>() +
+        QStringLiteral(" WHERE ") + localUidColumn + QStringLiteral(" IN (") +
+        joinedLocalUids + QStringLiteral(")") + orderByClause;
+
+    QNDEBUG("local_storage", "SQL query string: " << queryString);
+
+    QList<T> objects;
+
+    res = execQuery(query, queryString);
     if (!res) {
         errorDescription.base() = errorPrefix.base();
         QNERROR(
@@ -15176,11 +19292,113 @@ QList<T> LocalStorageManagerPrivate::listObjects(
         return objects;
     }
 
+    if ((pageSize == 0) || (static_cast<size_t>(numLocalUids) < pageSize)) {
+        continuationToken.clear();
+    }
+    else {
+        continuationToken = encodeListObjectsContinuationToken(
+            static_cast<int>(orderBy), orderDirection, lastOrderByValue,
+            lastLocalUid);
+    }
+
     QNDEBUG("local_storage", "found " << objects.size() << " objects");
 
     return objects;
 }
 
+QString LocalStorageManagerPrivate::encodeListObjectsContinuationToken(
+    const int orderBy, const OrderDirection orderDirection,
+    const QVariant & lastOrderByValue, const QString & lastLocalUid) const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    stream << static_cast<qint32>(orderBy)
+           << static_cast<qint32>(orderDirection) << lastOrderByValue
+           << lastLocalUid;
+
+    return QString::fromUtf8(data.toBase64(
+        QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals));
+}
+
+bool LocalStorageManagerPrivate::decodeListObjectsContinuationToken(
+    const QString & continuationToken, const int orderBy,
+    const OrderDirection orderDirection, QVariant & lastOrderByValue,
+    QString & lastLocalUid, ErrorString & errorDescription) const
+{
+    QByteArray data = QByteArray::fromBase64(
+        continuationToken.toUtf8(), QByteArray::Base64UrlEncoding);
+
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    qint32 tokenOrderBy = 0;
+    qint32 tokenOrderDirection = 0;
+    stream >> tokenOrderBy >> tokenOrderDirection >> lastOrderByValue >>
+        lastLocalUid;
+
+    if (Q_UNLIKELY(
+            (stream.status() != QDataStream::Ok) || lastLocalUid.isEmpty()))
+    {
+        errorDescription.setBase(QT_TR_NOOP("invalid continuation token"));
+        errorDescription.details() = continuationToken;
+        return false;
+    }
+
+    if (Q_UNLIKELY(
+            (tokenOrderBy != orderBy) ||
+            (tokenOrderDirection != static_cast<qint32>(orderDirection))))
+    {
+        errorDescription.setBase(
+            QT_TR_NOOP("continuation token was obtained with different "
+                       "ordering"));
+        errorDescription.details() = continuationToken;
+        return false;
+    }
+
+    return true;
+}
+
+QString LocalStorageManagerPrivate::linkedNotebookGuidSqlQueryCondition(
+    const QString & linkedNotebookGuid) const
+{
+    if (linkedNotebookGuid.isNull()) {
+        return QString();
+    }
+
+    if (linkedNotebookGuid.isEmpty()) {
+        return QStringLiteral("linkedNotebookGuid IS NULL");
+    }
+
+    return QString::fromUtf8("linkedNotebookGuid = '%1'")
+        .arg(sqlEscapeString(linkedNotebookGuid));
+}
+
+QString LocalStorageManagerPrivate::noteLinkedNotebookGuidSqlQueryCondition(
+    const QString & linkedNotebookGuid) const
+{
+    if (linkedNotebookGuid.isNull()) {
+        return QString();
+    }
+
+    QString condition = QStringLiteral(
+        "localUid IN (SELECT DISTINCT Notes.localUid FROM "
+        "(Notes LEFT OUTER JOIN Notebooks ON "
+        "Notes.notebookLocalUid = Notebooks.localUid) "
+        "WHERE Notebooks.linkedNotebookGuid");
+
+    if (linkedNotebookGuid.isEmpty()) {
+        condition += QStringLiteral(" IS NULL)");
+    }
+    else {
+        condition += QString::fromUtf8(" = '%1')")
+                         .arg(sqlEscapeString(linkedNotebookGuid));
+    }
+
+    return condition;
+}
+
 bool LocalStorageManagerPrivate::SharedNotebookCompareByIndex::operator()(
     const SharedNotebook & lhs, const SharedNotebook & rhs) const
 {
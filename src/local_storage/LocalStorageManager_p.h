@@ -19,6 +19,9 @@
 #ifndef LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_MANAGER_PRIVATE_H
 #define LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_MANAGER_PRIVATE_H
 
+#include "GuidLocalUidIndex.h"
+#include "QueryStatisticsCollector.h"
+
 #include <quentier/local_storage/Lists.h>
 #include <quentier/local_storage/LocalStorageManager.h>
 #include <quentier/types/LinkedNotebook.h>
@@ -29,6 +32,7 @@
 #include <quentier/types/SharedNotebook.h>
 #include <quentier/types/Tag.h>
 #include <quentier/types/User.h>
+#include <quentier/utility/LRUCache.hpp>
 #include <quentier/utility/StringUtils.h>
 #include <quentier/utility/SuppressWarnings.h>
 
@@ -49,10 +53,16 @@ GCC_SUPPRESS_WARNING(-Wtype-limits)
 
 RESTORE_WARNINGS
 
+#include <functional>
+#include <memory>
+
+QT_FORWARD_DECLARE_CLASS(QFileInfo)
+
 namespace quentier {
 
 QT_FORWARD_DECLARE_CLASS(LocalStoragePatchManager)
 QT_FORWARD_DECLARE_CLASS(NoteSearchQuery)
+QT_FORWARD_DECLARE_CLASS(Transaction)
 
 class Q_DECL_HIDDEN LocalStorageManagerPrivate final : public QObject
 {
@@ -61,12 +71,14 @@ public:
     LocalStorageManagerPrivate(
         const Account & account,
         const LocalStorageManager::StartupOptions options,
+        const LocalStorageManager::PerformanceProfile & performanceProfile,
         QObject * parent = nullptr);
 
     virtual ~LocalStorageManagerPrivate() override;
 
 Q_SIGNALS:
     void upgradeProgress(double progress);
+    void snapshotProgress(double progress);
 
 public:
     void switchUser(
@@ -115,6 +127,14 @@ public:
         const LocalStorageManager::OrderDirection & orderDirection,
         const QString & linkedNotebookGuid) const;
 
+    QList<Notebook> listNotebooksPage(
+        const LocalStorageManager::ListObjectsOptions flag,
+        ErrorString & errorDescription, const size_t pageSize,
+        QString & continuationToken,
+        const LocalStorageManager::ListNotebooksOrder & order,
+        const LocalStorageManager::OrderDirection & orderDirection,
+        const QString & linkedNotebookGuid) const;
+
     QList<SharedNotebook> listAllSharedNotebooks(
         ErrorString & errorDescription) const;
 
@@ -173,12 +193,30 @@ public:
     QString noteCountOptionsToSqlQueryPart(
         const LocalStorageManager::NoteCountOptions options) const;
 
+    // Returns the expression over columns of note counter tables giving
+    // the number of notes corresponding to options
+    QString noteCountOptionsToCounterColumns(
+        const LocalStorageManager::NoteCountOptions options) const;
+
+    bool noteCountersAreConsistent(ErrorString & errorDescription) const;
+    bool rebuildNoteCounters(ErrorString & errorDescription);
+
     bool addNote(Note & note, ErrorString & errorDescription);
 
     bool updateNote(
         Note & note, const LocalStorageManager::UpdateNoteOptions options,
         ErrorString & errorDescription);
 
+    bool addNotes(
+        QList<Note> & notes, QList<ErrorString> & noteErrorDescriptions,
+        ErrorString & errorDescription);
+
+    bool updateNotes(
+        QList<Note> & notes,
+        const LocalStorageManager::UpdateNoteOptions options,
+        QList<ErrorString> & noteErrorDescriptions,
+        ErrorString & errorDescription);
+
     bool findNote(
         Note & note, const LocalStorageManager::GetNoteOptions options,
         ErrorString & errorDescription) const;
@@ -226,6 +264,23 @@ public:
         const LocalStorageManager::OrderDirection & orderDirection,
         const QString & linkedNotebookGuid) const;
 
+    QList<Note> listNotesPage(
+        const LocalStorageManager::ListObjectsOptions flag,
+        const LocalStorageManager::GetNoteOptions options,
+        ErrorString & errorDescription, const size_t pageSize,
+        QString & continuationToken,
+        const LocalStorageManager::ListNotesOrder & order,
+        const LocalStorageManager::OrderDirection & orderDirection,
+        const QString & linkedNotebookGuid) const;
+
+    QList<LocalStorageManager::NoteSummary> listNoteSummaries(
+        const LocalStorageManager::ListObjectsOptions flag,
+        const LocalStorageManager::NoteSummaryFields fields,
+        ErrorString & errorDescription, const size_t limit, const size_t offset,
+        const LocalStorageManager::ListNotesOrder & order,
+        const LocalStorageManager::OrderDirection & orderDirection,
+        const QString & linkedNotebookGuid, const int previewLength) const;
+
     QList<Note> listNotesImpl(
         const ErrorString & errorPrefix, const QString & sqlQueryCondition,
         const LocalStorageManager::ListObjectsOptions flag,
@@ -234,6 +289,10 @@ public:
         const LocalStorageManager::ListNotesOrder & order,
         const LocalStorageManager::OrderDirection & orderDirection) const;
 
+    bool complementNotesWithTagsAndResources(
+        NoteList & notes, const LocalStorageManager::GetNoteOptions options,
+        const ErrorString & errorPrefix, ErrorString & errorDescription) const;
+
     bool expungeNote(Note & note, ErrorString & errorDescription);
 
     QStringList findNoteLocalUidsWithSearchQuery(
@@ -245,8 +304,23 @@ public:
         const LocalStorageManager::GetNoteOptions options,
         ErrorString & errorDescription) const;
 
+    QList<LocalStorageManager::NoteSearchHit> findNoteSearchHits(
+        const NoteSearchQuery & noteSearchQuery, ErrorString & errorDescription,
+        const size_t limit) const;
+
+    QStringList findNoteLocalUidsWithinBoundingBox(
+        const double minLatitude, const double maxLatitude,
+        const double minLongitude, const double maxLongitude,
+        const LocalStorageManager::NoteCountOptions options,
+        ErrorString & errorDescription) const;
+
     int tagCount(ErrorString & errorDescription) const;
     bool addTag(Tag & tag, ErrorString & errorDescription);
+
+    bool addTags(
+        QList<Tag> & tags, QList<ErrorString> & tagErrorDescriptions,
+        ErrorString & errorDescription);
+
     bool updateTag(Tag & tag, ErrorString & errorDescription);
     bool findTag(Tag & tag, ErrorString & errorDescription) const;
 
@@ -270,6 +344,14 @@ public:
         const LocalStorageManager::OrderDirection & orderDirection,
         const QString & linkedNotebookGuid) const;
 
+    QList<Tag> listTagsPage(
+        const LocalStorageManager::ListObjectsOptions flag,
+        ErrorString & errorDescription, const size_t pageSize,
+        QString & continuationToken,
+        const LocalStorageManager::ListTagsOrder & order,
+        const LocalStorageManager::OrderDirection & orderDirection,
+        const QString & linkedNotebookGuid) const;
+
     QList<std::pair<Tag, QStringList>> listTagsWithNoteLocalUids(
         const LocalStorageManager::ListObjectsOptions flag,
         ErrorString & errorDescription, const size_t limit, const size_t offset,
@@ -284,8 +366,25 @@ public:
     bool expungeNotelessTagsFromLinkedNotebooks(ErrorString & errorDescription);
 
     int enResourceCount(ErrorString & errorDescription) const;
-    bool addEnResource(Resource & resource, ErrorString & errorDescription);
-    bool updateEnResource(Resource & resource, ErrorString & errorDescription);
+
+    // If keepMissingDataBody is true, the resource having data but no data
+    // body keeps its stored data body; it is only the case for the resource
+    // which data body is streamed to the blob store separately
+    bool addEnResource(
+        Resource & resource, ErrorString & errorDescription,
+        const bool keepMissingDataBody = false);
+
+    bool updateEnResource(
+        Resource & resource, ErrorString & errorDescription,
+        const bool keepMissingDataBody = false);
+
+    bool addEnResource(
+        Resource & resource, QIODevice & dataBodySource,
+        ErrorString & errorDescription);
+
+    bool updateEnResource(
+        Resource & resource, QIODevice & dataBodySource,
+        ErrorString & errorDescription);
 
     bool findEnResource(
         Resource & resource,
@@ -320,6 +419,9 @@ public:
     qint32 accountHighUsn(
         const QString & linkedNotebookGuid, ErrorString & errorDescription);
 
+    qint32 accountHighUsnFromTables(
+        const QString & linkedNotebookGuid, ErrorString & errorDescription);
+
     bool updateSequenceNumberFromTable(
         const QString & tableName, const QString & usnColumnName,
         const QString & queryCondition, qint32 & usn,
@@ -327,6 +429,76 @@ public:
 
     bool compactLocalStorage(ErrorString & errorDescription);
 
+    bool enableIncrementalVacuum(ErrorString & errorDescription);
+
+    bool freePageStatistics(
+        LocalStorageManager::FreePageStatistics & statistics,
+        ErrorString & errorDescription) const;
+
+    qint64 reclaimFreePages(
+        const qint64 timeBudgetMsec, ErrorString & errorDescription);
+
+    bool createSnapshot(
+        const QString & snapshotDirPath, ErrorString & errorDescription);
+
+    LocalStorageManager::PerformanceProfile performanceProfile() const;
+
+    bool setPerformanceProfile(
+        const LocalStorageManager::PerformanceProfile & performanceProfile,
+        ErrorString & errorDescription);
+
+    // Lists the hashes of resource data blobs referenced from the database
+    // copy created for the snapshot
+    bool listSnapshotResourceBlobHashes(
+        const QString & snapshotDatabaseFilePath, QStringList & blobHashes,
+        ErrorString & errorDescription) const;
+
+    bool createFullTextSearchIndexTriggers(ErrorString & errorDescription);
+
+    bool createResourceBlobStoreTables(ErrorString & errorDescription);
+
+    bool createNoteCounterTables(ErrorString & errorDescription);
+
+    bool createAccountHighUsnTables(ErrorString & errorDescription);
+
+    bool createNoteLocationIndexTables(ErrorString & errorDescription);
+
+    bool checkNoteLocationIndexAvailability(ErrorString & errorDescription);
+
+    QString resourceBlobFilePath(const QString & blobHash) const;
+
+    // Runs the passed in function within a single read transaction so that
+    // all the queries it makes see the same snapshot of the database; if
+    // the transaction can't be begun, runs the function without it
+    void runWithinSelectionTransaction(const std::function<void()> & func);
+
+    // Opens the transaction within which the following writes are made until
+    // commitWriteGroup is called; transactions opened by the writes become
+    // savepoints within it
+    bool beginWriteGroup(ErrorString & errorDescription);
+    bool commitWriteGroup(ErrorString & errorDescription);
+
+    QList<LocalStorageManager::QueryStatistics> queryStatistics() const;
+    void resetQueryStatistics();
+    void logQueryStatistics() const;
+
+    // Read-only connections from the pool account their queries within
+    // the collector of the primary connection
+    std::shared_ptr<QueryStatisticsCollector> queryStatisticsCollector() const;
+
+    void setQueryStatisticsCollector(
+        std::shared_ptr<QueryStatisticsCollector> pQueryStatistics);
+
+    void setSlowQueryThreshold(const qint64 thresholdUsec);
+    qint64 slowQueryThreshold() const;
+
+    void setAccountHighUsnVerificationEnabled(const bool enabled);
+    bool accountHighUsnVerificationEnabled() const;
+
+    void setGuidIndexEnabled(const bool enabled);
+    bool guidIndexEnabled() const;
+    LocalStorageManager::GuidIndexStatistics guidIndexStatistics() const;
+
 public Q_SLOTS:
     void processPostTransactionException(ErrorString message, QSqlError error);
 
@@ -334,10 +506,45 @@ private:
     LocalStorageManagerPrivate() = delete;
     Q_DISABLE_COPY(LocalStorageManagerPrivate)
 
+    bool applyPerformanceProfile(
+        const LocalStorageManager::PerformanceProfile & performanceProfile,
+        ErrorString & errorDescription);
+
+    void lockDatabaseFile(
+        const QFileInfo & databaseFileInfo,
+        const LocalStorageManager::StartupOptions options);
+
     void unlockDatabaseFile();
 
     bool createTables(ErrorString & errorDescription);
 
+    // Executes either the prepared query, if the query string is null, or
+    // the passed in query string, accounting the execution within the query
+    // statistics
+    bool execQuery(
+        QSqlQuery & query, const QString & queryString = QString()) const;
+
+    // Accounts the number of rows returned by the executed select query within
+    // the query statistics
+    void recordQueryRows(const QSqlQuery & query, const int rowCount) const;
+
+    // Prepared queries are explained with the same values bound to them
+    void captureQueryPlan(
+        const QString & normalizedQuery, const QSqlQuery & query,
+        const qint64 durationUsec) const;
+
+    /**
+     * Calls processItem for each of numItems items within a single exclusive
+     * transaction; each item is processed within its own savepoint which is
+     * rolled back if the item fails to be processed so that the failure
+     * of one item doesn't affect the rest of the batch
+     */
+    bool processBatchInTransaction(
+        const int numItems,
+        const std::function<bool(const int, ErrorString &)> & processItem,
+        QList<ErrorString> & itemErrorDescriptions,
+        ErrorString & errorDescription);
+
     bool insertOrReplaceNotebookRestrictions(
         const QString & localUid,
         const qevercloud::NotebookRestrictions & notebookRestrictions,
@@ -433,10 +640,47 @@ private:
         const QString & savedSearchGuid, QString & savedSearchLocalUid,
         ErrorString & errorDescription) const;
 
+    // State of the note as it was last read from or written to the local
+    // storage; comparing the note being updated against it tells which parts
+    // of the note were modified since then
+    struct NoteLocalStorageSnapshot
+    {
+        Note m_note;
+
+        // False if the note was read or written without its resources so
+        // their persisted state is unknown
+        bool m_hasResources = false;
+    };
+
     bool insertOrReplaceNote(
         Note & note, const LocalStorageManager::UpdateNoteOptions options,
         ErrorString & errorDescription);
 
+    // Updates only the modified columns of the note's row in Notes table;
+    // if the row doesn't match the snapshot, leaves it intact and sets
+    // snapshotMatches to false
+    bool updateModifiedNoteColumns(
+        const Note & note, const Note & snapshot, const QString & localUid,
+        const QString & notebookLocalUid, bool & snapshotMatches,
+        ErrorString & errorDescription);
+
+    // Collects the values of Notes table columns for the note; if the snapshot
+    // of the note's persisted state is given, only for the modified columns
+    bool noteColumnValues(
+        const Note & note, const Note * pSnapshot, const QString & localUid,
+        const QString & notebookLocalUid,
+        QList<std::pair<QString, QVariant>> & columnValues,
+        ErrorString & errorDescription);
+
+    void updateNoteLocalStorageSnapshot(
+        const Note & note, const NoteLocalStorageSnapshot * pPreviousSnapshot,
+        const LocalStorageManager::UpdateNoteOptions options);
+
+    void putNoteLocalStorageSnapshot(
+        const Note & note, const bool withResources) const;
+
+    void removeNoteLocalStorageSnapshot(const Resource & resource);
+
     bool insertOrReplaceSharedNote(
         const SharedNote & sharedNote, ErrorString & errorDescription);
 
@@ -467,7 +711,8 @@ private:
     bool insertOrReplaceResource(
         const Resource & resource, ErrorString & errorDescription,
         const bool setResourceBinaryData = true,
-        const bool useSeparateTransaction = true);
+        const bool useSeparateTransaction = true,
+        const bool keepMissingDataBody = false);
 
     bool insertOrReplaceResourceAttributes(
         const QString & localUid,
@@ -479,29 +724,48 @@ private:
         ErrorString & errorDescription);
 
     bool writeResourceBinaryDataToFiles(
-        const Resource & resource, ErrorString & errorDescription);
+        const Resource & resource, const bool keepMissingDataBody,
+        ErrorString & errorDescription);
+
+    bool writeResourceBlob(
+        const QByteArray & body, QString & blobHash,
+        ErrorString & errorDescription);
 
-    bool writeResourceBinaryDataToFile(
-        const QString & resourceLocalUid, const QString & noteLocalUid,
-        const QByteArray & dataBody, const bool isAlternateDataBody,
-        const bool replaceOriginalFile, ErrorString & errorDescription);
+    bool writeResourceBlob(
+        QIODevice & source, QString & blobHash, qint64 & size,
+        ErrorString & errorDescription);
 
-    bool updateNoteResources(
-        const Resource & resource, ErrorString & errorDescription);
+    bool addOrUpdateEnResourceWithDataFromDevice(
+        Resource & resource, QIODevice & dataBodySource, const bool isUpdate,
+        ErrorString & errorDescription);
 
-    void setNoteIdsToNoteResources(Note & note) const;
+    bool setResourceBlobReference(
+        const QString & resourceLocalUid, const bool isAlternateDataBody,
+        const QString & blobHash, ErrorString & errorDescription);
 
-    bool removeResourceDataFiles(
-        const Resource & resource, ErrorString & errorDescription);
+    bool removeResourceBlobReference(
+        const QString & resourceLocalUid, const bool isAlternateDataBody,
+        ErrorString & errorDescription);
 
-    bool removeResourceDataFilesForNote(
-        const QString & noteLocalUid, ErrorString & errorDescription);
+    bool findResourceBlobHash(
+        const QString & resourceLocalUid, const bool isAlternateDataBody,
+        QString & blobHash, ErrorString & errorDescription) const;
 
-    bool removeResourceDataFilesForNotebook(
-        const Notebook & notebook, ErrorString & errorDescription);
+    bool checkAndPrepareGetResourceBlobHashQuery() const;
 
-    bool removeResourceDataFilesForLinkedNotebook(
-        const LinkedNotebook & linkedNotebook, ErrorString & errorDescription);
+    bool removeOrphanResourceBlobs(ErrorString & errorDescription);
+
+    bool removeUnreferencedResourceBlobFiles(ErrorString & errorDescription);
+
+    bool collectResourceBlobsGarbage(ErrorString & errorDescription);
+
+    void onTransactionCommitted();
+    void onTransactionRolledBack();
+
+    bool updateNoteResources(
+        const Resource & resource, ErrorString & errorDescription);
+
+    void setNoteIdsToNoteResources(Note & note) const;
 
     bool
     checkAndPrepareInsertOrReplaceResourceMetadataWithDataPropertiesQuery();
@@ -540,7 +804,9 @@ private:
         ErrorString & errorDescription) const;
 
     bool readResourceDataFromFiles(
-        Resource & resource, ErrorString & errorDescription) const;
+        Resource & resource,
+        const LocalStorageManager::GetResourceOptions options,
+        ErrorString & errorDescription) const;
 
     enum class ReadResourceBinaryDataFromFileStatus
     {
@@ -550,10 +816,15 @@ private:
     };
 
     ReadResourceBinaryDataFromFileStatus readResourceBinaryDataFromFile(
-        const QString & resourceLocalUid, const QString & noteLocalUid,
-        const bool isAlternateDataBody, QByteArray & dataBody,
+        const QString & resourceLocalUid, const bool isAlternateDataBody,
+        const bool mapFile, QByteArray & dataBody,
+        std::shared_ptr<const void> & dataBodyOwner,
         ErrorString & errorDescription) const;
 
+    ReadResourceBinaryDataFromFileStatus findResourceBinaryDataFilePath(
+        const QString & resourceLocalUid, const bool isAlternateDataBody,
+        QString & filePath, ErrorString & errorDescription) const;
+
     void fillResourceFromSqlRecord(
         const QSqlRecord & rec, Resource & resource) const;
 
@@ -625,10 +896,24 @@ private:
     bool findAndSetTagIdsPerNote(
         Note & note, ErrorString & errorDescription) const;
 
+    bool findAndSetTagIdsPerNotes(
+        NoteList & notes, ErrorString & errorDescription) const;
+
+    bool findAndSetTagLocalUidsPerNoteSummaries(
+        QList<LocalStorageManager::NoteSummary> & noteSummaries,
+        ErrorString & errorDescription) const;
+
     bool findAndSetResourcesPerNote(
         Note & note, const LocalStorageManager::GetResourceOptions options,
         ErrorString & errorDescription) const;
 
+    bool findAndSetResourcesPerNotes(
+        NoteList & notes, const LocalStorageManager::GetResourceOptions options,
+        ErrorString & errorDescription) const;
+
+    QString resourceSelectionQueryPart() const;
+    QString sqlQueryPlaceholders(const int numPlaceholders) const;
+
     void sortSharedNotebooks(Notebook & notebook) const;
     void sortSharedNotes(Note & note) const;
 
@@ -639,6 +924,16 @@ private:
         const NoteSearchQuery & noteSearchQuery, QString & sql,
         ErrorString & errorDescription) const;
 
+    // Returns the prepared SQL query corresponding to the note search query,
+    // either the cached one or the one compiled from scratch
+    bool compiledNoteSearchQuery(
+        const NoteSearchQuery & noteSearchQuery, QSqlQuery & query,
+        ErrorString & errorDescription) const;
+
+    // Compiled note search queries embed local uids of notebooks, tags and
+    // resources so they need to be dropped when any of these change
+    void invalidateCompiledNoteSearchQueries() const;
+
     bool noteSearchQueryContentSearchTermsToSQL(
         const NoteSearchQuery & noteSearchQuery, QString & sql,
         ErrorString & errorDescription) const;
@@ -647,6 +942,37 @@ private:
         QString & frontSearchTermModifier, QString & searchTerm,
         QString & backSearchTermModifier, QString & matchStatement) const;
 
+    // Returns the positive content search terms of the note search query which
+    // can be looked up via FTS MATCH, lowercased and ready to be put into
+    // the FTS query expression
+    QStringList noteSearchQueryContentSearchTermsToFTSTerms(
+        const NoteSearchQuery & noteSearchQuery) const;
+
+    // Runs the FTS query expression against the FTS table and accumulates
+    // BM25 scores per note local uid taken from the specified column, only
+    // for notes from noteLocalUids; also remembers the docid of the best
+    // scoring row per note
+    bool scoreFTSMatches(
+        const QString & ftsTableName, const QString & noteLocalUidColumn,
+        const QString & matchExpression, const QVector<double> & columnWeights,
+        const QSet<QString> & noteLocalUids, QHash<QString, double> & scores,
+        QHash<QString, QPair<qint64, double>> & bestDocIds,
+        ErrorString & errorDescription) const;
+
+    // Fills the snippets and match offsets of search hits using the docids
+    // of FTS table rows
+    bool fillNoteSearchHitSnippets(
+        const QString & ftsTableName, const QString & matchExpression,
+        const QHash<qint64, int> & hitIndicesByDocId,
+        QList<LocalStorageManager::NoteSearchHit> & hits,
+        ErrorString & errorDescription) const;
+
+    // Computes Okapi BM25 score from the output of FTS4 matchinfo function
+    // called with 'pcnalx' format string
+    double bm25FromMatchInfo(
+        const QByteArray & matchInfo,
+        const QVector<double> & columnWeights) const;
+
     bool tagNamesToTagLocalUids(
         const QStringList & tagNames, QStringList & tagLocalUids,
         ErrorString & errorDescription) const;
@@ -668,6 +994,12 @@ private:
         const LocalStorageManager::ListObjectsOptions & flag,
         ErrorString & errorDescription) const;
 
+    template <class T>
+    bool listObjectsSqlQueryConditions(
+        const LocalStorageManager::ListObjectsOptions & flag,
+        const QString & additionalSqlQueryCondition,
+        QString & sqlQueryConditions, ErrorString & errorDescription) const;
+
     template <class T, class TOrderBy>
     QList<T> listObjects(
         const LocalStorageManager::ListObjectsOptions & flag,
@@ -676,9 +1008,43 @@ private:
         const LocalStorageManager::OrderDirection & orderDirection,
         const QString & additionalSqlQueryCondition = QString()) const;
 
+    /**
+     * Lists objects using keyset pagination: the page starts right after
+     * the row identified by continuation token (or from the beginning if it's
+     * empty); on return continuation token identifies the last row
+     * of the page or is empty if there are no more rows
+     */
+    template <class T, class TOrderBy>
+    QList<T> listObjectsPage(
+        const LocalStorageManager::ListObjectsOptions & flag,
+        ErrorString & errorDescription, const size_t pageSize,
+        QString & continuationToken, const TOrderBy & orderBy,
+        const LocalStorageManager::OrderDirection & orderDirection,
+        const QString & additionalSqlQueryCondition = QString()) const;
+
+    QString encodeListObjectsContinuationToken(
+        const int orderBy,
+        const LocalStorageManager::OrderDirection orderDirection,
+        const QVariant & lastOrderByValue, const QString & lastLocalUid) const;
+
+    bool decodeListObjectsContinuationToken(
+        const QString & continuationToken, const int orderBy,
+        const LocalStorageManager::OrderDirection orderDirection,
+        QVariant & lastOrderByValue, QString & lastLocalUid,
+        ErrorString & errorDescription) const;
+
+    QString linkedNotebookGuidSqlQueryCondition(
+        const QString & linkedNotebookGuid) const;
+
+    QString noteLinkedNotebookGuidSqlQueryCondition(
+        const QString & linkedNotebookGuid) const;
+
     template <class T>
     QString listObjectsGenericSqlQuery() const;
 
+    template <class T>
+    QString listObjectsTableName() const;
+
     template <class TOrderBy>
     QString orderByToSqlTableColumn(const TOrderBy & orderBy) const;
 
@@ -739,6 +1105,7 @@ private:
     QString m_databaseFilePath;
     QSqlDatabase m_sqlDatabase;
     boost::interprocess::file_lock m_databaseFileLock;
+    bool m_readOnly = false;
 
     QSqlQuery m_insertOrReplaceSavedSearchQuery;
     bool m_insertOrReplaceSavedSearchQueryPrepared = false;
@@ -753,6 +1120,9 @@ private:
     QSqlQuery m_updateResourceMetadataWithoutDataPropertiesQuery;
     bool m_updateResourceMetadataWithoutDataPropertiesQueryPrepared = false;
 
+    mutable QSqlQuery m_getResourceBlobHashQuery;
+    mutable bool m_getResourceBlobHashQueryPrepared = false;
+
     QSqlQuery m_insertOrReplaceNoteResourceQuery;
     bool m_insertOrReplaceNoteResourceQueryPrepared = false;
 
@@ -871,6 +1241,58 @@ private:
 
     StringUtils m_stringUtils;
     QVector<QChar> m_preservedAsterisk;
+
+    LocalStorageManager::PerformanceProfile m_performanceProfile;
+
+    // Whether NoteLocationIndex R*Tree table exists; it doesn't if SQLite
+    // is built without R*Tree module or the database is not upgraded yet
+    bool m_noteLocationIndexAvailable = false;
+
+    // The number of currently open transactions; transactions opened while
+    // another one is open are implemented via savepoints
+    mutable int m_transactionNestingLevel = 0;
+
+    // The transaction enclosing the writes made between beginWriteGroup and
+    // commitWriteGroup calls
+    std::unique_ptr<Transaction> m_pWriteGroupTransaction;
+
+    // Whether some resource data blobs might have become orphan within
+    // the currently open transaction
+    bool m_hasPendingOrphanResourceBlobs = false;
+
+    std::shared_ptr<QueryStatisticsCollector> m_pQueryStatistics =
+        std::make_shared<QueryStatisticsCollector>();
+
+    // If true, account high USN values kept in AccountHighUsns table are
+    // checked against the ones computed from all the tables with USNs
+    bool m_verifyAccountHighUsn = false;
+
+    // Guids and local uids of items known to exist in the database; not used
+    // by read-only connections as they don't see the writes which would
+    // change it
+    mutable GuidLocalUidIndex m_guidLocalUidIndex;
+
+    // Snapshots of the recently read or written notes keyed by their local
+    // uids; removed by the writes which change notes bypassing them
+    mutable LRUCache<QString, NoteLocalStorageSnapshot>
+        m_noteLocalStorageSnapshots;
+
+    struct CompiledNoteSearchQuery
+    {
+        QSqlQuery m_query;
+        quint64 m_lastUseCounter = 0;
+    };
+
+    // Compiled note search queries keyed by the printed representation
+    // of parsed note search queries
+    mutable QHash<QString, CompiledNoteSearchQuery> m_compiledNoteSearchQueries;
+    mutable quint64 m_compiledNoteSearchQueriesUseCounter = 0;
+
+    // The value of data_version pragma as of the last check of compiled note
+    // search queries, used to detect changes made by other connections
+    mutable qint64 m_compiledNoteSearchQueriesDataVersion = -1;
+
+    friend class Transaction;
 };
 
 } // namespace quentier
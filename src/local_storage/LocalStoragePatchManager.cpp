@@ -19,6 +19,12 @@
 #include "LocalStoragePatchManager.h"
 #include "LocalStorageManager_p.h"
 #include "patches/LocalStoragePatch1To2.h"
+#include "patches/LocalStoragePatch2To3.h"
+#include "patches/LocalStoragePatch3To4.h"
+#include "patches/LocalStoragePatch4To5.h"
+#include "patches/LocalStoragePatch5To6.h"
+#include "patches/LocalStoragePatch6To7.h"
+#include "patches/LocalStoragePatch7To8.h"
 
 #include <quentier/logging/QuentierLogger.h>
 #include <quentier/types/ErrorString.h>
@@ -56,6 +62,36 @@ LocalStoragePatchManager::patchesForCurrentVersion()
             m_account, m_localStorageManager, m_sqlDatabase));
     }
 
+    if (version <= 2) {
+        result.append(std::make_shared<LocalStoragePatch2To3>(
+            m_account, m_localStorageManager, m_sqlDatabase));
+    }
+
+    if (version <= 3) {
+        result.append(std::make_shared<LocalStoragePatch3To4>(
+            m_account, m_localStorageManager, m_sqlDatabase));
+    }
+
+    if (version <= 4) {
+        result.append(std::make_shared<LocalStoragePatch4To5>(
+            m_account, m_localStorageManager, m_sqlDatabase));
+    }
+
+    if (version <= 5) {
+        result.append(std::make_shared<LocalStoragePatch5To6>(
+            m_account, m_localStorageManager, m_sqlDatabase));
+    }
+
+    if (version <= 6) {
+        result.append(std::make_shared<LocalStoragePatch6To7>(
+            m_account, m_localStorageManager, m_sqlDatabase));
+    }
+
+    if (version <= 7) {
+        result.append(std::make_shared<LocalStoragePatch7To8>(
+            m_account, m_localStorageManager, m_sqlDatabase));
+    }
+
     return result;
 }
 
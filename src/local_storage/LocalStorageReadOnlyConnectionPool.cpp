@@ -0,0 +1,237 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStorageReadOnlyConnectionPool.h"
+#include "LocalStorageManager_p.h"
+
+#include <quentier/local_storage/LocalStorageManager.h>
+#include <quentier/logging/QuentierLogger.h>
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include <algorithm>
+
+namespace quentier {
+
+LocalStorageReadOnlyConnection::LocalStorageReadOnlyConnection(
+    const Account & account, const PerformanceProfile & performanceProfile,
+    std::shared_ptr<QueryStatisticsCollector> pQueryStatistics,
+    QObject * parent) :
+    QObject(parent),
+    m_account(account), m_performanceProfile(performanceProfile),
+    m_pQueryStatistics(std::move(pQueryStatistics))
+{
+    QObject::connect(
+        this, &LocalStorageReadOnlyConnection::readRequestPosted, this,
+        &LocalStorageReadOnlyConnection::onReadRequestPosted,
+        Qt::QueuedConnection);
+}
+
+LocalStorageReadOnlyConnection::~LocalStorageReadOnlyConnection()
+{
+    delete m_pLocalStorageManager;
+}
+
+bool LocalStorageReadOnlyConnection::isInitialized() const
+{
+    return m_pLocalStorageManager != nullptr;
+}
+
+int LocalStorageReadOnlyConnection::pendingRequestCount() const
+{
+    return m_pendingRequestCount.loadAcquire();
+}
+
+void LocalStorageReadOnlyConnection::postReadRequest(
+    ReadFunc readFunc, CompletionFunc completionFunc)
+{
+    m_pendingRequestCount.ref();
+    Q_EMIT readRequestPosted(std::move(readFunc), std::move(completionFunc));
+}
+
+void LocalStorageReadOnlyConnection::init()
+{
+    QNDEBUG("local_storage", "LocalStorageReadOnlyConnection::init");
+
+    if (m_pLocalStorageManager) {
+        return;
+    }
+
+    try {
+        m_pLocalStorageManager = new LocalStorageManager(
+            m_account, LocalStorageManager::StartupOption::ReadOnly,
+            m_performanceProfile);
+
+        m_pLocalStorageManager->d_func()->setQueryStatisticsCollector(
+            m_pQueryStatistics);
+    }
+    catch (const std::exception & e) {
+        QNWARNING(
+            "local_storage",
+            "Failed to open read-only connection to the local storage "
+                << "database: " << e.what());
+        m_pLocalStorageManager = nullptr;
+    }
+}
+
+void LocalStorageReadOnlyConnection::sync() {}
+
+void LocalStorageReadOnlyConnection::onReadRequestPosted(
+    ReadFunc readFunc, CompletionFunc completionFunc)
+{
+    auto * d = m_pLocalStorageManager->d_func();
+
+    // The read request is expected to pass its errors to completionFunc by
+    // itself; exceptions are caught here only to keep them from escaping
+    // the slot, the request is not run again after them
+    try {
+        d->runWithinSelectionTransaction(
+            [&] { readFunc(*m_pLocalStorageManager); });
+    }
+    catch (const std::exception & e) {
+        QNWARNING(
+            "local_storage",
+            "Caught exception from the read request: " << e.what());
+    }
+
+    m_pendingRequestCount.deref();
+    Q_EMIT readRequestFinished(std::move(completionFunc));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LocalStorageReadOnlyConnectionPool::LocalStorageReadOnlyConnectionPool(
+    const Account & account, const int size,
+    const PerformanceProfile & performanceProfile,
+    std::shared_ptr<QueryStatisticsCollector> pQueryStatistics,
+    QObject * parent) :
+    QObject(parent)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageReadOnlyConnectionPool: account = "
+            << account.name() << ", size = " << size);
+
+    qRegisterMetaType<ReadFunc>();
+    qRegisterMetaType<CompletionFunc>();
+
+    m_connections.reserve(std::max(size, 0));
+
+    for (int i = 0; i < size; ++i) {
+        auto * pThread = new QThread;
+        auto * pConnection = new LocalStorageReadOnlyConnection(
+            account, performanceProfile, pQueryStatistics);
+        pConnection->moveToThread(pThread);
+
+        QObject::connect(
+            pThread, &QThread::finished, pConnection,
+            &LocalStorageReadOnlyConnection::deleteLater);
+
+        pThread->start();
+
+        // The connection must be opened within the thread which would use it
+        QMetaObject::invokeMethod(
+            pConnection, "init", Qt::BlockingQueuedConnection);
+
+        if (!pConnection->isInitialized()) {
+            stopConnection(pThread);
+            continue;
+        }
+
+        QObject::connect(
+            pConnection, &LocalStorageReadOnlyConnection::readRequestFinished,
+            this, &LocalStorageReadOnlyConnectionPool::onReadRequestFinished,
+            Qt::QueuedConnection);
+
+        ConnectionData data;
+        data.m_pThread = pThread;
+        data.m_pConnection = pConnection;
+        m_connections << data;
+    }
+}
+
+LocalStorageReadOnlyConnectionPool::~LocalStorageReadOnlyConnectionPool()
+{
+    for (const auto & data: qAsConst(m_connections)) {
+        QObject::disconnect(data.m_pConnection, nullptr, this, nullptr);
+        stopConnection(data.m_pThread);
+    }
+}
+
+int LocalStorageReadOnlyConnectionPool::size() const
+{
+    return m_connections.size();
+}
+
+void LocalStorageReadOnlyConnectionPool::postReadRequest(
+    ReadFunc readFunc, CompletionFunc completionFunc)
+{
+    if (Q_UNLIKELY(m_connections.isEmpty())) {
+        QNWARNING(
+            "local_storage",
+            "LocalStorageReadOnlyConnectionPool: no connections to run "
+                << "the read request");
+        return;
+    }
+
+    auto * pConnection = m_connections[0].m_pConnection;
+    int minPendingRequestCount = pConnection->pendingRequestCount();
+
+    for (const auto & data: qAsConst(m_connections)) {
+        int pendingRequestCount = data.m_pConnection->pendingRequestCount();
+        if (pendingRequestCount < minPendingRequestCount) {
+            minPendingRequestCount = pendingRequestCount;
+            pConnection = data.m_pConnection;
+        }
+    }
+
+    pConnection->postReadRequest(
+        std::move(readFunc), std::move(completionFunc));
+}
+
+void LocalStorageReadOnlyConnectionPool::finishPendingReadRequests()
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageReadOnlyConnectionPool::finishPendingReadRequests");
+
+    for (const auto & data: qAsConst(m_connections)) {
+        QMetaObject::invokeMethod(
+            data.m_pConnection, "sync", Qt::BlockingQueuedConnection);
+    }
+
+    // Notifications about the finished requests are queued to the pool
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
+
+void LocalStorageReadOnlyConnectionPool::onReadRequestFinished(
+    CompletionFunc completionFunc)
+{
+    completionFunc();
+}
+
+void LocalStorageReadOnlyConnectionPool::stopConnection(QThread * pThread)
+{
+    // The connection is deleted within its thread once the thread finishes
+    pThread->quit();
+    pThread->wait();
+    delete pThread;
+}
+
+} // namespace quentier
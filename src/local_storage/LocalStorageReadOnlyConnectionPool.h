@@ -0,0 +1,166 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_READ_ONLY_CONNECTION_POOL_H
+#define LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_READ_ONLY_CONNECTION_POOL_H
+
+#include <quentier/local_storage/LocalStorageManager.h>
+#include <quentier/types/Account.h>
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QVector>
+
+#include <functional>
+#include <memory>
+
+QT_FORWARD_DECLARE_CLASS(QThread)
+
+namespace quentier {
+
+QT_FORWARD_DECLARE_CLASS(QueryStatisticsCollector)
+
+/**
+ * @brief The LocalStorageReadOnlyConnection class owns LocalStorageManager
+ * working with the database in read-only mode and runs read requests against
+ * it within the thread the object lives in. Each request is run within its own
+ * read transaction so that all queries made by it see the same snapshot of
+ * the database.
+ */
+class Q_DECL_HIDDEN LocalStorageReadOnlyConnection final : public QObject
+{
+    Q_OBJECT
+public:
+    using ReadFunc = std::function<void(LocalStorageManager &)>;
+    using CompletionFunc = std::function<void()>;
+
+    using PerformanceProfile = LocalStorageManager::PerformanceProfile;
+
+    LocalStorageReadOnlyConnection(
+        const Account & account, const PerformanceProfile & performanceProfile,
+        std::shared_ptr<QueryStatisticsCollector> pQueryStatistics,
+        QObject * parent = nullptr);
+
+    virtual ~LocalStorageReadOnlyConnection() override;
+
+    bool isInitialized() const;
+
+    int pendingRequestCount() const;
+
+    void postReadRequest(ReadFunc readFunc, CompletionFunc completionFunc);
+
+Q_SIGNALS:
+    void readRequestFinished(CompletionFunc completionFunc);
+
+    // private signals
+    void readRequestPosted(ReadFunc readFunc, CompletionFunc completionFunc);
+
+public Q_SLOTS:
+    void init();
+
+    // Does nothing; as requests are run in the order they are posted, once
+    // the blocking invocation of this slot returns, all the requests posted
+    // before it are finished
+    void sync();
+
+private Q_SLOTS:
+    void onReadRequestPosted(ReadFunc readFunc, CompletionFunc completionFunc);
+
+private:
+    Q_DISABLE_COPY(LocalStorageReadOnlyConnection)
+
+private:
+    Account m_account;
+    PerformanceProfile m_performanceProfile;
+    std::shared_ptr<QueryStatisticsCollector> m_pQueryStatistics;
+    LocalStorageManager * m_pLocalStorageManager = nullptr;
+    QAtomicInt m_pendingRequestCount;
+};
+
+/**
+ * @brief The LocalStorageReadOnlyConnectionPool class maintains a number of
+ * read-only connections to the local storage database, each one within its own
+ * thread, and distributes read requests between them so that the requests can
+ * be served in parallel. The database must already be set up by the primary
+ * LocalStorageManager before the pool is created.
+ */
+class Q_DECL_HIDDEN LocalStorageReadOnlyConnectionPool final : public QObject
+{
+    Q_OBJECT
+public:
+    using ReadFunc = LocalStorageReadOnlyConnection::ReadFunc;
+    using CompletionFunc = LocalStorageReadOnlyConnection::CompletionFunc;
+
+    using PerformanceProfile = LocalStorageManager::PerformanceProfile;
+
+    /**
+     * @param pQueryStatistics      The collector of the primary connection's
+     *                              query statistics; queries made by
+     *                              the connections from the pool are
+     *                              accounted within it as well
+     */
+    LocalStorageReadOnlyConnectionPool(
+        const Account & account, const int size,
+        const PerformanceProfile & performanceProfile,
+        std::shared_ptr<QueryStatisticsCollector> pQueryStatistics,
+        QObject * parent = nullptr);
+
+    virtual ~LocalStorageReadOnlyConnectionPool() override;
+
+    /**
+     * @return      The number of connections which were opened successfully
+     */
+    int size() const;
+
+    /**
+     * Runs readFunc within the thread of the least loaded connection, then
+     * runs completionFunc within the thread the pool lives in
+     */
+    void postReadRequest(ReadFunc readFunc, CompletionFunc completionFunc);
+
+    /**
+     * Blocks until all the read requests posted before are finished and runs
+     * their completion functions; must be called within the thread the pool
+     * lives in
+     */
+    void finishPendingReadRequests();
+
+private Q_SLOTS:
+    void onReadRequestFinished(CompletionFunc completionFunc);
+
+private:
+    Q_DISABLE_COPY(LocalStorageReadOnlyConnectionPool)
+
+    void stopConnection(QThread * pThread);
+
+private:
+    struct ConnectionData
+    {
+        QThread * m_pThread = nullptr;
+        LocalStorageReadOnlyConnection * m_pConnection = nullptr;
+    };
+
+    QVector<ConnectionData> m_connections;
+};
+
+} // namespace quentier
+
+Q_DECLARE_METATYPE(quentier::LocalStorageReadOnlyConnection::ReadFunc)
+Q_DECLARE_METATYPE(quentier::LocalStorageReadOnlyConnection::CompletionFunc)
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_READ_ONLY_CONNECTION_POOL_H
@@ -0,0 +1,501 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStorageRequestScheduler.h"
+
+#include <quentier/logging/QuentierLogger.h>
+
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <vector>
+
+// How long the oldest bulk request may wait while background requests keep
+// coming before it is run ahead of them
+#define BULK_REQUEST_MAX_WAIT_MSEC (1000)
+
+namespace quentier {
+
+LocalStorageRequestScheduler::LocalStorageRequestScheduler(QObject * parent) :
+    QObject(parent)
+{
+    for (size_t i = 0; i < m_queues.size(); ++i) {
+        m_queues[i].m_statistics.m_priority =
+            static_cast<RequestPriority>(i);
+    }
+
+    m_lastRequestTimer.start();
+}
+
+LocalStorageRequestScheduler::~LocalStorageRequestScheduler()
+{
+    QMutexLocker locker(&m_mutex);
+    for (const auto & senderData: qAsConst(m_senders)) {
+        QObject::disconnect(senderData.m_destroyedConnection);
+    }
+}
+
+void LocalStorageRequestScheduler::setSenderPriority(
+    QObject * pSender, const RequestPriority priority)
+{
+    if (Q_UNLIKELY(!pSender)) {
+        return;
+    }
+
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageRequestScheduler::setSenderPriority: sender = "
+            << pSender << ", priority = " << priority);
+
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_senders.find(pSender);
+    if (priority == RequestPriority::Interactive) {
+        if (it != m_senders.end()) {
+            QObject::disconnect(it.value().m_destroyedConnection);
+            m_senders.erase(it);
+        }
+        return;
+    }
+
+    if (it != m_senders.end()) {
+        it.value().m_priority = priority;
+        return;
+    }
+
+    // The sender might be destroyed within any thread so the slot is invoked
+    // directly; the removed key would otherwise be reused by another object
+    SenderData senderData;
+    senderData.m_priority = priority;
+    senderData.m_destroyedConnection = QObject::connect(
+        pSender, &QObject::destroyed, this,
+        [this](QObject * pObject) {
+            QMutexLocker locker(&m_mutex);
+            m_senders.remove(pObject);
+        },
+        Qt::DirectConnection);
+
+    m_senders[pSender] = senderData;
+}
+
+LocalStorageRequestScheduler::RequestPriority
+LocalStorageRequestScheduler::senderPriority(const QObject * pSender) const
+{
+    if (!pSender) {
+        return RequestPriority::Interactive;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_senders.constFind(pSender);
+    if (it == m_senders.constEnd()) {
+        return RequestPriority::Interactive;
+    }
+
+    return it.value().m_priority;
+}
+
+bool LocalStorageRequestScheduler::deferRequest(
+    const QObject * pSender, RequestFunc requestFunc, const bool isWrite,
+    const QString & coalescingKey, const QStringList & writeKeys)
+{
+    if (m_runningDeferredRequest) {
+        return false;
+    }
+
+    m_lastRequestTimer.restart();
+
+    const auto priority = senderPriority(pSender);
+    auto & queue = m_queues[static_cast<size_t>(priority)];
+
+    if (isWrite) {
+        // Reads coming after the write must not get the results of the reads
+        // which might be run before it
+        for (auto & q: m_queues) {
+            q.m_coalescableRequests.clear();
+        }
+    }
+
+    if (priority == RequestPriority::Interactive) {
+        // The write doesn't get ahead of the deferred writes of the same
+        // objects or from the same sender; these are run in order along with
+        // the requests deferred before them within their queues so that reads
+        // don't see the writes sent after them by the same sender
+        if (isWrite) {
+            runConflictingDeferredRequests(pSender, writeKeys);
+        }
+
+        QMutexLocker locker(&m_mutex);
+        ++queue.m_statistics.m_processedRequestCount;
+        return false;
+    }
+
+    const bool coalescable = !isWrite && !coalescingKey.isEmpty();
+    if (coalescable) {
+        // Joining the read from the queue of lower priority might make
+        // the request wait longer than it would have waited on its own
+        for (size_t i = 0; i <= static_cast<size_t>(priority); ++i) {
+            auto & coalescableRequests = m_queues[i].m_coalescableRequests;
+            auto it = coalescableRequests.find(coalescingKey);
+            if (it == coalescableRequests.end()) {
+                continue;
+            }
+
+            it.value()->m_joinedFuncs.push_back(std::move(requestFunc));
+
+            QMutexLocker locker(&m_mutex);
+            ++queue.m_statistics.m_processedRequestCount;
+            return true;
+        }
+    }
+
+    DeferredRequest request;
+    request.m_func = std::move(requestFunc);
+    request.m_timer.start();
+    request.m_write = isWrite;
+    request.m_pSender = pSender;
+    request.m_writeKeys = writeKeys;
+    request.m_coalescingKey = coalescingKey;
+    queue.m_requests.push_back(std::move(request));
+
+    if (coalescable) {
+        queue.m_coalescableRequests[coalescingKey] = &queue.m_requests.back();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        auto & statistics = queue.m_statistics;
+        statistics.m_queueDepth = static_cast<qint64>(queue.m_requests.size());
+
+        statistics.m_maxQueueDepth =
+            std::max(statistics.m_maxQueueDepth, statistics.m_queueDepth);
+    }
+
+    scheduleProcessing();
+    return true;
+}
+
+void LocalStorageRequestScheduler::setWriteGroupFunc(
+    WriteGroupFunc func, const int maxRequestCount, const int maxDurationMsec)
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageRequestScheduler::setWriteGroupFunc: enabled = "
+            << (func ? "true" : "false")
+            << ", max request count = " << maxRequestCount
+            << ", max duration = " << maxDurationMsec << " msec");
+
+    m_writeGroupFunc = std::move(func);
+    m_writeGroupMaxRequestCount = maxRequestCount;
+    m_writeGroupMaxDurationMsec = maxDurationMsec;
+}
+
+void LocalStorageRequestScheduler::setReadGroupFunc(ReadGroupFunc func)
+{
+    m_readGroupFunc = std::move(func);
+}
+
+void LocalStorageRequestScheduler::runDeferredRequests()
+{
+    QNDEBUG(
+        "local_storage", "LocalStorageRequestScheduler::runDeferredRequests");
+
+    while (hasDeferredRequests()) {
+        runNextRequest();
+    }
+}
+
+QList<LocalStorageRequestScheduler::RequestQueueStatistics>
+LocalStorageRequestScheduler::statistics() const
+{
+    QList<RequestQueueStatistics> result;
+    result.reserve(static_cast<int>(m_queues.size()));
+
+    QMutexLocker locker(&m_mutex);
+    for (const auto & queue: m_queues) {
+        result << queue.m_statistics;
+    }
+
+    return result;
+}
+
+void LocalStorageRequestScheduler::resetStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+
+    for (auto & queue: m_queues) {
+        auto & statistics = queue.m_statistics;
+        statistics.m_maxQueueDepth = statistics.m_queueDepth;
+        statistics.m_processedRequestCount = 0;
+        statistics.m_totalWaitDurationUsec = 0;
+        statistics.m_maxWaitDurationUsec = 0;
+    }
+}
+
+void LocalStorageRequestScheduler::processNextRequest()
+{
+    m_processingScheduled = false;
+
+    if (!hasDeferredRequests()) {
+        return;
+    }
+
+    runNextRequest();
+
+    // Requests which have arrived while this one was running get into
+    // the event queue ahead of the next processing
+    if (hasDeferredRequests()) {
+        scheduleProcessing();
+    }
+}
+
+bool LocalStorageRequestScheduler::hasDeferredRequests() const
+{
+    return std::any_of(m_queues.begin(), m_queues.end(), [](const Queue & q) {
+        return !q.m_requests.empty();
+    });
+}
+
+qint64 LocalStorageRequestScheduler::msecsSinceLastRequest() const
+{
+    return m_lastRequestTimer.elapsed();
+}
+
+bool LocalStorageRequestScheduler::isConflictingWrite(
+    const DeferredRequest & request, const QObject * pSender,
+    const QStringList & writeKeys) const
+{
+    if (!request.m_write) {
+        return false;
+    }
+
+    if (pSender && (request.m_pSender == pSender)) {
+        return true;
+    }
+
+    // Empty list of keys means the write might modify any object
+    if (writeKeys.isEmpty() || request.m_writeKeys.isEmpty()) {
+        return true;
+    }
+
+    return std::any_of(
+        writeKeys.begin(), writeKeys.end(), [&](const QString & key) {
+            return request.m_writeKeys.contains(key);
+        });
+}
+
+void LocalStorageRequestScheduler::runConflictingDeferredRequests(
+    const QObject * pSender, const QStringList & writeKeys)
+{
+    for (auto & queue: m_queues) {
+        // Requests up to and including the last conflicting write are run
+        size_t requestCount = 0;
+        for (size_t i = queue.m_requests.size(); i > 0; --i) {
+            const auto & request = queue.m_requests[i - 1];
+            if (isConflictingWrite(request, pSender, writeKeys)) {
+                requestCount = i;
+                break;
+            }
+        }
+
+        if (requestCount == 0) {
+            continue;
+        }
+
+        QNDEBUG(
+            "local_storage",
+            "Running " << requestCount << " deferred requests of "
+                       << queue.m_statistics.m_priority
+                       << " priority before the interactive write request");
+
+        for (size_t i = 0; i < requestCount; ++i) {
+            auto request = takeRequest(queue);
+
+            m_runningDeferredRequest = true;
+            runRequest(request);
+            m_runningDeferredRequest = false;
+        }
+    }
+}
+
+int LocalStorageRequestScheduler::nextQueueIndex() const
+{
+    const auto & backgroundQueue =
+        m_queues[static_cast<size_t>(RequestPriority::Background)];
+
+    const auto & bulkQueue =
+        m_queues[static_cast<size_t>(RequestPriority::Bulk)];
+
+    if (backgroundQueue.m_requests.empty()) {
+        return bulkQueue.m_requests.empty()
+            ? -1
+            : static_cast<int>(RequestPriority::Bulk);
+    }
+
+    if (!bulkQueue.m_requests.empty() &&
+        bulkQueue.m_requests.front().m_timer.hasExpired(
+            BULK_REQUEST_MAX_WAIT_MSEC))
+    {
+        return static_cast<int>(RequestPriority::Bulk);
+    }
+
+    return static_cast<int>(RequestPriority::Background);
+}
+
+void LocalStorageRequestScheduler::runNextRequest()
+{
+    int index = nextQueueIndex();
+    if (index < 0) {
+        return;
+    }
+
+    auto & queue = m_queues[static_cast<size_t>(index)];
+
+    if (m_writeGroupFunc && (m_writeGroupMaxRequestCount > 1) &&
+        queue.m_requests.front().m_write)
+    {
+        runWriteGroup(queue);
+        m_lastRequestTimer.restart();
+        return;
+    }
+
+    auto request = takeRequest(queue);
+
+    m_runningDeferredRequest = true;
+    runRequest(request);
+    m_runningDeferredRequest = false;
+
+    m_lastRequestTimer.restart();
+}
+
+void LocalStorageRequestScheduler::runRequest(DeferredRequest & request)
+{
+    auto runRequests = [&] {
+        request.m_func();
+        for (const auto & func: request.m_joinedFuncs) {
+            func();
+        }
+    };
+
+    if (request.m_joinedFuncs.empty() || !m_readGroupFunc) {
+        runRequests();
+        return;
+    }
+
+    QNDEBUG(
+        "local_storage",
+        "Running the read request along with "
+            << request.m_joinedFuncs.size() << " requests which joined it");
+
+    m_readGroupFunc(runRequests);
+}
+
+void LocalStorageRequestScheduler::runWriteGroup(Queue & queue)
+{
+    std::vector<DeferredRequest> requests;
+
+    auto runRequests = [&] {
+        QElapsedTimer groupTimer;
+        groupTimer.start();
+
+        while (!queue.m_requests.empty() && queue.m_requests.front().m_write) {
+            requests.push_back(takeRequest(queue));
+            requests.back().m_func();
+
+            if ((static_cast<int>(requests.size()) >=
+                 m_writeGroupMaxRequestCount) ||
+                groupTimer.hasExpired(m_writeGroupMaxDurationMsec))
+            {
+                break;
+            }
+        }
+    };
+
+    m_runningDeferredRequest = true;
+    bool res = m_writeGroupFunc(runRequests);
+
+    if (!res) {
+        // The group might have failed even before running the first request
+        if (requests.empty()) {
+            requests.push_back(takeRequest(queue));
+        }
+
+        QNWARNING(
+            "local_storage",
+            "Failed to run the group of " << requests.size()
+                                          << " write requests, running them "
+                                          << "one by one");
+
+        for (auto & request: requests) {
+            request.m_func();
+        }
+    }
+    else {
+        QNDEBUG(
+            "local_storage",
+            "Ran the group of " << requests.size() << " write requests");
+    }
+
+    m_runningDeferredRequest = false;
+}
+
+LocalStorageRequestScheduler::DeferredRequest
+LocalStorageRequestScheduler::takeRequest(Queue & queue)
+{
+    auto & front = queue.m_requests.front();
+    if (!front.m_coalescingKey.isEmpty()) {
+        auto it = queue.m_coalescableRequests.find(front.m_coalescingKey);
+        if ((it != queue.m_coalescableRequests.end()) &&
+            (it.value() == &front))
+        {
+            queue.m_coalescableRequests.erase(it);
+        }
+    }
+
+    auto request = std::move(front);
+    queue.m_requests.pop_front();
+
+    qint64 waitDurationUsec = request.m_timer.nsecsElapsed() / 1000;
+
+    QMutexLocker locker(&m_mutex);
+    auto & statistics = queue.m_statistics;
+    statistics.m_queueDepth = static_cast<qint64>(queue.m_requests.size());
+    ++statistics.m_processedRequestCount;
+    statistics.m_totalWaitDurationUsec += waitDurationUsec;
+
+    statistics.m_maxWaitDurationUsec =
+        std::max(statistics.m_maxWaitDurationUsec, waitDurationUsec);
+
+    return request;
+}
+
+void LocalStorageRequestScheduler::scheduleProcessing()
+{
+    if (m_processingScheduled) {
+        return;
+    }
+
+    m_processingScheduled = true;
+
+    // The invocation is posted behind the requests already waiting in
+    // the event queue so they get a chance to run or to be deferred first
+    QMetaObject::invokeMethod(
+        this, "processNextRequest", Qt::QueuedConnection);
+}
+
+} // namespace quentier
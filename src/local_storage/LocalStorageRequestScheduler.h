@@ -0,0 +1,227 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_REQUEST_SCHEDULER_H
+#define LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_REQUEST_SCHEDULER_H
+
+#include <quentier/local_storage/LocalStorageManagerAsync.h>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace quentier {
+
+/**
+ * @brief The LocalStorageRequestScheduler class decides when requests coming
+ * to LocalStorageManagerAsync are run. Requests are classified by the objects
+ * which sent them: interactive requests are run right away while background
+ * and bulk ones are put into queues which are drained one request per event
+ * loop iteration. Requests already waiting in the thread's event queue are
+ * thus taken off it quickly and interactive requests among them don't wait
+ * for the preceding background and bulk ones to be processed.
+ */
+class Q_DECL_HIDDEN LocalStorageRequestScheduler final : public QObject
+{
+    Q_OBJECT
+public:
+    using RequestPriority = LocalStorageManagerAsync::RequestPriority;
+
+    using RequestQueueStatistics =
+        LocalStorageManagerAsync::RequestQueueStatistics;
+
+    using RequestFunc = std::function<void()>;
+
+    /**
+     * Runs a group of consecutive deferred write requests: the function
+     * passed to it runs the requests themselves
+     *
+     * @return      True if the group was run successfully, false otherwise;
+     *              in the latter case the requests from the group are run
+     *              once again, one by one
+     */
+    using WriteGroupFunc =
+        std::function<bool(const std::function<void()> & runRequests)>;
+
+    /**
+     * Runs a deferred read request along with the same read requests which
+     * have joined it: the function passed to it runs the requests themselves
+     */
+    using ReadGroupFunc =
+        std::function<void(const std::function<void()> & runRequests)>;
+
+    explicit LocalStorageRequestScheduler(QObject * parent = nullptr);
+
+    virtual ~LocalStorageRequestScheduler() override;
+
+    void setSenderPriority(QObject * pSender, const RequestPriority priority);
+    RequestPriority senderPriority(const QObject * pSender) const;
+
+    /**
+     * Puts the request into the queue corresponding to the priority of its
+     * sender unless the request is interactive or the scheduler is running
+     * one of the requests deferred before: in the latter case requestFunc
+     * is exactly that request. Interactive write request is let run only
+     * after the deferred writes of the same objects or from the same sender
+     * along with the requests deferred before them within the same queue so
+     * that it doesn't overtake the deferred writes of the same data; deferred
+     * requests unrelated to it keep waiting
+     *
+     * @param isWrite       True if the request modifies the local storage,
+     *                      false otherwise; consecutive deferred write
+     *                      requests can be run as a group
+     * @param coalescingKey Non-empty key of the read request identifying
+     *                      the reads which would produce the same result;
+     *                      if the read with the same key is already deferred
+     *                      within the queue of the same or higher priority
+     *                      and no write request has come after it,
+     *                      the request joins it instead of getting its own
+     *                      place in the queue
+     * @param writeKeys     Keys of the objects modified by the write request
+     *                      such as local uids and guids; empty list means
+     *                      the request might modify any object
+     * @return              True if the request was deferred, false if it
+     *                      should be run right away
+     */
+    bool deferRequest(
+        const QObject * pSender, RequestFunc requestFunc,
+        const bool isWrite = false,
+        const QString & coalescingKey = QString(),
+        const QStringList & writeKeys = QStringList());
+
+    /**
+     * Sets the function running groups of consecutive deferred write requests
+     * from the same queue; empty function disables grouping
+     *
+     * @param maxRequestCount       The max number of requests in a group
+     * @param maxDurationMsec       The duration after which no more requests
+     *                              are added to the group
+     */
+    void setWriteGroupFunc(
+        WriteGroupFunc func, const int maxRequestCount,
+        const int maxDurationMsec);
+
+    /**
+     * Sets the function running deferred read requests along with the ones
+     * which have joined them; without it the joined requests are run one by
+     * one right after the request they have joined
+     */
+    void setReadGroupFunc(ReadGroupFunc func);
+
+    /**
+     * Synchronously runs all deferred requests in the order in which they
+     * would have been run otherwise
+     */
+    void runDeferredRequests();
+
+    /**
+     * @return      True if there are deferred requests waiting to be run,
+     *              false otherwise
+     */
+    bool hasDeferredRequests() const;
+
+    /**
+     * @return      The number of milliseconds passed since the last request
+     *              came to the scheduler or since the last deferred request
+     *              finished running, whichever is later
+     */
+    qint64 msecsSinceLastRequest() const;
+
+    QList<RequestQueueStatistics> statistics() const;
+    void resetStatistics();
+
+private Q_SLOTS:
+    void processNextRequest();
+
+private:
+    Q_DISABLE_COPY(LocalStorageRequestScheduler)
+
+    struct DeferredRequest
+    {
+        RequestFunc m_func;
+        QElapsedTimer m_timer;
+        bool m_write = false;
+        const QObject * m_pSender = nullptr;
+        QStringList m_writeKeys;
+        QString m_coalescingKey;
+        std::vector<RequestFunc> m_joinedFuncs;
+    };
+
+    struct Queue
+    {
+        std::deque<DeferredRequest> m_requests;
+        RequestQueueStatistics m_statistics;
+
+        // Deferred reads which the same reads coming later can join;
+        // elements of std::deque are not moved by adding or removing
+        // the elements at its ends
+        QHash<QString, DeferredRequest *> m_coalescableRequests;
+    };
+
+    struct SenderData
+    {
+        RequestPriority m_priority = RequestPriority::Interactive;
+        QMetaObject::Connection m_destroyedConnection;
+    };
+
+    bool isConflictingWrite(
+        const DeferredRequest & request, const QObject * pSender,
+        const QStringList & writeKeys) const;
+
+    void runConflictingDeferredRequests(
+        const QObject * pSender, const QStringList & writeKeys);
+
+    int nextQueueIndex() const;
+    void runNextRequest();
+    void runWriteGroup(Queue & queue);
+    void runRequest(DeferredRequest & request);
+    DeferredRequest takeRequest(Queue & queue);
+    void scheduleProcessing();
+
+private:
+    // Guards the senders and the statistics which can be accessed from
+    // any thread; queues themselves are only touched within the thread
+    // the scheduler lives in
+    mutable QMutex m_mutex;
+
+    QHash<const QObject *, SenderData> m_senders;
+    std::array<Queue, 3> m_queues;
+
+    WriteGroupFunc m_writeGroupFunc;
+    ReadGroupFunc m_readGroupFunc;
+    int m_writeGroupMaxRequestCount = 0;
+    int m_writeGroupMaxDurationMsec = 0;
+
+    // Restarted when a request comes and when a deferred request finishes
+    // running
+    QElapsedTimer m_lastRequestTimer;
+
+    bool m_runningDeferredRequest = false;
+    bool m_processingScheduled = false;
+};
+
+} // namespace quentier
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_REQUEST_SCHEDULER_H
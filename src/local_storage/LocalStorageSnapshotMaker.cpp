@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStorageSnapshotMaker.h"
+
+#include <quentier/local_storage/LocalStorageManager.h>
+#include <quentier/logging/QuentierLogger.h>
+
+#include <memory>
+
+namespace quentier {
+
+LocalStorageSnapshotMaker::LocalStorageSnapshotMaker(
+    const Account & account, QString snapshotDirPath, QUuid requestId,
+    QObject * parent) :
+    QObject(parent),
+    m_account(account), m_snapshotDirPath(std::move(snapshotDirPath)),
+    m_requestId(requestId)
+{}
+
+LocalStorageSnapshotMaker::~LocalStorageSnapshotMaker() = default;
+
+void LocalStorageSnapshotMaker::start()
+{
+    QNDEBUG(
+        "local_storage",
+        "LocalStorageSnapshotMaker::start: snapshot dir path = "
+            << m_snapshotDirPath << ", request id = " << m_requestId);
+
+    ErrorString errorDescription;
+    std::unique_ptr<LocalStorageManager> pLocalStorageManager;
+
+    try {
+        // The connection is opened within the thread which would use it
+        pLocalStorageManager = std::make_unique<LocalStorageManager>(
+            m_account, LocalStorageManager::StartupOption::ReadOnly);
+    }
+    catch (const std::exception & e) {
+        errorDescription.setBase(
+            QT_TR_NOOP("Can't create snapshot of the local storage: failed to "
+                       "open connection to the database"));
+        errorDescription.details() = QString::fromUtf8(e.what());
+        QNWARNING("local_storage", errorDescription);
+        Q_EMIT finished(m_snapshotDirPath, errorDescription, m_requestId);
+        return;
+    }
+
+    QObject::connect(
+        pLocalStorageManager.get(), &LocalStorageManager::snapshotProgress,
+        this, [this](double value) { Q_EMIT progress(value, m_requestId); });
+
+    if (!pLocalStorageManager->createSnapshot(
+            m_snapshotDirPath, errorDescription) &&
+        errorDescription.isEmpty())
+    {
+        errorDescription.setBase(
+            QT_TR_NOOP("Can't create snapshot of the local storage"));
+    }
+
+    pLocalStorageManager.reset();
+    Q_EMIT finished(m_snapshotDirPath, errorDescription, m_requestId);
+}
+
+} // namespace quentier
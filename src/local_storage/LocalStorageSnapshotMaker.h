@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_SNAPSHOT_MAKER_H
+#define LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_SNAPSHOT_MAKER_H
+
+#include <quentier/types/Account.h>
+#include <quentier/types/ErrorString.h>
+
+#include <QObject>
+#include <QUuid>
+
+namespace quentier {
+
+/**
+ * @brief The LocalStorageSnapshotMaker class creates the snapshot of the local
+ * storage using its own read-only connection to the database. It is meant to
+ * be moved to a dedicated thread so that neither the thread serving local
+ * storage requests nor the read-only connection pool is occupied for
+ * the duration of the snapshot.
+ */
+class Q_DECL_HIDDEN LocalStorageSnapshotMaker final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalStorageSnapshotMaker(
+        const Account & account, QString snapshotDirPath, QUuid requestId,
+        QObject * parent = nullptr);
+
+    virtual ~LocalStorageSnapshotMaker() override;
+
+Q_SIGNALS:
+    void progress(double progress, QUuid requestId);
+
+    /**
+     * Emitted once the snapshot is either created or failed; error
+     * description is empty in the former case
+     */
+    void finished(
+        QString snapshotDirPath, ErrorString errorDescription, QUuid requestId);
+
+public Q_SLOTS:
+    void start();
+
+private:
+    Q_DISABLE_COPY(LocalStorageSnapshotMaker)
+
+private:
+    Account m_account;
+    QString m_snapshotDirPath;
+    QUuid m_requestId;
+};
+
+} // namespace quentier
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_LOCAL_STORAGE_SNAPSHOT_MAKER_H
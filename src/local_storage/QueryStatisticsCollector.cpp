@@ -0,0 +1,287 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "QueryStatisticsCollector.h"
+
+#include <QMutexLocker>
+#include <QRegularExpression>
+
+#include <algorithm>
+
+// Dynamically built queries might produce a lot of distinct normalized texts;
+// once this number of them is reached, new ones are accounted together
+#define MAX_DISTINCT_QUERIES (1000)
+
+// Queries with literals embedded into them rarely repeat so the remembered
+// normalized texts are dropped once there are this many of them
+#define MAX_REMEMBERED_NORMALIZED_QUERIES (1000)
+
+namespace quentier {
+
+QString QueryStatisticsCollector::normalizeQuery(const QString & query)
+{
+    QString result;
+    result.reserve(query.size());
+
+    const int size = query.size();
+    int i = 0;
+    while (i < size) {
+        const QChar c = query[i];
+
+        if (c == QChar::fromLatin1('\'')) {
+            // Skip the string literal, doubled quotes are escaped ones
+            ++i;
+            while (i < size) {
+                if (query[i] == QChar::fromLatin1('\'')) {
+                    if ((i + 1 < size) &&
+                        (query[i + 1] == QChar::fromLatin1('\'')))
+                    {
+                        i += 2;
+                        continue;
+                    }
+
+                    break;
+                }
+
+                ++i;
+            }
+
+            ++i;
+            result += QChar::fromLatin1('?');
+            continue;
+        }
+
+        if (c.isDigit()) {
+            const QChar previous =
+                (result.isEmpty() ? QChar() : result.at(result.size() - 1));
+            const bool partOfIdentifier = previous.isLetterOrNumber() ||
+                (previous == QChar::fromLatin1('_')) ||
+                (previous == QChar::fromLatin1('.'));
+
+            if (!partOfIdentifier) {
+                while ((i < size) &&
+                       (query[i].isDigit() ||
+                        (query[i] == QChar::fromLatin1('.'))))
+                {
+                    ++i;
+                }
+
+                result += QChar::fromLatin1('?');
+                continue;
+            }
+        }
+
+        if (c.isSpace()) {
+            while ((i < size) && query[i].isSpace()) {
+                ++i;
+            }
+
+            if (!result.isEmpty()) {
+                result += QChar::fromLatin1(' ');
+            }
+
+            continue;
+        }
+
+        result += c;
+        ++i;
+    }
+
+    static const QRegularExpression placeholdersListRegex(
+        QStringLiteral("\\?(\\s*,\\s*\\?)+"));
+
+    result.replace(placeholdersListRegex, QStringLiteral("?, ..."));
+    return result.trimmed();
+}
+
+QString QueryStatisticsCollector::normalizedQuery(const QString & query)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_normalizedQueries.constFind(query);
+    if (it != m_normalizedQueries.constEnd()) {
+        return it.value();
+    }
+
+    if (m_normalizedQueries.size() >= MAX_REMEMBERED_NORMALIZED_QUERIES) {
+        m_normalizedQueries.clear();
+    }
+
+    QString result = normalizeQuery(query);
+    m_normalizedQueries[query] = result;
+    return result;
+}
+
+void QueryStatisticsCollector::recordExecution(
+    const QString & normalizedQuery, const qint64 durationUsec,
+    const bool success, const int rowCount)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto & e = entry(normalizedQuery);
+    auto & stats = e.m_statistics;
+
+    ++stats.m_executionCount;
+    if (!success) {
+        ++stats.m_failureCount;
+    }
+
+    stats.m_rowCount += std::max(rowCount, 0);
+    stats.m_totalDurationUsec += durationUsec;
+    stats.m_maxDurationUsec = std::max(stats.m_maxDurationUsec, durationUsec);
+
+    size_t bucket = 0;
+    while ((bucket + 1 < e.m_histogram.size()) &&
+           ((qint64(1) << bucket) <= durationUsec))
+    {
+        ++bucket;
+    }
+
+    ++e.m_histogram[bucket];
+}
+
+void QueryStatisticsCollector::recordRows(
+    const QString & normalizedQuery, const int rowCount)
+{
+    QMutexLocker locker(&m_mutex);
+    entry(normalizedQuery).m_statistics.m_rowCount += std::max(rowCount, 0);
+}
+
+bool QueryStatisticsCollector::hasQueryPlan(
+    const QString & normalizedQuery) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.constFind(normalizedQuery);
+    if (it == m_entries.constEnd()) {
+        return false;
+    }
+
+    return !it.value().m_statistics.m_queryPlan.isEmpty();
+}
+
+void QueryStatisticsCollector::setQueryPlan(
+    const QString & normalizedQuery, const QString & queryPlan)
+{
+    QMutexLocker locker(&m_mutex);
+    entry(normalizedQuery).m_statistics.m_queryPlan = queryPlan;
+}
+
+QList<QueryStatisticsCollector::QueryStatistics>
+QueryStatisticsCollector::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QList<QueryStatistics> result;
+    result.reserve(m_entries.size());
+
+    for (auto it = m_entries.constBegin(), end = m_entries.constEnd();
+         it != end; ++it)
+    {
+        const auto & e = it.value();
+
+        QueryStatistics stats = e.m_statistics;
+
+        stats.m_medianDurationUsec = percentile(
+            e.m_histogram, stats.m_executionCount, stats.m_maxDurationUsec,
+            0.5);
+
+        stats.m_p90DurationUsec = percentile(
+            e.m_histogram, stats.m_executionCount, stats.m_maxDurationUsec,
+            0.9);
+
+        stats.m_p99DurationUsec = percentile(
+            e.m_histogram, stats.m_executionCount, stats.m_maxDurationUsec,
+            0.99);
+
+        result << stats;
+    }
+
+    std::sort(
+        result.begin(), result.end(),
+        [](const QueryStatistics & lhs, const QueryStatistics & rhs) {
+            return lhs.m_totalDurationUsec > rhs.m_totalDurationUsec;
+        });
+
+    return result;
+}
+
+void QueryStatisticsCollector::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+}
+
+void QueryStatisticsCollector::setSlowQueryThreshold(
+    const qint64 thresholdUsec)
+{
+    QMutexLocker locker(&m_mutex);
+    m_slowQueryThresholdUsec = thresholdUsec;
+}
+
+qint64 QueryStatisticsCollector::slowQueryThreshold() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_slowQueryThresholdUsec;
+}
+
+QueryStatisticsCollector::Entry & QueryStatisticsCollector::entry(
+    const QString & normalizedQuery)
+{
+    auto it = m_entries.find(normalizedQuery);
+    if (it != m_entries.end()) {
+        return it.value();
+    }
+
+    QString query = normalizedQuery;
+    if (m_entries.size() >= MAX_DISTINCT_QUERIES) {
+        query = QStringLiteral("<other queries>");
+        it = m_entries.find(query);
+        if (it != m_entries.end()) {
+            return it.value();
+        }
+    }
+
+    Entry & e = m_entries[query];
+    e.m_statistics.m_query = query;
+    return e;
+}
+
+qint64 QueryStatisticsCollector::percentile(
+    const Histogram & histogram, const qint64 executionCount,
+    const qint64 maxDurationUsec, const double fraction)
+{
+    if (executionCount <= 0) {
+        return 0;
+    }
+
+    const auto threshold = static_cast<qint64>(fraction * executionCount);
+
+    qint64 count = 0;
+    for (size_t bucket = 0; bucket < histogram.size(); ++bucket) {
+        count += histogram[bucket];
+        if (count > threshold) {
+            // The upper bound of the bucket
+            return std::min(qint64(1) << bucket, maxDurationUsec);
+        }
+    }
+
+    return maxDurationUsec;
+}
+
+} // namespace quentier
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_QUERY_STATISTICS_COLLECTOR_H
+#define LIB_QUENTIER_LOCAL_STORAGE_QUERY_STATISTICS_COLLECTOR_H
+
+#include <quentier/local_storage/LocalStorageManager.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <array>
+
+namespace quentier {
+
+/**
+ * @brief The QueryStatisticsCollector class accumulates the statistics
+ * of SQL queries executed by LocalStorageManagerPrivate. Queries are keyed
+ * by their normalized text, see normalizeQuery. The collector is shared by
+ * the primary connection and the read-only ones from the pool which run
+ * within their own threads and the statistics can be requested from any
+ * thread so all the methods are thread-safe.
+ */
+class Q_DECL_HIDDEN QueryStatisticsCollector
+{
+public:
+    using QueryStatistics = LocalStorageManager::QueryStatistics;
+
+    /**
+     * Replaces string and numeric literals within the query with "?",
+     * collapses lists of such placeholders and sequences of whitespace
+     * characters so that queries differing only in values have the same
+     * normalized text
+     */
+    static QString normalizeQuery(const QString & query);
+
+    /**
+     * Same as normalizeQuery but remembers the normalized texts of queries
+     * so that the queries executed over and over again, like the prepared
+     * ones, are only normalized once
+     */
+    QString normalizedQuery(const QString & query);
+
+    void recordExecution(
+        const QString & normalizedQuery, const qint64 durationUsec,
+        const bool success, const int rowCount);
+
+    void recordRows(const QString & normalizedQuery, const int rowCount);
+
+    bool hasQueryPlan(const QString & normalizedQuery) const;
+
+    void setQueryPlan(
+        const QString & normalizedQuery, const QString & queryPlan);
+
+    QList<QueryStatistics> statistics() const;
+
+    void clear();
+
+    void setSlowQueryThreshold(const qint64 thresholdUsec);
+    qint64 slowQueryThreshold() const;
+
+private:
+    // Bucket i holds the number of executions which took less than 2^i usec
+    // but not less than 2^(i-1) usec
+    using Histogram = std::array<qint64, 40>;
+
+    struct Entry
+    {
+        QueryStatistics m_statistics;
+        Histogram m_histogram = {};
+    };
+
+    // Must be called with the mutex locked
+    Entry & entry(const QString & normalizedQuery);
+
+    static qint64 percentile(
+        const Histogram & histogram, const qint64 executionCount,
+        const qint64 maxDurationUsec, const double fraction);
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, QString> m_normalizedQueries;
+    qint64 m_slowQueryThresholdUsec = 0;
+};
+
+} // namespace quentier
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_QUERY_STATISTICS_COLLECTOR_H
@@ -33,7 +33,8 @@ Transaction::Transaction(
     const LocalStorageManagerPrivate & localStorageManager, Type type) :
     m_db(db),
     m_localStorageManager(localStorageManager), m_type(type),
-    m_committed(false), m_rolledBack(false), m_ended(false)
+    m_committed(false), m_rolledBack(false), m_ended(false),
+    m_nestingLevel(localStorageManager.m_transactionNestingLevel)
 {
     init();
 }
@@ -42,7 +43,22 @@ Transaction::~Transaction()
 {
     if ((m_type != Type::Selection) && !m_committed && !m_rolledBack) {
         QSqlQuery query(m_db);
-        bool res = query.exec(QStringLiteral("ROLLBACK"));
+        bool res = false;
+        if (isNested()) {
+            res = m_localStorageManager.execQuery(
+                query,
+                QStringLiteral("ROLLBACK TO SAVEPOINT ") + savepointName());
+            if (res) {
+                res = m_localStorageManager.execQuery(
+                    query,
+                    QStringLiteral("RELEASE SAVEPOINT ") + savepointName());
+            }
+        }
+        else {
+            res = m_localStorageManager.execQuery(
+                query, QStringLiteral("ROLLBACK"));
+        }
+
         if (!res) {
             ErrorString errorMessage(QT_TRANSLATE_NOOP(
                 "Transaction", "Can't rollback the SQL transaction"));
@@ -53,10 +69,17 @@ Transaction::~Transaction()
                 "processPostTransactionException", Qt::QueuedConnection,
                 Q_ARG(ErrorString, errorMessage), Q_ARG(QSqlError, error));
         }
+
+        const_cast<LocalStorageManagerPrivate &>(m_localStorageManager)
+            .onTransactionRolledBack();
     }
     else if ((m_type == Type::Selection) && !m_ended) {
         QSqlQuery query(m_db);
-        bool res = query.exec(QStringLiteral("END"));
+        bool res = m_localStorageManager.execQuery(
+            query,
+            isNested()
+                ? (QStringLiteral("RELEASE SAVEPOINT ") + savepointName())
+                : QStringLiteral("END"));
         if (!res) {
             ErrorString errorMessage(QT_TRANSLATE_NOOP(
                 "Transaction", "Can't end the SQL transaction"));
@@ -68,6 +91,8 @@ Transaction::~Transaction()
                 Q_ARG(ErrorString, errorMessage), Q_ARG(QSqlError, error));
         }
     }
+
+    finish();
 }
 
 bool Transaction::commit(ErrorString & errorDescription)
@@ -79,7 +104,10 @@ bool Transaction::commit(ErrorString & errorDescription)
     }
 
     QSqlQuery query(m_db);
-    bool res = query.exec(QStringLiteral("COMMIT"));
+    bool res = m_localStorageManager.execQuery(
+        query,
+        isNested() ? (QStringLiteral("RELEASE SAVEPOINT ") + savepointName())
+                   : QStringLiteral("COMMIT"));
     if (!res) {
         errorDescription.setBase(QT_TRANSLATE_NOOP(
             "Transaction", "Can't commit the SQL transaction"));
@@ -92,6 +120,13 @@ bool Transaction::commit(ErrorString & errorDescription)
     }
 
     m_committed = true;
+    finish();
+
+    if (!isNested()) {
+        const_cast<LocalStorageManagerPrivate &>(m_localStorageManager)
+            .onTransactionCommitted();
+    }
+
     return true;
 }
 
@@ -104,7 +139,23 @@ bool Transaction::rollback(ErrorString & errorDescription)
     }
 
     QSqlQuery query(m_db);
-    bool res = query.exec(QStringLiteral("ROLLBACK"));
+    bool res = false;
+    if (isNested()) {
+        res = m_localStorageManager.execQuery(
+            query, QStringLiteral("ROLLBACK TO SAVEPOINT ") + savepointName());
+        if (res) {
+            res = m_localStorageManager.execQuery(
+                query, QStringLiteral("RELEASE SAVEPOINT ") + savepointName());
+        }
+    }
+    else {
+        res = m_localStorageManager.execQuery(
+            query, QStringLiteral("ROLLBACK"));
+    }
+
+    const_cast<LocalStorageManagerPrivate &>(m_localStorageManager)
+        .onTransactionRolledBack();
+
     if (!res) {
         errorDescription.setBase(QT_TRANSLATE_NOOP(
             "Transaction", "Can't rollback the SQL transaction"));
@@ -117,6 +168,7 @@ bool Transaction::rollback(ErrorString & errorDescription)
     }
 
     m_rolledBack = true;
+    finish();
     return true;
 }
 
@@ -131,7 +183,10 @@ bool Transaction::end(ErrorString & errorDescription)
     }
 
     QSqlQuery query(m_db);
-    bool res = query.exec(QStringLiteral("END"));
+    bool res = m_localStorageManager.execQuery(
+        query,
+        isNested() ? (QStringLiteral("RELEASE SAVEPOINT ") + savepointName())
+                   : QStringLiteral("END"));
     if (!res) {
         errorDescription.setBase(
             QT_TRANSLATE_NOOP("Transaction", "Can't end the SQL transaction"));
@@ -144,21 +199,31 @@ bool Transaction::end(ErrorString & errorDescription)
     }
 
     m_ended = true;
+    finish();
     return true;
 }
 
 void Transaction::init()
 {
-    QString queryString = QStringLiteral("BEGIN");
-    if (m_type == Type::Immediate) {
-        queryString += QStringLiteral(" IMMEDIATE");
+    QString queryString;
+    if (isNested()) {
+        // SQLite doesn't support nested transactions, savepoints are used
+        // instead; the type of nested transaction is determined by
+        // the enclosing one
+        queryString = QStringLiteral("SAVEPOINT ") + savepointName();
     }
-    else if (m_type == Type::Exclusive) {
-        queryString += QStringLiteral(" EXCLUSIVE");
+    else {
+        queryString = QStringLiteral("BEGIN");
+        if (m_type == Type::Immediate) {
+            queryString += QStringLiteral(" IMMEDIATE");
+        }
+        else if (m_type == Type::Exclusive) {
+            queryString += QStringLiteral(" EXCLUSIVE");
+        }
     }
 
     QSqlQuery query(m_db);
-    bool res = query.exec(queryString);
+    bool res = m_localStorageManager.execQuery(query, queryString);
     if (!res) {
         QNERROR(
             "local_storage",
@@ -170,6 +235,23 @@ void Transaction::init()
         errorDescription.details() = query.lastError().text();
         throw DatabaseRequestException(errorDescription);
     }
+
+    ++m_localStorageManager.m_transactionNestingLevel;
+}
+
+void Transaction::finish()
+{
+    if (m_finished) {
+        return;
+    }
+
+    --m_localStorageManager.m_transactionNestingLevel;
+    m_finished = true;
+}
+
+QString Transaction::savepointName() const
+{
+    return QStringLiteral("transaction_") + QString::number(m_nestingLevel);
 }
 
 } // namespace quentier
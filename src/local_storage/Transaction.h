@@ -55,6 +55,14 @@ private:
     Q_DISABLE_COPY(Transaction)
 
     void init();
+    void finish();
+
+    bool isNested() const
+    {
+        return m_nestingLevel > 0;
+    }
+
+    QString savepointName() const;
 
     const QSqlDatabase & m_db;
     const LocalStorageManagerPrivate & m_localStorageManager;
@@ -64,6 +72,12 @@ private:
     bool m_committed;
     bool m_rolledBack;
     bool m_ended;
+
+    // The number of transactions which were already open when this one was
+    // created; nested transactions are implemented via savepoints so that
+    // they can be committed or rolled back within the enclosing transaction
+    int m_nestingLevel;
+    bool m_finished = false;
 };
 
 } // namespace quentier
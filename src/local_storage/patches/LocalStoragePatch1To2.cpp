@@ -25,22 +25,15 @@
 #include <quentier/types/ErrorString.h>
 #include <quentier/utility/ApplicationSettings.h>
 #include <quentier/utility/Compat.h>
-#include <quentier/utility/EventLoopWithExitStatus.h>
-#include <quentier/utility/FileCopier.h>
-#include <quentier/utility/FileSystem.h>
 #include <quentier/utility/StandardPaths.h>
 #include <quentier/utility/StringUtils.h>
 
 #include <QDir>
 #include <QFile>
-#include <QFileInfo>
-#include <QPointer>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QSqlRecord>
-#include <QThread>
-#include <QTimer>
 
 #define UPGRADE_1_TO_2_PERSISTENCE                                             \
     QStringLiteral("LocalStorageDatabaseUpgradeFromVersion1ToVersion2")
@@ -61,9 +54,7 @@ namespace quentier {
 LocalStoragePatch1To2::LocalStoragePatch1To2(
     const Account & account, LocalStorageManagerPrivate & localStorageManager,
     QSqlDatabase & database, QObject * parent) :
-    ILocalStoragePatch(parent),
-    m_account(account), m_localStorageManager(localStorageManager),
-    m_sqlDatabase(database)
+    LocalStoragePatchBase(account, localStorageManager, database, parent)
 {}
 
 QString LocalStoragePatch1To2::patchShortDescription() const
@@ -142,385 +133,6 @@ QString LocalStoragePatch1To2::patchLongDescription() const
     return result;
 }
 
-bool LocalStoragePatch1To2::backupLocalStorage(ErrorString & errorDescription)
-{
-    QNINFO(
-        "local_storage:patches", "LocalStoragePatch1To2::backupLocalStorage");
-
-    QString storagePath = accountPersistentStoragePath(m_account);
-
-    m_backupDirPath = storagePath + QStringLiteral("/backup_upgrade_1_to_2_") +
-        QDateTime::currentDateTime().toString(Qt::ISODate);
-
-    QDir backupDir(m_backupDirPath);
-    if (!backupDir.exists()) {
-        bool res = backupDir.mkpath(m_backupDirPath);
-        if (!res) {
-            errorDescription.setBase(
-                QT_TR_NOOP("Can't backup local storage: failed to create "
-                           "folder for backup files"));
-
-            errorDescription.details() =
-                QDir::toNativeSeparators(m_backupDirPath);
-
-            QNWARNING("local_storage:patches", errorDescription);
-            return false;
-        }
-    }
-
-    QFileInfo shmDbFileInfo(
-        storagePath + QStringLiteral("/qn.storage.sqlite-shm"));
-
-    if (shmDbFileInfo.exists()) {
-        QString shmDbFileName = shmDbFileInfo.fileName();
-
-        QString shmDbBackupFilePath =
-            m_backupDirPath + QStringLiteral("/") + shmDbFileName;
-
-        QFileInfo shmDbBackupFileInfo(shmDbBackupFilePath);
-        if (shmDbBackupFileInfo.exists() && !removeFile(shmDbBackupFilePath)) {
-            errorDescription.setBase(
-                QT_TR_NOOP("Can't backup local storage: failed to remove "
-                           "pre-existing SQLite shm backup file"));
-
-            errorDescription.details() =
-                QDir::toNativeSeparators(shmDbBackupFilePath);
-
-            QNWARNING("tests:local_storage", errorDescription);
-            return false;
-        }
-
-        QString shmDbFilePath = shmDbFileInfo.absoluteFilePath();
-        if (!QFile::copy(shmDbFilePath, shmDbBackupFilePath)) {
-            errorDescription.setBase(
-                QT_TR_NOOP("Can't backup local storage: "
-                           "failed to backup SQLite shm file"));
-
-            errorDescription.details() =
-                QDir::toNativeSeparators(shmDbFilePath);
-
-            QNWARNING("tests:local_storage", errorDescription);
-            return false;
-        }
-    }
-
-    QFileInfo walDbFileInfo(
-        storagePath + QStringLiteral("/qn.storage.sqlite-wal"));
-
-    if (walDbFileInfo.exists()) {
-        QString walDbFileName = walDbFileInfo.fileName();
-
-        QString walDbBackupFilePath =
-            m_backupDirPath + QStringLiteral("/") + walDbFileName;
-
-        QFileInfo walDbBackupFileInfo(walDbBackupFilePath);
-        if (walDbBackupFileInfo.exists() && !removeFile(walDbBackupFilePath)) {
-            errorDescription.setBase(
-                QT_TR_NOOP("Can't backup local storage: failed to remove "
-                           "pre-existing SQLite wal backup file"));
-
-            errorDescription.details() =
-                QDir::toNativeSeparators(walDbBackupFilePath);
-
-            QNWARNING("tests:local_storage", errorDescription);
-            return false;
-        }
-
-        QString walDbFilePath = walDbFileInfo.absoluteFilePath();
-        if (!QFile::copy(walDbFilePath, walDbBackupFilePath)) {
-            errorDescription.setBase(
-                QT_TR_NOOP("Can't backup local storage: "
-                           "failed to backup SQLite wal file"));
-
-            errorDescription.details() =
-                QDir::toNativeSeparators(walDbFilePath);
-
-            QNWARNING("tests:local_storage", errorDescription);
-            return false;
-        }
-    }
-
-    EventLoopWithExitStatus backupEventLoop;
-
-    auto * pMainDbFileCopierThread = new QThread;
-
-    QObject::connect(
-        pMainDbFileCopierThread, &QThread::finished, pMainDbFileCopierThread,
-        &QThread::deleteLater);
-
-    pMainDbFileCopierThread->start();
-
-    auto * pMainDbFileCopier = new FileCopier;
-    QPointer<FileCopier> pFileCopierQPtr = pMainDbFileCopier;
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::progressUpdate, this,
-        &LocalStoragePatch1To2::backupProgress);
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::notifyError, &backupEventLoop,
-        &EventLoopWithExitStatus::exitAsFailureWithErrorString);
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::finished, &backupEventLoop,
-        &EventLoopWithExitStatus::exitAsSuccess);
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::finished, pMainDbFileCopier,
-        &FileCopier::deleteLater);
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::finished, pMainDbFileCopierThread,
-        &QThread::quit);
-
-    QObject::connect(
-        this, &LocalStoragePatch1To2::copyDbFile, pMainDbFileCopier,
-        &FileCopier::copyFile);
-
-    pMainDbFileCopier->moveToThread(pMainDbFileCopierThread);
-
-    QTimer::singleShot(0, this, SLOT(startLocalStorageBackup()));
-
-    Q_UNUSED(backupEventLoop.exec())
-    auto status = backupEventLoop.exitStatus();
-
-    if (!pFileCopierQPtr.isNull()) {
-        QObject::disconnect(
-            this, &LocalStoragePatch1To2::copyDbFile, pMainDbFileCopier,
-            &FileCopier::copyFile);
-    }
-
-    if (status == EventLoopWithExitStatus::ExitStatus::Failure) {
-        errorDescription = backupEventLoop.errorDescription();
-        return false;
-    }
-
-    return true;
-}
-
-bool LocalStoragePatch1To2::restoreLocalStorageFromBackup(
-    ErrorString & errorDescription)
-{
-    QNINFO(
-        "local_storage:patches",
-        "LocalStoragePatch1To2::restoreLocalStorageFromBackup");
-
-    QString storagePath = accountPersistentStoragePath(m_account);
-    QString shmDbFileName = QStringLiteral("qn.storage.sqlite-shm");
-
-    QFileInfo shmDbBackupFileInfo(
-        m_backupDirPath + QStringLiteral("/") + shmDbFileName);
-
-    if (shmDbBackupFileInfo.exists()) {
-        QString shmDbBackupFilePath = shmDbBackupFileInfo.absoluteFilePath();
-
-        QString shmDbFilePath =
-            storagePath + QStringLiteral("/") + shmDbFileName;
-
-        QFileInfo shmDbFileInfo(shmDbFilePath);
-        if (shmDbFileInfo.exists() && !removeFile(shmDbFilePath)) {
-            errorDescription.setBase(
-                QT_TR_NOOP("Can't restore the local storage "
-                           "from backup: failed to remove "
-                           "the pre-existing SQLite shm file"));
-
-            errorDescription.details() =
-                QDir::toNativeSeparators(shmDbFilePath);
-
-            QNWARNING("tests:local_storage", errorDescription);
-            return false;
-        }
-
-        if (!QFile::copy(shmDbBackupFilePath, shmDbFilePath)) {
-            errorDescription.setBase(
-                QT_TR_NOOP("Can't restore the local storage "
-                           "from backup: failed to restore "
-                           "the SQLite shm file"));
-
-            errorDescription.details() =
-                QDir::toNativeSeparators(shmDbFilePath);
-
-            QNWARNING("tests:local_storage", errorDescription);
-            return false;
-        }
-    }
-
-    QString walDbFileName = QStringLiteral("qn.storage.sqlite-wal");
-
-    QFileInfo walDbBackupFileInfo(
-        m_backupDirPath + QStringLiteral("/") + walDbFileName);
-
-    if (walDbBackupFileInfo.exists()) {
-        QString walDbBackupFilePath = walDbBackupFileInfo.absoluteFilePath();
-
-        QString walDbFilePath =
-            storagePath + QStringLiteral("/") + walDbFileName;
-
-        QFileInfo walDbFileInfo(walDbFilePath);
-        if (walDbFileInfo.exists() && !removeFile(walDbFilePath)) {
-            errorDescription.setBase(
-                QT_TR_NOOP("Can't restore the local storage "
-                           "from backup: failed to remove "
-                           "the pre-existing SQLite wal file"));
-
-            errorDescription.details() =
-                QDir::toNativeSeparators(walDbFilePath);
-
-            QNWARNING("tests:local_storage", errorDescription);
-            return false;
-        }
-
-        if (!QFile::copy(walDbBackupFilePath, walDbFilePath)) {
-            errorDescription.setBase(
-                QT_TR_NOOP("Can't restore the local storage "
-                           "from backup: failed to restore "
-                           "the SQLite wal file"));
-
-            errorDescription.details() =
-                QDir::toNativeSeparators(walDbFilePath);
-
-            QNWARNING("tests:local_storage", errorDescription);
-            return false;
-        }
-    }
-
-    EventLoopWithExitStatus restoreFromBackupEventLoop;
-
-    auto * pMainDbFileCopierThread = new QThread;
-
-    QObject::connect(
-        pMainDbFileCopierThread, &QThread::finished, pMainDbFileCopierThread,
-        &QThread::deleteLater);
-
-    pMainDbFileCopierThread->start();
-
-    auto * pMainDbFileCopier = new FileCopier;
-    QPointer<FileCopier> pFileCopierQPtr = pMainDbFileCopier;
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::progressUpdate, this,
-        &LocalStoragePatch1To2::restoreBackupProgress);
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::notifyError,
-        &restoreFromBackupEventLoop,
-        &EventLoopWithExitStatus::exitAsFailureWithErrorString);
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::finished, &restoreFromBackupEventLoop,
-        &EventLoopWithExitStatus::exitAsSuccess);
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::finished, pMainDbFileCopier,
-        &FileCopier::deleteLater);
-
-    QObject::connect(
-        pMainDbFileCopier, &FileCopier::finished, pMainDbFileCopierThread,
-        &QThread::quit);
-
-    QObject::connect(
-        this, &LocalStoragePatch1To2::copyDbFile, pMainDbFileCopier,
-        &FileCopier::copyFile);
-
-    pMainDbFileCopier->moveToThread(pMainDbFileCopierThread);
-
-    QTimer::singleShot(0, this, SLOT(startLocalStorageRestorationFromBackup()));
-
-    Q_UNUSED(restoreFromBackupEventLoop.exec())
-    auto status = restoreFromBackupEventLoop.exitStatus();
-
-    if (!pFileCopierQPtr.isNull()) {
-        QObject::disconnect(
-            this, &LocalStoragePatch1To2::copyDbFile, pMainDbFileCopier,
-            &FileCopier::copyFile);
-    }
-
-    if (status == EventLoopWithExitStatus::ExitStatus::Failure) {
-        errorDescription = restoreFromBackupEventLoop.errorDescription();
-        return false;
-    }
-
-    return true;
-}
-
-bool LocalStoragePatch1To2::removeLocalStorageBackup(
-    ErrorString & errorDescription)
-{
-    QNINFO(
-        "local_storage:patches",
-        "LocalStoragePatch1To2::removeLocalStorageBackup");
-
-    bool removedShmDbBackup = true;
-
-    QFileInfo shmDbBackupFileInfo(
-        m_backupDirPath + QStringLiteral("/qn.storage.sqlite-shm"));
-
-    if (shmDbBackupFileInfo.exists() &&
-        !removeFile(shmDbBackupFileInfo.absoluteFilePath()))
-    {
-        QNDEBUG(
-            "local_storage:patches",
-            "Failed to remove the SQLite shm "
-                << "file's backup: " << shmDbBackupFileInfo.absoluteFilePath());
-
-        removedShmDbBackup = false;
-    }
-
-    bool removedWalDbBackup = true;
-
-    QFileInfo walDbBackupFileInfo(
-        m_backupDirPath + QStringLiteral("/qn.storage.sqlite-wal"));
-
-    if (walDbBackupFileInfo.exists() &&
-        !removeFile(walDbBackupFileInfo.absoluteFilePath()))
-    {
-        QNDEBUG(
-            "local_storage:patches",
-            "Failed to remove the SQLite wal "
-                << "file's backup: " << walDbBackupFileInfo.absoluteFilePath());
-
-        removedWalDbBackup = false;
-    }
-
-    bool removedDbBackup = true;
-
-    QFileInfo dbBackupFileInfo(
-        m_backupDirPath + QStringLiteral("/qn.storage.sqlite"));
-
-    if (dbBackupFileInfo.exists() &&
-        !removeFile(dbBackupFileInfo.absoluteFilePath()))
-    {
-        QNWARNING(
-            "local_storage:patches",
-            "Failed to remove the SQLite "
-                << "database's backup: "
-                << dbBackupFileInfo.absoluteFilePath());
-
-        removedDbBackup = false;
-    }
-
-    bool removedBackupDir = true;
-    QDir backupDir(m_backupDirPath);
-    if (!backupDir.rmdir(m_backupDirPath)) {
-        QNWARNING(
-            "local_storage:patches",
-            "Failed to remove the SQLite "
-                << "database's backup folder: " << m_backupDirPath);
-
-        removedBackupDir = false;
-    }
-
-    if (!removedShmDbBackup || !removedWalDbBackup || !removedDbBackup ||
-        !removedBackupDir)
-    {
-        errorDescription.setBase(
-            QT_TR_NOOP("Failed to remove some of SQLite database's backups"));
-        return false;
-    }
-
-    return true;
-}
-
 bool LocalStoragePatch1To2::apply(ErrorString & errorDescription)
 {
     QNINFO("local_storage:patches", "LocalStoragePatch1To2::apply");
@@ -1061,36 +673,4 @@ bool LocalStoragePatch1To2::
     return true;
 }
 
-void LocalStoragePatch1To2::startLocalStorageBackup()
-{
-    QNDEBUG(
-        "local_storage:patches",
-        "LocalStoragePatch1To2::startLocalStorageBackup");
-
-    QString storagePath = accountPersistentStoragePath(m_account);
-    QString dbFileName = QStringLiteral("qn.storage.sqlite");
-    QString sourceDbFilePath = storagePath + QStringLiteral("/") + dbFileName;
-
-    QString backupDbFilePath =
-        m_backupDirPath + QStringLiteral("/") + dbFileName;
-
-    Q_EMIT copyDbFile(sourceDbFilePath, backupDbFilePath);
-}
-
-void LocalStoragePatch1To2::startLocalStorageRestorationFromBackup()
-{
-    QNDEBUG(
-        "local_storage:patches",
-        "LocalStoragePatch1To2::startLocalStorageRestorationFromBackup");
-
-    QString storagePath = accountPersistentStoragePath(m_account);
-    QString dbFileName = QStringLiteral("qn.storage.sqlite");
-    QString sourceDbFilePath = storagePath + QStringLiteral("/") + dbFileName;
-
-    QString backupDbFilePath =
-        m_backupDirPath + QStringLiteral("/") + dbFileName;
-
-    Q_EMIT copyDbFile(backupDbFilePath, sourceDbFilePath);
-}
-
 } // namespace quentier
@@ -19,16 +19,11 @@
 #ifndef LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_1_TO_2_H
 #define LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_1_TO_2_H
 
-#include <quentier/local_storage/ILocalStoragePatch.h>
-#include <quentier/types/Account.h>
-
-QT_FORWARD_DECLARE_CLASS(QSqlDatabase)
+#include "LocalStoragePatchBase.h"
 
 namespace quentier {
 
-QT_FORWARD_DECLARE_CLASS(LocalStorageManagerPrivate)
-
-class Q_DECL_HIDDEN LocalStoragePatch1To2 final : public ILocalStoragePatch
+class Q_DECL_HIDDEN LocalStoragePatch1To2 final : public LocalStoragePatchBase
 {
     Q_OBJECT
 public:
@@ -49,24 +44,8 @@ public:
     virtual QString patchShortDescription() const override;
     virtual QString patchLongDescription() const override;
 
-    virtual bool backupLocalStorage(ErrorString & errorDescription) override;
-
-    virtual bool restoreLocalStorageFromBackup(
-        ErrorString & errorDescription) override;
-
-    virtual bool removeLocalStorageBackup(
-        ErrorString & errorDescription) override;
-
     virtual bool apply(ErrorString & errorDescription) override;
 
-    // private
-Q_SIGNALS:
-    void copyDbFile(QString sourcePath, QString destPath);
-
-private Q_SLOTS:
-    void startLocalStorageBackup();
-    void startLocalStorageRestorationFromBackup();
-
 private:
     QStringList listResourceLocalUidsForDatabaseUpgradeFromVersion1ToVersion2(
         ErrorString & errorDescription);
@@ -80,13 +59,6 @@ private:
 
 private:
     Q_DISABLE_COPY(LocalStoragePatch1To2)
-
-private:
-    Account m_account;
-    LocalStorageManagerPrivate & m_localStorageManager;
-    QSqlDatabase & m_sqlDatabase;
-
-    QString m_backupDirPath;
 };
 
 } // namespace quentier
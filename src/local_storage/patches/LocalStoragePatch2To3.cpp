@@ -0,0 +1,176 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStoragePatch2To3.h"
+
+#include "../LocalStorageManager_p.h"
+#include "../LocalStorageShared.h"
+#include "../Transaction.h"
+
+#include <quentier/logging/QuentierLogger.h>
+#include <quentier/types/ErrorString.h>
+#include <quentier/utility/Compat.h>
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace quentier {
+
+LocalStoragePatch2To3::LocalStoragePatch2To3(
+    const Account & account, LocalStorageManagerPrivate & localStorageManager,
+    QSqlDatabase & database, QObject * parent) :
+    LocalStoragePatchBase(account, localStorageManager, database, parent)
+{}
+
+QString LocalStoragePatch2To3::patchShortDescription() const
+{
+    return tr("Maintain full text search index incrementally");
+}
+
+QString LocalStoragePatch2To3::patchLongDescription() const
+{
+    QString result;
+
+    result +=
+        tr("This patch changes the way in which the full text search index "
+           "of notes, notebooks, tags and attachments is kept up to date: "
+           "previously the entire index was rebuilt on each addition of "
+           "an item to the local storage which made the addition slower "
+           "and slower as the number of items in the account grew. After "
+           "the patch the index would be updated only for the added, updated "
+           "or removed item. The existing index would be rebuilt once as "
+           "a part of the patch application so it might take some time "
+           "for accounts with many notes");
+
+    result += QStringLiteral(".\n\n");
+
+    result +=
+        tr("Note that after the upgrade previous versions of Quentier would "
+           "no longer be able to use this account's local storage");
+
+    result += QStringLiteral(".");
+    return result;
+}
+
+bool LocalStoragePatch2To3::apply(ErrorString & errorDescription)
+{
+    QNINFO("local_storage:patches", "LocalStoragePatch2To3::apply");
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to upgrade local storage "
+                   "from version 2 to version 3"));
+
+    errorDescription.clear();
+
+    Transaction transaction(
+        m_sqlDatabase, m_localStorageManager, Transaction::Type::Exclusive);
+
+    const QStringList ftsTableNames = QStringList()
+        << QStringLiteral("NotebookFTS") << QStringLiteral("NoteFTS")
+        << QStringLiteral("ResourceRecognitionDataFTS")
+        << QStringLiteral("ResourceMimeFTS") << QStringLiteral("TagFTS");
+
+    // Part 1: drop triggers rebuilding the whole FTS index on each insertion
+    // and removing index entries by column values rather than by docid
+    QSqlQuery query(m_sqlDatabase);
+    bool res = true;
+
+    for (const auto & ftsTableName: qAsConst(ftsTableNames)) {
+        res = query.exec(
+            QString::fromUtf8("DROP TRIGGER IF EXISTS %1_AfterInsertTrigger")
+                .arg(ftsTableName));
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        res = query.exec(
+            QString::fromUtf8("DROP TRIGGER IF EXISTS %1_BeforeDeleteTrigger")
+                .arg(ftsTableName));
+        DATABASE_CHECK_AND_SET_ERROR()
+    }
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Dropped the old full text search index triggers");
+
+    Q_EMIT progress(0.1);
+
+    // Part 2: create triggers maintaining FTS index incrementally
+    ErrorString error;
+    if (!m_localStorageManager.createFullTextSearchIndexTriggers(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Created the incremental full text search index triggers");
+
+    Q_EMIT progress(0.2);
+
+    // Part 3: rebuild each FTS index once as old triggers could have left
+    // it inconsistent with the content table: the entries of replaced rows
+    // were never removed and the removal of rows by column values could affect
+    // entries of other rows
+    double lastProgress = 0.2;
+    double singleTableProgressFraction =
+        (0.9 - lastProgress) / static_cast<double>(ftsTableNames.size());
+
+    for (const auto & ftsTableName: qAsConst(ftsTableNames)) {
+        res = query.exec(
+            QString::fromUtf8("INSERT INTO %1(%1) VALUES('rebuild')")
+                .arg(ftsTableName));
+        DATABASE_CHECK_AND_SET_ERROR()
+
+        lastProgress += singleTableProgressFraction;
+
+        QNDEBUG(
+            "local_storage:patches",
+            "Rebuilt full text search index " << ftsTableName
+                                              << "; updated progress to "
+                                              << lastProgress);
+
+        Q_EMIT progress(lastProgress);
+    }
+
+    // Part 4: change the version in local storage database
+    res = query.exec(
+        QStringLiteral("INSERT OR REPLACE INTO Auxiliary (version) VALUES(3)"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    error.clear();
+    if (!transaction.commit(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Finished upgrading the local storage "
+            << "from version 2 to version 3");
+    return true;
+}
+
+} // namespace quentier
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_2_TO_3_H
+#define LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_2_TO_3_H
+
+#include "LocalStoragePatchBase.h"
+
+namespace quentier {
+
+class Q_DECL_HIDDEN LocalStoragePatch2To3 final : public LocalStoragePatchBase
+{
+    Q_OBJECT
+public:
+    explicit LocalStoragePatch2To3(
+        const Account & account,
+        LocalStorageManagerPrivate & localStorageManager,
+        QSqlDatabase & database, QObject * parent = nullptr);
+
+    virtual int fromVersion() const override
+    {
+        return 2;
+    }
+    virtual int toVersion() const override
+    {
+        return 3;
+    }
+
+    virtual QString patchShortDescription() const override;
+    virtual QString patchLongDescription() const override;
+
+    virtual bool apply(ErrorString & errorDescription) override;
+
+private:
+    Q_DISABLE_COPY(LocalStoragePatch2To3)
+};
+
+} // namespace quentier
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_2_TO_3_H
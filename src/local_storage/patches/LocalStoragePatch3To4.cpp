@@ -0,0 +1,315 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStoragePatch3To4.h"
+
+#include "../LocalStorageManager_p.h"
+#include "../LocalStorageShared.h"
+#include "../Transaction.h"
+
+#include <quentier/logging/QuentierLogger.h>
+#include <quentier/types/ErrorString.h>
+#include <quentier/utility/Compat.h>
+#include <quentier/utility/FileSystem.h>
+#include <quentier/utility/StandardPaths.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include <utility>
+
+namespace quentier {
+
+LocalStoragePatch3To4::LocalStoragePatch3To4(
+    const Account & account, LocalStorageManagerPrivate & localStorageManager,
+    QSqlDatabase & database, QObject * parent) :
+    LocalStoragePatchBase(account, localStorageManager, database, parent)
+{}
+
+QString LocalStoragePatch3To4::patchShortDescription() const
+{
+    return tr("Deduplicate attachment files");
+}
+
+QString LocalStoragePatch3To4::patchLongDescription() const
+{
+    QString result;
+
+    result +=
+        tr("This patch changes the way in which the data of attachments is "
+           "stored on disk: previously the data of each attachment was stored "
+           "in a separate file even if the very same data was attached to "
+           "multiple notes. After the patch the files would be named after "
+           "the hashes of their contents so that identical attachments would "
+           "only be stored once. The existing attachment files would be "
+           "moved to the new storage as a part of the patch application so "
+           "it might take some time for accounts with many attachments");
+
+    result += QStringLiteral(".\n\n");
+
+    result +=
+        tr("Note that after the upgrade previous versions of Quentier would "
+           "no longer be able to use this account's local storage");
+
+    result += QStringLiteral(".");
+    return result;
+}
+
+bool LocalStoragePatch3To4::apply(ErrorString & errorDescription)
+{
+    QNINFO("local_storage:patches", "LocalStoragePatch3To4::apply");
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to upgrade local storage "
+                   "from version 3 to version 4"));
+
+    errorDescription.clear();
+
+    Transaction transaction(
+        m_sqlDatabase, m_localStorageManager, Transaction::Type::Exclusive);
+
+    // Part 1: create tables of the blob store
+    ErrorString error;
+    if (!m_localStorageManager.createResourceBlobStoreTables(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG(
+        "local_storage:patches", "Created the resource data blob store tables");
+
+    Q_EMIT progress(0.05);
+
+    // Part 2: collect local uids of resources along with local uids of their
+    // notes as these make the paths to resource data files
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(
+        QStringLiteral("SELECT resourceLocalUid, noteLocalUid FROM Resources"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    QList<std::pair<QString, QString>> resourceAndNoteLocalUids;
+    while (query.next()) {
+        resourceAndNoteLocalUids << std::make_pair(
+            query.value(0).toString(), query.value(1).toString());
+    }
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Found " << resourceAndNoteLocalUids.size()
+                 << " resources to move the data of to the blob store");
+
+    Q_EMIT progress(0.1);
+
+    // Part 3: move each resource data file to the blob store
+    QString storagePath = accountPersistentStoragePath(m_account);
+    QString dataPath = storagePath + QStringLiteral("/Resources/data");
+
+    QString alternateDataPath =
+        storagePath + QStringLiteral("/Resources/alternateData");
+
+    double lastProgress = 0.1;
+    double singleResourceProgressFraction =
+        (resourceAndNoteLocalUids.isEmpty()
+             ? 0.0
+             : (0.9 - lastProgress) /
+                 static_cast<double>(resourceAndNoteLocalUids.size()));
+
+    for (const auto & pair: qAsConst(resourceAndNoteLocalUids)) {
+        const QString & resourceLocalUid = pair.first;
+        const QString & noteLocalUid = pair.second;
+
+        for (const bool isAlternateData: {false, true}) {
+            QString filePath =
+                (isAlternateData ? alternateDataPath : dataPath) +
+                QStringLiteral("/") + noteLocalUid + QStringLiteral("/") +
+                resourceLocalUid + QStringLiteral(".dat");
+
+            // Alternate data file might have been left with ".old" suffix
+            // if the process crashed in the middle of its update
+            if (isAlternateData && !QFileInfo::exists(filePath) &&
+                QFileInfo::exists(filePath + QStringLiteral(".old")))
+            {
+                filePath += QStringLiteral(".old");
+            }
+
+            if (!QFileInfo::exists(filePath)) {
+                continue;
+            }
+
+            error.clear();
+            if (!moveResourceDataFileToBlobStore(
+                    resourceLocalUid, filePath, isAlternateData, error))
+            {
+                errorDescription = errorPrefix;
+                errorDescription.appendBase(error.base());
+                errorDescription.appendBase(error.additionalBases());
+                errorDescription.details() = error.details();
+                QNWARNING("local_storage:patches", errorDescription);
+                return false;
+            }
+        }
+
+        lastProgress += singleResourceProgressFraction;
+        Q_EMIT progress(lastProgress);
+    }
+
+    // Part 4: change the version in local storage database
+    res = query.exec(
+        QStringLiteral("INSERT OR REPLACE INTO Auxiliary (version) VALUES(4)"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    error.clear();
+    if (!transaction.commit(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    // Part 5: remove the old resource data files; they were copied rather
+    // than moved so that the local storage could be restored from backup
+    // if the patch failed
+    for (const auto & path: {dataPath, alternateDataPath}) {
+        if (!removeDir(path)) {
+            QNWARNING(
+                "local_storage:patches",
+                "Failed to remove the folder with resource data files "
+                    << "which were moved to the blob store: " << path);
+        }
+    }
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Finished upgrading the local storage "
+            << "from version 3 to version 4");
+    return true;
+}
+
+bool LocalStoragePatch3To4::moveResourceDataFileToBlobStore(
+    const QString & resourceLocalUid, const QString & filePath,
+    const bool isAlternateData, ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "local_storage:patches",
+        "LocalStoragePatch3To4::moveResourceDataFileToBlobStore: "
+            << "resource local uid = " << resourceLocalUid
+            << ", file path = " << filePath);
+
+    ErrorString errorPrefix(QT_TR_NOOP(
+        "failed to move the resource data file to the blob store"));
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("failed to open resource data file for reading"));
+        errorDescription.details() = filePath;
+        return false;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    if (!hash.addData(&file)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(
+            QT_TR_NOOP("failed to read resource data file"));
+        errorDescription.details() = filePath;
+        return false;
+    }
+
+    file.close();
+
+    QString blobHash = QString::fromLatin1(hash.result().toHex());
+
+    QString blobFilePath =
+        m_localStorageManager.resourceBlobFilePath(blobHash);
+
+    if (!QFileInfo::exists(blobFilePath)) {
+        QDir blobDir = QFileInfo(blobFilePath).absoluteDir();
+        if (!blobDir.exists() && !blobDir.mkpath(blobDir.absolutePath())) {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(QT_TR_NOOP(
+                "failed to create directory for resource data blob"));
+            errorDescription.details() = blobDir.absolutePath();
+            return false;
+        }
+
+        QString newBlobFilePath = blobFilePath + QStringLiteral(".new");
+        if (QFileInfo::exists(newBlobFilePath)) {
+            Q_UNUSED(removeFile(newBlobFilePath))
+        }
+
+        if (!QFile::copy(filePath, newBlobFilePath)) {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(QT_TR_NOOP(
+                "failed to copy resource data file to the blob store"));
+            errorDescription.details() = filePath;
+            return false;
+        }
+
+        ErrorString error;
+        if (!renameFile(newBlobFilePath, blobFilePath, error)) {
+            errorDescription = errorPrefix;
+            errorDescription.appendBase(error.base());
+            errorDescription.appendBase(error.additionalBases());
+            errorDescription.details() = error.details();
+            return false;
+        }
+    }
+
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.prepare(QStringLiteral(
+        "INSERT OR IGNORE INTO ResourceBlobs (blobHash, refCount) "
+        "VALUES(:blobHash, 0)"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    query.bindValue(QStringLiteral(":blobHash"), blobHash);
+
+    res = query.exec();
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    res = query.prepare(QStringLiteral(
+        "INSERT INTO ResourceBlobReferences "
+        "(resourceLocalUid, isAlternateData, blobHash) "
+        "VALUES(:resourceLocalUid, :isAlternateData, :blobHash)"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    query.bindValue(QStringLiteral(":resourceLocalUid"), resourceLocalUid);
+
+    query.bindValue(
+        QStringLiteral(":isAlternateData"), (isAlternateData ? 1 : 0));
+
+    query.bindValue(QStringLiteral(":blobHash"), blobHash);
+
+    res = query.exec();
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    return true;
+}
+
+} // namespace quentier
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_3_TO_4_H
+#define LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_3_TO_4_H
+
+#include "LocalStoragePatchBase.h"
+
+namespace quentier {
+
+class Q_DECL_HIDDEN LocalStoragePatch3To4 final : public LocalStoragePatchBase
+{
+    Q_OBJECT
+public:
+    explicit LocalStoragePatch3To4(
+        const Account & account,
+        LocalStorageManagerPrivate & localStorageManager,
+        QSqlDatabase & database, QObject * parent = nullptr);
+
+    virtual int fromVersion() const override
+    {
+        return 3;
+    }
+    virtual int toVersion() const override
+    {
+        return 4;
+    }
+
+    virtual QString patchShortDescription() const override;
+    virtual QString patchLongDescription() const override;
+
+    virtual bool apply(ErrorString & errorDescription) override;
+
+private:
+    Q_DISABLE_COPY(LocalStoragePatch3To4)
+
+    bool moveResourceDataFileToBlobStore(
+        const QString & resourceLocalUid, const QString & filePath,
+        const bool isAlternateData, ErrorString & errorDescription);
+};
+
+} // namespace quentier
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_3_TO_4_H
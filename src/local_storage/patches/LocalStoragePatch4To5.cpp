@@ -0,0 +1,133 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStoragePatch4To5.h"
+
+#include "../LocalStorageManager_p.h"
+#include "../LocalStorageShared.h"
+#include "../Transaction.h"
+
+#include <quentier/logging/QuentierLogger.h>
+#include <quentier/types/ErrorString.h>
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace quentier {
+
+LocalStoragePatch4To5::LocalStoragePatch4To5(
+    const Account & account, LocalStorageManagerPrivate & localStorageManager,
+    QSqlDatabase & database, QObject * parent) :
+    LocalStoragePatchBase(account, localStorageManager, database, parent)
+{}
+
+QString LocalStoragePatch4To5::patchShortDescription() const
+{
+    return tr("Maintain the numbers of notes per notebook and tag");
+}
+
+QString LocalStoragePatch4To5::patchLongDescription() const
+{
+    QString result;
+
+    result +=
+        tr("This patch makes the local storage keep track of the numbers of "
+           "notes per each notebook and tag: previously these numbers were "
+           "computed by going through all the notes each time they were "
+           "requested which could be slow for accounts with many notes. "
+           "The numbers would be computed once as a part of the patch "
+           "application");
+
+    result += QStringLiteral(".\n\n");
+
+    result +=
+        tr("Note that after the upgrade previous versions of Quentier would "
+           "no longer be able to use this account's local storage");
+
+    result += QStringLiteral(".");
+    return result;
+}
+
+bool LocalStoragePatch4To5::apply(ErrorString & errorDescription)
+{
+    QNINFO("local_storage:patches", "LocalStoragePatch4To5::apply");
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to upgrade local storage "
+                   "from version 4 to version 5"));
+
+    errorDescription.clear();
+
+    Transaction transaction(
+        m_sqlDatabase, m_localStorageManager, Transaction::Type::Exclusive);
+
+    // Part 1: create note counter tables along with triggers maintaining them
+    ErrorString error;
+    if (!m_localStorageManager.createNoteCounterTables(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG("local_storage:patches", "Created the note counter tables");
+
+    Q_EMIT progress(0.1);
+
+    // Part 2: fill note counters from the existing notes
+    error.clear();
+    if (!m_localStorageManager.rebuildNoteCounters(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG("local_storage:patches", "Filled the note counters");
+
+    Q_EMIT progress(0.9);
+
+    // Part 3: change the version in local storage database
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(
+        QStringLiteral("INSERT OR REPLACE INTO Auxiliary (version) VALUES(5)"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    error.clear();
+    if (!transaction.commit(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Finished upgrading the local storage "
+            << "from version 4 to version 5");
+    return true;
+}
+
+} // namespace quentier
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStoragePatch5To6.h"
+
+#include "../LocalStorageManager_p.h"
+#include "../LocalStorageShared.h"
+
+#include <quentier/logging/QuentierLogger.h>
+#include <quentier/types/ErrorString.h>
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace quentier {
+
+LocalStoragePatch5To6::LocalStoragePatch5To6(
+    const Account & account, LocalStorageManagerPrivate & localStorageManager,
+    QSqlDatabase & database, QObject * parent) :
+    LocalStoragePatchBase(account, localStorageManager, database, parent)
+{}
+
+QString LocalStoragePatch5To6::patchShortDescription() const
+{
+    return tr("Enable incremental compaction of the local storage database");
+}
+
+QString LocalStoragePatch5To6::patchLongDescription() const
+{
+    QString result;
+
+    result +=
+        tr("This patch switches the local storage database to the mode in "
+           "which the space left after deleted data can be returned to "
+           "the file system in small portions while the local storage is "
+           "idle instead of rebuilding the whole database at once. "
+           "The database would be rebuilt once as a part of the patch "
+           "application which can take a while for large databases");
+
+    result += QStringLiteral(".\n\n");
+
+    result +=
+        tr("Note that after the upgrade previous versions of Quentier would "
+           "no longer be able to use this account's local storage");
+
+    result += QStringLiteral(".");
+    return result;
+}
+
+bool LocalStoragePatch5To6::apply(ErrorString & errorDescription)
+{
+    QNINFO("local_storage:patches", "LocalStoragePatch5To6::apply");
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to upgrade local storage "
+                   "from version 5 to version 6"));
+
+    errorDescription.clear();
+
+    // Part 1: switch the database to incremental vacuum mode; it involves
+    // VACUUM which cannot run within a transaction so the patch doesn't use
+    // one. If the patch is interrupted after this part, applying it again is
+    // harmless
+    ErrorString error;
+    if (!m_localStorageManager.enableIncrementalVacuum(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Switched the local storage database to incremental vacuum mode");
+
+    Q_EMIT progress(0.9);
+
+    // Part 2: change the version in local storage database
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(
+        QStringLiteral("INSERT OR REPLACE INTO Auxiliary (version) VALUES(6)"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Finished upgrading the local storage "
+            << "from version 5 to version 6");
+    return true;
+}
+
+} // namespace quentier
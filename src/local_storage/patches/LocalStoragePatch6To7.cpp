@@ -0,0 +1,119 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStoragePatch6To7.h"
+
+#include "../LocalStorageManager_p.h"
+#include "../LocalStorageShared.h"
+#include "../Transaction.h"
+
+#include <quentier/logging/QuentierLogger.h>
+#include <quentier/types/ErrorString.h>
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace quentier {
+
+LocalStoragePatch6To7::LocalStoragePatch6To7(
+    const Account & account, LocalStorageManagerPrivate & localStorageManager,
+    QSqlDatabase & database, QObject * parent) :
+    LocalStoragePatchBase(account, localStorageManager, database, parent)
+{}
+
+QString LocalStoragePatch6To7::patchShortDescription() const
+{
+    return tr("Keep track of the highest update sequence numbers");
+}
+
+QString LocalStoragePatch6To7::patchLongDescription() const
+{
+    QString result;
+
+    result +=
+        tr("This patch makes the local storage keep the highest update "
+           "sequence numbers of the user's own account and of each linked "
+           "notebook: previously these numbers were computed by going "
+           "through all notebooks, tags, notes, resources, saved searches "
+           "and linked notebooks each time they were requested which could "
+           "be slow for accounts with many notes");
+
+    result += QStringLiteral(".\n\n");
+
+    result +=
+        tr("Note that after the upgrade previous versions of Quentier would "
+           "no longer be able to use this account's local storage");
+
+    result += QStringLiteral(".");
+    return result;
+}
+
+bool LocalStoragePatch6To7::apply(ErrorString & errorDescription)
+{
+    QNINFO("local_storage:patches", "LocalStoragePatch6To7::apply");
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to upgrade local storage "
+                   "from version 6 to version 7"));
+
+    errorDescription.clear();
+
+    Transaction transaction(
+        m_sqlDatabase, m_localStorageManager, Transaction::Type::Exclusive);
+
+    // Part 1: create the table of account high USNs along with triggers
+    // maintaining it; the values would be computed on the first request
+    ErrorString error;
+    if (!m_localStorageManager.createAccountHighUsnTables(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG("local_storage:patches", "Created the account high USN table");
+
+    Q_EMIT progress(0.9);
+
+    // Part 2: change the version in local storage database
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(
+        QStringLiteral("INSERT OR REPLACE INTO Auxiliary (version) VALUES(7)"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    error.clear();
+    if (!transaction.commit(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Finished upgrading the local storage "
+            << "from version 6 to version 7");
+    return true;
+}
+
+} // namespace quentier
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStoragePatch7To8.h"
+
+#include "../LocalStorageManager_p.h"
+#include "../LocalStorageShared.h"
+#include "../Transaction.h"
+
+#include <quentier/logging/QuentierLogger.h>
+#include <quentier/types/ErrorString.h>
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace quentier {
+
+LocalStoragePatch7To8::LocalStoragePatch7To8(
+    const Account & account, LocalStorageManagerPrivate & localStorageManager,
+    QSqlDatabase & database, QObject * parent) :
+    LocalStoragePatchBase(account, localStorageManager, database, parent)
+{}
+
+QString LocalStoragePatch7To8::patchShortDescription() const
+{
+    return tr("Create spatial index of note locations");
+}
+
+QString LocalStoragePatch7To8::patchLongDescription() const
+{
+    QString result;
+
+    result +=
+        tr("This patch creates the spatial index of notes' latitudes, "
+           "longitudes and altitudes which speeds up searching for notes "
+           "by location and finding notes to be shown on the map: "
+           "previously such searches had to go through all the notes "
+           "within the account");
+
+    result += QStringLiteral(".\n\n");
+
+    result +=
+        tr("Note that after the upgrade previous versions of Quentier would "
+           "no longer be able to use this account's local storage");
+
+    result += QStringLiteral(".");
+    return result;
+}
+
+bool LocalStoragePatch7To8::apply(ErrorString & errorDescription)
+{
+    QNINFO("local_storage:patches", "LocalStoragePatch7To8::apply");
+
+    ErrorString errorPrefix(
+        QT_TR_NOOP("failed to upgrade local storage "
+                   "from version 7 to version 8"));
+
+    errorDescription.clear();
+
+    Transaction transaction(
+        m_sqlDatabase, m_localStorageManager, Transaction::Type::Exclusive);
+
+    // Part 1: create the note location index along with triggers maintaining
+    // it and fill it from the existing notes
+    ErrorString error;
+    if (!m_localStorageManager.createNoteLocationIndexTables(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG("local_storage:patches", "Created the note location index");
+
+    Q_EMIT progress(0.9);
+
+    // Part 2: change the version in local storage database
+    QSqlQuery query(m_sqlDatabase);
+    bool res = query.exec(
+        QStringLiteral("INSERT OR REPLACE INTO Auxiliary (version) VALUES(8)"));
+    DATABASE_CHECK_AND_SET_ERROR()
+
+    error.clear();
+    if (!transaction.commit(error)) {
+        errorDescription = errorPrefix;
+        errorDescription.appendBase(error.base());
+        errorDescription.appendBase(error.additionalBases());
+        errorDescription.details() = error.details();
+        QNWARNING("local_storage:patches", errorDescription);
+        return false;
+    }
+
+    QNDEBUG(
+        "local_storage:patches",
+        "Finished upgrading the local storage "
+            << "from version 7 to version 8");
+    return true;
+}
+
+} // namespace quentier
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_BASE_H
+#define LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_BASE_H
+
+#include <quentier/local_storage/ILocalStoragePatch.h>
+#include <quentier/types/Account.h>
+
+QT_FORWARD_DECLARE_CLASS(QSqlDatabase)
+
+namespace quentier {
+
+QT_FORWARD_DECLARE_CLASS(LocalStorageManagerPrivate)
+
+/**
+ * @brief The LocalStoragePatchBase class implements the backup related parts
+ * of ILocalStoragePatch interface which are the same for all local storage
+ * patches: the backup consists of copies of SQLite database files put into
+ * a dedicated folder within the account's persistent storage path
+ */
+class Q_DECL_HIDDEN LocalStoragePatchBase : public ILocalStoragePatch
+{
+    Q_OBJECT
+protected:
+    explicit LocalStoragePatchBase(
+        const Account & account,
+        LocalStorageManagerPrivate & localStorageManager,
+        QSqlDatabase & database, QObject * parent = nullptr);
+
+public:
+    virtual bool backupLocalStorage(ErrorString & errorDescription) override;
+
+    virtual bool restoreLocalStorageFromBackup(
+        ErrorString & errorDescription) override;
+
+    virtual bool removeLocalStorageBackup(
+        ErrorString & errorDescription) override;
+
+    // private
+Q_SIGNALS:
+    void copyDbFile(QString sourcePath, QString destPath);
+
+private Q_SLOTS:
+    void startLocalStorageBackup();
+    void startLocalStorageRestorationFromBackup();
+
+private:
+    Q_DISABLE_COPY(LocalStoragePatchBase)
+
+protected:
+    Account m_account;
+    LocalStorageManagerPrivate & m_localStorageManager;
+    QSqlDatabase & m_sqlDatabase;
+
+    QString m_backupDirPath;
+};
+
+} // namespace quentier
+
+#endif // LIB_QUENTIER_LOCAL_STORAGE_PATCHES_LOCAL_STORAGE_PATCH_BASE_H
@@ -38,6 +38,7 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QThreadPool>
+#include <QTimer>
 #include <QTimerEvent>
 
 #include <algorithm>
@@ -86,6 +87,10 @@
 
 #define THIRTY_DAYS_IN_MSEC (2592000000)
 
+// Max number of tags or notes sent to the local storage within a single batch
+// add or update request
+#define MAX_WRITE_BATCH_SIZE (100)
+
 #define SET_ITEM_TYPE_TO_ERROR()                                               \
     errorDescription.appendBase(QT_TRANSLATE_NOOP(                             \
         "RemoteToLocalSynchronizationManager", "item type is"));               \
@@ -535,15 +540,20 @@ void RemoteToLocalSynchronizationManager::emitAddRequest<Tag>(const Tag & tag)
 
     registerTagPendingAddOrUpdate(tag);
 
-    QUuid addTagRequestId = QUuid::createUuid();
-    Q_UNUSED(m_addTagRequestIds.insert(addTagRequestId));
-    QNTRACE(
-        "synchronization:remote_to_local",
-        "Emitting the request to add "
-            << "tag to local storage: request id = " << addTagRequestId
-            << ", tag: " << tag);
+    if (m_tagsPendingAdd.isEmpty()) {
+        m_addTagsPendingRequestId = QUuid::createUuid();
+        Q_UNUSED(m_addTagsRequestIds.insert(m_addTagsPendingRequestId));
 
-    Q_EMIT addTag(tag, addTagRequestId);
+        // Parent tags precede their children within the batch since tags are
+        // processed in this order
+        QTimer::singleShot(
+            0, this, &RemoteToLocalSynchronizationManager::flushTagsPendingAdd);
+    }
+
+    m_tagsPendingAdd << tag;
+    if (m_tagsPendingAdd.size() >= MAX_WRITE_BATCH_SIZE) {
+        flushTagsPendingAdd();
+    }
 }
 
 template <>
@@ -623,15 +633,134 @@ void RemoteToLocalSynchronizationManager::emitAddRequest<Note>(
 
     registerNotePendingAddOrUpdate(note);
 
-    QUuid addNoteRequestId = QUuid::createUuid();
-    Q_UNUSED(m_addNoteRequestIds.insert(addNoteRequestId));
+    if (m_notesPendingAdd.isEmpty()) {
+        m_addNotesPendingRequestId = QUuid::createUuid();
+        Q_UNUSED(m_addNotesRequestIds.insert(m_addNotesPendingRequestId));
+    }
+
+    m_notesPendingAdd << note;
+    if (m_notesPendingAdd.size() >= MAX_WRITE_BATCH_SIZE) {
+        flushNotesPendingAdd();
+        return;
+    }
+
+    checkNotesPendingAddOrUpdateFlush();
+}
+
+void RemoteToLocalSynchronizationManager::emitUpdateRequest(const Note & note)
+{
+    QNDEBUG(
+        "synchronization:remote_to_local",
+        "RemoteToLocalSynchronizationManager::emitUpdateRequest: " << note);
+
+    if (m_notesPendingUpdate.isEmpty()) {
+        m_updateNotesPendingRequestId = QUuid::createUuid();
+        Q_UNUSED(m_updateNotesRequestIds.insert(m_updateNotesPendingRequestId));
+    }
+
+    m_notesPendingUpdate << note;
+    if (m_notesPendingUpdate.size() >= MAX_WRITE_BATCH_SIZE) {
+        flushNotesPendingUpdate();
+        return;
+    }
+
+    checkNotesPendingAddOrUpdateFlush();
+}
+
+void RemoteToLocalSynchronizationManager::flushTagsPendingAdd()
+{
+    if (m_tagsPendingAdd.isEmpty()) {
+        return;
+    }
+
     QNTRACE(
         "synchronization:remote_to_local",
         "Emitting the request to add "
-            << "note to the local storage: request id = " << addNoteRequestId
-            << ", note: " << note);
+            << m_tagsPendingAdd.size()
+            << " tags to local storage: request id = "
+            << m_addTagsPendingRequestId);
+
+    QList<Tag> tags;
+    tags.swap(m_tagsPendingAdd);
+
+    QUuid requestId = m_addTagsPendingRequestId;
+    m_addTagsPendingRequestId = QUuid();
 
-    Q_EMIT addNote(note, addNoteRequestId);
+    Q_EMIT addTags(tags, requestId);
+}
+
+void RemoteToLocalSynchronizationManager::flushNotesPendingAdd()
+{
+    if (m_notesPendingAdd.isEmpty()) {
+        return;
+    }
+
+    QNTRACE(
+        "synchronization:remote_to_local",
+        "Emitting the request to add "
+            << m_notesPendingAdd.size()
+            << " notes to local storage: request id = "
+            << m_addNotesPendingRequestId);
+
+    QList<Note> notes;
+    notes.swap(m_notesPendingAdd);
+
+    QUuid requestId = m_addNotesPendingRequestId;
+    m_addNotesPendingRequestId = QUuid();
+
+    Q_EMIT addNotes(notes, requestId);
+}
+
+void RemoteToLocalSynchronizationManager::flushNotesPendingUpdate()
+{
+    if (m_notesPendingUpdate.isEmpty()) {
+        return;
+    }
+
+    QNTRACE(
+        "synchronization:remote_to_local",
+        "Emitting the request to update "
+            << m_notesPendingUpdate.size()
+            << " notes in local storage: request id = "
+            << m_updateNotesPendingRequestId);
+
+    QList<Note> notes;
+    notes.swap(m_notesPendingUpdate);
+
+    QUuid requestId = m_updateNotesPendingRequestId;
+    m_updateNotesPendingRequestId = QUuid();
+
+    LocalStorageManager::UpdateNoteOptions options(
+        LocalStorageManager::UpdateNoteOption::UpdateResourceMetadata |
+        LocalStorageManager::UpdateNoteOption::UpdateResourceBinaryData |
+        LocalStorageManager::UpdateNoteOption::UpdateTags);
+
+    Q_EMIT updateNotes(notes, options, requestId);
+}
+
+void RemoteToLocalSynchronizationManager::checkNotesPendingAddOrUpdateFlush()
+{
+    if (!m_notesPendingDownloadForAddingToLocalStorage.isEmpty() ||
+        !m_notesPendingDownloadForUpdatingInLocalStorageByGuid.isEmpty())
+    {
+        QNTRACE(
+            "synchronization:remote_to_local",
+            "Still waiting for the downloads of "
+                << m_notesPendingDownloadForAddingToLocalStorage.size()
+                << " new and "
+                << m_notesPendingDownloadForUpdatingInLocalStorageByGuid.size()
+                << " existing notes before sending the downloaded notes to "
+                << "the local storage");
+        return;
+    }
+
+    flushNotesPendingAddOrUpdate();
+}
+
+void RemoteToLocalSynchronizationManager::flushNotesPendingAddOrUpdate()
+{
+    flushNotesPendingAdd();
+    flushNotesPendingUpdate();
 }
 
 void RemoteToLocalSynchronizationManager::onFindUserCompleted(
@@ -1608,6 +1737,108 @@ void RemoteToLocalSynchronizationManager::onAddTagFailed(
         m_addTagRequestIds);
 }
 
+template <class ElementType>
+void RemoteToLocalSynchronizationManager::onAddDataElementsCompleted(
+    const QList<ElementType> & elements,
+    const QList<ErrorString> & errorDescriptions, const QUuid & requestId,
+    const QString & typeName, QSet<QUuid> & addElementsRequestIds)
+{
+    auto it = addElementsRequestIds.find(requestId);
+    if (it == addElementsRequestIds.end()) {
+        return;
+    }
+
+    QNDEBUG(
+        "synchronization:remote_to_local",
+        "RemoteToLocalSynchronizationManager::"
+            << "onAddDataElementsCompleted<" << typeName
+            << ">: " << elements.size() << " items, requestId = " << requestId);
+
+    Q_UNUSED(addElementsRequestIds.erase(it));
+
+    const ErrorString * pErrorDescription = nullptr;
+    for (int i = 0, size = elements.size(); i < size; ++i) {
+        const ErrorString & errorDescription = errorDescriptions.at(i);
+        if (!errorDescription.isEmpty()) {
+            QNWARNING(
+                "synchronization:remote_to_local",
+                "Failed to add " << typeName << ": " << errorDescription
+                                 << "; " << typeName << " = "
+                                 << elements.at(i));
+
+            if (!pErrorDescription) {
+                pErrorDescription = &errorDescription;
+            }
+
+            continue;
+        }
+
+        performPostAddOrUpdateChecks<ElementType>(elements.at(i));
+    }
+
+    if (pErrorDescription) {
+        ErrorString error(QT_TRANSLATE_NOOP(
+            "RemoteToLocalSynchronizationManager",
+            "Failed to add the data item fetched "
+            "from the remote database to the local storage"));
+        error.additionalBases().append(pErrorDescription->base());
+        error.additionalBases().append(pErrorDescription->additionalBases());
+        error.details() = pErrorDescription->details();
+        QNWARNING("synchronization:remote_to_local", error);
+        Q_EMIT failure(error);
+        return;
+    }
+
+    checkServerDataMergeCompletion();
+}
+
+template <class ElementType>
+void RemoteToLocalSynchronizationManager::onAddDataElementsFailed(
+    const QList<ElementType> & elements, const QUuid & requestId,
+    const ErrorString & errorDescription, const QString & typeName,
+    QSet<QUuid> & addElementsRequestIds)
+{
+    auto it = addElementsRequestIds.find(requestId);
+    if (it == addElementsRequestIds.end()) {
+        return;
+    }
+
+    QNWARNING(
+        "synchronization:remote_to_local",
+        "RemoteToLocalSynchronizationManager::onAddDataElementsFailed<"
+            << typeName << ">: " << elements.size() << " items"
+            << "\nError description = " << errorDescription
+            << ", requestId = " << requestId);
+
+    Q_UNUSED(addElementsRequestIds.erase(it));
+
+    ErrorString error(QT_TRANSLATE_NOOP(
+        "RemoteToLocalSynchronizationManager",
+        "Failed to add the data items fetched "
+        "from the remote database to the local storage"));
+    error.additionalBases().append(errorDescription.base());
+    error.additionalBases().append(errorDescription.additionalBases());
+    error.details() = errorDescription.details();
+    QNWARNING("synchronization:remote_to_local", error);
+    Q_EMIT failure(error);
+}
+
+void RemoteToLocalSynchronizationManager::onAddTagsCompleted(
+    QList<Tag> tags, QList<ErrorString> errorDescriptions, QUuid requestId)
+{
+    onAddDataElementsCompleted(
+        tags, errorDescriptions, requestId, QStringLiteral("Tag"),
+        m_addTagsRequestIds);
+}
+
+void RemoteToLocalSynchronizationManager::onAddTagsFailed(
+    QList<Tag> tags, ErrorString errorDescription, QUuid requestId)
+{
+    onAddDataElementsFailed(
+        tags, requestId, errorDescription, QStringLiteral("Tag"),
+        m_addTagsRequestIds);
+}
+
 void RemoteToLocalSynchronizationManager::onAddSavedSearchFailed(
     SavedSearch search, ErrorString errorDescription, QUuid requestId)
 {
@@ -2848,6 +3079,22 @@ void RemoteToLocalSynchronizationManager::onAddNoteFailed(
         m_addNoteRequestIds);
 }
 
+void RemoteToLocalSynchronizationManager::onAddNotesCompleted(
+    QList<Note> notes, QList<ErrorString> errorDescriptions, QUuid requestId)
+{
+    onAddDataElementsCompleted(
+        notes, errorDescriptions, requestId, QStringLiteral("Note"),
+        m_addNotesRequestIds);
+}
+
+void RemoteToLocalSynchronizationManager::onAddNotesFailed(
+    QList<Note> notes, ErrorString errorDescription, QUuid requestId)
+{
+    onAddDataElementsFailed(
+        notes, requestId, errorDescription, QStringLiteral("Note"),
+        m_addNotesRequestIds);
+}
+
 void RemoteToLocalSynchronizationManager::onUpdateNoteCompleted(
     Note note, LocalStorageManager::UpdateNoteOptions options, QUuid requestId)
 {
@@ -2968,6 +3215,83 @@ void RemoteToLocalSynchronizationManager::onUpdateNoteFailed(
     }
 }
 
+void RemoteToLocalSynchronizationManager::onUpdateNotesCompleted(
+    QList<Note> notes, LocalStorageManager::UpdateNoteOptions options,
+    QList<ErrorString> errorDescriptions, QUuid requestId)
+{
+    Q_UNUSED(options)
+
+    auto it = m_updateNotesRequestIds.find(requestId);
+    if (it == m_updateNotesRequestIds.end()) {
+        return;
+    }
+
+    QNDEBUG(
+        "synchronization:remote_to_local",
+        "RemoteToLocalSynchronizationManager::onUpdateNotesCompleted: "
+            << notes.size() << " notes, request id = " << requestId);
+
+    Q_UNUSED(m_updateNotesRequestIds.erase(it))
+
+    const ErrorString * pErrorDescription = nullptr;
+    for (int i = 0, size = notes.size(); i < size; ++i) {
+        const ErrorString & errorDescription = errorDescriptions.at(i);
+        if (!errorDescription.isEmpty()) {
+            QNWARNING(
+                "synchronization:remote_to_local",
+                "Failed to update note: " << errorDescription
+                                          << "; note = " << notes.at(i));
+
+            if (!pErrorDescription) {
+                pErrorDescription = &errorDescription;
+            }
+
+            continue;
+        }
+
+        performPostAddOrUpdateChecks(notes.at(i));
+    }
+
+    if (pErrorDescription) {
+        ErrorString error(
+            QT_TR_NOOP("Failed to update note in the local storage"));
+        error.additionalBases().append(pErrorDescription->base());
+        error.additionalBases().append(pErrorDescription->additionalBases());
+        error.details() = pErrorDescription->details();
+        Q_EMIT failure(error);
+        return;
+    }
+
+    checkServerDataMergeCompletion();
+}
+
+void RemoteToLocalSynchronizationManager::onUpdateNotesFailed(
+    QList<Note> notes, LocalStorageManager::UpdateNoteOptions options,
+    ErrorString errorDescription, QUuid requestId)
+{
+    Q_UNUSED(options)
+
+    auto it = m_updateNotesRequestIds.find(requestId);
+    if (it == m_updateNotesRequestIds.end()) {
+        return;
+    }
+
+    QNWARNING(
+        "synchronization:remote_to_local",
+        "RemoteToLocalSynchronizationManager::onUpdateNotesFailed: "
+            << notes.size() << " notes\nErrorDescription = "
+            << errorDescription << "\nRequestId = " << requestId);
+
+    Q_UNUSED(m_updateNotesRequestIds.erase(it))
+
+    ErrorString error(
+        QT_TR_NOOP("Failed to update notes in the local storage"));
+    error.additionalBases().append(errorDescription.base());
+    error.additionalBases().append(errorDescription.additionalBases());
+    error.details() = errorDescription.details();
+    Q_EMIT failure(error);
+}
+
 void RemoteToLocalSynchronizationManager::onExpungeNoteCompleted(
     Note note, QUuid requestId)
 {
@@ -3090,6 +3414,9 @@ void RemoteToLocalSynchronizationManager::onNoteThumbnailDownloadingFinished(
 
     note.setThumbnailData(downloadedThumbnailImageData);
 
+    // The note itself might not have been sent to the local storage yet
+    flushNotesPendingAddOrUpdate();
+
     QUuid updateNoteRequestId = QUuid::createUuid();
     Q_UNUSED(m_updateNoteWithThumbnailRequestIds.insert(updateNoteRequestId))
 
@@ -3454,6 +3781,9 @@ void RemoteToLocalSynchronizationManager::onGetNoteAsyncFinished(
             m_notesToUpdatePerAPICallPostponeTimerId[timerId] = note;
         }
 
+        // Notes downloaded before shouldn't wait for the postponed download
+        checkNotesPendingAddOrUpdateFlush();
+
         Q_EMIT rateLimitExceeded(rateLimitSeconds);
         return;
     }
@@ -3572,20 +3902,7 @@ void RemoteToLocalSynchronizationManager::onGetNoteAsyncFinished(
         return;
     }
 
-    QUuid updateNoteRequestId = QUuid::createUuid();
-    Q_UNUSED(m_updateNoteRequestIds.insert(updateNoteRequestId))
-
-    LocalStorageManager::UpdateNoteOptions options(
-        LocalStorageManager::UpdateNoteOption::UpdateResourceMetadata |
-        LocalStorageManager::UpdateNoteOption::UpdateResourceBinaryData |
-        LocalStorageManager::UpdateNoteOption::UpdateTags);
-
-    QNTRACE(
-        "synchronization:remote_to_local",
-        "Emitting the request to update "
-            << "note in local storage: request id = " << updateNoteRequestId
-            << ", note; " << note);
-    Q_EMIT updateNote(note, options, updateNoteRequestId);
+    emitUpdateRequest(note);
 }
 
 void RemoteToLocalSynchronizationManager::onGetResourceAsyncFinished(
@@ -3716,6 +4033,10 @@ void RemoteToLocalSynchronizationManager::onGetResourceAsyncFinished(
 
     checkAndIncrementResourceDownloadProgress(resourceGuid);
 
+    // The note owning the resource might not have been sent to the local
+    // storage yet
+    flushNotesPendingAddOrUpdate();
+
     if (needToAddResource) {
         QString resourceGuid =
             (resource.hasGuid() ? resource.guid() : QString());
@@ -4163,6 +4484,11 @@ void RemoteToLocalSynchronizationManager::connectToLocalStorage()
 
     auto & localStorageManagerAsync = m_manager.localStorageManagerAsync();
 
+    // Lots of data items are written during the sync so requests made
+    // by the user meanwhile should not wait for all of them to be processed
+    localStorageManagerAsync.setRequestSenderPriority(
+        this, LocalStorageManagerAsync::RequestPriority::Bulk);
+
     // Connect local signals with localStorageManagerAsync's slots
     QObject::connect(
         this, &RemoteToLocalSynchronizationManager::addUser,
@@ -4209,12 +4535,24 @@ void RemoteToLocalSynchronizationManager::connectToLocalStorage()
         &localStorageManagerAsync, &LocalStorageManagerAsync::onAddNoteRequest,
         Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
 
+    QObject::connect(
+        this, &RemoteToLocalSynchronizationManager::addNotes,
+        &localStorageManagerAsync,
+        &LocalStorageManagerAsync::onAddNotesRequest,
+        Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
+
     QObject::connect(
         this, &RemoteToLocalSynchronizationManager::updateNote,
         &localStorageManagerAsync,
         &LocalStorageManagerAsync::onUpdateNoteRequest,
         Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
 
+    QObject::connect(
+        this, &RemoteToLocalSynchronizationManager::updateNotes,
+        &localStorageManagerAsync,
+        &LocalStorageManagerAsync::onUpdateNotesRequest,
+        Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
+
     QObject::connect(
         this, &RemoteToLocalSynchronizationManager::findNote,
         &localStorageManagerAsync, &LocalStorageManagerAsync::onFindNoteRequest,
@@ -4231,6 +4569,11 @@ void RemoteToLocalSynchronizationManager::connectToLocalStorage()
         &localStorageManagerAsync, &LocalStorageManagerAsync::onAddTagRequest,
         Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
 
+    QObject::connect(
+        this, &RemoteToLocalSynchronizationManager::addTags,
+        &localStorageManagerAsync, &LocalStorageManagerAsync::onAddTagsRequest,
+        Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
+
     QObject::connect(
         this, &RemoteToLocalSynchronizationManager::updateTag,
         &localStorageManagerAsync,
@@ -4418,6 +4761,16 @@ void RemoteToLocalSynchronizationManager::connectToLocalStorage()
         this, &RemoteToLocalSynchronizationManager::onAddTagFailed,
         Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
 
+    QObject::connect(
+        &localStorageManagerAsync, &LocalStorageManagerAsync::addTagsComplete,
+        this, &RemoteToLocalSynchronizationManager::onAddTagsCompleted,
+        Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
+
+    QObject::connect(
+        &localStorageManagerAsync, &LocalStorageManagerAsync::addTagsFailed,
+        this, &RemoteToLocalSynchronizationManager::onAddTagsFailed,
+        Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
+
     QObject::connect(
         &localStorageManagerAsync, &LocalStorageManagerAsync::updateTagComplete,
         this, &RemoteToLocalSynchronizationManager::onUpdateTagCompleted,
@@ -4606,6 +4959,16 @@ void RemoteToLocalSynchronizationManager::connectToLocalStorage()
         this, &RemoteToLocalSynchronizationManager::onAddNoteFailed,
         Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
 
+    QObject::connect(
+        &localStorageManagerAsync, &LocalStorageManagerAsync::addNotesComplete,
+        this, &RemoteToLocalSynchronizationManager::onAddNotesCompleted,
+        Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
+
+    QObject::connect(
+        &localStorageManagerAsync, &LocalStorageManagerAsync::addNotesFailed,
+        this, &RemoteToLocalSynchronizationManager::onAddNotesFailed,
+        Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
+
     QObject::connect(
         &localStorageManagerAsync,
         &LocalStorageManagerAsync::updateNoteComplete, this,
@@ -4617,6 +4980,18 @@ void RemoteToLocalSynchronizationManager::connectToLocalStorage()
         this, &RemoteToLocalSynchronizationManager::onUpdateNoteFailed,
         Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
 
+    QObject::connect(
+        &localStorageManagerAsync,
+        &LocalStorageManagerAsync::updateNotesComplete, this,
+        &RemoteToLocalSynchronizationManager::onUpdateNotesCompleted,
+        Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
+
+    QObject::connect(
+        &localStorageManagerAsync,
+        &LocalStorageManagerAsync::updateNotesFailed, this,
+        &RemoteToLocalSynchronizationManager::onUpdateNotesFailed,
+        Qt::ConnectionType(Qt::UniqueConnection | Qt::QueuedConnection));
+
     QObject::connect(
         &localStorageManagerAsync,
         &LocalStorageManagerAsync::expungeNoteComplete, this,
@@ -4670,6 +5045,9 @@ void RemoteToLocalSynchronizationManager::disconnectFromLocalStorage()
 
     auto & localStorageManagerAsync = m_manager.localStorageManagerAsync();
 
+    localStorageManagerAsync.setRequestSenderPriority(
+        this, LocalStorageManagerAsync::RequestPriority::Interactive);
+
     // Disconnect local signals from localStorageManagerAsync's slots
     QObject::disconnect(
         this, &RemoteToLocalSynchronizationManager::addUser,
@@ -4709,11 +5087,21 @@ void RemoteToLocalSynchronizationManager::disconnectFromLocalStorage()
         this, &RemoteToLocalSynchronizationManager::addNote,
         &localStorageManagerAsync, &LocalStorageManagerAsync::onAddNoteRequest);
 
+    QObject::disconnect(
+        this, &RemoteToLocalSynchronizationManager::addNotes,
+        &localStorageManagerAsync,
+        &LocalStorageManagerAsync::onAddNotesRequest);
+
     QObject::disconnect(
         this, &RemoteToLocalSynchronizationManager::updateNote,
         &localStorageManagerAsync,
         &LocalStorageManagerAsync::onUpdateNoteRequest);
 
+    QObject::disconnect(
+        this, &RemoteToLocalSynchronizationManager::updateNotes,
+        &localStorageManagerAsync,
+        &LocalStorageManagerAsync::onUpdateNotesRequest);
+
     QObject::disconnect(
         this, &RemoteToLocalSynchronizationManager::findNote,
         &localStorageManagerAsync,
@@ -4728,6 +5116,10 @@ void RemoteToLocalSynchronizationManager::disconnectFromLocalStorage()
         this, &RemoteToLocalSynchronizationManager::addTag,
         &localStorageManagerAsync, &LocalStorageManagerAsync::onAddTagRequest);
 
+    QObject::disconnect(
+        this, &RemoteToLocalSynchronizationManager::addTags,
+        &localStorageManagerAsync, &LocalStorageManagerAsync::onAddTagsRequest);
+
     QObject::disconnect(
         this, &RemoteToLocalSynchronizationManager::updateTag,
         &localStorageManagerAsync,
@@ -4890,6 +5282,14 @@ void RemoteToLocalSynchronizationManager::disconnectFromLocalStorage()
         &localStorageManagerAsync, &LocalStorageManagerAsync::addTagFailed,
         this, &RemoteToLocalSynchronizationManager::onAddTagFailed);
 
+    QObject::disconnect(
+        &localStorageManagerAsync, &LocalStorageManagerAsync::addTagsComplete,
+        this, &RemoteToLocalSynchronizationManager::onAddTagsCompleted);
+
+    QObject::disconnect(
+        &localStorageManagerAsync, &LocalStorageManagerAsync::addTagsFailed,
+        this, &RemoteToLocalSynchronizationManager::onAddTagsFailed);
+
     QObject::disconnect(
         &localStorageManagerAsync, &LocalStorageManagerAsync::updateTagComplete,
         this, &RemoteToLocalSynchronizationManager::onUpdateTagCompleted);
@@ -5033,6 +5433,16 @@ void RemoteToLocalSynchronizationManager::disconnectFromLocalStorage()
         &localStorageManagerAsync, &LocalStorageManagerAsync::updateNoteFailed,
         this, &RemoteToLocalSynchronizationManager::onUpdateNoteFailed);
 
+    QObject::disconnect(
+        &localStorageManagerAsync,
+        &LocalStorageManagerAsync::updateNotesComplete, this,
+        &RemoteToLocalSynchronizationManager::onUpdateNotesCompleted);
+
+    QObject::disconnect(
+        &localStorageManagerAsync,
+        &LocalStorageManagerAsync::updateNotesFailed, this,
+        &RemoteToLocalSynchronizationManager::onUpdateNotesFailed);
+
     QObject::disconnect(
         &localStorageManagerAsync, &LocalStorageManagerAsync::addNoteComplete,
         this, &RemoteToLocalSynchronizationManager::onAddNoteCompleted);
@@ -5041,6 +5451,14 @@ void RemoteToLocalSynchronizationManager::disconnectFromLocalStorage()
         &localStorageManagerAsync, &LocalStorageManagerAsync::addNoteFailed,
         this, &RemoteToLocalSynchronizationManager::onAddNoteFailed);
 
+    QObject::disconnect(
+        &localStorageManagerAsync, &LocalStorageManagerAsync::addNotesComplete,
+        this, &RemoteToLocalSynchronizationManager::onAddNotesCompleted);
+
+    QObject::disconnect(
+        &localStorageManagerAsync, &LocalStorageManagerAsync::addNotesFailed,
+        this, &RemoteToLocalSynchronizationManager::onAddNotesFailed);
+
     QObject::disconnect(
         &localStorageManagerAsync,
         &LocalStorageManagerAsync::expungeNoteComplete, this,
@@ -6647,7 +7065,8 @@ bool RemoteToLocalSynchronizationManager::tagsSyncInProgress() const
          !m_tagsPendingAddOrUpdate.isEmpty() ||
          !m_findTagByGuidRequestIds.isEmpty() ||
          !m_findTagByNameRequestIds.isEmpty() ||
-         !m_addTagRequestIds.isEmpty() || !m_updateTagRequestIds.isEmpty() ||
+         !m_addTagRequestIds.isEmpty() || !m_addTagsRequestIds.isEmpty() ||
+         !m_updateTagRequestIds.isEmpty() ||
          !m_expungeTagRequestIds.isEmpty()))
     {
         QNDEBUG(
@@ -6658,7 +7077,9 @@ bool RemoteToLocalSynchronizationManager::tagsSyncInProgress() const
                 << m_tagsPendingAddOrUpdate.size()
                 << " tags pending add or update within "
                 << "the local storage: pending " << m_addTagRequestIds.size()
-                << " add tag requests and/or " << m_updateTagRequestIds.size()
+                << " add tag requests and/or " << m_addTagsRequestIds.size()
+                << " batch add tags requests and/or "
+                << m_updateTagRequestIds.size()
                 << " update tag requests and/or "
                 << m_findTagByGuidRequestIds.size()
                 << " find tag by guid requests and/or "
@@ -6688,7 +7109,9 @@ bool RemoteToLocalSynchronizationManager::notesSyncInProgress() const
 
     if (!m_notesPendingAddOrUpdate.isEmpty() ||
         !m_findNoteByGuidRequestIds.isEmpty() ||
-        !m_addNoteRequestIds.isEmpty() || !m_updateNoteRequestIds.isEmpty() ||
+        !m_addNoteRequestIds.isEmpty() || !m_addNotesRequestIds.isEmpty() ||
+        !m_updateNoteRequestIds.isEmpty() ||
+        !m_updateNotesRequestIds.isEmpty() ||
         !m_expungeNoteRequestIds.isEmpty() ||
         !m_notesToAddPerAPICallPostponeTimerId.isEmpty() ||
         !m_notesToUpdatePerAPICallPostponeTimerId.isEmpty() ||
@@ -6706,8 +7129,12 @@ bool RemoteToLocalSynchronizationManager::notesSyncInProgress() const
                 << "there are " << m_notesPendingAddOrUpdate.size()
                 << " notes pending add or update within "
                 << "the local storage: pending " << m_addNoteRequestIds.size()
-                << " add note requests and/or " << m_updateNoteRequestIds.size()
+                << " add note requests and/or " << m_addNotesRequestIds.size()
+                << " batch add notes requests and/or "
+                << m_updateNoteRequestIds.size()
                 << " update note requests and/or "
+                << m_updateNotesRequestIds.size()
+                << " batch update notes requests and/or "
                 << m_findNoteByGuidRequestIds.size()
                 << " find note by guid requests and/or "
                 << m_notesToAddPerAPICallPostponeTimerId.size()
@@ -7837,7 +8264,8 @@ void RemoteToLocalSynchronizationManager::checkServerDataMergeCompletion()
         m_tagsPendingAddOrUpdate.isEmpty() &&
         m_findTagByGuidRequestIds.isEmpty() &&
         m_findTagByNameRequestIds.isEmpty() &&
-        m_updateTagRequestIds.isEmpty() && m_addTagRequestIds.isEmpty();
+        m_updateTagRequestIds.isEmpty() && m_addTagRequestIds.isEmpty() &&
+        m_addTagsRequestIds.isEmpty();
 
     if (!tagsReady) {
         QNDEBUG(
@@ -7852,7 +8280,8 @@ void RemoteToLocalSynchronizationManager::checkServerDataMergeCompletion()
                 << "the local storage: pending response for "
                 << m_updateTagRequestIds.size()
                 << " tag update requests and/or " << m_addTagRequestIds.size()
-                << " tag add requests and/or "
+                << " tag add requests and/or " << m_addTagsRequestIds.size()
+                << " batch tag add requests and/or "
                 << m_findTagByGuidRequestIds.size()
                 << " find tag by guid requests and/or "
                 << m_findTagByNameRequestIds.size()
@@ -7947,6 +8376,7 @@ void RemoteToLocalSynchronizationManager::checkServerDataMergeCompletion()
         m_notesPendingAddOrUpdate.isEmpty() &&
         m_findNoteByGuidRequestIds.isEmpty() &&
         m_updateNoteRequestIds.isEmpty() && m_addNoteRequestIds.isEmpty() &&
+        m_addNotesRequestIds.isEmpty() && m_updateNotesRequestIds.isEmpty() &&
         m_notesPendingDownloadForAddingToLocalStorage.isEmpty() &&
         m_notesPendingDownloadForUpdatingInLocalStorageByGuid.isEmpty() &&
         m_notesToAddPerAPICallPostponeTimerId.isEmpty() &&
@@ -7967,8 +8397,12 @@ void RemoteToLocalSynchronizationManager::checkServerDataMergeCompletion()
                 << " notes pending add or update within "
                 << "the local storage: pending response for "
                 << m_updateNoteRequestIds.size()
-                << " note update requests and/or " << m_addNoteRequestIds.size()
-                << " note add requests and/or "
+                << " note update requests and/or "
+                << m_updateNotesRequestIds.size()
+                << " batch note update requests and/or "
+                << m_addNoteRequestIds.size()
+                << " note add requests and/or " << m_addNotesRequestIds.size()
+                << " batch note add requests and/or "
                 << m_findNoteByGuidRequestIds.size()
                 << " find note by guid requests and/or "
                 << m_notesPendingDownloadForAddingToLocalStorage.size()
@@ -8260,6 +8694,9 @@ void RemoteToLocalSynchronizationManager::clear()
     m_linkedNotebookGuidsByFindTagByNameRequestIds.clear();
     m_findTagByGuidRequestIds.clear();
     m_addTagRequestIds.clear();
+    m_addTagsRequestIds.clear();
+    m_tagsPendingAdd.clear();
+    m_addTagsPendingRequestId = QUuid();
     m_updateTagRequestIds.clear();
     m_expungeTagRequestIds.clear();
     m_pendingTagsSyncStart = false;
@@ -8400,7 +8837,13 @@ void RemoteToLocalSynchronizationManager::clear()
     m_expungedNotes.clear();
     m_findNoteByGuidRequestIds.clear();
     m_addNoteRequestIds.clear();
+    m_addNotesRequestIds.clear();
+    m_notesPendingAdd.clear();
+    m_addNotesPendingRequestId = QUuid();
     m_updateNoteRequestIds.clear();
+    m_updateNotesRequestIds.clear();
+    m_notesPendingUpdate.clear();
+    m_updateNotesPendingRequestId = QUuid();
     m_expungeNoteRequestIds.clear();
     m_guidsOfProcessedNonExpungedNotes.clear();
 
@@ -11098,6 +11541,8 @@ void RemoteToLocalSynchronizationManager::processResourceConflictAsNoteConflict(
 
     // Update remote note
     registerNotePendingAddOrUpdate(remoteNote);
+    flushNotesPendingAddOrUpdate();
+
     QUuid updateNoteRequestId = QUuid::createUuid();
     Q_UNUSED(m_updateNoteRequestIds.insert(updateNoteRequestId))
 
@@ -194,11 +194,16 @@ Q_SIGNALS:
     void expungeNotebook(Notebook notebook, QUuid requestId);
 
     void addNote(Note note, QUuid requestId);
+    void addNotes(QList<Note> notes, QUuid requestId);
 
     void updateNote(
         Note note, LocalStorageManager::UpdateNoteOptions options,
         QUuid requestId);
 
+    void updateNotes(
+        QList<Note> notes, LocalStorageManager::UpdateNoteOptions options,
+        QUuid requestId);
+
     void findNote(
         Note note, LocalStorageManager::GetNoteOptions options,
         QUuid requestId);
@@ -206,6 +211,7 @@ Q_SIGNALS:
     void expungeNote(Note note, QUuid requestId);
 
     void addTag(Tag tag, QUuid requestId);
+    void addTags(QList<Tag> tags, QUuid requestId);
     void updateTag(Tag tag, QUuid requestId);
     void findTag(Tag tag, QUuid requestId);
     void expungeTag(Tag tag, QUuid requestId);
@@ -295,6 +301,14 @@ private Q_SLOTS:
 
     void onAddTagCompleted(Tag tag, QUuid requestId);
     void onAddTagFailed(Tag tag, ErrorString errorDescription, QUuid requestId);
+
+    void onAddTagsCompleted(
+        QList<Tag> tags, QList<ErrorString> errorDescriptions,
+        QUuid requestId);
+
+    void onAddTagsFailed(
+        QList<Tag> tags, ErrorString errorDescription, QUuid requestId);
+
     void onUpdateUserCompleted(User user, QUuid requestId);
 
     void onUpdateUserFailed(
@@ -384,6 +398,13 @@ private Q_SLOTS:
     void onAddNoteFailed(
         Note note, ErrorString errorDescription, QUuid requestId);
 
+    void onAddNotesCompleted(
+        QList<Note> notes, QList<ErrorString> errorDescriptions,
+        QUuid requestId);
+
+    void onAddNotesFailed(
+        QList<Note> notes, ErrorString errorDescription, QUuid requestId);
+
     void onUpdateNoteCompleted(
         Note note, LocalStorageManager::UpdateNoteOptions options,
         QUuid requestId);
@@ -392,6 +413,14 @@ private Q_SLOTS:
         Note note, LocalStorageManager::UpdateNoteOptions options,
         ErrorString errorDescription, QUuid requestId);
 
+    void onUpdateNotesCompleted(
+        QList<Note> notes, LocalStorageManager::UpdateNoteOptions options,
+        QList<ErrorString> errorDescriptions, QUuid requestId);
+
+    void onUpdateNotesFailed(
+        QList<Note> notes, LocalStorageManager::UpdateNoteOptions options,
+        ErrorString errorDescription, QUuid requestId);
+
     void onExpungeNoteCompleted(Note note, QUuid requestId);
 
     void onExpungeNoteFailed(
@@ -622,6 +651,34 @@ private:
         const ErrorString & errorDescription, const QString & typeName,
         QSet<QUuid> & addElementRequestIds);
 
+    template <class ElementType>
+    void onAddDataElementsCompleted(
+        const QList<ElementType> & elements,
+        const QList<ErrorString> & errorDescriptions, const QUuid & requestId,
+        const QString & typeName, QSet<QUuid> & addElementsRequestIds);
+
+    template <class ElementType>
+    void onAddDataElementsFailed(
+        const QList<ElementType> & elements, const QUuid & requestId,
+        const ErrorString & errorDescription, const QString & typeName,
+        QSet<QUuid> & addElementsRequestIds);
+
+    // Add requests for tags and notes are accumulated and sent to the local
+    // storage in batches so that each batch is written within a single
+    // transaction; the same goes for updates of downloaded notes
+    void flushTagsPendingAdd();
+    void flushNotesPendingAdd();
+
+    void emitUpdateRequest(const Note & note);
+    void flushNotesPendingUpdate();
+
+    // Notes are accumulated while their downloads are still pending; once
+    // none is pending, the accumulated notes are sent to the local storage.
+    // The notes are also sent before each request which might touch them
+    // so that the request is not served before them
+    void checkNotesPendingAddOrUpdateFlush();
+    void flushNotesPendingAddOrUpdate();
+
     // ========= Update helpers ==========
 
     template <class ElementType>
@@ -976,6 +1033,9 @@ private:
     QHash<QUuid, QString> m_linkedNotebookGuidsByFindTagByNameRequestIds;
     QSet<QUuid> m_findTagByGuidRequestIds;
     QSet<QUuid> m_addTagRequestIds;
+    QSet<QUuid> m_addTagsRequestIds;
+    QList<Tag> m_tagsPendingAdd;
+    QUuid m_addTagsPendingRequestId;
     QSet<QUuid> m_updateTagRequestIds;
     QSet<QUuid> m_expungeTagRequestIds;
     bool m_pendingTagsSyncStart = false;
@@ -1062,7 +1122,13 @@ private:
     QList<QString> m_expungedNotes;
     QSet<QUuid> m_findNoteByGuidRequestIds;
     QSet<QUuid> m_addNoteRequestIds;
+    QSet<QUuid> m_addNotesRequestIds;
+    QList<Note> m_notesPendingAdd;
+    QUuid m_addNotesPendingRequestId;
     QSet<QUuid> m_updateNoteRequestIds;
+    QSet<QUuid> m_updateNotesRequestIds;
+    QList<Note> m_notesPendingUpdate;
+    QUuid m_updateNotesPendingRequestId;
     QSet<QUuid> m_expungeNoteRequestIds;
     QSet<QString> m_guidsOfProcessedNonExpungedNotes;
 
@@ -834,6 +834,11 @@ void SendLocalChangesManager::connectToLocalStorage()
 
     auto & localStorageManagerAsync = m_manager.localStorageManagerAsync();
 
+    // Local changes are sent in the background so requests made by the user
+    // meanwhile should not wait for them
+    localStorageManagerAsync.setRequestSenderPriority(
+        this, LocalStorageManagerAsync::RequestPriority::Background);
+
     // Connect local signals with localStorageManagerAsync's slots
     QObject::connect(
         this, &SendLocalChangesManager::requestLocalUnsynchronizedTags,
@@ -1018,6 +1023,9 @@ void SendLocalChangesManager::disconnectFromLocalStorage()
 
     auto & localStorageManagerAsync = m_manager.localStorageManagerAsync();
 
+    localStorageManagerAsync.setRequestSenderPriority(
+        this, LocalStorageManagerAsync::RequestPriority::Interactive);
+
     // Disconnect local signals from localStorageManagerAsync's slots
     QObject::disconnect(
         this, &SendLocalChangesManager::requestLocalUnsynchronizedTags,
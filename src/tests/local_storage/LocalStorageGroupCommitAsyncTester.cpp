@@ -0,0 +1,235 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStorageGroupCommitAsyncTester.h"
+
+#include <quentier/local_storage/LocalStorageManagerAsync.h>
+#include <quentier/logging/QuentierLogger.h>
+
+// The number of add note requests sent in a row
+#define NOTE_COUNT (20)
+
+// The index of the request adding the note with the same local uid as
+// the first one
+#define DUPLICATE_NOTE_INDEX (10)
+
+namespace quentier {
+namespace test {
+
+LocalStorageGroupCommitAsyncTester::LocalStorageGroupCommitAsyncTester(
+    QObject * parent) :
+    QObject(parent)
+{}
+
+LocalStorageGroupCommitAsyncTester::~LocalStorageGroupCommitAsyncTester()
+{
+    clear();
+}
+
+void LocalStorageGroupCommitAsyncTester::onInitTestCase()
+{
+    clear();
+
+    Account account(
+        QStringLiteral("LocalStorageGroupCommitAsyncTester"),
+        Account::Type::Local);
+
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    // LocalStorageManagerAsync lives within the same thread as the tester
+    // so that all the requests below get into the queue before any of them
+    // is run; the limits are high enough for all of them to form one group
+    m_pLocalStorageManagerAsync =
+        new LocalStorageManagerAsync(account, startupOptions);
+
+    m_pLocalStorageManagerAsync->setGroupCommitEnabled(
+        true, NOTE_COUNT, 60000);
+
+    createConnections();
+    m_pLocalStorageManagerAsync->init();
+
+    m_notebook = Notebook();
+    m_notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorDescription;
+    if (!m_pLocalStorageManagerAsync->localStorageManager()->addNotebook(
+            m_notebook, errorDescription))
+    {
+        Q_EMIT failure(errorDescription.nonLocalizedString());
+        return;
+    }
+
+    m_pLocalStorageManagerAsync->setRequestSenderPriority(
+        this, LocalStorageManagerAsync::RequestPriority::Bulk);
+
+    QString firstNoteLocalUid;
+
+    for (int i = 0; i < NOTE_COUNT; ++i) {
+        Note note;
+        note.setTitle(QStringLiteral("Fake note title #") + QString::number(i));
+
+        note.setContent(
+            QStringLiteral("<en-note><div>The text of fake note #") +
+            QString::number(i) + QStringLiteral("</div></en-note>"));
+
+        note.setCreationTimestamp(1000 + i);
+        note.setModificationTimestamp(2000 + i);
+        note.setNotebookLocalUid(m_notebook.localUid());
+
+        if (i == 0) {
+            firstNoteLocalUid = note.localUid();
+        }
+
+        QUuid requestId = QUuid::createUuid();
+
+        // This note can't be added as the first one already has its local uid
+        if (i == DUPLICATE_NOTE_INDEX) {
+            note.setLocalUid(firstNoteLocalUid);
+            m_duplicateNoteRequestId = requestId;
+        }
+
+        Q_EMIT addNoteRequest(note, requestId);
+    }
+}
+
+void LocalStorageGroupCommitAsyncTester::onAddNoteCompleted(
+    Note note, QUuid requestId)
+{
+    Q_UNUSED(note)
+
+    if (requestId == m_duplicateNoteRequestId) {
+        Q_EMIT failure(
+            QStringLiteral("Note with duplicate local uid was added"));
+        return;
+    }
+
+    if (!checkNoteCount()) {
+        return;
+    }
+
+    ++m_addedNoteCount;
+    checkCompletion();
+}
+
+void LocalStorageGroupCommitAsyncTester::onAddNoteFailed(
+    Note note, ErrorString errorDescription, QUuid requestId)
+{
+    if (requestId != m_duplicateNoteRequestId) {
+        QNWARNING(
+            "tests:local_storage",
+            errorDescription << ", request id = " << requestId
+                             << ", note: " << note);
+
+        Q_EMIT failure(errorDescription.nonLocalizedString());
+        return;
+    }
+
+    if (!checkNoteCount()) {
+        return;
+    }
+
+    m_duplicateNoteFailed = true;
+    checkCompletion();
+}
+
+void LocalStorageGroupCommitAsyncTester::createConnections()
+{
+    // Request --> slot connections; the connection must be queued even though
+    // LocalStorageManagerAsync lives within the same thread
+    QObject::connect(
+        this, &LocalStorageGroupCommitAsyncTester::addNoteRequest,
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::onAddNoteRequest, Qt::QueuedConnection);
+
+    // Slot <-- result connections
+    QObject::connect(
+        m_pLocalStorageManagerAsync, &LocalStorageManagerAsync::addNoteComplete,
+        this, &LocalStorageGroupCommitAsyncTester::onAddNoteCompleted);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync, &LocalStorageManagerAsync::addNoteFailed,
+        this, &LocalStorageGroupCommitAsyncTester::onAddNoteFailed);
+}
+
+void LocalStorageGroupCommitAsyncTester::clear()
+{
+    if (m_pLocalStorageManagerAsync) {
+        m_pLocalStorageManagerAsync->deleteLater();
+        m_pLocalStorageManagerAsync = nullptr;
+    }
+
+    m_duplicateNoteRequestId = QUuid();
+    m_addedNoteCount = 0;
+    m_duplicateNoteFailed = false;
+}
+
+bool LocalStorageGroupCommitAsyncTester::checkNoteCount()
+{
+    // Signals are emitted only after the whole group is committed so by
+    // the time the first one comes all the notes but the duplicate one
+    // must already be in the local storage
+    ErrorString errorDescription;
+    int noteCount =
+        m_pLocalStorageManagerAsync->localStorageManager()->noteCount(
+            errorDescription);
+
+    if (noteCount < 0) {
+        Q_EMIT failure(errorDescription.nonLocalizedString());
+        return false;
+    }
+
+    if (noteCount != NOTE_COUNT - 1) {
+        Q_EMIT failure(
+            QStringLiteral("Unexpected note count on request completion: ") +
+            QString::number(noteCount));
+        return false;
+    }
+
+    return true;
+}
+
+void LocalStorageGroupCommitAsyncTester::checkCompletion()
+{
+    if (!m_duplicateNoteFailed || (m_addedNoteCount != NOTE_COUNT - 1)) {
+        return;
+    }
+
+    const auto statistics =
+        m_pLocalStorageManagerAsync->requestQueueStatistics();
+
+    for (const auto & queueStatistics: qAsConst(statistics)) {
+        if (queueStatistics.m_priority !=
+            LocalStorageManagerAsync::RequestPriority::Bulk)
+        {
+            continue;
+        }
+
+        if (queueStatistics.m_processedRequestCount != NOTE_COUNT) {
+            QNWARNING("tests:local_storage", queueStatistics);
+            Q_EMIT failure(
+                QStringLiteral("Unexpected request queue statistics"));
+            return;
+        }
+    }
+
+    Q_EMIT success();
+}
+
+} // namespace test
+} // namespace quentier
@@ -22,6 +22,9 @@
 
 #include "LinkedNotebookLocalStorageManagerAsyncTester.h"
 #include "LocalStorageCacheAsyncTester.h"
+#include "LocalStorageGroupCommitAsyncTester.h"
+#include "LocalStorageRequestCoalescingAsyncTester.h"
+#include "LocalStorageRequestPriorityAsyncTester.h"
 #include "NoteLocalStorageManagerAsyncTester.h"
 #include "NoteNotebookAndTagListTrackingAsyncTester.h"
 #include "NotebookLocalStorageManagerAsyncTester.h"
@@ -471,5 +474,155 @@ void TestCacheAsync()
     }
 }
 
+void TestRequestPriorityAsync()
+{
+    EventLoopWithExitStatus::ExitStatus status =
+        EventLoopWithExitStatus::ExitStatus::Failure;
+    {
+        QTimer timer;
+        timer.setInterval(MAX_ALLOWED_TEST_DURATION_MSEC);
+        timer.setSingleShot(true);
+
+        LocalStorageRequestPriorityAsyncTester requestPriorityAsyncTester;
+        EventLoopWithExitStatus loop;
+
+        QObject::connect(
+            &timer, &QTimer::timeout, &loop,
+            &EventLoopWithExitStatus::exitAsTimeout);
+
+        QObject::connect(
+            &requestPriorityAsyncTester,
+            &LocalStorageRequestPriorityAsyncTester::success, &loop,
+            &EventLoopWithExitStatus::exitAsSuccess);
+
+        QObject::connect(
+            &requestPriorityAsyncTester,
+            &LocalStorageRequestPriorityAsyncTester::failure, &loop,
+            &EventLoopWithExitStatus::exitAsFailureWithError);
+
+        QTimer slotInvokingTimer;
+        slotInvokingTimer.setInterval(500);
+        slotInvokingTimer.setSingleShot(true);
+
+        timer.start();
+        slotInvokingTimer.singleShot(
+            0, &requestPriorityAsyncTester, SLOT(onInitTestCase()));
+
+        Q_UNUSED(loop.exec())
+        status = loop.exitStatus();
+    }
+
+    if (status == EventLoopWithExitStatus::ExitStatus::Failure) {
+        QFAIL(
+            "Detected failure during the asynchronous loop processing in "
+            "local storage request priority async tester");
+    }
+    else if (status == EventLoopWithExitStatus::ExitStatus::Timeout) {
+        QFAIL(
+            "Local storage request priority async tester failed to finish "
+            "in time");
+    }
+}
+
+void TestGroupCommitAsync()
+{
+    EventLoopWithExitStatus::ExitStatus status =
+        EventLoopWithExitStatus::ExitStatus::Failure;
+    {
+        QTimer timer;
+        timer.setInterval(MAX_ALLOWED_TEST_DURATION_MSEC);
+        timer.setSingleShot(true);
+
+        LocalStorageGroupCommitAsyncTester groupCommitAsyncTester;
+        EventLoopWithExitStatus loop;
+
+        QObject::connect(
+            &timer, &QTimer::timeout, &loop,
+            &EventLoopWithExitStatus::exitAsTimeout);
+
+        QObject::connect(
+            &groupCommitAsyncTester,
+            &LocalStorageGroupCommitAsyncTester::success, &loop,
+            &EventLoopWithExitStatus::exitAsSuccess);
+
+        QObject::connect(
+            &groupCommitAsyncTester,
+            &LocalStorageGroupCommitAsyncTester::failure, &loop,
+            &EventLoopWithExitStatus::exitAsFailureWithError);
+
+        QTimer slotInvokingTimer;
+        slotInvokingTimer.setInterval(500);
+        slotInvokingTimer.setSingleShot(true);
+
+        timer.start();
+        slotInvokingTimer.singleShot(
+            0, &groupCommitAsyncTester, SLOT(onInitTestCase()));
+
+        Q_UNUSED(loop.exec())
+        status = loop.exitStatus();
+    }
+
+    if (status == EventLoopWithExitStatus::ExitStatus::Failure) {
+        QFAIL(
+            "Detected failure during the asynchronous loop processing in "
+            "local storage group commit async tester");
+    }
+    else if (status == EventLoopWithExitStatus::ExitStatus::Timeout) {
+        QFAIL(
+            "Local storage group commit async tester failed to finish "
+            "in time");
+    }
+}
+
+void TestRequestCoalescingAsync()
+{
+    EventLoopWithExitStatus::ExitStatus status =
+        EventLoopWithExitStatus::ExitStatus::Failure;
+    {
+        QTimer timer;
+        timer.setInterval(MAX_ALLOWED_TEST_DURATION_MSEC);
+        timer.setSingleShot(true);
+
+        LocalStorageRequestCoalescingAsyncTester requestCoalescingAsyncTester;
+        EventLoopWithExitStatus loop;
+
+        QObject::connect(
+            &timer, &QTimer::timeout, &loop,
+            &EventLoopWithExitStatus::exitAsTimeout);
+
+        QObject::connect(
+            &requestCoalescingAsyncTester,
+            &LocalStorageRequestCoalescingAsyncTester::success, &loop,
+            &EventLoopWithExitStatus::exitAsSuccess);
+
+        QObject::connect(
+            &requestCoalescingAsyncTester,
+            &LocalStorageRequestCoalescingAsyncTester::failure, &loop,
+            &EventLoopWithExitStatus::exitAsFailureWithError);
+
+        QTimer slotInvokingTimer;
+        slotInvokingTimer.setInterval(500);
+        slotInvokingTimer.setSingleShot(true);
+
+        timer.start();
+        slotInvokingTimer.singleShot(
+            0, &requestCoalescingAsyncTester, SLOT(onInitTestCase()));
+
+        Q_UNUSED(loop.exec())
+        status = loop.exitStatus();
+    }
+
+    if (status == EventLoopWithExitStatus::ExitStatus::Failure) {
+        QFAIL(
+            "Detected failure during the asynchronous loop processing in "
+            "local storage request coalescing async tester");
+    }
+    else if (status == EventLoopWithExitStatus::ExitStatus::Timeout) {
+        QFAIL(
+            "Local storage request coalescing async tester failed to finish "
+            "in time");
+    }
+}
+
 } // namespace test
 } // namespace quentier
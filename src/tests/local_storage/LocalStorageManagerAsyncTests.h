@@ -40,6 +40,12 @@ void TestNoteNotebookAndTagListTrackingAsync();
 
 void TestCacheAsync();
 
+void TestRequestPriorityAsync();
+
+void TestGroupCommitAsync();
+
+void TestRequestCoalescingAsync();
+
 } // namespace test
 } // namespace quentier
 
@@ -20,7 +20,11 @@
 
 #include "../TestMacros.h"
 
+#include <quentier/local_storage/ByteBudgetLocalStorageCacheExpiryChecker.h>
+#include <quentier/local_storage/ILocalStoragePatch.h>
+#include <quentier/local_storage/LocalStorageCacheManager.h>
 #include <quentier/local_storage/LocalStorageManager.h>
+#include <quentier/local_storage/NoteSearchQuery.h>
 #include <quentier/types/LinkedNotebook.h>
 #include <quentier/types/Note.h>
 #include <quentier/types/Notebook.h>
@@ -29,11 +33,20 @@
 #include <quentier/types/SharedNotebook.h>
 #include <quentier/types/Tag.h>
 #include <quentier/types/User.h>
+#include <quentier/utility/StandardPaths.h>
 #include <quentier/utility/UidGenerator.h>
 
+#include <QBuffer>
 #include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
 #include <QtTest/QtTest>
 
+#include <memory>
 #include <string>
 
 namespace quentier {
@@ -3624,5 +3637,3175 @@ void TestNoteTagIdsComplementWhenAddingAndUpdatingNote()
             "LocalStorageManager::updateNote method returning")));
 }
 
+void TestNoteFullTextSearchIndexMaintenance()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(
+        QStringLiteral("LocalStorageManagerNoteFtsIndexTestFakeUser"),
+        Account::Type::Local);
+
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // Add notes in batches: full text search index is maintained
+    // incrementally so after each batch the index should contain exactly
+    // the notes added so far
+    const int numBatches = 5;
+    const int numNotesPerBatch = 200;
+
+    NoteSearchQuery noteSearchQuery;
+    QVERIFY2(
+        noteSearchQuery.setQueryString(
+            QStringLiteral("intitle:fake"), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    int noteCounter = 0;
+
+    for (int i = 0; i < numBatches; ++i) {
+        for (int j = 0; j < numNotesPerBatch; ++j, ++noteCounter) {
+            Note note;
+            note.setNotebookLocalUid(notebook.localUid());
+
+            note.setTitle(
+                QStringLiteral("Fake note title #") +
+                QString::number(noteCounter));
+
+            note.setContent(
+                QStringLiteral("<en-note><h1>Fake note content #") +
+                QString::number(noteCounter) +
+                QStringLiteral("</h1></en-note>"));
+
+            errorMessage.clear();
+
+            QVERIFY2(
+                localStorageManager.addNote(note, errorMessage),
+                qPrintable(errorMessage.nonLocalizedString()));
+        }
+
+        errorMessage.clear();
+
+        const QStringList foundNoteLocalUids =
+            localStorageManager.findNoteLocalUidsWithSearchQuery(
+                noteSearchQuery, errorMessage);
+
+        VERIFY2(
+            foundNoteLocalUids.size() == noteCounter && errorMessage.isEmpty(),
+            "Unexpected number of notes found by title after adding batch #"
+                << i << ": expected " << noteCounter << ", found "
+                << foundNoteLocalUids.size()
+                << "; error: " << errorMessage.nonLocalizedString());
+    }
+
+    // Ensure the full text search index is up to date after note addition,
+    // update and expunging
+    Note note;
+    note.setNotebookLocalUid(notebook.localUid());
+    note.setTitle(QStringLiteral("Quokka"));
+    note.setContent(QStringLiteral("<en-note><h1>Quokka</h1></en-note>"));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        noteSearchQuery.setQueryString(
+            QStringLiteral("intitle:quokka"), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    QStringList foundNoteLocalUids =
+        localStorageManager.findNoteLocalUidsWithSearchQuery(
+            noteSearchQuery, errorMessage);
+
+    VERIFY2(
+        foundNoteLocalUids == QStringList() << note.localUid(),
+        "Unexpected result of searching for the added note by its title: "
+            << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    note.setTitle(QStringLiteral("Wombat"));
+
+    LocalStorageManager::UpdateNoteOptions updateNoteOptions(
+        LocalStorageManager::UpdateNoteOption::UpdateResourceMetadata |
+        LocalStorageManager::UpdateNoteOption::UpdateResourceBinaryData |
+        LocalStorageManager::UpdateNoteOption::UpdateTags);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(note, updateNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    foundNoteLocalUids = localStorageManager.findNoteLocalUidsWithSearchQuery(
+        noteSearchQuery, errorMessage);
+
+    VERIFY2(
+        foundNoteLocalUids.isEmpty() && errorMessage.isEmpty(),
+        "Found note by its title after the title was changed: "
+            << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    QVERIFY2(
+        noteSearchQuery.setQueryString(
+            QStringLiteral("intitle:wombat"), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    foundNoteLocalUids = localStorageManager.findNoteLocalUidsWithSearchQuery(
+        noteSearchQuery, errorMessage);
+
+    VERIFY2(
+        foundNoteLocalUids == QStringList() << note.localUid(),
+        "Unexpected result of searching for the updated note by its title: "
+            << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    foundNoteLocalUids = localStorageManager.findNoteLocalUidsWithSearchQuery(
+        noteSearchQuery, errorMessage);
+
+    VERIFY2(
+        foundNoteLocalUids.isEmpty() && errorMessage.isEmpty(),
+        "Found note by its title after the note was expunged: "
+            << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    QVERIFY2(
+        noteSearchQuery.setQueryString(
+            QStringLiteral("intitle:fake"), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    foundNoteLocalUids = localStorageManager.findNoteLocalUidsWithSearchQuery(
+        noteSearchQuery, errorMessage);
+
+    VERIFY2(
+        foundNoteLocalUids.size() == noteCounter && errorMessage.isEmpty(),
+        "Unexpected number of notes found by title after expunging "
+            << "another note: expected " << noteCounter << ", found "
+            << foundNoteLocalUids.size()
+            << "; error: " << errorMessage.nonLocalizedString());
+}
+
+void TestNoteAdditionAndUpdateThroughput()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(
+        QStringLiteral("LocalStorageManagerNoteThroughputTestFakeUser"),
+        Account::Type::Local);
+
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    LocalStorageManager::UpdateNoteOptions updateNoteOptions(
+        LocalStorageManager::UpdateNoteOption::UpdateResourceMetadata |
+        LocalStorageManager::UpdateNoteOption::UpdateResourceBinaryData |
+        LocalStorageManager::UpdateNoteOption::UpdateTags);
+
+    // Each iteration adds a batch of notes and then updates them; as the full
+    // text search index is maintained incrementally, the time per iteration
+    // should stay flat while the number of notes grows. The timings are only
+    // reported as they depend on the machine running the tests
+    const int numNotesPerBatch = 100;
+    int noteCounter = 0;
+
+    QBENCHMARK {
+        QList<Note> notes;
+        notes.reserve(numNotesPerBatch);
+
+        for (int i = 0; i < numNotesPerBatch; ++i, ++noteCounter) {
+            Note note;
+            note.setNotebookLocalUid(notebook.localUid());
+
+            note.setTitle(
+                QStringLiteral("Fake note title #") +
+                QString::number(noteCounter));
+
+            note.setContent(
+                QStringLiteral("<en-note><h1>Fake note content #") +
+                QString::number(noteCounter) +
+                QStringLiteral("</h1></en-note>"));
+
+            errorMessage.clear();
+
+            QVERIFY2(
+                localStorageManager.addNote(note, errorMessage),
+                qPrintable(errorMessage.nonLocalizedString()));
+
+            notes << note;
+        }
+
+        for (auto & note: notes) {
+            note.setTitle(QStringLiteral("Updated ") + note.title());
+
+            errorMessage.clear();
+
+            QVERIFY2(
+                localStorageManager.updateNote(
+                    note, updateNoteOptions, errorMessage),
+                qPrintable(errorMessage.nonLocalizedString()));
+        }
+    }
+
+    errorMessage.clear();
+
+    int noteCount = localStorageManager.noteCount(errorMessage);
+
+    VERIFY2(
+        noteCount == noteCounter,
+        "Unexpected number of notes after the benchmark: expected "
+            << noteCounter << ", got " << noteCount
+            << "; error: " << errorMessage.nonLocalizedString());
+}
+
+void TestFullTextSearchIndexRebuildByLocalStoragePatch2To3()
+{
+    Account account(
+        QStringLiteral("LocalStorageManagerPatch2To3TestFakeUser"),
+        Account::Type::Local);
+
+    const int numNotes = 20;
+
+    {
+        LocalStorageManager localStorageManager(
+            account, LocalStorageManager::StartupOption::ClearDatabase);
+
+        ErrorString errorMessage;
+
+        Notebook notebook;
+        notebook.setName(QStringLiteral("Fake notebook name"));
+
+        QVERIFY2(
+            localStorageManager.addNotebook(notebook, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        for (int i = 0; i < numNotes; ++i) {
+            Note note;
+            note.setNotebookLocalUid(notebook.localUid());
+            note.setTitle(
+                QStringLiteral("Fake note title #") + QString::number(i));
+
+            note.setContent(
+                QStringLiteral("<en-note><h1>Fake note content #") +
+                QString::number(i) + QStringLiteral("</h1></en-note>"));
+
+            errorMessage.clear();
+
+            QVERIFY2(
+                localStorageManager.addNote(note, errorMessage),
+                qPrintable(errorMessage.nonLocalizedString()));
+        }
+    }
+
+    // Turn the local storage into the one of version 2: without incremental
+    // full text search index triggers and with the note index out of sync
+    // with notes
+    QString connectionName =
+        QStringLiteral("LocalStorageManagerPatch2To3TestConnection");
+
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(
+            QStringLiteral("QSQLITE"), connectionName);
+
+        database.setDatabaseName(
+            accountPersistentStoragePath(account) +
+            QStringLiteral("/qn.storage.sqlite"));
+
+        QVERIFY2(database.open(), qPrintable(database.lastError().text()));
+
+        const QStringList ftsTableNames = QStringList()
+            << QStringLiteral("NotebookFTS") << QStringLiteral("NoteFTS")
+            << QStringLiteral("ResourceRecognitionDataFTS")
+            << QStringLiteral("ResourceMimeFTS") << QStringLiteral("TagFTS");
+
+        const QStringList triggerSuffixes = QStringList()
+            << QStringLiteral("BeforeInsertTrigger")
+            << QStringLiteral("AfterInsertTrigger")
+            << QStringLiteral("BeforeUpdateTrigger")
+            << QStringLiteral("AfterUpdateTrigger")
+            << QStringLiteral("BeforeDeleteTrigger");
+
+        QStringList queryStrings;
+        for (const auto & ftsTableName: qAsConst(ftsTableNames)) {
+            for (const auto & triggerSuffix: qAsConst(triggerSuffixes)) {
+                queryStrings << QString::fromUtf8("DROP TRIGGER %1_%2")
+                                    .arg(ftsTableName, triggerSuffix);
+            }
+        }
+
+        queryStrings << QStringLiteral(
+                            "INSERT INTO NoteFTS(NoteFTS) VALUES('delete-all')")
+                     << QStringLiteral("UPDATE Auxiliary SET version = 2");
+
+        QSqlQuery query(database);
+        for (const auto & queryString: qAsConst(queryStrings)) {
+            VERIFY2(
+                query.exec(queryString),
+                "Failed to execute query " << queryString << ": "
+                                           << query.lastError().text());
+        }
+    }
+
+    QSqlDatabase::removeDatabase(connectionName);
+
+    LocalStorageManager localStorageManager(account);
+
+    ErrorString errorMessage;
+
+    VERIFY2(
+        localStorageManager.localStorageVersion(errorMessage) == 2,
+        "Unexpected local storage version before the upgrade: "
+            << errorMessage.nonLocalizedString());
+
+    NoteSearchQuery noteSearchQuery;
+
+    QVERIFY2(
+        noteSearchQuery.setQueryString(
+            QStringLiteral("intitle:fake"), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    QStringList foundNoteLocalUids =
+        localStorageManager.findNoteLocalUidsWithSearchQuery(
+            noteSearchQuery, errorMessage);
+
+    VERIFY2(
+        foundNoteLocalUids.isEmpty() && errorMessage.isEmpty(),
+        "Found notes by title while the index was cleared: "
+            << foundNoteLocalUids.size()
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    auto patches = localStorageManager.requiredLocalStoragePatches();
+
+    QVERIFY2(
+        !patches.isEmpty() && (patches.front()->fromVersion() == 2) &&
+            (patches.front()->toVersion() == 3),
+        "Local storage of version 2 doesn't require LocalStoragePatch2To3");
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        patches.front()->apply(errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    VERIFY2(
+        localStorageManager.localStorageVersion(errorMessage) == 3,
+        "Unexpected local storage version after the upgrade: "
+            << errorMessage.nonLocalizedString());
+
+    // The index should be rebuilt from the existing notes
+    errorMessage.clear();
+
+    foundNoteLocalUids = localStorageManager.findNoteLocalUidsWithSearchQuery(
+        noteSearchQuery, errorMessage);
+
+    VERIFY2(
+        foundNoteLocalUids.size() == numNotes && errorMessage.isEmpty(),
+        "Unexpected number of notes found by title after the upgrade: "
+            << "expected " << numNotes << ", found "
+            << foundNoteLocalUids.size()
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    // The index should be maintained by the triggers created by the patch
+    Note note;
+    note.setLocalUid(foundNoteLocalUids.front());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(
+            note, LocalStorageManager::GetNoteOptions(), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    note.setTitle(QStringLiteral("Quokka"));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(
+            note, LocalStorageManager::UpdateNoteOptions(), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    foundNoteLocalUids = localStorageManager.findNoteLocalUidsWithSearchQuery(
+        noteSearchQuery, errorMessage);
+
+    VERIFY2(
+        foundNoteLocalUids.size() == numNotes - 1 && errorMessage.isEmpty(),
+        "Unexpected number of notes found by title after updating a note: "
+            << "expected " << (numNotes - 1) << ", found "
+            << foundNoteLocalUids.size()
+            << "; error: " << errorMessage.nonLocalizedString());
+}
+
+void TestBatchNoteAndTagAdditionInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(
+        QStringLiteral("LocalStorageManagerBatchAdditionTestFakeUser"),
+        Account::Type::Local);
+
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // The second tag has no name so it should fail to be added without
+    // affecting the other tags within the batch
+    QList<Tag> tags;
+    for (int i = 0; i < 3; ++i) {
+        Tag tag;
+        if (i != 1) {
+            tag.setName(QStringLiteral("Fake tag #") + QString::number(i));
+        }
+
+        tags << tag;
+    }
+
+    QList<ErrorString> errorDescriptions;
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addTags(tags, errorDescriptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        errorDescriptions.size() == tags.size(),
+        "The number of per tag error descriptions doesn't match the number "
+        "of tags");
+
+    QVERIFY2(
+        errorDescriptions[0].isEmpty() && errorDescriptions[2].isEmpty(),
+        "Unexpected failure to add a valid tag within the batch");
+
+    QVERIFY2(
+        !errorDescriptions[1].isEmpty(),
+        "Tag without a name was unexpectedly added within the batch");
+
+    errorMessage.clear();
+    int tagCount = localStorageManager.tagCount(errorMessage);
+
+    VERIFY2(
+        tagCount == 2,
+        "Unexpected number of tags after batch addition: "
+            << tagCount << "; error: " << errorMessage.nonLocalizedString());
+
+    // The second note refers to a non-existing notebook so it should fail
+    // to be added without affecting the other notes within the batch
+    QList<Note> notes;
+    for (int i = 0; i < 3; ++i) {
+        Note note;
+        note.setTitle(QStringLiteral("Fake note #") + QString::number(i));
+        note.setContent(QStringLiteral("<en-note><h1>Hello</h1></en-note>"));
+
+        if (i != 1) {
+            note.setNotebookLocalUid(notebook.localUid());
+            note.addTagLocalUid(tags[0].localUid());
+        }
+        else {
+            note.setNotebookLocalUid(UidGenerator::Generate());
+        }
+
+        notes << note;
+    }
+
+    errorDescriptions.clear();
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNotes(notes, errorDescriptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        errorDescriptions.size() == notes.size(),
+        "The number of per note error descriptions doesn't match the number "
+        "of notes");
+
+    QVERIFY2(
+        errorDescriptions[0].isEmpty() && errorDescriptions[2].isEmpty(),
+        "Unexpected failure to add a valid note within the batch");
+
+    QVERIFY2(
+        !errorDescriptions[1].isEmpty(),
+        "Note from non-existing notebook was unexpectedly added within "
+        "the batch");
+
+    errorMessage.clear();
+    int noteCount = localStorageManager.noteCount(errorMessage);
+
+    VERIFY2(
+        noteCount == 2,
+        "Unexpected number of notes after batch addition: "
+            << noteCount << "; error: " << errorMessage.nonLocalizedString());
+
+    // Update the successfully added notes within another batch
+    notes.removeAt(1);
+    for (auto & note: notes) {
+        note.setTitle(note.title() + QStringLiteral(" updated"));
+    }
+
+    LocalStorageManager::UpdateNoteOptions updateNoteOptions(
+        LocalStorageManager::UpdateNoteOption::UpdateResourceMetadata |
+        LocalStorageManager::UpdateNoteOption::UpdateResourceBinaryData |
+        LocalStorageManager::UpdateNoteOption::UpdateTags);
+
+    errorDescriptions.clear();
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNotes(
+            notes, updateNoteOptions, errorDescriptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    for (const auto & note: qAsConst(notes)) {
+        Note foundNote;
+        foundNote.setLocalUid(note.localUid());
+
+        LocalStorageManager::GetNoteOptions getNoteOptions(
+            LocalStorageManager::GetNoteOption::WithResourceMetadata);
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.findNote(
+                foundNote, getNoteOptions, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        VERIFY2(
+            foundNote.title() == note.title(),
+            "Note title was not updated within the batch: expected "
+                << note.title() << ", found " << foundNote.title());
+
+        VERIFY2(
+            foundNote.tagLocalUids() == QStringList() << tags[0].localUid(),
+            "Unexpected note tag local uids after batch update: "
+                << foundNote.tagLocalUids().join(QStringLiteral(", ")));
+    }
+}
+
+void TestReadOnlyConnectionToLocalStorage()
+{
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    LocalStorageManager readOnlyLocalStorageManager(
+        account, LocalStorageManager::StartupOption::ReadOnly);
+
+    Notebook foundNotebook;
+    foundNotebook.setLocalUid(notebook.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        readOnlyLocalStorageManager.findNotebook(foundNotebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    VERIFY2(
+        foundNotebook == notebook,
+        "Notebook found via the read-only connection doesn't match "
+            << "the original one: original notebook: " << notebook
+            << "\nFound notebook: " << foundNotebook);
+
+    // The data written via the primary connection after the read-only one
+    // was opened should be visible through the latter as well
+    Notebook anotherNotebook;
+    anotherNotebook.setName(QStringLiteral("Another fake notebook name"));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNotebook(anotherNotebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+    int notebookCount = readOnlyLocalStorageManager.notebookCount(errorMessage);
+
+    VERIFY2(
+        notebookCount == 2,
+        "Unexpected number of notebooks seen via the read-only connection: "
+            << notebookCount
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    // Writes via the read-only connection must fail
+    Notebook yetAnotherNotebook;
+    yetAnotherNotebook.setName(QStringLiteral("Yet another notebook name"));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        !readOnlyLocalStorageManager.addNotebook(
+            yetAnotherNotebook, errorMessage),
+        "Notebook was unexpectedly added via the read-only connection");
+}
+
+void TestMappedResourceBinaryDataInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // The data body is large enough to be mapped while the alternate data
+    // body is small enough to be read into memory
+    QByteArray dataBody(1024 * 1024, 'x');
+    dataBody.replace(0, 5, "Start");
+
+    QByteArray alternateDataBody("Fake alternate data body");
+
+    Resource resource;
+    resource.setDataBody(dataBody);
+    resource.setDataSize(dataBody.size());
+    resource.setDataHash(QByteArray("Fake hash      1"));
+    resource.setAlternateDataBody(alternateDataBody);
+    resource.setAlternateDataSize(alternateDataBody.size());
+    resource.setAlternateDataHash(QByteArray("Fake hash      2"));
+    resource.setMime(QStringLiteral("application/octet-stream"));
+
+    Note note;
+    note.setTitle(QStringLiteral("Fake note title"));
+    note.setContent(QStringLiteral("<en-note><h1>Hello, world</h1></en-note>"));
+    note.setNotebookLocalUid(notebook.localUid());
+    note.addResource(resource);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Resource foundResource;
+    foundResource.setLocalUid(resource.localUid());
+
+    LocalStorageManager::GetResourceOptions getResourceOptions(
+        LocalStorageManager::GetResourceOption::WithBinaryData |
+        LocalStorageManager::GetResourceOption::MapBinaryData);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findEnResource(
+            foundResource, getResourceOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        foundResource.dataBody() == dataBody,
+        "Mapped resource data body doesn't match the original one");
+
+    QVERIFY2(
+        foundResource.alternateDataBody() == alternateDataBody,
+        "Resource alternate data body doesn't match the original one");
+
+    // The copy of the resource must keep the mapping alive after the original
+    // resource is gone
+    auto pResourceCopy = std::make_unique<Resource>(foundResource);
+    foundResource = Resource();
+
+    QVERIFY2(
+        pResourceCopy->dataBody() == dataBody,
+        "Mapped resource data body doesn't match the original one after "
+        "the resource it was found into was destroyed");
+
+    // Same for resources of the note found with resource binary data mapping
+    Note foundNote;
+    foundNote.setLocalUid(note.localUid());
+
+    LocalStorageManager::GetNoteOptions getNoteOptions(
+        LocalStorageManager::GetNoteOption::WithResourceMetadata |
+        LocalStorageManager::GetNoteOption::WithResourceBinaryData |
+        LocalStorageManager::GetNoteOption::MapResourceBinaryData);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(foundNote, getNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QList<Resource> foundResources = foundNote.resources();
+    foundNote = Note();
+
+    VERIFY2(
+        foundResources.size() == 1,
+        "Unexpected number of found note's resources: "
+            << foundResources.size());
+
+    QVERIFY2(
+        foundResources[0].dataBody() == dataBody,
+        "Mapped data body of the note's resource doesn't match the original "
+        "one");
+
+    // The note the mapped resource is put into must keep the mapping alive
+    // after the resource is gone
+    Note otherNote;
+    otherNote.addResource(*pResourceCopy);
+    pResourceCopy.reset();
+
+    Note yetAnotherNote;
+    yetAnotherNote.setResources(foundResources);
+    foundResources.clear();
+
+    QList<Resource> otherNoteResources = otherNote.resources();
+
+    VERIFY2(
+        otherNoteResources.size() == 1,
+        "Unexpected number of resources of the note the mapped resource was "
+            << "added to: " << otherNoteResources.size());
+
+    QVERIFY2(
+        otherNoteResources[0].dataBody() == dataBody,
+        "Mapped data body of the resource added to the note doesn't match "
+        "the original one after the resource was destroyed");
+
+    QList<Resource> yetAnotherNoteResources = yetAnotherNote.resources();
+
+    VERIFY2(
+        yetAnotherNoteResources.size() == 1,
+        "Unexpected number of resources of the note the mapped resource was "
+            << "set to: " << yetAnotherNoteResources.size());
+
+    QVERIFY2(
+        yetAnotherNoteResources[0].dataBody() == dataBody,
+        "Mapped data body of the resource set to the note doesn't match "
+        "the original one after the resource was destroyed");
+}
+
+namespace {
+
+int countResourceBlobFiles(const Account & account)
+{
+    QString blobsPath = accountPersistentStoragePath(account) +
+        QStringLiteral("/Resources/blobs");
+
+    QDirIterator it(
+        blobsPath, QStringList() << QStringLiteral("*.dat"), QDir::Files,
+        QDirIterator::Subdirectories);
+
+    int count = 0;
+    while (it.hasNext()) {
+        Q_UNUSED(it.next())
+        ++count;
+    }
+
+    return count;
+}
+
+} // namespace
+
+void TestResourceBlobDeduplicationInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QByteArray dataBody("Fake shared resource data body");
+
+    QByteArray dataHash =
+        QCryptographicHash::hash(dataBody, QCryptographicHash::Md5);
+
+    QList<Note> notes;
+    for (int i = 0; i < 2; ++i) {
+        Resource resource;
+        resource.setDataBody(dataBody);
+        resource.setDataSize(dataBody.size());
+        resource.setDataHash(dataHash);
+        resource.setMime(QStringLiteral("application/octet-stream"));
+
+        Note note;
+        note.setTitle(QStringLiteral("Fake note title #") + QString::number(i));
+
+        note.setContent(
+            QStringLiteral("<en-note><h1>Hello, world</h1></en-note>"));
+
+        note.setNotebookLocalUid(notebook.localUid());
+        note.addResource(resource);
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addNote(note, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        notes << note;
+    }
+
+    int blobFileCount = countResourceBlobFiles(account);
+
+    VERIFY2(
+        blobFileCount == 1,
+        "Unexpected number of resource blob files after adding two "
+            << "resources with the same data: " << blobFileCount);
+
+    // Expunging one of the notes must not affect the data of the other one
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNote(notes[0], errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    blobFileCount = countResourceBlobFiles(account);
+
+    VERIFY2(
+        blobFileCount == 1,
+        "Unexpected number of resource blob files after expunging one of "
+            << "the notes: " << blobFileCount);
+
+    Resource foundResource;
+    foundResource.setLocalUid(notes[1].resources()[0].localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findEnResource(
+            foundResource,
+            LocalStorageManager::GetResourceOption::WithBinaryData,
+            errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        foundResource.dataBody() == dataBody,
+        "Resource data body doesn't match the original one after expunging "
+        "another resource with the same data");
+
+    // Once the last reference is gone the blob file must be removed as well
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNote(notes[1], errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    blobFileCount = countResourceBlobFiles(account);
+
+    VERIFY2(
+        blobFileCount == 0,
+        "Unexpected number of resource blob files after expunging all "
+            << "notes: " << blobFileCount);
+}
+
+void TestResourceDataStreamingToLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Note note;
+    note.setTitle(QStringLiteral("Fake note title"));
+    note.setContent(QStringLiteral("<en-note><h1>Hello, world</h1></en-note>"));
+    note.setNotebookLocalUid(notebook.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // The data is large enough to be streamed in several chunks
+    QByteArray dataBody(3 * 1024 * 1024 + 17, 'x');
+    dataBody.replace(0, 5, "Start");
+
+    QBuffer dataBodySource(&dataBody);
+    QVERIFY(dataBodySource.open(QIODevice::ReadOnly));
+
+    Resource resource;
+    resource.setMime(QStringLiteral("application/octet-stream"));
+    resource.setNoteLocalUid(note.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addEnResource(
+            resource, dataBodySource, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        resource.hasDataHash() &&
+            (resource.dataHash() ==
+             QCryptographicHash::hash(dataBody, QCryptographicHash::Md5)),
+        "Resource data hash doesn't match the hash of the streamed data");
+
+    VERIFY2(
+        resource.hasDataSize() && (resource.dataSize() == dataBody.size()),
+        "Resource data size doesn't match the size of the streamed data: "
+            << (resource.hasDataSize() ? resource.dataSize() : -1));
+
+    Resource foundResource;
+    foundResource.setLocalUid(resource.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findEnResource(
+            foundResource,
+            LocalStorageManager::GetResourceOption::WithBinaryData,
+            errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        foundResource.dataBody() == dataBody,
+        "Found resource data body doesn't match the streamed data");
+
+    // Replace the data of the resource with the streamed one
+    QByteArray updatedDataBody("Fake updated resource data body");
+
+    QBuffer updatedDataBodySource(&updatedDataBody);
+    QVERIFY(updatedDataBodySource.open(QIODevice::ReadOnly));
+
+    Resource updatedResource;
+    updatedResource.setLocalUid(resource.localUid());
+    updatedResource.setMime(resource.mime());
+    updatedResource.setNoteLocalUid(note.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateEnResource(
+            updatedResource, updatedDataBodySource, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    foundResource = Resource();
+    foundResource.setLocalUid(resource.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findEnResource(
+            foundResource,
+            LocalStorageManager::GetResourceOption::WithBinaryData,
+            errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        foundResource.dataBody() == updatedDataBody,
+        "Found resource data body doesn't match the streamed updated data");
+
+    QVERIFY2(
+        foundResource.dataHash() ==
+            QCryptographicHash::hash(
+                updatedDataBody, QCryptographicHash::Md5),
+        "Found resource data hash doesn't match the hash of the streamed "
+        "updated data");
+
+    // Only the streaming update may keep the stored data body; the plain one
+    // of the resource without data body should fail and keep the data intact
+    Resource resourceWithoutDataBody;
+    resourceWithoutDataBody.setLocalUid(resource.localUid());
+    resourceWithoutDataBody.setMime(resource.mime());
+    resourceWithoutDataBody.setNoteLocalUid(note.localUid());
+    resourceWithoutDataBody.setDataHash(foundResource.dataHash());
+    resourceWithoutDataBody.setDataSize(foundResource.dataSize());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        !localStorageManager.updateEnResource(
+            resourceWithoutDataBody, errorMessage),
+        "Resource without data body was updated without streaming its data");
+
+    foundResource = Resource();
+    foundResource.setLocalUid(resource.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findEnResource(
+            foundResource,
+            LocalStorageManager::GetResourceOption::WithBinaryData,
+            errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        foundResource.dataBody() == updatedDataBody,
+        "Found resource data body changed after the failed update");
+}
+
+void TestLazyResourceBinaryDataInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QByteArray dataBody("Fake resource data body");
+    QByteArray alternateDataBody("Fake resource alternate data body");
+
+    Resource resource;
+    resource.setDataBody(dataBody);
+    resource.setDataSize(dataBody.size());
+    resource.setDataHash(QByteArray("Fake hash      1"));
+    resource.setAlternateDataBody(alternateDataBody);
+    resource.setAlternateDataSize(alternateDataBody.size());
+    resource.setAlternateDataHash(QByteArray("Fake hash      2"));
+    resource.setMime(QStringLiteral("application/octet-stream"));
+
+    Note note;
+    note.setTitle(QStringLiteral("Fake note title"));
+    note.setContent(QStringLiteral("<en-note><h1>Hello, world</h1></en-note>"));
+    note.setNotebookLocalUid(notebook.localUid());
+    note.addResource(resource);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Resource foundResource;
+    foundResource.setLocalUid(resource.localUid());
+
+    LocalStorageManager::GetResourceOptions getResourceOptions(
+        LocalStorageManager::GetResourceOption::WithBinaryData |
+        LocalStorageManager::GetResourceOption::LazyBinaryData);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findEnResource(
+            foundResource, getResourceOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        foundResource.hasLazyDataBody() &&
+            foundResource.hasLazyAlternateDataBody(),
+        "Found resource doesn't have lazy data body and alternate data body");
+
+    QVERIFY2(
+        foundResource.hasDataBody() && foundResource.hasAlternateDataBody(),
+        "Found resource with lazy bodies doesn't report having bodies");
+
+    QVERIFY2(
+        !foundResource.qevercloudResource().data->body.isSet(),
+        "Lazy data body was loaded before the first access to it");
+
+    QVERIFY2(
+        foundResource.dataBody() == dataBody,
+        "Lazy resource data body doesn't match the original one");
+
+    QVERIFY2(
+        foundResource.alternateDataBody() == alternateDataBody,
+        "Lazy resource alternate data body doesn't match the original one");
+
+    // Released bodies must be read again on the next access
+    foundResource.releaseDataBodies();
+
+    QVERIFY2(
+        foundResource.dataBody() == dataBody,
+        "Lazy resource data body doesn't match the original one after "
+        "releasing it");
+
+    // Prefetched bodies must become a part of qevercloud resource
+    QVERIFY2(
+        foundResource.prefetchDataBodies(),
+        "Failed to prefetch lazy resource bodies");
+
+    QVERIFY2(
+        foundResource.qevercloudResource().data->body.isSet() &&
+            (foundResource.qevercloudResource().data->body.ref() ==
+             dataBody),
+        "Prefetched data body is not a part of qevercloud resource");
+
+    // Lazy bodies of note's resources must survive passing through the note
+    Note foundNote;
+    foundNote.setLocalUid(note.localUid());
+
+    LocalStorageManager::GetNoteOptions getNoteOptions(
+        LocalStorageManager::GetNoteOption::WithResourceMetadata |
+        LocalStorageManager::GetNoteOption::WithResourceBinaryData |
+        LocalStorageManager::GetNoteOption::LazyResourceBinaryData);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(foundNote, getNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QList<Resource> foundResources = foundNote.resources();
+
+    VERIFY2(
+        foundResources.size() == 1,
+        "Unexpected number of found note's resources: "
+            << foundResources.size());
+
+    QVERIFY2(
+        foundResources[0].hasLazyDataBody(),
+        "Note's resource doesn't have lazy data body");
+
+    QVERIFY2(
+        foundResources[0].dataBody() == dataBody,
+        "Lazy data body of the note's resource doesn't match the original "
+        "one");
+
+    // Releasing the bodies of one copy must not affect the other copies
+    Resource resourceCopy = foundResources[0];
+    foundResources[0].releaseDataBodies();
+
+    QVERIFY2(
+        resourceCopy.dataBody() == dataBody,
+        "Releasing lazy bodies of the resource affected its copy");
+
+    // Lazy body referring to the missing file must not be reported as present
+    // nor be written over the actual binary data
+    Resource missingBodyResource = foundResource;
+    missingBodyResource.setLazyDataBody(QDir::temp().absoluteFilePath(
+        QStringLiteral("LocalStorageManagerBasicTestsMissingBody")));
+
+    QVERIFY2(
+        !missingBodyResource.hasDataBody() &&
+            missingBodyResource.dataBody().isEmpty(),
+        "Resource with lazy body from the missing file reports having it");
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        !localStorageManager.updateEnResource(
+            missingBodyResource, errorMessage),
+        "Resource with unreadable lazy body was written to the local storage");
+
+    foundResource = Resource();
+    foundResource.setLocalUid(resource.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findEnResource(
+            foundResource, getResourceOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        foundResource.dataBody() == dataBody,
+        "Resource data body changed after failed attempt to write unreadable "
+        "lazy body");
+}
+
+void TestCompiledNoteSearchQueriesInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Tag tag;
+    tag.setName(QStringLiteral("Alpha"));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addTag(tag, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Note firstNote;
+    firstNote.setTitle(QStringLiteral("First note"));
+    firstNote.setContent(QStringLiteral("<en-note><h1>First</h1></en-note>"));
+    firstNote.setNotebookLocalUid(notebook.localUid());
+    firstNote.addTagLocalUid(tag.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(firstNote, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Note secondNote;
+    secondNote.setTitle(QStringLiteral("Second note"));
+    secondNote.setContent(QStringLiteral("<en-note><h1>Second</h1></en-note>"));
+    secondNote.setNotebookLocalUid(notebook.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(secondNote, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    NoteSearchQuery noteSearchQuery;
+    errorMessage.clear();
+
+    QVERIFY2(
+        noteSearchQuery.setQueryString(
+            QStringLiteral("tag:Alpha"), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // The second search reuses the query compiled for the first one
+    for (int i = 0; i < 2; ++i) {
+        errorMessage.clear();
+
+        QStringList foundLocalUids =
+            localStorageManager.findNoteLocalUidsWithSearchQuery(
+                noteSearchQuery, errorMessage);
+
+        QVERIFY2(
+            errorMessage.isEmpty(),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        QVERIFY2(
+            foundLocalUids == QStringList() << firstNote.localUid(),
+            "Unexpected result of the search for notes with a tag");
+    }
+
+    // Replace the tag with another one having the same name: the compiled
+    // query contains the local uid of the expunged tag and must be dropped
+    QStringList expungedChildTagLocalUids;
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeTag(
+            tag, expungedChildTagLocalUids, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Tag newTag;
+    newTag.setName(QStringLiteral("Alpha"));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addTag(newTag, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    secondNote.addTagLocalUid(newTag.localUid());
+
+    LocalStorageManager::UpdateNoteOptions updateNoteOptions(
+        LocalStorageManager::UpdateNoteOption::UpdateTags);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(
+            secondNote, updateNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    QStringList foundLocalUids =
+        localStorageManager.findNoteLocalUidsWithSearchQuery(
+            noteSearchQuery, errorMessage);
+
+    QVERIFY2(
+        errorMessage.isEmpty(), qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        foundLocalUids == QStringList() << secondNote.localUid(),
+        "Compiled note search query was not invalidated after the change "
+        "of tags");
+}
+
+void TestQueryStatisticsInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+
+    for (int i = 0; i < 3; ++i) {
+        Notebook notebook;
+        notebook.setName(
+            QStringLiteral("Fake notebook name #") + QString::number(i));
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addNotebook(notebook, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+    }
+
+    localStorageManager.resetQueryStatistics();
+
+    QVERIFY2(
+        localStorageManager.queryStatistics().isEmpty(),
+        "Query statistics are not empty after resetting them");
+
+    // Capture plans of all queries
+    localStorageManager.setSlowQueryThreshold(1);
+
+    // The queries differ only in limit so they should be accounted together
+    for (int limit = 1; limit <= 2; ++limit) {
+        errorMessage.clear();
+
+        auto notebooks = localStorageManager.listNotebooks(
+            LocalStorageManager::ListObjectsOption::ListAll, errorMessage,
+            static_cast<size_t>(limit));
+
+        QVERIFY2(
+            errorMessage.isEmpty(),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        QVERIFY2(
+            notebooks.size() == limit,
+            "Unexpected number of listed notebooks");
+    }
+
+    const auto statistics = localStorageManager.queryStatistics();
+
+    const LocalStorageManager::QueryStatistics * pListNotebooksStatistics =
+        nullptr;
+
+    for (const auto & stats: qAsConst(statistics)) {
+        if (stats.m_query.startsWith(
+                QStringLiteral("SELECT * FROM Notebooks")) &&
+            stats.m_query.endsWith(QStringLiteral("LIMIT ?")))
+        {
+            pListNotebooksStatistics = &stats;
+            break;
+        }
+    }
+
+    QVERIFY2(
+        pListNotebooksStatistics,
+        "No statistics were collected for the notebooks listing query");
+
+    QVERIFY2(
+        pListNotebooksStatistics->m_executionCount == 2,
+        "Unexpected execution count of the notebooks listing query");
+
+    QVERIFY2(
+        pListNotebooksStatistics->m_failureCount == 0,
+        "Unexpected failure count of the notebooks listing query");
+
+    QVERIFY2(
+        pListNotebooksStatistics->m_rowCount == 3,
+        "Unexpected row count of the notebooks listing query");
+
+    QVERIFY2(
+        pListNotebooksStatistics->m_maxDurationUsec <=
+            pListNotebooksStatistics->m_totalDurationUsec,
+        "Max duration of the notebooks listing query exceeds its total "
+        "duration");
+
+    QVERIFY2(
+        pListNotebooksStatistics->m_medianDurationUsec <=
+            pListNotebooksStatistics->m_maxDurationUsec,
+        "Median duration of the notebooks listing query exceeds its max "
+        "duration");
+
+    QVERIFY2(
+        !pListNotebooksStatistics->m_queryPlan.isEmpty(),
+        "No plan was captured for the notebooks listing query");
+
+    // Prepared queries with bound values get their plans captured too
+    errorMessage.clear();
+
+    Q_UNUSED(localStorageManager.accountHighUsn(QString(), errorMessage))
+
+    QVERIFY2(
+        errorMessage.isEmpty(), qPrintable(errorMessage.nonLocalizedString()));
+
+    // Statements beginning and ending transactions are accounted as well
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name #3"));
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    bool foundAccountHighUsnQueryPlan = false;
+    bool foundBeginStatistics = false;
+    bool foundCommitStatistics = false;
+
+    const auto updatedStatistics = localStorageManager.queryStatistics();
+    for (const auto & stats: qAsConst(updatedStatistics)) {
+        if (stats.m_query.startsWith(
+                QStringLiteral("SELECT highUsn FROM AccountHighUsns")))
+        {
+            foundAccountHighUsnQueryPlan = !stats.m_queryPlan.isEmpty();
+        }
+        else if (stats.m_query.startsWith(QStringLiteral("BEGIN"))) {
+            foundBeginStatistics = (stats.m_executionCount > 0);
+        }
+        else if (stats.m_query.startsWith(QStringLiteral("COMMIT"))) {
+            foundCommitStatistics = (stats.m_executionCount > 0);
+        }
+    }
+
+    QVERIFY2(
+        foundAccountHighUsnQueryPlan,
+        "No plan was captured for the prepared account high USN query");
+
+    QVERIFY2(
+        foundBeginStatistics,
+        "No statistics were collected for statements beginning transactions");
+
+    QVERIFY2(
+        foundCommitStatistics,
+        "No statistics were collected for statements committing "
+        "transactions");
+}
+
+void TestLocalStorageCacheByteBudgetExpiry()
+{
+    LocalStorageCacheManager cacheManager;
+
+    ByteBudgetLocalStorageCacheExpiryChecker::Budget budget;
+    budget.m_notesBytes = 64 * 1024;
+
+    ByteBudgetLocalStorageCacheExpiryChecker checker(cacheManager, budget);
+    cacheManager.installCacheExpiryFunction(checker);
+
+    QVERIFY2(
+        cacheManager.cachedNotesBytes() == 0,
+        "Empty cache reports non-zero number of bytes occupied by notes");
+
+    // Each note's content occupies 16 Kb so the budget fits only a few notes
+    const QString content = QString(8 * 1024, QChar::fromLatin1('a'));
+
+    Note firstNote;
+    firstNote.setTitle(QStringLiteral("Fake note title #00"));
+    firstNote.setContent(content);
+    cacheManager.cacheNote(firstNote);
+
+    const size_t noteBytes = cacheManager.cachedNotesBytes();
+
+    QVERIFY2(
+        noteBytes >= static_cast<size_t>(content.size()) * sizeof(QChar),
+        "The number of bytes occupied by cached note is less than the size "
+        "of its content");
+
+    // Updating the cached note must not change the amount of cached notes'
+    // bytes as long as the note's size doesn't change
+    firstNote.setTitle(QStringLiteral("Fake note title #99"));
+    cacheManager.cacheNote(firstNote);
+
+    QVERIFY2(
+        cacheManager.cachedNotesBytes() == noteBytes,
+        "The number of bytes occupied by cached notes changed after "
+        "updating the cached note without changing its size");
+
+    const int numNotes = 20;
+    for (int i = 1; i < numNotes; ++i) {
+        Note note;
+        note.setTitle(
+            QStringLiteral("Fake note title #") +
+            QString::number(i).rightJustified(2, QChar::fromLatin1('0')));
+        note.setContent(content);
+        cacheManager.cacheNote(note);
+
+        QVERIFY2(
+            cacheManager.cachedNotesBytes() < budget.m_notesBytes + noteBytes,
+            "Cached notes exceed the byte budget by more than one note");
+    }
+
+    QVERIFY2(
+        cacheManager.numEvictedNotes() > 0,
+        "No notes were evicted from the cache after exceeding the budget");
+
+    QVERIFY2(
+        cacheManager.numCachedNotes() + cacheManager.numEvictedNotes() ==
+            static_cast<size_t>(numNotes),
+        "The number of cached and evicted notes doesn't match the number of "
+        "notes put into the cache");
+
+    QVERIFY2(
+        cacheManager.cachedNotesBytes() ==
+            cacheManager.numCachedNotes() * noteBytes,
+        "The number of bytes occupied by cached notes doesn't match "
+        "the number of cached notes");
+
+    // The data body referring to memory owned by someone else must not be
+    // accounted as it is not freed when the resource is evicted
+    auto pDataBodyOwner = std::make_shared<QByteArray>(64 * 1024, 'b');
+
+    Resource resource;
+    resource.setDataBody(*pDataBodyOwner);
+    cacheManager.cacheResource(resource);
+
+    const size_t resourceBytes = cacheManager.cachedResourcesBytes();
+
+    QVERIFY2(
+        resourceBytes >= static_cast<size_t>(pDataBodyOwner->size()),
+        "The number of bytes occupied by cached resource is less than the size "
+        "of its data body");
+
+    Resource resourceWithDataBodyOwner;
+    resourceWithDataBodyOwner.setDataBody(
+        QByteArray::fromRawData(
+            pDataBodyOwner->constData(), pDataBodyOwner->size()),
+        pDataBodyOwner);
+
+    cacheManager.cacheResource(resourceWithDataBodyOwner);
+
+    QVERIFY2(
+        cacheManager.cachedResourcesBytes() - resourceBytes <
+            static_cast<size_t>(pDataBodyOwner->size()),
+        "The data body of cached resource owned by someone else is accounted "
+        "in the number of bytes occupied by cached resources");
+
+    cacheManager.clear();
+
+    QVERIFY2(
+        cacheManager.cachedNotesBytes() == 0,
+        "Cleared cache reports non-zero number of bytes occupied by notes");
+
+    QVERIFY2(
+        cacheManager.cachedResourcesBytes() == 0,
+        "Cleared cache reports non-zero number of bytes occupied by resources");
+}
+
+void TestNoteSearchHitsInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QStringList titles = QStringList()
+        << QStringLiteral("Alpha report") << QStringLiteral("Meeting minutes")
+        << QStringLiteral("Shopping list");
+
+    QStringList contents = QStringList()
+        << QStringLiteral("<en-note><div>alpha release of alpha version"
+                          "</div></en-note>")
+        << QStringLiteral("<en-note><div>discussed the schedule of the next "
+                          "release, the alpha is postponed until the rest of "
+                          "the team is back from vacation</div></en-note>")
+        << QStringLiteral("<en-note><div>milk, bread</div></en-note>");
+
+    QList<Note> notes;
+    for (int i = 0; i < titles.size(); ++i) {
+        Note note;
+        note.setTitle(titles[i]);
+        note.setContent(contents[i]);
+        note.setNotebookLocalUid(notebook.localUid());
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addNote(note, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        notes << note;
+    }
+
+    NoteSearchQuery noteSearchQuery;
+    errorMessage.clear();
+
+    QVERIFY2(
+        noteSearchQuery.setQueryString(QStringLiteral("alpha"), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    auto hits =
+        localStorageManager.findNoteSearchHits(noteSearchQuery, errorMessage);
+
+    QVERIFY2(
+        errorMessage.isEmpty(), qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        hits.size() == 2,
+        qPrintable(
+            QString::fromUtf8("Unexpected number of note search hits: %1")
+                .arg(hits.size())));
+
+    QVERIFY2(
+        hits[0].m_noteLocalUid == notes[0].localUid(),
+        "The note mentioning the search term in its title and more often "
+        "in its text is not ranked first");
+
+    QVERIFY2(
+        hits[1].m_noteLocalUid == notes[1].localUid(),
+        "Unexpected second note search hit");
+
+    QVERIFY2(
+        hits[0].m_score > hits[1].m_score && hits[1].m_score > 0.0,
+        "Unexpected scores of note search hits");
+
+    for (const auto & hit: qAsConst(hits)) {
+        QVERIFY2(
+            !hit.m_matchOffsets.isEmpty(),
+            qPrintable(
+                QString::fromUtf8("Note search hit has no match offsets: %1")
+                    .arg(ToString(hit))));
+
+        for (const auto & offset: qAsConst(hit.m_matchOffsets)) {
+            QVERIFY2(
+                hit.m_snippet.mid(offset.first, offset.second).toLower() ==
+                    QStringLiteral("alpha"),
+                qPrintable(
+                    QString::fromUtf8("Match offset doesn't point to "
+                                      "the search term within snippet: %1")
+                        .arg(ToString(hit))));
+        }
+    }
+
+    errorMessage.clear();
+
+    hits = localStorageManager.findNoteSearchHits(
+        noteSearchQuery, errorMessage, 1);
+
+    QVERIFY2(
+        errorMessage.isEmpty(), qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        hits.size() == 1 && hits[0].m_noteLocalUid == notes[0].localUid(),
+        "Limited search didn't return only the most relevant note");
+}
+
+void TestNoteCountersInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+
+    QList<Notebook> notebooks;
+    for (int i = 0; i < 2; ++i) {
+        Notebook notebook;
+        notebook.setName(
+            QStringLiteral("Fake notebook name #") + QString::number(i));
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addNotebook(notebook, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        notebooks << notebook;
+    }
+
+    QList<Tag> tags;
+    for (int i = 0; i < 2; ++i) {
+        Tag tag;
+        tag.setName(QStringLiteral("Fake tag name #") + QString::number(i));
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addTag(tag, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        tags << tag;
+    }
+
+    // First note: first notebook, both tags
+    // Second note: first notebook, first tag
+    // Third note: second notebook, second tag, deleted
+    QList<Note> notes;
+    for (int i = 0; i < 3; ++i) {
+        Note note;
+        note.setTitle(QStringLiteral("Fake note #") + QString::number(i));
+        note.setNotebookLocalUid(notebooks[(i == 2) ? 1 : 0].localUid());
+
+        if (i != 2) {
+            note.addTagLocalUid(tags[0].localUid());
+        }
+
+        if (i != 1) {
+            note.addTagLocalUid(tags[1].localUid());
+        }
+
+        if (i == 2) {
+            note.setDeletionTimestamp(1);
+        }
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addNote(note, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        notes << note;
+    }
+
+    const LocalStorageManager::NoteCountOptions deletedNotes(
+        LocalStorageManager::NoteCountOption::IncludeDeletedNotes);
+
+    const LocalStorageManager::NoteCountOptions allNotes =
+        LocalStorageManager::NoteCountOption::IncludeNonDeletedNotes |
+        LocalStorageManager::NoteCountOption::IncludeDeletedNotes;
+
+    QVERIFY(localStorageManager.noteCount(errorMessage) == 2);
+    QVERIFY(localStorageManager.noteCount(errorMessage, allNotes) == 3);
+
+    QVERIFY(
+        localStorageManager.noteCountPerNotebook(notebooks[0], errorMessage) ==
+        2);
+
+    QVERIFY(
+        localStorageManager.noteCountPerNotebook(notebooks[1], errorMessage) ==
+        0);
+
+    QVERIFY(
+        localStorageManager.noteCountPerNotebook(
+            notebooks[1], errorMessage, deletedNotes) == 1);
+
+    QVERIFY(localStorageManager.noteCountPerTag(tags[0], errorMessage) == 2);
+    QVERIFY(localStorageManager.noteCountPerTag(tags[1], errorMessage) == 1);
+
+    QVERIFY(
+        localStorageManager.noteCountPerTag(tags[1], errorMessage, allNotes) ==
+        2);
+
+    // Move the second note to the second notebook, mark it deleted and
+    // replace its tag
+    notes[1].setNotebookLocalUid(notebooks[1].localUid());
+    notes[1].setDeletionTimestamp(2);
+    notes[1].setTagLocalUids(QStringList() << tags[1].localUid());
+
+    LocalStorageManager::UpdateNoteOptions updateNoteOptions(
+        LocalStorageManager::UpdateNoteOption::UpdateTags);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(
+            notes[1], updateNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY(
+        localStorageManager.noteCountPerNotebook(notebooks[0], errorMessage) ==
+        1);
+
+    QVERIFY(
+        localStorageManager.noteCountPerNotebook(
+            notebooks[1], errorMessage, deletedNotes) == 2);
+
+    QVERIFY(localStorageManager.noteCountPerTag(tags[0], errorMessage) == 1);
+
+    QVERIFY(
+        localStorageManager.noteCountPerTag(
+            tags[1], errorMessage, deletedNotes) == 2);
+
+    // Expunge the first note
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNote(notes[0], errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY(localStorageManager.noteCount(errorMessage) == 0);
+    QVERIFY(localStorageManager.noteCountPerTag(tags[0], errorMessage) == 0);
+
+    QHash<QString, int> noteCountsPerTagLocalUid;
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.noteCountsPerAllTags(
+            noteCountsPerTagLocalUid, errorMessage, allNotes),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        noteCountsPerTagLocalUid.size() == 1 &&
+            noteCountsPerTagLocalUid.value(tags[1].localUid()) == 2,
+        "Unexpected note counts per all tags");
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.noteCountersAreConsistent(errorMessage),
+        qPrintable(
+            QStringLiteral("Note counters are inconsistent with notes: ") +
+            errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.rebuildNoteCounters(errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY(
+        localStorageManager.noteCountPerNotebook(
+            notebooks[1], errorMessage, allNotes) == 2);
+
+    QVERIFY(
+        localStorageManager.noteCountPerTag(tags[1], errorMessage, allNotes) ==
+        2);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.noteCountersAreConsistent(errorMessage),
+        qPrintable(
+            QStringLiteral("Rebuilt note counters are inconsistent with "
+                           "notes: ") +
+            errorMessage.nonLocalizedString()));
+}
+
+void TestIncrementalCompactionOfLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+    LocalStorageManager::FreePageStatistics statistics;
+
+    QVERIFY2(
+        localStorageManager.freePageStatistics(statistics, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        statistics.m_incrementalVacuumEnabled,
+        "Incremental vacuum is not enabled for the new local storage");
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QString text;
+    for (int i = 0; i < 1000; ++i) {
+        text += QStringLiteral("Lorem ipsum dolor sit amet ");
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        Note note;
+        note.setTitle(QStringLiteral("Fake note #") + QString::number(i));
+        note.setContent(
+            QStringLiteral("<en-note><div>") + text +
+            QStringLiteral("</div></en-note>"));
+        note.setNotebookLocalUid(notebook.localUid());
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addNote(note, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+    }
+
+    // Expunging the notebook along with its notes leaves their pages free
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.freePageStatistics(statistics, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        statistics.m_freePageCount > 0,
+        "Expected to have free pages after expunging the notes");
+
+    QVERIFY(statistics.fragmentation() > 0.0);
+    QVERIFY(statistics.fragmentation() <= 1.0);
+
+    const qint64 pageCountBeforeCompaction = statistics.m_pageCount;
+
+    // Zero time budget leaves no time for reclaiming anything
+    errorMessage.clear();
+    qint64 remainingFreePageCount =
+        localStorageManager.reclaimFreePages(0, errorMessage);
+
+    QVERIFY2(
+        remainingFreePageCount == statistics.m_freePageCount,
+        "Free pages were reclaimed despite zero time budget");
+
+    errorMessage.clear();
+    remainingFreePageCount =
+        localStorageManager.reclaimFreePages(60000, errorMessage);
+
+    QVERIFY2(
+        remainingFreePageCount == 0,
+        qPrintable(
+            QStringLiteral("Unexpected number of free pages remaining after "
+                           "compaction: ") +
+            QString::number(remainingFreePageCount) + QStringLiteral(", ") +
+            errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.freePageStatistics(statistics, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY(statistics.m_freePageCount == 0);
+    QVERIFY(statistics.m_pageCount < pageCountBeforeCompaction);
+}
+
+void TestAccountHighUsnCacheInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(
+        QStringLiteral("LocalStorageManagerAccountHighUsnTestFakeUser"),
+        Account::Type::Evernote, 0);
+
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    // In verification mode accountHighUsn fails if the value kept up to date
+    // on writes differs from the one computed from all the tables
+    localStorageManager.setAccountHighUsnVerificationEnabled(true);
+    QVERIFY(localStorageManager.accountHighUsnVerificationEnabled());
+
+    ErrorString errorMessage;
+
+    auto checkAccountHighUsn = [&](const QString & linkedNotebookGuid,
+                                   const qint32 expectedUsn) {
+        errorMessage.clear();
+        qint32 usn = localStorageManager.accountHighUsn(
+            linkedNotebookGuid, errorMessage);
+
+        VERIFY2(
+            usn == expectedUsn,
+            "Wrong value of account high USN for linked notebook guid "
+                << linkedNotebookGuid << ": expected "
+                << QString::number(expectedUsn) << ", got "
+                << QString::number(usn) << "; " << errorMessage);
+    };
+
+    checkAccountHighUsn(QString(), 0);
+
+    Notebook notebook;
+    notebook.setGuid(UidGenerator::Generate());
+    notebook.setUpdateSequenceNumber(10);
+    notebook.setName(QStringLiteral("Notebook"));
+    notebook.setCreationTimestamp(QDateTime::currentMSecsSinceEpoch());
+    notebook.setModificationTimestamp(notebook.creationTimestamp());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    checkAccountHighUsn(QString(), 10);
+
+    LinkedNotebook linkedNotebook;
+    linkedNotebook.setGuid(UidGenerator::Generate());
+    linkedNotebook.setUpdateSequenceNumber(5);
+    linkedNotebook.setShareName(QStringLiteral("Share name"));
+    linkedNotebook.setUsername(QStringLiteral("Username"));
+    linkedNotebook.setShardId(UidGenerator::Generate());
+    linkedNotebook.setSharedNotebookGlobalId(UidGenerator::Generate());
+    linkedNotebook.setUri(UidGenerator::Generate());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addLinkedNotebook(linkedNotebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    checkAccountHighUsn(QString(), 10);
+    checkAccountHighUsn(linkedNotebook.guid(), 0);
+
+    Notebook notebookFromLinkedNotebook;
+    notebookFromLinkedNotebook.setGuid(linkedNotebook.sharedNotebookGlobalId());
+    notebookFromLinkedNotebook.setLinkedNotebookGuid(linkedNotebook.guid());
+    notebookFromLinkedNotebook.setUpdateSequenceNumber(20);
+
+    notebookFromLinkedNotebook.setName(
+        QStringLiteral("Notebook from linked notebook"));
+
+    notebookFromLinkedNotebook.setCreationTimestamp(
+        QDateTime::currentMSecsSinceEpoch());
+
+    notebookFromLinkedNotebook.setModificationTimestamp(
+        notebookFromLinkedNotebook.creationTimestamp());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNotebook(
+            notebookFromLinkedNotebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    checkAccountHighUsn(QString(), 10);
+    checkAccountHighUsn(linkedNotebook.guid(), 20);
+
+    Note note;
+    note.setGuid(UidGenerator::Generate());
+    note.setTitle(QStringLiteral("Note"));
+    note.setUpdateSequenceNumber(30);
+    note.setNotebookLocalUid(notebook.localUid());
+    note.setNotebookGuid(notebook.guid());
+    note.setCreationTimestamp(QDateTime::currentMSecsSinceEpoch());
+    note.setModificationTimestamp(note.creationTimestamp());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Note noteFromLinkedNotebook;
+    noteFromLinkedNotebook.setGuid(UidGenerator::Generate());
+    noteFromLinkedNotebook.setTitle(
+        QStringLiteral("Note from linked notebook"));
+    noteFromLinkedNotebook.setUpdateSequenceNumber(40);
+
+    noteFromLinkedNotebook.setNotebookLocalUid(
+        notebookFromLinkedNotebook.localUid());
+
+    noteFromLinkedNotebook.setNotebookGuid(notebookFromLinkedNotebook.guid());
+
+    noteFromLinkedNotebook.setCreationTimestamp(
+        QDateTime::currentMSecsSinceEpoch());
+
+    noteFromLinkedNotebook.setModificationTimestamp(
+        noteFromLinkedNotebook.creationTimestamp());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(noteFromLinkedNotebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    checkAccountHighUsn(QString(), 30);
+    checkAccountHighUsn(linkedNotebook.guid(), 40);
+
+    // Decreasing the highest USN requires recomputing the value
+    note.setUpdateSequenceNumber(15);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(
+            note, LocalStorageManager::UpdateNoteOptions(), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    checkAccountHighUsn(QString(), 15);
+    checkAccountHighUsn(linkedNotebook.guid(), 40);
+
+    // So does expunging the data element with the highest USN
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    checkAccountHighUsn(QString(), 10);
+    checkAccountHighUsn(linkedNotebook.guid(), 40);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNotebook(
+            notebookFromLinkedNotebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    checkAccountHighUsn(QString(), 10);
+    checkAccountHighUsn(linkedNotebook.guid(), 0);
+}
+
+
+void TestGuidLocalUidIndexInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(
+        QStringLiteral("LocalStorageManagerGuidIndexTestFakeUser"),
+        Account::Type::Evernote, 0);
+
+    LocalStorageManager localStorageManager(account, startupOptions);
+    QVERIFY(localStorageManager.guidIndexEnabled());
+
+    Notebook notebook;
+    notebook.setGuid(UidGenerator::Generate());
+    notebook.setUpdateSequenceNumber(1);
+    notebook.setName(QStringLiteral("Notebook"));
+    notebook.setCreationTimestamp(QDateTime::currentMSecsSinceEpoch());
+    notebook.setModificationTimestamp(notebook.creationTimestamp());
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Note note;
+    note.setGuid(UidGenerator::Generate());
+    note.setUpdateSequenceNumber(2);
+    note.setTitle(QStringLiteral("Note"));
+    note.setNotebookLocalUid(notebook.localUid());
+    note.setNotebookGuid(notebook.guid());
+    note.setCreationTimestamp(QDateTime::currentMSecsSinceEpoch());
+    note.setModificationTimestamp(note.creationTimestamp());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // Written items are put into the index right away
+    auto statistics = localStorageManager.guidIndexStatistics();
+    QVERIFY(statistics.m_enabled);
+
+    VERIFY2(
+        statistics.m_entryCount == 2,
+        "Unexpected number of guid index entries: " << statistics);
+
+    QVERIFY(statistics.m_memoryUsage > 0);
+
+    LocalStorageManager::GetNoteOptions getNoteOptions;
+
+    Note foundNote;
+    foundNote.setGuid(note.guid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(foundNote, getNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QCOMPARE(foundNote.localUid(), note.localUid());
+
+    auto previousStatistics = statistics;
+    statistics = localStorageManager.guidIndexStatistics();
+
+    VERIFY2(
+        statistics.m_hitCount > previousStatistics.m_hitCount,
+        "Note's guid was not translated using the guid index: " << statistics);
+
+    // Expunging the notebook expunges its notes as well, none of them should
+    // be found via the index afterwards
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    statistics = localStorageManager.guidIndexStatistics();
+
+    VERIFY2(
+        statistics.m_entryCount == 0,
+        "Guid index still has entries after expunging the notebook: "
+            << statistics);
+
+    foundNote = Note();
+    foundNote.setGuid(note.guid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        !localStorageManager.findNote(foundNote, getNoteOptions, errorMessage),
+        "Found the note which was expunged along with its notebook");
+
+    // Items with the same guids but different local uids should be found
+    // by the new local uids
+    Notebook newNotebook;
+    newNotebook.setGuid(notebook.guid());
+    newNotebook.setUpdateSequenceNumber(3);
+    newNotebook.setName(notebook.name());
+    newNotebook.setCreationTimestamp(QDateTime::currentMSecsSinceEpoch());
+    newNotebook.setModificationTimestamp(newNotebook.creationTimestamp());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNotebook(newNotebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Note newNote;
+    newNote.setGuid(note.guid());
+    newNote.setUpdateSequenceNumber(4);
+    newNote.setTitle(note.title());
+    newNote.setNotebookLocalUid(newNotebook.localUid());
+    newNote.setNotebookGuid(newNotebook.guid());
+    newNote.setCreationTimestamp(QDateTime::currentMSecsSinceEpoch());
+    newNote.setModificationTimestamp(newNote.creationTimestamp());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(newNote, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY(newNote.localUid() != note.localUid());
+
+    foundNote = Note();
+    foundNote.setGuid(newNote.guid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(foundNote, getNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QCOMPARE(foundNote.localUid(), newNote.localUid());
+
+    // Disabled index is empty but lookups by guid still work
+    localStorageManager.setGuidIndexEnabled(false);
+    QVERIFY(!localStorageManager.guidIndexEnabled());
+
+    statistics = localStorageManager.guidIndexStatistics();
+    QVERIFY(!statistics.m_enabled);
+    QVERIFY(statistics.m_entryCount == 0);
+    QVERIFY(statistics.m_memoryUsage == 0);
+
+    foundNote = Note();
+    foundNote.setGuid(newNote.guid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(foundNote, getNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QCOMPARE(foundNote.localUid(), newNote.localUid());
+}
+
+void TestPartialNoteUpdatesInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(
+        QStringLiteral("LocalStorageManagerPartialNoteUpdatesTestFakeUser"),
+        Account::Type::Evernote, 0);
+
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    Notebook notebook;
+    notebook.setGuid(UidGenerator::Generate());
+    notebook.setUpdateSequenceNumber(1);
+    notebook.setName(QStringLiteral("Notebook"));
+    notebook.setCreationTimestamp(QDateTime::currentMSecsSinceEpoch());
+    notebook.setModificationTimestamp(notebook.creationTimestamp());
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Tag tag;
+    tag.setGuid(UidGenerator::Generate());
+    tag.setUpdateSequenceNumber(2);
+    tag.setName(QStringLiteral("Tag"));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addTag(tag, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Note note;
+    note.setGuid(UidGenerator::Generate());
+    note.setUpdateSequenceNumber(3);
+    note.setTitle(QStringLiteral("Note"));
+    note.setContent(QStringLiteral("<en-note><h1>Hello, world</h1></en-note>"));
+    note.setNotebookLocalUid(notebook.localUid());
+    note.setNotebookGuid(notebook.guid());
+    note.addTagLocalUid(tag.localUid());
+    note.addTagGuid(tag.guid());
+    note.setCreationTimestamp(QDateTime::currentMSecsSinceEpoch());
+    note.setModificationTimestamp(note.creationTimestamp());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    LocalStorageManager::GetNoteOptions getNoteOptions(
+        LocalStorageManager::GetNoteOption::WithResourceMetadata |
+        LocalStorageManager::GetNoteOption::WithResourceBinaryData);
+
+    Note foundNote;
+    foundNote.setLocalUid(note.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(foundNote, getNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // Toggling flags of the found note should only update the respective
+    // columns of Notes table even if the options allow updating tags and
+    // resources
+    foundNote.setFavorited(!foundNote.isFavorited());
+    foundNote.setDirty(!foundNote.isDirty());
+
+    LocalStorageManager::UpdateNoteOptions updateNoteOptions(
+        LocalStorageManager::UpdateNoteOption::UpdateTags |
+        LocalStorageManager::UpdateNoteOption::UpdateResourceMetadata |
+        LocalStorageManager::UpdateNoteOption::UpdateResourceBinaryData);
+
+    localStorageManager.resetQueryStatistics();
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(
+            foundNote, updateNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    const auto statistics = localStorageManager.queryStatistics();
+
+    const LocalStorageManager::QueryStatistics * pUpdateNoteStatistics =
+        nullptr;
+
+    for (const auto & stats: qAsConst(statistics)) {
+        VERIFY2(
+            !stats.m_query.startsWith(QStringLiteral("INSERT")) &&
+                !stats.m_query.startsWith(QStringLiteral("DELETE")),
+            "Unexpected query on toggling note's flags: " << stats.m_query);
+
+        if (stats.m_query.startsWith(QStringLiteral("UPDATE Notes "))) {
+            QVERIFY2(
+                !pUpdateNoteStatistics,
+                "More than one statement updating Notes table");
+            pUpdateNoteStatistics = &stats;
+        }
+    }
+
+    QVERIFY2(
+        pUpdateNoteStatistics,
+        "No statement updating Notes table was executed");
+
+    VERIFY2(
+        pUpdateNoteStatistics->m_query.contains(
+            QStringLiteral("isFavorited")) &&
+            pUpdateNoteStatistics->m_query.contains(
+                QStringLiteral("isDirty")) &&
+            !pUpdateNoteStatistics->m_query.contains(QStringLiteral("title")),
+        "Unexpected columns updated: " << pUpdateNoteStatistics->m_query);
+
+    QVERIFY(pUpdateNoteStatistics->m_executionCount == 1);
+    QVERIFY(pUpdateNoteStatistics->m_rowCount == 1);
+
+    Note updatedNote;
+    updatedNote.setLocalUid(note.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(
+            updatedNote, getNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    VERIFY2(
+        updatedNote == foundNote,
+        "Note updated partially differs from the original: original note: "
+            << foundNote << "\nNote found in the local storage: "
+            << updatedNote);
+
+    // Modified title, content and tags should be written as well
+    updatedNote.setTitle(QStringLiteral("Modified note"));
+
+    updatedNote.setContent(
+        QStringLiteral("<en-note><h1>Modified content</h1></en-note>"));
+
+    updatedNote.removeTagLocalUid(tag.localUid());
+    updatedNote.removeTagGuid(tag.guid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(
+            updatedNote, updateNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Note modifiedNote;
+    modifiedNote.setLocalUid(note.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(
+            modifiedNote, getNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    VERIFY2(
+        modifiedNote == updatedNote,
+        "Note updated partially differs from the original: original note: "
+            << updatedNote << "\nNote found in the local storage: "
+            << modifiedNote);
+
+    // The note modified in the database bypassing the local storage manager
+    // no longer matches its snapshot so the whole row should be replaced
+    QString connectionName =
+        QStringLiteral("LocalStorageManagerPartialNoteUpdatesTestConnection");
+
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(
+            QStringLiteral("QSQLITE"), connectionName);
+
+        database.setDatabaseName(
+            accountPersistentStoragePath(account) +
+            QStringLiteral("/qn.storage.sqlite"));
+
+        QVERIFY2(database.open(), qPrintable(database.lastError().text()));
+
+        QSqlQuery query(database);
+        QString queryString =
+            QString::fromUtf8(
+                "UPDATE Notes SET title = 'Title written elsewhere', "
+                "updateSequenceNumber = 100 WHERE localUid = '%1'")
+                .arg(note.localUid());
+
+        QVERIFY2(
+            query.exec(queryString), qPrintable(query.lastError().text()));
+
+        QVERIFY(query.numRowsAffected() == 1);
+    }
+
+    QSqlDatabase::removeDatabase(connectionName);
+
+    modifiedNote.setFavorited(!modifiedNote.isFavorited());
+
+    localStorageManager.resetQueryStatistics();
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(
+            modifiedNote, updateNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    bool noteReplaced = false;
+    const auto replaceStatistics = localStorageManager.queryStatistics();
+    for (const auto & stats: qAsConst(replaceStatistics)) {
+        if (stats.m_query.startsWith(
+                QStringLiteral("INSERT OR REPLACE INTO Notes(")))
+        {
+            noteReplaced = true;
+            break;
+        }
+    }
+
+    QVERIFY2(
+        noteReplaced,
+        "Note not matching its snapshot was not replaced as a whole");
+
+    Note replacedNote;
+    replacedNote.setLocalUid(note.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.findNote(
+            replacedNote, getNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    VERIFY2(
+        replacedNote == modifiedNote,
+        "Note not matching its snapshot was written partially: original "
+            << "note: " << modifiedNote
+            << "\nNote found in the local storage: " << replacedNote);
+}
+
+void TestNoteSummariesInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QStringList tagLocalUids;
+    for (int i = 0; i < 2; ++i) {
+        Tag tag;
+        tag.setName(QStringLiteral("Fake tag name #") + QString::number(i));
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addTag(tag, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        tagLocalUids << tag.localUid();
+    }
+
+    QList<Note> notes;
+    for (int i = 0; i < 3; ++i) {
+        Note note;
+        note.setTitle(QStringLiteral("Fake note title #") + QString::number(i));
+
+        note.setContent(
+            QStringLiteral("<en-note><div>The text of fake note #") +
+            QString::number(i) + QStringLiteral("</div></en-note>"));
+
+        note.setCreationTimestamp(1000 + i);
+        note.setModificationTimestamp(2000 + i);
+        note.setNotebookLocalUid(notebook.localUid());
+        note.setFavorited(i == 1);
+
+        if (i == 0) {
+            // The reverse order ensures tags are not listed in the order of
+            // their addition to the local storage
+            note.addTagLocalUid(tagLocalUids[1]);
+            note.addTagLocalUid(tagLocalUids[0]);
+        }
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addNote(note, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        notes << note;
+    }
+
+    const int previewLength = 10;
+
+    LocalStorageManager::NoteSummaryFields fields =
+        LocalStorageManager::NoteSummaryField::Title |
+        LocalStorageManager::NoteSummaryField::Notebook |
+        LocalStorageManager::NoteSummaryField::Timestamps |
+        LocalStorageManager::NoteSummaryField::TagLocalUids |
+        LocalStorageManager::NoteSummaryField::Preview |
+        LocalStorageManager::NoteSummaryField::Flags;
+
+    localStorageManager.resetQueryStatistics();
+    errorMessage.clear();
+
+    auto noteSummaries = localStorageManager.listNoteSummaries(
+        LocalStorageManager::ListObjectsOption::ListAll, fields, errorMessage,
+        0, 0, LocalStorageManager::ListNotesOrder::ByCreationTimestamp,
+        LocalStorageManager::OrderDirection::Ascending, QString(),
+        previewLength);
+
+    QVERIFY2(
+        errorMessage.isEmpty(), qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        noteSummaries.size() == notes.size(),
+        qPrintable(
+            QString::fromUtf8("Unexpected number of note summaries: %1")
+                .arg(noteSummaries.size())));
+
+    for (int i = 0; i < notes.size(); ++i) {
+        const Note & note = notes[i];
+        const auto & noteSummary = noteSummaries[i];
+
+        QVERIFY2(
+            noteSummary.m_localUid == note.localUid() &&
+                noteSummary.m_guid.isEmpty() &&
+                noteSummary.m_title == note.title() &&
+                noteSummary.m_notebookLocalUid == notebook.localUid() &&
+                noteSummary.m_notebookGuid.isEmpty() &&
+                noteSummary.m_creationTimestamp == note.creationTimestamp() &&
+                noteSummary.m_modificationTimestamp ==
+                    note.modificationTimestamp() &&
+                noteSummary.m_deletionTimestamp == 0 &&
+                noteSummary.m_tagLocalUids == note.tagLocalUids() &&
+                noteSummary.m_preview ==
+                    note.plainText().left(previewLength) &&
+                noteSummary.m_isDirty == note.isDirty() &&
+                noteSummary.m_isLocal == note.isLocal() &&
+                noteSummary.m_isFavorited == note.isFavorited(),
+            qPrintable(
+                QString::fromUtf8("Note summary doesn't match the note: %1")
+                    .arg(ToString(noteSummary))));
+    }
+
+    const auto statistics = localStorageManager.queryStatistics();
+    for (const auto & stats: qAsConst(statistics)) {
+        QVERIFY2(
+            !stats.m_query.contains(QStringLiteral("SharedNotes")) &&
+                !stats.m_query.contains(QStringLiteral("NoteRestrictions")) &&
+                !stats.m_query.contains(QStringLiteral("Resources")) &&
+                !stats.m_query.contains(QStringLiteral("content,")),
+            qPrintable(
+                QString::fromUtf8("Unexpected query while listing note "
+                                  "summaries: %1")
+                    .arg(stats.m_query)));
+    }
+
+    errorMessage.clear();
+
+    noteSummaries = localStorageManager.listNoteSummaries(
+        LocalStorageManager::ListObjectsOption::ListAll,
+        LocalStorageManager::NoteSummaryField::Title, errorMessage, 1, 1,
+        LocalStorageManager::ListNotesOrder::ByCreationTimestamp,
+        LocalStorageManager::OrderDirection::Descending);
+
+    QVERIFY2(
+        errorMessage.isEmpty(), qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        noteSummaries.size() == 1 &&
+            noteSummaries[0].m_localUid == notes[1].localUid() &&
+            noteSummaries[0].m_title == notes[1].title() &&
+            noteSummaries[0].m_notebookLocalUid.isEmpty() &&
+            noteSummaries[0].m_tagLocalUids.isEmpty() &&
+            noteSummaries[0].m_preview.isEmpty(),
+        "Unexpected note summaries listed with limit, offset and only "
+        "the title field");
+
+    errorMessage.clear();
+
+    noteSummaries = localStorageManager.listNoteSummaries(
+        LocalStorageManager::ListObjectsOption::ListFavoritedElements,
+        LocalStorageManager::NoteSummaryField::Flags, errorMessage);
+
+    QVERIFY2(
+        errorMessage.isEmpty(), qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        noteSummaries.size() == 1 &&
+            noteSummaries[0].m_localUid == notes[1].localUid() &&
+            noteSummaries[0].m_isFavorited,
+        "Unexpected note summaries listed for favorited notes");
+}
+
+void TestLocalStorageSnapshot()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QByteArray dataBody("Fake resource data body");
+
+    Resource resource;
+    resource.setDataBody(dataBody);
+    resource.setDataSize(dataBody.size());
+    resource.setDataHash(
+        QCryptographicHash::hash(dataBody, QCryptographicHash::Md5));
+    resource.setMime(QStringLiteral("application/octet-stream"));
+
+    Note note;
+    note.setTitle(QStringLiteral("Fake note title"));
+    note.setContent(QStringLiteral("<en-note><h1>Hello, world</h1></en-note>"));
+    note.setNotebookLocalUid(notebook.localUid());
+    note.addResource(resource);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QTemporaryDir snapshotDir;
+    QVERIFY2(snapshotDir.isValid(), "Failed to create temporary directory");
+
+    QList<double> progressValues;
+    QObject::connect(
+        &localStorageManager, &LocalStorageManager::snapshotProgress,
+        &localStorageManager,
+        [&progressValues](double progress) { progressValues << progress; });
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.createSnapshot(snapshotDir.path(), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        !progressValues.isEmpty() && (progressValues.last() == 1.0),
+        "Snapshot progress didn't reach 1");
+
+    for (int i = 1; i < progressValues.size(); ++i) {
+        QVERIFY2(
+            progressValues[i] >= progressValues[i - 1],
+            "Snapshot progress is not monotonic");
+    }
+
+    QFileInfo snapshotDatabaseFileInfo(
+        snapshotDir.path() + QStringLiteral("/qn.storage.sqlite"));
+
+    QVERIFY2(
+        snapshotDatabaseFileInfo.exists() &&
+            (snapshotDatabaseFileInfo.size() > 0),
+        "Snapshot doesn't contain the database file");
+
+    // The note is expunged after the snapshot is taken so its resource data
+    // blob is removed from the local storage but must stay in the snapshot
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QDirIterator it(
+        snapshotDir.path() + QStringLiteral("/Resources/blobs"),
+        QStringList() << QStringLiteral("*.dat"), QDir::Files,
+        QDirIterator::Subdirectories);
+
+    QStringList snapshotBlobFilePaths;
+    while (it.hasNext()) {
+        snapshotBlobFilePaths << it.next();
+    }
+
+    VERIFY2(
+        snapshotBlobFilePaths.size() == 1,
+        "Unexpected number of resource blob files in the snapshot: "
+            << snapshotBlobFilePaths.size());
+
+    QFile snapshotBlobFile(snapshotBlobFilePaths[0]);
+    QVERIFY2(
+        snapshotBlobFile.open(QIODevice::ReadOnly),
+        "Failed to open resource blob file from the snapshot");
+
+    QVERIFY2(
+        snapshotBlobFile.readAll() == dataBody,
+        "Resource blob file from the snapshot doesn't contain resource data");
+
+    // Snapshot must not overwrite the existing one
+    errorMessage.clear();
+
+    QVERIFY2(
+        !localStorageManager.createSnapshot(snapshotDir.path(), errorMessage),
+        "Snapshot was created in the folder already containing a snapshot");
+}
+
+void TestLocalStoragePerformanceProfiles()
+{
+    using PerformanceProfile = LocalStorageManager::PerformanceProfile;
+
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+
+    LocalStorageManager localStorageManager(
+        account, startupOptions, PerformanceProfile::bulkImport());
+
+    QVERIFY2(
+        localStorageManager.performanceProfile() ==
+            PerformanceProfile::bulkImport(),
+        "Local storage doesn't use the profile it was created with");
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // Preset with overridden pragma values
+    PerformanceProfile profile = PerformanceProfile::balanced();
+    profile.m_cacheSize = -4000;
+    profile.m_busyTimeoutMsec = 1000;
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.setPerformanceProfile(profile, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(
+        localStorageManager.performanceProfile() == profile,
+        "Local storage doesn't use the profile which was set");
+
+    Note note;
+    note.setTitle(QStringLiteral("Fake note title"));
+    note.setContent(QStringLiteral("<en-note><h1>Hello, world</h1></en-note>"));
+    note.setNotebookLocalUid(notebook.localUid());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(note, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.setPerformanceProfile(
+            PerformanceProfile::durable(), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // The profile must survive switching to another account
+    Account otherAccount(
+        QStringLiteral("CoreTesterFakeUser2"), Account::Type::Local);
+
+    localStorageManager.switchUser(otherAccount, startupOptions);
+
+    QVERIFY2(
+        localStorageManager.performanceProfile() ==
+            PerformanceProfile::durable(),
+        "Local storage profile has changed on switching the account");
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.noteCount(errorMessage) == 0,
+        qPrintable(errorMessage.nonLocalizedString()));
+}
+
+void TestNoteLocationIndexInLocalStorage()
+{
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    Notebook notebook;
+    notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorMessage;
+
+    QVERIFY2(
+        localStorageManager.addNotebook(notebook, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    struct Location
+    {
+        const char * m_title;
+        double m_latitude;
+        double m_longitude;
+    };
+
+    // Fiji and Samoa lie on different sides of the 180th meridian
+    const Location locations[] = {
+        {"Berlin", 52.52, 13.405},
+        {"Paris", 48.8566, 2.3522},
+        {"Fiji", -17.7134, 178.065},
+        {"Samoa", -13.759, -172.1046}};
+
+    const QString noteContent =
+        QStringLiteral("<en-note><h1>Hello</h1></en-note>");
+
+    QHash<QString, Note> notesByTitle;
+
+    for (const auto & location: locations) {
+        Note note;
+        note.setTitle(QString::fromUtf8(location.m_title));
+        note.setContent(noteContent);
+        note.setNotebookLocalUid(notebook.localUid());
+
+        auto & attributes = note.noteAttributes();
+        attributes.latitude = location.m_latitude;
+        attributes.longitude = location.m_longitude;
+
+        errorMessage.clear();
+
+        QVERIFY2(
+            localStorageManager.addNote(note, errorMessage),
+            qPrintable(errorMessage.nonLocalizedString()));
+
+        notesByTitle[note.title()] = note;
+    }
+
+    // Notes with partially set location and without location at all
+    Note latitudeOnlyNote;
+    latitudeOnlyNote.setTitle(QStringLiteral("Latitude only"));
+    latitudeOnlyNote.setNotebookLocalUid(notebook.localUid());
+    latitudeOnlyNote.setContent(noteContent);
+    latitudeOnlyNote.noteAttributes().latitude = 45.0;
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(latitudeOnlyNote, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    Note noLocationNote;
+    noLocationNote.setTitle(QStringLiteral("No location"));
+    noLocationNote.setNotebookLocalUid(notebook.localUid());
+    noLocationNote.setContent(noteContent);
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.addNote(noLocationNote, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    const auto localUids = [&](const QStringList & titles) {
+        QStringList result;
+        for (const auto & title: titles) {
+            result << notesByTitle.value(title).localUid();
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+
+    const auto findWithinBoundingBox =
+        [&](const double minLatitude, const double maxLatitude,
+            const double minLongitude, const double maxLongitude,
+            const LocalStorageManager::NoteCountOptions options) {
+            errorMessage.clear();
+            QStringList result =
+                localStorageManager.findNoteLocalUidsWithinBoundingBox(
+                    minLatitude, maxLatitude, minLongitude, maxLongitude,
+                    errorMessage, options);
+            std::sort(result.begin(), result.end());
+            return result;
+        };
+
+    LocalStorageManager::NoteCountOptions nonDeletedNotes(
+        LocalStorageManager::NoteCountOption::IncludeNonDeletedNotes);
+
+    LocalStorageManager::NoteCountOptions deletedNotes(
+        LocalStorageManager::NoteCountOption::IncludeDeletedNotes);
+
+    QStringList foundNoteLocalUids =
+        findWithinBoundingBox(40.0, 60.0, -10.0, 20.0, nonDeletedNotes);
+
+    VERIFY2(
+        foundNoteLocalUids ==
+            localUids(QStringList() << QStringLiteral("Berlin")
+                                    << QStringLiteral("Paris")),
+        "Unexpected notes found within the bounding box of Europe: "
+            << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    foundNoteLocalUids =
+        findWithinBoundingBox(-20.0, -10.0, 170.0, -170.0, nonDeletedNotes);
+
+    VERIFY2(
+        foundNoteLocalUids ==
+            localUids(QStringList() << QStringLiteral("Fiji")
+                                    << QStringLiteral("Samoa")),
+        "Unexpected notes found within the bounding box crossing the 180th "
+            << "meridian: " << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    // Search terms on coordinates must keep matching the notes with partially
+    // set location
+    NoteSearchQuery noteSearchQuery;
+    QVERIFY2(
+        noteSearchQuery.setQueryString(
+            QStringLiteral("latitude:45"), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    foundNoteLocalUids = localStorageManager.findNoteLocalUidsWithSearchQuery(
+        noteSearchQuery, errorMessage);
+    std::sort(foundNoteLocalUids.begin(), foundNoteLocalUids.end());
+
+    QStringList expectedNoteLocalUids =
+        localUids(QStringList() << QStringLiteral("Berlin")
+                                << QStringLiteral("Paris"))
+        << latitudeOnlyNote.localUid();
+    std::sort(expectedNoteLocalUids.begin(), expectedNoteLocalUids.end());
+
+    VERIFY2(
+        foundNoteLocalUids == expectedNoteLocalUids,
+        "Unexpected result of searching for notes by latitude: "
+            << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    QVERIFY2(
+        noteSearchQuery.setQueryString(
+            QStringLiteral("-longitude:0"), errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    errorMessage.clear();
+
+    foundNoteLocalUids = localStorageManager.findNoteLocalUidsWithSearchQuery(
+        noteSearchQuery, errorMessage);
+
+    VERIFY2(
+        foundNoteLocalUids ==
+            localUids(QStringList() << QStringLiteral("Samoa")),
+        "Unexpected result of searching for notes by negated longitude: "
+            << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    // Moving the note out of the bounding box
+    Note & parisNote = notesByTitle[QStringLiteral("Paris")];
+    parisNote.noteAttributes().latitude = 35.6762;
+    parisNote.noteAttributes().longitude = 139.6503;
+
+    LocalStorageManager::UpdateNoteOptions updateNoteOptions;
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(
+            parisNote, updateNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    // Deleted notes are only found if requested
+    Note & berlinNote = notesByTitle[QStringLiteral("Berlin")];
+    berlinNote.setDeletionTimestamp(QDateTime::currentMSecsSinceEpoch());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.updateNote(
+            berlinNote, updateNoteOptions, errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    foundNoteLocalUids =
+        findWithinBoundingBox(40.0, 60.0, -10.0, 20.0, nonDeletedNotes);
+
+    VERIFY2(
+        foundNoteLocalUids.isEmpty() && errorMessage.isEmpty(),
+        "Unexpected non-deleted notes found within the bounding box of "
+            << "Europe: " << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    foundNoteLocalUids =
+        findWithinBoundingBox(40.0, 60.0, -10.0, 20.0, deletedNotes);
+
+    VERIFY2(
+        foundNoteLocalUids ==
+            localUids(QStringList() << QStringLiteral("Berlin")),
+        "Unexpected deleted notes found within the bounding box of Europe: "
+            << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    errorMessage.clear();
+
+    QVERIFY2(
+        localStorageManager.expungeNote(
+            notesByTitle[QStringLiteral("Fiji")], errorMessage),
+        qPrintable(errorMessage.nonLocalizedString()));
+
+    foundNoteLocalUids =
+        findWithinBoundingBox(-20.0, -10.0, 170.0, -170.0, nonDeletedNotes);
+
+    VERIFY2(
+        foundNoteLocalUids ==
+            localUids(QStringList() << QStringLiteral("Samoa")),
+        "Unexpected notes found within the bounding box crossing the 180th "
+            << "meridian after expunging the note: "
+            << foundNoteLocalUids.join(QStringLiteral(", "))
+            << "; error: " << errorMessage.nonLocalizedString());
+
+    errorMessage.clear();
+
+    foundNoteLocalUids = localStorageManager.findNoteLocalUidsWithinBoundingBox(
+        10.0, -10.0, 0.0, 10.0, errorMessage);
+
+    QVERIFY2(
+        foundNoteLocalUids.isEmpty() && !errorMessage.isEmpty(),
+        "No error reported for the bounding box with min latitude greater "
+        "than max latitude");
+}
+
 } // namespace test
 } // namespace quentier
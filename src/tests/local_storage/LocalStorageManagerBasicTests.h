@@ -50,6 +50,50 @@ void TestAddingNoteWithoutLocalUid();
 
 void TestNoteTagIdsComplementWhenAddingAndUpdatingNote();
 
+void TestNoteFullTextSearchIndexMaintenance();
+
+void TestNoteAdditionAndUpdateThroughput();
+
+void TestFullTextSearchIndexRebuildByLocalStoragePatch2To3();
+
+void TestBatchNoteAndTagAdditionInLocalStorage();
+
+void TestReadOnlyConnectionToLocalStorage();
+
+void TestMappedResourceBinaryDataInLocalStorage();
+
+void TestResourceBlobDeduplicationInLocalStorage();
+
+void TestResourceDataStreamingToLocalStorage();
+
+void TestLazyResourceBinaryDataInLocalStorage();
+
+void TestQueryStatisticsInLocalStorage();
+
+void TestCompiledNoteSearchQueriesInLocalStorage();
+
+void TestLocalStorageCacheByteBudgetExpiry();
+
+void TestNoteSearchHitsInLocalStorage();
+
+void TestNoteCountersInLocalStorage();
+
+void TestIncrementalCompactionOfLocalStorage();
+
+void TestAccountHighUsnCacheInLocalStorage();
+
+void TestGuidLocalUidIndexInLocalStorage();
+
+void TestPartialNoteUpdatesInLocalStorage();
+
+void TestNoteSummariesInLocalStorage();
+
+void TestLocalStorageSnapshot();
+
+void TestLocalStoragePerformanceProfiles();
+
+void TestNoteLocationIndexInLocalStorage();
+
 } // namespace test
 } // namespace quentier
 
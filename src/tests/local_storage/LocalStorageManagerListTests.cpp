@@ -1933,5 +1933,276 @@ void TestExpungeNotelessTagsFromLinkedNotebooks()
     }
 }
 
+void TestListObjectsPages()
+{
+    Account account(QStringLiteral("CoreTesterFakeUser"), Account::Type::Local);
+
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    LocalStorageManager localStorageManager(account, startupOptions);
+
+    ErrorString errorMessage;
+
+    Notebook notebook;
+    notebook.setGuid(QStringLiteral("00000000-0000-0000-c000-000000000047"));
+    notebook.setUpdateSequenceNumber(1);
+    notebook.setName(QStringLiteral("Fake notebook name"));
+    notebook.setCreationTimestamp(1);
+    notebook.setModificationTimestamp(1);
+
+    bool res = localStorageManager.addNotebook(notebook, errorMessage);
+    QVERIFY2(res == true, qPrintable(errorMessage.nonLocalizedString()));
+
+    // Some tags have no update sequence numbers and some share the same one
+    // so that the pages have to deal with both null values and ties
+    const int numTags = 11;
+    for (int i = 0; i < numTags; ++i) {
+        Tag tag;
+        tag.setName(QStringLiteral("Tag #") + QString::number(i));
+        if (i % 3 != 0) {
+            tag.setUpdateSequenceNumber(i / 2);
+        }
+
+        res = localStorageManager.addTag(tag, errorMessage);
+        QVERIFY2(res == true, qPrintable(errorMessage.nonLocalizedString()));
+    }
+
+    // Same for notes' titles
+    const int numNotes = 13;
+    for (int i = 0; i < numNotes; ++i) {
+        Note note;
+        note.setNotebookLocalUid(notebook.localUid());
+        note.setNotebookGuid(notebook.guid());
+        if (i % 4 != 0) {
+            note.setTitle(QStringLiteral("Note #") + QString::number(i / 3));
+        }
+
+        note.setContent(QStringLiteral("<en-note><h1>Note</h1></en-note>"));
+        note.setCreationTimestamp(i);
+        note.setModificationTimestamp(i);
+
+        res = localStorageManager.addNote(note, errorMessage);
+        QVERIFY2(res == true, qPrintable(errorMessage.nonLocalizedString()));
+    }
+
+    const QList<LocalStorageManager::OrderDirection> orderDirections = {
+        LocalStorageManager::OrderDirection::Ascending,
+        LocalStorageManager::OrderDirection::Descending};
+
+    const QList<size_t> pageSizes = {1, 2, 5, 100};
+
+    const QList<LocalStorageManager::ListTagsOrder> tagOrders = {
+        LocalStorageManager::ListTagsOrder::NoOrder,
+        LocalStorageManager::ListTagsOrder::ByUpdateSequenceNumber,
+        LocalStorageManager::ListTagsOrder::ByName};
+
+    for (const auto order: tagOrders) {
+        for (const auto orderDirection: orderDirections) {
+            errorMessage.clear();
+            QList<Tag> allTags = localStorageManager.listTags(
+                LocalStorageManager::ListObjectsOption::ListAll, errorMessage,
+                0, 0, order, orderDirection);
+
+            QVERIFY2(
+                errorMessage.isEmpty(),
+                qPrintable(errorMessage.nonLocalizedString()));
+
+            QVERIFY2(
+                allTags.size() == numTags,
+                "Unexpected number of tags listed at once");
+
+            for (const size_t pageSize: pageSizes) {
+                QList<Tag> pagedTags;
+                QString continuationToken;
+                int numPages = 0;
+                do {
+                    errorMessage.clear();
+                    QList<Tag> page = localStorageManager.listTagsPage(
+                        LocalStorageManager::ListObjectsOption::ListAll,
+                        errorMessage, pageSize, continuationToken, order,
+                        orderDirection);
+
+                    QVERIFY2(
+                        errorMessage.isEmpty(),
+                        qPrintable(errorMessage.nonLocalizedString()));
+
+                    QVERIFY2(
+                        static_cast<size_t>(page.size()) <= pageSize,
+                        "The page of tags is larger than requested");
+
+                    pagedTags << page;
+                    ++numPages;
+                    QVERIFY2(
+                        numPages <= numTags + 1,
+                        "Listing the pages of tags doesn't terminate");
+                } while (!continuationToken.isEmpty());
+
+                QVERIFY2(
+                    pagedTags.size() == numTags,
+                    "Unexpected number of tags listed in pages");
+
+                for (int i = 0; i < numTags; ++i) {
+                    QVERIFY2(
+                        allTags.contains(pagedTags.at(i)),
+                        "Tag listed in pages was not listed at once");
+
+                    QVERIFY2(
+                        pagedTags.indexOf(pagedTags.at(i)) == i,
+                        "Tag was listed in pages more than once");
+
+                    if ((i == 0) ||
+                        (order ==
+                         LocalStorageManager::ListTagsOrder::NoOrder)) {
+                        continue;
+                    }
+
+                    // Tags sharing the same value of the ordering column
+                    // can go in any order, the values themselves must not
+                    const Tag & previousTag = pagedTags.at(i - 1);
+                    const Tag & tag = pagedTags.at(i);
+                    const int previousIndex = allTags.indexOf(previousTag);
+                    const int index = allTags.indexOf(tag);
+                    if (index > previousIndex) {
+                        continue;
+                    }
+
+                    if (order == LocalStorageManager::ListTagsOrder::ByName) {
+                        QFAIL("Tags listed in pages are not ordered by name");
+                    }
+
+                    QVERIFY2(
+                        (previousTag.hasUpdateSequenceNumber() ==
+                         tag.hasUpdateSequenceNumber()) &&
+                            (!tag.hasUpdateSequenceNumber() ||
+                             (previousTag.updateSequenceNumber() ==
+                              tag.updateSequenceNumber())),
+                        "Tags listed in pages are not ordered by update "
+                        "sequence number");
+                }
+            }
+        }
+    }
+
+    const QList<LocalStorageManager::ListNotesOrder> noteOrders = {
+        LocalStorageManager::ListNotesOrder::NoOrder,
+        LocalStorageManager::ListNotesOrder::ByTitle,
+        LocalStorageManager::ListNotesOrder::ByCreationTimestamp};
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    LocalStorageManager::GetNoteOptions getNoteOptions;
+#else
+    LocalStorageManager::GetNoteOptions getNoteOptions(0);
+#endif
+
+    for (const auto order: noteOrders) {
+        for (const auto orderDirection: orderDirections) {
+            errorMessage.clear();
+            QList<Note> allNotes = localStorageManager.listNotes(
+                LocalStorageManager::ListObjectsOption::ListAll,
+                getNoteOptions, errorMessage, 0, 0, order, orderDirection);
+
+            QVERIFY2(
+                errorMessage.isEmpty(),
+                qPrintable(errorMessage.nonLocalizedString()));
+
+            QVERIFY2(
+                allNotes.size() == numNotes,
+                "Unexpected number of notes listed at once");
+
+            for (const size_t pageSize: pageSizes) {
+                QList<Note> pagedNotes;
+                QString continuationToken;
+                int numPages = 0;
+                do {
+                    errorMessage.clear();
+                    QList<Note> page = localStorageManager.listNotesPage(
+                        LocalStorageManager::ListObjectsOption::ListAll,
+                        getNoteOptions, errorMessage, pageSize,
+                        continuationToken, order, orderDirection);
+
+                    QVERIFY2(
+                        errorMessage.isEmpty(),
+                        qPrintable(errorMessage.nonLocalizedString()));
+
+                    QVERIFY2(
+                        static_cast<size_t>(page.size()) <= pageSize,
+                        "The page of notes is larger than requested");
+
+                    pagedNotes << page;
+                    ++numPages;
+                    QVERIFY2(
+                        numPages <= numNotes + 1,
+                        "Listing the pages of notes doesn't terminate");
+                } while (!continuationToken.isEmpty());
+
+                QVERIFY2(
+                    pagedNotes.size() == numNotes,
+                    "Unexpected number of notes listed in pages");
+
+                for (int i = 0; i < numNotes; ++i) {
+                    QVERIFY2(
+                        allNotes.contains(pagedNotes.at(i)),
+                        "Note listed in pages was not listed at once");
+
+                    QVERIFY2(
+                        pagedNotes.indexOf(pagedNotes.at(i)) == i,
+                        "Note was listed in pages more than once");
+
+                    if ((i == 0) ||
+                        (order ==
+                         LocalStorageManager::ListNotesOrder::NoOrder)) {
+                        continue;
+                    }
+
+                    const Note & previousNote = pagedNotes.at(i - 1);
+                    const Note & note = pagedNotes.at(i);
+                    const int previousIndex = allNotes.indexOf(previousNote);
+                    const int index = allNotes.indexOf(note);
+                    if (index > previousIndex) {
+                        continue;
+                    }
+
+                    if (order != LocalStorageManager::ListNotesOrder::ByTitle) {
+                        QFAIL(
+                            "Notes listed in pages are not ordered by "
+                            "creation timestamp");
+                    }
+
+                    QVERIFY2(
+                        (previousNote.hasTitle() == note.hasTitle()) &&
+                            (!note.hasTitle() ||
+                             (previousNote.title() == note.title())),
+                        "Notes listed in pages are not ordered by title");
+                }
+            }
+        }
+    }
+
+    // The continuation token must not be reused with a different ordering
+    QString continuationToken;
+    errorMessage.clear();
+    QList<Tag> page = localStorageManager.listTagsPage(
+        LocalStorageManager::ListObjectsOption::ListAll, errorMessage, 2,
+        continuationToken, LocalStorageManager::ListTagsOrder::ByName);
+
+    QVERIFY2(
+        errorMessage.isEmpty(), qPrintable(errorMessage.nonLocalizedString()));
+
+    QVERIFY2(page.size() == 2, "Unexpected number of tags in the first page");
+    QVERIFY2(
+        !continuationToken.isEmpty(),
+        "No continuation token after the first page of tags");
+
+    page = localStorageManager.listTagsPage(
+        LocalStorageManager::ListObjectsOption::ListAll, errorMessage, 2,
+        continuationToken,
+        LocalStorageManager::ListTagsOrder::ByUpdateSequenceNumber);
+
+    QVERIFY2(
+        page.isEmpty() && !errorMessage.isEmpty(),
+        "Continuation token was accepted for a different ordering");
+}
+
 } // namespace test
 } // namespace quentier
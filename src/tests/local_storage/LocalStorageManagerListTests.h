@@ -40,6 +40,8 @@ void TestListNotebooks();
 
 void TestExpungeNotelessTagsFromLinkedNotebooks();
 
+void TestListObjectsPages();
+
 } // namespace test
 } // namespace quentier
 
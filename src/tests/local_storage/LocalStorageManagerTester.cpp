@@ -203,6 +203,182 @@ void LocalStorageManagerTester::localStorageManagerNoteTagIdsComplementTest()
     CATCH_EXCEPTION();
 }
 
+void LocalStorageManagerTester::localStorageManagerNoteFullTextSearchIndexTest()
+{
+    try {
+        TestNoteFullTextSearchIndexMaintenance();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerNoteThroughputBenchmark()
+{
+    try {
+        TestNoteAdditionAndUpdateThroughput();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerPatch2To3Test()
+{
+    try {
+        TestFullTextSearchIndexRebuildByLocalStoragePatch2To3();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerBatchAdditionTest()
+{
+    try {
+        TestBatchNoteAndTagAdditionInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerReadOnlyConnectionTest()
+{
+    try {
+        TestReadOnlyConnectionToLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerMappedResourceDataTest()
+{
+    try {
+        TestMappedResourceBinaryDataInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerResourceBlobsTest()
+{
+    try {
+        TestResourceBlobDeduplicationInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerResourceDataStreamingTest()
+{
+    try {
+        TestResourceDataStreamingToLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerLazyResourceDataTest()
+{
+    try {
+        TestLazyResourceBinaryDataInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerQueryStatisticsTest()
+{
+    try {
+        TestQueryStatisticsInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerCompiledSearchTest()
+{
+    try {
+        TestCompiledNoteSearchQueriesInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageCacheManagerByteBudgetTest()
+{
+    try {
+        TestLocalStorageCacheByteBudgetExpiry();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerSearchHitsTest()
+{
+    try {
+        TestNoteSearchHitsInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerNoteCountersTest()
+{
+    try {
+        TestNoteCountersInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerIncrementalCompactionTest()
+{
+    try {
+        TestIncrementalCompactionOfLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerAccountHighUsnCacheTest()
+{
+    try {
+        TestAccountHighUsnCacheInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerGuidIndexTest()
+{
+    try {
+        TestGuidLocalUidIndexInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerPartialNoteUpdatesTest()
+{
+    try {
+        TestPartialNoteUpdatesInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerNoteSummariesTest()
+{
+    try {
+        TestNoteSummariesInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerSnapshotTest()
+{
+    try {
+        TestLocalStorageSnapshot();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerPerformanceProfilesTest()
+{
+    try {
+        TestLocalStoragePerformanceProfiles();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerNoteLocationIndexTest()
+{
+    try {
+        TestNoteLocationIndexInLocalStorage();
+    }
+    CATCH_EXCEPTION();
+}
+
 void LocalStorageManagerTester::localStorageManagerListSavedSearchesTest()
 {
     try {
@@ -268,6 +444,14 @@ void LocalStorageManagerTester::localStorageManagerListNotebooksTest()
     CATCH_EXCEPTION();
 }
 
+void LocalStorageManagerTester::localStorageManagerListObjectsPagesTest()
+{
+    try {
+        TestListObjectsPages();
+    }
+    CATCH_EXCEPTION();
+}
+
 void LocalStorageManagerTester::
     localStorageManagerExpungeNotelessTagsFromLinkedNotebooksTest()
 {
@@ -350,5 +534,29 @@ void LocalStorageManagerTester::localStorageCacheManagerTest()
     CATCH_EXCEPTION();
 }
 
+void LocalStorageManagerTester::localStorageManagerAsyncRequestPriorityTest()
+{
+    try {
+        TestRequestPriorityAsync();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerAsyncGroupCommitTest()
+{
+    try {
+        TestGroupCommitAsync();
+    }
+    CATCH_EXCEPTION();
+}
+
+void LocalStorageManagerTester::localStorageManagerAsyncRequestCoalescingTest()
+{
+    try {
+        TestRequestCoalescingAsync();
+    }
+    CATCH_EXCEPTION();
+}
+
 } // namespace test
 } // namespace quentier
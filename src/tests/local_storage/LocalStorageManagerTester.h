@@ -52,6 +52,28 @@ private Q_SLOTS:
     void localStorageManagerAccountHighUsnTest();
     void localStorageManagerAddNoteWithoutLocalUidTest();
     void localStorageManagerNoteTagIdsComplementTest();
+    void localStorageManagerNoteFullTextSearchIndexTest();
+    void localStorageManagerNoteThroughputBenchmark();
+    void localStorageManagerPatch2To3Test();
+    void localStorageManagerBatchAdditionTest();
+    void localStorageManagerReadOnlyConnectionTest();
+    void localStorageManagerMappedResourceDataTest();
+    void localStorageManagerResourceBlobsTest();
+    void localStorageManagerResourceDataStreamingTest();
+    void localStorageManagerLazyResourceDataTest();
+    void localStorageManagerQueryStatisticsTest();
+    void localStorageManagerCompiledSearchTest();
+    void localStorageCacheManagerByteBudgetTest();
+    void localStorageManagerSearchHitsTest();
+    void localStorageManagerNoteCountersTest();
+    void localStorageManagerIncrementalCompactionTest();
+    void localStorageManagerAccountHighUsnCacheTest();
+    void localStorageManagerGuidIndexTest();
+    void localStorageManagerPartialNoteUpdatesTest();
+    void localStorageManagerNoteSummariesTest();
+    void localStorageManagerSnapshotTest();
+    void localStorageManagerPerformanceProfilesTest();
+    void localStorageManagerNoteLocationIndexTest();
 
     void localStorageManagerListSavedSearchesTest();
     void localStorageManagerListLinkedNotebooksTest();
@@ -61,6 +83,7 @@ private Q_SLOTS:
     void localStorageManagerListAllTagsPerNoteTest();
     void localStorageManagerListNotesTest();
     void localStorageManagerListNotebooksTest();
+    void localStorageManagerListObjectsPagesTest();
 
     void localStorageManagerExpungeNotelessTagsFromLinkedNotebooksTest();
 
@@ -74,6 +97,9 @@ private Q_SLOTS:
     void localStorageManagerAsyncNoteNotebookAndTagListTrackingTest();
 
     void localStorageCacheManagerTest();
+    void localStorageManagerAsyncRequestPriorityTest();
+    void localStorageManagerAsyncGroupCommitTest();
+    void localStorageManagerAsyncRequestCoalescingTest();
 };
 
 } // namespace test
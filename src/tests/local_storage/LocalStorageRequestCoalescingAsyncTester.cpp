@@ -0,0 +1,312 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStorageRequestCoalescingAsyncTester.h"
+
+#include <quentier/local_storage/LocalStorageManagerAsync.h>
+#include <quentier/logging/QuentierLogger.h>
+
+namespace quentier {
+namespace test {
+
+LocalStorageRequestCoalescingAsyncTester::
+    LocalStorageRequestCoalescingAsyncTester(QObject * parent) :
+    QObject(parent)
+{}
+
+LocalStorageRequestCoalescingAsyncTester::
+    ~LocalStorageRequestCoalescingAsyncTester()
+{
+    clear();
+}
+
+void LocalStorageRequestCoalescingAsyncTester::onInitTestCase()
+{
+    clear();
+
+    Account account(
+        QStringLiteral("LocalStorageRequestCoalescingAsyncTester"),
+        Account::Type::Local);
+
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    // LocalStorageManagerAsync lives within the same thread as the tester
+    // so that all the requests below are taken off the event queue before
+    // results of reads from the read-only connection come back
+    m_pLocalStorageManagerAsync =
+        new LocalStorageManagerAsync(account, startupOptions);
+
+    m_pLocalStorageManagerAsync->setReadOnlyConnectionPoolSize(1);
+
+    createConnections();
+    m_pLocalStorageManagerAsync->init();
+
+    m_notebook = Notebook();
+    m_notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorDescription;
+    if (!m_pLocalStorageManagerAsync->localStorageManager()->addNotebook(
+            m_notebook, errorDescription))
+    {
+        Q_EMIT failure(errorDescription.nonLocalizedString());
+        return;
+    }
+
+    LocalStorageManager::NoteCountOptions options(
+        LocalStorageManager::NoteCountOption::IncludeNonDeletedNotes);
+
+    // The second request should get the result of the first one
+    m_firstNoteCountRequestId = QUuid::createUuid();
+    Q_EMIT getNoteCountRequest(options, m_firstNoteCountRequestId);
+
+    m_secondNoteCountRequestId = QUuid::createUuid();
+    Q_EMIT getNoteCountRequest(options, m_secondNoteCountRequestId);
+
+    Note note;
+    note.setTitle(QStringLiteral("Fake note title"));
+
+    note.setContent(QStringLiteral(
+        "<en-note><div>The text of fake note</div></en-note>"));
+
+    note.setNotebookLocalUid(m_notebook.localUid());
+    Q_EMIT addNoteRequest(note, QUuid::createUuid());
+
+    // This request comes after the write so it must not be coalesced with
+    // the ones sent before it
+    m_lastNoteCountRequestId = QUuid::createUuid();
+    Q_EMIT getNoteCountRequest(options, m_lastNoteCountRequestId);
+}
+
+void LocalStorageRequestCoalescingAsyncTester::onGetNoteCountCompleted(
+    int noteCount, LocalStorageManager::NoteCountOptions options,
+    QUuid requestId)
+{
+    Q_UNUSED(options)
+
+    m_noteCountsByRequestId[requestId] = noteCount;
+    checkCompletion();
+}
+
+void LocalStorageRequestCoalescingAsyncTester::onGetNoteCountFailed(
+    ErrorString errorDescription,
+    LocalStorageManager::NoteCountOptions options, QUuid requestId)
+{
+    Q_UNUSED(options)
+
+    QNWARNING(
+        "tests:local_storage",
+        errorDescription << ", request id = " << requestId);
+
+    Q_EMIT failure(errorDescription.nonLocalizedString());
+}
+
+void LocalStorageRequestCoalescingAsyncTester::onAddNoteCompleted(
+    Note note, QUuid requestId)
+{
+    Q_UNUSED(note)
+    Q_UNUSED(requestId)
+
+    m_addedNote = true;
+    checkCompletion();
+}
+
+void LocalStorageRequestCoalescingAsyncTester::onAddNoteFailed(
+    Note note, ErrorString errorDescription, QUuid requestId)
+{
+    QNWARNING(
+        "tests:local_storage",
+        errorDescription << ", request id = " << requestId
+                         << ", note: " << note);
+
+    Q_EMIT failure(errorDescription.nonLocalizedString());
+}
+
+void LocalStorageRequestCoalescingAsyncTester::onFindNotebookCompleted(
+    Notebook notebook, QUuid requestId)
+{
+    if ((requestId != m_firstFindNotebookRequestId) &&
+        (requestId != m_secondFindNotebookRequestId))
+    {
+        return;
+    }
+
+    if (notebook.localUid() != m_notebook.localUid()) {
+        Q_EMIT failure(
+            QStringLiteral("Found notebook doesn't match the added one"));
+        return;
+    }
+
+    ++m_foundNotebookCount;
+    if (m_foundNotebookCount != 2) {
+        return;
+    }
+
+    // The second request was deferred after the first one so it must have
+    // joined it within the request scheduler
+    qint64 coalescedReadRequestCount =
+        m_pLocalStorageManagerAsync->coalescedReadRequestCount();
+
+    if (coalescedReadRequestCount != 2) {
+        Q_EMIT failure(
+            QStringLiteral("Unexpected number of coalesced read requests "
+                           "after finding the notebook: ") +
+            QString::number(coalescedReadRequestCount));
+        return;
+    }
+
+    Q_EMIT success();
+}
+
+void LocalStorageRequestCoalescingAsyncTester::onFindNotebookFailed(
+    Notebook notebook, ErrorString errorDescription, QUuid requestId)
+{
+    QNWARNING(
+        "tests:local_storage",
+        errorDescription << ", request id = " << requestId
+                         << ", notebook: " << notebook);
+
+    Q_EMIT failure(errorDescription.nonLocalizedString());
+}
+
+void LocalStorageRequestCoalescingAsyncTester::createConnections()
+{
+    // Request --> slot connections; the connections must be queued even
+    // though LocalStorageManagerAsync lives within the same thread
+    QObject::connect(
+        this, &LocalStorageRequestCoalescingAsyncTester::getNoteCountRequest,
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::onGetNoteCountRequest,
+        Qt::QueuedConnection);
+
+    QObject::connect(
+        this, &LocalStorageRequestCoalescingAsyncTester::addNoteRequest,
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::onAddNoteRequest, Qt::QueuedConnection);
+
+    QObject::connect(
+        this, &LocalStorageRequestCoalescingAsyncTester::findNotebookRequest,
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::onFindNotebookRequest,
+        Qt::QueuedConnection);
+
+    // Slot <-- result connections
+    QObject::connect(
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::getNoteCountComplete, this,
+        &LocalStorageRequestCoalescingAsyncTester::onGetNoteCountCompleted);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::getNoteCountFailed, this,
+        &LocalStorageRequestCoalescingAsyncTester::onGetNoteCountFailed);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync, &LocalStorageManagerAsync::addNoteComplete,
+        this, &LocalStorageRequestCoalescingAsyncTester::onAddNoteCompleted);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync, &LocalStorageManagerAsync::addNoteFailed,
+        this, &LocalStorageRequestCoalescingAsyncTester::onAddNoteFailed);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::findNotebookComplete, this,
+        &LocalStorageRequestCoalescingAsyncTester::onFindNotebookCompleted);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::findNotebookFailed, this,
+        &LocalStorageRequestCoalescingAsyncTester::onFindNotebookFailed);
+}
+
+void LocalStorageRequestCoalescingAsyncTester::clear()
+{
+    if (m_pLocalStorageManagerAsync) {
+        m_pLocalStorageManagerAsync->deleteLater();
+        m_pLocalStorageManagerAsync = nullptr;
+    }
+
+    m_firstNoteCountRequestId = QUuid();
+    m_secondNoteCountRequestId = QUuid();
+    m_lastNoteCountRequestId = QUuid();
+    m_noteCountsByRequestId.clear();
+    m_addedNote = false;
+
+    m_firstFindNotebookRequestId = QUuid();
+    m_secondFindNotebookRequestId = QUuid();
+    m_foundNotebookCount = 0;
+}
+
+void LocalStorageRequestCoalescingAsyncTester::checkCompletion()
+{
+    if (!m_addedNote || (m_noteCountsByRequestId.size() != 3)) {
+        return;
+    }
+
+    // The first read might have been run either before or after the note was
+    // added but both requests joined by it must get the same count
+    if (m_noteCountsByRequestId.value(m_firstNoteCountRequestId) !=
+        m_noteCountsByRequestId.value(m_secondNoteCountRequestId))
+    {
+        Q_EMIT failure(QStringLiteral(
+            "Coalesced note count requests got different results"));
+        return;
+    }
+
+    if (m_noteCountsByRequestId.value(m_lastNoteCountRequestId) != 1) {
+        Q_EMIT failure(QStringLiteral(
+            "Note count request sent after adding the note didn't see it"));
+        return;
+    }
+
+    qint64 coalescedReadRequestCount =
+        m_pLocalStorageManagerAsync->coalescedReadRequestCount();
+
+    if (coalescedReadRequestCount != 1) {
+        Q_EMIT failure(
+            QStringLiteral("Unexpected number of coalesced read requests: ") +
+            QString::number(coalescedReadRequestCount));
+        return;
+    }
+
+    findNotebookWithDeferredRequests();
+}
+
+void LocalStorageRequestCoalescingAsyncTester::
+    findNotebookWithDeferredRequests()
+{
+    // Requests from background senders are deferred by the request scheduler
+    m_pLocalStorageManagerAsync->setRequestSenderPriority(
+        this, LocalStorageManagerAsync::RequestPriority::Background);
+
+    // The cache would serve the requests without reading the local storage
+    m_pLocalStorageManagerAsync->setUseCache(false);
+
+    Notebook notebook;
+    notebook.setLocalUid(m_notebook.localUid());
+
+    m_firstFindNotebookRequestId = QUuid::createUuid();
+    Q_EMIT findNotebookRequest(notebook, m_firstFindNotebookRequestId);
+
+    m_secondFindNotebookRequestId = QUuid::createUuid();
+    Q_EMIT findNotebookRequest(notebook, m_secondFindNotebookRequestId);
+}
+
+} // namespace test
+} // namespace quentier
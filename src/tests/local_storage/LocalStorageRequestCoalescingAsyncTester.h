@@ -0,0 +1,107 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_TESTS_LOCAL_STORAGE_REQUEST_COALESCING_ASYNC_TESTER_H
+#define LIB_QUENTIER_TESTS_LOCAL_STORAGE_REQUEST_COALESCING_ASYNC_TESTER_H
+
+#include <quentier/local_storage/LocalStorageManager.h>
+#include <quentier/types/ErrorString.h>
+#include <quentier/types/Note.h>
+#include <quentier/types/Notebook.h>
+
+#include <QHash>
+#include <QUuid>
+
+namespace quentier {
+
+QT_FORWARD_DECLARE_CLASS(LocalStorageManagerAsync)
+
+namespace test {
+
+class LocalStorageRequestCoalescingAsyncTester final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalStorageRequestCoalescingAsyncTester(
+        QObject * parent = nullptr);
+    ~LocalStorageRequestCoalescingAsyncTester();
+
+public Q_SLOTS:
+    void onInitTestCase();
+
+Q_SIGNALS:
+    void success();
+    void failure(QString errorDescription);
+
+    // private signals:
+    void getNoteCountRequest(
+        LocalStorageManager::NoteCountOptions options, QUuid requestId);
+
+    void addNoteRequest(Note note, QUuid requestId);
+    void findNotebookRequest(Notebook notebook, QUuid requestId);
+
+private Q_SLOTS:
+    void onGetNoteCountCompleted(
+        int noteCount, LocalStorageManager::NoteCountOptions options,
+        QUuid requestId);
+
+    void onGetNoteCountFailed(
+        ErrorString errorDescription,
+        LocalStorageManager::NoteCountOptions options, QUuid requestId);
+
+    void onAddNoteCompleted(Note note, QUuid requestId);
+
+    void onAddNoteFailed(
+        Note note, ErrorString errorDescription, QUuid requestId);
+
+    void onFindNotebookCompleted(Notebook notebook, QUuid requestId);
+
+    void onFindNotebookFailed(
+        Notebook notebook, ErrorString errorDescription, QUuid requestId);
+
+private:
+    void createConnections();
+    void clear();
+    void checkCompletion();
+    void findNotebookWithDeferredRequests();
+
+private:
+    LocalStorageManagerAsync * m_pLocalStorageManagerAsync = nullptr;
+
+    Notebook m_notebook;
+
+    // Ids of note count requests sent before the note is added
+    QUuid m_firstNoteCountRequestId;
+    QUuid m_secondNoteCountRequestId;
+
+    // Id of note count request sent after the note is added
+    QUuid m_lastNoteCountRequestId;
+
+    QHash<QUuid, int> m_noteCountsByRequestId;
+    bool m_addedNote = false;
+
+    // Ids of find notebook requests deferred by the request scheduler
+    QUuid m_firstFindNotebookRequestId;
+    QUuid m_secondFindNotebookRequestId;
+    int m_foundNotebookCount = 0;
+};
+
+} // namespace test
+} // namespace quentier
+
+#endif // LIB_QUENTIER_TESTS_LOCAL_STORAGE_REQUEST_COALESCING_ASYNC_TESTER_H
@@ -0,0 +1,365 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalStorageRequestPriorityAsyncTester.h"
+
+#include <quentier/local_storage/LocalStorageManagerAsync.h>
+#include <quentier/logging/QuentierLogger.h>
+
+// The number of bulk requests sent ahead of the interactive one
+#define BULK_NOTE_COUNT (50)
+
+namespace quentier {
+namespace test {
+
+LocalStorageRequestPriorityAsyncTester::LocalStorageRequestPriorityAsyncTester(
+    QObject * parent) :
+    QObject(parent)
+{}
+
+LocalStorageRequestPriorityAsyncTester::
+    ~LocalStorageRequestPriorityAsyncTester()
+{
+    clear();
+}
+
+void LocalStorageRequestPriorityAsyncTester::onInitTestCase()
+{
+    clear();
+
+    Account account(
+        QStringLiteral("LocalStorageRequestPriorityAsyncTester"),
+        Account::Type::Local);
+
+    LocalStorageManager::StartupOptions startupOptions(
+        LocalStorageManager::StartupOption::ClearDatabase);
+
+    // LocalStorageManagerAsync lives within the same thread as the tester
+    // so that all the requests below get into the event queue before any
+    // of them is taken off it
+    m_pLocalStorageManagerAsync =
+        new LocalStorageManagerAsync(account, startupOptions);
+
+    createConnections();
+    m_pLocalStorageManagerAsync->init();
+
+    m_notebook = Notebook();
+    m_notebook.setName(QStringLiteral("Fake notebook name"));
+
+    ErrorString errorDescription;
+    if (!m_pLocalStorageManagerAsync->localStorageManager()->addNotebook(
+            m_notebook, errorDescription))
+    {
+        Q_EMIT failure(errorDescription.nonLocalizedString());
+        return;
+    }
+
+    m_otherNotebook = Notebook();
+    m_otherNotebook.setName(QStringLiteral("Other fake notebook name"));
+
+    if (!m_pLocalStorageManagerAsync->localStorageManager()->addNotebook(
+            m_otherNotebook, errorDescription))
+    {
+        Q_EMIT failure(errorDescription.nonLocalizedString());
+        return;
+    }
+
+    m_pLocalStorageManagerAsync->setRequestSenderPriority(
+        this, LocalStorageManagerAsync::RequestPriority::Bulk);
+
+    for (int i = 0; i < BULK_NOTE_COUNT; ++i) {
+        Note note;
+        note.setTitle(QStringLiteral("Fake note title #") + QString::number(i));
+
+        note.setContent(
+            QStringLiteral("<en-note><div>The text of fake note #") +
+            QString::number(i) + QStringLiteral("</div></en-note>"));
+
+        note.setCreationTimestamp(1000 + i);
+        note.setModificationTimestamp(2000 + i);
+        note.setNotebookLocalUid(m_notebook.localUid());
+
+        Q_EMIT addNoteRequest(note, QUuid::createUuid());
+    }
+
+    // Requests made not via signals have interactive priority
+    m_findNotebookRequestId = QUuid::createUuid();
+
+    bool res = QMetaObject::invokeMethod(
+        m_pLocalStorageManagerAsync, "onFindNotebookRequest",
+        Qt::QueuedConnection, Q_ARG(Notebook, m_notebook),
+        Q_ARG(QUuid, m_findNotebookRequestId));
+
+    if (!res) {
+        Q_EMIT failure(
+            QStringLiteral("Failed to invoke onFindNotebookRequest slot"));
+        return;
+    }
+
+    // The interactive write of the notebook not touched by the bulk writes
+    // must not wait for them
+    Notebook otherNotebook = m_otherNotebook;
+    otherNotebook.setName(QStringLiteral("Updated other fake notebook name"));
+    m_updateOtherNotebookRequestId = QUuid::createUuid();
+
+    res = QMetaObject::invokeMethod(
+        m_pLocalStorageManagerAsync, "onUpdateNotebookRequest",
+        Qt::QueuedConnection, Q_ARG(Notebook, otherNotebook),
+        Q_ARG(QUuid, m_updateOtherNotebookRequestId));
+
+    if (!res) {
+        Q_EMIT failure(
+            QStringLiteral("Failed to invoke onUpdateNotebookRequest slot"));
+        return;
+    }
+
+    // Unlike the interactive read and the unrelated interactive write,
+    // the interactive write of the notebook the bulk writes add notes to must
+    // not overtake the bulk writes sent before it
+    Notebook notebook = m_notebook;
+    notebook.setName(QStringLiteral("Updated fake notebook name"));
+    m_updateNotebookRequestId = QUuid::createUuid();
+
+    res = QMetaObject::invokeMethod(
+        m_pLocalStorageManagerAsync, "onUpdateNotebookRequest",
+        Qt::QueuedConnection, Q_ARG(Notebook, notebook),
+        Q_ARG(QUuid, m_updateNotebookRequestId));
+
+    if (!res) {
+        Q_EMIT failure(
+            QStringLiteral("Failed to invoke onUpdateNotebookRequest slot"));
+    }
+}
+
+void LocalStorageRequestPriorityAsyncTester::onAddNoteCompleted(
+    Note note, QUuid requestId)
+{
+    Q_UNUSED(note)
+    Q_UNUSED(requestId)
+
+    if (!m_foundNotebook) {
+        Q_EMIT failure(QStringLiteral(
+            "Bulk request was served before the interactive one"));
+        return;
+    }
+
+    if (!m_updatedOtherNotebook) {
+        Q_EMIT failure(QStringLiteral(
+            "Interactive write request was served after unrelated bulk "
+            "writes"));
+        return;
+    }
+
+    if (m_updatedNotebook) {
+        Q_EMIT failure(QStringLiteral(
+            "Bulk write request was served after the interactive write "
+            "sent after it"));
+        return;
+    }
+
+    ++m_addedNoteCount;
+}
+
+void LocalStorageRequestPriorityAsyncTester::onAddNoteFailed(
+    Note note, ErrorString errorDescription, QUuid requestId)
+{
+    QNWARNING(
+        "tests:local_storage",
+        errorDescription << ", request id = " << requestId
+                         << ", note: " << note);
+
+    Q_EMIT failure(errorDescription.nonLocalizedString());
+}
+
+void LocalStorageRequestPriorityAsyncTester::onFindNotebookCompleted(
+    Notebook notebook, QUuid requestId)
+{
+    Q_UNUSED(notebook)
+
+    if (requestId != m_findNotebookRequestId) {
+        return;
+    }
+
+    if (m_addedNoteCount != 0) {
+        Q_EMIT failure(QStringLiteral(
+            "Interactive request was served after some bulk ones"));
+        return;
+    }
+
+    m_foundNotebook = true;
+}
+
+void LocalStorageRequestPriorityAsyncTester::onFindNotebookFailed(
+    Notebook notebook, ErrorString errorDescription, QUuid requestId)
+{
+    if (requestId != m_findNotebookRequestId) {
+        return;
+    }
+
+    QNWARNING(
+        "tests:local_storage",
+        errorDescription << ", request id = " << requestId
+                         << ", notebook: " << notebook);
+
+    Q_EMIT failure(errorDescription.nonLocalizedString());
+}
+
+void LocalStorageRequestPriorityAsyncTester::onUpdateNotebookCompleted(
+    Notebook notebook, QUuid requestId)
+{
+    Q_UNUSED(notebook)
+
+    if (requestId == m_updateOtherNotebookRequestId) {
+        if (m_addedNoteCount != 0) {
+            Q_EMIT failure(QStringLiteral(
+                "Interactive write request was blocked behind unrelated bulk "
+                "writes"));
+            return;
+        }
+
+        m_updatedOtherNotebook = true;
+        return;
+    }
+
+    if (requestId != m_updateNotebookRequestId) {
+        return;
+    }
+
+    if (m_addedNoteCount != BULK_NOTE_COUNT) {
+        Q_EMIT failure(QStringLiteral(
+            "Interactive write request was served before the bulk writes "
+            "sent before it"));
+        return;
+    }
+
+    m_updatedNotebook = true;
+    checkStatistics();
+}
+
+void LocalStorageRequestPriorityAsyncTester::onUpdateNotebookFailed(
+    Notebook notebook, ErrorString errorDescription, QUuid requestId)
+{
+    if ((requestId != m_updateNotebookRequestId) &&
+        (requestId != m_updateOtherNotebookRequestId))
+    {
+        return;
+    }
+
+    QNWARNING(
+        "tests:local_storage",
+        errorDescription << ", request id = " << requestId
+                         << ", notebook: " << notebook);
+
+    Q_EMIT failure(errorDescription.nonLocalizedString());
+}
+
+void LocalStorageRequestPriorityAsyncTester::createConnections()
+{
+    // Request --> slot connections; the connection must be queued even though
+    // LocalStorageManagerAsync lives within the same thread
+    QObject::connect(
+        this, &LocalStorageRequestPriorityAsyncTester::addNoteRequest,
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::onAddNoteRequest, Qt::QueuedConnection);
+
+    // Slot <-- result connections
+    QObject::connect(
+        m_pLocalStorageManagerAsync, &LocalStorageManagerAsync::addNoteComplete,
+        this, &LocalStorageRequestPriorityAsyncTester::onAddNoteCompleted);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync, &LocalStorageManagerAsync::addNoteFailed,
+        this, &LocalStorageRequestPriorityAsyncTester::onAddNoteFailed);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::findNotebookComplete, this,
+        &LocalStorageRequestPriorityAsyncTester::onFindNotebookCompleted);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::findNotebookFailed, this,
+        &LocalStorageRequestPriorityAsyncTester::onFindNotebookFailed);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::updateNotebookComplete, this,
+        &LocalStorageRequestPriorityAsyncTester::onUpdateNotebookCompleted);
+
+    QObject::connect(
+        m_pLocalStorageManagerAsync,
+        &LocalStorageManagerAsync::updateNotebookFailed, this,
+        &LocalStorageRequestPriorityAsyncTester::onUpdateNotebookFailed);
+}
+
+void LocalStorageRequestPriorityAsyncTester::clear()
+{
+    if (m_pLocalStorageManagerAsync) {
+        m_pLocalStorageManagerAsync->deleteLater();
+        m_pLocalStorageManagerAsync = nullptr;
+    }
+
+    m_findNotebookRequestId = QUuid();
+    m_foundNotebook = false;
+    m_addedNoteCount = 0;
+    m_updateNotebookRequestId = QUuid();
+    m_updatedNotebook = false;
+    m_updateOtherNotebookRequestId = QUuid();
+    m_updatedOtherNotebook = false;
+}
+
+void LocalStorageRequestPriorityAsyncTester::checkStatistics()
+{
+    using RequestPriority = LocalStorageManagerAsync::RequestPriority;
+
+    const auto statistics =
+        m_pLocalStorageManagerAsync->requestQueueStatistics();
+
+    for (const auto & queueStatistics: qAsConst(statistics)) {
+        qint64 expectedProcessedRequestCount = 0;
+        qint64 expectedMaxQueueDepth = 0;
+
+        switch (queueStatistics.m_priority) {
+        case RequestPriority::Interactive:
+            expectedProcessedRequestCount = 3;
+            break;
+        case RequestPriority::Bulk:
+            expectedProcessedRequestCount = BULK_NOTE_COUNT;
+            expectedMaxQueueDepth = BULK_NOTE_COUNT;
+            break;
+        default:
+            break;
+        }
+
+        if ((queueStatistics.m_processedRequestCount !=
+             expectedProcessedRequestCount) ||
+            (queueStatistics.m_maxQueueDepth != expectedMaxQueueDepth) ||
+            (queueStatistics.m_queueDepth != 0))
+        {
+            QNWARNING("tests:local_storage", queueStatistics);
+            Q_EMIT failure(QStringLiteral(
+                "Unexpected request queue statistics"));
+            return;
+        }
+    }
+
+    Q_EMIT success();
+}
+
+} // namespace test
+} // namespace quentier
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2020 Dmitry Ivanov
+ *
+ * This file is part of libquentier
+ *
+ * libquentier is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * libquentier is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libquentier. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIB_QUENTIER_TESTS_LOCAL_STORAGE_REQUEST_PRIORITY_ASYNC_TESTER_H
+#define LIB_QUENTIER_TESTS_LOCAL_STORAGE_REQUEST_PRIORITY_ASYNC_TESTER_H
+
+#include <quentier/types/ErrorString.h>
+#include <quentier/types/Note.h>
+#include <quentier/types/Notebook.h>
+
+#include <QUuid>
+
+namespace quentier {
+
+QT_FORWARD_DECLARE_CLASS(LocalStorageManagerAsync)
+
+namespace test {
+
+class LocalStorageRequestPriorityAsyncTester final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalStorageRequestPriorityAsyncTester(QObject * parent = nullptr);
+    ~LocalStorageRequestPriorityAsyncTester();
+
+public Q_SLOTS:
+    void onInitTestCase();
+
+Q_SIGNALS:
+    void success();
+    void failure(QString errorDescription);
+
+    // private signals:
+    void addNoteRequest(Note note, QUuid requestId);
+
+private Q_SLOTS:
+    void onAddNoteCompleted(Note note, QUuid requestId);
+
+    void onAddNoteFailed(
+        Note note, ErrorString errorDescription, QUuid requestId);
+
+    void onFindNotebookCompleted(Notebook notebook, QUuid requestId);
+
+    void onFindNotebookFailed(
+        Notebook notebook, ErrorString errorDescription, QUuid requestId);
+
+    void onUpdateNotebookCompleted(Notebook notebook, QUuid requestId);
+
+    void onUpdateNotebookFailed(
+        Notebook notebook, ErrorString errorDescription, QUuid requestId);
+
+private:
+    void createConnections();
+    void clear();
+    void checkStatistics();
+
+private:
+    LocalStorageManagerAsync * m_pLocalStorageManagerAsync = nullptr;
+
+    Notebook m_notebook;
+    Notebook m_otherNotebook;
+    QUuid m_findNotebookRequestId;
+    bool m_foundNotebook = false;
+    int m_addedNoteCount = 0;
+
+    QUuid m_updateNotebookRequestId;
+    bool m_updatedNotebook = false;
+
+    QUuid m_updateOtherNotebookRequestId;
+    bool m_updatedOtherNotebook = false;
+};
+
+} // namespace test
+} // namespace quentier
+
+#endif // LIB_QUENTIER_TESTS_LOCAL_STORAGE_REQUEST_PRIORITY_ASYNC_TESTER_H
@@ -569,6 +569,7 @@ QList<Resource> Note::resources() const
             resource.setLocalUid(info.localUid);
             resource.setNoteLocalUid(noteLocalUid);
             resource.setDirty(info.isDirty);
+            info.applyBodiesTo(*resource.d);
         }
 
         resource.setIndexInNote(i);
@@ -594,6 +595,7 @@ void Note::setResources(const QList<Resource> & resources)
         d->m_qecNote.resources.ref() << resource.qevercloudResource();
         info.localUid = resource.localUid();
         info.isDirty = resource.isDirty();
+        info.setBodiesFrom(*resource.d);
         d->m_resourcesAdditionalInfo.push_back(info);
     }
 }
@@ -617,6 +619,7 @@ void Note::addResource(const Resource & resource)
     NoteData::ResourceAdditionalInfo info;
     info.localUid = resource.localUid();
     info.isDirty = resource.isDirty();
+    info.setBodiesFrom(*resource.d);
     d->m_resourcesAdditionalInfo.push_back(info);
 
     QNDEBUG(
@@ -657,8 +660,9 @@ bool Note::updateResource(const Resource & resource)
     d->m_qecNote.resources.ref()[targetResourceIndex] =
         resource.qevercloudResource();
 
-    d->m_resourcesAdditionalInfo[targetResourceIndex].isDirty =
-        resource.isDirty();
+    auto & info = d->m_resourcesAdditionalInfo[targetResourceIndex];
+    info.isDirty = resource.isDirty();
+    info.setBodiesFrom(*resource.d);
 
     return true;
 }
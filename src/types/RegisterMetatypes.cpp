@@ -110,6 +110,21 @@ void registerMetatypes()
     qRegisterMetaType<LocalStorageManager::NoteCountOptions>(
         "LocalStorageManager::NoteCountOptions");
 
+    qRegisterMetaType<QList<LocalStorageManager::NoteSearchHit>>(
+        "QList<LocalStorageManager::NoteSearchHit>");
+
+    qRegisterMetaType<LocalStorageManager::NoteSummaryFields>(
+        "LocalStorageManager::NoteSummaryFields");
+
+    qRegisterMetaType<QList<LocalStorageManager::NoteSummary>>(
+        "QList<LocalStorageManager::NoteSummary>");
+
+    qRegisterMetaType<LocalStorageManager::FreePageStatistics>(
+        "LocalStorageManager::FreePageStatistics");
+
+    qRegisterMetaType<LocalStorageManager::PerformanceProfile>(
+        "LocalStorageManager::PerformanceProfile");
+
     qRegisterMetaType<size_t>("size_t");
     qRegisterMetaType<QUuid>("QUuid");
 
@@ -130,6 +145,7 @@ void registerMetatypes()
     qRegisterMetaType<NoteSearchQuery>("NoteSearchQuery");
 
     qRegisterMetaType<ErrorString>("ErrorString");
+    qRegisterMetaType<QList<ErrorString>>("QList<ErrorString>");
     qRegisterMetaType<QSqlError>("QSqlError");
 
     qRegisterMetaType<QList<std::pair<Tag, QStringList>>>(
@@ -99,6 +99,10 @@ void Resource::clear()
     d->m_qecResource = qevercloud::Resource();
     d->m_indexInNote = -1;
     d->m_noteLocalUid.clear();
+    d->m_dataBodyOwner.reset();
+    d->m_alternateDataBodyOwner.reset();
+    d->m_lazyDataBody.reset();
+    d->m_lazyAlternateDataBody.reset();
 }
 
 bool Resource::hasGuid() const
@@ -489,11 +493,19 @@ bool Resource::hasDataBody() const
         return false;
     }
 
-    return d->m_qecResource.data->body.isSet();
+    if (d->m_qecResource.data->body.isSet()) {
+        return true;
+    }
+
+    return d->m_lazyDataBody && d->m_lazyDataBody->isAvailable();
 }
 
 const QByteArray & Resource::dataBody() const
 {
+    if (d->m_lazyDataBody && !d->m_qecResource.data->body.isSet()) {
+        return d->m_lazyDataBody->body();
+    }
+
     return d->m_qecResource.data->body;
 }
 
@@ -504,6 +516,9 @@ void Resource::setDataBody(const QByteArray & body)
         "Resource::setDataBody: body to set is "
             << (body.isEmpty() ? "empty" : "not empty"));
 
+    d->m_dataBodyOwner.reset();
+    d->m_lazyDataBody.reset();
+
     auto & enResource = d->m_qecResource;
 
     if (!enResource.data.isSet()) {
@@ -528,6 +543,39 @@ void Resource::setDataBody(const QByteArray & body)
     enResource.data->body = body;
 }
 
+void Resource::setDataBody(
+    const QByteArray & body, std::shared_ptr<const void> bodyOwner)
+{
+    setDataBody(body);
+    d->m_dataBodyOwner = std::move(bodyOwner);
+}
+
+bool Resource::hasDataBodyOwner() const
+{
+    return hasData() && d->m_dataBodyOwner;
+}
+
+bool Resource::hasLazyDataBody() const
+{
+    return hasData() && d->m_lazyDataBody;
+}
+
+void Resource::setLazyDataBody(const QString & filePath)
+{
+    QNTRACE(
+        "types:resource",
+        "Resource::setLazyDataBody: file path = " << filePath);
+
+    auto & enResource = d->m_qecResource;
+    if (!enResource.data.isSet()) {
+        enResource.data = qevercloud::Data();
+    }
+
+    enResource.data->body.clear();
+    d->m_dataBodyOwner.reset();
+    d->m_lazyDataBody = std::make_shared<ResourceLazyBody>(filePath);
+}
+
 bool Resource::hasMime() const
 {
     return d->m_qecResource.mime.isSet();
@@ -804,16 +852,30 @@ bool Resource::hasAlternateDataBody() const
         return false;
     }
 
-    return d->m_qecResource.alternateData->body.isSet();
+    if (d->m_qecResource.alternateData->body.isSet()) {
+        return true;
+    }
+
+    return d->m_lazyAlternateDataBody &&
+        d->m_lazyAlternateDataBody->isAvailable();
 }
 
 const QByteArray & Resource::alternateDataBody() const
 {
+    if (d->m_lazyAlternateDataBody &&
+        !d->m_qecResource.alternateData->body.isSet())
+    {
+        return d->m_lazyAlternateDataBody->body();
+    }
+
     return d->m_qecResource.alternateData->body;
 }
 
 void Resource::setAlternateDataBody(const QByteArray & body)
 {
+    d->m_alternateDataBodyOwner.reset();
+    d->m_lazyAlternateDataBody.reset();
+
     auto & enResource = d->m_qecResource;
 
     if (!enResource.alternateData.isSet()) {
@@ -839,6 +901,95 @@ void Resource::setAlternateDataBody(const QByteArray & body)
     enResource.alternateData->body = body;
 }
 
+void Resource::setAlternateDataBody(
+    const QByteArray & body, std::shared_ptr<const void> bodyOwner)
+{
+    setAlternateDataBody(body);
+    d->m_alternateDataBodyOwner = std::move(bodyOwner);
+}
+
+bool Resource::hasAlternateDataBodyOwner() const
+{
+    return hasAlternateData() && d->m_alternateDataBodyOwner;
+}
+
+bool Resource::hasLazyAlternateDataBody() const
+{
+    return hasAlternateData() && d->m_lazyAlternateDataBody;
+}
+
+void Resource::setLazyAlternateDataBody(const QString & filePath)
+{
+    QNTRACE(
+        "types:resource",
+        "Resource::setLazyAlternateDataBody: file path = " << filePath);
+
+    auto & enResource = d->m_qecResource;
+    if (!enResource.alternateData.isSet()) {
+        enResource.alternateData = qevercloud::Data();
+    }
+
+    enResource.alternateData->body.clear();
+    d->m_alternateDataBodyOwner.reset();
+    d->m_lazyAlternateDataBody = std::make_shared<ResourceLazyBody>(filePath);
+}
+
+bool Resource::prefetchDataBodies()
+{
+    QNTRACE("types:resource", "Resource::prefetchDataBodies");
+
+    auto & enResource = d->m_qecResource;
+    bool res = true;
+
+    if (d->m_lazyDataBody && enResource.data.isSet()) {
+        if (d->m_lazyDataBody->load()) {
+            enResource.data->body = d->m_lazyDataBody->body();
+        }
+        else {
+            res = false;
+        }
+    }
+
+    if (d->m_lazyAlternateDataBody && enResource.alternateData.isSet()) {
+        if (d->m_lazyAlternateDataBody->load()) {
+            enResource.alternateData->body =
+                d->m_lazyAlternateDataBody->body();
+        }
+        else {
+            res = false;
+        }
+    }
+
+    return res;
+}
+
+void Resource::releaseDataBodies()
+{
+    QNTRACE("types:resource", "Resource::releaseDataBodies");
+
+    auto & enResource = d->m_qecResource;
+
+    // Other copies of the resource might still be using the read bodies so
+    // this copy switches to its own lazy bodies referring to the same files
+    if (d->m_lazyDataBody) {
+        if (enResource.data.isSet()) {
+            enResource.data->body.clear();
+        }
+
+        d->m_lazyDataBody = std::make_shared<ResourceLazyBody>(
+            d->m_lazyDataBody->filePath());
+    }
+
+    if (d->m_lazyAlternateDataBody) {
+        if (enResource.alternateData.isSet()) {
+            enResource.alternateData->body.clear();
+        }
+
+        d->m_lazyAlternateDataBody = std::make_shared<ResourceLazyBody>(
+            d->m_lazyAlternateDataBody->filePath());
+    }
+}
+
 bool Resource::hasResourceAttributes() const
 {
     return d->m_qecResource.attributes.isSet();
@@ -76,6 +76,24 @@ NoteData::NoteData(const qevercloud::Note & other) :
     }
 }
 
+void NoteData::ResourceAdditionalInfo::setBodiesFrom(
+    const ResourceData & resourceData)
+{
+    dataBodyOwner = resourceData.m_dataBodyOwner;
+    alternateDataBodyOwner = resourceData.m_alternateDataBodyOwner;
+    lazyDataBody = resourceData.m_lazyDataBody;
+    lazyAlternateDataBody = resourceData.m_lazyAlternateDataBody;
+}
+
+void NoteData::ResourceAdditionalInfo::applyBodiesTo(
+    ResourceData & resourceData) const
+{
+    resourceData.m_dataBodyOwner = dataBodyOwner;
+    resourceData.m_alternateDataBodyOwner = alternateDataBodyOwner;
+    resourceData.m_lazyDataBody = lazyDataBody;
+    resourceData.m_lazyAlternateDataBody = lazyAlternateDataBody;
+}
+
 bool NoteData::ResourceAdditionalInfo::operator==(
     const NoteData::ResourceAdditionalInfo & other) const
 {
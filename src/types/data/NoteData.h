@@ -20,6 +20,7 @@
 #define LIB_QUENTIER_TYPES_DATA_NOTE_DATA_H
 
 #include "FavoritableDataElementData.h"
+#include "ResourceData.h"
 
 #include <quentier/types/ErrorString.h>
 
@@ -64,6 +65,17 @@ public:
         QString localUid;
         bool isDirty = false;
 
+        // Bits of resource data which don't fit into qevercloud::Resource:
+        // owners of mapped bodies and lazily loaded bodies; these don't take
+        // part in comparison
+        std::shared_ptr<const void> dataBodyOwner;
+        std::shared_ptr<const void> alternateDataBodyOwner;
+        std::shared_ptr<ResourceLazyBody> lazyDataBody;
+        std::shared_ptr<ResourceLazyBody> lazyAlternateDataBody;
+
+        void setBodiesFrom(const ResourceData & resourceData);
+        void applyBodiesTo(ResourceData & resourceData) const;
+
         bool operator==(const ResourceAdditionalInfo & other) const;
     };
 
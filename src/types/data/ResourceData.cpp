@@ -18,8 +18,84 @@
 
 #include "ResourceData.h"
 
+#include <quentier/logging/QuentierLogger.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
 namespace quentier {
 
+ResourceLazyBody::ResourceLazyBody(const QString & filePath) :
+    m_filePath(filePath)
+{}
+
+const QString & ResourceLazyBody::filePath() const
+{
+    return m_filePath;
+}
+
+bool ResourceLazyBody::isLoaded() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_loaded;
+}
+
+bool ResourceLazyBody::isAvailable() const
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_loaded) {
+        return true;
+    }
+
+    if (m_loadFailed) {
+        return false;
+    }
+
+    return QFileInfo::exists(m_filePath);
+}
+
+const QByteArray & ResourceLazyBody::body()
+{
+    QMutexLocker lock(&m_mutex);
+    if (loadImpl()) {
+        return m_body;
+    }
+
+    // m_body might still be assigned by a later successful attempt to read
+    // the file so it must not be referred to until then
+    static const QByteArray emptyBody;
+    return emptyBody;
+}
+
+bool ResourceLazyBody::load()
+{
+    QMutexLocker lock(&m_mutex);
+    return loadImpl();
+}
+
+bool ResourceLazyBody::loadImpl()
+{
+    if (m_loaded) {
+        return true;
+    }
+
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        QNWARNING(
+            "types:resource",
+            "Failed to open the file with resource body for reading: "
+                << m_filePath << ": " << file.errorString());
+        m_loadFailed = true;
+        return false;
+    }
+
+    m_body = file.readAll();
+    m_loaded = true;
+    m_loadFailed = false;
+    return true;
+}
+
 ResourceData::ResourceData(const qevercloud::Resource & other) :
     NoteStoreDataElementData(), m_qecResource(other)
 {}
@@ -23,8 +23,66 @@
 
 #include <qt5qevercloud/QEverCloud.h>
 
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+
+#include <memory>
+
 namespace quentier {
 
+/**
+ * @brief The ResourceLazyBody class refers to the file containing data body
+ * or alternate data body of a resource and reads the body from this file on
+ * the first access. Copies of the resource share the same lazy body so it is
+ * read at most once for all of them. Once read, the body is never modified
+ * so copies living in different threads can safely access it.
+ */
+class Q_DECL_HIDDEN ResourceLazyBody
+{
+public:
+    explicit ResourceLazyBody(const QString & filePath);
+
+    const QString & filePath() const;
+
+    bool isLoaded() const;
+
+    /**
+     * @return      False if the last attempt to read the body failed or if
+     *              the body was not read yet and the file doesn't exist,
+     *              true otherwise
+     */
+    bool isAvailable() const;
+
+    /**
+     * @return      The body read from the file; it is read on the first call;
+     *              empty byte array if the file could not be read. The read
+     *              body is kept until the lazy body is destroyed so
+     *              the reference stays valid as long as the lazy body exists
+     */
+    const QByteArray & body();
+
+    /**
+     * Reads the body from the file if it was not read yet
+     *
+     * @return      True if the body is loaded, false if the file could not
+     *              be read
+     */
+    bool load();
+
+private:
+    Q_DISABLE_COPY(ResourceLazyBody)
+
+    bool loadImpl();
+
+private:
+    const QString m_filePath;
+    mutable QMutex m_mutex;
+    QByteArray m_body;
+    bool m_loaded = false;
+    bool m_loadFailed = false;
+};
+
 class Q_DECL_HIDDEN ResourceData final : public NoteStoreDataElementData
 {
 public:
@@ -44,6 +102,16 @@ public:
     qevercloud::Resource m_qecResource;
     int m_indexInNote = -1;
     qevercloud::Optional<QString> m_noteLocalUid;
+
+    // Owners of the memory data body and alternate data body refer to when
+    // these were set without copying the bytes
+    std::shared_ptr<const void> m_dataBodyOwner;
+    std::shared_ptr<const void> m_alternateDataBodyOwner;
+
+    // Lazily loaded data body and alternate data body; if set, the body
+    // within m_qecResource is only set after these are prefetched
+    std::shared_ptr<ResourceLazyBody> m_lazyDataBody;
+    std::shared_ptr<ResourceLazyBody> m_lazyAlternateDataBody;
 };
 
 } // namespace quentier
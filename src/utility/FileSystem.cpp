@@ -38,6 +38,8 @@
 #endif
 
 #include <windows.h>
+#else
+#include <unistd.h>
 #endif // defined Q_OS_WIN
 
 namespace quentier {
@@ -251,4 +253,43 @@ bool renameFile(
 #endif // Q_OS_WIN
 }
 
+bool linkOrCopyFile(
+    const QString & from, const QString & to, ErrorString & errorDescription)
+{
+    QNDEBUG(
+        "utility:filesystem",
+        "linkOrCopyFile: from = " << from << ", to = " << to);
+
+#ifdef Q_OS_WIN
+    std::wstring fromW = QDir::toNativeSeparators(from).toStdWString();
+    std::wstring toW = QDir::toNativeSeparators(to).toStdWString();
+    bool linked = (CreateHardLinkW(toW.c_str(), fromW.c_str(), NULL) != 0);
+#else  // Q_OS_WIN
+    bool linked =
+        (link(from.toUtf8().constData(), to.toUtf8().constData()) == 0);
+#endif // Q_OS_WIN
+
+    if (linked) {
+        return true;
+    }
+
+    QNDEBUG(
+        "utility:filesystem", "Failed to create hard link, copying the file");
+
+    QFile file(from);
+    if (!file.copy(to)) {
+        errorDescription.setBase(
+            QT_TRANSLATE_NOOP("linkOrCopyFile", "failed to copy file"));
+
+        errorDescription.details() += file.errorString();
+        errorDescription.details() += QStringLiteral("; from = ");
+        errorDescription.details() += from;
+        errorDescription.details() += QStringLiteral(", to = ");
+        errorDescription.details() += to;
+        return false;
+    }
+
+    return true;
+}
+
 } // namespace quentier